@@ -38,6 +38,7 @@
 #include <Urho3D/IO/File.h>
 #include <Urho3D/IO/FileSystem.h>
 #ifdef URHO3D_PHYSICS
+#include <Urho3D/Physics/CollisionShape.h>
 #include <Urho3D/Physics/PhysicsWorld.h>
 #endif
 #include <Urho3D/Resource/ResourceCache.h>
@@ -171,10 +172,14 @@ HashSet<aiAnimation*> allAnimations_;
 PODVector<aiAnimation*> sceneAnimations_;
 
 float defaultTicksPerSecond_ = 4800.0f;
+// Sample rate of compressed animations, or zero to not compress
+float animationSampleRate_ = 0.0f;
 // For subset animation import usage
 float importStartTime_ = 0.0f;
 float importEndTime_ = 0.0f;
 bool suppressFbxPivotNodes_ = true;
+bool cookTriangleMesh_ = false;
+bool cookConvexHull_ = false;
 
 int main(int argc, char** argv);
 void Run(const Vector<String>& arguments);
@@ -202,6 +207,7 @@ void BuildAndSaveMaterial(aiMaterial* material, HashSet<String>& usedTextures);
 void CopyTextures(const HashSet<String>& usedTextures, const String& sourcePath);
 
 void CombineLods(const PODVector<float>& lodDistances, const Vector<String>& modelNames, const String& outName);
+void SaveCookedCollisionGeometry(const String& modelName);
 
 void GetMeshesUnderNode(Vector<Pair<aiNode*, aiMesh*> >& dest, aiNode* node);
 unsigned GetMeshIndex(aiMesh* mesh);
@@ -306,6 +312,10 @@ void Run(const Vector<String>& arguments)
             "-split <start> <end> (animation model only)\n"
             "            Split animation, will only import from start frame to end frame\n"
             "-np         Do not suppress $fbx pivot nodes (FBX files only)\n"
+            "-ac <rate>  Compress animations: resample at the given rate in samples per\n"
+            "            second and quantize. Prints the largest errors introduced\n"
+            "-ctm        Cook triangle mesh collision geometry for each output model\n"
+            "-cch        Cook convex hull collision geometry for each output model\n"
         );
     }
 
@@ -456,6 +466,17 @@ void Run(const Vector<String>& arguments)
                 checkUniqueModel_ = false;
             else if (argument == "bp")
                 moveToBindPose_ = true;
+            else if (argument == "ctm")
+                cookTriangleMesh_ = true;
+            else if (argument == "cch")
+                cookConvexHull_ = true;
+            else if (argument == "ac" && !value.Empty())
+            {
+                animationSampleRate_ = ToFloat(value);
+                if (animationSampleRate_ <= 0.0f)
+                    animationSampleRate_ = DEFAULT_ANIMATION_SAMPLE_RATE;
+                ++i;
+            }
             else if (argument == "split")
             {
                 String value2 = i + 2 < arguments.Size() ? arguments[i + 2] : String::EMPTY;
@@ -1222,6 +1243,8 @@ void BuildAndSaveModel(OutModel& model)
     if (!outFile.Open(model.outName_, FILE_WRITE))
         ErrorExit("Could not open output file " + model.outName_);
     outModel->Save(outFile);
+    outFile.Close();
+    SaveCookedCollisionGeometry(model.outName_);
 
     // If exporting materials, also save material list for use by the editor
     if (!noMaterials_ && saveMaterialList_)
@@ -1479,6 +1502,15 @@ void BuildAndSaveAnimations(OutModel* model)
             }
         }
 
+        if (animationSampleRate_ > 0.0f)
+        {
+            AnimationCompressionReport report = outAnim->Compress(animationSampleRate_);
+            PrintLine("Compressed animation " + animName + " from " + String(report.originalSize_) + " to " +
+                String(report.compressedSize_) + " bytes, max error position " + String(report.maxPositionError_) +
+                " rotation " + String(report.maxRotationError_) + " degrees (track " + report.maxRotationErrorTrack_ +
+                ") scale " + String(report.maxScaleError_));
+        }
+
         File outFile(context_);
         if (!outFile.Open(animOutName, FILE_WRITE))
             ErrorExit("Could not open output file " + animOutName);
@@ -2136,6 +2168,47 @@ void CombineLods(const PODVector<float>& lodDistances, const Vector<String>& mod
     if (!outFile.Open(outName, FILE_WRITE))
         ErrorExit("Could not open output file " + outName);
     outModel->Save(outFile);
+    outFile.Close();
+    SaveCookedCollisionGeometry(outName);
+}
+
+void SaveCookedCollisionGeometry(const String& modelName)
+{
+#ifdef URHO3D_PHYSICS
+    if (!cookTriangleMesh_ && !cookConvexHull_)
+        return;
+
+    // Cook from the saved model so that the geometry matches what is loaded at runtime
+    File modelFile(context_);
+    SharedPtr<Model> model(new Model(context_));
+    if (!modelFile.Open(modelName) || !model->Load(modelFile))
+        ErrorExit("Could not reload model " + modelName + " for cooking collision geometry");
+
+    unsigned numLodLevels = 0;
+    for (unsigned i = 0; i < model->GetNumGeometries(); ++i)
+        numLodLevels = Max(numLodLevels, model->GetNumGeometryLodLevels(i));
+
+    for (unsigned i = 0; i < numLodLevels; ++i)
+    {
+        if (cookTriangleMesh_)
+        {
+            String cookedName = GetCookedGeometryName(modelName, SHAPE_TRIANGLEMESH, i);
+            File cookedFile(context_);
+            if (!cookedFile.Open(cookedName, FILE_WRITE) || !CookCollisionGeometry(cookedFile, SHAPE_TRIANGLEMESH, model, i))
+                ErrorExit("Could not write cooked collision geometry " + cookedName);
+        }
+        if (cookConvexHull_)
+        {
+            String cookedName = GetCookedGeometryName(modelName, SHAPE_CONVEXHULL, i);
+            File cookedFile(context_);
+            if (!cookedFile.Open(cookedName, FILE_WRITE) || !CookCollisionGeometry(cookedFile, SHAPE_CONVEXHULL, model, i))
+                ErrorExit("Could not write cooked collision geometry " + cookedName);
+        }
+    }
+#else
+    if (cookTriangleMesh_ || cookConvexHull_)
+        PrintLine("Warning: physics is disabled in this build, collision geometry was not cooked");
+#endif
 }
 
 void GetMeshesUnderNode(Vector<Pair<aiNode*, aiMesh*> >& dest, aiNode* node)
@@ -0,0 +1,205 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/AnimatedModel.h>
+#include <Urho3D/Graphics/Animation.h>
+#include <Urho3D/Graphics/AnimationState.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+/// Number of bones in the benchmark skeleton.
+static const unsigned NUM_BONES = 48;
+/// Number of key frames in each animation track.
+static const unsigned NUM_KEYFRAMES = 31;
+/// Length of the benchmark animations in seconds.
+static const float ANIMATION_LENGTH = 1.0f;
+/// Simulated frame time step.
+static const float FRAME_TIME_STEP = 1.0f / 60.0f;
+
+static String GetBoneName(unsigned index)
+{
+    return "Bone" + String(index);
+}
+
+static SharedPtr<Model> CreateBenchmarkModel(Context* context)
+{
+    SharedPtr<Model> model(new Model(context));
+    Skeleton skeleton;
+    Vector<Bone>& bones = skeleton.GetModifiableBones();
+
+    // Spine of six bones, with limbs of six bones branching from it
+    for (unsigned i = 0; i < NUM_BONES; ++i)
+    {
+        Bone bone;
+        bone.name_ = GetBoneName(i);
+        bone.nameHash_ = bone.name_;
+        bone.parentIndex_ = i < 6 ? (i ? i - 1 : 0) : (i % 6 ? i - 1 : i / 6 - 1);
+        bone.initialPosition_ = Vector3(0.0f, 0.2f, 0.0f);
+        bone.initialRotation_ = Quaternion(5.0f * i, Vector3::FORWARD);
+        bones.Push(bone);
+    }
+
+    skeleton.SetRootBoneIndex(0);
+    model->SetSkeleton(skeleton);
+    model->SetBoundingBox(BoundingBox(-Vector3::ONE, Vector3::ONE));
+    return model;
+}
+
+static SharedPtr<Animation> CreateBenchmarkAnimation(Context* context, unsigned index)
+{
+    SharedPtr<Animation> animation(new Animation(context));
+    animation->SetAnimationName("Animation" + String(index));
+    animation->SetLength(ANIMATION_LENGTH);
+
+    for (unsigned i = 0; i < NUM_BONES; ++i)
+    {
+        AnimationTrack* track = animation->CreateTrack(GetBoneName(i));
+        track->channelMask_ = CHANNEL_POSITION | CHANNEL_ROTATION;
+        for (unsigned j = 0; j < NUM_KEYFRAMES; ++j)
+        {
+            float angle = 360.0f * j / (NUM_KEYFRAMES - 1) + 30.0f * index;
+            AnimationKeyFrame keyFrame;
+            keyFrame.time_ = ANIMATION_LENGTH * j / (NUM_KEYFRAMES - 1);
+            keyFrame.position_ = Vector3(0.02f * Sin(angle), 0.2f, 0.02f * Cos(angle));
+            keyFrame.rotation_ = Quaternion(20.0f * Sin(angle + i), 10.0f * Cos(angle), 5.0f * i);
+            track->AddKeyFrame(keyFrame);
+        }
+    }
+
+    return animation;
+}
+
+static void AnimateWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto** start = reinterpret_cast<AnimatedModel**>(item->start_);
+    auto** end = reinterpret_cast<AnimatedModel**>(item->end_);
+    while (start != end)
+        (*start++)->ApplyAnimation();
+}
+
+/// Animate the characters for a number of frames and return milliseconds per frame per 1000 characters.
+static double MeasureAnimation(WorkQueue* queue, PODVector<AnimatedModel*>& models, unsigned numFrames)
+{
+    HiresTimer timer;
+
+    for (unsigned frame = 0; frame < numFrames; ++frame)
+    {
+        for (PODVector<AnimatedModel*>::Iterator i = models.Begin(); i != models.End(); ++i)
+            (*i)->GetAnimationState(0U)->AddTime(FRAME_TIME_STEP);
+
+        if (queue->GetNumThreads())
+        {
+            unsigned numItems = queue->GetNumThreads() + 1;
+            unsigned modelsPerItem = (models.Size() + numItems - 1) / numItems;
+            for (unsigned start = 0; start < models.Size(); start += modelsPerItem)
+            {
+                SharedPtr<WorkItem> item = queue->GetFreeItem();
+                item->priority_ = M_MAX_UNSIGNED;
+                item->workFunction_ = AnimateWork;
+                item->start_ = &models[start];
+                item->end_ = &models[0] + Min(start + modelsPerItem, models.Size());
+                queue->AddWorkItem(item);
+            }
+            queue->Complete(M_MAX_UNSIGNED);
+        }
+        else
+        {
+            for (PODVector<AnimatedModel*>::Iterator i = models.Begin(); i != models.End(); ++i)
+                (*i)->ApplyAnimation();
+        }
+    }
+
+    long long usec = timer.GetUSec(false);
+    return models.Size() ? usec / 1000.0 / numFrames * 1000.0 / models.Size() : 0.0;
+}
+
+void RunAnimationBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numCharacters = GetOption(arguments, "-n", 1000);
+    unsigned numFrames = GetOption(arguments, "-f", 100);
+    unsigned numAnimations = Max(GetOption(arguments, "-a", 4), 1U);
+    unsigned numPhases = Max(GetOption(arguments, "-p", 8), 1U);
+    unsigned numThreads = GetOption(arguments, "-t", 0);
+    bool compress = arguments.Contains("-c");
+
+    PrintLine(ToString("  %u characters, %u bones, %u %sanimations, %u start phases, %u frames, %u worker threads",
+        numCharacters, NUM_BONES, numAnimations, compress ? "compressed " : "", numPhases, numFrames, numThreads));
+
+    if (!context->GetSubsystem<WorkQueue>())
+        context->RegisterSubsystem(new WorkQueue(context));
+    auto* queue = context->GetSubsystem<WorkQueue>();
+    if (numThreads && !queue->GetNumThreads())
+        queue->CreateThreads(numThreads);
+
+    RegisterSceneLibrary(context);
+    RegisterGraphicsLibrary(context);
+
+    SharedPtr<Model> model = CreateBenchmarkModel(context);
+    Vector<SharedPtr<Animation> > animations;
+    for (unsigned i = 0; i < numAnimations; ++i)
+    {
+        animations.Push(CreateBenchmarkAnimation(context, i));
+        if (compress)
+            animations.Back()->Compress();
+    }
+
+    SharedPtr<Scene> scene(new Scene(context));
+    PODVector<AnimatedModel*> models;
+    SetRandomSeed(1);
+
+    for (unsigned i = 0; i < numCharacters; ++i)
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition(Vector3(Random(100.0f), 0.0f, Random(100.0f)));
+        auto* animatedModel = node->CreateComponent<AnimatedModel>();
+        animatedModel->SetBoneNodesEnabled(false);
+        animatedModel->SetModel(model);
+        AnimationState* state = animatedModel->AddAnimationState(animations[Rand() % numAnimations]);
+        state->SetWeight(1.0f);
+        state->SetLooped(true);
+        state->SetTime(ANIMATION_LENGTH * (Rand() % numPhases) / numPhases);
+        models.Push(animatedModel);
+    }
+
+    PrintResult("without pose sharing", MeasureAnimation(queue, models, numFrames), "ms per 1000 characters");
+
+    for (PODVector<AnimatedModel*>::Iterator i = models.Begin(); i != models.End(); ++i)
+        (*i)->SetPoseSharing(true);
+    model->GetPoseCache()->ResetStats();
+
+    PrintResult("with pose sharing", MeasureAnimation(queue, models, numFrames), "ms per 1000 characters");
+
+    AnimationPoseCache* poseCache = model->GetPoseCache();
+    unsigned numLookups = poseCache->GetNumHits() + poseCache->GetNumMisses();
+    PrintResult("pose cache hit rate", numLookups ? 100.0 * poseCache->GetNumHits() / numLookups : 0.0, "%");
+}
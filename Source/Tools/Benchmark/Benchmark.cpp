@@ -0,0 +1,138 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+
+#include "Benchmark.h"
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <Urho3D/DebugNew.h>
+
+struct BenchmarkCase
+{
+    /// Name used on the command line.
+    const char* name_;
+    /// Description.
+    const char* description_;
+    /// Function to run.
+    BenchmarkFunction function_;
+};
+
+static const BenchmarkCase benchmarks[] =
+{
+    {"animation", "AnimatedModel update cost per 1000 characters without bone nodes, with and without pose sharing (-n characters, -f frames, -a animations, -p start phases, -t threads, -c to compress the animations)", RunAnimationBenchmark},
+    {"events", "Object::SendEvent cost per receiver, plain and nested sends (-n receivers, -r rounds)", RunEventBenchmark},
+    {"occlusion", "Occlusion buffer rasterization and occludee test cost, single-threaded vs. threaded, single vs. batched tests (-i recorded occluder set, -o file to save the set, -n generated occludees, -w width, -h height, -f frames, -t threads)", RunOcclusionBenchmark},
+    {"particles", "Particle emitter update and billboard vertex generation cost, AoS vs. SoA particle storage (-n emitters, -p particles per emitter, -f frames, -t threads)", RunParticleBenchmark},
+    {"physicsqueries", "Physics world raycast, sphere cast and convex cast rate, single-call vs. batched queries (-n bodies, -q queries per round, -r rounds, -t threads)", RunPhysicsQueryBenchmark},
+    {"spatial", "Octree vs. AABB tree spatial index update, frustum query and raycast cost with moving objects (-n objects, -m percent moving, -f frames, -q queries per frame)", RunSpatialBenchmark},
+    {"workqueue", "WorkQueue throughput with tiny and large work items, shared queue vs. work stealing (-t threads, -n items, -r rounds)", RunWorkQueueBenchmark},
+    {nullptr, nullptr, nullptr}
+};
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+
+    Run(arguments);
+    return 0;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    if (arguments.Empty())
+    {
+        String usage = "Usage: Benchmark <benchmark name|all> [options]\n\nBenchmarks:\n";
+        for (const BenchmarkCase* i = benchmarks; i->name_; ++i)
+            usage += PadRight(i->name_, 16) + i->description_ + "\n";
+        ErrorExit(usage);
+    }
+
+    SharedPtr<Context> context(new Context());
+    // The Time subsystem initializes the high-resolution timer frequency
+    context->RegisterSubsystem(new Time(context));
+    Vector<String> options(arguments);
+    options.Erase(0);
+    bool found = false;
+
+    for (const BenchmarkCase* i = benchmarks; i->name_; ++i)
+    {
+        if (arguments[0] == "all" || arguments[0] == i->name_)
+        {
+            PrintLine("Running benchmark " + String(i->name_));
+            i->function_(context, options);
+            found = true;
+        }
+    }
+
+    if (!found)
+        ErrorExit("Unknown benchmark " + arguments[0]);
+}
+
+unsigned GetOption(const Vector<String>& arguments, const String& name, unsigned defaultValue)
+{
+    for (unsigned i = 0; i + 1 < arguments.Size(); ++i)
+    {
+        if (arguments[i] == name)
+            return ToUInt(arguments[i + 1]);
+    }
+
+    return defaultValue;
+}
+
+String GetStringOption(const Vector<String>& arguments, const String& name, const String& defaultValue)
+{
+    for (unsigned i = 0; i + 1 < arguments.Size(); ++i)
+    {
+        if (arguments[i] == name)
+            return arguments[i + 1];
+    }
+
+    return defaultValue;
+}
+
+String PadRight(const String& str, unsigned width)
+{
+    String ret = str;
+    while (ret.Length() < width)
+        ret += ' ';
+    return ret;
+}
+
+void PrintResult(const String& name, double value, const String& unit)
+{
+    PrintLine("  " + PadRight(name, 48) + String(value) + " " + unit);
+}
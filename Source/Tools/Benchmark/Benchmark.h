@@ -0,0 +1,56 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/StringUtils.h>
+
+using namespace Urho3D;
+
+/// Benchmark case function. Called with the arguments following the case name.
+using BenchmarkFunction = void (*)(Context* context, const Vector<String>& arguments);
+
+/// Return the value of an integer option such as "-n 1000", or the default value if not specified.
+unsigned GetOption(const Vector<String>& arguments, const String& name, unsigned defaultValue);
+/// Return the value of a string option such as "-i file.bin", or the default value if not specified.
+String GetStringOption(const Vector<String>& arguments, const String& name, const String& defaultValue);
+/// Return string padded with spaces to the specified width.
+String PadRight(const String& str, unsigned width);
+/// Print a single benchmark result line.
+void PrintResult(const String& name, double value, const String& unit);
+
+/// Benchmark skeletal animation cost per 1000 characters with and without bone pose sharing.
+void RunAnimationBenchmark(Context* context, const Vector<String>& arguments);
+/// Benchmark event dispatch cost per receiver for plain and nested sends.
+void RunEventBenchmark(Context* context, const Vector<String>& arguments);
+/// Benchmark occlusion buffer rasterization and occludee test cost with a generated or recorded occluder set.
+void RunOcclusionBenchmark(Context* context, const Vector<String>& arguments);
+/// Benchmark particle emitter simulation and billboard vertex generation cost in the AoS and SoA storage modes.
+void RunParticleBenchmark(Context* context, const Vector<String>& arguments);
+/// Benchmark physics world scene query rate with the single-call and batched query functions.
+void RunPhysicsQueryBenchmark(Context* context, const Vector<String>& arguments);
+/// Benchmark spatial index update and query cost with moving objects, octree vs. AABB tree.
+void RunSpatialBenchmark(Context* context, const Vector<String>& arguments);
+/// Benchmark WorkQueue throughput with tiny and large work items in the shared queue and work stealing modes.
+void RunWorkQueueBenchmark(Context* context, const Vector<String>& arguments);
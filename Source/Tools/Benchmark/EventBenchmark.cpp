@@ -0,0 +1,150 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+/// Event sent to all receivers by the benchmark sender.
+static const StringHash E_BENCHMARKOUTER("BenchmarkOuter");
+/// Event sent by receivers from inside their handler when measuring nested sends.
+static const StringHash E_BENCHMARKINNER("BenchmarkInner");
+
+/// Benchmark event sender.
+class EventSender : public Object
+{
+    URHO3D_OBJECT(EventSender, Object);
+
+public:
+    /// Construct.
+    explicit EventSender(Context* context) :
+        Object(context)
+    {
+    }
+};
+
+/// Benchmark event receiver. Optionally sends a nested event from its handler.
+class EventReceiver : public Object
+{
+    URHO3D_OBJECT(EventReceiver, Object);
+
+public:
+    /// Construct.
+    EventReceiver(Context* context, EventSender* nestedSender) :
+        Object(context),
+        nestedSender_(nestedSender),
+        count_(0)
+    {
+    }
+
+    /// Subscribe to the outer event from the sender, and optionally from any sender.
+    void SubscribeOuter(EventSender* sender, bool nonSpecific)
+    {
+        SubscribeToEvent(sender, E_BENCHMARKOUTER, URHO3D_HANDLER(EventReceiver, HandleOuter));
+        if (nonSpecific)
+            SubscribeToEvent(E_BENCHMARKOUTER, URHO3D_HANDLER(EventReceiver, HandleOuter));
+    }
+
+    /// Subscribe to the nested event from the sender.
+    void SubscribeInner(EventSender* sender)
+    {
+        SubscribeToEvent(sender, E_BENCHMARKINNER, URHO3D_HANDLER(EventReceiver, HandleInner));
+    }
+
+    /// Handle the outer event.
+    void HandleOuter(StringHash eventType, VariantMap& eventData)
+    {
+        ++count_;
+        if (nestedSender_)
+            nestedSender_->SendEvent(E_BENCHMARKINNER, eventData);
+    }
+
+    /// Handle the nested event.
+    void HandleInner(StringHash eventType, VariantMap& eventData)
+    {
+        ++count_;
+    }
+
+    /// Sender of nested events, or null if not sending.
+    EventSender* nestedSender_;
+    /// Number of events received.
+    unsigned count_;
+};
+
+static double MeasureDispatch(Context* context, unsigned numReceivers, unsigned numRounds, bool nonSpecific, bool nested)
+{
+    SharedPtr<EventSender> sender(new EventSender(context));
+    SharedPtr<EventSender> nestedSender(nested ? new EventSender(context) : nullptr);
+    Vector<SharedPtr<EventReceiver> > receivers;
+
+    for (unsigned i = 0; i < numReceivers; ++i)
+    {
+        SharedPtr<EventReceiver> receiver(new EventReceiver(context, nestedSender));
+        // Every tenth receiver also listens to the event from any sender, which exercises the double delivery check
+        receiver->SubscribeOuter(sender, nonSpecific && i % 10 == 0);
+        receivers.Push(receiver);
+    }
+
+    // One receiver for the nested events, so that each nested send has its own dispatch cost
+    SharedPtr<EventReceiver> nestedReceiver;
+    if (nested)
+    {
+        nestedReceiver = new EventReceiver(context, nullptr);
+        nestedReceiver->SubscribeInner(nestedSender);
+    }
+
+    VariantMap& eventData = context->GetEventDataMap();
+    // Warm up so that the scratch storage has reached its steady state size
+    sender->SendEvent(E_BENCHMARKOUTER, eventData);
+
+    HiresTimer timer;
+    for (unsigned round = 0; round < numRounds; ++round)
+        sender->SendEvent(E_BENCHMARKOUTER, eventData);
+    long long usec = timer.GetUSec(false);
+
+    unsigned numDeliveries = 0;
+    for (unsigned i = 0; i < receivers.Size(); ++i)
+        numDeliveries += receivers[i]->count_;
+    if (nestedReceiver)
+        numDeliveries += nestedReceiver->count_;
+    // Exclude the warmup round
+    numDeliveries = numDeliveries * numRounds / (numRounds + 1);
+
+    return numDeliveries ? (double)usec * 1000.0 / numDeliveries : 0.0;
+}
+
+void RunEventBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numReceivers = GetOption(arguments, "-n", 5000);
+    unsigned numRounds = GetOption(arguments, "-r", 200);
+
+    PrintLine(ToString("  %u receivers, %u rounds", numReceivers, numRounds));
+
+    PrintResult("specific receivers", MeasureDispatch(context, numReceivers, numRounds, false, false), "ns/receiver");
+    PrintResult("specific and non-specific receivers", MeasureDispatch(context, numReceivers, numRounds, true, false),
+        "ns/receiver");
+    PrintResult("nested sends", MeasureDispatch(context, numReceivers, numRounds, false, true), "ns/receiver");
+}
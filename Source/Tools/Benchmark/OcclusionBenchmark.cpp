@@ -0,0 +1,331 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/OcclusionBuffer.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+/// Number of rooms per side in the generated occluder set.
+static const int NUM_ROOMS = 12;
+/// Size of a generated room.
+static const float ROOM_SIZE = 20.0f;
+/// Height of the generated walls.
+static const float WALL_HEIGHT = 6.0f;
+
+/// Occluder mesh of an occluder set.
+struct OccluderMesh
+{
+    /// World transform.
+    Matrix3x4 transform_;
+    /// Vertex positions.
+    PODVector<Vector3> vertices_;
+    /// Triangle list indices.
+    PODVector<unsigned> indices_;
+};
+
+/// Recorded occlusion workload: a camera view, the occluders drawn from it and the bounding boxes tested for occlusion.
+struct OccluderSet
+{
+    /// Camera position.
+    Vector3 cameraPosition_;
+    /// Camera rotation.
+    Quaternion cameraRotation_;
+    /// Camera vertical field of view.
+    float fov_;
+    /// Camera aspect ratio.
+    float aspectRatio_;
+    /// Camera far clip distance.
+    float farClip_;
+    /// Occluders.
+    Vector<OccluderMesh> occluders_;
+    /// Occludee bounding boxes.
+    PODVector<BoundingBox> occludees_;
+};
+
+/// Return a box occluder mesh.
+static OccluderMesh CreateBoxOccluder(const Vector3& position, const Vector3& size)
+{
+    static const Vector3 boxVertices[] = {Vector3(-0.5f, -0.5f, -0.5f), Vector3(0.5f, -0.5f, -0.5f), Vector3(0.5f, 0.5f, -0.5f),
+        Vector3(-0.5f, 0.5f, -0.5f), Vector3(-0.5f, -0.5f, 0.5f), Vector3(0.5f, -0.5f, 0.5f), Vector3(0.5f, 0.5f, 0.5f),
+        Vector3(-0.5f, 0.5f, 0.5f)};
+    static const unsigned boxIndices[] = {0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4, 3, 6, 2, 3, 7, 6, 0, 4, 7, 0, 7, 3, 1,
+        2, 6, 1, 6, 5};
+
+    OccluderMesh mesh;
+    mesh.transform_ = Matrix3x4(position, Quaternion::IDENTITY, size);
+    for (const Vector3& vertex : boxVertices)
+        mesh.vertices_.Push(vertex);
+    for (unsigned index : boxIndices)
+        mesh.indices_.Push(index);
+    return mesh;
+}
+
+/// Generate an indoor occluder set: a grid of rooms with doorways, viewed from a corner room, and furniture-sized occludees.
+static void GenerateOccluderSet(OccluderSet& set, unsigned numOccludees)
+{
+    SetRandomSeed(1);
+
+    set.cameraPosition_ = Vector3(ROOM_SIZE * 0.5f, 1.7f, ROOM_SIZE * 0.5f);
+    set.cameraRotation_ = Quaternion(5.0f, 40.0f, 0.0f);
+    set.fov_ = 60.0f;
+    set.aspectRatio_ = 16.0f / 9.0f;
+    set.farClip_ = NUM_ROOMS * ROOM_SIZE * 1.5f;
+
+    // Walls along both axes, split in two by a doorway
+    for (int i = 0; i <= NUM_ROOMS; ++i)
+    {
+        for (int j = 0; j < NUM_ROOMS; ++j)
+        {
+            float line = i * ROOM_SIZE;
+            float start = j * ROOM_SIZE;
+            float door = Random(4.0f, ROOM_SIZE - 4.0f);
+            float y = WALL_HEIGHT * 0.5f;
+            set.occluders_.Push(CreateBoxOccluder(Vector3(line, y, start + (door - 1.0f) * 0.5f), Vector3(0.3f, WALL_HEIGHT, door - 1.0f)));
+            set.occluders_.Push(CreateBoxOccluder(Vector3(line, y, start + (door + 1.0f + ROOM_SIZE) * 0.5f),
+                Vector3(0.3f, WALL_HEIGHT, ROOM_SIZE - door - 1.0f)));
+            door = Random(4.0f, ROOM_SIZE - 4.0f);
+            set.occluders_.Push(CreateBoxOccluder(Vector3(start + (door - 1.0f) * 0.5f, y, line), Vector3(door - 1.0f, WALL_HEIGHT, 0.3f)));
+            set.occluders_.Push(CreateBoxOccluder(Vector3(start + (door + 1.0f + ROOM_SIZE) * 0.5f, y, line),
+                Vector3(ROOM_SIZE - door - 1.0f, WALL_HEIGHT, 0.3f)));
+        }
+    }
+
+    for (unsigned i = 0; i < numOccludees; ++i)
+    {
+        Vector3 center(Random(NUM_ROOMS * ROOM_SIZE), Random(0.5f, 3.0f), Random(NUM_ROOMS * ROOM_SIZE));
+        Vector3 halfSize(Random(0.2f, 1.5f), Random(0.2f, 1.0f), Random(0.2f, 1.5f));
+        set.occludees_.Push(BoundingBox(center - halfSize, center + halfSize));
+    }
+}
+
+/// Load an occluder set from a file. Return true on success.
+static bool LoadOccluderSet(Context* context, const String& fileName, OccluderSet& set)
+{
+    File file(context, fileName);
+    if (!file.IsOpen() || file.ReadFileID() != "OCCS")
+        return false;
+
+    set.cameraPosition_ = file.ReadVector3();
+    set.cameraRotation_ = file.ReadQuaternion();
+    set.fov_ = file.ReadFloat();
+    set.aspectRatio_ = file.ReadFloat();
+    set.farClip_ = file.ReadFloat();
+
+    set.occluders_.Resize(file.ReadUInt());
+    for (Vector<OccluderMesh>::Iterator i = set.occluders_.Begin(); i != set.occluders_.End(); ++i)
+    {
+        i->transform_ = file.ReadMatrix3x4();
+
+        // Check the counts against the remaining file size before allocating
+        unsigned numVertices = file.ReadUInt();
+        if (numVertices > (file.GetSize() - file.GetPosition()) / sizeof(Vector3))
+            return false;
+        i->vertices_.Resize(numVertices);
+        file.Read(i->vertices_.Buffer(), numVertices * sizeof(Vector3));
+
+        unsigned numIndices = file.ReadUInt();
+        if (numIndices % 3 || numIndices > (file.GetSize() - file.GetPosition()) / sizeof(unsigned))
+            return false;
+        i->indices_.Resize(numIndices);
+        file.Read(i->indices_.Buffer(), numIndices * sizeof(unsigned));
+
+        // Reject triangles referring to vertices outside the mesh
+        for (PODVector<unsigned>::ConstIterator j = i->indices_.Begin(); j != i->indices_.End(); ++j)
+        {
+            if (*j >= numVertices)
+                return false;
+        }
+    }
+
+    unsigned numOccludees = file.ReadUInt();
+    if (numOccludees > (file.GetSize() - file.GetPosition()) / (2 * sizeof(Vector3)))
+        return false;
+    set.occludees_.Resize(numOccludees);
+    for (PODVector<BoundingBox>::Iterator i = set.occludees_.Begin(); i != set.occludees_.End(); ++i)
+        *i = file.ReadBoundingBox();
+
+    return true;
+}
+
+/// Save an occluder set to a file. Return true on success.
+static bool SaveOccluderSet(Context* context, const String& fileName, const OccluderSet& set)
+{
+    File file(context, fileName, FILE_WRITE);
+    if (!file.IsOpen())
+        return false;
+
+    file.WriteFileID("OCCS");
+    file.WriteVector3(set.cameraPosition_);
+    file.WriteQuaternion(set.cameraRotation_);
+    file.WriteFloat(set.fov_);
+    file.WriteFloat(set.aspectRatio_);
+    file.WriteFloat(set.farClip_);
+
+    file.WriteUInt(set.occluders_.Size());
+    for (Vector<OccluderMesh>::ConstIterator i = set.occluders_.Begin(); i != set.occluders_.End(); ++i)
+    {
+        file.WriteMatrix3x4(i->transform_);
+        file.WriteUInt(i->vertices_.Size());
+        file.Write(i->vertices_.Buffer(), i->vertices_.Size() * sizeof(Vector3));
+        file.WriteUInt(i->indices_.Size());
+        file.Write(i->indices_.Buffer(), i->indices_.Size() * sizeof(unsigned));
+    }
+
+    file.WriteUInt(set.occludees_.Size());
+    for (PODVector<BoundingBox>::ConstIterator i = set.occludees_.Begin(); i != set.occludees_.End(); ++i)
+        file.WriteBoundingBox(*i);
+
+    return true;
+}
+
+/// Occlusion benchmark results.
+struct OcclusionResults
+{
+    /// Milliseconds per frame spent rasterizing the occluders and building the depth hierarchy.
+    double drawTime_;
+    /// Microseconds per occludee tested one at a time.
+    double singleTestTime_;
+    /// Microseconds per occludee tested in one batch.
+    double batchTestTime_;
+    /// Number of visible occludees.
+    unsigned numVisible_;
+};
+
+/// Render the occluder set for a number of frames, then test the occludees one at a time and in batches.
+static OcclusionResults MeasureOcclusion(Context* context, const OccluderSet& set, Camera* camera, int width, int height,
+    bool threaded, unsigned numFrames)
+{
+    SharedPtr<OcclusionBuffer> buffer(new OcclusionBuffer(context));
+    buffer->SetSize(width, height, threaded);
+    buffer->SetView(camera);
+    buffer->SetMaxTriangles(M_MAX_UNSIGNED);
+    buffer->SetCullMode(CULL_CCW);
+
+    OcclusionResults results;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        buffer->Clear();
+        for (Vector<OccluderMesh>::ConstIterator j = set.occluders_.Begin(); j != set.occluders_.End(); ++j)
+        {
+            buffer->AddTriangles(j->transform_, j->vertices_.Buffer(), sizeof(Vector3), j->indices_.Buffer(), sizeof(unsigned), 0,
+                j->indices_.Size());
+        }
+        buffer->DrawTriangles();
+        buffer->BuildDepthHierarchy();
+    }
+    results.drawTime_ = timer.GetUSec(true) / 1000.0 / Max(numFrames, 1U);
+
+    unsigned numOccludees = Max(set.occludees_.Size(), 1U);
+    PODVector<bool> visible(set.occludees_.Size());
+    results.numVisible_ = 0;
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        for (unsigned j = 0; j < set.occludees_.Size(); ++j)
+            visible[j] = buffer->IsVisible(set.occludees_[j]);
+    }
+    results.singleTestTime_ = (double)timer.GetUSec(true) / numFrames / numOccludees;
+
+    for (unsigned i = 0; i < numFrames; ++i)
+        buffer->IsVisible(set.occludees_.Buffer(), set.occludees_.Size(), visible.Buffer());
+    results.batchTestTime_ = (double)timer.GetUSec(true) / numFrames / numOccludees;
+
+    for (unsigned i = 0; i < visible.Size(); ++i)
+    {
+        if (visible[i])
+            ++results.numVisible_;
+    }
+
+    return results;
+}
+
+void RunOcclusionBenchmark(Context* context, const Vector<String>& arguments)
+{
+    int width = NextPowerOfTwo(GetOption(arguments, "-w", 256));
+    int height = GetOption(arguments, "-h", 128);
+    unsigned numFrames = Max(GetOption(arguments, "-f", 50), 1U);
+    unsigned numThreads = GetOption(arguments, "-t", 3);
+    unsigned numOccludees = GetOption(arguments, "-n", 20000);
+    String inputFile = GetStringOption(arguments, "-i", String::EMPTY);
+    String outputFile = GetStringOption(arguments, "-o", String::EMPTY);
+
+    OccluderSet set;
+    if (!inputFile.Empty())
+    {
+        if (!LoadOccluderSet(context, inputFile, set))
+        {
+            PrintLine("  Could not load occluder set " + inputFile);
+            return;
+        }
+    }
+    else
+        GenerateOccluderSet(set, numOccludees);
+
+    if (!outputFile.Empty() && !SaveOccluderSet(context, outputFile, set))
+        PrintLine("  Could not save occluder set " + outputFile);
+
+    unsigned numTriangles = 0;
+    for (Vector<OccluderMesh>::ConstIterator i = set.occluders_.Begin(); i != set.occluders_.End(); ++i)
+        numTriangles += i->indices_.Size() / 3;
+
+    PrintLine(ToString("  %u occluders with %u triangles, %u occludees, %dx%d buffer, %u frames, %u worker threads",
+        set.occluders_.Size(), numTriangles, set.occludees_.Size(), width, height, numFrames, numThreads));
+
+    if (!context->GetSubsystem<WorkQueue>())
+        context->RegisterSubsystem(new WorkQueue(context));
+    auto* queue = context->GetSubsystem<WorkQueue>();
+    if (numThreads && !queue->GetNumThreads())
+        queue->CreateThreads(numThreads);
+    RegisterSceneLibrary(context);
+    RegisterGraphicsLibrary(context);
+
+    SharedPtr<Node> cameraNode(new Node(context));
+    cameraNode->SetPosition(set.cameraPosition_);
+    cameraNode->SetRotation(set.cameraRotation_);
+    auto* camera = cameraNode->CreateComponent<Camera>();
+    camera->SetFov(set.fov_);
+    camera->SetAspectRatio(set.aspectRatio_);
+    camera->SetFarClip(set.farClip_);
+
+    const char* modeNames[] = {"single-threaded", "threaded"};
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        OcclusionResults results = MeasureOcclusion(context, set, camera, width, height, i == 1, numFrames);
+        String name(modeNames[i]);
+        PrintResult(name + " occluder rendering", results.drawTime_, "ms per frame");
+        PrintResult(name + " occludee test, single", results.singleTestTime_, "us per box");
+        PrintResult(name + " occludee test, batched", results.batchTestTime_, "us per box");
+        PrintResult(name + " visible occludees", results.numVisible_, "boxes");
+    }
+}
@@ -0,0 +1,235 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/ParticleEffect.h>
+#include <Urho3D/Graphics/ParticleEmitter.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+/// Simulated frame time step.
+static const float FRAME_TIME_STEP = 1.0f / 60.0f;
+/// Distance between the emitters.
+static const float EMITTER_SPACING = 20.0f;
+
+/// Particle emitter that can be filled to capacity at once, so that the measurement starts from a full effect.
+class BenchmarkEmitter : public ParticleEmitter
+{
+public:
+    /// Construct.
+    explicit BenchmarkEmitter(Context* context) :
+        ParticleEmitter(context)
+    {
+    }
+
+    /// Emit particles until there is no more room.
+    void Fill()
+    {
+        while (EmitNewParticle())
+        {
+        }
+    }
+};
+
+/// Per-frame timings of one storage mode.
+struct ParticleResults
+{
+    /// Simulation milliseconds per frame.
+    double updateTime_;
+    /// Vertex generation milliseconds per frame.
+    double vertexTime_;
+};
+
+static SharedPtr<ParticleEffect> CreateBenchmarkEffect(Context* context, unsigned numParticles)
+{
+    SharedPtr<ParticleEffect> effect(new ParticleEffect(context));
+    effect->SetNumParticles(numParticles);
+    effect->SetUpdateInvisible(true);
+    effect->SetRelative(false);
+    effect->SetEmitterType(EMITTER_SPHERE);
+    effect->SetEmitterSize(Vector3(4.0f, 4.0f, 4.0f));
+    effect->SetMinDirection(Vector3(-1.0f, 0.0f, -1.0f));
+    effect->SetMaxDirection(Vector3(1.0f, 1.0f, 1.0f));
+    effect->SetMinVelocity(1.0f);
+    effect->SetMaxVelocity(4.0f);
+    effect->SetConstantForce(Vector3(0.0f, -2.0f, 0.0f));
+    effect->SetDampingForce(0.5f);
+    effect->SetMinTimeToLive(1.0f);
+    effect->SetMaxTimeToLive(30.0f);
+    effect->SetMinRotationSpeed(-90.0f);
+    effect->SetMaxRotationSpeed(90.0f);
+    effect->SetMinParticleSize(Vector2(0.1f, 0.1f));
+    effect->SetMaxParticleSize(Vector2(0.5f, 0.5f));
+    effect->SetSizeAdd(0.05f);
+    effect->SetSizeMul(1.01f);
+    effect->SetMinEmissionRate(1000.0f);
+    effect->SetMaxEmissionRate(2000.0f);
+
+    Vector<ColorFrame> colorFrames;
+    colorFrames.Push(ColorFrame(Color::YELLOW, 0.0f));
+    colorFrames.Push(ColorFrame(Color::RED, 0.5f));
+    colorFrames.Push(ColorFrame(Color(0.2f, 0.2f, 0.2f, 0.0f), 10.0f));
+    effect->SetColorFrames(colorFrames);
+
+    Vector<TextureFrame> textureFrames(4);
+    for (unsigned i = 0; i < textureFrames.Size(); ++i)
+    {
+        textureFrames[i].uv_ = Rect(0.25f * i, 0.0f, 0.25f * (i + 1), 1.0f);
+        textureFrames[i].time_ = 0.25f * i;
+    }
+    effect->SetTextureFrames(textureFrames);
+
+    return effect;
+}
+
+/// Create full emitters in either storage mode, then simulate and generate their vertices for a number of frames.
+static ParticleResults MeasureParticles(Context* context, ParticleEffect* effect, bool soaStorage, unsigned numEmitters,
+    unsigned numFrames, Vector<SharedPtr<BenchmarkEmitter> >& emitters)
+{
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* octree = scene->CreateComponent<Octree>();
+    Node* cameraNode = scene->CreateChild();
+    cameraNode->SetPosition(Vector3(0.0f, 10.0f, -EMITTER_SPACING));
+    auto* camera = cameraNode->CreateComponent<Camera>();
+
+    for (unsigned i = 0; i < numEmitters; ++i)
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition(Vector3(EMITTER_SPACING * (i % 8), 0.0f, EMITTER_SPACING * (i / 8)));
+        SharedPtr<BenchmarkEmitter> emitter(new BenchmarkEmitter(context));
+        node->AddComponent(emitter, 0, LOCAL);
+        emitter->SetSoAStorage(soaStorage);
+        emitter->SetSeed(i + 1);
+        emitter->SetEffect(effect);
+        emitter->Fill();
+        emitters.Push(emitter);
+    }
+
+    FrameInfo frame;
+    frame.camera_ = camera;
+    frame.viewSize_ = IntVector2(1920, 1080);
+    frame.timeStep_ = FRAME_TIME_STEP;
+
+    long long updateTime = 0;
+    long long vertexTime = 0;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        frame.frameNumber_ = i + 1;
+
+        // The emitters are updated from the octree's drawable update, in worker threads if there are any
+        timer.Reset();
+        scene->Update(FRAME_TIME_STEP);
+        octree->Update(frame);
+        updateTime += timer.GetUSec(false);
+
+        timer.Reset();
+        for (Vector<SharedPtr<BenchmarkEmitter> >::Iterator j = emitters.Begin(); j != emitters.End(); ++j)
+        {
+            (*j)->UpdateBatches(frame);
+            (*j)->UpdateGeometry(frame);
+        }
+        vertexTime += timer.GetUSec(false);
+    }
+
+    ParticleResults results;
+    results.updateTime_ = updateTime / 1000.0 / Max(numFrames, 1U);
+    results.vertexTime_ = vertexTime / 1000.0 / Max(numFrames, 1U);
+    return results;
+}
+
+/// Return whether float values are equal up to rounding. The SIMD kernels do not contract multiply-adds the way the
+/// compiler may do for the scalar code, so the storage modes can differ in the last bits.
+static bool NearlyEquals(const float* lhs, const float* rhs, unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i)
+    {
+        if (Abs(lhs[i] - rhs[i]) > 1e-4f * Max(Abs(lhs[i]), 1.0f))
+            return false;
+    }
+    return true;
+}
+
+/// Return the number of billboards that differ between the two storage modes.
+static unsigned CountMismatches(const Vector<SharedPtr<BenchmarkEmitter> >& aosEmitters,
+    const Vector<SharedPtr<BenchmarkEmitter> >& soaEmitters)
+{
+    unsigned mismatches = 0;
+    for (unsigned i = 0; i < aosEmitters.Size(); ++i)
+    {
+        const PODVector<Billboard>& aos = aosEmitters[i]->GetBillboards();
+        const PODVector<Billboard>& soa = soaEmitters[i]->GetBillboards();
+        for (unsigned j = 0; j < aos.Size(); ++j)
+        {
+            const Billboard& a = aos[j];
+            const Billboard& b = soa[j];
+            if (a.enabled_ != b.enabled_ || (a.enabled_ && (!NearlyEquals(a.position_.Data(), b.position_.Data(), 3) ||
+                !NearlyEquals(a.size_.Data(), b.size_.Data(), 2) || !NearlyEquals(a.uv_.Data(), b.uv_.Data(), 4) ||
+                !NearlyEquals(a.color_.Data(), b.color_.Data(), 4) || !NearlyEquals(&a.rotation_, &b.rotation_, 1) ||
+                !NearlyEquals(a.direction_.Data(), b.direction_.Data(), 3))))
+                ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+void RunParticleBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numEmitters = Max(GetOption(arguments, "-n", 8), 1U);
+    unsigned numParticles = GetOption(arguments, "-p", 50000);
+    unsigned numFrames = GetOption(arguments, "-f", 100);
+    unsigned numThreads = GetOption(arguments, "-t", 0);
+
+    PrintLine(ToString("  %u emitters, %u particles each, %u frames, %u worker threads", numEmitters, numParticles, numFrames,
+        numThreads));
+
+    if (!context->GetSubsystem<WorkQueue>())
+        context->RegisterSubsystem(new WorkQueue(context));
+    auto* queue = context->GetSubsystem<WorkQueue>();
+    if (numThreads && !queue->GetNumThreads())
+        queue->CreateThreads(numThreads);
+
+    RegisterSceneLibrary(context);
+    RegisterGraphicsLibrary(context);
+
+    SharedPtr<ParticleEffect> effect = CreateBenchmarkEffect(context, numParticles);
+    // The emitters are kept alive after their scene is destroyed to compare the storage modes
+    Vector<SharedPtr<BenchmarkEmitter> > aosEmitters;
+    Vector<SharedPtr<BenchmarkEmitter> > soaEmitters;
+    ParticleResults aos = MeasureParticles(context, effect, false, numEmitters, numFrames, aosEmitters);
+    ParticleResults soa = MeasureParticles(context, effect, true, numEmitters, numFrames, soaEmitters);
+
+    PrintResult("AoS update", aos.updateTime_, "ms per frame");
+    PrintResult("SoA update", soa.updateTime_, "ms per frame");
+    PrintResult("vertex generation", aos.vertexTime_, "ms per frame");
+    PrintResult("SoA differing results", CountMismatches(aosEmitters, soaEmitters), "billboards");
+}
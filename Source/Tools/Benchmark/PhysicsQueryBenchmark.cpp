@@ -0,0 +1,191 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Math/Random.h>
+#ifdef URHO3D_PHYSICS
+#include <Urho3D/Physics/CollisionShape.h>
+#include <Urho3D/Physics/PhysicsWorld.h>
+#include <Urho3D/Physics/RigidBody.h>
+#endif
+#include <Urho3D/Scene/Scene.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+#ifdef URHO3D_PHYSICS
+
+/// Half size of the benchmark world on the horizontal plane.
+static const float QUERY_WORLD_SIZE = 200.0f;
+/// Length of the query rays and sweeps.
+static const float QUERY_DISTANCE = 50.0f;
+/// Radius of the swept spheres.
+static const float QUERY_RADIUS = 0.5f;
+
+/// Return the number of results that differ between the single-call and batched queries.
+static unsigned CountMismatches(const PODVector<PhysicsRaycastResult>& single, const PODVector<PhysicsRaycastResult>& batch)
+{
+    unsigned mismatches = 0;
+    for (unsigned i = 0; i < single.Size(); ++i)
+    {
+        if (i >= batch.Size() || single[i] != batch[i])
+            ++mismatches;
+    }
+    return mismatches;
+}
+
+/// Print the single-call and batched query rates and the number of differing results.
+static void PrintQueryResults(const String& name, unsigned numQueries, long long singleTime, long long batchTime,
+    unsigned mismatches)
+{
+    PrintResult(name + " single-call", numQueries * 1000000.0 / Max(singleTime, 1LL), "queries per second");
+    PrintResult(name + " batched", numQueries * 1000000.0 / Max(batchTime, 1LL), "queries per second");
+    PrintResult(name + " differing results", mismatches, "queries");
+}
+
+#endif
+
+void RunPhysicsQueryBenchmark(Context* context, const Vector<String>& arguments)
+{
+#ifdef URHO3D_PHYSICS
+    unsigned numBodies = GetOption(arguments, "-n", 5000);
+    unsigned numQueries = Max(GetOption(arguments, "-q", 20000), 1U);
+    unsigned numRounds = Max(GetOption(arguments, "-r", 10), 1U);
+    unsigned numThreads = GetOption(arguments, "-t", 0);
+
+    PrintLine(ToString("  %u static bodies, %u queries per round, %u rounds, %u worker threads", numBodies, numQueries, numRounds,
+        numThreads));
+
+    if (!context->GetSubsystem<WorkQueue>())
+        context->RegisterSubsystem(new WorkQueue(context));
+    auto* queue = context->GetSubsystem<WorkQueue>();
+    if (numThreads && !queue->GetNumThreads())
+        queue->CreateThreads(numThreads);
+
+    RegisterSceneLibrary(context);
+    RegisterPhysicsLibrary(context);
+
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* world = scene->CreateComponent<PhysicsWorld>();
+    SetRandomSeed(1);
+
+    for (unsigned i = 0; i < numBodies; ++i)
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition(Vector3(Random(-QUERY_WORLD_SIZE, QUERY_WORLD_SIZE), Random(10.0f),
+            Random(-QUERY_WORLD_SIZE, QUERY_WORLD_SIZE)));
+        node->SetRotation(Quaternion(Random(360.0f), Vector3::UP));
+        node->CreateComponent<RigidBody>();
+        auto* shape = node->CreateComponent<CollisionShape>();
+        switch (i % 3)
+        {
+        case 0:
+            shape->SetBox(Vector3(Random(0.5f, 4.0f), Random(0.5f, 4.0f), Random(0.5f, 4.0f)));
+            break;
+        case 1:
+            shape->SetSphere(Random(0.5f, 4.0f));
+            break;
+        default:
+            shape->SetCylinder(Random(0.5f, 4.0f), Random(1.0f, 6.0f));
+            break;
+        }
+    }
+    world->UpdateCollisions();
+
+    // The swept capsule is not attached to a rigid body, like a character probe
+    auto* probe = scene->CreateChild()->CreateComponent<CollisionShape>();
+    probe->SetCapsule(0.5f, 1.8f);
+
+    PODVector<PhysicsRaycastQuery> rayQueries(numQueries, PhysicsRaycastQuery());
+    PODVector<PhysicsConvexCastQuery> convexQueries(numQueries, PhysicsConvexCastQuery());
+    for (unsigned i = 0; i < numQueries; ++i)
+    {
+        PhysicsRaycastQuery& rayQuery = rayQueries[i];
+        Vector3 origin(Random(-QUERY_WORLD_SIZE, QUERY_WORLD_SIZE), Random(1.0f, 8.0f), Random(-QUERY_WORLD_SIZE, QUERY_WORLD_SIZE));
+        Vector3 direction(Random(-1.0f, 1.0f), Random(-0.2f, 0.2f), Random(-1.0f, 1.0f));
+        rayQuery.ray_ = Ray(origin, direction);
+        rayQuery.maxDistance_ = QUERY_DISTANCE;
+        rayQuery.radius_ = QUERY_RADIUS;
+
+        PhysicsConvexCastQuery& convexQuery = convexQueries[i];
+        convexQuery.shape_ = probe;
+        convexQuery.startPos_ = origin;
+        convexQuery.endPos_ = origin + rayQuery.ray_.direction_ * QUERY_DISTANCE;
+    }
+
+    PODVector<PhysicsRaycastResult> singleResults(numQueries);
+    PODVector<PhysicsRaycastResult> batchResults;
+    long long singleTime = 0;
+    long long batchTime = 0;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < numRounds; ++i)
+    {
+        timer.Reset();
+        for (unsigned j = 0; j < numQueries; ++j)
+            world->RaycastSingle(singleResults[j], rayQueries[j].ray_, rayQueries[j].maxDistance_);
+        singleTime += timer.GetUSec(false);
+
+        timer.Reset();
+        world->RaycastSingleBatch(batchResults, rayQueries);
+        batchTime += timer.GetUSec(false);
+    }
+    PrintQueryResults("raycast", numQueries * numRounds, singleTime, batchTime, CountMismatches(singleResults, batchResults));
+
+    singleTime = batchTime = 0;
+    for (unsigned i = 0; i < numRounds; ++i)
+    {
+        timer.Reset();
+        for (unsigned j = 0; j < numQueries; ++j)
+            world->SphereCast(singleResults[j], rayQueries[j].ray_, rayQueries[j].radius_, rayQueries[j].maxDistance_);
+        singleTime += timer.GetUSec(false);
+
+        timer.Reset();
+        world->SphereCastBatch(batchResults, rayQueries);
+        batchTime += timer.GetUSec(false);
+    }
+    PrintQueryResults("sphere cast", numQueries * numRounds, singleTime, batchTime, CountMismatches(singleResults, batchResults));
+
+    singleTime = batchTime = 0;
+    for (unsigned i = 0; i < numRounds; ++i)
+    {
+        timer.Reset();
+        for (unsigned j = 0; j < numQueries; ++j)
+        {
+            const PhysicsConvexCastQuery& query = convexQueries[j];
+            world->ConvexCast(singleResults[j], query.shape_, query.startPos_, query.startRot_, query.endPos_, query.endRot_);
+        }
+        singleTime += timer.GetUSec(false);
+
+        timer.Reset();
+        world->ConvexCastBatch(batchResults, convexQueries);
+        batchTime += timer.GetUSec(false);
+    }
+    PrintQueryResults("convex cast", numQueries * numRounds, singleTime, batchTime, CountMismatches(singleResults, batchResults));
+#else
+    PrintLine("  Physics is disabled in this build");
+#endif
+}
@@ -0,0 +1,206 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/Model.h>
+#include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Graphics/StaticModel.h>
+#include <Urho3D/Math/Random.h>
+#include <Urho3D/Scene/Scene.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+/// Half size of the benchmark world on the horizontal plane.
+static const float WORLD_SIZE = 900.0f;
+/// Maximum speed of the moving objects in units per second.
+static const float MAX_SPEED = 20.0f;
+/// Simulated frame time step.
+static const float FRAME_TIME_STEP = 1.0f / 60.0f;
+/// Far clip distance of the query frustums.
+static const float QUERY_FAR_CLIP = 300.0f;
+
+/// Moving object of the benchmark scene.
+struct MovingObject
+{
+    /// Scene node.
+    Node* node_;
+    /// Velocity.
+    Vector3 velocity_;
+};
+
+/// Spatial index benchmark results.
+struct SpatialResults
+{
+    /// Milliseconds per frame spent moving the objects and updating the spatial index.
+    double updateTime_;
+    /// Milliseconds per frustum query.
+    double frustumTime_;
+    /// Milliseconds per raycast.
+    double raycastTime_;
+    /// Average number of drawables returned by a frustum query.
+    double frustumResults_;
+};
+
+static SharedPtr<Model> CreateBoxModel(Context* context, float halfSize)
+{
+    SharedPtr<Model> model(new Model(context));
+    model->SetBoundingBox(BoundingBox(-halfSize, halfSize));
+    return model;
+}
+
+static Frustum GetQueryFrustum(unsigned index)
+{
+    // Cameras at deterministic positions looking along the ground plane
+    Vector3 position(WORLD_SIZE * Sin(37.0f * index), 10.0f, WORLD_SIZE * Cos(53.0f * index));
+    Frustum frustum;
+    frustum.Define(60.0f, 16.0f / 9.0f, 1.0f, 0.1f, QUERY_FAR_CLIP, Matrix3x4(position, Quaternion(71.0f * index, Vector3::UP), 1.0f));
+    return frustum;
+}
+
+static Ray GetQueryRay(unsigned index)
+{
+    Vector3 origin(WORLD_SIZE * Sin(29.0f * index), 5.0f, WORLD_SIZE * Cos(41.0f * index));
+    return Ray(origin, Vector3(Sin(83.0f * index), -0.05f, Cos(83.0f * index)));
+}
+
+/// Build the scene with the given spatial index, then run the moving and query frames.
+static SpatialResults MeasureSpatialIndex(Context* context, SpatialIndexType type, unsigned numObjects, unsigned movingPercent,
+    unsigned numFrames, unsigned numQueries)
+{
+    SharedPtr<Scene> scene(new Scene(context));
+    auto* octree = scene->CreateComponent<Octree>();
+    octree->SetSpatialIndex(type);
+
+    Vector<SharedPtr<Model> > models;
+    models.Push(CreateBoxModel(context, 0.5f));
+    models.Push(CreateBoxModel(context, 2.0f));
+    models.Push(CreateBoxModel(context, 8.0f));
+
+    SetRandomSeed(1);
+    PODVector<MovingObject> movingObjects;
+    for (unsigned i = 0; i < numObjects; ++i)
+    {
+        Node* node = scene->CreateChild();
+        node->SetPosition(Vector3(Random(-WORLD_SIZE, WORLD_SIZE), Random(20.0f), Random(-WORLD_SIZE, WORLD_SIZE)));
+        auto* staticModel = node->CreateComponent<StaticModel>();
+        staticModel->SetModel(models[Rand() % models.Size()]);
+
+        if (Rand() % 100 < (int)movingPercent)
+        {
+            MovingObject object;
+            object.node_ = node;
+            object.velocity_ = Vector3(Random(-MAX_SPEED, MAX_SPEED), 0.0f, Random(-MAX_SPEED, MAX_SPEED));
+            movingObjects.Push(object);
+        }
+    }
+
+    FrameInfo frame;
+    frame.timeStep_ = FRAME_TIME_STEP;
+    octree->Update(frame);
+
+    SpatialResults results;
+    PODVector<Drawable*> drawables;
+    PODVector<RayQueryResult> rayResults;
+    long long updateTime = 0;
+    long long frustumTime = 0;
+    long long raycastTime = 0;
+    unsigned numResults = 0;
+    unsigned queryIndex = 0;
+    HiresTimer timer;
+
+    for (unsigned i = 0; i < numFrames; ++i)
+    {
+        timer.Reset();
+        for (PODVector<MovingObject>::Iterator j = movingObjects.Begin(); j != movingObjects.End(); ++j)
+        {
+            Vector3 position = j->node_->GetPosition() + j->velocity_ * FRAME_TIME_STEP;
+            // Bounce back from the world edges
+            if (Abs(position.x_) > WORLD_SIZE)
+                j->velocity_.x_ = -j->velocity_.x_;
+            if (Abs(position.z_) > WORLD_SIZE)
+                j->velocity_.z_ = -j->velocity_.z_;
+            j->node_->SetPosition(position);
+        }
+        octree->Update(frame);
+        updateTime += timer.GetUSec(false);
+
+        timer.Reset();
+        for (unsigned j = 0; j < numQueries; ++j)
+        {
+            FrustumOctreeQuery query(drawables, GetQueryFrustum(queryIndex + j), DRAWABLE_GEOMETRY);
+            octree->GetDrawables(query);
+            numResults += drawables.Size();
+        }
+        frustumTime += timer.GetUSec(false);
+
+        timer.Reset();
+        for (unsigned j = 0; j < numQueries; ++j)
+        {
+            RayOctreeQuery query(rayResults, GetQueryRay(queryIndex + j), RAY_AABB, QUERY_FAR_CLIP, DRAWABLE_GEOMETRY);
+            octree->Raycast(query);
+        }
+        raycastTime += timer.GetUSec(false);
+
+        queryIndex += numQueries;
+    }
+
+    unsigned totalQueries = Max(numFrames * numQueries, 1U);
+    results.updateTime_ = updateTime / 1000.0 / Max(numFrames, 1U);
+    results.frustumTime_ = frustumTime / 1000.0 / totalQueries;
+    results.raycastTime_ = raycastTime / 1000.0 / totalQueries;
+    results.frustumResults_ = (double)numResults / totalQueries;
+    return results;
+}
+
+void RunSpatialBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numObjects = GetOption(arguments, "-n", 20000);
+    unsigned movingPercent = Min(GetOption(arguments, "-m", 25), 100U);
+    unsigned numFrames = GetOption(arguments, "-f", 100);
+    unsigned numQueries = GetOption(arguments, "-q", 4);
+
+    PrintLine(ToString("  %u objects, %u%% moving, %u frames, %u frustum queries and raycasts per frame", numObjects, movingPercent,
+        numFrames, numQueries));
+
+    if (!context->GetSubsystem<WorkQueue>())
+        context->RegisterSubsystem(new WorkQueue(context));
+    RegisterSceneLibrary(context);
+    RegisterGraphicsLibrary(context);
+
+    const char* indexNames[] = {"octree", "AABB tree"};
+    for (unsigned i = SPATIAL_INDEX_OCTREE; i <= SPATIAL_INDEX_AABBTREE; ++i)
+    {
+        SpatialResults results = MeasureSpatialIndex(context, (SpatialIndexType)i, numObjects, movingPercent, numFrames, numQueries);
+        String name(indexNames[i]);
+        PrintResult(name + " update", results.updateTime_, "ms per frame");
+        PrintResult(name + " frustum query", results.frustumTime_, "ms per query");
+        PrintResult(name + " raycast", results.raycastTime_, "ms per ray");
+        PrintResult(name + " frustum query results", results.frustumResults_, "drawables");
+    }
+}
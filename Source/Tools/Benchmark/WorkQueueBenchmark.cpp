@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Core/WorkQueue.h>
+
+#include "Benchmark.h"
+
+#include <Urho3D/DebugNew.h>
+
+/// Number of loop iterations in a tiny work item.
+static const unsigned TINY_ITEM_ITERATIONS = 16;
+/// Number of loop iterations in a large work item.
+static const unsigned LARGE_ITEM_ITERATIONS = 20000;
+
+static void BenchmarkWork(const WorkItem* item, unsigned threadIndex)
+{
+    unsigned iterations = *reinterpret_cast<unsigned*>(item->aux_);
+    float value = 0.0f;
+    for (unsigned i = 0; i < iterations; ++i)
+        value += Sqrt((float)(i + threadIndex));
+    *reinterpret_cast<float*>(item->start_) = value;
+}
+
+static double MeasureThroughput(Context* context, WorkQueueMode mode, unsigned numThreads, unsigned numItems, unsigned numRounds,
+    unsigned iterations)
+{
+    SharedPtr<WorkQueue> queue(new WorkQueue(context));
+    queue->CreateThreads(numThreads, mode);
+
+    PODVector<float> results(numItems);
+    HiresTimer timer;
+
+    for (unsigned round = 0; round < numRounds; ++round)
+    {
+        for (unsigned i = 0; i < numItems; ++i)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = BenchmarkWork;
+            item->start_ = &results[i];
+            item->aux_ = &iterations;
+            queue->AddWorkItem(item);
+        }
+        queue->Complete(M_MAX_UNSIGNED);
+    }
+
+    long long usec = timer.GetUSec(false);
+    return usec ? (double)numItems * numRounds * 1000000.0 / usec : 0.0;
+}
+
+void RunWorkQueueBenchmark(Context* context, const Vector<String>& arguments)
+{
+    unsigned numThreads = GetOption(arguments, "-t", Max(GetNumPhysicalCPUs(), 2U) - 1);
+    unsigned numItems = GetOption(arguments, "-n", 1000);
+    unsigned numRounds = GetOption(arguments, "-r", 100);
+
+    PrintLine(ToString("  %u worker threads, %u items per round, %u rounds", numThreads, numItems, numRounds));
+
+    const char* modeNames[] = {"shared queue", "work stealing"};
+    const WorkQueueMode modes[] = {WQM_SHARED_QUEUE, WQM_WORK_STEALING};
+
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        PrintResult(String(modeNames[i]) + ", tiny items", MeasureThroughput(context, modes[i], numThreads, numItems, numRounds,
+            TINY_ITEM_ITERATIONS), "items/s");
+        PrintResult(String(modeNames[i]) + ", large items", MeasureThroughput(context, modes[i], numThreads, numItems,
+            Max(numRounds / 10, 1U), LARGE_ITEM_ITERATIONS), "items/s");
+    }
+}
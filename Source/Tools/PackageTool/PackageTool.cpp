@@ -22,7 +22,11 @@
 
 #include <Urho3D/Core/Context.h>
 #include <Urho3D/Container/ArrayPtr.h>
+#include <Urho3D/Core/Condition.h>
+#include <Urho3D/Core/Mutex.h>
 #include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/StringUtils.h>
+#include <Urho3D/Core/Thread.h>
 #include <Urho3D/IO/File.h>
 #include <Urho3D/IO/FileSystem.h>
 #include <Urho3D/IO/PackageFile.h>
@@ -39,6 +43,15 @@
 using namespace Urho3D;
 
 static const unsigned COMPRESSED_BLOCK_SIZE = 32768;
+static const unsigned MAX_BLOCK_SIZE = 16 * 1024 * 1024;
+// LZ4 can not refer further back than 64 KB, so a larger dictionary would not help
+static const unsigned DICTIONARY_SIZE = 65536;
+static const unsigned DICTIONARY_MAX_SAMPLE_SIZE = 16 * 1024 * 1024;
+static const unsigned DICTIONARY_SEGMENT_SIZE = 256;
+static const unsigned DICTIONARY_KMER_SIZE = 8;
+static const unsigned DICTIONARY_TABLE_BITS = 22;
+// Entries that may be read and compressed ahead of the writer, to bound the memory use
+static const unsigned MAX_PENDING_ENTRIES_PER_THREAD = 2;
 
 struct FileEntry
 {
@@ -46,6 +59,11 @@ struct FileEntry
     unsigned offset_{};
     unsigned size_{};
     unsigned checksum_{};
+    bool useDictionary_{};
+    /// Data to be written, compressed if compression is enabled.
+    PODVector<unsigned char> data_;
+    /// Whether data is ready to be written.
+    bool ready_{};
 };
 
 SharedPtr<Context> context_(new Context());
@@ -54,8 +72,20 @@ String basePath_;
 Vector<FileEntry> entries_;
 unsigned checksum_ = 0;
 bool compress_ = false;
+bool fastCompression_ = false;
+int compressionLevel_ = 0;
+bool trainDictionary_ = false;
 bool quiet_ = false;
 unsigned blockSize_ = COMPRESSED_BLOCK_SIZE;
+unsigned numThreads_ = GetNumLogicalCPUs();
+PODVector<unsigned char> dictionary_;
+// Entry preparation state shared with the worker threads, guarded by the mutex
+Mutex entryMutex_;
+Condition entryReadyCondition_;
+unsigned nextEntry_ = 0;
+unsigned numWrittenEntries_ = 0;
+unsigned maxPendingEntries_ = 0;
+String errorMessage_;
 
 String ignoreExtensions_[] = {
     ".bak",
@@ -66,8 +96,94 @@ String ignoreExtensions_[] = {
 int main(int argc, char** argv);
 void Run(const Vector<String>& arguments);
 void ProcessFile(const String& fileName, const String& rootDir);
+void TrainDictionary(const String& rootDir);
+bool PrepareEntry(FileEntry& entry, const String& rootDir, LZ4_stream_t* stream, LZ4_streamHC_t* streamHC, String& error);
+bool CompressEntry(FileEntry& entry, const PODVector<unsigned char>& buffer, LZ4_stream_t* stream, LZ4_streamHC_t* streamHC, String& error);
 void WritePackageFile(const String& fileName, const String& rootDir);
 void WriteHeader(File& dest);
+void WriteEntries(File& dest);
+
+/// LZ4 streams for compressing with the dictionary.
+struct CompressionStreams
+{
+    /// Construct. Create the streams only if they are needed.
+    CompressionStreams() :
+        stream_(compress_ && !dictionary_.Empty() ? LZ4_createStream() : nullptr),
+        streamHC_(compress_ && !dictionary_.Empty() ? LZ4_createStreamHC() : nullptr)
+    {
+    }
+
+    /// Destruct.
+    ~CompressionStreams()
+    {
+        if (stream_)
+            LZ4_freeStream(stream_);
+        if (streamHC_)
+            LZ4_freeStreamHC(streamHC_);
+    }
+
+    /// Fast compression stream.
+    LZ4_stream_t* stream_;
+    /// High compression stream.
+    LZ4_streamHC_t* streamHC_;
+};
+
+/// Worker thread for reading and compressing the files to be packaged.
+class PackageThread : public Thread, public RefCounted
+{
+public:
+    /// Construct.
+    explicit PackageThread(const String& rootDir) :
+        rootDir_(rootDir)
+    {
+    }
+
+    /// Prepare entries ahead of the writer until all are taken or an error occurs.
+    void ThreadFunction() override
+    {
+        CompressionStreams streams;
+
+        for (;;)
+        {
+            entryMutex_.Acquire();
+            if (!shouldRun_ || !errorMessage_.Empty() || nextEntry_ >= entries_.Size())
+            {
+                entryMutex_.Release();
+                break;
+            }
+            // Wait for the writer if too many entries are already held in memory
+            if (nextEntry_ >= numWrittenEntries_ + maxPendingEntries_)
+            {
+                entryMutex_.Release();
+                wakeCondition_.Wait();
+                continue;
+            }
+            unsigned index = nextEntry_++;
+            entryMutex_.Release();
+
+            String error;
+            bool success = PrepareEntry(entries_[index], rootDir_, streams.stream_, streams.streamHC_, error);
+
+            entryMutex_.Acquire();
+            if (success)
+                entries_[index].ready_ = true;
+            else if (errorMessage_.Empty())
+                errorMessage_ = error;
+            entryMutex_.Release();
+
+            entryReadyCondition_.Set();
+        }
+    }
+
+    /// Wake up the thread to check whether it can prepare more entries.
+    void Wake() { wakeCondition_.Set(); }
+
+private:
+    /// Directory being packaged.
+    String rootDir_;
+    /// Condition for waking up the thread when the writer has written an entry.
+    Condition wakeCondition_;
+};
 
 int main(int argc, char** argv)
 {
@@ -90,7 +206,11 @@ void Run(const Vector<String>& arguments)
             "Usage: PackageTool <directory to process> <package name> [basepath] [options]\n"
             "\n"
             "Options:\n"
-            "-c      Enable package file LZ4 compression\n"
+            "-c[level] Enable package file LZ4 compression, optionally with a LZ4HC compression level (1-12)\n"
+            "-f      Use the fast LZ4 codec instead of LZ4HC, implies -c\n"
+            "-d      Train a shared dictionary for compressing small files, implies -c\n"
+            "-b<kB>  Compression block size in kilobytes, default 32. Smaller blocks make seeking faster but compress worse\n"
+            "-j<num> Number of threads used for reading and compressing files, default is the number of logical CPUs\n"
             "-q      Enable quiet mode\n"
             "\n"
             "Basepath is an optional prefix that will be added to the file entries.\n\n"
@@ -114,10 +234,31 @@ void Run(const Vector<String>& arguments)
             {
                 if (arguments[i].Length() > 1)
                 {
+                    String value = arguments[i].Substring(2);
                     switch (arguments[i][1])
                     {
                     case 'c':
                         compress_ = true;
+                        if (!value.Empty())
+                            compressionLevel_ = ToInt(value);
+                        break;
+                    case 'f':
+                        compress_ = true;
+                        fastCompression_ = true;
+                        break;
+                    case 'd':
+                        compress_ = true;
+                        trainDictionary_ = true;
+                        break;
+                    case 'b':
+                        blockSize_ = ToUInt(value) * 1024;
+                        if (!blockSize_ || blockSize_ > MAX_BLOCK_SIZE)
+                            ErrorExit("Invalid block size");
+                        break;
+                    case 'j':
+                        numThreads_ = ToUInt(value);
+                        if (!numThreads_)
+                            ErrorExit("Invalid number of threads");
                         break;
                     case 'q':
                         quiet_ = true;
@@ -172,6 +313,11 @@ void Run(const Vector<String>& arguments)
             PrintLine("Package size: " + String(packageFile->GetTotalSize()));
             PrintLine("Checksum: " + String(packageFile->GetChecksum()));
             PrintLine("Compressed: " + String(packageFile->IsCompressed() ? "yes" : "no"));
+            if (packageFile->GetBlockSize())
+            {
+                PrintLine("Block size: " + String(packageFile->GetBlockSize()));
+                PrintLine("Dictionary size: " + String(packageFile->GetDictionary().Size()));
+            }
             break;
         case 'L':
             if (!packageFile->IsCompressed())
@@ -220,6 +366,219 @@ void ProcessFile(const String& fileName, const String& rootDir)
     entries_.Push(newEntry);
 }
 
+void TrainDictionary(const String& rootDir)
+{
+    // Use the files that fit in a single block as samples, as larger files benefit little from the dictionary
+    PODVector<unsigned char> samples;
+    for (unsigned i = 0; i < entries_.Size(); ++i)
+    {
+        unsigned size = entries_[i].size_;
+        if (size > blockSize_ || samples.Size() + size > DICTIONARY_MAX_SAMPLE_SIZE)
+            continue;
+
+        String fileFullPath = rootDir + "/" + entries_[i].name_;
+        File srcFile(context_, fileFullPath);
+        unsigned oldSize = samples.Size();
+        samples.Resize(oldSize + size);
+        if (srcFile.Read(&samples[oldSize], size) != size)
+            ErrorExit("Could not read file " + fileFullPath);
+    }
+
+    if (samples.Size() < DICTIONARY_SEGMENT_SIZE * 2)
+    {
+        if (!quiet_)
+            PrintLine("Not enough small files to train a dictionary");
+        return;
+    }
+
+    // Count the occurrences of each k-mer (short byte sequence) in a hash table, ignoring those that occur only once
+    unsigned numKmers = samples.Size() - DICTIONARY_KMER_SIZE + 1;
+    PODVector<unsigned> kmerHashes(numKmers);
+    PODVector<unsigned> counts(1u << DICTIONARY_TABLE_BITS);
+    memset(&counts[0], 0, counts.Size() * sizeof(unsigned));
+    for (unsigned i = 0; i < numKmers; ++i)
+    {
+        unsigned long long kmer;
+        memcpy(&kmer, &samples[i], sizeof kmer);
+        kmerHashes[i] = (unsigned)((kmer * 0x9e3779b97f4a7c15ULL) >> (64 - DICTIONARY_TABLE_BITS));
+        ++counts[kmerHashes[i]];
+    }
+    for (unsigned i = 0; i < counts.Size(); ++i)
+    {
+        if (counts[i] == 1)
+            counts[i] = 0;
+    }
+
+    // Split the samples into as many epochs as there are segments in the dictionary, and pick the segment covering
+    // the most frequent k-mers from each. The k-mers of picked segments are zeroed so that later segments add new content
+    const unsigned segmentKmers = DICTIONARY_SEGMENT_SIZE - DICTIONARY_KMER_SIZE + 1;
+    unsigned numSegments = Min(DICTIONARY_SIZE / DICTIONARY_SEGMENT_SIZE, numKmers / DICTIONARY_SEGMENT_SIZE);
+    unsigned epochSize = numKmers / numSegments;
+    PODVector<unsigned char> dictionary;
+
+    for (unsigned i = 0; i < numSegments; ++i)
+    {
+        unsigned begin = i * epochSize;
+        unsigned end = i + 1 < numSegments ? begin + epochSize : numKmers;
+        if (end - begin < segmentKmers)
+            continue;
+
+        unsigned long long score = 0;
+        for (unsigned j = begin; j < begin + segmentKmers; ++j)
+            score += counts[kmerHashes[j]];
+        unsigned long long bestScore = score;
+        unsigned bestBegin = begin;
+
+        for (unsigned j = begin + 1; j + segmentKmers <= end; ++j)
+        {
+            score += counts[kmerHashes[j + segmentKmers - 1]];
+            score -= counts[kmerHashes[j - 1]];
+            if (score > bestScore)
+            {
+                bestScore = score;
+                bestBegin = j;
+            }
+        }
+
+        if (!bestScore)
+            continue;
+
+        unsigned oldSize = dictionary.Size();
+        dictionary.Resize(oldSize + DICTIONARY_SEGMENT_SIZE);
+        memcpy(&dictionary[oldSize], &samples[bestBegin], DICTIONARY_SEGMENT_SIZE);
+        for (unsigned j = bestBegin; j < bestBegin + segmentKmers; ++j)
+            counts[kmerHashes[j]] = 0;
+    }
+
+    dictionary_ = dictionary;
+    if (!quiet_)
+        PrintLine("Trained dictionary of " + String(dictionary_.Size()) + " bytes from " + String(samples.Size()) + " bytes of samples");
+}
+
+bool PrepareEntry(FileEntry& entry, const String& rootDir, LZ4_stream_t* stream, LZ4_streamHC_t* streamHC, String& error)
+{
+    String fileFullPath = rootDir + "/" + entry.name_;
+
+    File srcFile(context_, fileFullPath);
+    if (!srcFile.IsOpen())
+    {
+        error = "Could not open file " + fileFullPath;
+        return false;
+    }
+
+    unsigned dataSize = entry.size_;
+    PODVector<unsigned char> buffer(dataSize);
+    if (srcFile.Read(buffer.Buffer(), dataSize) != dataSize)
+    {
+        error = "Could not read file " + fileFullPath;
+        return false;
+    }
+    srcFile.Close();
+
+    for (unsigned j = 0; j < dataSize; ++j)
+        entry.checksum_ = SDBMHash(entry.checksum_, buffer[j]);
+
+    if (compress_)
+        return CompressEntry(entry, buffer, stream, streamHC, error);
+
+    entry.data_.Swap(buffer);
+    return true;
+}
+
+bool CompressEntry(FileEntry& entry, const PODVector<unsigned char>& buffer, LZ4_stream_t* stream, LZ4_streamHC_t* streamHC, String& error)
+{
+    unsigned dataSize = buffer.Size();
+    unsigned numBlocks = (dataSize + blockSize_ - 1) / blockSize_;
+    int maxPackedSize = LZ4_compressBound(blockSize_);
+    SharedArrayPtr<unsigned char> compressBuffer(new unsigned char[maxPackedSize]);
+    auto* dictionary = (const char*)dictionary_.Begin().ptr_;
+    entry.useDictionary_ = !dictionary_.Empty() && dataSize <= blockSize_;
+
+    // Leave space for the block index, which holds the packed size of each block
+    entry.data_.Resize(numBlocks * sizeof(unsigned));
+
+    for (unsigned i = 0; i < numBlocks; ++i)
+    {
+        unsigned pos = i * blockSize_;
+        unsigned unpackedSize = Min(blockSize_, dataSize - pos);
+        auto* src = (const char*)&buffer[pos];
+        auto* dest = (char*)compressBuffer.Get();
+        int packedSize;
+
+        if (entry.useDictionary_)
+        {
+            if (fastCompression_)
+            {
+                LZ4_resetStream(stream);
+                LZ4_loadDict(stream, dictionary, dictionary_.Size());
+                packedSize = LZ4_compress_fast_continue(stream, src, dest, unpackedSize, maxPackedSize, 1);
+            }
+            else
+            {
+                LZ4_resetStreamHC(streamHC, compressionLevel_);
+                LZ4_loadDictHC(streamHC, dictionary, dictionary_.Size());
+                packedSize = LZ4_compress_HC_continue(streamHC, src, dest, unpackedSize, maxPackedSize);
+            }
+        }
+        else if (fastCompression_)
+            packedSize = LZ4_compress_default(src, dest, unpackedSize, maxPackedSize);
+        else
+            packedSize = LZ4_compress_HC(src, dest, unpackedSize, maxPackedSize, compressionLevel_);
+
+        if (!packedSize)
+        {
+            error = "LZ4 compression failed for file " + entry.name_ + " at offset " + String(pos);
+            return false;
+        }
+
+        // Store the block as is if compression did not help, so that it can be read without decompression
+        if ((unsigned)packedSize >= unpackedSize)
+        {
+            packedSize = unpackedSize;
+            src = (const char*)&buffer[pos];
+        }
+        else
+            src = dest;
+
+        unsigned oldSize = entry.data_.Size();
+        entry.data_.Resize(oldSize + packedSize);
+        memcpy(&entry.data_[oldSize], src, (size_t)packedSize);
+        memcpy(&entry.data_[i * sizeof(unsigned)], &packedSize, sizeof(unsigned));
+    }
+
+    return true;
+}
+
+void StopPackageThreads(Vector<SharedPtr<PackageThread> >& threads)
+{
+    {
+        MutexLock lock(entryMutex_);
+        // Make the threads stop taking new entries
+        nextEntry_ = entries_.Size();
+    }
+
+    for (unsigned i = 0; i < threads.Size(); ++i)
+    {
+        threads[i]->Wake();
+        threads[i]->Stop();
+    }
+    threads.Clear();
+}
+
+unsigned AppendChecksum(unsigned checksum, unsigned dataChecksum, unsigned dataSize)
+{
+    // SDBMHash(hash, c) is hash * 65599 + c, so the checksum of preceding data only needs to be scaled
+    unsigned multiplier = 1;
+    unsigned base = 65599;
+    for (; dataSize; dataSize >>= 1)
+    {
+        if (dataSize & 1u)
+            multiplier *= base;
+        base *= base;
+    }
+    return checksum * multiplier + dataChecksum;
+}
+
 void WritePackageFile(const String& fileName, const String& rootDir)
 {
     if (!quiet_)
@@ -229,85 +588,91 @@ void WritePackageFile(const String& fileName, const String& rootDir)
     if (!dest.Open(fileName, FILE_WRITE))
         ErrorExit("Could not open output file " + fileName);
 
+    if (trainDictionary_)
+        TrainDictionary(rootDir);
+
     // Write ID, number of files & placeholder for checksum
     WriteHeader(dest);
-
-    for (unsigned i = 0; i < entries_.Size(); ++i)
+    // Write entries (correct offsets are still unknown, will be filled in later)
+    WriteEntries(dest);
+
+    // Read, checksum & compress the files in worker threads a limited amount ahead, while writing them out in order
+    Vector<SharedPtr<PackageThread> > threads;
+    nextEntry_ = 0;
+    numWrittenEntries_ = 0;
+    maxPendingEntries_ = numThreads_ * MAX_PENDING_ENTRIES_PER_THREAD;
+    for (unsigned i = 0; i < numThreads_; ++i)
     {
-        // Write entry (correct offset is still unknown, will be filled in later)
-        dest.WriteString(basePath_ + entries_[i].name_);
-        dest.WriteUInt(entries_[i].offset_);
-        dest.WriteUInt(entries_[i].size_);
-        dest.WriteUInt(entries_[i].checksum_);
+        SharedPtr<PackageThread> thread(new PackageThread(rootDir));
+        if (!thread->Run())
+            break;
+        threads.Push(thread);
     }
+    // If threads are not available, prepare each entry just before writing it
+    CompressionStreams streams;
 
     unsigned totalDataSize = 0;
-    unsigned lastOffset;
 
     // Write file data, calculate checksums & correct offsets
     for (unsigned i = 0; i < entries_.Size(); ++i)
     {
-        lastOffset = entries_[i].offset_ = dest.GetSize();
-        String fileFullPath = rootDir + "/" + entries_[i].name_;
-
-        File srcFile(context_, fileFullPath);
-        if (!srcFile.IsOpen())
-            ErrorExit("Could not open file " + fileFullPath);
+        FileEntry& entry = entries_[i];
+        String error;
 
-        unsigned dataSize = entries_[i].size_;
-        totalDataSize += dataSize;
-        SharedArrayPtr<unsigned char> buffer(new unsigned char[dataSize]);
-
-        if (srcFile.Read(&buffer[0], dataSize) != dataSize)
-            ErrorExit("Could not read file " + fileFullPath);
-        srcFile.Close();
-
-        for (unsigned j = 0; j < dataSize; ++j)
+        if (threads.Empty())
+            PrepareEntry(entry, rootDir, streams.stream_, streams.streamHC_, error);
+        else
         {
-            checksum_ = SDBMHash(checksum_, buffer[j]);
-            entries_[i].checksum_ = SDBMHash(entries_[i].checksum_, buffer[j]);
+            entryMutex_.Acquire();
+            while (!entry.ready_ && errorMessage_.Empty())
+            {
+                entryMutex_.Release();
+                entryReadyCondition_.Wait();
+                entryMutex_.Acquire();
+            }
+            error = errorMessage_;
+            entryMutex_.Release();
         }
 
-        if (!compress_)
+        // Exit only after the worker threads have finished, so that none of them holds the mutex or a file
+        if (!error.Empty())
         {
-            if (!quiet_)
-                PrintLine(entries_[i].name_ + " size " + String(dataSize));
-            dest.Write(&buffer[0], entries_[i].size_);
+            StopPackageThreads(threads);
+            ErrorExit(error);
         }
-        else
-        {
-            SharedArrayPtr<unsigned char> compressBuffer(new unsigned char[LZ4_compressBound(blockSize_)]);
-
-            unsigned pos = 0;
-
-            while (pos < dataSize)
-            {
-                unsigned unpackedSize = blockSize_;
-                if (pos + unpackedSize > dataSize)
-                    unpackedSize = dataSize - pos;
 
-                auto packedSize = (unsigned)LZ4_compress_HC((const char*)&buffer[pos], (char*)compressBuffer.Get(), unpackedSize, LZ4_compressBound(unpackedSize), 0);
-                if (!packedSize)
-                    ErrorExit("LZ4 compression failed for file " + entries_[i].name_ + " at offset " + String(pos));
+        entry.offset_ = dest.GetSize();
+        dest.Write(entry.data_.Buffer(), entry.data_.Size());
+        checksum_ = AppendChecksum(checksum_, entry.checksum_, entry.size_);
+        totalDataSize += entry.size_;
 
-                dest.WriteUShort((unsigned short)unpackedSize);
-                dest.WriteUShort((unsigned short)packedSize);
-                dest.Write(compressBuffer.Get(), packedSize);
-
-                pos += unpackedSize;
-            }
-
-            if (!quiet_)
+        if (!quiet_)
+        {
+            if (!compress_)
+                PrintLine(entry.name_ + " size " + String(entry.size_));
+            else
             {
-                unsigned totalPackedBytes = dest.GetSize() - lastOffset;
-                String fileEntry(entries_[i].name_);
-                fileEntry.AppendWithFormat("\tin: %u\tout: %u\tratio: %f", dataSize, totalPackedBytes,
-                    totalPackedBytes ? 1.f * dataSize / totalPackedBytes : 0.f);
+                unsigned totalPackedBytes = entry.data_.Size();
+                String fileEntry(entry.name_);
+                fileEntry.AppendWithFormat("\tin: %u\tout: %u\tratio: %f", entry.size_, totalPackedBytes,
+                    totalPackedBytes ? 1.f * entry.size_ / totalPackedBytes : 0.f);
                 PrintLine(fileEntry);
             }
         }
+
+        entry.data_.Clear();
+        entry.data_.Compact();
+
+        {
+            MutexLock lock(entryMutex_);
+            ++numWrittenEntries_;
+        }
+        for (unsigned j = 0; j < threads.Size(); ++j)
+            threads[j]->Wake();
     }
 
+    StopPackageThreads(threads);
+
     // Write package size to the end of file to allow finding it linked to an executable file
     unsigned currentSize = dest.GetSize();
     dest.WriteUInt(currentSize + sizeof(unsigned));
@@ -315,14 +680,7 @@ void WritePackageFile(const String& fileName, const String& rootDir)
     // Write header again with correct offsets & checksums
     dest.Seek(0);
     WriteHeader(dest);
-
-    for (unsigned i = 0; i < entries_.Size(); ++i)
-    {
-        dest.WriteString(basePath_ + entries_[i].name_);
-        dest.WriteUInt(entries_[i].offset_);
-        dest.WriteUInt(entries_[i].size_);
-        dest.WriteUInt(entries_[i].checksum_);
-    }
+    WriteEntries(dest);
 
     if (!quiet_)
     {
@@ -339,7 +697,28 @@ void WriteHeader(File& dest)
     if (!compress_)
         dest.WriteFileID("UPAK");
     else
-        dest.WriteFileID("ULZ4");
+        dest.WriteFileID("UPK2");
     dest.WriteUInt(entries_.Size());
     dest.WriteUInt(checksum_);
+
+    if (compress_)
+    {
+        dest.WriteUInt(blockSize_);
+        dest.WriteUInt(dictionary_.Size());
+        if (!dictionary_.Empty())
+            dest.Write(&dictionary_[0], dictionary_.Size());
+    }
+}
+
+void WriteEntries(File& dest)
+{
+    for (unsigned i = 0; i < entries_.Size(); ++i)
+    {
+        dest.WriteString(basePath_ + entries_[i].name_);
+        dest.WriteUInt(entries_[i].offset_);
+        dest.WriteUInt(entries_[i].size_);
+        dest.WriteUInt(entries_[i].checksum_);
+        if (compress_)
+            dest.WriteBool(entries_[i].useDictionary_);
+    }
 }
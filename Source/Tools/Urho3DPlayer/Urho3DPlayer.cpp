@@ -101,6 +101,7 @@ void Urho3DPlayer::Setup()
             "-pf <files>  Resource package file to use, separated by semicolons, default to none\n"
             "-ap <paths>  Resource autoload path(s), separated by semicolons, default to 'AutoLoad'\n"
             "-log <level> Change the log level, valid 'level' values: 'debug', 'info', 'warning', 'error'\n"
+            "-logasync    Write the log output in a background thread\n"
             "-ds <file>   Dump used shader variations to a file for precaching\n"
             "-mq <level>  Material quality level, default 2 (high)\n"
             "-tq <level>  Texture quality level, default 2 (high)\n"
@@ -122,6 +123,8 @@ void Urho3DPlayer::Setup()
             "-noshadows   Disable shadow rendering\n"
             "-nolimit     Disable frame limiter\n"
             "-nothreads   Disable worker threads\n"
+            "-workstealing Use work stealing deques for worker threads\n"
+            "-mmap        Map resource packages to memory\n"
             "-nosound     Disable sound output\n"
             "-noip        Disable sound mixing interpolation\n"
             "-touch       Touch emulation on desktop platform\n"
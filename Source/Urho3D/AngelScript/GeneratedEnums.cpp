@@ -1889,6 +1889,11 @@ void ASRegisterGeneratedEnums(asIScriptEngine* engine)
     engine->RegisterEnumValue("WindowDragMode", "DRAG_RESIZE_BOTTOMLEFT", DRAG_RESIZE_BOTTOMLEFT);
     engine->RegisterEnumValue("WindowDragMode", "DRAG_RESIZE_LEFT", DRAG_RESIZE_LEFT);
 
+    // enum WorkQueueMode | File: ../Core/WorkQueue.h
+    engine->RegisterEnum("WorkQueueMode");
+    engine->RegisterEnumValue("WorkQueueMode", "WQM_SHARED_QUEUE", WQM_SHARED_QUEUE);
+    engine->RegisterEnumValue("WorkQueueMode", "WQM_WORK_STEALING", WQM_WORK_STEALING);
+
     // enum WrapMode | File: ../Scene/AnimationDefs.h
     engine->RegisterEnum("WrapMode");
     engine->RegisterEnumValue("WrapMode", "WM_LOOP", WM_LOOP);
@@ -151,6 +151,7 @@
 #ifdef URHO3D_NETWORK
 #include "../Network/Connection.h"
 #include "../Network/HttpRequest.h"
+#include "../Network/InterestManager.h"
 #include "../Network/Network.h"
 #include "../Network/NetworkPriority.h"
 #include "../Network/Protocol.h"
@@ -260,6 +260,10 @@ void ASRegisterGenerated_Classes(asIScriptEngine* engine)
     engine->RegisterObjectType("IndexBuffer", 0, asOBJ_REF);
     // class Input | File: ../Input/Input.h
     engine->RegisterObjectType("Input", 0, asOBJ_REF);
+#ifdef URHO3D_NETWORK
+    // class InterestManager | File: ../Network/InterestManager.h
+    engine->RegisterObjectType("InterestManager", 0, asOBJ_REF);
+#endif
     // class IntRect | File: ../Math/Rect.h
     engine->RegisterObjectType("IntRect", sizeof(IntRect), asOBJ_VALUE | asGetTypeTraits<IntRect>() | asOBJ_POD | asOBJ_APP_CLASS_ALLINTS);
     // class IntVector2 | File: ../Math/Vector2.h
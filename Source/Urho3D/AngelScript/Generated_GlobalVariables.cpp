@@ -69,6 +69,8 @@ void ASRegisterGenerated_GlobalVariables(asIScriptEngine* engine)
     engine->RegisterGlobalProperty("const String EP_HEADLESS", (void*)&EP_HEADLESS);
     // static const String EP_HIGH_DPI | File: ../Engine/EngineDefs.h
     engine->RegisterGlobalProperty("const String EP_HIGH_DPI", (void*)&EP_HIGH_DPI);
+    // static const String EP_LOG_ASYNC | File: ../Engine/EngineDefs.h
+    engine->RegisterGlobalProperty("const String EP_LOG_ASYNC", (void*)&EP_LOG_ASYNC);
     // static const String EP_LOG_LEVEL | File: ../Engine/EngineDefs.h
     engine->RegisterGlobalProperty("const String EP_LOG_LEVEL", (void*)&EP_LOG_LEVEL);
     // static const String EP_LOG_NAME | File: ../Engine/EngineDefs.h
@@ -79,6 +81,8 @@ void ASRegisterGenerated_GlobalVariables(asIScriptEngine* engine)
     engine->RegisterGlobalProperty("const String EP_LOW_QUALITY_SHADOWS", (void*)&EP_LOW_QUALITY_SHADOWS);
     // static const String EP_MATERIAL_QUALITY | File: ../Engine/EngineDefs.h
     engine->RegisterGlobalProperty("const String EP_MATERIAL_QUALITY", (void*)&EP_MATERIAL_QUALITY);
+    // static const String EP_MEMORY_MAP_PACKAGES | File: ../Engine/EngineDefs.h
+    engine->RegisterGlobalProperty("const String EP_MEMORY_MAP_PACKAGES", (void*)&EP_MEMORY_MAP_PACKAGES);
     // static const String EP_MONITOR | File: ../Engine/EngineDefs.h
     engine->RegisterGlobalProperty("const String EP_MONITOR", (void*)&EP_MONITOR);
     // static const String EP_MULTI_SAMPLE | File: ../Engine/EngineDefs.h
@@ -141,6 +145,8 @@ void ASRegisterGenerated_GlobalVariables(asIScriptEngine* engine)
     engine->RegisterGlobalProperty("const String EP_WINDOW_WIDTH", (void*)&EP_WINDOW_WIDTH);
     // static const String EP_WORKER_THREADS | File: ../Engine/EngineDefs.h
     engine->RegisterGlobalProperty("const String EP_WORKER_THREADS", (void*)&EP_WORKER_THREADS);
+    // static const String EP_WORK_STEALING | File: ../Engine/EngineDefs.h
+    engine->RegisterGlobalProperty("const String EP_WORK_STEALING", (void*)&EP_WORK_STEALING);
     // static const float DEFAULT_NEARCLIP | File: ../Graphics/Camera.h
     engine->RegisterGlobalProperty("const float DEFAULT_NEARCLIP", (void*)&DEFAULT_NEARCLIP);
     // static const float DEFAULT_FARCLIP | File: ../Graphics/Camera.h
@@ -3451,6 +3451,15 @@ void ASRegisterGenerated_Members_Cn_Cz(asIScriptEngine* engine)
     // unsigned Connection::GetNumDownloads() const | File: ../Network/Connection.h
     engine->RegisterObjectMethod("Connection", "uint GetNumDownloads() const", asMETHODPR(Connection, GetNumDownloads, () const, unsigned), asCALL_THISCALL);
     engine->RegisterObjectMethod("Connection", "uint get_numDownloads() const", asMETHODPR(Connection, GetNumDownloads, () const, unsigned), asCALL_THISCALL);
+    // unsigned Connection::GetNumNodesConsidered() const | File: ../Network/Connection.h
+    engine->RegisterObjectMethod("Connection", "uint GetNumNodesConsidered() const", asMETHODPR(Connection, GetNumNodesConsidered, () const, unsigned), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Connection", "uint get_numNodesConsidered() const", asMETHODPR(Connection, GetNumNodesConsidered, () const, unsigned), asCALL_THISCALL);
+    // unsigned Connection::GetNumNodesSent() const | File: ../Network/Connection.h
+    engine->RegisterObjectMethod("Connection", "uint GetNumNodesSent() const", asMETHODPR(Connection, GetNumNodesSent, () const, unsigned), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Connection", "uint get_numNodesSent() const", asMETHODPR(Connection, GetNumNodesSent, () const, unsigned), asCALL_THISCALL);
+    // unsigned Connection::GetNumRelevantNodes() const | File: ../Network/Connection.h
+    engine->RegisterObjectMethod("Connection", "uint GetNumRelevantNodes() const", asMETHODPR(Connection, GetNumRelevantNodes, () const, unsigned), asCALL_THISCALL);
+    engine->RegisterObjectMethod("Connection", "uint get_numRelevantNodes() const", asMETHODPR(Connection, GetNumRelevantNodes, () const, unsigned), asCALL_THISCALL);
     // int Connection::GetPacketsInPerSec() const | File: ../Network/Connection.h
     engine->RegisterObjectMethod("Connection", "int GetPacketsInPerSec() const", asMETHODPR(Connection, GetPacketsInPerSec, () const, int), asCALL_THISCALL);
     engine->RegisterObjectMethod("Connection", "int get_packetsInPerSec() const", asMETHODPR(Connection, GetPacketsInPerSec, () const, int), asCALL_THISCALL);
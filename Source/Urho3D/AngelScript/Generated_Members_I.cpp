@@ -130,6 +130,23 @@ static void Input_UnsubscribeFromAllEventsExcept_PODVectorStringHash_bool(Input*
     ptr->UnsubscribeFromAllEventsExcept(param0, onlyUserData);
 }
 
+#ifdef URHO3D_NETWORK
+// explicit InterestManager::InterestManager(Context* context) | File: ../Network/InterestManager.h
+static InterestManager* InterestManager_InterestManager_Context()
+{
+    return new InterestManager(GetScriptContext());
+}
+#endif
+
+#ifdef URHO3D_NETWORK
+// void Object::UnsubscribeFromAllEventsExcept(const PODVector<StringHash>& exceptions, bool onlyUserData) | File: ../Core/Object.h
+static void InterestManager_UnsubscribeFromAllEventsExcept_PODVectorStringHash_bool(InterestManager* ptr, CScriptArray* exceptions, bool onlyUserData)
+{
+    PODVector<StringHash> param0 = ArrayToPODVector<StringHash>(exceptions);
+    ptr->UnsubscribeFromAllEventsExcept(param0, onlyUserData);
+}
+#endif
+
 // IntRect::IntRect(const IntVector2& min, const IntVector2& max) noexcept | File: ../Math/Rect.h
 static void IntRect_IntRect_IntVector2_IntVector2(IntRect* ptr, const IntVector2 &min, const IntVector2 &max)
 {
@@ -1853,6 +1870,312 @@ void ASRegisterGenerated_Members_I(asIScriptEngine* engine)
     RegisterSubclass<Object, Input>(engine, "Object", "Input");
     RegisterSubclass<RefCounted, Input>(engine, "RefCounted", "Input");
 
+#ifdef URHO3D_NETWORK
+    // void RefCounted::AddRef() | File: ../Container/RefCounted.h
+    engine->RegisterObjectBehaviour("InterestManager", asBEHAVE_ADDREF, "void f()", asMETHODPR(InterestManager, AddRef, (), void), asCALL_THISCALL);
+    // void Component::AddReplicationState(ComponentReplicationState* state) | File: ../Scene/Component.h
+    // Error: type "ComponentReplicationState*" can not automatically bind
+    // void Serializable::AllocateNetworkState() | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "void AllocateNetworkState()", asMETHODPR(InterestManager, AllocateNetworkState, (), void), asCALL_THISCALL);
+    // virtual void Serializable::ApplyAttributes() | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "void ApplyAttributes()", asMETHODPR(InterestManager, ApplyAttributes, (), void), asCALL_THISCALL);
+    // template<typename T> T* Object::Cast() | File: ../Core/Object.h
+    // Not registered because template
+    // template<typename T> const T* Object::Cast() const | File: ../Core/Object.h
+    // Not registered because template
+    // void Component::CleanupConnection(Connection* connection) | File: ../Scene/Component.h
+    // Not registered because have @manualbind mark
+    // virtual void Component::DrawDebugGeometry(DebugRenderer* debug, bool depthTest) | File: ../Scene/Component.h
+    engine->RegisterObjectMethod("InterestManager", "void DrawDebugGeometry(DebugRenderer@+, bool)", asMETHODPR(InterestManager, DrawDebugGeometry, (DebugRenderer*, bool), void), asCALL_THISCALL);
+    // bool Animatable::GetAnimationEnabled() const | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "bool GetAnimationEnabled() const", asMETHODPR(InterestManager, GetAnimationEnabled, () const, bool), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "bool get_animationEnabled() const", asMETHODPR(InterestManager, GetAnimationEnabled, () const, bool), asCALL_THISCALL);
+    // Variant Serializable::GetAttribute(unsigned index) const | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "Variant GetAttribute(uint) const", asMETHODPR(InterestManager, GetAttribute, (unsigned) const, Variant), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "Variant get_attributes(uint) const", asMETHODPR(InterestManager, GetAttribute, (unsigned) const, Variant), asCALL_THISCALL);
+    // Variant Serializable::GetAttribute(const String& name) const | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "Variant GetAttribute(const String&in) const", asMETHODPR(InterestManager, GetAttribute, (const String&) const, Variant), asCALL_THISCALL);
+    // ValueAnimation* Animatable::GetAttributeAnimation(const String& name) const | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "ValueAnimation@+ GetAttributeAnimation(const String&in) const", asMETHODPR(InterestManager, GetAttributeAnimation, (const String&) const, ValueAnimation*), asCALL_THISCALL);
+    // float Animatable::GetAttributeAnimationSpeed(const String& name) const | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "float GetAttributeAnimationSpeed(const String&in) const", asMETHODPR(InterestManager, GetAttributeAnimationSpeed, (const String&) const, float), asCALL_THISCALL);
+    // float Animatable::GetAttributeAnimationTime(const String& name) const | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "float GetAttributeAnimationTime(const String&in) const", asMETHODPR(InterestManager, GetAttributeAnimationTime, (const String&) const, float), asCALL_THISCALL);
+    // WrapMode Animatable::GetAttributeAnimationWrapMode(const String& name) const | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "WrapMode GetAttributeAnimationWrapMode(const String&in) const", asMETHODPR(InterestManager, GetAttributeAnimationWrapMode, (const String&) const, WrapMode), asCALL_THISCALL);
+    // Variant Serializable::GetAttributeDefault(unsigned index) const | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "Variant GetAttributeDefault(uint) const", asMETHODPR(InterestManager, GetAttributeDefault, (unsigned) const, Variant), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "Variant get_attributeDefaults(uint) const", asMETHODPR(InterestManager, GetAttributeDefault, (unsigned) const, Variant), asCALL_THISCALL);
+    // Variant Serializable::GetAttributeDefault(const String& name) const | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "Variant GetAttributeDefault(const String&in) const", asMETHODPR(InterestManager, GetAttributeDefault, (const String&) const, Variant), asCALL_THISCALL);
+    // virtual const Vector<AttributeInfo>* Serializable::GetAttributes() const | File: ../Scene/Serializable.h
+    // Error: type "const Vector<AttributeInfo>*" can not automatically bind
+    // bool Object::GetBlockEvents() const | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "bool GetBlockEvents() const", asMETHODPR(InterestManager, GetBlockEvents, () const, bool), asCALL_THISCALL);
+    // const String& Object::GetCategory() const | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "const String& GetCategory() const", asMETHODPR(InterestManager, GetCategory, () const, const String&), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "const String& get_category() const", asMETHODPR(InterestManager, GetCategory, () const, const String&), asCALL_THISCALL);
+    // float InterestManager::GetCellSize() const | File: ../Network/InterestManager.h
+    engine->RegisterObjectMethod("InterestManager", "float GetCellSize() const", asMETHODPR(InterestManager, GetCellSize, () const, float), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "float get_cellSize() const", asMETHODPR(InterestManager, GetCellSize, () const, float), asCALL_THISCALL);
+    // Component* Component::GetComponent(StringHash type) const | File: ../Scene/Component.h
+    engine->RegisterObjectMethod("InterestManager", "Component@+ GetComponent(StringHash) const", asMETHODPR(InterestManager, GetComponent, (StringHash) const, Component*), asCALL_THISCALL);
+    // template<class T> T*  Component::GetComponent() const | File: ../Scene/Component.h
+    // Not registered because template
+    // void Component::GetComponents(PODVector<Component*>& dest, StringHash type) const | File: ../Scene/Component.h
+    // Error: type "PODVector<Component*>&" can not automatically bind
+    // template<class T> void Component::GetComponents(PODVector<T*>& dest) const | File: ../Scene/Component.h
+    // Not registered because template
+    // Context* Object::GetContext() const | File: ../Core/Object.h
+    // Error: type "Context*" can not be returned
+    // virtual void Component::GetDependencyNodes(PODVector<Node*>& dest) | File: ../Scene/Component.h
+    // Error: type "PODVector<Node*>&" can not automatically bind
+    // VariantMap& Object::GetEventDataMap() const | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "VariantMap& GetEventDataMap() const", asMETHODPR(InterestManager, GetEventDataMap, () const, VariantMap&), asCALL_THISCALL);
+    // EventHandler* Object::GetEventHandler() const | File: ../Core/Object.h
+    // Error: type "EventHandler*" can not automatically bind
+    // Object* Object::GetEventSender() const | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "Object@+ GetEventSender() const", asMETHODPR(InterestManager, GetEventSender, () const, Object*), asCALL_THISCALL);
+    // const Variant& Object::GetGlobalVar(StringHash key) const | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "const Variant& GetGlobalVar(StringHash) const", asMETHODPR(InterestManager, GetGlobalVar, (StringHash) const, const Variant&), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "const Variant& get_globalVar(StringHash) const", asMETHODPR(InterestManager, GetGlobalVar, (StringHash) const, const Variant&), asCALL_THISCALL);
+    // const VariantMap& Object::GetGlobalVars() const | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "const VariantMap& GetGlobalVars() const", asMETHODPR(InterestManager, GetGlobalVars, () const, const VariantMap&), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "const VariantMap& get_globalVars() const", asMETHODPR(InterestManager, GetGlobalVars, () const, const VariantMap&), asCALL_THISCALL);
+    // float InterestManager::GetHysteresis() const | File: ../Network/InterestManager.h
+    engine->RegisterObjectMethod("InterestManager", "float GetHysteresis() const", asMETHODPR(InterestManager, GetHysteresis, () const, float), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "float get_hysteresis() const", asMETHODPR(InterestManager, GetHysteresis, () const, float), asCALL_THISCALL);
+    // unsigned Component::GetID() const | File: ../Scene/Component.h
+    engine->RegisterObjectMethod("InterestManager", "uint GetID() const", asMETHODPR(InterestManager, GetID, () const, unsigned), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "uint get_id() const", asMETHODPR(InterestManager, GetID, () const, unsigned), asCALL_THISCALL);
+    // bool Serializable::GetInterceptNetworkUpdate(const String& attributeName) const | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "bool GetInterceptNetworkUpdate(const String&in) const", asMETHODPR(InterestManager, GetInterceptNetworkUpdate, (const String&) const, bool), asCALL_THISCALL);
+    // float InterestManager::GetInterestRadius() const | File: ../Network/InterestManager.h
+    engine->RegisterObjectMethod("InterestManager", "float GetInterestRadius() const", asMETHODPR(InterestManager, GetInterestRadius, () const, float), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "float get_interestRadius() const", asMETHODPR(InterestManager, GetInterestRadius, () const, float), asCALL_THISCALL);
+    // virtual const Vector<AttributeInfo>* Serializable::GetNetworkAttributes() const | File: ../Scene/Serializable.h
+    // Error: type "const Vector<AttributeInfo>*" can not automatically bind
+    // NetworkState* Serializable::GetNetworkState() const | File: ../Scene/Serializable.h
+    // Error: type "NetworkState*" can not automatically bind
+    // Node* Component::GetNode() const | File: ../Scene/Component.h
+    engine->RegisterObjectMethod("InterestManager", "Node@+ GetNode() const", asMETHODPR(InterestManager, GetNode, () const, Node*), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "Node@+ get_node() const", asMETHODPR(InterestManager, GetNode, () const, Node*), asCALL_THISCALL);
+    // void InterestManager::GetNodes(PODVector<Node*>& dest, const Vector3& position, float radius, Connection* owner) const | File: ../Network/InterestManager.h
+    // Error: type "PODVector<Node*>&" can not automatically bind
+    // unsigned Serializable::GetNumAttributes() const | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "uint GetNumAttributes() const", asMETHODPR(InterestManager, GetNumAttributes, () const, unsigned), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "uint get_numAttributes() const", asMETHODPR(InterestManager, GetNumAttributes, () const, unsigned), asCALL_THISCALL);
+    // unsigned InterestManager::GetNumCells() const | File: ../Network/InterestManager.h
+    engine->RegisterObjectMethod("InterestManager", "uint GetNumCells() const", asMETHODPR(InterestManager, GetNumCells, () const, unsigned), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "uint get_numCells() const", asMETHODPR(InterestManager, GetNumCells, () const, unsigned), asCALL_THISCALL);
+    // unsigned Serializable::GetNumNetworkAttributes() const | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "uint GetNumNetworkAttributes() const", asMETHODPR(InterestManager, GetNumNetworkAttributes, () const, unsigned), asCALL_THISCALL);
+    // unsigned InterestManager::GetNumNodes() const | File: ../Network/InterestManager.h
+    engine->RegisterObjectMethod("InterestManager", "uint GetNumNodes() const", asMETHODPR(InterestManager, GetNumNodes, () const, unsigned), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "uint get_numNodes() const", asMETHODPR(InterestManager, GetNumNodes, () const, unsigned), asCALL_THISCALL);
+    // ObjectAnimation* Animatable::GetObjectAnimation() const | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "ObjectAnimation@+ GetObjectAnimation() const", asMETHODPR(InterestManager, GetObjectAnimation, () const, ObjectAnimation*), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "ObjectAnimation@+ get_objectAnimation() const", asMETHODPR(InterestManager, GetObjectAnimation, () const, ObjectAnimation*), asCALL_THISCALL);
+    // ResourceRef Animatable::GetObjectAnimationAttr() const | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "ResourceRef GetObjectAnimationAttr() const", asMETHODPR(InterestManager, GetObjectAnimationAttr, () const, ResourceRef), asCALL_THISCALL);
+    // Scene* Component::GetScene() const | File: ../Scene/Component.h
+    engine->RegisterObjectMethod("InterestManager", "Scene@+ GetScene() const", asMETHODPR(InterestManager, GetScene, () const, Scene*), asCALL_THISCALL);
+    // Object* Object::GetSubsystem(StringHash type) const | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "Object@+ GetSubsystem(StringHash) const", asMETHODPR(InterestManager, GetSubsystem, (StringHash) const, Object*), asCALL_THISCALL);
+    // template<class T> T*  Object::GetSubsystem() const | File: ../Core/Object.h
+    // Not registered because template
+    // virtual StringHash Object::GetType() const =0 | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "StringHash GetType() const", asMETHODPR(InterestManager, GetType, () const, StringHash), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "StringHash get_type() const", asMETHODPR(InterestManager, GetType, () const, StringHash), asCALL_THISCALL);
+    // virtual const TypeInfo* Object::GetTypeInfo() const =0 | File: ../Core/Object.h
+    // Error: type "TypeInfo" can not automatically bind bacause have @nobind mark
+    // static const TypeInfo* Object::GetTypeInfoStatic() | File: ../Core/Object.h
+    // Error: type "TypeInfo" can not automatically bind bacause have @nobind mark
+    // virtual const String& Object::GetTypeName() const =0 | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "const String& GetTypeName() const", asMETHODPR(InterestManager, GetTypeName, () const, const String&), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "const String& get_typeName() const", asMETHODPR(InterestManager, GetTypeName, () const, const String&), asCALL_THISCALL);
+    // bool Object::HasEventHandlers() const | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "bool HasEventHandlers() const", asMETHODPR(InterestManager, HasEventHandlers, () const, bool), asCALL_THISCALL);
+    // bool Object::HasSubscribedToEvent(StringHash eventType) const | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "bool HasSubscribedToEvent(StringHash) const", asMETHODPR(InterestManager, HasSubscribedToEvent, (StringHash) const, bool), asCALL_THISCALL);
+    // bool Object::HasSubscribedToEvent(Object* sender, StringHash eventType) const | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "bool HasSubscribedToEvent(Object@+, StringHash) const", asMETHODPR(InterestManager, HasSubscribedToEvent, (Object*, StringHash) const, bool), asCALL_THISCALL);
+    // explicit InterestManager::InterestManager(Context* context) | File: ../Network/InterestManager.h
+    engine->RegisterObjectBehaviour("InterestManager", asBEHAVE_FACTORY, "InterestManager@+ f()", asFUNCTION(InterestManager_InterestManager_Context), asCALL_CDECL);
+    // bool Component::IsEnabled() const | File: ../Scene/Component.h
+    engine->RegisterObjectMethod("InterestManager", "bool IsEnabled() const", asMETHODPR(InterestManager, IsEnabled, () const, bool), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "bool get_enabled() const", asMETHODPR(InterestManager, IsEnabled, () const, bool), asCALL_THISCALL);
+    // bool Component::IsEnabledEffective() const | File: ../Scene/Component.h
+    engine->RegisterObjectMethod("InterestManager", "bool IsEnabledEffective() const", asMETHODPR(InterestManager, IsEnabledEffective, () const, bool), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "bool get_enabledEffective() const", asMETHODPR(InterestManager, IsEnabledEffective, () const, bool), asCALL_THISCALL);
+    // bool Object::IsInstanceOf(StringHash type) const | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "bool IsInstanceOf(StringHash) const", asMETHODPR(InterestManager, IsInstanceOf, (StringHash) const, bool), asCALL_THISCALL);
+    // bool Object::IsInstanceOf(const TypeInfo* typeInfo) const | File: ../Core/Object.h
+    // Error: type "TypeInfo" can not automatically bind bacause have @nobind mark
+    // template<typename T> bool Object::IsInstanceOf() const | File: ../Core/Object.h
+    // Not registered because template
+    // bool Component::IsReplicated() const | File: ../Scene/Component.h
+    engine->RegisterObjectMethod("InterestManager", "bool IsReplicated() const", asMETHODPR(InterestManager, IsReplicated, () const, bool), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "bool get_replicated() const", asMETHODPR(InterestManager, IsReplicated, () const, bool), asCALL_THISCALL);
+    // bool Serializable::IsTemporary() const | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "bool IsTemporary() const", asMETHODPR(InterestManager, IsTemporary, () const, bool), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "bool get_temporary() const", asMETHODPR(InterestManager, IsTemporary, () const, bool), asCALL_THISCALL);
+    // virtual bool Serializable::Load(Deserializer& source) | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "bool Load(Deserializer&)", asMETHODPR(InterestManager, Load, (Deserializer&), bool), asCALL_THISCALL);
+    // bool Animatable::LoadJSON(const JSONValue& source) override | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "bool LoadJSON(const JSONValue&in)", asMETHODPR(InterestManager, LoadJSON, (const JSONValue&), bool), asCALL_THISCALL);
+    // bool Animatable::LoadXML(const XMLElement& source) override | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "bool LoadXML(const XMLElement&in)", asMETHODPR(InterestManager, LoadXML, (const XMLElement&), bool), asCALL_THISCALL);
+    // void Component::MarkNetworkUpdate() override | File: ../Scene/Component.h
+    engine->RegisterObjectMethod("InterestManager", "void MarkNetworkUpdate()", asMETHODPR(InterestManager, MarkNetworkUpdate, (), void), asCALL_THISCALL);
+    // virtual void Object::OnEvent(Object* sender, StringHash eventType, VariantMap& eventData) | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "void OnEvent(Object@+, StringHash, VariantMap&)", asMETHODPR(InterestManager, OnEvent, (Object*, StringHash, VariantMap&), void), asCALL_THISCALL);
+    // virtual void Serializable::OnGetAttribute(const AttributeInfo& attr, Variant& dest) const | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "void OnGetAttribute(const AttributeInfo&in, Variant&) const", asMETHODPR(InterestManager, OnGetAttribute, (const AttributeInfo&, Variant&) const, void), asCALL_THISCALL);
+    // virtual void Serializable::OnSetAttribute(const AttributeInfo& attr, const Variant& src) | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "void OnSetAttribute(const AttributeInfo&in, const Variant&in)", asMETHODPR(InterestManager, OnSetAttribute, (const AttributeInfo&, const Variant&), void), asCALL_THISCALL);
+    // virtual void Component::OnSetEnabled() | File: ../Scene/Component.h
+    engine->RegisterObjectMethod("InterestManager", "void OnSetEnabled()", asMETHODPR(InterestManager, OnSetEnabled, (), void), asCALL_THISCALL);
+    // void Component::PrepareNetworkUpdate() | File: ../Scene/Component.h
+    engine->RegisterObjectMethod("InterestManager", "void PrepareNetworkUpdate()", asMETHODPR(InterestManager, PrepareNetworkUpdate, (), void), asCALL_THISCALL);
+    // bool Serializable::ReadDeltaUpdate(Deserializer& source) | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "bool ReadDeltaUpdate(Deserializer&)", asMETHODPR(InterestManager, ReadDeltaUpdate, (Deserializer&), bool), asCALL_THISCALL);
+    // bool Serializable::ReadLatestDataUpdate(Deserializer& source) | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "bool ReadLatestDataUpdate(Deserializer&)", asMETHODPR(InterestManager, ReadLatestDataUpdate, (Deserializer&), bool), asCALL_THISCALL);
+    // RefCount* RefCounted::RefCountPtr() | File: ../Container/RefCounted.h
+    // Error: type "RefCount*" can not automatically bind
+    // int RefCounted::Refs() const | File: ../Container/RefCounted.h
+    engine->RegisterObjectMethod("InterestManager", "int Refs() const", asMETHODPR(InterestManager, Refs, () const, int), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "int get_refs() const", asMETHODPR(InterestManager, Refs, () const, int), asCALL_THISCALL);
+    // static void InterestManager::RegisterObject(Context* context) | File: ../Network/InterestManager.h
+    // Context can be used as firs parameter of constructors only
+    // void RefCounted::ReleaseRef() | File: ../Container/RefCounted.h
+    engine->RegisterObjectBehaviour("InterestManager", asBEHAVE_RELEASE, "void f()", asMETHODPR(InterestManager, ReleaseRef, (), void), asCALL_THISCALL);
+    // void Component::Remove() | File: ../Scene/Component.h
+    engine->RegisterObjectMethod("InterestManager", "void Remove()", asMETHODPR(InterestManager, Remove, (), void), asCALL_THISCALL);
+    // void Animatable::RemoveAttributeAnimation(const String& name) | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "void RemoveAttributeAnimation(const String&in)", asMETHODPR(InterestManager, RemoveAttributeAnimation, (const String&), void), asCALL_THISCALL);
+    // void Serializable::RemoveInstanceDefault() | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "void RemoveInstanceDefault()", asMETHODPR(InterestManager, RemoveInstanceDefault, (), void), asCALL_THISCALL);
+    // void Animatable::RemoveObjectAnimation() | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "void RemoveObjectAnimation()", asMETHODPR(InterestManager, RemoveObjectAnimation, (), void), asCALL_THISCALL);
+    // void Serializable::ResetToDefault() | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "void ResetToDefault()", asMETHODPR(InterestManager, ResetToDefault, (), void), asCALL_THISCALL);
+    // bool Component::Save(Serializer& dest) const override | File: ../Scene/Component.h
+    engine->RegisterObjectMethod("InterestManager", "bool Save(Serializer&) const", asMETHODPR(InterestManager, Save, (Serializer&) const, bool), asCALL_THISCALL);
+    // virtual bool Serializable::SaveDefaultAttributes() const | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "bool SaveDefaultAttributes() const", asMETHODPR(InterestManager, SaveDefaultAttributes, () const, bool), asCALL_THISCALL);
+    // bool Component::SaveJSON(JSONValue& dest) const override | File: ../Scene/Component.h
+    engine->RegisterObjectMethod("InterestManager", "bool SaveJSON(JSONValue&) const", asMETHODPR(InterestManager, SaveJSON, (JSONValue&) const, bool), asCALL_THISCALL);
+    // bool Component::SaveXML(XMLElement& dest) const override | File: ../Scene/Component.h
+    engine->RegisterObjectMethod("InterestManager", "bool SaveXML(XMLElement&) const", asMETHODPR(InterestManager, SaveXML, (XMLElement&) const, bool), asCALL_THISCALL);
+    // void Object::SendEvent(StringHash eventType) | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "void SendEvent(StringHash)", asMETHODPR(InterestManager, SendEvent, (StringHash), void), asCALL_THISCALL);
+    // void Object::SendEvent(StringHash eventType, VariantMap& eventData) | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "void SendEvent(StringHash, VariantMap&)", asMETHODPR(InterestManager, SendEvent, (StringHash, VariantMap&), void), asCALL_THISCALL);
+    // template<typename... Args> void Object::SendEvent(StringHash eventType, Args... args) | File: ../Core/Object.h
+    // Not registered because template
+    // void Animatable::SetAnimationEnabled(bool enable) | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "void SetAnimationEnabled(bool)", asMETHODPR(InterestManager, SetAnimationEnabled, (bool), void), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "void set_animationEnabled(bool)", asMETHODPR(InterestManager, SetAnimationEnabled, (bool), void), asCALL_THISCALL);
+    // void Animatable::SetAnimationTime(float time) | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "void SetAnimationTime(float)", asMETHODPR(InterestManager, SetAnimationTime, (float), void), asCALL_THISCALL);
+    // bool Serializable::SetAttribute(unsigned index, const Variant& value) | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "bool SetAttribute(uint, const Variant&in)", asMETHODPR(InterestManager, SetAttribute, (unsigned, const Variant&), bool), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "bool set_attributes(uint, const Variant&in)", asMETHODPR(InterestManager, SetAttribute, (unsigned, const Variant&), bool), asCALL_THISCALL);
+    // bool Serializable::SetAttribute(const String& name, const Variant& value) | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "bool SetAttribute(const String&in, const Variant&in)", asMETHODPR(InterestManager, SetAttribute, (const String&, const Variant&), bool), asCALL_THISCALL);
+    // void Animatable::SetAttributeAnimation(const String& name, ValueAnimation* attributeAnimation, WrapMode wrapMode=WM_LOOP, float speed=1.0f) | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "void SetAttributeAnimation(const String&in, ValueAnimation@+, WrapMode = WM_LOOP, float = 1.0f)", asMETHODPR(InterestManager, SetAttributeAnimation, (const String&, ValueAnimation*, WrapMode, float), void), asCALL_THISCALL);
+    // void Animatable::SetAttributeAnimationSpeed(const String& name, float speed) | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "void SetAttributeAnimationSpeed(const String&in, float)", asMETHODPR(InterestManager, SetAttributeAnimationSpeed, (const String&, float), void), asCALL_THISCALL);
+    // void Animatable::SetAttributeAnimationTime(const String& name, float time) | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "void SetAttributeAnimationTime(const String&in, float)", asMETHODPR(InterestManager, SetAttributeAnimationTime, (const String&, float), void), asCALL_THISCALL);
+    // void Animatable::SetAttributeAnimationWrapMode(const String& name, WrapMode wrapMode) | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "void SetAttributeAnimationWrapMode(const String&in, WrapMode)", asMETHODPR(InterestManager, SetAttributeAnimationWrapMode, (const String&, WrapMode), void), asCALL_THISCALL);
+    // void Object::SetBlockEvents(bool block) | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "void SetBlockEvents(bool)", asMETHODPR(InterestManager, SetBlockEvents, (bool), void), asCALL_THISCALL);
+    // void InterestManager::SetCellSize(float size) | File: ../Network/InterestManager.h
+    engine->RegisterObjectMethod("InterestManager", "void SetCellSize(float)", asMETHODPR(InterestManager, SetCellSize, (float), void), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "void set_cellSize(float)", asMETHODPR(InterestManager, SetCellSize, (float), void), asCALL_THISCALL);
+    // void Component::SetEnabled(bool enable) | File: ../Scene/Component.h
+    engine->RegisterObjectMethod("InterestManager", "void SetEnabled(bool)", asMETHODPR(InterestManager, SetEnabled, (bool), void), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "void set_enabled(bool)", asMETHODPR(InterestManager, SetEnabled, (bool), void), asCALL_THISCALL);
+    // void Object::SetGlobalVar(StringHash key, const Variant& value) | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "void SetGlobalVar(StringHash, const Variant&in)", asMETHODPR(InterestManager, SetGlobalVar, (StringHash, const Variant&), void), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "void set_globalVar(StringHash, const Variant&in)", asMETHODPR(InterestManager, SetGlobalVar, (StringHash, const Variant&), void), asCALL_THISCALL);
+    // void InterestManager::SetHysteresis(float hysteresis) | File: ../Network/InterestManager.h
+    engine->RegisterObjectMethod("InterestManager", "void SetHysteresis(float)", asMETHODPR(InterestManager, SetHysteresis, (float), void), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "void set_hysteresis(float)", asMETHODPR(InterestManager, SetHysteresis, (float), void), asCALL_THISCALL);
+    // void Serializable::SetInstanceDefault(bool enable) | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "void SetInstanceDefault(bool)", asMETHODPR(InterestManager, SetInstanceDefault, (bool), void), asCALL_THISCALL);
+    // void Serializable::SetInterceptNetworkUpdate(const String& attributeName, bool enable) | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "void SetInterceptNetworkUpdate(const String&in, bool)", asMETHODPR(InterestManager, SetInterceptNetworkUpdate, (const String&, bool), void), asCALL_THISCALL);
+    // void InterestManager::SetInterestRadius(float radius) | File: ../Network/InterestManager.h
+    engine->RegisterObjectMethod("InterestManager", "void SetInterestRadius(float)", asMETHODPR(InterestManager, SetInterestRadius, (float), void), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "void set_interestRadius(float)", asMETHODPR(InterestManager, SetInterestRadius, (float), void), asCALL_THISCALL);
+    // void Animatable::SetObjectAnimation(ObjectAnimation* objectAnimation) | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "void SetObjectAnimation(ObjectAnimation@+)", asMETHODPR(InterestManager, SetObjectAnimation, (ObjectAnimation*), void), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "void set_objectAnimation(ObjectAnimation@+)", asMETHODPR(InterestManager, SetObjectAnimation, (ObjectAnimation*), void), asCALL_THISCALL);
+    // void Animatable::SetObjectAnimationAttr(const ResourceRef& value) | File: ../Scene/Animatable.h
+    engine->RegisterObjectMethod("InterestManager", "void SetObjectAnimationAttr(const ResourceRef&in)", asMETHODPR(InterestManager, SetObjectAnimationAttr, (const ResourceRef&), void), asCALL_THISCALL);
+    // void Serializable::SetTemporary(bool enable) | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "void SetTemporary(bool)", asMETHODPR(InterestManager, SetTemporary, (bool), void), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "void set_temporary(bool)", asMETHODPR(InterestManager, SetTemporary, (bool), void), asCALL_THISCALL);
+    // void Object::SubscribeToEvent(StringHash eventType, EventHandler* handler) | File: ../Core/Object.h
+    // Error: type "EventHandler*" can not automatically bind
+    // void Object::SubscribeToEvent(Object* sender, StringHash eventType, EventHandler* handler) | File: ../Core/Object.h
+    // Error: type "EventHandler*" can not automatically bind
+    // void Object::SubscribeToEvent(StringHash eventType, const std::function<void(StringHash, VariantMap&)>& function, void* userData=nullptr) | File: ../Core/Object.h
+    // Error: type "const std::function<void(StringHash, VariantMap&)>&" can not automatically bind
+    // void Object::SubscribeToEvent(Object* sender, StringHash eventType, const std::function<void(StringHash, VariantMap&)>& function, void* userData=nullptr) | File: ../Core/Object.h
+    // Error: type "const std::function<void(StringHash, VariantMap&)>&" can not automatically bind
+    // void Object::UnsubscribeFromAllEvents() | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "void UnsubscribeFromAllEvents()", asMETHODPR(InterestManager, UnsubscribeFromAllEvents, (), void), asCALL_THISCALL);
+    // void Object::UnsubscribeFromAllEventsExcept(const PODVector<StringHash>& exceptions, bool onlyUserData) | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "void UnsubscribeFromAllEventsExcept(Array<StringHash>@+, bool)", asFUNCTION(InterestManager_UnsubscribeFromAllEventsExcept_PODVectorStringHash_bool), asCALL_CDECL_OBJFIRST);
+    // void Object::UnsubscribeFromEvent(StringHash eventType) | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "void UnsubscribeFromEvent(StringHash)", asMETHODPR(InterestManager, UnsubscribeFromEvent, (StringHash), void), asCALL_THISCALL);
+    // void Object::UnsubscribeFromEvent(Object* sender, StringHash eventType) | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "void UnsubscribeFromEvent(Object@+, StringHash)", asMETHODPR(InterestManager, UnsubscribeFromEvent, (Object*, StringHash), void), asCALL_THISCALL);
+    // void Object::UnsubscribeFromEvents(Object* sender) | File: ../Core/Object.h
+    engine->RegisterObjectMethod("InterestManager", "void UnsubscribeFromEvents(Object@+)", asMETHODPR(InterestManager, UnsubscribeFromEvents, (Object*), void), asCALL_THISCALL);
+    // void InterestManager::Update() | File: ../Network/InterestManager.h
+    engine->RegisterObjectMethod("InterestManager", "void Update()", asMETHODPR(InterestManager, Update, (), void), asCALL_THISCALL);
+    // int RefCounted::WeakRefs() const | File: ../Container/RefCounted.h
+    engine->RegisterObjectMethod("InterestManager", "int WeakRefs() const", asMETHODPR(InterestManager, WeakRefs, () const, int), asCALL_THISCALL);
+    engine->RegisterObjectMethod("InterestManager", "int get_weakRefs() const", asMETHODPR(InterestManager, WeakRefs, () const, int), asCALL_THISCALL);
+    // void Serializable::WriteDeltaUpdate(Serializer& dest, const DirtyBits& attributeBits, unsigned char timeStamp) | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "void WriteDeltaUpdate(Serializer&, const DirtyBits&in, uint8)", asMETHODPR(InterestManager, WriteDeltaUpdate, (Serializer&, const DirtyBits&, unsigned char), void), asCALL_THISCALL);
+    // void Serializable::WriteInitialDeltaUpdate(Serializer& dest, unsigned char timeStamp) | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "void WriteInitialDeltaUpdate(Serializer&, uint8)", asMETHODPR(InterestManager, WriteInitialDeltaUpdate, (Serializer&, unsigned char), void), asCALL_THISCALL);
+    // void Serializable::WriteLatestDataUpdate(Serializer& dest, unsigned char timeStamp) | File: ../Scene/Serializable.h
+    engine->RegisterObjectMethod("InterestManager", "void WriteLatestDataUpdate(Serializer&, uint8)", asMETHODPR(InterestManager, WriteLatestDataUpdate, (Serializer&, unsigned char), void), asCALL_THISCALL);
+#ifdef REGISTER_MANUAL_PART_Component
+    REGISTER_MANUAL_PART_Component(InterestManager, "InterestManager")
+#endif
+#ifdef REGISTER_MANUAL_PART_Animatable
+    REGISTER_MANUAL_PART_Animatable(InterestManager, "InterestManager")
+#endif
+#ifdef REGISTER_MANUAL_PART_Serializable
+    REGISTER_MANUAL_PART_Serializable(InterestManager, "InterestManager")
+#endif
+#ifdef REGISTER_MANUAL_PART_Object
+    REGISTER_MANUAL_PART_Object(InterestManager, "InterestManager")
+#endif
+#ifdef REGISTER_MANUAL_PART_RefCounted
+    REGISTER_MANUAL_PART_RefCounted(InterestManager, "InterestManager")
+#endif
+#ifdef REGISTER_MANUAL_PART_InterestManager
+    REGISTER_MANUAL_PART_InterestManager(InterestManager, "InterestManager")
+#endif
+    RegisterSubclass<Component, InterestManager>(engine, "Component", "InterestManager");
+    RegisterSubclass<Animatable, InterestManager>(engine, "Animatable", "InterestManager");
+    RegisterSubclass<Serializable, InterestManager>(engine, "Serializable", "InterestManager");
+    RegisterSubclass<Object, InterestManager>(engine, "Object", "InterestManager");
+    RegisterSubclass<RefCounted, InterestManager>(engine, "RefCounted", "InterestManager");
+#endif
+
     // int IntRect::bottom_ | File: ../Math/Rect.h
     engine->RegisterObjectProperty("IntRect", "int bottom", offsetof(IntRect, bottom_));
     // int IntRect::left_ | File: ../Math/Rect.h
@@ -2089,9 +2089,9 @@ void ASRegisterGenerated_Members_R(asIScriptEngine* engine)
     engine->RegisterObjectMethod("ResourceCache", "bool AddResourceDir(const String&in, uint = PRIORITY_LAST)", asMETHODPR(ResourceCache, AddResourceDir, (const String&, unsigned), bool), asCALL_THISCALL);
     // void ResourceCache::AddResourceRouter(ResourceRouter* router, bool addAsFirst=false) | File: ../Resource/ResourceCache.h
     // Error: type "ResourceRouter" can not automatically bind bacause have @nobind mark
-    // bool ResourceCache::BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure=true, Resource* caller=nullptr) | File: ../Resource/ResourceCache.h
-    engine->RegisterObjectMethod("ResourceCache", "bool BackgroundLoadResource(StringHash, const String&in, bool = true, Resource@+ = null)", asMETHODPR(ResourceCache, BackgroundLoadResource, (StringHash, const String&, bool, Resource*), bool), asCALL_THISCALL);
-    // template<class T> bool ResourceCache::BackgroundLoadResource(const String& name, bool sendEventOnFailure=true, Resource* caller=nullptr) | File: ../Resource/ResourceCache.h
+    // bool ResourceCache::BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure=true, Resource* caller=nullptr, int priority=0) | File: ../Resource/ResourceCache.h
+    engine->RegisterObjectMethod("ResourceCache", "bool BackgroundLoadResource(StringHash, const String&in, bool = true, Resource@+ = null, int = 0)", asMETHODPR(ResourceCache, BackgroundLoadResource, (StringHash, const String&, bool, Resource*, int), bool), asCALL_THISCALL);
+    // template<class T> bool ResourceCache::BackgroundLoadResource(const String& name, bool sendEventOnFailure=true, Resource* caller=nullptr, int priority=0) | File: ../Resource/ResourceCache.h
     // Not registered because template
     // template<typename T> T* Object::Cast() | File: ../Core/Object.h
     // Not registered because template
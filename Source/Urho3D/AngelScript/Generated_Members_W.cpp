@@ -980,8 +980,8 @@ void ASRegisterGenerated_Members_W(asIScriptEngine* engine)
     // Not registered because template
     // void WorkQueue::Complete(unsigned priority) | File: ../Core/WorkQueue.h
     engine->RegisterObjectMethod("WorkQueue", "void Complete(uint)", asMETHODPR(WorkQueue, Complete, (unsigned), void), asCALL_THISCALL);
-    // void WorkQueue::CreateThreads(unsigned numThreads) | File: ../Core/WorkQueue.h
-    engine->RegisterObjectMethod("WorkQueue", "void CreateThreads(uint)", asMETHODPR(WorkQueue, CreateThreads, (unsigned), void), asCALL_THISCALL);
+    // void WorkQueue::CreateThreads(unsigned numThreads, WorkQueueMode mode = WQM_SHARED_QUEUE) | File: ../Core/WorkQueue.h
+    engine->RegisterObjectMethod("WorkQueue", "void CreateThreads(uint, WorkQueueMode = WQM_SHARED_QUEUE)", asMETHODPR(WorkQueue, CreateThreads, (unsigned, WorkQueueMode), void), asCALL_THISCALL);
     // bool Object::GetBlockEvents() const | File: ../Core/Object.h
     engine->RegisterObjectMethod("WorkQueue", "bool GetBlockEvents() const", asMETHODPR(WorkQueue, GetBlockEvents, () const, bool), asCALL_THISCALL);
     // const String& Object::GetCategory() const | File: ../Core/Object.h
@@ -149,6 +149,10 @@ Context::~Context()
     for (PODVector<VariantMap*>::Iterator i = eventDataMaps_.Begin(); i != eventDataMaps_.End(); ++i)
         delete *i;
     eventDataMaps_.Clear();
+
+    for (PODVector<PODVector<Object*>*>::Iterator i = processedReceivers_.Begin(); i != processedReceivers_.End(); ++i)
+        delete *i;
+    processedReceivers_.Clear();
 }
 
 SharedPtr<Object> Context::CreateObject(StringHash objectType)
@@ -465,6 +469,18 @@ void Context::BeginSendEvent(Object* sender, StringHash eventType)
     eventSenders_.Push(sender);
 }
 
+PODVector<Object*>& Context::GetProcessedReceivers()
+{
+    // Called after BeginSendEvent, so the sender stack size is at least one
+    unsigned nestingLevel = eventSenders_.Size() - 1;
+    while (processedReceivers_.Size() < nestingLevel + 1)
+        processedReceivers_.Push(new PODVector<Object*>());
+
+    PODVector<Object*>& ret = *processedReceivers_[nestingLevel];
+    ret.Clear();
+    return ret;
+}
+
 void Context::EndSendEvent()
 {
     eventSenders_.Pop();
@@ -218,6 +218,8 @@ private:
     void BeginSendEvent(Object* sender, StringHash eventType);
     /// End event send. Clean up event receivers removed in the meanwhile.
     void EndSendEvent();
+    /// Return the cleared processed receivers list for the current event nesting level. Storage is reused between sends.
+    PODVector<Object*>& GetProcessedReceivers();
 
     /// Set current event handler. Called by Object.
     void SetEventHandler(EventHandler* handler) { eventHandler_ = handler; }
@@ -238,6 +240,8 @@ private:
     PODVector<Object*> eventSenders_;
     /// Event data stack.
     PODVector<VariantMap*> eventDataMaps_;
+    /// Specific receivers already handled by each nesting level of SendEvent. Reused to avoid allocating during dispatch.
+    PODVector<PODVector<Object*>*> processedReceivers_;
     /// Active event handler. Not stored in a stack for performance reasons; is needed only in esoteric cases.
     EventHandler* eventHandler_;
     /// Object categories.
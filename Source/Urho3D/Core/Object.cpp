@@ -22,11 +22,14 @@
 
 #include "../Precompiled.h"
 
+#include "../Container/Sort.h"
 #include "../Core/Context.h"
 #include "../Core/ProcessUtils.h"
 #include "../Core/Thread.h"
 #include "../IO/Log.h"
 
+#include <algorithm>
+
 #include "../DebugNew.h"
 
 
@@ -308,13 +311,17 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
     if (blockEvents_)
         return;
 
-    // Make a weak pointer to self to check for destruction during event handling
+    // Make a weak pointer to self to check for destruction during event handling. The refcount structure always exists,
+    // so this does not allocate
     WeakPtr<Object> self(this);
     Context* context = context_;
-    HashSet<Object*> processed;
 
     context->BeginSendEvent(this, eventType);
 
+    // Receivers of the specific event are recorded to the scratch list of this nesting level, which keeps its capacity
+    // between sends, so steady state dispatch does not allocate
+    PODVector<Object*>& processed = context->GetProcessedReceivers();
+
     // Check first the specific event receivers
     // Note: group is held alive with a shared ptr, as it may get destroyed along with the sender
     SharedPtr<EventReceiverGroup> group(context->GetEventReceivers(this, eventType));
@@ -340,7 +347,7 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
                 return;
             }
 
-            processed.Insert(receiver);
+            processed.Push(receiver);
         }
 
         group->EndSendEvent();
@@ -373,12 +380,15 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
         }
         else
         {
-            // If there were specific receivers, check that the event is not sent doubly to them
+            // If there were specific receivers, check that the event is not sent doubly to them. Sort the processed
+            // receivers only now, as most events have either specific or non-specific receivers but not both
+            Sort(processed.Begin(), processed.End());
+
             const unsigned numReceivers = group->receivers_.Size();
             for (unsigned i = 0; i < numReceivers; ++i)
             {
                 Object* receiver = group->receivers_[i];
-                if (!receiver || processed.Contains(receiver))
+                if (!receiver || std::binary_search(processed.Begin().ptr_, processed.End().ptr_, receiver))
                     continue;
 
                 receiver->OnEvent(this, eventType, eventData);
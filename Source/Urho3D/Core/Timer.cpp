@@ -173,7 +173,14 @@ String Time::GetTimeStamp()
 {
     time_t sysTime;
     time(&sysTime);
+#ifdef _WIN32
+    // The Windows C runtime uses a per-thread buffer
     const char* dateTime = ctime(&sysTime);
+#else
+    // Use the reentrant version, as the log may format messages in its writer thread
+    char dateTime[32];
+    ctime_r(&sysTime, dateTime);
+#endif
     return String(dateTime).Replaced("\n", "");
 }
 
@@ -31,6 +31,157 @@
 namespace Urho3D
 {
 
+/// Number of priority bands in the work stealing mode. Band 0 holds M_MAX_UNSIGNED priority items, band 1 everything else.
+static const unsigned NUM_PRIORITY_BANDS = 2;
+/// Capacity of each work stealing deque. Must be a power of two.
+static const unsigned DEQUE_CAPACITY = 1024;
+
+/// Return the priority band of a work item priority.
+static inline unsigned GetPriorityBand(unsigned priority)
+{
+    return priority == M_MAX_UNSIGNED ? 0 : 1;
+}
+
+/// Bounded lock-free work stealing deque (Chase-Lev). The main thread is the owner which pushes and pops at the bottom, other threads steal from the top.
+class WorkStealingDeque : public RefCounted
+{
+public:
+    /// Construct.
+    WorkStealingDeque() :
+        items_(new std::atomic<WorkItem*>[DEQUE_CAPACITY]),
+        top_(0),
+        bottom_(0)
+    {
+    }
+
+    /// Destruct.
+    ~WorkStealingDeque() override
+    {
+        delete[] items_;
+    }
+
+    /// Push an item to the bottom. Owner only. Return false if the deque is full.
+    bool Push(WorkItem* item)
+    {
+        long long bottom = bottom_.load(std::memory_order_relaxed);
+        long long top = top_.load(std::memory_order_acquire);
+        if (bottom - top >= (long long)DEQUE_CAPACITY)
+            return false;
+
+        items_[bottom & (DEQUE_CAPACITY - 1)].store(item, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// Pop an item from the bottom. Owner only. Return null if empty.
+    WorkItem* Pop()
+    {
+        long long bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long long top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+        {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        WorkItem* item = items_[bottom & (DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (top == bottom)
+        {
+            // Last item, race against thieves
+            if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                item = nullptr;
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        return item;
+    }
+
+    /// Steal an item from the top. Can be called from any thread. Return null if empty or if lost a race to another thread.
+    WorkItem* Steal()
+    {
+        long long top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long long bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom)
+            return nullptr;
+
+        WorkItem* item = items_[top & (DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+
+        return item;
+    }
+
+    /// Return whether is empty. The result is only a snapshot when other threads are stealing.
+    bool IsEmpty() const
+    {
+        return top_.load(std::memory_order_acquire) >= bottom_.load(std::memory_order_acquire);
+    }
+
+private:
+    /// Item ring buffer.
+    std::atomic<WorkItem*>* items_;
+    /// Index of the next item to steal.
+    std::atomic<long long> top_;
+    /// Padding to keep top and bottom indices on separate cache lines.
+    char padding_[64];
+    /// Index of the next item to push.
+    std::atomic<long long> bottom_;
+};
+
+/// Parallel for execution state.
+struct ParallelForData
+{
+    /// Range begin.
+    unsigned begin_;
+    /// Range end.
+    unsigned end_;
+    /// Indices per chunk.
+    unsigned grainSize_;
+    /// Number of chunks.
+    unsigned numChunks_;
+    /// Function to execute.
+    const ParallelForFunction* function_;
+    /// Next chunk to process.
+    std::atomic<unsigned> nextChunk_;
+};
+
+/// Process parallel for chunks until none are left.
+static void ProcessParallelForChunks(ParallelForData& data, unsigned threadIndex)
+{
+    for (;;)
+    {
+        unsigned chunk = data.nextChunk_.fetch_add(1);
+        if (chunk >= data.numChunks_)
+            return;
+
+        unsigned begin = data.begin_ + chunk * data.grainSize_;
+        unsigned end = Min(begin + data.grainSize_, data.end_);
+        (*data.function_)(begin, end, threadIndex);
+    }
+}
+
+static void ParallelForWork(const WorkItem* item, unsigned threadIndex)
+{
+    ProcessParallelForChunks(*reinterpret_cast<ParallelForData*>(item->aux_), threadIndex);
+}
+
+static void TaskGraphWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* graph = reinterpret_cast<WorkTaskGraph*>(item->aux_);
+
+    // Keep taking tasks as they become ready, until the whole graph is finished
+    while (!graph->IsFinished())
+    {
+        if (!graph->ExecuteReadyTask(threadIndex))
+            Time::Sleep(0);
+    }
+}
+
 /// Worker thread managed by the work queue.
 class WorkerThread : public Thread, public RefCounted
 {
@@ -47,7 +198,10 @@ public:
     {
         // Init FPU state first
         InitFPU();
-        owner_->ProcessItems(index_);
+        if (owner_->GetMode() == WQM_WORK_STEALING)
+            owner_->ProcessItemsStealing(index_);
+        else
+            owner_->ProcessItems(index_);
     }
 
     /// Return thread index.
@@ -60,6 +214,137 @@ private:
     unsigned index_;
 };
 
+WorkTaskGraph::WorkTaskGraph() :
+    capacity_(0),
+    readyHead_(0),
+    readyTail_(0),
+    numCompleted_(0)
+{
+}
+
+unsigned WorkTaskGraph::AddTask(const WorkTaskFunction& function)
+{
+    tasks_.Resize(tasks_.Size() + 1);
+    Task& task = tasks_.Back();
+    task.function_ = function;
+    task.dependents_.Clear();
+    task.numDependencies_ = 0;
+    return tasks_.Size() - 1;
+}
+
+unsigned WorkTaskGraph::AddContinuation(unsigned task, const WorkTaskFunction& function)
+{
+    unsigned continuation = AddTask(function);
+    AddDependency(continuation, task);
+    return continuation;
+}
+
+void WorkTaskGraph::AddDependency(unsigned task, unsigned dependency)
+{
+    if (task >= tasks_.Size() || dependency >= tasks_.Size() || task == dependency)
+    {
+        URHO3D_LOGERROR("Invalid task graph dependency");
+        return;
+    }
+
+    tasks_[dependency].dependents_.Push(task);
+    ++tasks_[task].numDependencies_;
+}
+
+void WorkTaskGraph::Clear()
+{
+    tasks_.Clear();
+    numCompleted_ = 0;
+}
+
+bool WorkTaskGraph::Prepare()
+{
+    unsigned numTasks = tasks_.Size();
+    if (capacity_ < numTasks)
+    {
+        capacity_ = numTasks;
+        remainingDependencies_ = new std::atomic<unsigned>[capacity_];
+        readyTasks_ = new std::atomic<unsigned>[capacity_];
+    }
+
+    for (unsigned i = 0; i < numTasks; ++i)
+    {
+        remainingDependencies_[i] = tasks_[i].numDependencies_;
+        readyTasks_[i] = M_MAX_UNSIGNED;
+    }
+
+    readyHead_ = 0;
+    readyTail_ = 0;
+    numCompleted_ = 0;
+
+    for (unsigned i = 0; i < numTasks; ++i)
+    {
+        if (!tasks_[i].numDependencies_)
+            PushReadyTask(i);
+    }
+
+    // Verify the graph is acyclic by walking the ready tasks in order (Kahn's algorithm), using a scratch copy of the counts
+    PODVector<unsigned> remaining(numTasks);
+    PODVector<unsigned> order;
+    order.Reserve(numTasks);
+    for (unsigned i = 0; i < numTasks; ++i)
+    {
+        remaining[i] = tasks_[i].numDependencies_;
+        if (!remaining[i])
+            order.Push(i);
+    }
+    for (unsigned i = 0; i < order.Size(); ++i)
+    {
+        const PODVector<unsigned>& dependents = tasks_[order[i]].dependents_;
+        for (unsigned j = 0; j < dependents.Size(); ++j)
+        {
+            if (!--remaining[dependents[j]])
+                order.Push(dependents[j]);
+        }
+    }
+
+    return order.Size() == numTasks;
+}
+
+bool WorkTaskGraph::ExecuteReadyTask(unsigned threadIndex)
+{
+    unsigned head = readyHead_.load(std::memory_order_acquire);
+    unsigned index;
+
+    for (;;)
+    {
+        if (head >= tasks_.Size())
+            return false;
+        index = readyTasks_[head].load(std::memory_order_acquire);
+        if (index == M_MAX_UNSIGNED)
+            return false;
+        // On failure head is reloaded, try again
+        if (readyHead_.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            break;
+    }
+
+    Task& task = tasks_[index];
+    if (task.function_)
+        task.function_(threadIndex);
+
+    // Release the continuations whose last dependency this was
+    for (unsigned i = 0; i < task.dependents_.Size(); ++i)
+    {
+        unsigned dependent = task.dependents_[i];
+        if (remainingDependencies_[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+            PushReadyTask(dependent);
+    }
+
+    numCompleted_.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+void WorkTaskGraph::PushReadyTask(unsigned index)
+{
+    unsigned slot = readyTail_.fetch_add(1, std::memory_order_acq_rel);
+    readyTasks_[slot].store(index, std::memory_order_release);
+}
+
 WorkQueue::WorkQueue(Context* context) :
     Object(context),
     shutDown_(false),
@@ -68,7 +353,9 @@ WorkQueue::WorkQueue(Context* context) :
     completing_(false),
     tolerance_(10),
     lastSize_(0),
-    maxNonThreadedWorkMs_(5)
+    maxNonThreadedWorkMs_(5),
+    nextDeque_(0),
+    mode_(WQM_SHARED_QUEUE)
 {
     SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(WorkQueue, HandleBeginFrame));
 }
@@ -83,7 +370,7 @@ WorkQueue::~WorkQueue()
         threads_[i]->Stop();
 }
 
-void WorkQueue::CreateThreads(unsigned numThreads)
+void WorkQueue::CreateThreads(unsigned numThreads, WorkQueueMode mode)
 {
 #ifdef URHO3D_THREADING
     // Other subsystems may initialize themselves according to the number of threads.
@@ -91,6 +378,15 @@ void WorkQueue::CreateThreads(unsigned numThreads)
     if (!threads_.Empty())
         return;
 
+    // Work stealing is meaningless without worker threads
+    mode_ = numThreads ? mode : WQM_SHARED_QUEUE;
+    if (mode_ == WQM_WORK_STEALING)
+    {
+        // One deque per priority band for the main thread and each worker thread
+        for (unsigned i = 0; i < NUM_PRIORITY_BANDS * (numThreads + 1); ++i)
+            deques_.Push(SharedPtr<WorkStealingDeque>(new WorkStealingDeque()));
+    }
+
     // Start threads in paused mode
     Pause();
 
@@ -109,8 +405,8 @@ SharedPtr<WorkItem> WorkQueue::GetFreeItem()
 {
     if (poolItems_.Size() > 0)
     {
-        SharedPtr<WorkItem> item = poolItems_.Front();
-        poolItems_.PopFront();
+        SharedPtr<WorkItem> item = poolItems_.Back();
+        poolItems_.Pop();
         return item;
     }
     else
@@ -138,6 +434,15 @@ void WorkQueue::AddWorkItem(const SharedPtr<WorkItem>& item)
     workItems_.Push(item);
     item->completed_ = false;
 
+    if (mode_ == WQM_WORK_STEALING)
+    {
+        item->claimed_ = false;
+        item->removed_ = false;
+        PushStealing(item);
+        Resume();
+        return;
+    }
+
     // Make sure worker threads' list is safe to modify
     if (threads_.Size() && !paused_)
         queueMutex_.Acquire();
@@ -175,6 +480,22 @@ bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
     if (!item)
         return false;
 
+    if (mode_ == WQM_WORK_STEALING)
+    {
+        // Items can not be erased from the middle of the deques. Instead claim the item so that the thread which
+        // eventually takes it skips execution. It stays in the work item list until then to keep the pointer valid
+        if (item->removed_ || !workItems_.Contains(item))
+            return false;
+
+        bool expected = false;
+        if (item->claimed_.compare_exchange_strong(expected, true))
+        {
+            item->removed_ = true;
+            return true;
+        }
+        return false;
+    }
+
     MutexLock lock(queueMutex_);
 
     // Can only remove successfully if the item was not yet taken by threads for execution
@@ -196,9 +517,20 @@ bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
 
 unsigned WorkQueue::RemoveWorkItems(const Vector<SharedPtr<WorkItem> >& items)
 {
-    MutexLock lock(queueMutex_);
     unsigned removed = 0;
 
+    if (mode_ == WQM_WORK_STEALING)
+    {
+        for (Vector<SharedPtr<WorkItem> >::ConstIterator i = items.Begin(); i != items.End(); ++i)
+        {
+            if (RemoveWorkItem(*i))
+                ++removed;
+        }
+        return removed;
+    }
+
+    MutexLock lock(queueMutex_);
+
     for (Vector<SharedPtr<WorkItem> >::ConstIterator i = items.Begin(); i != items.End(); ++i)
     {
         List<WorkItem*>::Iterator j = queue_.Find(i->Get());
@@ -245,7 +577,9 @@ void WorkQueue::Complete(unsigned priority)
 {
     completing_ = true;
 
-    if (threads_.Size())
+    if (mode_ == WQM_WORK_STEALING)
+        CompleteStealing(priority);
+    else if (threads_.Size())
     {
         Resume();
 
@@ -293,6 +627,96 @@ void WorkQueue::Complete(unsigned priority)
     completing_ = false;
 }
 
+void WorkQueue::ParallelFor(unsigned begin, unsigned end, unsigned grainSize, const ParallelForFunction& function)
+{
+    if (begin >= end)
+        return;
+
+    unsigned count = end - begin;
+    unsigned numThreads = threads_.Size() + 1;
+    if (!grainSize)
+        grainSize = (count + numThreads - 1) / numThreads;
+
+    ParallelForData data;
+    data.begin_ = begin;
+    data.end_ = end;
+    data.grainSize_ = grainSize;
+    data.numChunks_ = (count + grainSize - 1) / grainSize;
+    data.function_ = &function;
+    data.nextChunk_ = 0;
+
+    // No need for helpers if there is just one chunk. Helper items are tracked from this index, as the function may itself
+    // call ParallelFor() in the main thread
+    unsigned firstHelper = helperItems_.Size();
+    if (threads_.Size() && data.numChunks_ > 1)
+        AddHelperItems(Min(threads_.Size(), data.numChunks_ - 1), ParallelForWork, &data);
+
+    ProcessParallelForChunks(data, 0);
+    FinishHelperItems(firstHelper);
+}
+
+void WorkQueue::Run(WorkTaskGraph* graph)
+{
+    if (!graph || !graph->GetNumTasks())
+        return;
+
+    if (!graph->Prepare())
+    {
+        URHO3D_LOGERROR("Can not run task graph with cyclic dependencies");
+        return;
+    }
+
+    unsigned firstHelper = helperItems_.Size();
+    if (threads_.Size() && graph->GetNumTasks() > 1)
+        AddHelperItems(Min(threads_.Size(), graph->GetNumTasks() - 1), TaskGraphWork, graph);
+
+    // Execute tasks also in the main thread. When a task is not ready yet, a worker thread is still executing its dependency
+    while (!graph->IsFinished())
+    {
+        if (!graph->ExecuteReadyTask(0))
+            Time::Sleep(0);
+    }
+
+    FinishHelperItems(firstHelper);
+}
+
+void WorkQueue::AddHelperItems(unsigned count, void (* workFunction)(const WorkItem*, unsigned), void* aux)
+{
+    for (unsigned i = 0; i < count; ++i)
+    {
+        SharedPtr<WorkItem> item = GetFreeItem();
+        item->priority_ = M_MAX_UNSIGNED;
+        item->workFunction_ = workFunction;
+        item->aux_ = aux;
+        AddWorkItem(item);
+        helperItems_.Push(item);
+    }
+}
+
+void WorkQueue::FinishHelperItems(unsigned first)
+{
+    if (helperItems_.Size() <= first)
+        return;
+
+    // The main thread has finished all work, so helpers that have not started yet are no longer needed. The rest
+    // return quickly, but must be waited for as they access data owned by the caller
+    for (unsigned i = first; i < helperItems_.Size(); ++i)
+    {
+        WorkItem* item = helperItems_[i];
+        if (!RemoveWorkItem(helperItems_[i]))
+        {
+            while (!item->completed_)
+            {
+            }
+        }
+    }
+    helperItems_.Resize(first);
+
+    // If no work at all remaining, pause worker threads by leaving the mutex locked
+    if (!HasQueuedItems())
+        Pause();
+}
+
 bool WorkQueue::IsCompleted(unsigned priority) const
 {
     for (List<SharedPtr<WorkItem> >::ConstIterator i = workItems_.Begin(); i != workItems_.End(); ++i)
@@ -339,6 +763,167 @@ void WorkQueue::ProcessItems(unsigned threadIndex)
     }
 }
 
+void WorkQueue::ProcessItemsStealing(unsigned threadIndex)
+{
+    bool wasActive = false;
+
+    for (;;)
+    {
+        if (shutDown_)
+            return;
+
+        if (pausing_ && !wasActive)
+        {
+            Time::Sleep(0);
+            continue;
+        }
+
+        WorkItem* item = StealItem(threadIndex);
+        if (!item)
+        {
+            // Deques are empty, check the overflow queue. This also blocks while the work queue is paused
+            queueMutex_.Acquire();
+            if (!queue_.Empty())
+            {
+                item = queue_.Front();
+                queue_.PopFront();
+            }
+            queueMutex_.Release();
+        }
+
+        if (item)
+        {
+            wasActive = true;
+            ExecuteStolenItem(item, threadIndex);
+        }
+        else
+        {
+            wasActive = false;
+            Time::Sleep(0);
+        }
+    }
+}
+
+void WorkQueue::CompleteStealing(unsigned priority)
+{
+    Resume();
+
+    // Take work items also in the main thread until no high-priority items anymore
+    while (WorkItem* item = TakeItemMainThread(priority))
+        ExecuteStolenItem(item, 0);
+
+    // Wait for threaded work to complete
+    while (!IsCompleted(priority))
+    {
+    }
+
+    // If no work at all remaining, pause worker threads by leaving the mutex locked
+    if (!HasQueuedItems())
+        Pause();
+}
+
+void WorkQueue::PushStealing(WorkItem* item)
+{
+    // Distribute round-robin so that each worker finds work in its own deque first
+    unsigned numSlots = threads_.Size() + 1;
+    unsigned band = GetPriorityBand(item->priority_);
+
+    for (unsigned i = 0; i < numSlots; ++i)
+    {
+        unsigned slot = nextDeque_;
+        nextDeque_ = (nextDeque_ + 1) % numSlots;
+        if (deques_[band * numSlots + slot]->Push(item))
+            return;
+    }
+
+    // All deques full, use the shared queue
+    if (!paused_)
+        queueMutex_.Acquire();
+
+    List<WorkItem*>::Iterator i = queue_.Begin();
+    while (i != queue_.End() && (*i)->priority_ > item->priority_)
+        ++i;
+    queue_.Insert(i, item);
+
+    if (!paused_)
+        queueMutex_.Release();
+}
+
+WorkItem* WorkQueue::StealItem(unsigned threadIndex)
+{
+    unsigned numSlots = threads_.Size() + 1;
+
+    // Exhaust higher priority band first. Start from own deque, then try the others
+    for (unsigned band = 0; band < NUM_PRIORITY_BANDS; ++band)
+    {
+        for (unsigned i = 0; i < numSlots; ++i)
+        {
+            unsigned slot = (threadIndex + i) % numSlots;
+            if (WorkItem* item = deques_[band * numSlots + slot]->Steal())
+                return item;
+        }
+    }
+
+    return nullptr;
+}
+
+WorkItem* WorkQueue::TakeItemMainThread(unsigned priority)
+{
+    unsigned numSlots = threads_.Size() + 1;
+
+    for (unsigned band = 0; band < NUM_PRIORITY_BANDS; ++band)
+    {
+        // Lower bands can only contain items with priority less than M_MAX_UNSIGNED
+        if (band > 0 && priority == M_MAX_UNSIGNED)
+            break;
+
+        // The main thread owns all deques, so it can pop from the bottom and put back items which do not qualify
+        for (unsigned slot = 0; slot < numSlots; ++slot)
+        {
+            WorkStealingDeque* deque = deques_[band * numSlots + slot];
+            if (WorkItem* item = deque->Pop())
+            {
+                if (item->priority_ >= priority)
+                    return item;
+                deque->Push(item);
+            }
+        }
+    }
+
+    // Check the overflow queue last
+    if (!queue_.Empty())
+    {
+        MutexLock lock(queueMutex_);
+        if (!queue_.Empty() && queue_.Front()->priority_ >= priority)
+        {
+            WorkItem* item = queue_.Front();
+            queue_.PopFront();
+            return item;
+        }
+    }
+
+    return nullptr;
+}
+
+void WorkQueue::ExecuteStolenItem(WorkItem* item, unsigned threadIndex)
+{
+    // The claim fails if the item was removed by the main thread before it was taken
+    if (!item->claimed_.exchange(true))
+        item->workFunction_(item, threadIndex);
+    item->completed_ = true;
+}
+
+bool WorkQueue::HasQueuedItems() const
+{
+    for (Vector<SharedPtr<WorkStealingDeque> >::ConstIterator i = deques_.Begin(); i != deques_.End(); ++i)
+    {
+        if (!(*i)->IsEmpty())
+            return true;
+    }
+
+    return !queue_.Empty();
+}
+
 void WorkQueue::PurgeCompleted(unsigned priority)
 {
     // Purge completed work items and send completion events. Do not signal items lower than priority threshold,
@@ -348,7 +933,7 @@ void WorkQueue::PurgeCompleted(unsigned priority)
     {
         if ((*i)->completed_ && (*i)->priority_ >= priority)
         {
-            if ((*i)->sendEvent_)
+            if ((*i)->sendEvent_ && !(*i)->removed_)
             {
                 using namespace WorkItemCompleted;
 
@@ -372,7 +957,7 @@ void WorkQueue::PurgePool()
 
     // Difference tolerance, should be fairly significant to reduce the pool size.
     for (unsigned i = 0; poolItems_.Size() > 0 && difference > tolerance_ && i < (unsigned)difference; i++)
-        poolItems_.PopFront();
+        poolItems_.Pop();
 
     lastSize_ = currentSize;
 }
@@ -393,6 +978,8 @@ void WorkQueue::ReturnToPool(SharedPtr<WorkItem>& item)
         item->priority_ = M_MAX_UNSIGNED;
         item->sendEvent_ = false;
         item->completed_ = false;
+        item->claimed_ = false;
+        item->removed_ = false;
 
         poolItems_.Push(item);
     }
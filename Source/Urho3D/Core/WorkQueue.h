@@ -22,11 +22,13 @@
 
 #pragma once
 
+#include "../Container/ArrayPtr.h"
 #include "../Container/List.h"
 #include "../Core/Mutex.h"
 #include "../Core/Object.h"
 
 #include <atomic>
+#include <functional>
 
 namespace Urho3D
 {
@@ -38,6 +40,16 @@ URHO3D_EVENT(E_WORKITEMCOMPLETED, WorkItemCompleted)
 }
 
 class WorkerThread;
+class WorkStealingDeque;
+
+/// Work queue scheduling mode.
+enum WorkQueueMode
+{
+    /// All threads share a single priority-sorted queue guarded by a mutex.
+    WQM_SHARED_QUEUE = 0,
+    /// Each thread has lock-free deques per priority band and idle threads steal work from the others.
+    WQM_WORK_STEALING
+};
 
 /// Work queue item.
 /// @nobind
@@ -63,6 +75,75 @@ public:
 
 private:
     bool pooled_{};
+    /// Claimed for execution or removal flag. Used by the work stealing mode.
+    std::atomic<bool> claimed_{};
+    /// Removed before execution flag. Used by the work stealing mode. Accessed only by the main thread.
+    bool removed_{};
+};
+
+/// Parallel for function. Called with the begin and end of the index range to process and the thread index (0 = main thread).
+using ParallelForFunction = std::function<void(unsigned, unsigned, unsigned)>;
+/// Task graph function. Called with the thread index (0 = main thread).
+using WorkTaskFunction = std::function<void(unsigned)>;
+
+/// Graph of tasks with dependencies, executed by the work queue. A task starts as soon as all the tasks it depends on have completed. The graph must be acyclic.
+/// @nobind
+class URHO3D_API WorkTaskGraph : public RefCounted
+{
+    friend class WorkQueue;
+
+public:
+    /// Construct.
+    WorkTaskGraph();
+
+    /// Add a task without dependencies. Return its index.
+    unsigned AddTask(const WorkTaskFunction& function);
+    /// Add a continuation task which starts once the given task has completed. Return its index.
+    unsigned AddContinuation(unsigned task, const WorkTaskFunction& function);
+    /// Make a task start only after another task has completed.
+    void AddDependency(unsigned task, unsigned dependency);
+    /// Remove all tasks.
+    void Clear();
+
+    /// Return number of tasks.
+    unsigned GetNumTasks() const { return tasks_.Size(); }
+    /// Take a ready task and execute it. Return false if no task was ready. Called by the work queue during execution.
+    bool ExecuteReadyTask(unsigned threadIndex);
+
+    /// Return whether all tasks have completed during execution.
+    bool IsFinished() const { return numCompleted_.load(std::memory_order_acquire) == tasks_.Size(); }
+
+private:
+    /// Task graph node.
+    struct Task
+    {
+        /// Function to execute.
+        WorkTaskFunction function_;
+        /// Indices of the tasks that depend on this task.
+        PODVector<unsigned> dependents_;
+        /// Number of tasks this task depends on.
+        unsigned numDependencies_;
+    };
+
+    /// Reset execution state and queue the tasks without dependencies. Return false if the graph contains a cycle.
+    bool Prepare();
+    /// Mark a task ready for execution.
+    void PushReadyTask(unsigned index);
+
+    /// Tasks.
+    Vector<Task> tasks_;
+    /// Remaining dependencies per task during execution.
+    SharedArrayPtr<std::atomic<unsigned> > remainingDependencies_;
+    /// Ready task indices in the order they became ready. Unpublished slots hold M_MAX_UNSIGNED.
+    SharedArrayPtr<std::atomic<unsigned> > readyTasks_;
+    /// Capacity of the execution state arrays.
+    unsigned capacity_;
+    /// Index of the next ready task to take.
+    std::atomic<unsigned> readyHead_;
+    /// Index of the next ready task slot to publish.
+    std::atomic<unsigned> readyTail_;
+    /// Number of completed tasks during execution.
+    std::atomic<unsigned> numCompleted_;
 };
 
 /// Work queue subsystem for multithreading.
@@ -78,8 +159,8 @@ public:
     /// Destruct.
     ~WorkQueue() override;
 
-    /// Create worker threads. Can only be called once.
-    void CreateThreads(unsigned numThreads);
+    /// Create worker threads and choose the scheduling mode. Can only be called once.
+    void CreateThreads(unsigned numThreads, WorkQueueMode mode = WQM_SHARED_QUEUE);
     /// Get pointer to an usable WorkItem from the item pool. Allocate one if no more free items.
     SharedPtr<WorkItem> GetFreeItem();
     /// Add a work item and resume worker threads.
@@ -94,6 +175,10 @@ public:
     void Resume();
     /// Finish all queued work which has at least the specified priority. Main thread will also execute priority work. Pause worker threads if no more work remains.
     void Complete(unsigned priority);
+    /// Execute a function over the index range [begin, end) split into chunks of grainSize indices (0 = one chunk per thread) in the worker threads and the main thread. Return once all chunks have been processed, without waiting for other queued work. Can only be called from the main thread.
+    void ParallelFor(unsigned begin, unsigned end, unsigned grainSize, const ParallelForFunction& function);
+    /// Execute a task graph in the worker threads and the main thread. Return once all tasks have completed, without waiting for other queued work. Can only be called from the main thread.
+    void Run(WorkTaskGraph* graph);
 
     /// Set the pool telerance before it starts deleting pool items.
     void SetTolerance(int tolerance) { tolerance_ = tolerance; }
@@ -104,6 +189,9 @@ public:
     /// Return number of worker threads.
     unsigned GetNumThreads() const { return threads_.Size(); }
 
+    /// Return the scheduling mode.
+    WorkQueueMode GetMode() const { return mode_; }
+
     /// Return whether all work with at least the specified priority is finished.
     bool IsCompleted(unsigned priority) const;
     /// Return whether the queue is currently completing work in the main thread.
@@ -118,6 +206,24 @@ public:
 private:
     /// Process work items until shut down. Called by the worker threads.
     void ProcessItems(unsigned threadIndex);
+    /// Process work items using the work stealing deques until shut down. Called by the worker threads.
+    void ProcessItemsStealing(unsigned threadIndex);
+    /// Complete work using the work stealing deques.
+    void CompleteStealing(unsigned priority);
+    /// Push an item to the work stealing deques, falling back to the shared queue if they are full. Called by the main thread.
+    void PushStealing(WorkItem* item);
+    /// Take an item from the work stealing deques, preferring the given thread's own deque. Return null if none found.
+    WorkItem* StealItem(unsigned threadIndex);
+    /// Take an item with at least the specified priority from the work stealing deques in the main thread. Return null if none found.
+    WorkItem* TakeItemMainThread(unsigned priority);
+    /// Execute an item taken from the work stealing deques unless it has been removed.
+    void ExecuteStolenItem(WorkItem* item, unsigned threadIndex);
+    /// Return whether the work stealing deques or the shared queue hold unclaimed items.
+    bool HasQueuedItems() const;
+    /// Add work items which run the work function in each worker thread, until the main thread has finished.
+    void AddHelperItems(unsigned count, void (* workFunction)(const WorkItem*, unsigned), void* aux);
+    /// Wait for helper work items starting from the specified index to finish. Remove those that have not started yet.
+    void FinishHelperItems(unsigned first);
     /// Purge completed work items which have at least the specified priority, and send completion events as necessary.
     void PurgeCompleted(unsigned priority);
     /// Purge the pool to reduce allocation where its unneeded.
@@ -129,11 +235,13 @@ private:
 
     /// Worker threads.
     Vector<SharedPtr<WorkerThread> > threads_;
-    /// Work item pool for reuse to cut down on allocation. The bool is a flag for item pooling and whether it is available or not.
-    List<SharedPtr<WorkItem> > poolItems_;
+    /// Work item pool for reuse to cut down on allocation.
+    Vector<SharedPtr<WorkItem> > poolItems_;
+    /// Helper work items of the currently running parallel for or task graph.
+    Vector<SharedPtr<WorkItem> > helperItems_;
     /// Work item collection. Accessed only by the main thread.
     List<SharedPtr<WorkItem> > workItems_;
-    /// Work item prioritized queue for worker threads. Pointers are guaranteed to be valid (point to workItems).
+    /// Work item prioritized queue for worker threads. Pointers are guaranteed to be valid (point to workItems). In work stealing mode only used when the deques overflow.
     List<WorkItem*> queue_;
     /// Worker queue mutex.
     Mutex queueMutex_;
@@ -151,6 +259,12 @@ private:
     unsigned lastSize_;
     /// Maximum milliseconds per frame to spend on low-priority work, when there are no worker threads.
     int maxNonThreadedWorkMs_;
+    /// Work stealing deques, one per thread (main thread first) for each priority band. Owned (pushed to) by the main thread, stolen from by all threads.
+    Vector<SharedPtr<WorkStealingDeque> > deques_;
+    /// Round-robin thread index for distributing new work items to the deques.
+    unsigned nextDeque_;
+    /// Scheduling mode.
+    WorkQueueMode mode_;
 };
 
 }
@@ -194,6 +194,7 @@ bool Engine::Initialize(const VariantMap& parameters)
         if (HasParameter(parameters, EP_LOG_LEVEL))
             log->SetLevel(GetParameter(parameters, EP_LOG_LEVEL).GetInt());
         log->SetQuiet(GetParameter(parameters, EP_LOG_QUIET, false).GetBool());
+        log->SetAsync(GetParameter(parameters, EP_LOG_ASYNC, false).GetBool());
         log->Open(GetParameter(parameters, EP_LOG_NAME, "Urho3D.log").GetString());
     }
 
@@ -210,7 +211,8 @@ bool Engine::Initialize(const VariantMap& parameters)
     unsigned numThreads = GetParameter(parameters, EP_WORKER_THREADS, true).GetBool() ? GetNumPhysicalCPUs() - 1 : 0;
     if (numThreads)
     {
-        GetSubsystem<WorkQueue>()->CreateThreads(numThreads);
+        WorkQueueMode mode = GetParameter(parameters, EP_WORK_STEALING, false).GetBool() ? WQM_WORK_STEALING : WQM_SHARED_QUEUE;
+        GetSubsystem<WorkQueue>()->CreateThreads(numThreads, mode);
 
         URHO3D_LOGINFOF("Created %u worker thread%s", numThreads, numThreads > 1 ? "s" : "");
     }
@@ -334,6 +336,8 @@ bool Engine::InitializeResourceCache(const VariantMap& parameters, bool removeOl
             cache->RemovePackageFile(packageFiles[i]);
     }
 
+    cache->SetMemoryMapPackages(GetParameter(parameters, EP_MEMORY_MAP_PACKAGES, false).GetBool());
+
     // Add resource paths
     Vector<String> resourcePrefixPaths = GetParameter(parameters, EP_RESOURCE_PREFIX_PATHS, String::EMPTY).GetString().Split(';', true);
     for (unsigned i = 0; i < resourcePrefixPaths.Size(); ++i)
@@ -842,6 +846,10 @@ VariantMap Engine::ParseParameters(const Vector<String>& arguments)
                 ret[EP_LOW_QUALITY_SHADOWS] = true;
             else if (argument == "nothreads")
                 ret[EP_WORKER_THREADS] = false;
+            else if (argument == "workstealing")
+                ret[EP_WORK_STEALING] = true;
+            else if (argument == "mmap")
+                ret[EP_MEMORY_MAP_PACKAGES] = true;
             else if (argument == "v")
                 ret[EP_VSYNC] = true;
             else if (argument == "t")
@@ -856,6 +864,8 @@ VariantMap Engine::ParseParameters(const Vector<String>& arguments)
                 ret[EP_WINDOW_RESIZABLE] = true;
             else if (argument == "q")
                 ret[EP_LOG_QUIET] = true;
+            else if (argument == "logasync")
+                ret[EP_LOG_ASYNC] = true;
             else if (argument == "log" && !value.Empty())
             {
                 unsigned logLevel = GetStringListIndex(value.CString(), logLevelPrefixes, M_MAX_UNSIGNED);
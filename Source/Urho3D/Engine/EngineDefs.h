@@ -37,11 +37,13 @@ static const String EP_FRAME_LIMITER = "FrameLimiter";
 static const String EP_FULL_SCREEN = "FullScreen";
 static const String EP_HEADLESS = "Headless";
 static const String EP_HIGH_DPI = "HighDPI";
+static const String EP_LOG_ASYNC = "LogAsync";
 static const String EP_LOG_LEVEL = "LogLevel";
 static const String EP_LOG_NAME = "LogName";
 static const String EP_LOG_QUIET = "LogQuiet";
 static const String EP_LOW_QUALITY_SHADOWS = "LowQualityShadows";
 static const String EP_MATERIAL_QUALITY = "MaterialQuality";
+static const String EP_MEMORY_MAP_PACKAGES = "MemoryMapPackages";
 static const String EP_MONITOR = "Monitor";
 static const String EP_MULTI_SAMPLE = "MultiSample";
 static const String EP_ORIENTATIONS = "Orientations";
@@ -73,5 +75,6 @@ static const String EP_WINDOW_RESIZABLE = "WindowResizable";
 static const String EP_WINDOW_TITLE = "WindowTitle";
 static const String EP_WINDOW_WIDTH = "WindowWidth";
 static const String EP_WORKER_THREADS = "WorkerThreads";
+static const String EP_WORK_STEALING = "WorkStealing";
 
 }
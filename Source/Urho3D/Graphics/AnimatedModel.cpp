@@ -66,6 +66,16 @@ static bool CompareAnimationOrder(const SharedPtr<AnimationState>& lhs, const Sh
 }
 
 static const unsigned MAX_ANIMATION_STATES = 256;
+static const float DEFAULT_POSE_SHARING_TIME_STEP = 1.0f / 60.0f;
+static const float MIN_POSE_SHARING_TIME_STEP = 0.001f;
+/// Number of quantization steps for the animation weights when sharing bone poses.
+static const float POSE_SHARING_WEIGHT_STEPS = 255.0f;
+
+/// Quantize an animation state weight for pose sharing. Positive weights stay nonzero.
+static unsigned QuantizePoseWeight(float weight)
+{
+    return (unsigned)Clamp(RoundToInt(weight * POSE_SHARING_WEIGHT_STEPS), 1, (int)POSE_SHARING_WEIGHT_STEPS);
+}
 
 AnimatedModel::AnimatedModel(Context* context) :
     StaticModel(context),
@@ -74,6 +84,7 @@ AnimatedModel::AnimatedModel(Context* context) :
     animationLodBias_(1.0f),
     animationLodTimer_(-1.0f),
     animationLodDistance_(0.0f),
+    poseSharingTimeStep_(DEFAULT_POSE_SHARING_TIME_STEP),
     updateInvisible_(false),
     animationDirty_(false),
     animationOrderDirty_(false),
@@ -83,17 +94,34 @@ AnimatedModel::AnimatedModel(Context* context) :
     isMaster_(true),
     loading_(false),
     assignBonesPending_(false),
-    forceAnimationUpdate_(false)
+    forceAnimationUpdate_(false),
+    boneNodesEnabled_(true),
+    boneNodesDirty_(false),
+    poseSharing_(false)
 {
 }
 
 AnimatedModel::~AnimatedModel()
 {
     // When being destroyed, remove the bone hierarchy if appropriate (last AnimatedModel in the node)
-    Bone* rootBone = skeleton_.GetRootBone();
-    if (rootBone && rootBone->node_)
+    Node* boneNode = nullptr;
+    if (boneNodesEnabled_)
     {
-        Node* parent = rootBone->node_->GetParent();
+        Bone* rootBone = skeleton_.GetRootBone();
+        if (rootBone)
+            boneNode = rootBone->node_;
+    }
+    else
+    {
+        // Without bone nodes, any of the created bone nodes is a child of the model's scene node
+        const Vector<Bone>& bones = skeleton_.GetBones();
+        for (Vector<Bone>::ConstIterator i = bones.Begin(); i != bones.End() && !boneNode; ++i)
+            boneNode = i->node_;
+    }
+
+    if (boneNode)
+    {
+        Node* parent = boneNode->GetParent();
         if (parent && !parent->GetComponent<AnimatedModel>())
             RemoveRootBone();
     }
@@ -123,6 +151,10 @@ void AnimatedModel::RegisterObject(Context* context)
         .SetMetadata(AttributeMetadata::P_VECTOR_STRUCT_ELEMENTS, animationStatesStructureElementNames);
     URHO3D_ACCESSOR_ATTRIBUTE("Morphs", GetMorphsAttr, SetMorphsAttr, PODVector<unsigned char>, Variant::emptyBuffer,
         AM_DEFAULT | AM_NOEDIT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Bone Nodes Enabled", GetBoneNodesEnabled, SetBoneNodesEnabled, bool, true, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Pose Sharing", GetPoseSharing, SetPoseSharing, bool, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Pose Sharing Time Step", GetPoseSharingTimeStep, SetPoseSharingTimeStep, float,
+        DEFAULT_POSE_SHARING_TIME_STEP, AM_DEFAULT);
 }
 
 bool AnimatedModel::Load(Deserializer& source)
@@ -174,21 +206,23 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
 
     const Vector<Bone>& bones = skeleton_.GetBones();
     Sphere boneSphere;
+    // Without bone nodes, use the bone pose of the master model
+    bool usePose = isMaster_ && !boneNodesEnabled_ && boneTransforms_.Size() == bones.Size();
 
     for (unsigned i = 0; i < bones.Size(); ++i)
     {
         const Bone& bone = bones[i];
-        if (!bone.node_)
+        if (!bone.node_ && !usePose)
             continue;
 
         float distance;
+        Matrix3x4 transform = usePose ? node_->GetWorldTransform() * boneTransforms_[i] : bone.node_->GetWorldTransform();
 
         // Use hitbox if available
         if (bone.collisionMask_ & BONECOLLISION_BOX)
         {
             // Do an initial crude test using the bone's AABB
             const BoundingBox& box = bone.boundingBox_;
-            const Matrix3x4& transform = bone.node_->GetWorldTransform();
             distance = query.ray_.HitDistance(box.Transformed(transform));
             if (distance >= query.maxDistance_)
                 continue;
@@ -204,7 +238,7 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, PODVector<RayQu
         }
         else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
         {
-            boneSphere.center_ = bone.node_->GetWorldPosition();
+            boneSphere.center_ = transform.Translation();
             boneSphere.radius_ = bone.radius_;
             distance = query.ray_.HitDistance(boneSphere);
             if (distance >= query.maxDistance_)
@@ -325,7 +359,31 @@ void AnimatedModel::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
     if (debug && IsEnabledEffective())
     {
         debug->AddBoundingBox(GetWorldBoundingBox(), Color::GREEN, depthTest);
-        debug->AddSkeleton(skeleton_, Color(0.75f, 0.75f, 0.75f), depthTest);
+        if (boneNodesEnabled_ || !isMaster_)
+            debug->AddSkeleton(skeleton_, Color(0.75f, 0.75f, 0.75f), depthTest);
+        else
+        {
+            // Draw the skeleton from the bone pose, the same way as DebugRenderer::AddSkeleton() does from the bone nodes
+            const Vector<Bone>& bones = skeleton_.GetBones();
+            const Matrix3x4& worldTransform = node_->GetWorldTransform();
+            Color color(0.75f, 0.75f, 0.75f);
+
+            for (unsigned i = 0; i < bones.Size() && i < boneTransforms_.Size(); ++i)
+            {
+                // Skip if bone contains no skinned geometry
+                if (bones[i].radius_ < M_EPSILON && bones[i].boundingBox_.Size().LengthSquared() < M_EPSILON)
+                    continue;
+
+                Vector3 start = worldTransform * boneTransforms_[i].Translation();
+                Vector3 end = start;
+
+                unsigned j = boneParents_[i];
+                if (j != M_MAX_UNSIGNED && (bones[j].radius_ >= M_EPSILON || bones[j].boundingBox_.Size().LengthSquared() >= M_EPSILON))
+                    end = worldTransform * boneTransforms_[j].Translation();
+
+                debug->AddLine(start, end, color, depthTest);
+            }
+        }
     }
 }
 
@@ -548,6 +606,90 @@ void AnimatedModel::SetUpdateInvisible(bool enable)
     MarkNetworkUpdate();
 }
 
+void AnimatedModel::SetBoneNodesEnabled(bool enable)
+{
+    if (enable == boneNodesEnabled_)
+        return;
+
+    boneNodesEnabled_ = enable;
+
+    // When loading, the bone nodes are assigned later in ApplyAttributes()
+    if (isMaster_ && node_ && !loading_ && !assignBonesPending_ && skeleton_.GetNumBones())
+    {
+        if (enable)
+            CreateBoneNodes();
+        else
+        {
+            RemoveUnusedBoneNodes();
+            InitializeBonePose();
+        }
+
+        // Re-assign the same start bone to animations to switch between the bone nodes and the bone pose
+        for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+        {
+            AnimationState* state = *i;
+            state->SetStartBone(state->GetStartBone());
+        }
+
+        MarkAnimationDirty();
+    }
+
+    MarkNetworkUpdate();
+}
+
+void AnimatedModel::SetPoseSharing(bool enable)
+{
+    if (enable == poseSharing_)
+        return;
+
+    poseSharing_ = enable;
+    MarkAnimationDirty();
+    MarkNetworkUpdate();
+}
+
+void AnimatedModel::SetPoseSharingTimeStep(float step)
+{
+    poseSharingTimeStep_ = Max(step, MIN_POSE_SHARING_TIME_STEP);
+    MarkAnimationDirty();
+    MarkNetworkUpdate();
+}
+
+Node* AnimatedModel::CreateBoneNode(const String& boneName)
+{
+    Bone* bone = skeleton_.GetBone(boneName);
+    if (!bone)
+    {
+        URHO3D_LOGERROR("Bone " + boneName + " not found, can not create bone node");
+        return nullptr;
+    }
+
+    if (bone->node_ || boneNodesEnabled_)
+        return bone->node_;
+
+    if (!isMaster_ || !node_)
+    {
+        URHO3D_LOGERROR("Can not create bone node for a non-master model or a model not attached to a scene node");
+        return nullptr;
+    }
+
+    // Create bones as local, as they are never to be directly synchronized over the network
+    Node* boneNode = node_->CreateChild(bone->name_, LOCAL);
+    boneNode->SetTemporary(IsTemporary());
+    bone->node_ = boneNode;
+
+    unsigned index = skeleton_.GetBoneIndex(bone);
+    if (index < boneTransforms_.Size())
+    {
+        Vector3 position;
+        Quaternion rotation;
+        Vector3 scale;
+        boneTransforms_[index].Decompose(position, rotation, scale);
+        boneNode->SetTransform(position, rotation, scale);
+    }
+
+    return boneNode;
+}
+
 
 void AnimatedModel::SetMorphWeight(unsigned index, float weight)
 {
@@ -710,8 +852,8 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
 
             for (unsigned i = 0; i < destBones.Size(); ++i)
             {
-                if (destBones[i].node_ && destBones[i].name_ == srcBones[i].name_ && destBones[i].parentIndex_ ==
-                                                                                     srcBones[i].parentIndex_)
+                if ((destBones[i].node_ || !boneNodesEnabled_) && destBones[i].name_ == srcBones[i].name_ &&
+                    destBones[i].parentIndex_ == srcBones[i].parentIndex_)
                 {
                     // If compatible, just copy the values and retain the old node and animated status
                     Node* boneNode = destBones[i].node_;
@@ -740,29 +882,17 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
 
         // Merge bounding boxes from non-master models
         FinalizeBoneBoundingBoxes();
+        InitializeBonePose();
 
-        Vector<Bone>& bones = skeleton_.GetModifiableBones();
-        // Create scene nodes for the bones
-        if (createBones)
-        {
-            for (Vector<Bone>::Iterator i = bones.Begin(); i != bones.End(); ++i)
-            {
-                // Create bones as local, as they are never to be directly synchronized over the network
-                Node* boneNode = node_->CreateChild(i->name_, LOCAL);
-                boneNode->AddListener(this);
-                boneNode->SetTransform(i->initialPosition_, i->initialRotation_, i->initialScale_);
-                // Copy the model component's temporary status
-                boneNode->SetTemporary(IsTemporary());
-                i->node_ = boneNode;
-            }
+        // Non-master models need to map their bones to the new skeleton
+        PODVector<AnimatedModel*> models;
+        GetComponents<AnimatedModel>(models);
+        for (PODVector<AnimatedModel*>::Iterator i = models.Begin(); i != models.End(); ++i)
+            (*i)->masterBoneIndices_.Clear();
 
-            for (unsigned i = 0; i < bones.Size(); ++i)
-            {
-                unsigned parentIndex = bones[i].parentIndex_;
-                if (parentIndex != i && parentIndex < bones.Size())
-                    bones[parentIndex].node_->AddChild(bones[i].node_);
-            }
-        }
+        // Create scene nodes for the bones
+        if (createBones && boneNodesEnabled_)
+            CreateBoneNodes();
 
         using namespace BoneHierarchyCreated;
 
@@ -774,6 +904,7 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
     {
         // For non-master models: use the bone nodes of the master model
         skeleton_.Define(skeleton);
+        masterBoneIndices_.Clear();
 
         // Instruct the master model to refresh (merge) its bone bounding boxes
         auto* master = node_->GetComponent<AnimatedModel>();
@@ -909,9 +1040,28 @@ void AnimatedModel::UpdateBoneBoundingBox()
     {
         // The bone bounding box is in local space, so need the node's inverse transform
         boneBoundingBox_.Clear();
+        const Vector<Bone>& bones = skeleton_.GetBones();
+
+        // Without bone nodes the bone pose is already in local space
+        if (isMaster_ && !boneNodesEnabled_ && boneTransforms_.Size() == bones.Size())
+        {
+            for (unsigned i = 0; i < bones.Size(); ++i)
+            {
+                const Bone& bone = bones[i];
+                if (bone.collisionMask_ & BONECOLLISION_BOX)
+                    boneBoundingBox_.Merge(bone.boundingBox_.Transformed(boneTransforms_[i]));
+                else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
+                    boneBoundingBox_.Merge(Sphere(boneTransforms_[i].Translation(), bone.radius_ * 0.5f));
+            }
+
+            boneBoundingBoxDirty_ = false;
+            worldBoundingBoxDirty_ = true;
+            UpdateOctantBounds();
+            return;
+        }
+
         Matrix3x4 inverseNodeTransform = node_->GetWorldTransform().Inverse();
 
-        const Vector<Bone>& bones = skeleton_.GetBones();
         for (Vector<Bone>::ConstIterator i = bones.Begin(); i != bones.End(); ++i)
         {
             Node* boneNode = i->node_;
@@ -929,6 +1079,7 @@ void AnimatedModel::UpdateBoneBoundingBox()
 
     boneBoundingBoxDirty_ = false;
     worldBoundingBoxDirty_ = true;
+    UpdateOctantBounds();
 }
 
 void AnimatedModel::OnNodeSet(Node* node)
@@ -946,6 +1097,17 @@ void AnimatedModel::OnMarkedDirty(Node* node)
 {
     Drawable::OnMarkedDirty(node);
 
+    // Write the bone pose of a threaded animation update to the bone nodes
+    if (boneNodesDirty_ && node == node_)
+    {
+        Scene* scene = GetScene();
+        if (!scene || !scene->IsThreadedUpdate())
+        {
+            boneNodesDirty_ = false;
+            UpdateBoneNodes();
+        }
+    }
+
     // If the scene node or any of the bone nodes move, mark skinning dirty
     if (skeleton_.GetNumBones())
     {
@@ -998,8 +1160,10 @@ void AnimatedModel::AssignBoneNodes()
     }
 
     // If no bones found, this may be a prefab where the bone information was left out.
-    // In that case reassign the skeleton now if possible
-    if (!boneFound && model_)
+    // In that case reassign the skeleton now if possible. Without bone nodes, keep only the nodes that are in use
+    if (isMaster_ && !boneNodesEnabled_)
+        RemoveUnusedBoneNodes();
+    else if (!boneFound && model_)
         SetSkeleton(model_->GetSkeleton(), true);
 
     // Re-assign the same start bone to animations to get the proper bone node this time
@@ -1074,11 +1238,276 @@ void AnimatedModel::FinalizeBoneBoundingBoxes()
 
 void AnimatedModel::RemoveRootBone()
 {
+    // Without bone nodes, the created bone nodes are each parented to the model's scene node
+    if (!boneNodesEnabled_)
+    {
+        Vector<Bone>& bones = skeleton_.GetModifiableBones();
+        for (Vector<Bone>::Iterator i = bones.Begin(); i != bones.End(); ++i)
+        {
+            if (i->node_)
+                i->node_->Remove();
+        }
+        return;
+    }
+
     Bone* rootBone = skeleton_.GetRootBone();
     if (rootBone && rootBone->node_)
         rootBone->node_->Remove();
 }
 
+void AnimatedModel::CreateBoneNodes()
+{
+    Vector<Bone>& bones = skeleton_.GetModifiableBones();
+    for (Vector<Bone>::Iterator i = bones.Begin(); i != bones.End(); ++i)
+    {
+        // Reuse the nodes created while bone nodes were disabled
+        Node* boneNode = i->node_;
+        if (!boneNode)
+        {
+            // Create bones as local, as they are never to be directly synchronized over the network
+            boneNode = node_->CreateChild(i->name_, LOCAL);
+            // Copy the model component's temporary status
+            boneNode->SetTemporary(IsTemporary());
+            i->node_ = boneNode;
+        }
+        boneNode->AddListener(this);
+        boneNode->SetTransform(i->initialPosition_, i->initialRotation_, i->initialScale_);
+    }
+
+    for (unsigned i = 0; i < bones.Size(); ++i)
+    {
+        unsigned parentIndex = bones[i].parentIndex_;
+        if (parentIndex != i && parentIndex < bones.Size())
+            bones[parentIndex].node_->AddChild(bones[i].node_);
+    }
+}
+
+void AnimatedModel::RemoveUnusedBoneNodes()
+{
+    Vector<Bone>& bones = skeleton_.GetModifiableBones();
+    PODVector<bool> keep(bones.Size());
+
+    // Keep the bone nodes that have components or other than bone nodes as children. Also keep the nodes that
+    // are already parented to the model's scene node without bone children, as they were created while bone nodes
+    // were disabled
+    for (unsigned i = 0; i < bones.Size(); ++i)
+    {
+        Node* boneNode = bones[i].node_;
+        keep[i] = false;
+        if (!boneNode)
+            continue;
+
+        bool hasBoneChildren = false;
+        const Vector<SharedPtr<Node> >& children = boneNode->GetChildren();
+        for (Vector<SharedPtr<Node> >::ConstIterator j = children.Begin(); j != children.End(); ++j)
+        {
+            if (skeleton_.GetBone((*j)->GetNameHash()))
+                hasBoneChildren = true;
+            else
+                keep[i] = true;
+        }
+
+        if (boneNode->GetNumComponents() || (boneNode->GetParent() == node_ && !hasBoneChildren))
+            keep[i] = true;
+    }
+
+    // Move the kept nodes first, so that removing the rest of the hierarchy does not remove them
+    for (unsigned i = 0; i < bones.Size(); ++i)
+    {
+        Node* boneNode = bones[i].node_;
+        if (keep[i])
+        {
+            boneNode->RemoveListener(this);
+            if (boneNode->GetParent() != node_)
+                node_->AddChild(boneNode);
+        }
+    }
+
+    for (unsigned i = 0; i < bones.Size(); ++i)
+    {
+        Node* boneNode = bones[i].node_;
+        if (boneNode && !keep[i])
+        {
+            boneNode->RemoveListener(this);
+            boneNode->Remove();
+        }
+        if (!keep[i])
+            bones[i].node_.Reset();
+    }
+}
+
+void AnimatedModel::InitializeBonePose()
+{
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    unsigned numBones = bones.Size();
+
+    bonePositions_.Resize(numBones);
+    boneRotations_.Resize(numBones);
+    boneScales_.Resize(numBones);
+    boneTransforms_.Resize(numBones);
+    boneParents_.Resize(numBones);
+    boneOrder_.Clear();
+    boneOrder_.Reserve(numBones);
+
+    PODVector<bool> added(numBones);
+    for (unsigned i = 0; i < numBones; ++i)
+    {
+        const Bone& bone = bones[i];
+        bonePositions_[i] = bone.initialPosition_;
+        boneRotations_[i] = bone.initialRotation_;
+        boneScales_[i] = bone.initialScale_;
+        boneParents_[i] = bone.parentIndex_ != i && bone.parentIndex_ < numBones ? bone.parentIndex_ : M_MAX_UNSIGNED;
+        added[i] = false;
+    }
+
+    // Order the bones so that each parent comes before its children. A bone in a parent loop is evaluated as a root
+    while (boneOrder_.Size() < numBones)
+    {
+        unsigned numAdded = boneOrder_.Size();
+        for (unsigned i = 0; i < numBones; ++i)
+        {
+            if (!added[i] && (boneParents_[i] == M_MAX_UNSIGNED || added[boneParents_[i]]))
+            {
+                boneOrder_.Push(i);
+                added[i] = true;
+            }
+        }
+
+        if (boneOrder_.Size() == numAdded)
+        {
+            for (unsigned i = 0; i < numBones; ++i)
+            {
+                if (!added[i])
+                {
+                    boneParents_[i] = M_MAX_UNSIGNED;
+                    break;
+                }
+            }
+        }
+    }
+
+    UpdateBoneTransforms();
+}
+
+void AnimatedModel::UpdateBoneTransforms()
+{
+    for (PODVector<unsigned>::ConstIterator i = boneOrder_.Begin(); i != boneOrder_.End(); ++i)
+    {
+        unsigned index = *i;
+        unsigned parentIndex = boneParents_[index];
+        Matrix3x4 localTransform(bonePositions_[index], boneRotations_[index], boneScales_[index]);
+        boneTransforms_[index] = parentIndex != M_MAX_UNSIGNED ? boneTransforms_[parentIndex] * localTransform : localTransform;
+    }
+}
+
+void AnimatedModel::ResetBonePose()
+{
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    for (unsigned i = 0; i < bonePositions_.Size(); ++i)
+    {
+        const Bone& bone = bones[i];
+        if (bone.animated_)
+        {
+            bonePositions_[i] = bone.initialPosition_;
+            boneRotations_[i] = bone.initialRotation_;
+            boneScales_[i] = bone.initialScale_;
+        }
+    }
+}
+
+bool AnimatedModel::ApplySharedAnimation()
+{
+    AnimationPoseCache* poseCache = model_ ? model_->GetPoseCache() : nullptr;
+    if (!poseCache)
+        return false;
+
+    // Bones with animation disabled may be posed from outside, so such a skeleton can not share poses
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    if (bones.Empty())
+        return false;
+    for (Vector<Bone>::ConstIterator i = bones.Begin(); i != bones.End(); ++i)
+    {
+        if (!i->animated_)
+            return false;
+    }
+
+    // The animation states are in layer order already, so the same key always means the same blending order
+    float timeStep = poseSharingTimeStep_;
+    poseKey_.Clear();
+    poseKey_.Add(FloatToRawIntBits(timeStep));
+    for (Vector<SharedPtr<AnimationState> >::ConstIterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+    {
+        // Skip the same states as AnimationState::Apply(), so that small weights are quantized rather than dropped. Key
+        // the animation by its data version, as an animation at the same address may be a different one
+        const AnimationState* state = *i;
+        if (!state->GetAnimation() || !state->IsEnabled())
+            continue;
+
+        Bone* startBone = state->GetStartBone();
+        poseKey_.Add(state->GetAnimation()->GetVersion());
+        unsigned weightIndex = QuantizePoseWeight(state->GetWeight());
+        poseKey_.Add((unsigned)RoundToInt(state->GetTime() / timeStep));
+        poseKey_.Add(weightIndex | (unsigned)state->GetBlendMode() << 8u | (state->IsLooped() ? 1u << 16u : 0u));
+        poseKey_.Add(startBone ? (unsigned)(startBone - &bones[0]) : M_MAX_UNSIGNED);
+
+        // Per-bone weights are rare, so only add them when used
+        const Vector<AnimationStateTrack>& stateTracks = state->stateTracks_;
+        bool hasBoneWeights = false;
+        for (Vector<AnimationStateTrack>::ConstIterator j = stateTracks.Begin(); j != stateTracks.End(); ++j)
+        {
+            if (j->weight_ != 1.0f)
+            {
+                hasBoneWeights = true;
+                break;
+            }
+        }
+        if (hasBoneWeights)
+        {
+            for (Vector<AnimationStateTrack>::ConstIterator j = stateTracks.Begin(); j != stateTracks.End(); ++j)
+                poseKey_.Add((unsigned)RoundToInt(j->weight_ * POSE_SHARING_WEIGHT_STEPS));
+        }
+    }
+
+    if (poseCache->GetPose(poseKey_, boneTransforms_))
+        return true;
+
+    // Not found: evaluate with the quantized time positions and weights, so that the pose is the same for every model
+    // with the same key
+    ResetBonePose();
+    for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+    {
+        AnimationState* state = *i;
+        if (!state->GetAnimation() || !state->IsEnabled())
+            continue;
+
+        unsigned weightIndex = QuantizePoseWeight(state->GetWeight());
+        float time = Min(RoundToInt(state->GetTime() / timeStep) * timeStep, state->GetLength());
+        state->ApplyToModel(time, weightIndex / POSE_SHARING_WEIGHT_STEPS);
+    }
+
+    UpdateBoneTransforms();
+    poseCache->StorePose(poseKey_, boneTransforms_);
+    return true;
+}
+
+void AnimatedModel::UpdateBoneNodes()
+{
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    Vector3 position;
+    Quaternion rotation;
+    Vector3 scale;
+
+    for (unsigned i = 0; i < bones.Size(); ++i)
+    {
+        Node* boneNode = bones[i].node_;
+        if (boneNode)
+        {
+            boneTransforms_[i].Decompose(position, rotation, scale);
+            boneNode->SetTransform(position, rotation, scale);
+        }
+    }
+}
+
 void AnimatedModel::MarkAnimationDirty()
 {
     if (isMaster_)
@@ -1284,14 +1713,58 @@ void AnimatedModel::ApplyAnimation()
 
     // Reset skeleton, apply all animations, calculate bones' bounding box. Make sure this is only done for the master model
     // (first AnimatedModel in a node)
-    if (isMaster_)
+    if (isMaster_ && !boneNodesEnabled_)
+    {
+        // Without bone nodes, reset and animate the bone pose arrays, then evaluate the hierarchy in one pass
+        if (!poseSharing_ || !ApplySharedAnimation())
+        {
+            ResetBonePose();
+            for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+                (*i)->Apply();
+
+            UpdateBoneTransforms();
+        }
+
+        // The other models in the node use this model's bone pose, so their skinning needs to be updated too
+        const Vector<SharedPtr<Component> >& components = node_->GetComponents();
+        for (Vector<SharedPtr<Component> >::ConstIterator i = components.Begin(); i != components.End(); ++i)
+        {
+            if ((*i)->GetType() == GetTypeStatic())
+                static_cast<AnimatedModel*>(i->Get())->skinningDirty_ = true;
+        }
+
+        // Copy the pose to the bone nodes that exist. Marking nodes dirty is not threadsafe, so during a threaded update
+        // this is done in the main thread afterward
+        const Vector<Bone>& bones = skeleton_.GetBones();
+        for (Vector<Bone>::ConstIterator i = bones.Begin(); i != bones.End(); ++i)
+        {
+            if (i->node_)
+            {
+                Scene* scene = GetScene();
+                if (scene && scene->IsThreadedUpdate())
+                {
+                    boneNodesDirty_ = true;
+                    scene->DelayedMarkedDirty(this);
+                }
+                else
+                    UpdateBoneNodes();
+                break;
+            }
+        }
+
+        UpdateBoneBoundingBox();
+    }
+    else if (isMaster_)
     {
         skeleton_.ResetSilent();
         for (Vector<SharedPtr<AnimationState> >::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
             (*i)->Apply();
 
-        // Skeleton reset and animations apply the node transforms "silently" to avoid repeated marking dirty. Mark dirty now
-        node_->MarkDirty();
+        // Skeleton reset and animations apply the node transforms "silently" to avoid repeated marking dirty. Mark the
+        // bone hierarchy dirty now, which also marks the skinning dirty through the bone node listeners
+        Bone* rootBone = skeleton_.GetRootBone();
+        if (rootBone && rootBone->node_)
+            rootBone->node_->MarkDirty();
 
         // Calculate new bone bounding box
         UpdateBoneBoundingBox();
@@ -1307,8 +1780,38 @@ void AnimatedModel::UpdateSkinning()
     // Use model's world transform in case a bone is missing
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
 
+    // Without bone nodes, use the bone pose of the master model
+    AnimatedModel* master = isMaster_ ? this : node_->GetComponent<AnimatedModel>();
+    if (master && !master->boneNodesEnabled_ && master->skeleton_.GetNumBones() == master->boneTransforms_.Size())
+    {
+        const PODVector<Matrix3x4>& boneTransforms = master->boneTransforms_;
+
+        // Map a non-master model's bones to the master model's bones by name
+        if (master != this && masterBoneIndices_.Size() != bones.Size())
+        {
+            masterBoneIndices_.Resize(bones.Size());
+            for (unsigned i = 0; i < bones.Size(); ++i)
+                masterBoneIndices_[i] = master->skeleton_.GetBoneIndex(bones[i].nameHash_);
+        }
+
+        for (unsigned i = 0; i < bones.Size(); ++i)
+        {
+            unsigned index = master == this ? i : masterBoneIndices_[i];
+            if (index < boneTransforms.Size())
+                skinMatrices_[i] = worldTransform * (boneTransforms[index] * bones[i].offsetMatrix_);
+            else
+                skinMatrices_[i] = worldTransform;
+
+            // Copy the skin matrix to per-geometry matrices as needed
+            if (geometrySkinMatrices_.Size())
+            {
+                for (unsigned j = 0; j < geometrySkinMatrixPtrs_[i].Size(); ++j)
+                    *geometrySkinMatrixPtrs_[i][j] = skinMatrices_[i];
+            }
+        }
+    }
     // Skinning with global matrices only
-    if (!geometrySkinMatrices_.Size())
+    else if (!geometrySkinMatrices_.Size())
     {
         for (unsigned i = 0; i < bones.Size(); ++i)
         {
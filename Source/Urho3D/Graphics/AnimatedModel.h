@@ -101,6 +101,17 @@ public:
     void ResetMorphWeights();
     /// Apply all animation states to nodes.
     void ApplyAnimation();
+    /// Set whether to create a scene node for each bone. When disabled, the bone poses are kept in flat arrays and the bone hierarchy is evaluated without scene nodes; only bones that have nodes attached or that are requested with CreateBoneNode() get a node. Only has effect on the master model. Default true.
+    /// @property
+    void SetBoneNodesEnabled(bool enable);
+    /// Create a scene node for a bone when bone nodes are disabled. The node is a child of the model's scene node and follows the bone's animated pose. Return the existing node if the bone already has one.
+    Node* CreateBoneNode(const String& boneName);
+    /// Set whether to share evaluated bone poses with the other models that use the same model resource, skeleton and animation states. Animation time positions and weights are quantized for sharing. Only has effect on the master model when bone nodes are disabled and all bones are animated. Default false.
+    /// @property
+    void SetPoseSharing(bool enable);
+    /// Set time step to quantize the animation time positions to when sharing bone poses. Default 1/60 seconds.
+    /// @property
+    void SetPoseSharingTimeStep(float step);
 
     /// Return skeleton.
     /// @property
@@ -131,6 +142,21 @@ public:
     /// @property
     bool GetUpdateInvisible() const { return updateInvisible_; }
 
+    /// Return whether a scene node is created for each bone.
+    /// @property
+    bool GetBoneNodesEnabled() const { return boneNodesEnabled_; }
+
+    /// Return whether evaluated bone poses are shared.
+    /// @property
+    bool GetPoseSharing() const { return poseSharing_; }
+
+    /// Return time step to quantize the animation time positions to when sharing bone poses.
+    /// @property
+    float GetPoseSharingTimeStep() const { return poseSharingTimeStep_; }
+
+    /// Return model space bone transforms. Only updated on the master model when bone nodes are disabled.
+    const PODVector<Matrix3x4>& GetBoneTransforms() const { return boneTransforms_; }
+
     /// Return all vertex morphs.
     const Vector<ModelMorph>& GetMorphs() const { return morphs_; }
 
@@ -191,8 +217,22 @@ private:
     void AssignBoneNodes();
     /// Finalize master model bone bounding boxes by merging from matching non-master bones.. Performed whenever any of the AnimatedModels in the same node changes its model.
     void FinalizeBoneBoundingBoxes();
-    /// Remove (old) skeleton root bone.
+    /// Remove (old) skeleton root bone, or all bone nodes when bone nodes are disabled.
     void RemoveRootBone();
+    /// Create the bone node hierarchy, reusing bone nodes that already exist.
+    void CreateBoneNodes();
+    /// Remove the bone nodes that have nothing attached, and parent the rest directly to the model's scene node. Called when bone nodes are disabled.
+    void RemoveUnusedBoneNodes();
+    /// Reset the bone pose arrays and calculate the bone evaluation order.
+    void InitializeBonePose();
+    /// Evaluate the model space bone transforms from the bone pose in one pass.
+    void UpdateBoneTransforms();
+    /// Copy the bone pose to the bone nodes that exist when bone nodes are disabled.
+    void UpdateBoneNodes();
+    /// Reset the animated bones of the bone pose to their initial transforms.
+    void ResetBonePose();
+    /// Look up the model space bone transforms from the model's pose cache, or evaluate and store them with quantized animation time positions and weights. Return false if the pose can not be shared.
+    bool ApplySharedAnimation();
     /// Mark animation and skinning to require an update.
     void MarkAnimationDirty();
     /// Mark animation and skinning to require a forced update (blending order changed).
@@ -235,6 +275,22 @@ private:
     Vector<PODVector<Matrix3x4> > geometrySkinMatrices_;
     /// Subgeometry skinning matrix pointers, if more bones than skinning shader can manage.
     Vector<PODVector<Matrix3x4*> > geometrySkinMatrixPtrs_;
+    /// Bone local positions, used when bone nodes are disabled.
+    PODVector<Vector3> bonePositions_;
+    /// Bone local rotations, used when bone nodes are disabled.
+    PODVector<Quaternion> boneRotations_;
+    /// Bone local scales, used when bone nodes are disabled.
+    PODVector<Vector3> boneScales_;
+    /// Bone model space transforms, used when bone nodes are disabled.
+    PODVector<Matrix3x4> boneTransforms_;
+    /// Bone parent indices, M_MAX_UNSIGNED for root bones.
+    PODVector<unsigned> boneParents_;
+    /// Bone evaluation order with parents before their children.
+    PODVector<unsigned> boneOrder_;
+    /// Master model bone indices of a non-master model's bones, used when the master model has bone nodes disabled.
+    PODVector<unsigned> masterBoneIndices_;
+    /// Key of the shared bone pose.
+    AnimationPoseKey poseKey_;
     /// Bounding box calculated from bones.
     BoundingBox boneBoundingBox_;
     /// Attribute buffer.
@@ -249,6 +305,8 @@ private:
     float animationLodTimer_;
     /// Animation LOD distance, the minimum of all LOD view distances last frame.
     float animationLodDistance_;
+    /// Time step to quantize the animation time positions to when sharing bone poses.
+    float poseSharingTimeStep_;
     /// Update animation when invisible flag.
     bool updateInvisible_;
     /// Animation dirty flag.
@@ -269,6 +327,12 @@ private:
     bool assignBonesPending_;
     /// Force animation update after becoming visible flag.
     bool forceAnimationUpdate_;
+    /// Bone nodes enabled flag.
+    bool boneNodesEnabled_;
+    /// Bone pose waiting to be copied to the bone nodes in the main thread flag.
+    bool boneNodesDirty_;
+    /// Pose sharing flag.
+    bool poseSharing_;
 };
 
 }
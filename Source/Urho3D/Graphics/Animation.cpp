@@ -30,15 +30,156 @@
 #include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../IO/Serializer.h"
+#include "../Math/BoundingBox.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/XMLFile.h"
 #include "../Resource/JSONFile.h"
 
+#include <atomic>
+
 #include "../DebugNew.h"
 
 namespace Urho3D
 {
 
+/// Range of the three smallest components of a normalized quaternion.
+static const float SMALLEST_THREE_RANGE = 0.70710678f;
+/// Maximum value of a 15-bit quantized rotation component. Even, so that zero is exactly representable.
+static const float ROTATION_QUANTIZE_MAX = 32766.0f;
+/// Maximum value of a 16-bit quantized position or scale component.
+static const float VECTOR_QUANTIZE_MAX = 65535.0f;
+/// Channels whose values differ less than these from the first keyframe are stored once.
+static const float CONSTANT_POSITION_THRESHOLD = 0.0001f;
+static const float CONSTANT_ROTATION_THRESHOLD = 0.00001f;
+static const float CONSTANT_SCALE_THRESHOLD = 0.0001f;
+
+/// Next animation data version. Animations may be loaded in worker threads.
+static std::atomic<unsigned> nextAnimationVersion(1);
+
+static void QuantizeRotation(Quaternion rotation, unsigned short* dest)
+{
+    rotation.Normalize();
+    const float* src = rotation.Data();
+
+    // Drop the largest component, and reconstruct it from the others when decoding. Negate the quaternion if needed to
+    // make the dropped component positive
+    unsigned largest = 0;
+    for (unsigned i = 1; i < 4; ++i)
+    {
+        if (Abs(src[i]) > Abs(src[largest]))
+            largest = i;
+    }
+    float sign = src[largest] < 0.0f ? -1.0f : 1.0f;
+
+    unsigned values[3];
+    for (unsigned i = 0, j = 0; i < 4; ++i)
+    {
+        if (i != largest)
+        {
+            float value = Clamp(src[i] * sign / SMALLEST_THREE_RANGE, -1.0f, 1.0f);
+            values[j++] = (unsigned)RoundToInt((value * 0.5f + 0.5f) * ROTATION_QUANTIZE_MAX);
+        }
+    }
+
+    // The index of the dropped component goes to the high bits of the first two values
+    dest[0] = (unsigned short)(values[0] | (largest & 1u) << 15u);
+    dest[1] = (unsigned short)(values[1] | (largest >> 1u) << 15u);
+    dest[2] = (unsigned short)values[2];
+}
+
+static Quaternion DequantizeRotation(const unsigned short* src)
+{
+    unsigned largest = (unsigned)(src[0] >> 15u) | (unsigned)(src[1] >> 15u) << 1u;
+    float values[4];
+    float sumSquares = 0.0f;
+
+    for (unsigned i = 0, j = 0; i < 4; ++i)
+    {
+        if (i != largest)
+        {
+            float value = ((src[j++] & 0x7fffu) / ROTATION_QUANTIZE_MAX * 2.0f - 1.0f) * SMALLEST_THREE_RANGE;
+            values[i] = value;
+            sumSquares += value * value;
+        }
+    }
+    values[largest] = sqrtf(Max(1.0f - sumSquares, 0.0f));
+
+    return Quaternion(values[0], values[1], values[2], values[3]);
+}
+
+static void QuantizeVector(const Vector3& value, const Vector3& min, const Vector3& range, unsigned short* dest)
+{
+    const float* src = value.Data();
+    const float* minData = min.Data();
+    const float* rangeData = range.Data();
+
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        float normalized = rangeData[i] > 0.0f ? Clamp((src[i] - minData[i]) / rangeData[i], 0.0f, 1.0f) : 0.0f;
+        dest[i] = (unsigned short)RoundToInt(normalized * VECTOR_QUANTIZE_MAX);
+    }
+}
+
+static Vector3 DequantizeVector(const unsigned short* src, const Vector3& min, const Vector3& range)
+{
+    return Vector3(min.x_ + range.x_ * (src[0] / VECTOR_QUANTIZE_MAX), min.y_ + range.y_ * (src[1] / VECTOR_QUANTIZE_MAX),
+        min.z_ + range.z_ * (src[2] / VECTOR_QUANTIZE_MAX));
+}
+
+static bool IsConstantVector(const Vector<AnimationKeyFrame>& keyFrames, Vector3 AnimationKeyFrame::* member, float threshold)
+{
+    const Vector3& first = keyFrames[0].*member;
+    for (unsigned i = 1; i < keyFrames.Size(); ++i)
+    {
+        Vector3 delta = keyFrames[i].*member - first;
+        if (Abs(delta.x_) > threshold || Abs(delta.y_) > threshold || Abs(delta.z_) > threshold)
+            return false;
+    }
+    return true;
+}
+
+static bool IsConstantRotation(const Vector<AnimationKeyFrame>& keyFrames)
+{
+    // Compare the components, as the dot product is imprecise for small angles. Account for the quaternion sign
+    Quaternion first = keyFrames[0].rotation_.Normalized();
+    for (unsigned i = 1; i < keyFrames.Size(); ++i)
+    {
+        Quaternion rotation = keyFrames[i].rotation_.Normalized();
+        if (first.DotProduct(rotation) < 0.0f)
+            rotation = -rotation;
+        Quaternion delta = rotation - first;
+        if (Abs(delta.w_) > CONSTANT_ROTATION_THRESHOLD || Abs(delta.x_) > CONSTANT_ROTATION_THRESHOLD ||
+            Abs(delta.y_) > CONSTANT_ROTATION_THRESHOLD || Abs(delta.z_) > CONSTANT_ROTATION_THRESHOLD)
+            return false;
+    }
+    return true;
+}
+
+static bool IsUniformlySpaced(const Vector<AnimationKeyFrame>& keyFrames, float length)
+{
+    float interval = length / (keyFrames.Size() - 1);
+    float threshold = interval * 0.001f;
+    for (unsigned i = 0; i < keyFrames.Size(); ++i)
+    {
+        if (Abs(keyFrames[i].time_ - i * interval) > threshold)
+            return false;
+    }
+    return true;
+}
+
+static void WriteQuantizedVectors(Serializer& dest, const PODVector<unsigned short>& values)
+{
+    if (!values.Empty())
+        dest.Write(&values[0], values.Size() * sizeof(unsigned short));
+}
+
+static void ReadQuantizedVectors(Deserializer& source, PODVector<unsigned short>& values, unsigned numSamples)
+{
+    values.Resize(numSamples * 3);
+    if (!values.Empty())
+        source.Read(&values[0], values.Size() * sizeof(unsigned short));
+}
+
 inline bool CompareTriggers(AnimationTriggerPoint& lhs, AnimationTriggerPoint& rhs)
 {
     return lhs.time_ < rhs.time_;
@@ -57,7 +198,14 @@ void AnimationTrack::SetKeyFrame(unsigned index, const AnimationKeyFrame& keyFra
         Urho3D::Sort(keyFrames_.Begin(), keyFrames_.End(), CompareKeyFrames);
     }
     else if (index == keyFrames_.Size())
+    {
         AddKeyFrame(keyFrame);
+        return;
+    }
+    else
+        return;
+
+    RenewOwnerVersion();
 }
 
 void AnimationTrack::AddKeyFrame(const AnimationKeyFrame& keyFrame)
@@ -66,22 +214,26 @@ void AnimationTrack::AddKeyFrame(const AnimationKeyFrame& keyFrame)
     keyFrames_.Push(keyFrame);
     if (needSort)
         Urho3D::Sort(keyFrames_.Begin(), keyFrames_.End(), CompareKeyFrames);
+    RenewOwnerVersion();
 }
 
 void AnimationTrack::InsertKeyFrame(unsigned index, const AnimationKeyFrame& keyFrame)
 {
     keyFrames_.Insert(index, keyFrame);
     Urho3D::Sort(keyFrames_.Begin(), keyFrames_.End(), CompareKeyFrames);
+    RenewOwnerVersion();
 }
 
 void AnimationTrack::RemoveKeyFrame(unsigned index)
 {
     keyFrames_.Erase(index);
+    RenewOwnerVersion();
 }
 
 void AnimationTrack::RemoveAllKeyFrames()
 {
     keyFrames_.Clear();
+    RenewOwnerVersion();
 }
 
 AnimationKeyFrame* AnimationTrack::GetKeyFrame(unsigned index)
@@ -111,9 +263,191 @@ bool AnimationTrack::GetKeyFrameIndex(float time, unsigned& index) const
     return true;
 }
 
+void AnimationTrack::Compress(float length, float sampleRate)
+{
+    if (keyFrames_.Empty())
+        return;
+
+    CompressedAnimationTrack compressed;
+
+    // Find the channels that change. A track with all channels constant needs only one sample
+    if ((channelMask_ & CHANNEL_POSITION) && !IsConstantVector(keyFrames_, &AnimationKeyFrame::position_, CONSTANT_POSITION_THRESHOLD))
+        compressed.animatedMask_ |= CHANNEL_POSITION;
+    if ((channelMask_ & CHANNEL_ROTATION) && !IsConstantRotation(keyFrames_))
+        compressed.animatedMask_ |= CHANNEL_ROTATION;
+    if ((channelMask_ & CHANNEL_SCALE) && !IsConstantVector(keyFrames_, &AnimationKeyFrame::scale_, CONSTANT_SCALE_THRESHOLD))
+        compressed.animatedMask_ |= CHANNEL_SCALE;
+
+    // Sample from time 0 to the last keyframe at even intervals, adjusting the rate slightly so that the last sample lands
+    // on the end. The rest of the animation length is not sampled, so that looped playback can still interpolate from the
+    // last keyframe back to the first
+    float end = Min(keyFrames_.Back().time_, length);
+    unsigned numSamples = 1;
+    if (compressed.animatedMask_ && end > 0.0f)
+    {
+        numSamples = Max((unsigned)CeilToInt(end * Max(sampleRate, M_EPSILON)), 1U) + 1;
+        // Keyframes that are evenly spaced at a lower rate can be used as they are
+        if (keyFrames_.Size() > 1 && keyFrames_.Size() < numSamples && IsUniformlySpaced(keyFrames_, end))
+            numSamples = keyFrames_.Size();
+    }
+    compressed.numSamples_ = numSamples;
+    compressed.sampleInterval_ = numSamples > 1 ? end / (numSamples - 1) : 0.0f;
+
+    Vector<AnimationKeyFrame> samples(numSamples);
+    for (unsigned i = 0; i < numSamples; ++i)
+        Sample(i * compressed.sampleInterval_, samples[i]);
+
+    // Constant channels keep the first keyframe's value, animated channels are quantized within their bounds
+    const AnimationKeyFrame& first = keyFrames_[0];
+    compressed.positionMin_ = first.position_;
+    compressed.rotation_ = first.rotation_.Normalized();
+    compressed.scaleMin_ = first.scale_;
+
+    if (compressed.animatedMask_ & CHANNEL_POSITION)
+    {
+        BoundingBox bounds;
+        for (unsigned i = 0; i < numSamples; ++i)
+            bounds.Merge(samples[i].position_);
+        compressed.positionMin_ = bounds.min_;
+        compressed.positionRange_ = bounds.Size();
+        compressed.positions_.Resize(numSamples * 3);
+        for (unsigned i = 0; i < numSamples; ++i)
+            QuantizeVector(samples[i].position_, compressed.positionMin_, compressed.positionRange_, &compressed.positions_[i * 3]);
+    }
+    if (compressed.animatedMask_ & CHANNEL_ROTATION)
+    {
+        compressed.rotations_.Resize(numSamples * 3);
+        for (unsigned i = 0; i < numSamples; ++i)
+            QuantizeRotation(samples[i].rotation_, &compressed.rotations_[i * 3]);
+    }
+    if (compressed.animatedMask_ & CHANNEL_SCALE)
+    {
+        BoundingBox bounds;
+        for (unsigned i = 0; i < numSamples; ++i)
+            bounds.Merge(samples[i].scale_);
+        compressed.scaleMin_ = bounds.min_;
+        compressed.scaleRange_ = bounds.Size();
+        compressed.scales_.Resize(numSamples * 3);
+        for (unsigned i = 0; i < numSamples; ++i)
+            QuantizeVector(samples[i].scale_, compressed.scaleMin_, compressed.scaleRange_, &compressed.scales_[i * 3]);
+    }
+
+    compressed_ = compressed;
+    keyFrames_.Clear();
+    RenewOwnerVersion();
+}
+
+void AnimationTrack::Decompress()
+{
+    if (!IsCompressed())
+        return;
+
+    keyFrames_.Resize(compressed_.numSamples_);
+    for (unsigned i = 0; i < compressed_.numSamples_; ++i)
+    {
+        keyFrames_[i].time_ = i * compressed_.sampleInterval_;
+        compressed_.GetSample(i, channelMask_, keyFrames_[i]);
+    }
+
+    compressed_ = CompressedAnimationTrack();
+    RenewOwnerVersion();
+}
+
+void AnimationTrack::RenewOwnerVersion()
+{
+    if (owner_)
+        owner_->RenewVersion();
+}
+
+bool AnimationTrack::Sample(float time, AnimationKeyFrame& dest, float loopLength) const
+{
+    time = Max(time, 0.0f);
+    dest.time_ = time;
+
+    if (IsCompressed())
+    {
+        unsigned index = 0;
+        unsigned nextIndex = 1;
+        float t = 0.0f;
+        if (compressed_.sampleInterval_ > 0.0f)
+        {
+            float position = time / compressed_.sampleInterval_;
+            index = Min((unsigned)position, compressed_.numSamples_ - 1);
+            nextIndex = index + 1;
+            t = Min(position - index, 1.0f);
+
+            // Interpolate back to the first sample over the rest of the loop
+            if (nextIndex == compressed_.numSamples_ && loopLength > 0.0f)
+            {
+                float end = index * compressed_.sampleInterval_;
+                nextIndex = 0;
+                t = loopLength > end ? Min((time - end) / (loopLength - end), 1.0f) : 0.0f;
+            }
+        }
+
+        compressed_.GetSample(index, channelMask_, dest);
+        if (nextIndex < compressed_.numSamples_ && t > 0.0f)
+        {
+            AnimationKeyFrame next;
+            compressed_.GetSample(nextIndex, channelMask_, next);
+            dest.position_ = dest.position_.Lerp(next.position_, t);
+            dest.rotation_ = dest.rotation_.Slerp(next.rotation_, t);
+            dest.scale_ = dest.scale_.Lerp(next.scale_, t);
+        }
+        dest.time_ = time;
+        return true;
+    }
+
+    unsigned index = 0;
+    if (!GetKeyFrameIndex(time, index))
+        return false;
+
+    const AnimationKeyFrame& keyFrame = keyFrames_[index];
+    dest.position_ = keyFrame.position_;
+    dest.rotation_ = keyFrame.rotation_;
+    dest.scale_ = keyFrame.scale_;
+
+    unsigned nextIndex = index + 1;
+    if (nextIndex == keyFrames_.Size() && loopLength > 0.0f)
+        nextIndex = 0;
+
+    if (nextIndex < keyFrames_.Size() && time > keyFrame.time_)
+    {
+        const AnimationKeyFrame& nextKeyFrame = keyFrames_[nextIndex];
+        float timeInterval = nextKeyFrame.time_ - keyFrame.time_;
+        if (timeInterval < 0.0f)
+            timeInterval += loopLength;
+        float t = timeInterval > 0.0f ? Min((time - keyFrame.time_) / timeInterval, 1.0f) : 1.0f;
+        dest.position_ = keyFrame.position_.Lerp(nextKeyFrame.position_, t);
+        dest.rotation_ = keyFrame.rotation_.Slerp(nextKeyFrame.rotation_, t);
+        dest.scale_ = keyFrame.scale_.Lerp(nextKeyFrame.scale_, t);
+    }
+
+    return true;
+}
+
+void CompressedAnimationTrack::GetSample(unsigned index, AnimationChannelFlags channelMask, AnimationKeyFrame& dest) const
+{
+    if (channelMask & CHANNEL_POSITION)
+    {
+        dest.position_ = (animatedMask_ & CHANNEL_POSITION) ? DequantizeVector(&positions_[index * 3], positionMin_,
+            positionRange_) : positionMin_;
+    }
+    if (channelMask & CHANNEL_ROTATION)
+        dest.rotation_ = (animatedMask_ & CHANNEL_ROTATION) ? DequantizeRotation(&rotations_[index * 3]) : rotation_;
+    if (channelMask & CHANNEL_SCALE)
+        dest.scale_ = (animatedMask_ & CHANNEL_SCALE) ? DequantizeVector(&scales_[index * 3], scaleMin_, scaleRange_) : scaleMin_;
+}
+
+unsigned CompressedAnimationTrack::GetMemoryUse() const
+{
+    return (positions_.Size() + rotations_.Size() + scales_.Size()) * sizeof(unsigned short);
+}
+
 Animation::Animation(Context* context) :
     ResourceWithMetadata(context),
-    length_(0.f)
+    length_(0.f),
+    version_(nextAnimationVersion.fetch_add(1, std::memory_order_relaxed))
 {
 }
 
@@ -129,12 +463,18 @@ bool Animation::BeginLoad(Deserializer& source)
     unsigned memoryUse = sizeof(Animation);
 
     // Check ID
-    if (source.ReadFileID() != "UANI")
+    String fileID = source.ReadFileID();
+    if (fileID != "UANI" && fileID != "UAN2")
     {
         URHO3D_LOGERROR(source.GetName() + " is not a valid animation file");
         return false;
     }
 
+    bool hasCompressedTracks = (fileID == "UAN2");
+
+    // The data of a reloaded animation is different, even though the object is the same
+    RenewVersion();
+
     // Read name and length
     animationName_ = source.ReadString();
     animationNameHash_ = animationName_;
@@ -150,6 +490,44 @@ bool Animation::BeginLoad(Deserializer& source)
         AnimationTrack* newTrack = CreateTrack(source.ReadString());
         newTrack->channelMask_ = AnimationChannelFlags(source.ReadUByte());
 
+        if (hasCompressedTracks && source.ReadBool())
+        {
+            CompressedAnimationTrack& compressed = newTrack->compressed_;
+            compressed.numSamples_ = source.ReadUInt();
+            compressed.sampleInterval_ = source.ReadFloat();
+            compressed.animatedMask_ = AnimationChannelFlags(source.ReadUByte()) & newTrack->channelMask_;
+            unsigned numSamples = compressed.numSamples_;
+
+            if (newTrack->channelMask_ & CHANNEL_POSITION)
+            {
+                compressed.positionMin_ = source.ReadVector3();
+                if (compressed.animatedMask_ & CHANNEL_POSITION)
+                {
+                    compressed.positionRange_ = source.ReadVector3();
+                    ReadQuantizedVectors(source, compressed.positions_, numSamples);
+                }
+            }
+            if (newTrack->channelMask_ & CHANNEL_ROTATION)
+            {
+                if (compressed.animatedMask_ & CHANNEL_ROTATION)
+                    ReadQuantizedVectors(source, compressed.rotations_, numSamples);
+                else
+                    compressed.rotation_ = source.ReadQuaternion();
+            }
+            if (newTrack->channelMask_ & CHANNEL_SCALE)
+            {
+                compressed.scaleMin_ = source.ReadVector3();
+                if (compressed.animatedMask_ & CHANNEL_SCALE)
+                {
+                    compressed.scaleRange_ = source.ReadVector3();
+                    ReadQuantizedVectors(source, compressed.scales_, numSamples);
+                }
+            }
+
+            memoryUse += compressed.GetMemoryUse();
+            continue;
+        }
+
         unsigned keyFrames = source.ReadUInt();
         newTrack->keyFrames_.Resize(keyFrames);
         memoryUse += keyFrames * sizeof(AnimationKeyFrame);
@@ -228,8 +606,19 @@ bool Animation::BeginLoad(Deserializer& source)
 
 bool Animation::Save(Serializer& dest) const
 {
+    // Use the old format when there are no compressed tracks
+    bool hasCompressedTracks = false;
+    for (HashMap<StringHash, AnimationTrack>::ConstIterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+    {
+        if (i->second_.IsCompressed())
+        {
+            hasCompressedTracks = true;
+            break;
+        }
+    }
+
     // Write ID, name and length
-    dest.WriteFileID("UANI");
+    dest.WriteFileID(hasCompressedTracks ? "UAN2" : "UANI");
     dest.WriteString(animationName_);
     dest.WriteFloat(length_);
 
@@ -240,6 +629,46 @@ bool Animation::Save(Serializer& dest) const
         const AnimationTrack& track = i->second_;
         dest.WriteString(track.name_);
         dest.WriteUByte(track.channelMask_);
+
+        if (hasCompressedTracks)
+        {
+            dest.WriteBool(track.IsCompressed());
+            if (track.IsCompressed())
+            {
+                const CompressedAnimationTrack& compressed = track.compressed_;
+                dest.WriteUInt(compressed.numSamples_);
+                dest.WriteFloat(compressed.sampleInterval_);
+                dest.WriteUByte(compressed.animatedMask_);
+
+                if (track.channelMask_ & CHANNEL_POSITION)
+                {
+                    dest.WriteVector3(compressed.positionMin_);
+                    if (compressed.animatedMask_ & CHANNEL_POSITION)
+                    {
+                        dest.WriteVector3(compressed.positionRange_);
+                        WriteQuantizedVectors(dest, compressed.positions_);
+                    }
+                }
+                if (track.channelMask_ & CHANNEL_ROTATION)
+                {
+                    if (compressed.animatedMask_ & CHANNEL_ROTATION)
+                        WriteQuantizedVectors(dest, compressed.rotations_);
+                    else
+                        dest.WriteQuaternion(compressed.rotation_);
+                }
+                if (track.channelMask_ & CHANNEL_SCALE)
+                {
+                    dest.WriteVector3(compressed.scaleMin_);
+                    if (compressed.animatedMask_ & CHANNEL_SCALE)
+                    {
+                        dest.WriteVector3(compressed.scaleRange_);
+                        WriteQuantizedVectors(dest, compressed.scales_);
+                    }
+                }
+                continue;
+            }
+        }
+
         dest.WriteUInt(track.keyFrames_.Size());
 
         // Write keyframes of the track
@@ -290,11 +719,13 @@ void Animation::SetAnimationName(const String& name)
 {
     animationName_ = name;
     animationNameHash_ = StringHash(name);
+    RenewVersion();
 }
 
 void Animation::SetLength(float length)
 {
     length_ = Max(length, 0.0f);
+    RenewVersion();
 }
 
 AnimationTrack* Animation::CreateTrack(const String& name)
@@ -308,6 +739,8 @@ AnimationTrack* Animation::CreateTrack(const String& name)
     AnimationTrack& newTrack = tracks_[nameHash];
     newTrack.name_ = name;
     newTrack.nameHash_ = nameHash;
+    newTrack.owner_ = this;
+    RenewVersion();
     return &newTrack;
 }
 
@@ -317,6 +750,7 @@ bool Animation::RemoveTrack(const String& name)
     if (i != tracks_.End())
     {
         tracks_.Erase(i);
+        RenewVersion();
         return true;
     }
     else
@@ -326,6 +760,7 @@ bool Animation::RemoveTrack(const String& name)
 void Animation::RemoveAllTracks()
 {
     tracks_.Clear();
+    RenewVersion();
 }
 
 void Animation::SetTrigger(unsigned index, const AnimationTriggerPoint& trigger)
@@ -379,6 +814,8 @@ SharedPtr<Animation> Animation::Clone(const String& cloneName) const
     ret->SetAnimationName(animationName_);
     ret->length_ = length_;
     ret->tracks_ = tracks_;
+    for (HashMap<StringHash, AnimationTrack>::Iterator i = ret->tracks_.Begin(); i != ret->tracks_.End(); ++i)
+        i->second_.owner_ = ret;
     ret->triggers_ = triggers_;
     ret->CopyMetadata(*this);
     ret->SetMemoryUse(GetMemoryUse());
@@ -386,6 +823,100 @@ SharedPtr<Animation> Animation::Clone(const String& cloneName) const
     return ret;
 }
 
+AnimationCompressionReport Animation::Compress(float sampleRate)
+{
+    AnimationCompressionReport report;
+    PODVector<float> times;
+
+    for (HashMap<StringHash, AnimationTrack>::Iterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+    {
+        AnimationTrack& track = i->second_;
+        if (track.IsCompressed())
+        {
+            report.originalSize_ += track.compressed_.GetMemoryUse();
+            report.compressedSize_ += track.compressed_.GetMemoryUse();
+            continue;
+        }
+        if (track.keyFrames_.Empty())
+            continue;
+
+        AnimationTrack original(track);
+        track.Compress(length_, sampleRate);
+        report.originalSize_ += original.keyFrames_.Size() * sizeof(AnimationKeyFrame);
+        report.compressedSize_ += track.compressed_.GetMemoryUse();
+
+        // Measure the errors at the original keyframes, and halfway between the samples where the interpolation
+        // error is largest. Also measure halfway between the last sample and the end as in looped playback, where
+        // the track interpolates back to the start
+        times.Clear();
+        for (unsigned j = 0; j < original.keyFrames_.Size(); ++j)
+        {
+            if (original.keyFrames_[j].time_ <= length_)
+                times.Push(original.keyFrames_[j].time_);
+        }
+        for (unsigned j = 0; j + 1 < track.compressed_.numSamples_; ++j)
+            times.Push((j + 0.5f) * track.compressed_.sampleInterval_);
+        float end = (track.compressed_.numSamples_ - 1) * track.compressed_.sampleInterval_;
+        if (end < length_)
+            times.Push((end + length_) * 0.5f);
+
+        for (unsigned j = 0; j < times.Size(); ++j)
+        {
+            AnimationKeyFrame expected;
+            AnimationKeyFrame actual;
+            original.Sample(times[j], expected, length_);
+            track.Sample(times[j], actual, length_);
+
+            if (track.channelMask_ & CHANNEL_POSITION)
+                report.maxPositionError_ = Max(report.maxPositionError_, (actual.position_ - expected.position_).Length());
+            if (track.channelMask_ & CHANNEL_ROTATION)
+            {
+                // Use the chord length between the quaternions, as the arc cosine of the dot product is imprecise for
+                // small angles
+                Quaternion actualRotation = actual.rotation_.Normalized();
+                Quaternion expectedRotation = expected.rotation_.Normalized();
+                float chord = Min((actualRotation - expectedRotation).LengthSquared(),
+                    (actualRotation + expectedRotation).LengthSquared());
+                float rotationError = 4.0f * Asin(Min(sqrtf(chord) * 0.5f, 1.0f));
+                if (rotationError > report.maxRotationError_)
+                {
+                    report.maxRotationError_ = rotationError;
+                    report.maxRotationErrorTrack_ = track.name_;
+                }
+            }
+            if (track.channelMask_ & CHANNEL_SCALE)
+            {
+                Vector3 delta = (actual.scale_ - expected.scale_).Abs();
+                report.maxScaleError_ = Max(report.maxScaleError_, Max(delta.x_, Max(delta.y_, delta.z_)));
+            }
+        }
+    }
+
+    unsigned memoryUse = GetMemoryUse();
+    SetMemoryUse(memoryUse > report.originalSize_ ? memoryUse - report.originalSize_ + report.compressedSize_ :
+        report.compressedSize_);
+    return report;
+}
+
+void Animation::Decompress()
+{
+    unsigned memoryUse = GetMemoryUse();
+
+    for (HashMap<StringHash, AnimationTrack>::Iterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+    {
+        AnimationTrack& track = i->second_;
+        if (!track.IsCompressed())
+            continue;
+
+        unsigned compressedSize = track.compressed_.GetMemoryUse();
+        track.Decompress();
+        memoryUse = (memoryUse > compressedSize ? memoryUse - compressedSize : 0) + track.keyFrames_.Size() *
+            sizeof(AnimationKeyFrame);
+    }
+
+    SetMemoryUse(memoryUse);
+}
+
 AnimationTrack* Animation::GetTrack(unsigned index)
 {
     if (index >= GetNumTracks())
@@ -415,6 +946,11 @@ AnimationTrack* Animation::GetTrack(StringHash nameHash)
     return i != tracks_.End() ? &i->second_ : nullptr;
 }
 
+void Animation::RenewVersion()
+{
+    version_ = nextAnimationVersion.fetch_add(1, std::memory_order_relaxed);
+}
+
 AnimationTriggerPoint* Animation::GetTrigger(unsigned index)
 {
     return index < triggers_.Size() ? &triggers_[index] : nullptr;
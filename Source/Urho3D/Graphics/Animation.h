@@ -33,6 +33,8 @@
 namespace Urho3D
 {
 
+class Animation;
+
 enum AnimationChannel : unsigned char
 {
     CHANNEL_NONE = 0x0,
@@ -42,6 +44,9 @@ enum AnimationChannel : unsigned char
 };
 URHO3D_FLAGSET(AnimationChannel, AnimationChannelFlags);
 
+/// Default sample rate of compressed animation tracks in samples per second.
+static const float DEFAULT_ANIMATION_SAMPLE_RATE = 30.0f;
+
 /// Skeletal animation keyframe.
 struct AnimationKeyFrame
 {
@@ -62,6 +67,47 @@ struct AnimationKeyFrame
     Vector3 scale_;
 };
 
+/// Compressed skeletal animation track data. Uniformly sampled: constant channels are stored once, positions and scales are quantized to 16 bits relative to the track bounds, and rotations to 48 bits with the smallest three components.
+struct URHO3D_API CompressedAnimationTrack
+{
+    /// Construct.
+    CompressedAnimationTrack() :
+        numSamples_(0),
+        sampleInterval_(0.0f),
+        rotation_(Quaternion::IDENTITY),
+        scaleMin_(Vector3::ONE)
+    {
+    }
+
+    /// Decode a sample. Only the channels in the mask are written.
+    void GetSample(unsigned index, AnimationChannelFlags channelMask, AnimationKeyFrame& dest) const;
+    /// Return memory use in bytes, excluding the structure itself.
+    unsigned GetMemoryUse() const;
+
+    /// Number of samples.
+    unsigned numSamples_;
+    /// Time between samples.
+    float sampleInterval_;
+    /// Bitmask of the channels that change between samples. The other channels are constant.
+    AnimationChannelFlags animatedMask_{};
+    /// Position bounds minimum, or the constant position.
+    Vector3 positionMin_;
+    /// Position bounds size.
+    Vector3 positionRange_;
+    /// Constant rotation.
+    Quaternion rotation_;
+    /// Scale bounds minimum, or the constant scale.
+    Vector3 scaleMin_;
+    /// Scale bounds size.
+    Vector3 scaleRange_;
+    /// Quantized positions, three values per sample.
+    PODVector<unsigned short> positions_;
+    /// Quantized rotations, three values per sample.
+    PODVector<unsigned short> rotations_;
+    /// Quantized scales, three values per sample.
+    PODVector<unsigned short> scales_;
+};
+
 /// Skeletal animation track, stores keyframes of a single bone.
 /// @fakeref
 struct URHO3D_API AnimationTrack
@@ -90,6 +136,19 @@ struct URHO3D_API AnimationTrack
     unsigned GetNumKeyFrames() const { return keyFrames_.Size(); }
     /// Return keyframe index based on time and previous index. Return false if animation is empty.
     bool GetKeyFrameIndex(float time, unsigned& index) const;
+    /// Resample the keyframes uniformly from time 0 to the last keyframe, or the animation length if shorter, and quantize them. The keyframes are removed. As with keyframes, time positions past the last sample hold it, or in looped playback interpolate back to the first sample at the animation length.
+    void Compress(float length, float sampleRate = DEFAULT_ANIMATION_SAMPLE_RATE);
+    /// Convert compressed data back to keyframes, one per sample.
+    void Decompress();
+    /// Return the interpolated transform at a time position. Time positions outside the keyframes are clamped, unless a loop length is given, in which case time positions past the last keyframe interpolate back to the first keyframe as in looped playback. Return false if the track is empty.
+    bool Sample(float time, AnimationKeyFrame& dest, float loopLength = 0.0f) const;
+
+    /// Return whether the track is compressed.
+    /// @property
+    bool IsCompressed() const { return compressed_.numSamples_ != 0; }
+
+    /// Return whether the track has no keyframes or compressed samples.
+    bool IsEmpty() const { return keyFrames_.Empty() && !compressed_.numSamples_; }
 
     /// Bone or scene node name.
     String name_;
@@ -99,6 +158,14 @@ struct URHO3D_API AnimationTrack
     AnimationChannelFlags channelMask_{};
     /// Keyframes.
     Vector<AnimationKeyFrame> keyFrames_;
+    /// Compressed data, used instead of the keyframes when compressed.
+    CompressedAnimationTrack compressed_;
+    /// Animation that owns the track. Its data version is renewed when the keyframes are modified through the functions above.
+    WeakPtr<Animation> owner_;
+
+private:
+    /// Renew the data version of the owner animation.
+    void RenewOwnerVersion();
 };
 
 /// %Animation trigger point.
@@ -116,6 +183,23 @@ struct AnimationTriggerPoint
     Variant data_;
 };
 
+/// Result of compressing an animation.
+struct AnimationCompressionReport
+{
+    /// Maximum position error.
+    float maxPositionError_{};
+    /// Maximum rotation error in degrees.
+    float maxRotationError_{};
+    /// Maximum scale error.
+    float maxScaleError_{};
+    /// Name of the track with the largest rotation error.
+    String maxRotationErrorTrack_;
+    /// Keyframe data size in bytes before compression.
+    unsigned originalSize_{};
+    /// Keyframe data size in bytes after compression.
+    unsigned compressedSize_{};
+};
+
 /// Skeletal animation resource.
 class URHO3D_API Animation : public ResourceWithMetadata
 {
@@ -162,6 +246,10 @@ public:
     void SetNumTriggers(unsigned num);
     /// Clone the animation.
     SharedPtr<Animation> Clone(const String& cloneName = String::EMPTY) const;
+    /// Compress all tracks and return the errors introduced, measured at the original keyframes and between the samples. Compressed animations are saved in the UAN2 format. This is unsafe if the animation is currently used in playback.
+    AnimationCompressionReport Compress(float sampleRate = DEFAULT_ANIMATION_SAMPLE_RATE);
+    /// Convert all compressed tracks back to keyframes. This is unsafe if the animation is currently used in playback.
+    void Decompress();
 
     /// Return animation name.
     /// @property
@@ -200,6 +288,12 @@ public:
     /// Return a trigger point by index.
     AnimationTriggerPoint* GetTrigger(unsigned index);
 
+    /// Renew the data version. Called by the functions that modify the animation or its tracks. Call manually after modifying the keyframes or compressed data of a track directly.
+    void RenewVersion();
+
+    /// Return data version. Unique among the animations, and changed when the animation is loaded again or modified, so that it identifies the animation data unlike the object address, which may be reused.
+    unsigned GetVersion() const { return version_; }
+
 private:
     /// Animation name.
     String animationName_;
@@ -211,6 +305,8 @@ private:
     HashMap<StringHash, AnimationTrack> tracks_;
     /// Animation trigger points.
     Vector<AnimationTriggerPoint> triggers_;
+    /// Data version.
+    unsigned version_;
 };
 
 }
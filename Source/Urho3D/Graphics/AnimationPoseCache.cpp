@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Graphics/AnimationPoseCache.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned DEFAULT_MAX_POSES = 1024;
+
+AnimationPoseCache::AnimationPoseCache() :
+    clockHand_(poses_.End()),
+    maxPoses_(DEFAULT_MAX_POSES),
+    numHits_(0),
+    numMisses_(0)
+{
+}
+
+AnimationPoseCache::~AnimationPoseCache() = default;
+
+bool AnimationPoseCache::GetPose(const AnimationPoseKey& key, PODVector<Matrix3x4>& dest)
+{
+    MutexLock lock(mutex_);
+
+    HashMap<AnimationPoseKey, AnimationPoseCacheEntry>::Iterator i = poses_.Find(key);
+    if (i == poses_.End() || i->second_.pose_.Size() != dest.Size())
+    {
+        ++numMisses_;
+        return false;
+    }
+
+    ++numHits_;
+    i->second_.referenced_ = true;
+    dest = i->second_.pose_;
+    return true;
+}
+
+void AnimationPoseCache::StorePose(const AnimationPoseKey& key, const PODVector<Matrix3x4>& pose)
+{
+    MutexLock lock(mutex_);
+
+    HashMap<AnimationPoseKey, AnimationPoseCacheEntry>::Iterator i = poses_.Find(key);
+    if (i == poses_.End())
+    {
+        if (poses_.Size() >= maxPoses_)
+            EvictPose();
+        i = poses_.Insert(MakePair(key, AnimationPoseCacheEntry()));
+    }
+
+    i->second_.pose_ = pose;
+}
+
+void AnimationPoseCache::Clear()
+{
+    MutexLock lock(mutex_);
+    poses_.Clear();
+    clockHand_ = poses_.End();
+}
+
+void AnimationPoseCache::SetMaxPoses(unsigned num)
+{
+    MutexLock lock(mutex_);
+    maxPoses_ = Max(num, 1U);
+    while (poses_.Size() > maxPoses_)
+        EvictPose();
+}
+
+void AnimationPoseCache::ResetStats()
+{
+    MutexLock lock(mutex_);
+    numHits_ = 0;
+    numMisses_ = 0;
+}
+
+void AnimationPoseCache::EvictPose()
+{
+    // Second chance: clear the used flags while sweeping, so the loop ends at the latest after one full round
+    for (;;)
+    {
+        if (clockHand_ == poses_.End())
+            clockHand_ = poses_.Begin();
+
+        if (!clockHand_->second_.referenced_)
+        {
+            clockHand_ = poses_.Erase(clockHand_);
+            return;
+        }
+
+        clockHand_->second_.referenced_ = false;
+        ++clockHand_;
+    }
+}
+
+}
@@ -0,0 +1,130 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Container/RefCounted.h"
+#include "../Core/Mutex.h"
+#include "../Math/Matrix3x4.h"
+
+namespace Urho3D
+{
+
+/// Key of a shared animation pose. Built from the animation states that produce the pose and their quantized time positions and weights.
+struct URHO3D_API AnimationPoseKey
+{
+    /// Construct empty.
+    AnimationPoseKey() :
+        hash_(0)
+    {
+    }
+
+    /// Clear the key.
+    void Clear()
+    {
+        data_.Clear();
+        hash_ = 0;
+    }
+
+    /// Append a value.
+    void Add(unsigned value)
+    {
+        data_.Push(value);
+        hash_ = (hash_ ^ value) * 16777619u + (hash_ >> 7);
+    }
+
+    /// Test for equality with another key.
+    bool operator ==(const AnimationPoseKey& rhs) const { return hash_ == rhs.hash_ && data_ == rhs.data_; }
+
+    /// Test for inequality with another key.
+    bool operator !=(const AnimationPoseKey& rhs) const { return !(*this == rhs); }
+
+    /// Return hash value for HashSet & HashMap.
+    unsigned ToHash() const { return hash_; }
+
+    /// Key data.
+    PODVector<unsigned> data_;
+    /// Hash value.
+    unsigned hash_;
+};
+
+/// Cached animation pose.
+struct AnimationPoseCacheEntry
+{
+    /// Model space bone transforms.
+    PODVector<Matrix3x4> pose_;
+    /// Used since the eviction clock hand last passed the entry.
+    bool referenced_{};
+};
+
+/// Cache of evaluated model space bone poses, shared by the AnimatedModels that use the same model and play the same animation states. Thread-safe.
+class URHO3D_API AnimationPoseCache : public RefCounted
+{
+public:
+    /// Construct.
+    AnimationPoseCache();
+    /// Destruct.
+    ~AnimationPoseCache() override;
+
+    /// Copy a cached pose to the destination. Return true if found.
+    bool GetPose(const AnimationPoseKey& key, PODVector<Matrix3x4>& dest);
+    /// Store a pose. If the cache already holds the maximum number of poses, a pose not used recently is evicted first.
+    void StorePose(const AnimationPoseKey& key, const PODVector<Matrix3x4>& pose);
+    /// Remove all poses.
+    void Clear();
+    /// Set maximum number of poses to hold. Default 1024.
+    void SetMaxPoses(unsigned num);
+    /// Reset the hit and miss counters.
+    void ResetStats();
+
+    /// Return maximum number of poses to hold.
+    unsigned GetMaxPoses() const { return maxPoses_; }
+
+    /// Return number of poses held.
+    unsigned GetNumPoses() const { return poses_.Size(); }
+
+    /// Return number of poses found since the counters were reset.
+    unsigned GetNumHits() const { return numHits_; }
+
+    /// Return number of poses not found since the counters were reset.
+    unsigned GetNumMisses() const { return numMisses_; }
+
+private:
+    /// Remove a pose not used since the clock hand last passed it. Called with the mutex held.
+    void EvictPose();
+
+    /// Poses by key, in insertion order.
+    HashMap<AnimationPoseKey, AnimationPoseCacheEntry> poses_;
+    /// Eviction clock hand.
+    HashMap<AnimationPoseKey, AnimationPoseCacheEntry>::Iterator clockHand_;
+    /// Mutex for the poses and counters.
+    Mutex mutex_;
+    /// Maximum number of poses.
+    unsigned maxPoses_;
+    /// Number of poses found.
+    unsigned numHits_;
+    /// Number of poses not found.
+    unsigned numMisses_;
+};
+
+}
@@ -28,6 +28,10 @@
 #include "../Graphics/DrawableEvents.h"
 #include "../IO/Log.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -36,6 +40,7 @@ namespace Urho3D
 AnimationStateTrack::AnimationStateTrack() :
     track_(nullptr),
     bone_(nullptr),
+    boneIndex_(M_MAX_UNSIGNED),
     weight_(1.0f),
     keyFrame_(0)
 {
@@ -43,6 +48,203 @@ AnimationStateTrack::AnimationStateTrack() :
 
 AnimationStateTrack::~AnimationStateTrack() = default;
 
+#ifdef URHO3D_SSE
+/// Sampled key frame pair of a lerp-blended track, gathered for the SIMD blending kernel.
+struct TrackSample
+{
+    /// Decoded key frames of a compressed track.
+    AnimationKeyFrame decoded_[2];
+    /// Key frame to interpolate from.
+    const AnimationKeyFrame* keyFrame_;
+    /// Key frame to interpolate to.
+    const AnimationKeyFrame* nextKeyFrame_;
+    /// Interpolation factor.
+    float t_;
+    /// Blending weight.
+    float weight_;
+    /// Bone index in the model's bone pose.
+    unsigned boneIndex_;
+    /// Channels to write.
+    AnimationChannelFlags channelMask_;
+};
+
+/// Number of tracks blended at once by the SIMD kernel.
+static const unsigned NUM_SIMD_TRACKS = 4;
+
+static inline __m128 SelectSIMD(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/// Return sine of angles in the range [0, pi/2]. Uses the Taylor series up to x^11.
+static inline __m128 SinSIMD(__m128 x)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128 x2 = _mm_mul_ps(x, x);
+    __m128 r = _mm_sub_ps(one, _mm_mul_ps(x2, _mm_set1_ps(1.0f / 110.0f)));
+    r = _mm_sub_ps(one, _mm_mul_ps(_mm_mul_ps(x2, _mm_set1_ps(1.0f / 72.0f)), r));
+    r = _mm_sub_ps(one, _mm_mul_ps(_mm_mul_ps(x2, _mm_set1_ps(1.0f / 42.0f)), r));
+    r = _mm_sub_ps(one, _mm_mul_ps(_mm_mul_ps(x2, _mm_set1_ps(1.0f / 20.0f)), r));
+    r = _mm_sub_ps(one, _mm_mul_ps(_mm_mul_ps(x2, _mm_set1_ps(1.0f / 6.0f)), r));
+    return _mm_mul_ps(x, r);
+}
+
+/// Return arc cosine of values in the range [0, 1]. Uses the Abramowitz & Stegun polynomial approximation 4.4.46.
+static inline __m128 AcosSIMD(__m128 x)
+{
+    __m128 r = _mm_set1_ps(-0.0012624911f);
+    r = _mm_add_ps(_mm_mul_ps(r, x), _mm_set1_ps(0.0066700901f));
+    r = _mm_add_ps(_mm_mul_ps(r, x), _mm_set1_ps(-0.0170881256f));
+    r = _mm_add_ps(_mm_mul_ps(r, x), _mm_set1_ps(0.0308918810f));
+    r = _mm_add_ps(_mm_mul_ps(r, x), _mm_set1_ps(-0.0501743046f));
+    r = _mm_add_ps(_mm_mul_ps(r, x), _mm_set1_ps(0.0889789874f));
+    r = _mm_add_ps(_mm_mul_ps(r, x), _mm_set1_ps(-0.2145988016f));
+    r = _mm_add_ps(_mm_mul_ps(r, x), _mm_set1_ps(1.5707963050f));
+    return _mm_mul_ps(_mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.0f), x), _mm_setzero_ps())), r);
+}
+
+/// Spherical interpolation of four quaternions at once, given as w, x, y, z component registers. Matches Quaternion::Slerp().
+static inline void SlerpSIMD(const __m128* a, const __m128* b, __m128 t, __m128* result)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+
+    __m128 cosAngle = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], b[0]), _mm_mul_ps(a[1], b[1])),
+        _mm_add_ps(_mm_mul_ps(a[2], b[2]), _mm_mul_ps(a[3], b[3])));
+    // Enable shortest path rotation: take the absolute value, and flip the sign of the second quaternion's factor
+    __m128 sign = _mm_and_ps(cosAngle, signMask);
+    cosAngle = _mm_min_ps(_mm_xor_ps(cosAngle, sign), one);
+
+    __m128 angle = AcosSIMD(cosAngle);
+    __m128 sinAngle = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(one, _mm_mul_ps(cosAngle, cosAngle)), _mm_setzero_ps()));
+    __m128 useSlerp = _mm_cmpgt_ps(sinAngle, _mm_set1_ps(0.001f));
+    __m128 invSinAngle = _mm_div_ps(one, _mm_max_ps(sinAngle, _mm_set1_ps(0.001f)));
+
+    __m128 invT = _mm_sub_ps(one, t);
+    __m128 t1 = SelectSIMD(useSlerp, _mm_mul_ps(SinSIMD(_mm_mul_ps(invT, angle)), invSinAngle), invT);
+    __m128 t2 = SelectSIMD(useSlerp, _mm_mul_ps(SinSIMD(_mm_mul_ps(t, angle)), invSinAngle), t);
+    t2 = _mm_xor_ps(t2, sign);
+
+    for (unsigned i = 0; i < 4; ++i)
+        result[i] = _mm_add_ps(_mm_mul_ps(a[i], t1), _mm_mul_ps(b[i], t2));
+}
+
+/// Linear interpolation of four vectors at once, given as x, y, z component registers.
+static inline void LerpSIMD(const __m128* a, const __m128* b, __m128 t, __m128* result)
+{
+    __m128 invT = _mm_sub_ps(_mm_set1_ps(1.0f), t);
+    for (unsigned i = 0; i < 3; ++i)
+        result[i] = _mm_add_ps(_mm_mul_ps(a[i], invT), _mm_mul_ps(b[i], t));
+}
+
+/// Load four vectors as x, y, z component registers.
+static inline void LoadVectorsSIMD(const Vector3* v0, const Vector3* v1, const Vector3* v2, const Vector3* v3, __m128* result)
+{
+    result[0] = _mm_set_ps(v3->x_, v2->x_, v1->x_, v0->x_);
+    result[1] = _mm_set_ps(v3->y_, v2->y_, v1->y_, v0->y_);
+    result[2] = _mm_set_ps(v3->z_, v2->z_, v1->z_, v0->z_);
+}
+
+/// Interpolate up to four lerp-blended tracks and blend them into the bone pose.
+static void BlendTrackSamples(const TrackSample* samples, unsigned numSamples, Vector3* positions, Quaternion* rotations,
+    Vector3* scales)
+{
+    // Pad the unused lanes with the first sample. Their results are not written
+    const TrackSample* lane[NUM_SIMD_TRACKS];
+    for (unsigned i = 0; i < NUM_SIMD_TRACKS; ++i)
+        lane[i] = &samples[i < numSamples ? i : 0];
+
+    __m128 t = _mm_set_ps(lane[3]->t_, lane[2]->t_, lane[1]->t_, lane[0]->t_);
+    __m128 weight = _mm_set_ps(lane[3]->weight_, lane[2]->weight_, lane[1]->weight_, lane[0]->weight_);
+
+    // Rotations: transpose to one register per component, slerp between the key frames, then slerp from the current pose
+    __m128 keyRotations[4];
+    __m128 nextRotations[4];
+    __m128 poseRotations[4];
+    for (unsigned i = 0; i < NUM_SIMD_TRACKS; ++i)
+    {
+        keyRotations[i] = _mm_loadu_ps(&lane[i]->keyFrame_->rotation_.w_);
+        nextRotations[i] = _mm_loadu_ps(&lane[i]->nextKeyFrame_->rotation_.w_);
+        poseRotations[i] = _mm_loadu_ps(&rotations[lane[i]->boneIndex_].w_);
+    }
+    _MM_TRANSPOSE4_PS(keyRotations[0], keyRotations[1], keyRotations[2], keyRotations[3]);
+    _MM_TRANSPOSE4_PS(nextRotations[0], nextRotations[1], nextRotations[2], nextRotations[3]);
+    _MM_TRANSPOSE4_PS(poseRotations[0], poseRotations[1], poseRotations[2], poseRotations[3]);
+
+    __m128 newRotations[4];
+    __m128 blendedRotations[4];
+    SlerpSIMD(keyRotations, nextRotations, t, newRotations);
+    SlerpSIMD(poseRotations, newRotations, weight, blendedRotations);
+    _MM_TRANSPOSE4_PS(newRotations[0], newRotations[1], newRotations[2], newRotations[3]);
+    _MM_TRANSPOSE4_PS(blendedRotations[0], blendedRotations[1], blendedRotations[2], blendedRotations[3]);
+
+    // Positions and scales: lerp between the key frames, then lerp from the current pose
+    __m128 keyVectors[3];
+    __m128 nextVectors[3];
+    __m128 poseVectors[3];
+    __m128 newVectors[3];
+    float newPositions[3][NUM_SIMD_TRACKS];
+    float newScales[3][NUM_SIMD_TRACKS];
+
+    LoadVectorsSIMD(&lane[0]->keyFrame_->position_, &lane[1]->keyFrame_->position_, &lane[2]->keyFrame_->position_,
+        &lane[3]->keyFrame_->position_, keyVectors);
+    LoadVectorsSIMD(&lane[0]->nextKeyFrame_->position_, &lane[1]->nextKeyFrame_->position_,
+        &lane[2]->nextKeyFrame_->position_, &lane[3]->nextKeyFrame_->position_, nextVectors);
+    LoadVectorsSIMD(&positions[lane[0]->boneIndex_], &positions[lane[1]->boneIndex_], &positions[lane[2]->boneIndex_],
+        &positions[lane[3]->boneIndex_], poseVectors);
+    LerpSIMD(keyVectors, nextVectors, t, newVectors);
+    LerpSIMD(poseVectors, newVectors, weight, newVectors);
+    for (unsigned i = 0; i < 3; ++i)
+        _mm_storeu_ps(newPositions[i], newVectors[i]);
+
+    LoadVectorsSIMD(&lane[0]->keyFrame_->scale_, &lane[1]->keyFrame_->scale_, &lane[2]->keyFrame_->scale_,
+        &lane[3]->keyFrame_->scale_, keyVectors);
+    LoadVectorsSIMD(&lane[0]->nextKeyFrame_->scale_, &lane[1]->nextKeyFrame_->scale_, &lane[2]->nextKeyFrame_->scale_,
+        &lane[3]->nextKeyFrame_->scale_, nextVectors);
+    LoadVectorsSIMD(&scales[lane[0]->boneIndex_], &scales[lane[1]->boneIndex_], &scales[lane[2]->boneIndex_],
+        &scales[lane[3]->boneIndex_], poseVectors);
+    LerpSIMD(keyVectors, nextVectors, t, newVectors);
+    LerpSIMD(poseVectors, newVectors, weight, newVectors);
+    for (unsigned i = 0; i < 3; ++i)
+        _mm_storeu_ps(newScales[i], newVectors[i]);
+
+    // Scatter the channels that each track contains
+    for (unsigned i = 0; i < numSamples; ++i)
+    {
+        const TrackSample& sample = samples[i];
+        unsigned index = sample.boneIndex_;
+
+        if (sample.channelMask_ & CHANNEL_POSITION)
+            positions[index] = Vector3(newPositions[0][i], newPositions[1][i], newPositions[2][i]);
+        if (sample.channelMask_ & CHANNEL_ROTATION)
+        {
+            // At full weight the pose slerp is skipped, as it could flip the sign of the quaternion
+            _mm_storeu_ps(&rotations[index].w_, Equals(sample.weight_, 1.0f) ? newRotations[i] : blendedRotations[i]);
+        }
+        if (sample.channelMask_ & CHANNEL_SCALE)
+            scales[index] = Vector3(newScales[0][i], newScales[1][i], newScales[2][i]);
+    }
+}
+#endif
+
+static bool IsChildBone(const Skeleton& skeleton, unsigned index, unsigned ancestorIndex)
+{
+    const Vector<Bone>& bones = skeleton.GetBones();
+
+    // Walk up the parent indices. Limit the steps in case the hierarchy is malformed
+    for (unsigned steps = 0; index < bones.Size() && steps < bones.Size(); ++steps)
+    {
+        unsigned parentIndex = bones[index].parentIndex_;
+        if (parentIndex == ancestorIndex)
+            return true;
+        if (parentIndex == index)
+            return false;
+        index = parentIndex;
+    }
+
+    return false;
+}
+
 AnimationState::AnimationState(AnimatedModel* model, Animation* animation) :
     model_(model),
     animation_(animation),
@@ -51,7 +253,8 @@ AnimationState::AnimationState(AnimatedModel* model, Animation* animation) :
     weight_(0.0f),
     time_(0.0f),
     layer_(0),
-    blendingMode_(ABM_LERP)
+    blendingMode_(ABM_LERP),
+    boneNodes_(true)
 {
     // Set default start bone (use all tracks)
     SetStartBone(nullptr);
@@ -65,7 +268,8 @@ AnimationState::AnimationState(Node* node, Animation* animation) :
     weight_(1.0f),
     time_(0.0f),
     layer_(0),
-    blendingMode_(ABM_LERP)
+    blendingMode_(ABM_LERP),
+    boneNodes_(true)
 {
     if (animation_)
     {
@@ -117,17 +321,21 @@ void AnimationState::SetStartBone(Bone* startBone)
     }
 
     // Do not reassign if the start bone did not actually change, and we already have valid bone nodes
-    if (startBone == startBone_ && !stateTracks_.Empty())
+    bool boneNodes = model_->GetBoneNodesEnabled();
+    if (startBone == startBone_ && !stateTracks_.Empty() && boneNodes == boneNodes_)
         return;
 
     startBone_ = startBone;
+    boneNodes_ = boneNodes;
 
     const HashMap<StringHash, AnimationTrack>& tracks = animation_->GetTracks();
     stateTracks_.Clear();
 
-    if (!startBone->node_)
+    if (boneNodes && !startBone->node_)
         return;
 
+    unsigned startBoneIndex = skeleton.GetBoneIndex(startBone);
+
     for (HashMap<StringHash, AnimationTrack>::ConstIterator i = tracks.Begin(); i != tracks.End(); ++i)
     {
         AnimationStateTrack stateTrack;
@@ -139,17 +347,25 @@ void AnimationState::SetStartBone(Bone* startBone)
 
         if (nameHash == startBone->nameHash_)
             trackBone = startBone;
-        else
+        else if (boneNodes)
         {
             Node* trackBoneNode = startBone->node_->GetChild(nameHash, true);
             if (trackBoneNode)
                 trackBone = skeleton.GetBone(nameHash);
         }
+        else
+        {
+            // Without bone nodes, check the hierarchy from the skeleton
+            Bone* bone = skeleton.GetBone(nameHash);
+            if (bone && IsChildBone(skeleton, skeleton.GetBoneIndex(bone), startBoneIndex))
+                trackBone = bone;
+        }
 
-        if (trackBone && trackBone->node_)
+        if (trackBone && (trackBone->node_ || !boneNodes))
         {
             stateTrack.bone_ = trackBone;
             stateTrack.node_ = trackBone->node_;
+            stateTrack.boneIndex_ = skeleton.GetBoneIndex(trackBone);
             stateTracks_.Push(stateTrack);
         }
     }
@@ -218,6 +434,19 @@ void AnimationState::SetBoneWeight(unsigned index, float weight, bool recursive)
 
     if (recursive)
     {
+        // Without bone nodes, find the child bones from the skeleton
+        if (model_ && !boneNodes_)
+        {
+            unsigned boneIndex = stateTracks_[index].boneIndex_;
+            for (unsigned i = 0; i < stateTracks_.Size(); ++i)
+            {
+                const Bone* bone = stateTracks_[i].bone_;
+                if (i != index && bone && bone->parentIndex_ == boneIndex)
+                    SetBoneWeight(i, weight, true);
+            }
+            return;
+        }
+
         Node* boneNode = stateTracks_[index].node_;
         if (boneNode)
         {
@@ -406,7 +635,8 @@ unsigned AnimationState::GetTrackIndex(const String& name) const
     for (unsigned i = 0; i < stateTracks_.Size(); ++i)
     {
         Node* node = stateTracks_[i].node_;
-        if (node && node->GetName() == name)
+        const Bone* bone = stateTracks_[i].bone_;
+        if (node ? node->GetName() == name : bone && bone->name_ == name)
             return i;
     }
 
@@ -429,7 +659,8 @@ unsigned AnimationState::GetTrackIndex(StringHash nameHash) const
     for (unsigned i = 0; i < stateTracks_.Size(); ++i)
     {
         Node* node = stateTracks_[i].node_;
-        if (node && node->GetNameHash() == nameHash)
+        const Bone* bone = stateTracks_[i].bone_;
+        if (node ? node->GetNameHash() == nameHash : bone && bone->nameHash_ == nameHash)
             return i;
     }
 
@@ -447,73 +678,197 @@ void AnimationState::Apply()
         return;
 
     if (model_)
-        ApplyToModel();
+        ApplyToModel(time_, weight_);
     else
         ApplyToNodes();
 }
 
-void AnimationState::ApplyToModel()
+void AnimationState::ApplyToModel(float time, float weight)
 {
+    AnimatedModel* model = model_;
+    unsigned numBones = model->bonePositions_.Size();
+#ifdef URHO3D_SSE
+    TrackSample samples[NUM_SIMD_TRACKS];
+    unsigned numSamples = 0;
+#endif
+
     for (Vector<AnimationStateTrack>::Iterator i = stateTracks_.Begin(); i != stateTracks_.End(); ++i)
     {
         AnimationStateTrack& stateTrack = *i;
-        float finalWeight = weight_ * stateTrack.weight_;
+        float finalWeight = weight * stateTrack.weight_;
 
         // Do not apply if zero effective weight or the bone has animation disabled
         if (Equals(finalWeight, 0.0f) || !stateTrack.bone_->animated_)
             continue;
 
-        ApplyTrack(stateTrack, finalWeight, true);
+        if (boneNodes_)
+            ApplyTrack(stateTrack, time, finalWeight, true);
+        else if (stateTrack.boneIndex_ < numBones)
+        {
+            // Without bone nodes, blend directly into the model's bone pose
+            unsigned index = stateTrack.boneIndex_;
+#ifdef URHO3D_SSE
+            // Gather lerp-blended tracks and blend them four at a time
+            if (blendingMode_ == ABM_LERP)
+            {
+                TrackSample& sample = samples[numSamples];
+                if (!GetKeyFrames(stateTrack, time, sample.keyFrame_, sample.nextKeyFrame_, sample.t_, sample.decoded_))
+                    continue;
+                sample.weight_ = finalWeight;
+                sample.boneIndex_ = index;
+                sample.channelMask_ = stateTrack.track_->channelMask_;
+
+                if (++numSamples == NUM_SIMD_TRACKS)
+                {
+                    BlendTrackSamples(samples, numSamples, &model->bonePositions_[0], &model->boneRotations_[0],
+                        &model->boneScales_[0]);
+                    numSamples = 0;
+                }
+                continue;
+            }
+#endif
+            BlendTrack(stateTrack, time, finalWeight, model->bonePositions_[index], model->boneRotations_[index],
+                model->boneScales_[index]);
+        }
     }
+
+#ifdef URHO3D_SSE
+    if (numSamples)
+        BlendTrackSamples(samples, numSamples, &model->bonePositions_[0], &model->boneRotations_[0], &model->boneScales_[0]);
+#endif
 }
 
 void AnimationState::ApplyToNodes()
 {
     // When applying to a node hierarchy, can only use full weight (nothing to blend to)
     for (Vector<AnimationStateTrack>::Iterator i = stateTracks_.Begin(); i != stateTracks_.End(); ++i)
-        ApplyTrack(*i, 1.0f, false);
+        ApplyTrack(*i, time_, 1.0f, false);
 }
 
-void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, bool silent)
+void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float time, float weight, bool silent)
 {
     const AnimationTrack* track = stateTrack.track_;
     Node* node = stateTrack.node_;
 
-    if (track->keyFrames_.Empty() || !node)
+    if (track->IsEmpty() || !node)
         return;
 
+    const AnimationChannelFlags channelMask = track->channelMask_;
+    Vector3 newPosition = node->GetPosition();
+    Quaternion newRotation = node->GetRotation();
+    Vector3 newScale = node->GetScale();
+
+    BlendTrack(stateTrack, time, weight, newPosition, newRotation, newScale);
+
+    if (silent)
+    {
+        if (channelMask & CHANNEL_POSITION)
+            node->SetPositionSilent(newPosition);
+        if (channelMask & CHANNEL_ROTATION)
+            node->SetRotationSilent(newRotation);
+        if (channelMask & CHANNEL_SCALE)
+            node->SetScaleSilent(newScale);
+    }
+    else
+    {
+        if (channelMask & CHANNEL_POSITION)
+            node->SetPosition(newPosition);
+        if (channelMask & CHANNEL_ROTATION)
+            node->SetRotation(newRotation);
+        if (channelMask & CHANNEL_SCALE)
+            node->SetScale(newScale);
+    }
+}
+
+bool AnimationState::GetKeyFrames(AnimationStateTrack& stateTrack, float time, const AnimationKeyFrame*& keyFrame,
+    const AnimationKeyFrame*& nextKeyFrame, float& t, AnimationKeyFrame* decodeBuffer)
+{
+    const AnimationTrack* track = stateTrack.track_;
+
+    if (track->IsCompressed())
+    {
+        // Uniform samples: find the samples directly from the time position and decode them
+        const CompressedAnimationTrack& compressed = track->compressed_;
+        unsigned index = 0;
+        t = 0.0f;
+        if (compressed.sampleInterval_ > 0.0f)
+        {
+            float position = Max(time, 0.0f) / compressed.sampleInterval_;
+            index = Min((unsigned)position, compressed.numSamples_ - 1);
+            t = Min(position - index, 1.0f);
+        }
+
+        compressed.GetSample(index, track->channelMask_, decodeBuffer[0]);
+        keyFrame = &decodeBuffer[0];
+        if (index + 1 < compressed.numSamples_)
+        {
+            compressed.GetSample(index + 1, track->channelMask_, decodeBuffer[1]);
+            nextKeyFrame = &decodeBuffer[1];
+        }
+        else if (looped_ && index)
+        {
+            // Past the last sample, interpolate back to the first sample over the rest of the animation, as with keyframes
+            float end = index * compressed.sampleInterval_;
+            float length = animation_->GetLength();
+            compressed.GetSample(0, track->channelMask_, decodeBuffer[1]);
+            nextKeyFrame = &decodeBuffer[1];
+            t = length > end ? Clamp((time - end) / (length - end), 0.0f, 1.0f) : 0.0f;
+        }
+        else
+        {
+            nextKeyFrame = keyFrame;
+            t = 0.0f;
+        }
+        return true;
+    }
+
+    if (track->keyFrames_.Empty())
+        return false;
+
     unsigned& frame = stateTrack.keyFrame_;
-    track->GetKeyFrameIndex(time_, frame);
+    track->GetKeyFrameIndex(time, frame);
+    keyFrame = &track->keyFrames_[frame];
 
     // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
     unsigned nextFrame = frame + 1;
-    bool interpolate = true;
     if (nextFrame >= track->keyFrames_.Size())
     {
         if (!looped_)
         {
-            nextFrame = frame;
-            interpolate = false;
+            nextKeyFrame = keyFrame;
+            t = 0.0f;
+            return true;
         }
         else
             nextFrame = 0;
     }
 
-    const AnimationKeyFrame* keyFrame = &track->keyFrames_[frame];
-    const AnimationChannelFlags channelMask = track->channelMask_;
+    nextKeyFrame = &track->keyFrames_[nextFrame];
+    float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
+    if (timeInterval < 0.0f)
+        timeInterval += animation_->GetLength();
+    t = timeInterval > 0.0f ? (time - keyFrame->time_) / timeInterval : 1.0f;
+    return true;
+}
+
+void AnimationState::BlendTrack(AnimationStateTrack& stateTrack, float time, float weight, Vector3& position,
+    Quaternion& rotation, Vector3& scale)
+{
+    AnimationKeyFrame decodeBuffer[2];
+    const AnimationKeyFrame* keyFrame;
+    const AnimationKeyFrame* nextKeyFrame;
+    float t;
+    if (!GetKeyFrames(stateTrack, time, keyFrame, nextKeyFrame, t, decodeBuffer))
+        return;
+
+    const AnimationChannelFlags channelMask = stateTrack.track_->channelMask_;
 
     Vector3 newPosition;
     Quaternion newRotation;
     Vector3 newScale;
 
-    if (interpolate)
+    if (nextKeyFrame != keyFrame)
     {
-        const AnimationKeyFrame* nextKeyFrame = &track->keyFrames_[nextFrame];
-        float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
-        if (timeInterval < 0.0f)
-            timeInterval += animation_->GetLength();
-        float t = timeInterval > 0.0f ? (time_ - keyFrame->time_) / timeInterval : 1.0f;
-
         if (channelMask & CHANNEL_POSITION)
             newPosition = keyFrame->position_.Lerp(nextKeyFrame->position_, t);
         if (channelMask & CHANNEL_ROTATION)
@@ -536,19 +891,19 @@ void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, b
         if (channelMask & CHANNEL_POSITION)
         {
             Vector3 delta = newPosition - stateTrack.bone_->initialPosition_;
-            newPosition = node->GetPosition() + delta * weight;
+            newPosition = position + delta * weight;
         }
         if (channelMask & CHANNEL_ROTATION)
         {
             Quaternion delta = newRotation * stateTrack.bone_->initialRotation_.Inverse();
-            newRotation = (delta * node->GetRotation()).Normalized();
+            newRotation = (delta * rotation).Normalized();
             if (!Equals(weight, 1.0f))
-                newRotation = node->GetRotation().Slerp(newRotation, weight);
+                newRotation = rotation.Slerp(newRotation, weight);
         }
         if (channelMask & CHANNEL_SCALE)
         {
             Vector3 delta = newScale - stateTrack.bone_->initialScale_;
-            newScale = node->GetScale() + delta * weight;
+            newScale = scale + delta * weight;
         }
     }
     else
@@ -556,32 +911,20 @@ void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, b
         if (!Equals(weight, 1.0f)) // not full weight
         {
             if (channelMask & CHANNEL_POSITION)
-                newPosition = node->GetPosition().Lerp(newPosition, weight);
+                newPosition = position.Lerp(newPosition, weight);
             if (channelMask & CHANNEL_ROTATION)
-                newRotation = node->GetRotation().Slerp(newRotation, weight);
+                newRotation = rotation.Slerp(newRotation, weight);
             if (channelMask & CHANNEL_SCALE)
-                newScale = node->GetScale().Lerp(newScale, weight);
+                newScale = scale.Lerp(newScale, weight);
         }
     }
 
-    if (silent)
-    {
-        if (channelMask & CHANNEL_POSITION)
-            node->SetPositionSilent(newPosition);
-        if (channelMask & CHANNEL_ROTATION)
-            node->SetRotationSilent(newRotation);
-        if (channelMask & CHANNEL_SCALE)
-            node->SetScaleSilent(newScale);
-    }
-    else
-    {
-        if (channelMask & CHANNEL_POSITION)
-            node->SetPosition(newPosition);
-        if (channelMask & CHANNEL_ROTATION)
-            node->SetRotation(newRotation);
-        if (channelMask & CHANNEL_SCALE)
-            node->SetScale(newScale);
-    }
+    if (channelMask & CHANNEL_POSITION)
+        position = newPosition;
+    if (channelMask & CHANNEL_ROTATION)
+        rotation = newRotation;
+    if (channelMask & CHANNEL_SCALE)
+        scale = newScale;
 }
 
 }
@@ -35,6 +35,9 @@ class AnimatedModel;
 class Deserializer;
 class Serializer;
 class Skeleton;
+class Quaternion;
+class Vector3;
+struct AnimationKeyFrame;
 struct AnimationTrack;
 struct Bone;
 
@@ -61,6 +64,8 @@ struct AnimationStateTrack
     Bone* bone_;
     /// Scene node pointer.
     WeakPtr<Node> node_;
+    /// Bone index, used when the model's bone nodes are disabled.
+    unsigned boneIndex_;
     /// Blending weight.
     float weight_;
     /// Last key frame.
@@ -70,6 +75,8 @@ struct AnimationStateTrack
 /// %Animation instance.
 class URHO3D_API AnimationState : public RefCounted
 {
+    friend class AnimatedModel;
+
 public:
     /// Construct with animated model and animation pointers.
     AnimationState(AnimatedModel* model, Animation* animation);
@@ -166,12 +173,18 @@ public:
     void Apply();
 
 private:
-    /// Apply animation to a skeleton. Transform changes are applied silently, so the model needs to dirty its root model afterward.
-    void ApplyToModel();
+    /// Apply animation to a skeleton at a time position and blending weight. Transform changes are applied silently, so the model needs to dirty its root model afterward.
+    void ApplyToModel(float time, float weight);
     /// Apply animation to a scene node hierarchy.
     void ApplyToNodes();
     /// Apply track.
-    void ApplyTrack(AnimationStateTrack& stateTrack, float weight, bool silent);
+    void ApplyTrack(AnimationStateTrack& stateTrack, float time, float weight, bool silent);
+    /// Blend track into a local transform. Only the channels that the track contains are modified.
+    void BlendTrack(AnimationStateTrack& stateTrack, float time, float weight, Vector3& position, Quaternion& rotation,
+        Vector3& scale);
+    /// Return the key frames to interpolate between and the interpolation factor at a time position. Compressed tracks are decoded to the two-element buffer. Return false if the track has no key frames.
+    bool GetKeyFrames(AnimationStateTrack& stateTrack, float time, const AnimationKeyFrame*& keyFrame,
+        const AnimationKeyFrame*& nextKeyFrame, float& t, AnimationKeyFrame* decodeBuffer);
 
     /// Animated model (model mode).
     WeakPtr<AnimatedModel> model_;
@@ -193,6 +206,8 @@ private:
     unsigned char layer_;
     /// Blending mode.
     AnimationBlendMode blendingMode_;
+    /// Whether the tracks are assigned to bone nodes or to the model's bone pose.
+    bool boneNodes_;
 };
 
 }
@@ -36,6 +36,10 @@
 #include "../Resource/ResourceCache.h"
 #include "../Scene/Node.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -45,6 +49,53 @@ extern const char* GEOMETRY_CATEGORY;
 
 static const float INV_SQRT_TWO = 1.0f / sqrtf(2.0f);
 
+#ifdef URHO3D_SSE
+static inline __m128 SelectSIMD(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/// Calculate sine and cosine of four angles in degrees. Uses the Cephes single precision range reduction and polynomials.
+static inline void SinCosSIMD(__m128 angles, __m128& sin, __m128& cos)
+{
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32((int)0x80000000));
+    __m128 x = _mm_mul_ps(angles, _mm_set1_ps(M_DEGTORAD));
+    __m128 sinSign = _mm_and_ps(x, signMask);
+    x = _mm_andnot_ps(signMask, x);
+
+    // Octant of the angle, rounded up to an even number
+    __m128i octant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(4.0f / M_PI)));
+    octant = _mm_and_si128(_mm_add_epi32(octant, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+    __m128 y = _mm_cvtepi32_ps(octant);
+
+    // Signs and polynomial selection by the octant
+    sinSign = _mm_xor_ps(sinSign, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(octant, _mm_set1_epi32(4)), 29)));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(octant, _mm_set1_epi32(2)),
+        _mm_set1_epi32(4)), 29));
+    __m128 polyMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(octant, _mm_set1_epi32(2)), _mm_setzero_si128()));
+
+    // Extended precision modular arithmetic
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(0.78515625f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(2.4187564849853515625e-4f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(3.77489497744594108e-8f)));
+    __m128 z = _mm_mul_ps(x, x);
+
+    __m128 c = _mm_set1_ps(2.443315711809948e-5f);
+    c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(-1.388731625493765e-3f));
+    c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(4.166664568298827e-2f));
+    c = _mm_mul_ps(_mm_mul_ps(c, z), z);
+    c = _mm_add_ps(_mm_sub_ps(c, _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+    __m128 s = _mm_set1_ps(-1.9515295891e-4f);
+    s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(8.3321608736e-3f));
+    s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(-1.6666654611e-1f));
+    s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), x), x);
+
+    sin = _mm_xor_ps(SelectSIMD(polyMask, s, c), sinSign);
+    cos = _mm_xor_ps(SelectSIMD(polyMask, c, s), cosSign);
+}
+#endif
+
 const char* faceCameraModeNames[] =
 {
     "None",
@@ -596,27 +647,20 @@ void BillboardSet::UpdateVertexBuffer(const FrameInfo& frame)
     Matrix3x4 billboardTransform = relative_ ? worldTransform : Matrix3x4::IDENTITY;
     Vector3 billboardScale = scaled_ ? worldTransform.Scale() : Vector3::ONE;
 
-    // First check number of enabled billboards
-    for (unsigned i = 0; i < numBillboards; ++i)
-    {
-        if (billboards_[i].enabled_)
-            ++enabledBillboards;
-    }
-
-    sortedBillboards_.Resize(enabledBillboards);
-    unsigned index = 0;
-
-    // Then set initial sort order and distances
+    // Gather the enabled billboards in initial sort order and calculate their distances in one pass, as large sets do not
+    // fit in the cache
+    sortedBillboards_.Resize(numBillboards);
     for (unsigned i = 0; i < numBillboards; ++i)
     {
         Billboard& billboard = billboards_[i];
         if (billboard.enabled_)
         {
-            sortedBillboards_[index++] = &billboard;
+            sortedBillboards_[enabledBillboards++] = &billboard;
             if (sorted_)
                 billboard.sortDistance_ = frame.camera_->GetDistanceSquared(billboardTransform * billboards_[i].position_);
         }
     }
+    sortedBillboards_.Resize(enabledBillboards);
 
     batches_[0].geometry_->SetDrawRange(TRIANGLE_LIST, 0, enabledBillboards * 6, false);
 
@@ -639,6 +683,14 @@ void BillboardSet::UpdateVertexBuffer(const FrameInfo& frame)
 
     if (faceCameraMode_ != FC_DIRECTION)
     {
+#ifdef URHO3D_SSE
+        // Corner signs of the billboard's X and Y axes, in vertex order
+        const __m128 signX = _mm_castsi128_ps(_mm_setr_epi32((int)0x80000000, 0, 0, (int)0x80000000));
+        const __m128 signY = _mm_castsi128_ps(_mm_setr_epi32(0, 0, (int)0x80000000, (int)0x80000000));
+        float sines[4];
+        float cosines[4];
+#endif
+
         for (unsigned i = 0; i < enabledBillboards; ++i)
         {
             Billboard& billboard = *sortedBillboards_[i];
@@ -650,10 +702,49 @@ void BillboardSet::UpdateVertexBuffer(const FrameInfo& frame)
                 size *= billboard.screenScaleFactor_;
 
             float rotationMatrix[2][2];
+#ifdef URHO3D_SSE
+            // Calculate the rotations of four billboards at a time
+            if (!(i & 3))
+            {
+                float angles[4];
+                for (unsigned j = 0; j < 4; ++j)
+                    angles[j] = i + j < enabledBillboards ? sortedBillboards_[i + j]->rotation_ : 0.0f;
+                __m128 sin, cos;
+                SinCosSIMD(_mm_loadu_ps(angles), sin, cos);
+                _mm_storeu_ps(sines, sin);
+                _mm_storeu_ps(cosines, cos);
+            }
+            rotationMatrix[0][1] = sines[i & 3];
+            rotationMatrix[0][0] = cosines[i & 3];
+#else
             SinCos(billboard.rotation_, rotationMatrix[0][1], rotationMatrix[0][0]);
+#endif
             rotationMatrix[1][0] = -rotationMatrix[0][1];
             rotationMatrix[1][1] = rotationMatrix[0][0];
 
+#ifdef URHO3D_SSE
+            // All four vertices share the position and color. Build the UVs and offsets of the corners as columns,
+            // then transpose them to vertex order
+            float positionColor[4] = {billboard.position_.x_, billboard.position_.y_, billboard.position_.z_, 0.0f};
+            ((unsigned&)positionColor[3]) = color;
+            __m128 vertexStart = _mm_loadu_ps(positionColor);
+            __m128 u = _mm_setr_ps(billboard.uv_.min_.x_, billboard.uv_.max_.x_, billboard.uv_.max_.x_, billboard.uv_.min_.x_);
+            __m128 v = _mm_setr_ps(billboard.uv_.min_.y_, billboard.uv_.min_.y_, billboard.uv_.max_.y_, billboard.uv_.max_.y_);
+            __m128 offsetX = _mm_add_ps(_mm_xor_ps(_mm_set1_ps(size.x_ * rotationMatrix[0][0]), signX),
+                _mm_xor_ps(_mm_set1_ps(size.y_ * rotationMatrix[0][1]), signY));
+            __m128 offsetY = _mm_add_ps(_mm_xor_ps(_mm_set1_ps(size.x_ * rotationMatrix[1][0]), signX),
+                _mm_xor_ps(_mm_set1_ps(size.y_ * rotationMatrix[1][1]), signY));
+            _MM_TRANSPOSE4_PS(u, v, offsetX, offsetY);
+
+            _mm_storeu_ps(&dest[0], vertexStart);
+            _mm_storeu_ps(&dest[4], u);
+            _mm_storeu_ps(&dest[8], vertexStart);
+            _mm_storeu_ps(&dest[12], v);
+            _mm_storeu_ps(&dest[16], vertexStart);
+            _mm_storeu_ps(&dest[20], offsetX);
+            _mm_storeu_ps(&dest[24], vertexStart);
+            _mm_storeu_ps(&dest[28], offsetY);
+#else
             dest[0] = billboard.position_.x_;
             dest[1] = billboard.position_.y_;
             dest[2] = billboard.position_.z_;
@@ -689,6 +780,7 @@ void BillboardSet::UpdateVertexBuffer(const FrameInfo& frame)
             dest[29] = billboard.uv_.max_.y_;
             dest[30] = -size.x_ * rotationMatrix[0][0] - size.y_ * rotationMatrix[0][1];
             dest[31] = -size.x_ * rotationMatrix[1][0] - size.y_ * rotationMatrix[1][1];
+#endif
 
             dest += 32;
         }
@@ -812,6 +904,7 @@ void BillboardSet::CalculateFixedScreenSize(const FrameInfo& frame)
         bufferDirty_ = true;
         forceUpdate_ = true;
         worldBoundingBoxDirty_ = true;
+        UpdateOctantBounds();
     }
 }
 
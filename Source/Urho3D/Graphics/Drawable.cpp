@@ -24,6 +24,7 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Core/Thread.h"
 #include "../Graphics/Camera.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../IO/File.h"
@@ -65,8 +66,11 @@ Drawable::Drawable(Context* context, unsigned char drawableFlags) :
     occluder_(false),
     occludee_(true),
     updateQueued_(false),
+    boundsUpdateQueued_(false),
     zoneDirty_(false),
     octant_(nullptr),
+    octantIndex_(0),
+    treeProxy_(M_MAX_UNSIGNED),
     zone_(nullptr),
     viewMask_(DEFAULT_VIEWMASK),
     lightMask_(DEFAULT_LIGHTMASK),
@@ -99,7 +103,7 @@ Drawable::~Drawable()
 void Drawable::RegisterObject(Context* context)
 {
     URHO3D_ATTRIBUTE("Max Lights", int, maxLights_, 0, AM_DEFAULT);
-    URHO3D_ATTRIBUTE("View Mask", int, viewMask_, DEFAULT_VIEWMASK, AM_DEFAULT);
+    URHO3D_ATTRIBUTE_EX("View Mask", int, viewMask_, UpdateOctantBounds, DEFAULT_VIEWMASK, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Light Mask", int, lightMask_, DEFAULT_LIGHTMASK, AM_DEFAULT);
     URHO3D_ATTRIBUTE("Shadow Mask", int, shadowMask_, DEFAULT_SHADOWMASK, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Zone Mask", GetZoneMask, SetZoneMask, unsigned, DEFAULT_ZONEMASK, AM_DEFAULT);
@@ -191,6 +195,7 @@ void Drawable::SetLodBias(float bias)
 void Drawable::SetViewMask(unsigned mask)
 {
     viewMask_ = mask;
+    UpdateOctantBounds();
     MarkNetworkUpdate();
 }
 
@@ -411,6 +416,8 @@ void Drawable::RemoveFromOctree()
         Octree* octree = octant_->GetRoot();
         if (updateQueued_)
             octree->CancelUpdate(this);
+        if (boundsUpdateQueued_)
+            octree->CancelBoundsUpdate(this);
 
         // Perform subclass specific deinitialization if necessary
         OnRemoveFromOctree();
@@ -419,6 +426,20 @@ void Drawable::RemoveFromOctree()
     }
 }
 
+void Drawable::UpdateOctantBounds()
+{
+    if (!octant_)
+        return;
+
+    // Outside the main thread other views may be querying the octree, so only the main thread writes the packed bounds
+    bool mainThread = Thread::IsMainThread();
+    if (mainThread)
+        octant_->UpdateDrawableBounds(this);
+    // Also defer if the box is dirty without a reinsertion, so that the packed bounds do not stay flagged dirty
+    if (!mainThread || (worldBoundingBoxDirty_ && !updateQueued_))
+        octant_->GetRoot()->QueueBoundsUpdate(this);
+}
+
 bool WriteDrawablesToOBJ(const PODVector<Drawable*>& drawables, File* outputFile, bool asZUp, bool asRightHanded, bool writeLightmapUV)
 {
     // Must track indices independently to deal with potential mismatching of drawables vertex attributes (ie. one with UV, another without, then another with)
@@ -113,7 +113,6 @@ class URHO3D_API Drawable : public Component
 
     friend class Octant;
     friend class Octree;
-    friend void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex);
 
 public:
     /// Construct.
@@ -347,6 +346,8 @@ protected:
     void AddToOctree();
     /// Remove from octree.
     void RemoveFromOctree();
+    /// Refresh the octant's packed copy of the world bounding box and view mask. Call after marking the world bounding box dirty without queuing an octree update. Outside the main thread the refresh is deferred to the main thread.
+    void UpdateOctantBounds();
 
     /// Move into another octree octant.
     void SetOctant(Octant* octant) { octant_ = octant; }
@@ -369,10 +370,16 @@ protected:
     bool occludee_;
     /// Octree update queued flag.
     bool updateQueued_;
+    /// Octant bounds refresh queued flag.
+    bool boundsUpdateQueued_;
     /// Zone inconclusive or dirtied flag.
     bool zoneDirty_;
     /// Octree octant.
     Octant* octant_;
+    /// Index in the octant's drawable list.
+    unsigned octantIndex_;
+    /// Leaf index in the octree's AABB tree.
+    unsigned treeProxy_;
     /// Current zone.
     Zone* zone_;
     /// View mask.
@@ -0,0 +1,478 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Graphics/DebugRenderer.h"
+#include "../Graphics/Drawable.h"
+#include "../Graphics/DynamicAABBTree.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+static const unsigned INITIAL_NODE_CAPACITY = 16;
+/// Leaves whose fattened box exceeds the new fattened box by more than this many margins are reinserted even if the box still fits.
+static const float MAX_MARGIN_MULTIPLIER = 4.0f;
+/// Multiplier for the movement since the last update when extending a reinserted leaf's box in the direction of movement.
+static const float DISPLACEMENT_MULTIPLIER = 4.0f;
+
+/// Return half the surface area of a bounding box, used as the insertion cost.
+static float GetBoxCost(const BoundingBox& box)
+{
+    Vector3 size = box.Size();
+    return size.x_ * size.y_ + size.y_ * size.z_ + size.z_ * size.x_;
+}
+
+/// Return union of two bounding boxes.
+static BoundingBox GetUnion(const BoundingBox& lhs, const BoundingBox& rhs)
+{
+    BoundingBox result(lhs);
+    result.Merge(rhs);
+    return result;
+}
+
+DynamicAABBTree::DynamicAABBTree() :
+    root_(AABBTREE_NULL_NODE),
+    freeList_(AABBTREE_NULL_NODE),
+    numProxies_(0),
+    margin_(0.0f)
+{
+}
+
+void DynamicAABBTree::SetMargin(float margin)
+{
+    margin_ = Max(margin, 0.0f);
+}
+
+unsigned DynamicAABBTree::CreateProxy(Drawable* drawable, const BoundingBox& box)
+{
+    unsigned proxy = AllocateNode();
+    DynamicAABBTreeNode& node = nodes_[proxy];
+    Vector3 margin(margin_, margin_, margin_);
+    node.box_ = BoundingBox(box.min_ - margin, box.max_ + margin);
+    node.center_ = box.Center();
+    node.drawable_ = drawable;
+    node.height_ = 0;
+
+    InsertLeaf(proxy);
+    ++numProxies_;
+    return proxy;
+}
+
+void DynamicAABBTree::DestroyProxy(unsigned proxy)
+{
+    assert(proxy < nodes_.Size() && nodes_[proxy].IsLeaf());
+
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    --numProxies_;
+}
+
+bool DynamicAABBTree::MoveProxy(unsigned proxy, const BoundingBox& box)
+{
+    assert(proxy < nodes_.Size() && nodes_[proxy].IsLeaf());
+
+    DynamicAABBTreeNode& node = nodes_[proxy];
+    Vector3 center = box.Center();
+    Vector3 displacement = DISPLACEMENT_MULTIPLIER * (center - node.center_);
+    node.center_ = center;
+
+    // Fatten by the margin, and extend in the direction of movement
+    Vector3 margin(margin_, margin_, margin_);
+    BoundingBox fatBox(box.min_ - margin, box.max_ + margin);
+    fatBox.min_ += VectorMin(displacement, Vector3::ZERO);
+    fatBox.max_ += VectorMax(displacement, Vector3::ZERO);
+
+    if (node.box_.IsInside(box) == INSIDE)
+    {
+        // Also reinsert if the object has shrunk or slowed down a lot, so that the tree box does not stay too large
+        Vector3 maxMargin = MAX_MARGIN_MULTIPLIER * margin;
+        if (BoundingBox(fatBox.min_ - maxMargin, fatBox.max_ + maxMargin).IsInside(node.box_) == INSIDE)
+            return false;
+    }
+
+    RemoveLeaf(proxy);
+    nodes_[proxy].box_ = fatBox;
+    InsertLeaf(proxy);
+    return true;
+}
+
+void DynamicAABBTree::Clear()
+{
+    nodes_.Clear();
+    root_ = AABBTREE_NULL_NODE;
+    freeList_ = AABBTREE_NULL_NODE;
+    numProxies_ = 0;
+}
+
+void DynamicAABBTree::GetDrawables(OctreeQuery& query) const
+{
+    if (root_ != AABBTREE_NULL_NODE)
+        GetDrawablesInternal(root_, query, false);
+}
+
+void DynamicAABBTree::Raycast(RayOctreeQuery& query) const
+{
+    if (root_ != AABBTREE_NULL_NODE)
+        RaycastInternal(root_, query);
+}
+
+void DynamicAABBTree::GetDrawablesOnly(RayOctreeQuery& query, PODVector<Drawable*>& drawables) const
+{
+    if (root_ != AABBTREE_NULL_NODE)
+        GetDrawablesOnlyInternal(root_, query, drawables);
+}
+
+void DynamicAABBTree::DrawDebugGeometry(DebugRenderer* debug, bool depthTest) const
+{
+    if (!debug)
+        return;
+
+    for (PODVector<DynamicAABBTreeNode>::ConstIterator i = nodes_.Begin(); i != nodes_.End(); ++i)
+    {
+        if (i->height_ > 0 && debug->IsInside(i->box_))
+            debug->AddBoundingBox(i->box_, Color(0.25f, 0.25f, 0.25f), depthTest);
+    }
+}
+
+unsigned DynamicAABBTree::AllocateNode()
+{
+    if (freeList_ == AABBTREE_NULL_NODE)
+    {
+        // Grow the node storage and link the new nodes into the free list
+        unsigned oldSize = nodes_.Size();
+        unsigned newSize = Max(oldSize * 2, INITIAL_NODE_CAPACITY);
+        nodes_.Resize(newSize);
+        for (unsigned i = oldSize; i < newSize; ++i)
+        {
+            nodes_[i].parent_ = i + 1 < newSize ? i + 1 : AABBTREE_NULL_NODE;
+            nodes_[i].height_ = -1;
+        }
+        freeList_ = oldSize;
+    }
+
+    unsigned index = freeList_;
+    DynamicAABBTreeNode& node = nodes_[index];
+    freeList_ = node.parent_;
+    node.parent_ = AABBTREE_NULL_NODE;
+    node.child1_ = AABBTREE_NULL_NODE;
+    node.child2_ = AABBTREE_NULL_NODE;
+    node.drawable_ = nullptr;
+    node.height_ = 0;
+    return index;
+}
+
+void DynamicAABBTree::FreeNode(unsigned index)
+{
+    DynamicAABBTreeNode& node = nodes_[index];
+    node.parent_ = freeList_;
+    node.drawable_ = nullptr;
+    node.height_ = -1;
+    freeList_ = index;
+}
+
+void DynamicAABBTree::InsertLeaf(unsigned leaf)
+{
+    if (root_ == AABBTREE_NULL_NODE)
+    {
+        root_ = leaf;
+        nodes_[leaf].parent_ = AABBTREE_NULL_NODE;
+        return;
+    }
+
+    // Descend to the sibling that minimizes the surface area cost of the new parent and the enlarged ancestors
+    BoundingBox leafBox = nodes_[leaf].box_;
+    unsigned index = root_;
+    while (!nodes_[index].IsLeaf())
+    {
+        const DynamicAABBTreeNode& node = nodes_[index];
+        float area = GetBoxCost(node.box_);
+        float combinedArea = GetBoxCost(GetUnion(node.box_, leafBox));
+
+        // Cost of creating a new parent for this node and the leaf, and the minimum cost of pushing the leaf further down
+        float cost = 2.0f * combinedArea;
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        const DynamicAABBTreeNode& child1 = nodes_[node.child1_];
+        float cost1 = GetBoxCost(GetUnion(child1.box_, leafBox)) + inheritanceCost;
+        if (!child1.IsLeaf())
+            cost1 -= GetBoxCost(child1.box_);
+
+        const DynamicAABBTreeNode& child2 = nodes_[node.child2_];
+        float cost2 = GetBoxCost(GetUnion(child2.box_, leafBox)) + inheritanceCost;
+        if (!child2.IsLeaf())
+            cost2 -= GetBoxCost(child2.box_);
+
+        if (cost < cost1 && cost < cost2)
+            break;
+
+        index = cost1 < cost2 ? node.child1_ : node.child2_;
+    }
+
+    unsigned sibling = index;
+    unsigned oldParent = nodes_[sibling].parent_;
+    // Note: allocation may reallocate the node storage, so take references only after it
+    unsigned newParent = AllocateNode();
+    DynamicAABBTreeNode& parentNode = nodes_[newParent];
+    parentNode.parent_ = oldParent;
+    parentNode.box_ = GetUnion(leafBox, nodes_[sibling].box_);
+    parentNode.height_ = nodes_[sibling].height_ + 1;
+    parentNode.child1_ = sibling;
+    parentNode.child2_ = leaf;
+
+    if (oldParent != AABBTREE_NULL_NODE)
+    {
+        if (nodes_[oldParent].child1_ == sibling)
+            nodes_[oldParent].child1_ = newParent;
+        else
+            nodes_[oldParent].child2_ = newParent;
+    }
+    else
+        root_ = newParent;
+
+    nodes_[sibling].parent_ = newParent;
+    nodes_[leaf].parent_ = newParent;
+
+    RefitAncestors(newParent);
+}
+
+void DynamicAABBTree::RemoveLeaf(unsigned leaf)
+{
+    if (leaf == root_)
+    {
+        root_ = AABBTREE_NULL_NODE;
+        return;
+    }
+
+    unsigned parent = nodes_[leaf].parent_;
+    unsigned grandParent = nodes_[parent].parent_;
+    unsigned sibling = nodes_[parent].child1_ == leaf ? nodes_[parent].child2_ : nodes_[parent].child1_;
+
+    // Replace the parent with the sibling
+    if (grandParent != AABBTREE_NULL_NODE)
+    {
+        if (nodes_[grandParent].child1_ == parent)
+            nodes_[grandParent].child1_ = sibling;
+        else
+            nodes_[grandParent].child2_ = sibling;
+        nodes_[sibling].parent_ = grandParent;
+        FreeNode(parent);
+        RefitAncestors(grandParent);
+    }
+    else
+    {
+        root_ = sibling;
+        nodes_[sibling].parent_ = AABBTREE_NULL_NODE;
+        FreeNode(parent);
+    }
+
+    nodes_[leaf].parent_ = AABBTREE_NULL_NODE;
+}
+
+void DynamicAABBTree::RefitAncestors(unsigned index)
+{
+    while (index != AABBTREE_NULL_NODE)
+    {
+        index = Balance(index);
+
+        DynamicAABBTreeNode& node = nodes_[index];
+        const DynamicAABBTreeNode& child1 = nodes_[node.child1_];
+        const DynamicAABBTreeNode& child2 = nodes_[node.child2_];
+        node.height_ = 1 + Max(child1.height_, child2.height_);
+        node.box_ = GetUnion(child1.box_, child2.box_);
+
+        index = node.parent_;
+    }
+}
+
+unsigned DynamicAABBTree::Balance(unsigned iA)
+{
+    DynamicAABBTreeNode& a = nodes_[iA];
+    if (a.IsLeaf() || a.height_ < 2)
+        return iA;
+
+    unsigned iB = a.child1_;
+    unsigned iC = a.child2_;
+    DynamicAABBTreeNode& b = nodes_[iB];
+    DynamicAABBTreeNode& c = nodes_[iC];
+    int balance = c.height_ - b.height_;
+
+    // Rotate C up
+    if (balance > 1)
+    {
+        unsigned iF = c.child1_;
+        unsigned iG = c.child2_;
+        DynamicAABBTreeNode& f = nodes_[iF];
+        DynamicAABBTreeNode& g = nodes_[iG];
+
+        c.child1_ = iA;
+        c.parent_ = a.parent_;
+        a.parent_ = iC;
+
+        if (c.parent_ != AABBTREE_NULL_NODE)
+        {
+            if (nodes_[c.parent_].child1_ == iA)
+                nodes_[c.parent_].child1_ = iC;
+            else
+                nodes_[c.parent_].child2_ = iC;
+        }
+        else
+            root_ = iC;
+
+        if (f.height_ > g.height_)
+        {
+            c.child2_ = iF;
+            a.child2_ = iG;
+            g.parent_ = iA;
+            a.box_ = GetUnion(b.box_, g.box_);
+            c.box_ = GetUnion(a.box_, f.box_);
+            a.height_ = 1 + Max(b.height_, g.height_);
+            c.height_ = 1 + Max(a.height_, f.height_);
+        }
+        else
+        {
+            c.child2_ = iG;
+            a.child2_ = iF;
+            f.parent_ = iA;
+            a.box_ = GetUnion(b.box_, f.box_);
+            c.box_ = GetUnion(a.box_, g.box_);
+            a.height_ = 1 + Max(b.height_, f.height_);
+            c.height_ = 1 + Max(a.height_, g.height_);
+        }
+
+        return iC;
+    }
+
+    // Rotate B up
+    if (balance < -1)
+    {
+        unsigned iD = b.child1_;
+        unsigned iE = b.child2_;
+        DynamicAABBTreeNode& d = nodes_[iD];
+        DynamicAABBTreeNode& e = nodes_[iE];
+
+        b.child1_ = iA;
+        b.parent_ = a.parent_;
+        a.parent_ = iB;
+
+        if (b.parent_ != AABBTREE_NULL_NODE)
+        {
+            if (nodes_[b.parent_].child1_ == iA)
+                nodes_[b.parent_].child1_ = iB;
+            else
+                nodes_[b.parent_].child2_ = iB;
+        }
+        else
+            root_ = iB;
+
+        if (d.height_ > e.height_)
+        {
+            b.child2_ = iD;
+            a.child1_ = iE;
+            e.parent_ = iA;
+            a.box_ = GetUnion(c.box_, e.box_);
+            b.box_ = GetUnion(a.box_, d.box_);
+            a.height_ = 1 + Max(c.height_, e.height_);
+            b.height_ = 1 + Max(a.height_, d.height_);
+        }
+        else
+        {
+            b.child2_ = iE;
+            a.child1_ = iD;
+            d.parent_ = iA;
+            a.box_ = GetUnion(c.box_, d.box_);
+            b.box_ = GetUnion(a.box_, e.box_);
+            a.height_ = 1 + Max(c.height_, d.height_);
+            b.height_ = 1 + Max(a.height_, e.height_);
+        }
+
+        return iB;
+    }
+
+    return iA;
+}
+
+void DynamicAABBTree::GetDrawablesInternal(unsigned index, OctreeQuery& query, bool inside) const
+{
+    const DynamicAABBTreeNode& node = nodes_[index];
+
+    Intersection res = query.TestOctant(node.box_, inside);
+    if (res == INSIDE)
+        inside = true;
+    else if (res == OUTSIDE)
+        return;
+
+    if (node.IsLeaf())
+    {
+        auto** start = const_cast<Drawable**>(&node.drawable_);
+        query.TestDrawables(start, start + 1, inside);
+    }
+    else
+    {
+        GetDrawablesInternal(node.child1_, query, inside);
+        GetDrawablesInternal(node.child2_, query, inside);
+    }
+}
+
+void DynamicAABBTree::RaycastInternal(unsigned index, RayOctreeQuery& query) const
+{
+    const DynamicAABBTreeNode& node = nodes_[index];
+
+    if (query.ray_.HitDistance(node.box_) >= query.maxDistance_)
+        return;
+
+    if (node.IsLeaf())
+    {
+        Drawable* drawable = node.drawable_;
+        if ((drawable->GetDrawableFlags() & query.drawableFlags_) && (drawable->GetViewMask() & query.viewMask_))
+            drawable->ProcessRayQuery(query, query.result_);
+    }
+    else
+    {
+        RaycastInternal(node.child1_, query);
+        RaycastInternal(node.child2_, query);
+    }
+}
+
+void DynamicAABBTree::GetDrawablesOnlyInternal(unsigned index, RayOctreeQuery& query, PODVector<Drawable*>& drawables) const
+{
+    const DynamicAABBTreeNode& node = nodes_[index];
+
+    if (query.ray_.HitDistance(node.box_) >= query.maxDistance_)
+        return;
+
+    if (node.IsLeaf())
+    {
+        Drawable* drawable = node.drawable_;
+        if ((drawable->GetDrawableFlags() & query.drawableFlags_) && (drawable->GetViewMask() & query.viewMask_))
+            drawables.Push(drawable);
+    }
+    else
+    {
+        GetDrawablesOnlyInternal(node.child1_, query, drawables);
+        GetDrawablesOnlyInternal(node.child2_, query, drawables);
+    }
+}
+
+}
@@ -0,0 +1,134 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Graphics/OctreeQuery.h"
+#include "../Math/BoundingBox.h"
+
+namespace Urho3D
+{
+
+class DebugRenderer;
+class Drawable;
+
+/// Invalid node index in a dynamic AABB tree.
+static const unsigned AABBTREE_NULL_NODE = M_MAX_UNSIGNED;
+
+/// %Node of a dynamic AABB tree.
+struct DynamicAABBTreeNode
+{
+    /// Return whether is a leaf.
+    bool IsLeaf() const { return child1_ == AABBTREE_NULL_NODE; }
+
+    /// Bounding box. Fattened by the tree margin and the predicted movement for leaves.
+    BoundingBox box_;
+    /// Center of the actual bounding box on the last update, used to predict movement.
+    Vector3 center_;
+    /// Drawable object for leaves.
+    Drawable* drawable_;
+    /// Parent node index, or next free node index when in the free list.
+    unsigned parent_;
+    /// First child node index.
+    unsigned child1_;
+    /// Second child node index.
+    unsigned child2_;
+    /// Height of the subtree, 0 for leaves and -1 for free nodes.
+    int height_;
+};
+
+/// Dynamic bounding volume hierarchy of drawable objects. Leaves store bounding boxes fattened by a margin and extended in the direction of movement, so that small movements do not need a tree update; larger movements remove and reinsert the leaf, refitting and rebalancing its ancestors.
+/// @nobind
+class URHO3D_API DynamicAABBTree
+{
+public:
+    /// Construct empty.
+    DynamicAABBTree();
+
+    /// Set margin added to each side of the leaf bounding boxes.
+    void SetMargin(float margin);
+    /// Insert a drawable object with its bounding box and return the leaf index.
+    unsigned CreateProxy(Drawable* drawable, const BoundingBox& box);
+    /// Remove a leaf.
+    void DestroyProxy(unsigned proxy);
+    /// Update a leaf's bounding box. Should be called whenever the object moves, so that movement can be predicted. Return true if the leaf was reinserted, or false if the fattened box still contains the new box.
+    bool MoveProxy(unsigned proxy, const BoundingBox& box);
+    /// Remove all leaves.
+    void Clear();
+
+    /// Return drawable objects by a query. Does not clear the result vector.
+    void GetDrawables(OctreeQuery& query) const;
+    /// Return drawable objects by a ray query. Does not clear the result vector.
+    void Raycast(RayOctreeQuery& query) const;
+    /// Return drawable objects only for a ray query.
+    void GetDrawablesOnly(RayOctreeQuery& query, PODVector<Drawable*>& drawables) const;
+    /// Draw the bounding boxes of the non-leaf nodes to the debug graphics.
+    void DrawDebugGeometry(DebugRenderer* debug, bool depthTest) const;
+
+    /// Return margin.
+    float GetMargin() const { return margin_; }
+
+    /// Return number of leaves.
+    unsigned GetNumProxies() const { return numProxies_; }
+
+    /// Return tree height.
+    int GetHeight() const { return root_ != AABBTREE_NULL_NODE ? nodes_[root_].height_ : 0; }
+
+    /// Return drawable object of a leaf.
+    Drawable* GetDrawable(unsigned proxy) const { return nodes_[proxy].drawable_; }
+
+    /// Return fattened bounding box of a leaf.
+    const BoundingBox& GetFatBoundingBox(unsigned proxy) const { return nodes_[proxy].box_; }
+
+private:
+    /// Take a node from the free list, growing the node storage if necessary.
+    unsigned AllocateNode();
+    /// Return a node to the free list.
+    void FreeNode(unsigned index);
+    /// Insert a leaf to the best sibling position by surface area heuristic.
+    void InsertLeaf(unsigned leaf);
+    /// Detach a leaf from the tree.
+    void RemoveLeaf(unsigned leaf);
+    /// Refit and rebalance the ancestors of a node.
+    void RefitAncestors(unsigned index);
+    /// Perform a left or right rotation if the node is unbalanced. Return the new subtree root.
+    unsigned Balance(unsigned index);
+    /// Return drawable objects by a query from a subtree.
+    void GetDrawablesInternal(unsigned index, OctreeQuery& query, bool inside) const;
+    /// Return drawable objects by a ray query from a subtree.
+    void RaycastInternal(unsigned index, RayOctreeQuery& query) const;
+    /// Return drawable objects only for a ray query from a subtree.
+    void GetDrawablesOnlyInternal(unsigned index, RayOctreeQuery& query, PODVector<Drawable*>& drawables) const;
+
+    /// Nodes.
+    PODVector<DynamicAABBTreeNode> nodes_;
+    /// Root node index.
+    unsigned root_;
+    /// First free node index.
+    unsigned freeList_;
+    /// Number of leaves.
+    unsigned numProxies_;
+    /// Leaf bounding box margin.
+    float margin_;
+};
+
+}
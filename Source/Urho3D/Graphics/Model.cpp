@@ -61,7 +61,8 @@ unsigned LookupIndexBuffer(IndexBuffer* buffer, const Vector<SharedPtr<IndexBuff
 }
 
 Model::Model(Context* context) :
-    ResourceWithMetadata(context)
+    ResourceWithMetadata(context),
+    poseCache_(new AnimationPoseCache())
 {
 }
 
@@ -84,6 +85,9 @@ bool Model::BeginLoad(Deserializer& source)
 
     bool hasVertexDeclarations = (fileID == "UMD2");
 
+    // The skeleton may change, so poses evaluated for the old skeleton can not be shared anymore
+    poseCache_->Clear();
+
     geometries_.Clear();
     geometryBoneMappings_.Clear();
     geometryCenters_.Clear();
@@ -602,6 +606,7 @@ bool Model::SetGeometryCenter(unsigned index, const Vector3& center)
 void Model::SetSkeleton(const Skeleton& skeleton)
 {
     skeleton_ = skeleton;
+    poseCache_->Clear();
 }
 
 void Model::SetGeometryBoneMappings(const Vector<PODVector<unsigned> >& geometryBoneMappings)
@@ -24,6 +24,7 @@
 
 #include "../Container/ArrayPtr.h"
 #include "../Container/Ptr.h"
+#include "../Graphics/AnimationPoseCache.h"
 #include "../Graphics/GraphicsDefs.h"
 #include "../Graphics/Skeleton.h"
 #include "../Math/BoundingBox.h"
@@ -160,6 +161,9 @@ public:
     /// @property
     Skeleton& GetSkeleton() { return skeleton_; }
 
+    /// Return the bone pose cache shared by the AnimatedModels that use this model with pose sharing enabled.
+    AnimationPoseCache* GetPoseCache() const { return poseCache_; }
+
     /// Return vertex buffers.
     const Vector<SharedPtr<VertexBuffer> >& GetVertexBuffers() const { return vertexBuffers_; }
 
@@ -216,6 +220,8 @@ private:
     BoundingBox boundingBox_;
     /// Skeleton.
     Skeleton skeleton_;
+    /// Shared bone pose cache.
+    SharedPtr<AnimationPoseCache> poseCache_;
     /// Vertex buffers.
     Vector<SharedPtr<VertexBuffer> > vertexBuffers_;
     /// Index buffers.
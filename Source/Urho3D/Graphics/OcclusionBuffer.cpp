@@ -28,6 +28,10 @@
 #include "../Graphics/OcclusionBuffer.h"
 #include "../IO/Log.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -51,6 +55,14 @@ void DrawOcclusionBatchWork(const WorkItem* item, unsigned threadIndex)
     buffer->DrawBatch(batch, threadIndex);
 }
 
+void RasterizeOcclusionTilesWork(const WorkItem* item, unsigned threadIndex)
+{
+    auto* buffer = reinterpret_cast<OcclusionBuffer*>(item->aux_);
+    auto* start = reinterpret_cast<const IntRect*>(item->start_);
+    auto* end = reinterpret_cast<const IntRect*>(item->end_);
+    buffer->RasterizeTiles(start, end);
+}
+
 OcclusionBuffer::OcclusionBuffer(Context* context) :
     Object(context)
 {
@@ -79,15 +91,29 @@ bool OcclusionBuffer::SetSize(int width, int height, bool threaded)
     width_ = width;
     height_ = height;
 
-    // Build work buffers for threading
+    CalculateTiles();
+
+    // Build triangle bins for threading. All threads rasterize into the first buffer, as the tiles do not overlap
     unsigned numThreadBuffers = threaded ? GetSubsystem<WorkQueue>()->GetNumThreads() + 1 : 1;
     buffers_.Resize(numThreadBuffers);
     for (unsigned i = 0; i < numThreadBuffers; ++i)
     {
-        // Reserve extra memory in case 3D clipping is not exact
         OcclusionBufferData& buffer = buffers_[i];
-        buffer.dataWithSafety_ = new int[width * (height + 2) + 2];
-        buffer.data_ = buffer.dataWithSafety_.Get() + width + 1;
+        if (!i)
+        {
+            // Reserve extra memory in case 3D clipping is not exact
+            buffer.dataWithSafety_ = new int[width * (height + 2) + 2];
+            buffer.data_ = buffer.dataWithSafety_.Get() + width + 1;
+        }
+        else
+        {
+            buffer.dataWithSafety_.Reset();
+            buffer.data_ = nullptr;
+        }
+        buffer.triangles_.Clear();
+        buffer.tileTriangles_.Clear();
+        if (numThreadBuffers > 1)
+            buffer.tileTriangles_.Resize(tileRects_.Size());
         buffer.used_ = false;
     }
 
@@ -153,7 +179,6 @@ void OcclusionBuffer::Clear()
 {
     Reset();
 
-    // Only clear the main thread buffer. Rest are cleared on-demand when drawing the first batch
     ClearBuffer(0);
     for (unsigned i = 1; i < buffers_.Size(); ++i)
         buffers_[i].used_ = false;
@@ -209,7 +234,7 @@ void OcclusionBuffer::DrawTriangles()
     }
     else if (buffers_.Size() > 1)
     {
-        // Threaded
+        // Threaded: first set up and bin the triangles of each batch, then rasterize each row of tiles
         auto* queue = GetSubsystem<WorkQueue>();
 
         for (Vector<OcclusionBatch>::Iterator i = batches_.Begin(); i != batches_.End(); ++i)
@@ -224,10 +249,28 @@ void OcclusionBuffer::DrawTriangles()
 
         queue->Complete(M_MAX_UNSIGNED);
 
-        MergeBuffers();
+        for (unsigned i = 0; i < tileRects_.Size(); i += numTilesX_)
+        {
+            SharedPtr<WorkItem> item = queue->GetFreeItem();
+            item->priority_ = M_MAX_UNSIGNED;
+            item->workFunction_ = RasterizeOcclusionTilesWork;
+            item->aux_ = this;
+            item->start_ = &tileRects_[i];
+            item->end_ = &tileRects_[i] + numTilesX_;
+            queue->AddWorkItem(item);
+        }
+
+        queue->Complete(M_MAX_UNSIGNED);
+
         depthHierarchyDirty_ = true;
     }
 
+    for (Vector<OcclusionBufferData>::Iterator i = buffers_.Begin(); i != buffers_.End(); ++i)
+    {
+        i->triangles_.Clear();
+        i->used_ = false;
+    }
+
     batches_.Clear();
 }
 
@@ -335,49 +378,159 @@ void OcclusionBuffer::ResetUseTimer()
 
 bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
 {
-    if (buffers_.Empty())
-        return true;
+    bool visible;
+    IsVisible(&worldSpaceBox, 1, &visible);
+    return visible;
+}
 
-    // Transform corners to projection space
-    Vector4 vertices[8];
-    vertices[0] = ModelTransform(viewProj_, worldSpaceBox.min_);
-    vertices[1] = ModelTransform(viewProj_, Vector3(worldSpaceBox.max_.x_, worldSpaceBox.min_.y_, worldSpaceBox.min_.z_));
-    vertices[2] = ModelTransform(viewProj_, Vector3(worldSpaceBox.min_.x_, worldSpaceBox.max_.y_, worldSpaceBox.min_.z_));
-    vertices[3] = ModelTransform(viewProj_, Vector3(worldSpaceBox.max_.x_, worldSpaceBox.max_.y_, worldSpaceBox.min_.z_));
-    vertices[4] = ModelTransform(viewProj_, Vector3(worldSpaceBox.min_.x_, worldSpaceBox.min_.y_, worldSpaceBox.max_.z_));
-    vertices[5] = ModelTransform(viewProj_, Vector3(worldSpaceBox.max_.x_, worldSpaceBox.min_.y_, worldSpaceBox.max_.z_));
-    vertices[6] = ModelTransform(viewProj_, Vector3(worldSpaceBox.min_.x_, worldSpaceBox.max_.y_, worldSpaceBox.max_.z_));
-    vertices[7] = ModelTransform(viewProj_, worldSpaceBox.max_);
-
-    // Apply a far clip relative bias
-    for (auto& vertice : vertices)
-        vertice.z_ -= OCCLUSION_RELATIVE_BIAS;
-
-    // Transform to screen space. If any of the corners cross the near plane, assume visible
-    float minX, maxX, minY, maxY, minZ;
-
-    if (vertices[0].z_ <= 0.0f)
-        return true;
+#ifdef URHO3D_SSE
+/// Return the horizontal minimum of four floats.
+static inline float HorizontalMin(__m128 value)
+{
+    value = _mm_min_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+    value = _mm_min_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(value);
+}
 
-    Vector3 projected = ViewportTransform(vertices[0]);
-    minX = maxX = projected.x_;
-    minY = maxY = projected.y_;
-    minZ = projected.z_;
+/// Return the horizontal maximum of four floats.
+static inline float HorizontalMax(__m128 value)
+{
+    value = _mm_max_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 0, 3, 2)));
+    value = _mm_max_ps(value, _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(value);
+}
+#endif
 
-    // Project the rest
-    for (unsigned i = 1; i < 8; ++i)
+void OcclusionBuffer::IsVisible(const BoundingBox* worldSpaceBoxes, unsigned numBoxes, bool* visible) const
+{
+    if (buffers_.Empty())
     {
-        if (vertices[i].z_ <= 0.0f)
-            return true;
+        for (unsigned i = 0; i < numBoxes; ++i)
+            visible[i] = true;
+        return;
+    }
 
-        projected = ViewportTransform(vertices[i]);
+#ifdef URHO3D_SSE
+    // Broadcast the view-projection matrix and the viewport transform once for the whole batch
+    __m128 m[16];
+    const float* matrixData = viewProj_.Data();
+    for (unsigned i = 0; i < 16; ++i)
+        m[i] = _mm_set1_ps(matrixData[i]);
+    __m128 scaleX = _mm_set1_ps(scaleX_);
+    __m128 scaleY = _mm_set1_ps(scaleY_);
+    __m128 offsetX = _mm_set1_ps(offsetX_);
+    __m128 offsetY = _mm_set1_ps(offsetY_);
+    __m128 scaleZ = _mm_set1_ps(OCCLUSION_Z_SCALE);
+    __m128 bias = _mm_set1_ps(OCCLUSION_RELATIVE_BIAS);
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+#endif
+
+    for (unsigned i = 0; i < numBoxes; ++i)
+    {
+        const BoundingBox& box = worldSpaceBoxes[i];
+        Vector3 projectedMin;
+        Vector3 projectedMax;
+
+#ifdef URHO3D_SSE
+        // Transform four corners at a time to projection space and then to screen space
+        __m128 x = _mm_setr_ps(box.min_.x_, box.max_.x_, box.min_.x_, box.max_.x_);
+        __m128 y = _mm_setr_ps(box.min_.y_, box.min_.y_, box.max_.y_, box.max_.y_);
+        __m128 minX = _mm_set1_ps(M_INFINITY);
+        __m128 minY = minX;
+        __m128 minZ = minX;
+        __m128 maxX = _mm_set1_ps(-M_INFINITY);
+        __m128 maxY = maxX;
+        bool nearClipped = false;
+
+        for (unsigned j = 0; j < 2; ++j)
+        {
+            __m128 z = _mm_set1_ps(j ? box.max_.z_ : box.min_.z_);
+            __m128 clipX = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0], x), _mm_mul_ps(m[1], y)), _mm_mul_ps(m[2], z)), m[3]);
+            __m128 clipY = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[4], x), _mm_mul_ps(m[5], y)), _mm_mul_ps(m[6], z)), m[7]);
+            __m128 clipZ = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[8], x), _mm_mul_ps(m[9], y)), _mm_mul_ps(m[10], z)), m[11]);
+            __m128 clipW = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[12], x), _mm_mul_ps(m[13], y)), _mm_mul_ps(m[14], z)), m[15]);
+
+            // Apply a far clip relative bias. If any of the corners cross the near plane, assume visible
+            clipZ = _mm_sub_ps(clipZ, bias);
+            if (_mm_movemask_ps(_mm_cmple_ps(clipZ, zero)))
+            {
+                nearClipped = true;
+                break;
+            }
 
-        if (projected.x_ < minX) minX = projected.x_;
-        if (projected.x_ > maxX) maxX = projected.x_;
-        if (projected.y_ < minY) minY = projected.y_;
-        if (projected.y_ > maxY) maxY = projected.y_;
-        if (projected.z_ < minZ) minZ = projected.z_;
+            __m128 invW = _mm_div_ps(one, clipW);
+            __m128 screenX = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(invW, clipX), scaleX), offsetX);
+            __m128 screenY = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(invW, clipY), scaleY), offsetY);
+            __m128 screenZ = _mm_mul_ps(_mm_mul_ps(invW, clipZ), scaleZ);
+            minX = _mm_min_ps(minX, screenX);
+            maxX = _mm_max_ps(maxX, screenX);
+            minY = _mm_min_ps(minY, screenY);
+            maxY = _mm_max_ps(maxY, screenY);
+            minZ = _mm_min_ps(minZ, screenZ);
+        }
+
+        if (nearClipped)
+        {
+            visible[i] = true;
+            continue;
+        }
+
+        projectedMin = Vector3(HorizontalMin(minX), HorizontalMin(minY), HorizontalMin(minZ));
+        projectedMax = Vector3(HorizontalMax(maxX), HorizontalMax(maxY), 0.0f);
+#else
+        // Transform corners to projection space
+        Vector4 vertices[8];
+        vertices[0] = ModelTransform(viewProj_, box.min_);
+        vertices[1] = ModelTransform(viewProj_, Vector3(box.max_.x_, box.min_.y_, box.min_.z_));
+        vertices[2] = ModelTransform(viewProj_, Vector3(box.min_.x_, box.max_.y_, box.min_.z_));
+        vertices[3] = ModelTransform(viewProj_, Vector3(box.max_.x_, box.max_.y_, box.min_.z_));
+        vertices[4] = ModelTransform(viewProj_, Vector3(box.min_.x_, box.min_.y_, box.max_.z_));
+        vertices[5] = ModelTransform(viewProj_, Vector3(box.max_.x_, box.min_.y_, box.max_.z_));
+        vertices[6] = ModelTransform(viewProj_, Vector3(box.min_.x_, box.max_.y_, box.max_.z_));
+        vertices[7] = ModelTransform(viewProj_, box.max_);
+
+        // Apply a far clip relative bias
+        for (auto& vertice : vertices)
+            vertice.z_ -= OCCLUSION_RELATIVE_BIAS;
+
+        // Transform to screen space. If any of the corners cross the near plane, assume visible
+        projectedMin = Vector3(M_INFINITY, M_INFINITY, M_INFINITY);
+        projectedMax = Vector3(-M_INFINITY, -M_INFINITY, 0.0f);
+        bool nearClipped = false;
+
+        for (auto& vertice : vertices)
+        {
+            if (vertice.z_ <= 0.0f)
+            {
+                nearClipped = true;
+                break;
+            }
+
+            Vector3 projected = ViewportTransform(vertice);
+            projectedMin = VectorMin(projectedMin, projected);
+            projectedMax.x_ = Max(projectedMax.x_, projected.x_);
+            projectedMax.y_ = Max(projectedMax.y_, projected.y_);
+        }
+
+        if (nearClipped)
+        {
+            visible[i] = true;
+            continue;
+        }
+#endif
+
+        visible[i] = IsProjectedBoxVisible(projectedMin, projectedMax);
     }
+}
+
+bool OcclusionBuffer::IsProjectedBoxVisible(const Vector3& projectedMin, const Vector3& projectedMax) const
+{
+    float minX = projectedMin.x_;
+    float minY = projectedMin.y_;
+    float minZ = projectedMin.z_;
+    float maxX = projectedMax.x_;
+    float maxY = projectedMax.y_;
 
     // Expand the bounding box 1 pixel in each direction to be conservative and correct rasterization offset
     IntRect rect((int)(minX - 1.5f), (int)(minY - 1.5f), RoundToInt(maxX), RoundToInt(maxY));
@@ -463,12 +616,7 @@ unsigned OcclusionBuffer::GetUseTimer()
 
 void OcclusionBuffer::DrawBatch(const OcclusionBatch& batch, unsigned threadIndex)
 {
-    // If buffer not yet used, clear it
-    if (threadIndex > 0 && !buffers_[threadIndex].used_)
-    {
-        ClearBuffer(threadIndex);
-        buffers_[threadIndex].used_ = true;
-    }
+    buffers_[threadIndex].used_ = true;
 
     Matrix4 modelViewProj = viewProj_ * batch.model_;
 
@@ -586,6 +734,23 @@ void OcclusionBuffer::CalculateViewport()
     projOffsetScaleY_ = projection_.m11_ * scaleY_;
 }
 
+void OcclusionBuffer::CalculateTiles()
+{
+    tileWidth_ = Min(width_, OCCLUSION_TILE_WIDTH);
+    numTilesX_ = (width_ + tileWidth_ - 1) / tileWidth_;
+    int numTilesY = (height_ + OCCLUSION_TILE_HEIGHT - 1) / OCCLUSION_TILE_HEIGHT;
+
+    tileRects_.Clear();
+    for (int y = 0; y < numTilesY; ++y)
+    {
+        for (int x = 0; x < numTilesX_; ++x)
+        {
+            tileRects_.Push(IntRect(x * tileWidth_, y * OCCLUSION_TILE_HEIGHT, Min((x + 1) * tileWidth_, width_),
+                Min((y + 1) * OCCLUSION_TILE_HEIGHT, height_)));
+        }
+    }
+}
+
 void OcclusionBuffer::DrawTriangle(Vector4* vertices, unsigned threadIndex)
 {
     ClipMaskFlags clipMask{};
@@ -633,7 +798,7 @@ void OcclusionBuffer::DrawTriangle(Vector4* vertices, unsigned threadIndex)
         bool clockwise = SignedArea(projected[0], projected[1], projected[2]) < 0.0f;
         if (cullMode_ == CULL_NONE || (cullMode_ == CULL_CCW && clockwise) || (cullMode_ == CULL_CW && !clockwise))
         {
-            DrawTriangle2D(projected, clockwise, threadIndex);
+            SetupTriangle(projected, threadIndex);
             drawOk = true;
         }
     }
@@ -671,7 +836,7 @@ void OcclusionBuffer::DrawTriangle(Vector4* vertices, unsigned threadIndex)
                 bool clockwise = SignedArea(projected[0], projected[1], projected[2]) < 0.0f;
                 if (cullMode_ == CULL_NONE || (cullMode_ == CULL_CCW && clockwise) || (cullMode_ == CULL_CW && !clockwise))
                 {
-                    DrawTriangle2D(projected, clockwise, threadIndex);
+                    SetupTriangle(projected, threadIndex);
                     drawOk = true;
                 }
             }
@@ -752,274 +917,200 @@ void OcclusionBuffer::ClipVertices(const Vector4& plane, Vector4* vertices, bool
     }
 }
 
-// Code based on Chris Hecker's Perspective Texture Mapping series in the Game Developer magazine
-// Also available online at http://chrishecker.com/Miscellaneous_Technical_Articles
-
-/// %Gradients of a software rasterized triangle.
-struct Gradients
+void OcclusionBuffer::SetupTriangle(const Vector3* vertices, unsigned threadIndex)
 {
-    /// Construct from vertices.
-    explicit Gradients(const Vector3* vertices)
-    {
-        float invdX = 1.0f / (((vertices[1].x_ - vertices[2].x_) *
-                               (vertices[0].y_ - vertices[2].y_)) -
-                              ((vertices[0].x_ - vertices[2].x_) *
-                               (vertices[1].y_ - vertices[2].y_)));
+    // Rows and columns sample the triangle one pixel down and right from the integer coordinates: shift the vertices so
+    // that the sample points are at integer coordinates
+    float x0 = vertices[0].x_ - 1.0f;
+    float y0 = vertices[0].y_ - 1.0f;
+    float x1 = vertices[1].x_ - 1.0f;
+    float y1 = vertices[1].y_ - 1.0f;
+    float x2 = vertices[2].x_ - 1.0f;
+    float y2 = vertices[2].y_ - 1.0f;
+
+    float area = (x1 - x0) * (y2 - y0) - (y1 - y0) * (x2 - x0);
+    if (area == 0.0f)
+        return;
+
+    // Reject triangles that do not cover any sample point
+    int minX = Max(CeilToInt(Min(Min(x0, x1), x2)), 0);
+    int minY = Max(CeilToInt(Min(Min(y0, y1), y2)), 0);
+    int maxX = Min(FloorToInt(Max(Max(x0, x1), x2)), width_ - 1);
+    int maxY = Min(FloorToInt(Max(Max(y0, y1), y2)), height_ - 1);
+    if (minX > maxX || minY > maxY)
+        return;
 
-        float invdY = -invdX;
+    OcclusionTriangle triangle;
 
-        dInvZdX_ = invdX * (((vertices[1].z_ - vertices[2].z_) * (vertices[0].y_ - vertices[2].y_)) -
-                            ((vertices[0].z_ - vertices[2].z_) * (vertices[1].y_ - vertices[2].y_)));
+    // Classify the edges by the side of the row span they bound. Horizontal edges only limit the rows. Unused bounds are
+    // set to infinity, so that a triangle needs no branching per row
+    float orientation = area > 0.0f ? 1.0f : -1.0f;
+    const float xs[3] = { x0, x1, x2 };
+    const float ys[3] = { y0, y1, y2 };
+    unsigned numLeft = 0;
+    unsigned numRight = 0;
+    triangle.leftSlope_[0] = triangle.leftSlope_[1] = triangle.rightSlope_[0] = triangle.rightSlope_[1] = 0.0f;
+    triangle.leftOffset_[0] = triangle.leftOffset_[1] = -M_INFINITY;
+    triangle.rightOffset_[0] = triangle.rightOffset_[1] = M_INFINITY;
 
-        dInvZdY_ = invdY * (((vertices[1].z_ - vertices[2].z_) * (vertices[0].x_ - vertices[2].x_)) -
-                            ((vertices[0].z_ - vertices[2].z_) * (vertices[1].x_ - vertices[2].x_)));
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        // Edge function a * x + b * y + c, positive inside the triangle regardless of winding
+        unsigned j = i < 2 ? i + 1 : 0;
+        float a = (ys[i] - ys[j]) * orientation;
+        float b = (xs[j] - xs[i]) * orientation;
+        float c = -(a * xs[i] + b * ys[i]);
 
-        dInvZdXInt_ = (int)dInvZdX_;
+        if (a > 0.0f && numLeft < 2)
+        {
+            triangle.leftSlope_[numLeft] = -b / a;
+            triangle.leftOffset_[numLeft++] = -c / a;
+        }
+        else if (a < 0.0f && numRight < 2)
+        {
+            triangle.rightSlope_[numRight] = -b / a;
+            triangle.rightOffset_[numRight++] = -c / a;
+        }
+        else if (b > 0.0f)
+            minY = Max(minY, CeilToInt(-c / b));
+        else if (b < 0.0f)
+            maxY = Min(maxY, FloorToInt(-c / b));
     }
 
-    /// Integer horizontal gradient.
-    int dInvZdXInt_;
-    /// Horizontal gradient.
-    float dInvZdX_;
-    /// Vertical gradient.
-    float dInvZdY_;
-};
+    if (minY > maxY)
+        return;
 
-/// %Edge of a software rasterized triangle.
-struct Edge
-{
-    /// Construct from gradients and top & bottom vertices.
-    Edge(const Gradients& gradients, const Vector3& top, const Vector3& bottom, int topY)
+    // Depth plane through the vertices. Interpolated depth is clamped to the vertex depth range, so that precision errors
+    // on steep triangles can not produce depth values closer than the triangle
+    float invArea = 1.0f / area;
+    float dZ1 = vertices[1].z_ - vertices[0].z_;
+    float dZ2 = vertices[2].z_ - vertices[0].z_;
+    triangle.depthA_ = (dZ1 * (y2 - y0) - dZ2 * (y1 - y0)) * invArea;
+    triangle.depthB_ = (dZ2 * (x1 - x0) - dZ1 * (x2 - x0)) * invArea;
+    triangle.depthC_ = vertices[0].z_ - triangle.depthA_ * x0 - triangle.depthB_ * y0;
+    triangle.minDepth_ = Min(Min(vertices[0].z_, vertices[1].z_), vertices[2].z_);
+    triangle.maxDepth_ = Max(Max(vertices[0].z_, vertices[1].z_), vertices[2].z_);
+    triangle.minX_ = minX;
+    triangle.minY_ = minY;
+    triangle.maxX_ = maxX;
+    triangle.maxY_ = maxY;
+
+    // Without threading, rasterize immediately with the whole buffer as the tile
+    if (buffers_.Size() == 1)
     {
-        float height = (bottom.y_ - top.y_);
-        float slope = (height != 0.0f) ? (bottom.x_ - top.x_) / height : 0.0f;
-        float yPreStep = (float)(topY + 1) - top.y_;
-        float xPreStep = slope * yPreStep;
-
-        x_ = RoundToInt((xPreStep + top.x_) * OCCLUSION_X_SCALE);
-        xStep_ = RoundToInt(slope * OCCLUSION_X_SCALE);
-        invZ_ = RoundToInt(top.z_ + xPreStep * gradients.dInvZdX_ + yPreStep * gradients.dInvZdY_);
-        invZStep_ = RoundToInt(slope * gradients.dInvZdX_ + gradients.dInvZdY_);
+        RasterizeTriangle(triangle, IntRect(0, 0, width_, height_));
+        return;
     }
 
-    /// X coordinate.
-    int x_;
-    /// X coordinate step.
-    int xStep_;
-    /// Inverse Z.
-    int invZ_;
-    /// Inverse Z step.
-    int invZStep_;
-};
+    OcclusionBufferData& buffer = buffers_[threadIndex];
+    unsigned index = buffer.triangles_.Size();
+    buffer.triangles_.Push(triangle);
 
-void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices, bool clockwise, unsigned threadIndex)
-{
-    int top, middle, bottom;
-    bool middleIsRight;
-
-    // Sort vertices in Y-direction
-    if (vertices[0].y_ < vertices[1].y_)
+    // Bin to the overlapped tiles
+    int tileMaxX = maxX / tileWidth_;
+    int tileMaxY = maxY / OCCLUSION_TILE_HEIGHT;
+    for (int y = minY / OCCLUSION_TILE_HEIGHT; y <= tileMaxY; ++y)
     {
-        if (vertices[2].y_ < vertices[0].y_)
-        {
-            top = 2;
-            middle = 0;
-            bottom = 1;
-            middleIsRight = true;
-        }
-        else
-        {
-            top = 0;
-            if (vertices[1].y_ < vertices[2].y_)
-            {
-                middle = 1;
-                bottom = 2;
-                middleIsRight = true;
-            }
-            else
-            {
-                middle = 2;
-                bottom = 1;
-                middleIsRight = false;
-            }
-        }
+        for (int x = minX / tileWidth_; x <= tileMaxX; ++x)
+            buffer.tileTriangles_[y * numTilesX_ + x].Push(index);
     }
-    else
+}
+
+void OcclusionBuffer::RasterizeTiles(const IntRect* start, const IntRect* end)
+{
+    for (const IntRect* tile = start; tile != end; ++tile)
     {
-        if (vertices[2].y_ < vertices[1].y_)
-        {
-            top = 2;
-            middle = 1;
-            bottom = 0;
-            middleIsRight = false;
-        }
-        else
+        auto tileIndex = (unsigned)(tile - tileRects_.Buffer());
+
+        // Each tile is only touched by one thread, so the bins can be cleared here
+        for (Vector<OcclusionBufferData>::Iterator i = buffers_.Begin(); i != buffers_.End(); ++i)
         {
-            top = 1;
-            if (vertices[0].y_ < vertices[2].y_)
-            {
-                middle = 0;
-                bottom = 2;
-                middleIsRight = false;
-            }
-            else
-            {
-                middle = 2;
-                bottom = 0;
-                middleIsRight = true;
-            }
+            PODVector<unsigned>& bin = i->tileTriangles_[tileIndex];
+            const OcclusionTriangle* triangles = i->triangles_.Buffer();
+            for (PODVector<unsigned>::ConstIterator j = bin.Begin(); j != bin.End(); ++j)
+                RasterizeTriangle(triangles[*j], *tile);
+            bin.Clear();
         }
     }
+}
 
-    auto topY = (int)vertices[top].y_;
-    auto middleY = (int)vertices[middle].y_;
-    auto bottomY = (int)vertices[bottom].y_;
-
-    // Check for degenerate triangle
-    if (topY == bottomY)
+void OcclusionBuffer::RasterizeTriangle(const OcclusionTriangle& triangle, const IntRect& tile)
+{
+    int minX = Max(triangle.minX_, tile.left_);
+    int minY = Max(triangle.minY_, tile.top_);
+    int maxX = Min(triangle.maxX_, tile.right_ - 1);
+    int maxY = Min(triangle.maxY_, tile.bottom_ - 1);
+    if (minX > maxX || minY > maxY)
         return;
 
-    // Reverse middleIsRight test if triangle is counterclockwise
-    if (!clockwise)
-        middleIsRight = !middleIsRight;
-
-    const bool topDegenerate = topY == middleY;
-    const bool bottomDegenerate = middleY == bottomY;
+#ifdef URHO3D_SSE
+    __m128 depthA = _mm_set1_ps(triangle.depthA_);
+    __m128 depthStep = _mm_set1_ps(triangle.depthA_ * 4.0f);
+    __m128 minDepth = _mm_set1_ps(triangle.minDepth_);
+    __m128 maxDepth = _mm_set1_ps(triangle.maxDepth_);
+    __m128i laneOffsets = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i four = _mm_set1_epi32(4);
+#endif
 
-    Gradients gradients(vertices);
-    Edge topToBottom(gradients, vertices[top], vertices[bottom], topY);
+    int* row = buffers_[0].data_ + minY * width_;
 
-    int* bufferData = buffers_[threadIndex].data_;
-
-    if (middleIsRight)
+    for (int y = minY; y <= maxY; ++y, row += width_)
     {
-        // Top half
-        if (!topDegenerate)
-        {
-            Edge topToMiddle(gradients, vertices[top], vertices[middle], topY);
-            int* row = bufferData + topY * width_;
-            int* endRow = bufferData + middleY * width_;
-            while (row < endRow)
-            {
-                int invZ = topToBottom.invZ_;
-                int* dest = row + (topToBottom.x_ >> 16u);
-                int* end = row + (topToMiddle.x_ >> 16u);
-                while (dest < end)
-                {
-                    if (invZ < *dest)
-                        *dest = invZ;
-                    invZ += gradients.dInvZdXInt_;
-                    ++dest;
-                }
-
-                topToBottom.x_ += topToBottom.xStep_;
-                topToBottom.invZ_ += topToBottom.invZStep_;
-                topToMiddle.x_ += topToMiddle.xStep_;
-                row += width_;
-            }
-        }
-
-        // Bottom half
-        if (!bottomDegenerate)
-        {
-            Edge middleToBottom(gradients, vertices[middle], vertices[bottom], middleY);
-            int* row = bufferData + middleY * width_;
-            int* endRow = bufferData + bottomY * width_;
-            while (row < endRow)
-            {
-                int invZ = topToBottom.invZ_;
-                int* dest = row + (topToBottom.x_ >> 16u);
-                int* end = row + (middleToBottom.x_ >> 16u);
-                while (dest < end)
-                {
-                    if (invZ < *dest)
-                        *dest = invZ;
-                    invZ += gradients.dInvZdXInt_;
-                    ++dest;
-                }
+        // Find the span of sample points inside the triangle on this row
+        auto fy = (float)y;
+        float left = Max(Max((float)minX, triangle.leftSlope_[0] * fy + triangle.leftOffset_[0]),
+            triangle.leftSlope_[1] * fy + triangle.leftOffset_[1]);
+        float right = Min(Min((float)maxX, triangle.rightSlope_[0] * fy + triangle.rightOffset_[0]),
+            triangle.rightSlope_[1] * fy + triangle.rightOffset_[1]);
+        if (left > right)
+            continue;
 
-                topToBottom.x_ += topToBottom.xStep_;
-                topToBottom.invZ_ += topToBottom.invZStep_;
-                middleToBottom.x_ += middleToBottom.xStep_;
-                row += width_;
-            }
-        }
-    }
-    else
-    {
-        // Top half
-        if (!topDegenerate)
-        {
-            Edge topToMiddle(gradients, vertices[top], vertices[middle], topY);
-            int* row = bufferData + topY * width_;
-            int* endRow = bufferData + middleY * width_;
-            while (row < endRow)
-            {
-                int invZ = topToMiddle.invZ_;
-                int* dest = row + (topToMiddle.x_ >> 16u);
-                int* end = row + (topToBottom.x_ >> 16u);
-                while (dest < end)
-                {
-                    if (invZ < *dest)
-                        *dest = invZ;
-                    invZ += gradients.dInvZdXInt_;
-                    ++dest;
-                }
+        // Both ends are non-negative here, so truncation rounds down
+        auto spanStart = (int)left;
+        if ((float)spanStart < left)
+            ++spanStart;
+        auto spanEnd = (int)right;
+        if (spanStart > spanEnd)
+            continue;
 
-                topToMiddle.x_ += topToMiddle.xStep_;
-                topToMiddle.invZ_ += topToMiddle.invZStep_;
-                topToBottom.x_ += topToBottom.xStep_;
-                row += width_;
-            }
-        }
+        float rowDepth = triangle.depthB_ * fy + triangle.depthC_;
 
-        // Bottom half
-        if (!bottomDegenerate)
+#ifdef URHO3D_SSE
+        if (!(tileWidth_ & 3))
         {
-            Edge middleToBottom(gradients, vertices[middle], vertices[bottom], middleY);
-            int* row = bufferData + middleY * width_;
-            int* endRow = bufferData + bottomY * width_;
-            while (row < endRow)
+            // Write 4 pixels at a time with a coverage mask for the span ends. The tiles are 4-pixel aligned, so the
+            // pixel groups never cross into another tile
+            int groupStart = spanStart & ~3;
+            __m128i x = _mm_add_epi32(_mm_set1_epi32(groupStart), laneOffsets);
+            __m128i spanMin = _mm_set1_epi32(spanStart - 1);
+            __m128i spanMax = _mm_set1_epi32(spanEnd + 1);
+            __m128 depth = _mm_add_ps(_mm_mul_ps(depthA, _mm_cvtepi32_ps(x)), _mm_set1_ps(rowDepth));
+            int* dest = row + groupStart;
+            int* end = row + spanEnd;
+
+            while (dest <= end)
             {
-                int invZ = middleToBottom.invZ_;
-                int* dest = row + (middleToBottom.x_ >> 16u);
-                int* end = row + (topToBottom.x_ >> 16u);
-                while (dest < end)
-                {
-                    if (invZ < *dest)
-                        *dest = invZ;
-                    invZ += gradients.dInvZdXInt_;
-                    ++dest;
-                }
-
-                middleToBottom.x_ += middleToBottom.xStep_;
-                middleToBottom.invZ_ += middleToBottom.invZStep_;
-                topToBottom.x_ += topToBottom.xStep_;
-                row += width_;
+                __m128i covered = _mm_and_si128(_mm_cmpgt_epi32(x, spanMin), _mm_cmplt_epi32(x, spanMax));
+                __m128i z = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(depth, minDepth), maxDepth));
+                __m128i old = _mm_loadu_si128(reinterpret_cast<__m128i*>(dest));
+                __m128i write = _mm_and_si128(covered, _mm_cmplt_epi32(z, old));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_or_si128(_mm_and_si128(write, z), _mm_andnot_si128(write, old)));
+
+                x = _mm_add_epi32(x, four);
+                depth = _mm_add_ps(depth, depthStep);
+                dest += 4;
             }
-        }
-    }
-}
-
-void OcclusionBuffer::MergeBuffers()
-{
-    URHO3D_PROFILE(MergeBuffers);
 
-    for (unsigned i = 1; i < buffers_.Size(); ++i)
-    {
-        if (!buffers_[i].used_)
             continue;
+        }
+#endif
 
-        int* src = buffers_[i].data_;
-        int* dest = buffers_[0].data_;
-        int count = width_ * height_;
-
-        while (count--)
+        int* dest = row + spanStart;
+        for (int x = spanStart; x <= spanEnd; ++x)
         {
-            // If thread buffer's depth value is closer, overwrite the original
-            if (*src < *dest)
-                *dest = *src;
-            ++src;
+            auto z = (int)Clamp(triangle.depthA_ * (float)x + rowDepth, triangle.minDepth_, triangle.maxDepth_);
+            if (z < *dest)
+                *dest = z;
             ++dest;
         }
     }
@@ -1027,7 +1118,7 @@ void OcclusionBuffer::MergeBuffers()
 
 void OcclusionBuffer::ClearBuffer(unsigned threadIndex)
 {
-    if (threadIndex >= buffers_.Size())
+    if (threadIndex >= buffers_.Size() || !buffers_[threadIndex].data_)
         return;
 
     int* dest = buffers_[threadIndex].data_;
@@ -29,6 +29,7 @@
 #include "../Container/ArrayPtr.h"
 #include "../Graphics/GraphicsDefs.h"
 #include "../Math/Frustum.h"
+#include "../Math/Rect.h"
 
 namespace Urho3D
 {
@@ -36,10 +37,7 @@ namespace Urho3D
 class BoundingBox;
 class Camera;
 class IndexBuffer;
-class IntRect;
 class VertexBuffer;
-struct Edge;
-struct Gradients;
 
 /// Occlusion hierarchy depth value.
 struct DepthValue
@@ -50,13 +48,48 @@ struct DepthValue
     int max_;
 };
 
+/// Occluder triangle set up for tile rasterization.
+struct OcclusionTriangle
+{
+    /// Slopes of the edges bounding each row from the left, as X per row.
+    float leftSlope_[2];
+    /// X coordinates of the left edges at row zero.
+    float leftOffset_[2];
+    /// Slopes of the edges bounding each row from the right, as X per row.
+    float rightSlope_[2];
+    /// X coordinates of the right edges at row zero.
+    float rightOffset_[2];
+    /// Depth plane X coefficient.
+    float depthA_;
+    /// Depth plane Y coefficient.
+    float depthB_;
+    /// Depth plane constant.
+    float depthC_;
+    /// Minimum vertex depth.
+    float minDepth_;
+    /// Maximum vertex depth.
+    float maxDepth_;
+    /// Left pixel of the bounding rectangle.
+    int minX_;
+    /// Top pixel of the bounding rectangle.
+    int minY_;
+    /// Right pixel of the bounding rectangle, inclusive.
+    int maxX_;
+    /// Bottom pixel of the bounding rectangle, inclusive.
+    int maxY_;
+};
+
 /// Per-thread occlusion buffer data.
 struct OcclusionBufferData
 {
-    /// Full buffer data with safety padding.
+    /// Full buffer data with safety padding. Only allocated for the first buffer, which all threads rasterize into.
     SharedArrayPtr<int> dataWithSafety_;
     /// Buffer data.
     int* data_;
+    /// Triangles set up by the thread.
+    PODVector<OcclusionTriangle> triangles_;
+    /// Indices of the set up triangles binned per screen tile.
+    Vector<PODVector<unsigned> > tileTriangles_;
     /// Use flag.
     bool used_;
 };
@@ -81,13 +114,15 @@ struct OcclusionBatch
 };
 
 static const int OCCLUSION_MIN_SIZE = 8;
+static const int OCCLUSION_TILE_WIDTH = 32;
+static const int OCCLUSION_TILE_HEIGHT = 8;
 static const int OCCLUSION_DEFAULT_MAX_TRIANGLES = 5000;
 static const float OCCLUSION_RELATIVE_BIAS = 0.00001f;
 static const int OCCLUSION_FIXED_BIAS = 16;
 static const float OCCLUSION_X_SCALE = 65536.0f;
 static const float OCCLUSION_Z_SCALE = 16777216.0f;
 
-/// Software renderer for occlusion.
+/// Software renderer for occlusion. Occluder triangles are binned to screen tiles, which are rasterized independently, in parallel if threading is enabled.
 class URHO3D_API OcclusionBuffer : public Object
 {
     URHO3D_OBJECT(OcclusionBuffer, Object);
@@ -115,7 +150,7 @@ public:
     /// Submit a triangle mesh to the buffer using indexed geometry. Return true if did not overflow the allowed triangle count.
     bool AddTriangles(const Matrix3x4& model, const void* vertexData, unsigned vertexSize, const void* indexData, unsigned indexSize,
         unsigned indexStart, unsigned indexCount);
-    /// Draw submitted batches. Uses worker threads if enabled during SetSize().
+    /// Draw submitted batches. Uses worker threads for both triangle setup and tile rasterization if enabled during SetSize().
     void DrawTriangles();
     /// Build reduced size mip levels.
     void BuildDepthHierarchy();
@@ -151,11 +186,15 @@ public:
 
     /// Test a bounding box for visibility. For best performance, build depth hierarchy first.
     bool IsVisible(const BoundingBox& worldSpaceBox) const;
+    /// Test an array of bounding boxes for visibility and write the results. For best performance, build depth hierarchy first.
+    void IsVisible(const BoundingBox* worldSpaceBoxes, unsigned numBoxes, bool* visible) const;
     /// Return time since last use in milliseconds.
     unsigned GetUseTimer();
 
     /// Draw a batch. Called internally.
     void DrawBatch(const OcclusionBatch& batch, unsigned threadIndex);
+    /// Rasterize the binned triangles of a range of screen tiles. Called internally.
+    void RasterizeTiles(const IntRect* start, const IntRect* end);
 
 private:
     /// Apply modelview transform to vertex.
@@ -168,19 +207,25 @@ private:
     inline float SignedArea(const Vector3& v0, const Vector3& v1, const Vector3& v2) const;
     /// Calculate viewport transform.
     void CalculateViewport();
+    /// Calculate screen tile rectangles.
+    void CalculateTiles();
     /// Draw a triangle.
     void DrawTriangle(Vector4* vertices, unsigned threadIndex);
     /// Clip vertices against a plane.
     void ClipVertices(const Vector4& plane, Vector4* vertices, bool* triangles, unsigned& numTriangles);
-    /// Draw a clipped triangle.
-    void DrawTriangle2D(const Vector3* vertices, bool clockwise, unsigned threadIndex);
-    /// Clear a thread work buffer.
+    /// Set up a clipped triangle and bin it to the screen tiles it overlaps.
+    void SetupTriangle(const Vector3* vertices, unsigned threadIndex);
+    /// Rasterize a set up triangle within a screen tile.
+    void RasterizeTriangle(const OcclusionTriangle& triangle, const IntRect& tile);
+    /// Test a projected bounding box against the depth hierarchy and the pixel-level data.
+    bool IsProjectedBoxVisible(const Vector3& projectedMin, const Vector3& projectedMax) const;
+    /// Clear the buffer.
     void ClearBuffer(unsigned threadIndex);
-    /// Merge thread work buffers into the first buffer.
-    void MergeBuffers();
 
-    /// Highest-level buffer data per thread.
+    /// Highest-level buffer data and triangle bins per thread.
     Vector<OcclusionBufferData> buffers_;
+    /// Screen tile rectangles.
+    PODVector<IntRect> tileRects_;
     /// Reduced size depth buffers.
     Vector<SharedArrayPtr<DepthValue> > mipBuffers_;
     /// Submitted render jobs.
@@ -189,6 +234,10 @@ private:
     int width_{};
     /// Buffer height.
     int height_{};
+    /// Number of screen tiles horizontally.
+    int numTilesX_{};
+    /// Screen tile width.
+    int tileWidth_{};
     /// Number of rendered triangles.
     unsigned numTriangles_{};
     /// Maximum number of triangles.
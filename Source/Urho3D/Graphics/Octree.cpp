@@ -45,29 +45,35 @@ namespace Urho3D
 
 static const float DEFAULT_OCTREE_SIZE = 1000.0f;
 static const int DEFAULT_OCTREE_LEVELS = 8;
+static const float DEFAULT_TREE_MARGIN = 0.5f;
 
-extern const char* SUBSYSTEM_CATEGORY;
-
-void UpdateDrawablesWork(const WorkItem* item, unsigned threadIndex)
+static const char* spatialIndexNames[] =
 {
-    const FrameInfo& frame = *(reinterpret_cast<FrameInfo*>(item->aux_));
-    auto** start = reinterpret_cast<Drawable**>(item->start_);
-    auto** end = reinterpret_cast<Drawable**>(item->end_);
+    "Octree",
+    "AABB Tree",
+    nullptr
+};
 
-    while (start != end)
-    {
-        Drawable* drawable = *start;
-        if (drawable)
-            drawable->Update(frame);
-        ++start;
-    }
-}
+extern const char* SUBSYSTEM_CATEGORY;
 
 inline bool CompareRayQueryResults(const RayQueryResult& lhs, const RayQueryResult& rhs)
 {
     return lhs.distance_ < rhs.distance_;
 }
 
+/// Copy a drawable's packed bounds between blocks.
+static void CopyDrawableBounds(DrawableBoundsBlock& dest, unsigned destIndex, const DrawableBoundsBlock& src, unsigned srcIndex)
+{
+    dest.minX_[destIndex] = src.minX_[srcIndex];
+    dest.minY_[destIndex] = src.minY_[srcIndex];
+    dest.minZ_[destIndex] = src.minZ_[srcIndex];
+    dest.maxX_[destIndex] = src.maxX_[srcIndex];
+    dest.maxY_[destIndex] = src.maxY_[srcIndex];
+    dest.maxZ_[destIndex] = src.maxZ_[srcIndex];
+    dest.flags_[destIndex] = src.flags_[srcIndex];
+    dest.viewMasks_[destIndex] = src.viewMasks_[srcIndex];
+}
+
 Octant::Octant(const BoundingBox& box, unsigned level, Octant* parent, Octree* root, unsigned index) :
     level_(level),
     parent_(parent),
@@ -85,10 +91,11 @@ Octant::~Octant()
         for (PODVector<Drawable*>::Iterator i = drawables_.Begin(); i != drawables_.End(); ++i)
         {
             (*i)->SetOctant(root_);
-            root_->drawables_.Push(*i);
+            root_->PushDrawable(*i);
             root_->QueueUpdate(*i);
         }
         drawables_.Clear();
+        drawableBounds_.Clear();
         numDrawables_ = 0;
     }
 
@@ -136,10 +143,13 @@ void Octant::InsertDrawable(Drawable* drawable)
     const BoundingBox& box = drawable->GetWorldBoundingBox();
 
     // If root octant, insert all non-occludees here, so that octant occlusion does not hide the drawable.
-    // Also if drawable is outside the root octant bounds, insert to root
+    // Also if drawable is outside the root octant bounds, insert to root. When using the AABB tree, insert everything to root
     bool insertHere;
     if (this == root_)
-        insertHere = !drawable->IsOccludee() || cullingBox_.IsInside(box) != INSIDE || CheckDrawableFit(box);
+    {
+        insertHere = root_->spatialIndex_ == SPATIAL_INDEX_AABBTREE || !drawable->IsOccludee() ||
+            cullingBox_.IsInside(box) != INSIDE || CheckDrawableFit(box);
+    }
     else
         insertHere = CheckDrawableFit(box);
 
@@ -148,10 +158,13 @@ void Octant::InsertDrawable(Drawable* drawable)
         Octant* oldOctant = drawable->octant_;
         if (oldOctant != this)
         {
-            // Add first, then remove, because drawable count going to zero deletes the octree branch in question
+            // Erase from the old octant's list first, because the drawable only knows its index in the current octant.
+            // Decrease the old drawable count last, because drawable count going to zero deletes the octree branch in question
+            if (oldOctant)
+                oldOctant->EraseDrawable(drawable);
             AddDrawable(drawable);
             if (oldOctant)
-                oldOctant->RemoveDrawable(drawable, false);
+                oldOctant->DecDrawableCount();
         }
     }
     else
@@ -189,13 +202,42 @@ bool Octant::CheckDrawableFit(const BoundingBox& box) const
     return false;
 }
 
+void Octant::UpdateDrawableBounds(Drawable* drawable)
+{
+    unsigned index = drawable->octantIndex_;
+    assert(index < drawables_.Size() && drawables_[index] == drawable);
+
+    DrawableBoundsBlock& block = drawableBounds_[index / DRAWABLE_BOUNDS_BLOCK_SIZE];
+    index %= DRAWABLE_BOUNDS_BLOCK_SIZE;
+    block.viewMasks_[index] = drawable->GetViewMask();
+
+    // If the world bounding box is dirty or an update is queued, the box can not be safely calculated now (threaded update)
+    if (drawable->updateQueued_ || drawable->worldBoundingBoxDirty_)
+    {
+        block.flags_[index] = drawable->GetDrawableFlags() | DRAWABLE_BOUNDS_DIRTY;
+        return;
+    }
+
+    const BoundingBox& box = drawable->GetWorldBoundingBox();
+    block.minX_[index] = box.min_.x_;
+    block.minY_[index] = box.min_.y_;
+    block.minZ_[index] = box.min_.z_;
+    block.maxX_[index] = box.max_.x_;
+    block.maxY_[index] = box.max_.y_;
+    block.maxZ_[index] = box.max_.z_;
+    block.flags_[index] = drawable->GetDrawableFlags();
+}
+
 void Octant::ResetRoot()
 {
     root_ = nullptr;
 
     // The whole octree is being destroyed, just detach the drawables
     for (PODVector<Drawable*>::Iterator i = drawables_.Begin(); i != drawables_.End(); ++i)
+    {
         (*i)->SetOctant(nullptr);
+        (*i)->treeProxy_ = AABBTREE_NULL_NODE;
+    }
 
     for (auto& child : children_)
     {
@@ -244,7 +286,7 @@ void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside) const
     {
         auto** start = const_cast<Drawable**>(&drawables_[0]);
         Drawable** end = start + drawables_.Size();
-        query.TestDrawables(start, end, inside);
+        query.TestDrawableBounds(start, end, &drawableBounds_[0], inside);
     }
 
     for (auto child : children_)
@@ -308,11 +350,62 @@ void Octant::GetDrawablesOnlyInternal(RayOctreeQuery& query, PODVector<Drawable*
     }
 }
 
+void Octant::PushDrawable(Drawable* drawable)
+{
+    unsigned index = drawables_.Size();
+    drawables_.Push(drawable);
+    drawable->octantIndex_ = index;
+
+    if (index % DRAWABLE_BOUNDS_BLOCK_SIZE == 0)
+        drawableBounds_.Push(DrawableBoundsBlock());
+    UpdateDrawableBounds(drawable);
+
+    if (this == root_)
+        root_->AddToTree(drawable);
+}
+
+bool Octant::EraseDrawable(Drawable* drawable)
+{
+    unsigned index = drawable->octantIndex_;
+    if (index >= drawables_.Size() || drawables_[index] != drawable)
+        return false;
+
+    if (this == root_)
+        root_->RemoveFromTree(drawable);
+
+    // Move the last drawable into the freed slot to keep the packed bounds contiguous
+    unsigned lastIndex = drawables_.Size() - 1;
+    DrawableBoundsBlock& lastBlock = drawableBounds_[lastIndex / DRAWABLE_BOUNDS_BLOCK_SIZE];
+    if (index != lastIndex)
+    {
+        Drawable* last = drawables_[lastIndex];
+        drawables_[index] = last;
+        last->octantIndex_ = index;
+        CopyDrawableBounds(drawableBounds_[index / DRAWABLE_BOUNDS_BLOCK_SIZE], index % DRAWABLE_BOUNDS_BLOCK_SIZE, lastBlock,
+            lastIndex % DRAWABLE_BOUNDS_BLOCK_SIZE);
+    }
+    drawables_.Pop();
+
+    // Unused slots must have zero flags so that queries reject them
+    if (lastIndex % DRAWABLE_BOUNDS_BLOCK_SIZE == 0)
+        drawableBounds_.Pop();
+    else
+    {
+        lastBlock.flags_[lastIndex % DRAWABLE_BOUNDS_BLOCK_SIZE] = 0;
+        lastBlock.viewMasks_[lastIndex % DRAWABLE_BOUNDS_BLOCK_SIZE] = 0;
+    }
+
+    return true;
+}
+
 Octree::Octree(Context* context) :
     Component(context),
     Octant(BoundingBox(-DEFAULT_OCTREE_SIZE, DEFAULT_OCTREE_SIZE), 0, nullptr, this),
-    numLevels_(DEFAULT_OCTREE_LEVELS)
+    numLevels_(DEFAULT_OCTREE_LEVELS),
+    spatialIndex_(SPATIAL_INDEX_OCTREE)
 {
+    tree_.SetMargin(DEFAULT_TREE_MARGIN);
+
     // If the engine is running headless, subscribe to RenderUpdate events for manually updating the octree
     // to allow raycasts and animation update
     if (!GetSubsystem<Graphics>())
@@ -323,6 +416,9 @@ Octree::~Octree()
 {
     // Reset root pointer from all child octants now so that they do not move their drawables to root
     drawableUpdates_.Clear();
+    for (PODVector<Drawable*>::Iterator i = boundsUpdates_.Begin(); i != boundsUpdates_.End(); ++i)
+        (*i)->boundsUpdateQueued_ = false;
+    boundsUpdates_.Clear();
     ResetRoot();
 }
 
@@ -336,6 +432,9 @@ void Octree::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE_EX("Bounding Box Min", Vector3, worldBoundingBox_.min_, UpdateOctreeSize, defaultBoundsMin, AM_DEFAULT);
     URHO3D_ATTRIBUTE_EX("Bounding Box Max", Vector3, worldBoundingBox_.max_, UpdateOctreeSize, defaultBoundsMax, AM_DEFAULT);
     URHO3D_ATTRIBUTE_EX("Number of Levels", int, numLevels_, UpdateOctreeSize, DEFAULT_OCTREE_LEVELS, AM_DEFAULT);
+    URHO3D_ENUM_ACCESSOR_ATTRIBUTE("Spatial Index", GetSpatialIndex, SetSpatialIndex, SpatialIndexType, spatialIndexNames,
+        SPATIAL_INDEX_OCTREE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("AABB Tree Margin", GetTreeMargin, SetTreeMargin, float, DEFAULT_TREE_MARGIN, AM_DEFAULT);
 }
 
 void Octree::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
@@ -344,7 +443,10 @@ void Octree::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
     {
         URHO3D_PROFILE(OctreeDrawDebug);
 
-        Octant::DrawDebugGeometry(debug, depthTest);
+        if (spatialIndex_ == SPATIAL_INDEX_AABBTREE)
+            tree_.DrawDebugGeometry(debug, depthTest);
+        else
+            Octant::DrawDebugGeometry(debug, depthTest);
     }
 }
 
@@ -361,6 +463,45 @@ void Octree::SetSize(const BoundingBox& box, unsigned numLevels)
     numLevels_ = Max(numLevels, 1U);
 }
 
+void Octree::SetSpatialIndex(SpatialIndexType type)
+{
+    if (type == spatialIndex_)
+        return;
+
+    URHO3D_PROFILE(ChangeSpatialIndex);
+
+    if (type == SPATIAL_INDEX_AABBTREE)
+    {
+        // Move the drawables to the root octant, then build the tree from them
+        for (unsigned i = 0; i < NUM_OCTANTS; ++i)
+            DeleteChild(i);
+
+        spatialIndex_ = type;
+        for (PODVector<Drawable*>::Iterator i = drawables_.Begin(); i != drawables_.End(); ++i)
+            AddToTree(*i);
+    }
+    else
+    {
+        spatialIndex_ = type;
+        tree_.Clear();
+        treeNonOccludees_.Clear();
+
+        // Queue the drawables for reinsertion from the root octant into child octants
+        for (PODVector<Drawable*>::Iterator i = drawables_.Begin(); i != drawables_.End(); ++i)
+        {
+            Drawable* drawable = *i;
+            drawable->treeProxy_ = AABBTREE_NULL_NODE;
+            if (!drawable->updateQueued_)
+                QueueUpdate(drawable);
+        }
+    }
+}
+
+void Octree::SetTreeMargin(float margin)
+{
+    tree_.SetMargin(margin);
+}
+
 void Octree::Update(const FrameInfo& frame)
 {
     if (!Thread::IsMainThread())
@@ -380,30 +521,15 @@ void Octree::Update(const FrameInfo& frame)
         auto* queue = GetSubsystem<WorkQueue>();
         scene->BeginThreadedUpdate();
 
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = Max((int)(drawableUpdates_.Size() / numWorkItems), 1);
-
-        PODVector<Drawable*>::Iterator start = drawableUpdates_.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
+        Drawable** drawables = drawableUpdates_.Buffer();
+        queue->ParallelFor(0, drawableUpdates_.Size(), 0, [drawables, &frame](unsigned begin, unsigned end, unsigned threadIndex)
         {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = UpdateDrawablesWork;
-            item->aux_ = const_cast<FrameInfo*>(&frame);
-
-            PODVector<Drawable*>::Iterator end = drawableUpdates_.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
-        }
-
-        queue->Complete(M_MAX_UNSIGNED);
+            for (unsigned i = begin; i < end; ++i)
+            {
+                if (drawables[i])
+                    drawables[i]->Update(frame);
+            }
+        });
         scene->EndThreadedUpdate();
     }
 
@@ -453,11 +579,22 @@ void Octree::Update(const FrameInfo& frame)
             // Skip if no octant or does not belong to this octree anymore
             if (!octant || octant->GetRoot() != this)
                 continue;
+            // With the AABB tree the drawables stay in the root octant, and only the tree leaf needs to be updated
+            if (spatialIndex_ == SPATIAL_INDEX_AABBTREE)
+            {
+                UpdateInTree(drawable);
+                octant->UpdateDrawableBounds(drawable);
+                continue;
+            }
             // Skip if still fits the current octant
             if (drawable->IsOccludee() && octant->GetCullingBox().IsInside(box) == INSIDE && octant->CheckDrawableFit(box))
+            {
+                octant->UpdateDrawableBounds(drawable);
                 continue;
+            }
 
             InsertDrawable(drawable);
+            drawable->GetOctant()->UpdateDrawableBounds(drawable);
 
 #ifdef _DEBUG
             // Verify that the drawable will be culled correctly
@@ -472,6 +609,9 @@ void Octree::Update(const FrameInfo& frame)
     }
 
     drawableUpdates_.Clear();
+
+    // Refresh the packed bounds of drawables that were updated in worker threads
+    ApplyBoundsUpdates();
 }
 
 void Octree::AddManualDrawable(Drawable* drawable)
@@ -495,7 +635,18 @@ void Octree::RemoveManualDrawable(Drawable* drawable)
 void Octree::GetDrawables(OctreeQuery& query) const
 {
     query.result_.Clear();
-    GetDrawablesInternal(query, false);
+
+    if (spatialIndex_ == SPATIAL_INDEX_AABBTREE)
+    {
+        tree_.GetDrawables(query);
+        if (!treeNonOccludees_.Empty())
+        {
+            auto** start = const_cast<Drawable**>(&treeNonOccludees_[0]);
+            query.TestDrawables(start, start + treeNonOccludees_.Size(), false);
+        }
+    }
+    else
+        GetDrawablesInternal(query, false);
 }
 
 void Octree::Raycast(RayOctreeQuery& query) const
@@ -503,7 +654,20 @@ void Octree::Raycast(RayOctreeQuery& query) const
     URHO3D_PROFILE(Raycast);
 
     query.result_.Clear();
-    GetDrawablesInternal(query);
+
+    if (spatialIndex_ == SPATIAL_INDEX_AABBTREE)
+    {
+        tree_.Raycast(query);
+        for (PODVector<Drawable*>::ConstIterator i = treeNonOccludees_.Begin(); i != treeNonOccludees_.End(); ++i)
+        {
+            Drawable* drawable = *i;
+            if ((drawable->GetDrawableFlags() & query.drawableFlags_) && (drawable->GetViewMask() & query.viewMask_))
+                drawable->ProcessRayQuery(query, query.result_);
+        }
+    }
+    else
+        GetDrawablesInternal(query);
+
     Sort(query.result_.Begin(), query.result_.End(), CompareRayQueryResults);
 }
 
@@ -513,7 +677,19 @@ void Octree::RaycastSingle(RayOctreeQuery& query) const
 
     query.result_.Clear();
     rayQueryDrawables_.Clear();
-    GetDrawablesOnlyInternal(query, rayQueryDrawables_);
+
+    if (spatialIndex_ == SPATIAL_INDEX_AABBTREE)
+    {
+        tree_.GetDrawablesOnly(query, rayQueryDrawables_);
+        for (PODVector<Drawable*>::ConstIterator i = treeNonOccludees_.Begin(); i != treeNonOccludees_.End(); ++i)
+        {
+            Drawable* drawable = *i;
+            if ((drawable->GetDrawableFlags() & query.drawableFlags_) && (drawable->GetViewMask() & query.viewMask_))
+                rayQueryDrawables_.Push(drawable);
+        }
+    }
+    else
+        GetDrawablesOnlyInternal(query, rayQueryDrawables_);
 
     // Sort by increasing hit distance to AABB
     for (PODVector<Drawable*>::Iterator i = rayQueryDrawables_.Begin(); i != rayQueryDrawables_.End(); ++i)
@@ -559,6 +735,9 @@ void Octree::QueueUpdate(Drawable* drawable)
         drawableUpdates_.Push(drawable);
 
     drawable->updateQueued_ = true;
+    // Flag the packed bounds stale so that queries test the drawable itself until reinsertion
+    if (drawable->octant_)
+        drawable->octant_->UpdateDrawableBounds(drawable);
 }
 
 void Octree::CancelUpdate(Drawable* drawable)
@@ -569,12 +748,85 @@ void Octree::CancelUpdate(Drawable* drawable)
     drawable->updateQueued_ = false;
 }
 
+void Octree::QueueBoundsUpdate(Drawable* drawable)
+{
+    MutexLock lock(octreeMutex_);
+    if (drawable->boundsUpdateQueued_)
+        return;
+
+    boundsUpdates_.Push(drawable);
+    drawable->boundsUpdateQueued_ = true;
+}
+
+void Octree::CancelBoundsUpdate(Drawable* drawable)
+{
+    // Called only when removing a drawable from octree, which happens from the main thread
+    boundsUpdates_.Remove(drawable);
+    drawable->boundsUpdateQueued_ = false;
+}
+
+void Octree::ApplyBoundsUpdates()
+{
+    // Index loop, as calculating a box may queue more refreshes
+    for (unsigned i = 0; i < boundsUpdates_.Size(); ++i)
+    {
+        Drawable* drawable = boundsUpdates_[i];
+        Octant* octant = drawable->GetOctant();
+        if (octant && octant->GetRoot() == this)
+        {
+            // Calculate the box now so that the packed bounds are written instead of flagged dirty. A queued reinsertion
+            // writes them later
+            if (!drawable->updateQueued_)
+                drawable->GetWorldBoundingBox();
+            octant->UpdateDrawableBounds(drawable);
+        }
+        drawable->boundsUpdateQueued_ = false;
+    }
+
+    boundsUpdates_.Clear();
+}
+
 void Octree::DrawDebugGeometry(bool depthTest)
 {
     auto* debug = GetComponent<DebugRenderer>();
     DrawDebugGeometry(debug, depthTest);
 }
 
+void Octree::AddToTree(Drawable* drawable)
+{
+    if (spatialIndex_ != SPATIAL_INDEX_AABBTREE)
+        return;
+
+    // Non-occludees are kept out of the tree, so that occlusion of a tree node does not hide them
+    if (drawable->IsOccludee())
+        drawable->treeProxy_ = tree_.CreateProxy(drawable, drawable->GetWorldBoundingBox());
+    else
+        treeNonOccludees_.Push(drawable);
+}
+
+void Octree::RemoveFromTree(Drawable* drawable)
+{
+    if (drawable->treeProxy_ != AABBTREE_NULL_NODE)
+    {
+        tree_.DestroyProxy(drawable->treeProxy_);
+        drawable->treeProxy_ = AABBTREE_NULL_NODE;
+    }
+    else if (spatialIndex_ == SPATIAL_INDEX_AABBTREE)
+        treeNonOccludees_.Remove(drawable);
+}
+
+void Octree::UpdateInTree(Drawable* drawable)
+{
+    bool inTree = drawable->treeProxy_ != AABBTREE_NULL_NODE;
+    if (drawable->IsOccludee() != inTree)
+    {
+        RemoveFromTree(drawable);
+        AddToTree(drawable);
+    }
+    else if (inTree)
+        tree_.MoveProxy(drawable->treeProxy_, drawable->GetWorldBoundingBox());
+}
+
 void Octree::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
 {
     // When running in headless mode, update the Octree manually during the RenderUpdate event
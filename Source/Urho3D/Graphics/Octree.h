@@ -25,6 +25,7 @@
 #include "../Container/List.h"
 #include "../Core/Mutex.h"
 #include "../Graphics/Drawable.h"
+#include "../Graphics/DynamicAABBTree.h"
 #include "../Graphics/OctreeQuery.h"
 
 namespace Urho3D
@@ -35,6 +36,15 @@ class Octree;
 static const int NUM_OCTANTS = 8;
 static const unsigned ROOT_INDEX = M_MAX_UNSIGNED;
 
+/// Spatial index used by the octree component.
+enum SpatialIndexType
+{
+    /// Fixed-depth octree of octants.
+    SPATIAL_INDEX_OCTREE = 0,
+    /// Dynamic AABB tree with fattened leaf bounds. All drawables are kept in the root octant.
+    SPATIAL_INDEX_AABBTREE
+};
+
 /// %Octree octant.
 /// @nobind
 class URHO3D_API Octant
@@ -58,14 +68,14 @@ public:
     void AddDrawable(Drawable* drawable)
     {
         drawable->SetOctant(this);
-        drawables_.Push(drawable);
+        PushDrawable(drawable);
         IncDrawableCount();
     }
 
     /// Remove a drawable object from this octant.
     void RemoveDrawable(Drawable* drawable, bool resetOctant = true)
     {
-        if (drawables_.Remove(drawable))
+        if (EraseDrawable(drawable))
         {
             if (resetOctant)
                 drawable->SetOctant(nullptr);
@@ -95,6 +105,8 @@ public:
     /// Return true if there are no drawable objects in this octant and child octants.
     bool IsEmpty() { return numDrawables_ == 0; }
 
+    /// Refresh the packed bounds of a drawable object in this octant after its world bounding box, view mask or update queued state has changed.
+    void UpdateDrawableBounds(Drawable* drawable);
     /// Reset root pointer recursively. Called when the whole octree is being destroyed.
     void ResetRoot();
     /// Draw bounds to the debug graphics recursively.
@@ -109,6 +121,10 @@ protected:
     void GetDrawablesInternal(RayOctreeQuery& query) const;
     /// Return drawable objects only for a threaded ray query, called internally.
     void GetDrawablesOnlyInternal(RayOctreeQuery& query, PODVector<Drawable*>& drawables) const;
+    /// Append a drawable object to the drawable list and packed bounds without changing drawable counts.
+    void PushDrawable(Drawable* drawable);
+    /// Remove a drawable object from the drawable list and packed bounds without changing drawable counts. Return true if it was found.
+    bool EraseDrawable(Drawable* drawable);
 
     /// Increase drawable object count recursively.
     void IncDrawableCount()
@@ -140,6 +156,8 @@ protected:
     BoundingBox cullingBox_;
     /// Drawable objects.
     PODVector<Drawable*> drawables_;
+    /// Packed bounding boxes, flags and view masks of the drawable objects, in the same order.
+    PODVector<DrawableBoundsBlock> drawableBounds_;
     /// Child octants.
     Octant* children_[NUM_OCTANTS]{};
     /// World bounding box center.
@@ -163,6 +181,8 @@ class URHO3D_API Octree : public Component, public Octant
 {
     URHO3D_OBJECT(Octree, Component);
 
+    friend class Octant;
+
 public:
     /// Construct.
     explicit Octree(Context* context);
@@ -176,6 +196,12 @@ public:
 
     /// Set size and maximum subdivision levels. If octree is not empty, drawable objects will be temporarily moved to the root.
     void SetSize(const BoundingBox& box, unsigned numLevels);
+    /// Set spatial index type. Drawable objects are moved to the new index.
+    /// @property
+    void SetSpatialIndex(SpatialIndexType type);
+    /// Set margin added to each side of the drawable bounding boxes in the AABB tree. Larger margins mean fewer tree updates for moving objects but looser culling.
+    /// @property
+    void SetTreeMargin(float margin);
     /// Update and reinsert drawable objects.
     void Update(const FrameInfo& frame);
     /// Add a drawable manually.
@@ -195,10 +221,27 @@ public:
     /// @property
     unsigned GetNumLevels() const { return numLevels_; }
 
+    /// Return spatial index type.
+    /// @property
+    SpatialIndexType GetSpatialIndex() const { return spatialIndex_; }
+
+    /// Return AABB tree margin.
+    /// @property
+    float GetTreeMargin() const { return tree_.GetMargin(); }
+
+    /// Return the AABB tree. Empty when not using the AABB tree spatial index.
+    const DynamicAABBTree& GetTree() const { return tree_; }
+
     /// Mark drawable object as requiring an update and a reinsertion.
     void QueueUpdate(Drawable* drawable);
     /// Cancel drawable object's update.
     void CancelUpdate(Drawable* drawable);
+    /// Queue refreshing drawable object's packed bounds on the main thread. Thread-safe.
+    void QueueBoundsUpdate(Drawable* drawable);
+    /// Cancel drawable object's packed bounds refresh.
+    void CancelBoundsUpdate(Drawable* drawable);
+    /// Refresh the packed bounds of the queued drawable objects. Called from the main thread before querying.
+    void ApplyBoundsUpdates();
     /// Visualize the component as debug geometry.
     void DrawDebugGeometry(bool depthTest);
 
@@ -207,17 +250,31 @@ private:
     void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
     /// Update octree size.
     void UpdateOctreeSize() { SetSize(worldBoundingBox_, numLevels_); }
+    /// Add a drawable object that was added to the root octant to the AABB tree, if in use.
+    void AddToTree(Drawable* drawable);
+    /// Remove a drawable object that was removed from the root octant from the AABB tree.
+    void RemoveFromTree(Drawable* drawable);
+    /// Update a drawable object's AABB tree leaf after it has moved or its occludee flag has changed.
+    void UpdateInTree(Drawable* drawable);
 
     /// Drawable objects that require update.
     PODVector<Drawable*> drawableUpdates_;
     /// Drawable objects that were inserted during threaded update phase.
     PODVector<Drawable*> threadedDrawableUpdates_;
-    /// Mutex for octree reinsertions.
+    /// Drawable objects whose packed bounds require refreshing.
+    PODVector<Drawable*> boundsUpdates_;
+    /// Mutex for octree reinsertions and packed bounds refreshes.
     Mutex octreeMutex_;
     /// Ray query temporary list of drawables.
     mutable PODVector<Drawable*> rayQueryDrawables_;
     /// Subdivision level.
     unsigned numLevels_;
+    /// Spatial index type.
+    SpatialIndexType spatialIndex_;
+    /// AABB tree of occludee drawable objects.
+    DynamicAABBTree tree_;
+    /// Drawable objects that are not occludees and are therefore not culled through the AABB tree.
+    PODVector<Drawable*> treeNonOccludees_;
 };
 
 }
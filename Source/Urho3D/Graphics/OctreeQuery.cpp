@@ -24,11 +24,119 @@
 
 #include "../Graphics/OctreeQuery.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
 {
 
+static const unsigned ALL_DRAWABLES_MASK = (1u << DRAWABLE_BOUNDS_BLOCK_SIZE) - 1;
+/// Number of drawables passed to TestDrawables() at once after testing the packed bounds.
+static const unsigned BOUNDS_TEST_BATCH_SIZE = 64;
+
+/// Return bitmask of the drawables in a packed block that match the flags and view mask.
+static unsigned GetBoundsFilterMask(const DrawableBoundsBlock& block, unsigned drawableFlags, unsigned viewMask)
+{
+#ifdef URHO3D_SSE
+    __m128i zero = _mm_setzero_si128();
+    __m128i flags = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block.flags_)), _mm_set1_epi32(drawableFlags));
+    __m128i masks = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block.viewMasks_)), _mm_set1_epi32(viewMask));
+    __m128i rejected = _mm_or_si128(_mm_cmpeq_epi32(flags, zero), _mm_cmpeq_epi32(masks, zero));
+    return ~(unsigned)_mm_movemask_ps(_mm_castsi128_ps(rejected)) & ALL_DRAWABLES_MASK;
+#else
+    unsigned mask = 0;
+    for (unsigned i = 0; i < DRAWABLE_BOUNDS_BLOCK_SIZE; ++i)
+    {
+        if ((block.flags_[i] & drawableFlags) && (block.viewMasks_[i] & viewMask))
+            mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+/// Return bitmask of the drawables in a packed block whose bounding box is stale.
+static unsigned GetBoundsDirtyMask(const DrawableBoundsBlock& block)
+{
+#ifdef URHO3D_SSE
+    // Shift the dirty flag into the sign bit
+    __m128i flags = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block.flags_));
+    return (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_slli_epi32(flags, 23)));
+#else
+    unsigned mask = 0;
+    for (unsigned i = 0; i < DRAWABLE_BOUNDS_BLOCK_SIZE; ++i)
+    {
+        if (block.flags_[i] & DRAWABLE_BOUNDS_DIRTY)
+            mask |= 1u << i;
+    }
+    return mask;
+#endif
+}
+
+#ifndef URHO3D_SSE
+/// Return bounding box of a drawable in a packed block.
+static BoundingBox GetBlockBoundingBox(const DrawableBoundsBlock& block, unsigned index)
+{
+    return BoundingBox(Vector3(block.minX_[index], block.minY_[index], block.minZ_[index]),
+        Vector3(block.maxX_[index], block.maxY_[index], block.maxZ_[index]));
+}
+#endif
+
+/// Test packed drawable bounds block by block, and pass the drawables that intersect to the query's TestDrawables() as inside, so that a subclass can still filter them. The block test returns the bitmask of drawables that intersect. Drawables whose packed box is stale are passed as not inside, so that their own bounding box is tested.
+template <class BlockTest> static void TestBoundsBlocks(OctreeQuery& query, Drawable** start, Drawable** end,
+    const DrawableBoundsBlock* bounds, bool inside, const BlockTest& blockTest)
+{
+    Drawable* batch[BOUNDS_TEST_BATCH_SIZE];
+    unsigned batchSize = 0;
+    auto numDrawables = (unsigned)(end - start);
+
+    for (unsigned i = 0; i < numDrawables; i += DRAWABLE_BOUNDS_BLOCK_SIZE, ++bounds)
+    {
+        unsigned mask = GetBoundsFilterMask(*bounds, query.drawableFlags_, query.viewMask_);
+        if (!mask)
+            continue;
+
+        unsigned dirtyMask = 0;
+        if (!inside)
+        {
+            dirtyMask = GetBoundsDirtyMask(*bounds) & mask;
+            mask &= blockTest(*bounds) | dirtyMask;
+        }
+
+        for (unsigned j = 0; mask; ++j, mask >>= 1)
+        {
+            if (!(mask & 1u))
+                continue;
+
+            Drawable** drawable = start + i + j;
+            if (dirtyMask & (1u << j))
+            {
+                // Keep the result order by passing the batched drawables first
+                if (batchSize)
+                {
+                    query.TestDrawables(batch, batch + batchSize, true);
+                    batchSize = 0;
+                }
+                query.TestDrawables(drawable, drawable + 1, false);
+            }
+            else
+            {
+                batch[batchSize++] = *drawable;
+                if (batchSize == BOUNDS_TEST_BATCH_SIZE)
+                {
+                    query.TestDrawables(batch, batch + batchSize, true);
+                    batchSize = 0;
+                }
+            }
+        }
+    }
+
+    if (batchSize)
+        query.TestDrawables(batch, batch + batchSize, true);
+}
+
 Intersection PointOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -73,6 +181,45 @@ void SphereOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool ins
     }
 }
 
+void SphereOctreeQuery::TestDrawableBounds(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside)
+{
+    const Sphere& sphere = sphere_;
+
+#ifdef URHO3D_SSE
+    __m128 zero = _mm_setzero_ps();
+    __m128 centerX = _mm_set1_ps(sphere.center_.x_);
+    __m128 centerY = _mm_set1_ps(sphere.center_.y_);
+    __m128 centerZ = _mm_set1_ps(sphere.center_.z_);
+    __m128 radiusSquared = _mm_set1_ps(sphere.radius_ * sphere.radius_);
+
+    auto blockTest = [=](const DrawableBoundsBlock& block)
+    {
+        // Distance from the sphere center to the box along each axis, zero when the center is within the slab
+        __m128 dx = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(block.minX_), centerX),
+            _mm_max_ps(_mm_sub_ps(centerX, _mm_loadu_ps(block.maxX_)), zero));
+        __m128 dy = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(block.minY_), centerY),
+            _mm_max_ps(_mm_sub_ps(centerY, _mm_loadu_ps(block.maxY_)), zero));
+        __m128 dz = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(block.minZ_), centerZ),
+            _mm_max_ps(_mm_sub_ps(centerZ, _mm_loadu_ps(block.maxZ_)), zero));
+        __m128 distSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        return (unsigned)_mm_movemask_ps(_mm_cmplt_ps(distSquared, radiusSquared));
+    };
+#else
+    auto blockTest = [&sphere](const DrawableBoundsBlock& block)
+    {
+        unsigned mask = 0;
+        for (unsigned i = 0; i < DRAWABLE_BOUNDS_BLOCK_SIZE; ++i)
+        {
+            if (sphere.IsInsideFast(GetBlockBoundingBox(block, i)))
+                mask |= 1u << i;
+        }
+        return mask;
+    };
+#endif
+
+    TestBoundsBlocks(*this, start, end, bounds, inside, blockTest);
+}
+
 Intersection BoxOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -95,6 +242,41 @@ void BoxOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool inside
     }
 }
 
+void BoxOctreeQuery::TestDrawableBounds(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside)
+{
+    const BoundingBox& box = box_;
+
+#ifdef URHO3D_SSE
+    __m128 minX = _mm_set1_ps(box.min_.x_);
+    __m128 minY = _mm_set1_ps(box.min_.y_);
+    __m128 minZ = _mm_set1_ps(box.min_.z_);
+    __m128 maxX = _mm_set1_ps(box.max_.x_);
+    __m128 maxY = _mm_set1_ps(box.max_.y_);
+    __m128 maxZ = _mm_set1_ps(box.max_.z_);
+
+    auto blockTest = [=](const DrawableBoundsBlock& block)
+    {
+        __m128 outside = _mm_or_ps(_mm_cmplt_ps(_mm_loadu_ps(block.maxX_), minX), _mm_cmpgt_ps(_mm_loadu_ps(block.minX_), maxX));
+        outside = _mm_or_ps(outside, _mm_or_ps(_mm_cmplt_ps(_mm_loadu_ps(block.maxY_), minY), _mm_cmpgt_ps(_mm_loadu_ps(block.minY_), maxY)));
+        outside = _mm_or_ps(outside, _mm_or_ps(_mm_cmplt_ps(_mm_loadu_ps(block.maxZ_), minZ), _mm_cmpgt_ps(_mm_loadu_ps(block.minZ_), maxZ)));
+        return ~(unsigned)_mm_movemask_ps(outside) & ALL_DRAWABLES_MASK;
+    };
+#else
+    auto blockTest = [&box](const DrawableBoundsBlock& block)
+    {
+        unsigned mask = 0;
+        for (unsigned i = 0; i < DRAWABLE_BOUNDS_BLOCK_SIZE; ++i)
+        {
+            if (box.IsInsideFast(GetBlockBoundingBox(block, i)))
+                mask |= 1u << i;
+        }
+        return mask;
+    };
+#endif
+
+    TestBoundsBlocks(*this, start, end, bounds, inside, blockTest);
+}
+
 Intersection FrustumOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -117,6 +299,66 @@ void FrustumOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool in
     }
 }
 
+void FrustumOctreeQuery::TestDrawableBounds(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside)
+{
+    const Frustum& frustum = frustum_;
+
+#ifdef URHO3D_SSE
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 zero = _mm_setzero_ps();
+    // Broadcast the plane normals, distances and absolute normals once for all blocks
+    __m128 planes[NUM_FRUSTUM_PLANES][7];
+    for (unsigned i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+    {
+        const Plane& plane = frustum.planes_[i];
+        planes[i][0] = _mm_set1_ps(plane.normal_.x_);
+        planes[i][1] = _mm_set1_ps(plane.normal_.y_);
+        planes[i][2] = _mm_set1_ps(plane.normal_.z_);
+        planes[i][3] = _mm_set1_ps(plane.d_);
+        planes[i][4] = _mm_set1_ps(plane.absNormal_.x_);
+        planes[i][5] = _mm_set1_ps(plane.absNormal_.y_);
+        planes[i][6] = _mm_set1_ps(plane.absNormal_.z_);
+    }
+
+    auto blockTest = [&planes, half, zero](const DrawableBoundsBlock& block)
+    {
+        __m128 minX = _mm_loadu_ps(block.minX_);
+        __m128 minY = _mm_loadu_ps(block.minY_);
+        __m128 minZ = _mm_loadu_ps(block.minZ_);
+        __m128 centerX = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(block.maxX_), minX), half);
+        __m128 centerY = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(block.maxY_), minY), half);
+        __m128 centerZ = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(block.maxZ_), minZ), half);
+        __m128 edgeX = _mm_sub_ps(centerX, minX);
+        __m128 edgeY = _mm_sub_ps(centerY, minY);
+        __m128 edgeZ = _mm_sub_ps(centerZ, minZ);
+        __m128 outside = zero;
+
+        for (const auto& plane : planes)
+        {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(plane[0], centerX), _mm_mul_ps(plane[1], centerY)),
+                _mm_mul_ps(plane[2], centerZ)), plane[3]);
+            __m128 absDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane[4], edgeX), _mm_mul_ps(plane[5], edgeY)),
+                _mm_mul_ps(plane[6], edgeZ));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, _mm_sub_ps(zero, absDist)));
+        }
+
+        return ~(unsigned)_mm_movemask_ps(outside) & ALL_DRAWABLES_MASK;
+    };
+#else
+    auto blockTest = [&frustum](const DrawableBoundsBlock& block)
+    {
+        unsigned mask = 0;
+        for (unsigned i = 0; i < DRAWABLE_BOUNDS_BLOCK_SIZE; ++i)
+        {
+            if (frustum.IsInsideFast(GetBlockBoundingBox(block, i)))
+                mask |= 1u << i;
+        }
+        return mask;
+    };
+#endif
+
+    TestBoundsBlocks(*this, start, end, bounds, inside, blockTest);
+}
 
 Intersection AllContentOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
@@ -36,6 +36,32 @@ namespace Urho3D
 class Drawable;
 class Node;
 
+/// Number of drawables in a packed drawable bounds block.
+static const unsigned DRAWABLE_BOUNDS_BLOCK_SIZE = 4;
+/// Packed drawable flag set while the drawable's world bounding box is awaiting an octree update. The packed box is stale and the drawable itself must be tested.
+static const unsigned DRAWABLE_BOUNDS_DIRTY = 0x100;
+
+/// Packed world bounding boxes, drawable flags and view masks of an octant's drawables in structure-of-arrays layout for SIMD culling. Unused slots have zero flags.
+struct URHO3D_API DrawableBoundsBlock
+{
+    /// Bounding box minimum X coordinates.
+    float minX_[DRAWABLE_BOUNDS_BLOCK_SIZE];
+    /// Bounding box minimum Y coordinates.
+    float minY_[DRAWABLE_BOUNDS_BLOCK_SIZE];
+    /// Bounding box minimum Z coordinates.
+    float minZ_[DRAWABLE_BOUNDS_BLOCK_SIZE];
+    /// Bounding box maximum X coordinates.
+    float maxX_[DRAWABLE_BOUNDS_BLOCK_SIZE];
+    /// Bounding box maximum Y coordinates.
+    float maxY_[DRAWABLE_BOUNDS_BLOCK_SIZE];
+    /// Bounding box maximum Z coordinates.
+    float maxZ_[DRAWABLE_BOUNDS_BLOCK_SIZE];
+    /// Drawable flags, combined with DRAWABLE_BOUNDS_DIRTY if the box is stale.
+    unsigned flags_[DRAWABLE_BOUNDS_BLOCK_SIZE];
+    /// View masks.
+    unsigned viewMasks_[DRAWABLE_BOUNDS_BLOCK_SIZE];
+};
+
 /// Base class for octree queries.
 class URHO3D_API OctreeQuery
 {
@@ -60,6 +86,11 @@ public:
     virtual Intersection TestOctant(const BoundingBox& box, bool inside) = 0;
     /// Intersection test for drawables.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside) = 0;
+    /// Intersection test for drawables using their packed bounds, which start at the first block. Default implementation calls TestDrawables(). The built-in queries cull by the packed bounds, flags and view masks, then call TestDrawables() for the drawables that pass, so subclasses that filter drawables only need to override TestDrawables().
+    virtual void TestDrawableBounds(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside)
+    {
+        TestDrawables(start, end, inside);
+    }
 
     /// Result vector reference.
     PODVector<Drawable*>& result_;
@@ -108,6 +139,8 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Intersection test for drawables using their packed bounds.
+    void TestDrawableBounds(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside) override;
 
     /// Sphere.
     Sphere sphere_;
@@ -130,6 +163,8 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Intersection test for drawables using their packed bounds.
+    void TestDrawableBounds(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside) override;
 
     /// Bounding box.
     BoundingBox box_;
@@ -152,6 +187,8 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Intersection test for drawables using their packed bounds.
+    void TestDrawableBounds(Drawable** start, Drawable** end, const DrawableBoundsBlock* bounds, bool inside) override;
 
     /// Frustum.
     Frustum frustum_;
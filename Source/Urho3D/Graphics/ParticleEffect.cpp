@@ -818,6 +818,39 @@ float ParticleEffect::GetRandomRotation() const
     return Lerp(rotationMin_, rotationMax_, Random(1.0f));
 }
 
+Vector3 ParticleEffect::GetRandomDirection(unsigned& seed) const
+{
+    float x = Lerp(directionMin_.x_, directionMax_.x_, SeededRandom(seed, 1.0f));
+    float y = Lerp(directionMin_.y_, directionMax_.y_, SeededRandom(seed, 1.0f));
+    float z = Lerp(directionMin_.z_, directionMax_.z_, SeededRandom(seed, 1.0f));
+    return Vector3(x, y, z);
+}
+
+Vector2 ParticleEffect::GetRandomSize(unsigned& seed) const
+{
+    return sizeMin_.Lerp(sizeMax_, SeededRandom(seed, 1.0f));
+}
+
+float ParticleEffect::GetRandomVelocity(unsigned& seed) const
+{
+    return Lerp(velocityMin_, velocityMax_, SeededRandom(seed, 1.0f));
+}
+
+float ParticleEffect::GetRandomTimeToLive(unsigned& seed) const
+{
+    return Lerp(timeToLiveMin_, timeToLiveMax_, SeededRandom(seed, 1.0f));
+}
+
+float ParticleEffect::GetRandomRotationSpeed(unsigned& seed) const
+{
+    return Lerp(rotationSpeedMin_, rotationSpeedMax_, SeededRandom(seed, 1.0f));
+}
+
+float ParticleEffect::GetRandomRotation(unsigned& seed) const
+{
+    return Lerp(rotationMin_, rotationMax_, SeededRandom(seed, 1.0f));
+}
+
 void ParticleEffect::GetFloatMinMax(const XMLElement& element, float& minValue, float& maxValue)
 {
     if (element.IsNull())
@@ -414,6 +414,18 @@ public:
     float GetRandomRotationSpeed() const;
     /// Return random rotation.
     float GetRandomRotation() const;
+    /// Return random direction using a caller-owned random seed.
+    Vector3 GetRandomDirection(unsigned& seed) const;
+    /// Return random size using a caller-owned random seed.
+    Vector2 GetRandomSize(unsigned& seed) const;
+    /// Return random velocity using a caller-owned random seed.
+    float GetRandomVelocity(unsigned& seed) const;
+    /// Return random timetolive using a caller-owned random seed.
+    float GetRandomTimeToLive(unsigned& seed) const;
+    /// Return random rotationspeed using a caller-owned random seed.
+    float GetRandomRotationSpeed(unsigned& seed) const;
+    /// Return random rotation using a caller-owned random seed.
+    float GetRandomRotation(unsigned& seed) const;
 
 private:
     /// Read a float range from an XML element.
@@ -32,6 +32,10 @@
 #include "../Scene/Scene.h"
 #include "../Scene/SceneEvents.h"
 
+#ifdef URHO3D_SSE
+#include <emmintrin.h>
+#endif
+
 #include "../DebugNew.h"
 
 namespace Urho3D
@@ -43,8 +47,17 @@ static const unsigned MAX_PARTICLES_IN_FRAME = 100;
 
 extern const char* autoRemoveModeNames[];
 
+#ifdef URHO3D_SSE
+static inline __m128 SelectSIMD(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+#endif
+
 ParticleEmitter::ParticleEmitter(Context* context) :
     BillboardSet(context),
+    randomSeed_((unsigned)Rand()),
+    nextFreeParticle_(0),
     periodTimer_(0.0f),
     emissionTimer_(0.0f),
     lastTimeStep_(0.0f),
@@ -53,6 +66,7 @@ ParticleEmitter::ParticleEmitter(Context* context) :
     needUpdate_(false),
     serializeParticles_(true),
     sendFinishedEvent_(true),
+    soaStorage_(false),
     autoRemove_(REMOVE_DISABLED)
 {
     SetNumParticles(DEFAULT_NUM_PARTICLES);
@@ -76,6 +90,8 @@ void ParticleEmitter::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Period Timer", float, periodTimer_, 0.0f, AM_FILE | AM_NOEDIT);
     URHO3D_ATTRIBUTE("Emission Timer", float, emissionTimer_, 0.0f, AM_FILE | AM_NOEDIT);
     URHO3D_ENUM_ATTRIBUTE("Autoremove Mode", autoRemove_, autoRemoveModeNames, REMOVE_DISABLED, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("SoA Storage", IsSoAStorage, SetSoAStorage, bool, false, AM_DEFAULT);
+    URHO3D_ATTRIBUTE("Random Seed", unsigned, randomSeed_, 0, AM_FILE | AM_NOEDIT);
     URHO3D_COPY_BASE_ATTRIBUTES(Drawable);
     URHO3D_MIXED_ACCESSOR_ATTRIBUTE("Particles", GetParticlesAttr, SetParticlesAttr, VariantVector, Variant::emptyVariantVector,
         AM_FILE | AM_NOEDIT);
@@ -108,8 +124,8 @@ void ParticleEmitter::Update(const FrameInfo& frame)
         return;
 
     // If there is an amount mismatch between particles and billboards, correct it
-    if (particles_.Size() != billboards_.Size())
-        SetNumBillboards(particles_.Size());
+    if (GetNumParticles() != billboards_.Size())
+        SetNumBillboards(GetNumParticles());
 
     bool needCommit = false;
 
@@ -154,7 +170,7 @@ void ParticleEmitter::Update(const FrameInfo& frame)
 
         while (emissionTimer_ > 0.0f && counter)
         {
-            emissionTimer_ -= Lerp(intervalMin, intervalMax, Random(1.0f));
+            emissionTimer_ -= Lerp(intervalMin, intervalMax, SeededRandom(randomSeed_, 1.0f));
             if (EmitNewParticle())
             {
                 --counter;
@@ -172,6 +188,13 @@ void ParticleEmitter::Update(const FrameInfo& frame)
     if (scaled_ && !relative_)
         scaleVector = node_->GetWorldScale();
 
+    // In the SoA storage mode particles_ is empty and the loop below does nothing
+    if (soaStorage_)
+    {
+        if (UpdateParticlesSoA(relative_ ? relativeConstantForce : effect_->GetConstantForce(), scaleVector))
+            needCommit = true;
+    }
+
     for (unsigned i = 0; i < particles_.Size(); ++i)
     {
         Particle& particle = particles_[i];
@@ -286,7 +309,7 @@ void ParticleEmitter::SetNumParticles(unsigned num)
     if (num > M_MAX_INT)
         num = 0;
 
-    particles_.Resize(num);
+    ResizeParticles(num);
     SetNumBillboards(num);
 }
 
@@ -315,6 +338,31 @@ void ParticleEmitter::SetAutoRemoveMode(AutoRemoveMode mode)
     MarkNetworkUpdate();
 }
 
+void ParticleEmitter::SetSoAStorage(bool enable)
+{
+    if (enable == soaStorage_)
+        return;
+
+    unsigned numParticles = GetNumParticles();
+    PODVector<Particle> particles(numParticles);
+    for (unsigned i = 0; i < numParticles; ++i)
+        particles[i] = LoadParticle(i);
+
+    // Release the storage of the previous mode and move the particles over
+    ResizeParticles(0);
+    soaStorage_ = enable;
+    ResizeParticles(numParticles);
+    for (unsigned i = 0; i < numParticles; ++i)
+        StoreParticle(i, particles[i]);
+
+    MarkNetworkUpdate();
+}
+
+void ParticleEmitter::SetSeed(unsigned seed)
+{
+    randomSeed_ = seed;
+}
+
 void ParticleEmitter::ResetEmissionTimer()
 {
     emissionTimer_ = 0.0f;
@@ -371,40 +419,44 @@ void ParticleEmitter::SetParticlesAttr(const VariantVector& value)
     unsigned index = 0;
     SetNumParticles(index < value.Size() ? value[index++].GetUInt() : 0);
 
-    for (PODVector<Particle>::Iterator i = particles_.Begin(); i != particles_.End() && index < value.Size(); ++i)
+    for (unsigned i = 0; i < GetNumParticles() && index < value.Size(); ++i)
     {
-        i->velocity_ = value[index++].GetVector3();
-        i->size_ = value[index++].GetVector2();
-        i->timer_ = value[index++].GetFloat();
-        i->timeToLive_ = value[index++].GetFloat();
-        i->scale_ = value[index++].GetFloat();
-        i->rotationSpeed_ = value[index++].GetFloat();
-        i->colorIndex_ = (unsigned)value[index++].GetInt();
-        i->texIndex_ = (unsigned)value[index++].GetInt();
+        Particle particle;
+        particle.velocity_ = value[index++].GetVector3();
+        particle.size_ = value[index++].GetVector2();
+        particle.timer_ = value[index++].GetFloat();
+        particle.timeToLive_ = value[index++].GetFloat();
+        particle.scale_ = value[index++].GetFloat();
+        particle.rotationSpeed_ = value[index++].GetFloat();
+        particle.colorIndex_ = (unsigned)value[index++].GetInt();
+        particle.texIndex_ = (unsigned)value[index++].GetInt();
+        StoreParticle(i, particle);
     }
 }
 
 VariantVector ParticleEmitter::GetParticlesAttr() const
 {
     VariantVector ret;
+    unsigned numParticles = GetNumParticles();
     if (!serializeParticles_)
     {
-        ret.Push(particles_.Size());
+        ret.Push(numParticles);
         return ret;
     }
 
-    ret.Reserve(particles_.Size() * 8 + 1);
-    ret.Push(particles_.Size());
-    for (PODVector<Particle>::ConstIterator i = particles_.Begin(); i != particles_.End(); ++i)
+    ret.Reserve(numParticles * 8 + 1);
+    ret.Push(numParticles);
+    for (unsigned i = 0; i < numParticles; ++i)
     {
-        ret.Push(i->velocity_);
-        ret.Push(i->size_);
-        ret.Push(i->timer_);
-        ret.Push(i->timeToLive_);
-        ret.Push(i->scale_);
-        ret.Push(i->rotationSpeed_);
-        ret.Push(i->colorIndex_);
-        ret.Push(i->texIndex_);
+        Particle particle = LoadParticle(i);
+        ret.Push(particle.velocity_);
+        ret.Push(particle.size_);
+        ret.Push(particle.timer_);
+        ret.Push(particle.timeToLive_);
+        ret.Push(particle.scale_);
+        ret.Push(particle.rotationSpeed_);
+        ret.Push(particle.colorIndex_);
+        ret.Push(particle.texIndex_);
     }
     return ret;
 }
@@ -450,14 +502,17 @@ bool ParticleEmitter::EmitNewParticle()
     unsigned index = GetFreeParticle();
     if (index == M_MAX_UNSIGNED)
         return false;
-    assert(index < particles_.Size());
-    Particle& particle = particles_[index];
+    assert(index < GetNumParticles());
+    nextFreeParticle_ = index + 1;
+    Particle particle;
     Billboard& billboard = billboards_[index];
 
+    // Draw from the emitter's own seed, as emitters are updated in worker threads
+    unsigned& seed = randomSeed_;
     Vector3 startDir;
     Vector3 startPos;
 
-    startDir = effect_->GetRandomDirection();
+    startDir = effect_->GetRandomDirection(seed);
     startDir.Normalize();
 
     switch (effect_->GetEmitterType())
@@ -465,9 +520,9 @@ bool ParticleEmitter::EmitNewParticle()
     case EMITTER_SPHERE:
         {
             Vector3 dir(
-                Random(2.0f) - 1.0f,
-                Random(2.0f) - 1.0f,
-                Random(2.0f) - 1.0f
+                SeededRandom(seed, 2.0f) - 1.0f,
+                SeededRandom(seed, 2.0f) - 1.0f,
+                SeededRandom(seed, 2.0f) - 1.0f
             );
             dir.Normalize();
             startPos = effect_->GetEmitterSize() * dir * 0.5f;
@@ -478,9 +533,9 @@ bool ParticleEmitter::EmitNewParticle()
         {
             const Vector3& emitterSize = effect_->GetEmitterSize();
             startPos = Vector3(
-                Random(emitterSize.x_) - emitterSize.x_ * 0.5f,
-                Random(emitterSize.y_) - emitterSize.y_ * 0.5f,
-                Random(emitterSize.z_) - emitterSize.z_ * 0.5f
+                SeededRandom(seed, emitterSize.x_) - emitterSize.x_ * 0.5f,
+                SeededRandom(seed, emitterSize.y_) - emitterSize.y_ * 0.5f,
+                SeededRandom(seed, emitterSize.z_) - emitterSize.z_ * 0.5f
             );
         }
         break;
@@ -488,36 +543,36 @@ bool ParticleEmitter::EmitNewParticle()
     case EMITTER_SPHEREVOLUME:
         {
             Vector3 dir(
-                Random(2.0f) - 1.0f,
-                Random(2.0f) - 1.0f,
-                Random(2.0f) - 1.0f
+                SeededRandom(seed, 2.0f) - 1.0f,
+                SeededRandom(seed, 2.0f) - 1.0f,
+                SeededRandom(seed, 2.0f) - 1.0f
             );
             dir.Normalize();
-            startPos = effect_->GetEmitterSize() * dir * Pow(Random(), 1.0f / 3.0f) * 0.5f;
+            startPos = effect_->GetEmitterSize() * dir * Pow(SeededRandom(seed), 1.0f / 3.0f) * 0.5f;
         }
         break;
 
     case EMITTER_CYLINDER:
         {
-            float angle = Random(360.0f);
-            float radius = Sqrt(Random()) * 0.5f;
-            startPos = Vector3(Cos(angle) * radius, Random() - 0.5f, Sin(angle) * radius) * effect_->GetEmitterSize();
+            float angle = SeededRandom(seed, 360.0f);
+            float radius = Sqrt(SeededRandom(seed)) * 0.5f;
+            startPos = Vector3(Cos(angle) * radius, SeededRandom(seed) - 0.5f, Sin(angle) * radius) * effect_->GetEmitterSize();
         }
         break;
 
     case EMITTER_RING:
         {
-            float angle = Random(360.0f);
-            startPos = Vector3(Cos(angle), Random(2.0f) - 1.0f, Sin(angle)) * effect_->GetEmitterSize() * 0.5f;
+            float angle = SeededRandom(seed, 360.0f);
+            startPos = Vector3(Cos(angle), SeededRandom(seed, 2.0f) - 1.0f, Sin(angle)) * effect_->GetEmitterSize() * 0.5f;
         }
         break;
     }
 
-    particle.size_ = effect_->GetRandomSize();
+    particle.size_ = effect_->GetRandomSize(seed);
     particle.timer_ = 0.0f;
-    particle.timeToLive_ = effect_->GetRandomTimeToLive();
+    particle.timeToLive_ = effect_->GetRandomTimeToLive(seed);
     particle.scale_ = 1.0f;
-    particle.rotationSpeed_ = effect_->GetRandomRotationSpeed();
+    particle.rotationSpeed_ = effect_->GetRandomRotationSpeed(seed);
     particle.colorIndex_ = 0;
     particle.texIndex_ = 0;
 
@@ -532,13 +587,14 @@ bool ParticleEmitter::EmitNewParticle()
         startDir = node_->GetWorldRotation() * startDir;
     };
 
-    particle.velocity_ = effect_->GetRandomVelocity() * startDir;
+    particle.velocity_ = effect_->GetRandomVelocity(seed) * startDir;
+    StoreParticle(index, particle);
 
     billboard.position_ = startPos;
-    billboard.size_ = particles_[index].size_;
+    billboard.size_ = particle.size_;
     const Vector<TextureFrame>& textureFrames_ = effect_->GetTextureFrames();
     billboard.uv_ = textureFrames_.Size() ? textureFrames_[0].uv_ : Rect::POSITIVE;
-    billboard.rotation_ = effect_->GetRandomRotation();
+    billboard.rotation_ = effect_->GetRandomRotation(seed);
     const Vector<ColorFrame>& colorFrames_ = effect_->GetColorFrames();
     billboard.color_ = colorFrames_.Size() ? colorFrames_[0].color_ : Color();
     billboard.enabled_ = true;
@@ -549,7 +605,16 @@ bool ParticleEmitter::EmitNewParticle()
 
 unsigned ParticleEmitter::GetFreeParticle() const
 {
-    for (unsigned i = 0; i < billboards_.Size(); ++i)
+    // Continue from where the previous particle was emitted, as the particles before it are likely still alive.
+    // Avoids rescanning a large effect from the start for every emitted particle
+    unsigned numBillboards = billboards_.Size();
+    unsigned start = nextFreeParticle_ < numBillboards ? nextFreeParticle_ : 0;
+    for (unsigned i = start; i < numBillboards; ++i)
+    {
+        if (!billboards_[i].enabled_)
+            return i;
+    }
+    for (unsigned i = 0; i < start; ++i)
     {
         if (!billboards_[i].enabled_)
             return i;
@@ -617,4 +682,286 @@ void ParticleEmitter::HandleEffectReloadFinished(StringHash eventType, VariantMa
     ApplyEffect();
 }
 
+bool ParticleEmitter::UpdateParticlesSoA(const Vector3& constantForce, const Vector3& scaleVector)
+{
+    unsigned numParticles = streams_.size_;
+    float timeStep = lastTimeStep_;
+    bool applyForce = effect_->GetConstantForce() != Vector3::ZERO;
+    Vector3 forceStep = timeStep * constantForce;
+    float dampingForce = effect_->GetDampingForce();
+    float sizeAdd = effect_->GetSizeAdd();
+    float sizeMul = effect_->GetSizeMul();
+    bool applyScaling = sizeAdd != 0.0f || sizeMul != 1.0f;
+    float scaleAdd = timeStep * sizeAdd;
+    float scaleMul = sizeMul != 1.0f ? (timeStep * (sizeMul - 1.0f)) + 1.0f : 1.0f;
+    const Vector<ColorFrame>& colorFrames = effect_->GetColorFrames();
+    const Vector<TextureFrame>& textureFrames = effect_->GetTextureFrames();
+
+    float* velocityX = streams_.velocityX_.Buffer();
+    float* velocityY = streams_.velocityY_.Buffer();
+    float* velocityZ = streams_.velocityZ_.Buffer();
+    float* timer = streams_.timer_.Buffer();
+    float* timeToLive = streams_.timeToLive_.Buffer();
+    float* scale = streams_.scale_.Buffer();
+    const float* rotationSpeed = streams_.rotationSpeed_.Buffer();
+    const float* sizeX = streams_.sizeX_.Buffer();
+    const float* sizeY = streams_.sizeY_.Buffer();
+
+    // Reciprocals of the color frame intervals, so that the color interpolation does not divide per particle
+    colorFrameScales_.Resize(colorFrames.Size());
+    for (unsigned i = 0; i + 1 < colorFrames.Size(); ++i)
+    {
+        float interval = colorFrames[i + 1].time_ - colorFrames[i].time_;
+        colorFrameScales_[i] = interval > 0.0f ? 1.0f / interval : 0.0f;
+    }
+
+    bool active = false;
+
+    for (unsigned i = 0; i < numParticles; i += 4)
+    {
+        Billboard* billboards = &billboards_[i];
+        unsigned numLanes = Min(numParticles - i, 4U);
+
+        // Particles of disabled billboards are left untouched
+        unsigned enabledMask = 0;
+        for (unsigned j = 0; j < numLanes; ++j)
+        {
+            if (billboards[j].enabled_)
+                enabledMask |= 1u << j;
+        }
+        if (!enabledMask)
+            continue;
+        active = true;
+
+        float deltaX[4], deltaY[4], deltaZ[4];
+        float directionX[4], directionY[4], directionZ[4];
+        float rotationDelta[4];
+        unsigned liveMask;
+
+#ifdef URHO3D_SSE
+        __m128 dt = _mm_set1_ps(timeStep);
+        __m128 enabled = _mm_castsi128_ps(_mm_setr_epi32(-(int)(enabledMask & 1u), -(int)((enabledMask >> 1u) & 1u),
+            -(int)((enabledMask >> 2u) & 1u), -(int)((enabledMask >> 3u) & 1u)));
+        __m128 t = _mm_loadu_ps(&timer[i]);
+        __m128 live = _mm_and_ps(enabled, _mm_cmplt_ps(t, _mm_loadu_ps(&timeToLive[i])));
+        liveMask = (unsigned)_mm_movemask_ps(live);
+        _mm_storeu_ps(&timer[i], SelectSIMD(live, _mm_add_ps(t, dt), t));
+
+        // Velocity & position
+        __m128 vx = _mm_loadu_ps(&velocityX[i]);
+        __m128 vy = _mm_loadu_ps(&velocityY[i]);
+        __m128 vz = _mm_loadu_ps(&velocityZ[i]);
+        if (applyForce)
+        {
+            vx = _mm_add_ps(vx, _mm_set1_ps(forceStep.x_));
+            vy = _mm_add_ps(vy, _mm_set1_ps(forceStep.y_));
+            vz = _mm_add_ps(vz, _mm_set1_ps(forceStep.z_));
+        }
+        if (dampingForce != 0.0f)
+        {
+            __m128 damping = _mm_set1_ps(-dampingForce);
+            vx = _mm_add_ps(vx, _mm_mul_ps(_mm_mul_ps(vx, damping), dt));
+            vy = _mm_add_ps(vy, _mm_mul_ps(_mm_mul_ps(vy, damping), dt));
+            vz = _mm_add_ps(vz, _mm_mul_ps(_mm_mul_ps(vz, damping), dt));
+        }
+        _mm_storeu_ps(&velocityX[i], SelectSIMD(live, vx, _mm_loadu_ps(&velocityX[i])));
+        _mm_storeu_ps(&velocityY[i], SelectSIMD(live, vy, _mm_loadu_ps(&velocityY[i])));
+        _mm_storeu_ps(&velocityZ[i], SelectSIMD(live, vz, _mm_loadu_ps(&velocityZ[i])));
+        _mm_storeu_ps(deltaX, _mm_mul_ps(_mm_mul_ps(vx, dt), _mm_set1_ps(scaleVector.x_)));
+        _mm_storeu_ps(deltaY, _mm_mul_ps(_mm_mul_ps(vy, dt), _mm_set1_ps(scaleVector.y_)));
+        _mm_storeu_ps(deltaZ, _mm_mul_ps(_mm_mul_ps(vz, dt), _mm_set1_ps(scaleVector.z_)));
+
+        // Direction, normalized the same way as Vector3::Normalized()
+        __m128 one = _mm_set1_ps(1.0f);
+        __m128 epsilon = _mm_set1_ps(std::numeric_limits<float>::epsilon());
+        __m128 lenSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+        __m128 isUnit = _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(lenSquared, epsilon), one),
+            _mm_cmple_ps(_mm_sub_ps(lenSquared, epsilon), one));
+        __m128 normalize = _mm_andnot_ps(isUnit, _mm_cmpgt_ps(lenSquared, _mm_setzero_ps()));
+        __m128 invLen = _mm_div_ps(one, _mm_sqrt_ps(lenSquared));
+        _mm_storeu_ps(directionX, SelectSIMD(normalize, _mm_mul_ps(vx, invLen), vx));
+        _mm_storeu_ps(directionY, SelectSIMD(normalize, _mm_mul_ps(vy, invLen), vy));
+        _mm_storeu_ps(directionZ, SelectSIMD(normalize, _mm_mul_ps(vz, invLen), vz));
+
+        // Rotation
+        _mm_storeu_ps(rotationDelta, _mm_mul_ps(dt, _mm_loadu_ps(&rotationSpeed[i])));
+
+        // Scaling
+        if (applyScaling)
+        {
+            __m128 oldScale = _mm_loadu_ps(&scale[i]);
+            __m128 s = _mm_add_ps(oldScale, _mm_set1_ps(scaleAdd));
+            s = _mm_andnot_ps(_mm_cmplt_ps(s, _mm_setzero_ps()), s);
+            if (sizeMul != 1.0f)
+                s = _mm_mul_ps(s, _mm_set1_ps(scaleMul));
+            _mm_storeu_ps(&scale[i], SelectSIMD(live, s, oldScale));
+        }
+#else
+        liveMask = 0;
+        for (unsigned j = 0; j < numLanes; ++j)
+        {
+            unsigned k = i + j;
+            if (!(enabledMask & (1u << j)) || timer[k] >= timeToLive[k])
+                continue;
+            liveMask |= 1u << j;
+            timer[k] += timeStep;
+
+            Vector3 velocity(velocityX[k], velocityY[k], velocityZ[k]);
+            if (applyForce)
+                velocity += forceStep;
+            if (dampingForce != 0.0f)
+                velocity += timeStep * (-dampingForce * velocity);
+            velocityX[k] = velocity.x_;
+            velocityY[k] = velocity.y_;
+            velocityZ[k] = velocity.z_;
+
+            Vector3 delta = timeStep * velocity * scaleVector;
+            Vector3 direction = velocity.Normalized();
+            deltaX[j] = delta.x_;
+            deltaY[j] = delta.y_;
+            deltaZ[j] = delta.z_;
+            directionX[j] = direction.x_;
+            directionY[j] = direction.y_;
+            directionZ[j] = direction.z_;
+            rotationDelta[j] = timeStep * rotationSpeed[k];
+
+            if (applyScaling)
+            {
+                scale[k] += scaleAdd;
+                if (scale[k] < 0.0f)
+                    scale[k] = 0.0f;
+                if (sizeMul != 1.0f)
+                    scale[k] *= scaleMul;
+            }
+        }
+#endif
+
+        // Write back to the billboards and advance the frame animations, which branch per particle
+        for (unsigned j = 0; j < numLanes; ++j)
+        {
+            if (!(enabledMask & (1u << j)))
+                continue;
+
+            Billboard& billboard = billboards[j];
+            if (!(liveMask & (1u << j)))
+            {
+                billboard.enabled_ = false;
+                continue;
+            }
+
+            unsigned k = i + j;
+            billboard.position_ += Vector3(deltaX[j], deltaY[j], deltaZ[j]);
+            billboard.direction_ = Vector3(directionX[j], directionY[j], directionZ[j]);
+            billboard.rotation_ += rotationDelta[j];
+            if (applyScaling)
+                billboard.size_ = Vector2(sizeX[k], sizeY[k]) * scale[k];
+
+            unsigned& index = streams_.colorIndex_[k];
+            if (index < colorFrames.Size())
+            {
+                if (index < colorFrames.Size() - 1)
+                {
+                    if (timer[k] >= colorFrames[index + 1].time_)
+                        ++index;
+                }
+                if (index < colorFrames.Size() - 1)
+                {
+                    float invInterval = colorFrameScales_[index];
+                    float t = invInterval > 0.0f ? (timer[k] - colorFrames[index].time_) * invInterval : 1.0f;
+#ifdef URHO3D_SSE
+                    __m128 color = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(colorFrames[index].color_.Data()), _mm_set1_ps(1.0f - t)),
+                        _mm_mul_ps(_mm_loadu_ps(colorFrames[index + 1].color_.Data()), _mm_set1_ps(t)));
+                    _mm_storeu_ps(&billboard.color_.r_, color);
+#else
+                    billboard.color_ = colorFrames[index].color_.Lerp(colorFrames[index + 1].color_, t);
+#endif
+                }
+                else
+                    billboard.color_ = colorFrames[index].color_;
+            }
+
+            unsigned& texIndex = streams_.texIndex_[k];
+            if (textureFrames.Size() && texIndex < textureFrames.Size() - 1)
+            {
+                if (timer[k] >= textureFrames[texIndex + 1].time_)
+                {
+                    billboard.uv_ = textureFrames[texIndex + 1].uv_;
+                    ++texIndex;
+                }
+            }
+        }
+    }
+
+    return active;
+}
+
+void ParticleEmitter::ResizeParticles(unsigned num)
+{
+    if (!soaStorage_)
+    {
+        particles_.Resize(num);
+        return;
+    }
+
+    // Pad to whole SIMD blocks so that the kernel can always load four elements
+    unsigned paddedNum = (num + 3) & ~3u;
+    streams_.velocityX_.Resize(paddedNum);
+    streams_.velocityY_.Resize(paddedNum);
+    streams_.velocityZ_.Resize(paddedNum);
+    streams_.sizeX_.Resize(paddedNum);
+    streams_.sizeY_.Resize(paddedNum);
+    streams_.timer_.Resize(paddedNum);
+    streams_.timeToLive_.Resize(paddedNum);
+    streams_.scale_.Resize(paddedNum);
+    streams_.rotationSpeed_.Resize(paddedNum);
+    streams_.colorIndex_.Resize(paddedNum);
+    streams_.texIndex_.Resize(paddedNum);
+
+    // Clear the padding and the new particles, so that the kernel does not operate on garbage
+    for (unsigned i = streams_.size_; i < paddedNum; ++i)
+    {
+        Particle particle{};
+        StoreParticle(i, particle);
+    }
+    streams_.size_ = num;
+}
+
+Particle ParticleEmitter::LoadParticle(unsigned index) const
+{
+    if (!soaStorage_)
+        return particles_[index];
+
+    Particle particle;
+    particle.velocity_ = Vector3(streams_.velocityX_[index], streams_.velocityY_[index], streams_.velocityZ_[index]);
+    particle.size_ = Vector2(streams_.sizeX_[index], streams_.sizeY_[index]);
+    particle.timer_ = streams_.timer_[index];
+    particle.timeToLive_ = streams_.timeToLive_[index];
+    particle.scale_ = streams_.scale_[index];
+    particle.rotationSpeed_ = streams_.rotationSpeed_[index];
+    particle.colorIndex_ = streams_.colorIndex_[index];
+    particle.texIndex_ = streams_.texIndex_[index];
+    return particle;
+}
+
+void ParticleEmitter::StoreParticle(unsigned index, const Particle& particle)
+{
+    if (!soaStorage_)
+    {
+        particles_[index] = particle;
+        return;
+    }
+
+    streams_.velocityX_[index] = particle.velocity_.x_;
+    streams_.velocityY_[index] = particle.velocity_.y_;
+    streams_.velocityZ_[index] = particle.velocity_.z_;
+    streams_.sizeX_[index] = particle.size_.x_;
+    streams_.sizeY_[index] = particle.size_.y_;
+    streams_.timer_[index] = particle.timer_;
+    streams_.timeToLive_[index] = particle.timeToLive_;
+    streams_.scale_[index] = particle.scale_;
+    streams_.rotationSpeed_[index] = particle.rotationSpeed_;
+    streams_.colorIndex_[index] = particle.colorIndex_;
+    streams_.texIndex_[index] = particle.texIndex_;
+}
+
 }
@@ -50,6 +50,35 @@ struct Particle
     unsigned texIndex_;
 };
 
+/// Particle state in structure-of-arrays form, used by the SoA storage mode. The arrays are padded to a multiple of 4 elements.
+struct ParticleStreams
+{
+    /// Velocity X components.
+    PODVector<float> velocityX_;
+    /// Velocity Y components.
+    PODVector<float> velocityY_;
+    /// Velocity Z components.
+    PODVector<float> velocityZ_;
+    /// Original billboard widths.
+    PODVector<float> sizeX_;
+    /// Original billboard heights.
+    PODVector<float> sizeY_;
+    /// Times elapsed from creation.
+    PODVector<float> timer_;
+    /// Lifetimes.
+    PODVector<float> timeToLive_;
+    /// Size scaling values.
+    PODVector<float> scale_;
+    /// Rotation speeds.
+    PODVector<float> rotationSpeed_;
+    /// Current color animation indices.
+    PODVector<unsigned> colorIndex_;
+    /// Current texture animation indices.
+    PODVector<unsigned> texIndex_;
+    /// Number of particles, excluding the padding.
+    unsigned size_{};
+};
+
 /// %Particle emitter component.
 class URHO3D_API ParticleEmitter : public BillboardSet
 {
@@ -83,6 +112,12 @@ public:
     /// Set to remove either the emitter component or its owner node from the scene automatically on particle effect completion. Disabled by default.
     /// @property
     void SetAutoRemoveMode(AutoRemoveMode mode);
+    /// Set whether to store the particles in structure-of-arrays form and update them with SIMD kernels. Default false. Recommended for effects with thousands of particles.
+    /// @property
+    void SetSoAStorage(bool enable);
+    /// Set the seed of the emitter's own random number generator. Each emitter draws from its own seed so that emitters can update in parallel deterministically.
+    /// @property
+    void SetSeed(unsigned seed);
     /// Reset the emission period timer.
     void ResetEmissionTimer();
     /// Remove all current particles.
@@ -98,7 +133,7 @@ public:
 
     /// Return maximum number of particles.
     /// @property
-    unsigned GetNumParticles() const { return particles_.Size(); }
+    unsigned GetNumParticles() const { return soaStorage_ ? streams_.size_ : particles_.Size(); }
 
     /// Return whether is currently emitting.
     /// @property
@@ -112,6 +147,14 @@ public:
     /// @property
     AutoRemoveMode GetAutoRemoveMode() const { return autoRemove_; }
 
+    /// Return whether the particles are stored in structure-of-arrays form.
+    /// @property
+    bool IsSoAStorage() const { return soaStorage_; }
+
+    /// Return the current seed of the emitter's random number generator.
+    /// @property
+    unsigned GetSeed() const { return randomSeed_; }
+
     /// Set particles effect attribute.
     void SetEffectAttr(const ResourceRef& value);
     /// Set particles effect attribute.
@@ -139,11 +182,27 @@ private:
     void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
     /// Handle live reload of the particle effect.
     void HandleEffectReloadFinished(StringHash eventType, VariantMap& eventData);
+    /// Advance the particles and their billboards in the structure-of-arrays storage mode. Return true if any were active.
+    bool UpdateParticlesSoA(const Vector3& constantForce, const Vector3& scaleVector);
+    /// Resize the particle storage of the current mode.
+    void ResizeParticles(unsigned num);
+    /// Return a particle from the storage of the current mode.
+    Particle LoadParticle(unsigned index) const;
+    /// Write a particle to the storage of the current mode.
+    void StoreParticle(unsigned index, const Particle& particle);
 
     /// Particle effect.
     SharedPtr<ParticleEffect> effect_;
-    /// Particles.
+    /// Particles in the default storage mode.
     PODVector<Particle> particles_;
+    /// Particles in the structure-of-arrays storage mode.
+    ParticleStreams streams_;
+    /// Reciprocal color frame intervals used by the structure-of-arrays update.
+    PODVector<float> colorFrameScales_;
+    /// Random number generator seed.
+    unsigned randomSeed_;
+    /// Index to start the free particle search from.
+    unsigned nextFreeParticle_;
     /// Active/inactive period timer.
     float periodTimer_;
     /// New particle emission timer.
@@ -160,6 +219,8 @@ private:
     bool serializeParticles_;
     /// Ready to send effect finish event flag.
     bool sendFinishedEvent_;
+    /// Structure-of-arrays storage flag.
+    bool soaStorage_;
     /// Automatic removal mode.
     AutoRemoveMode autoRemove_;
 };
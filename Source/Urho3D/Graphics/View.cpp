@@ -55,6 +55,9 @@
 namespace Urho3D
 {
 
+/// Number of occludees tested against the occlusion buffer in one batch.
+static const unsigned OCCLUDEE_BATCH_SIZE = 64;
+
 /// %Frustum octree query for shadowcasters.
 class ShadowCasterOctreeQuery : public FrustumOctreeQuery
 {
@@ -112,7 +115,7 @@ public:
     }
 };
 
-/// %Frustum octree query with occlusion.
+/// %Frustum octree query with occlusion. Note: drawable occlusion is performed later in worker threads.
 class OccludedFrustumOctreeQuery : public FrustumOctreeQuery
 {
 public:
@@ -138,102 +141,10 @@ public:
         }
     }
 
-    /// Intersection test for drawables. Note: drawable occlusion is performed later in worker threads.
-    void TestDrawables(Drawable** start, Drawable** end, bool inside) override
-    {
-        while (start != end)
-        {
-            Drawable* drawable = *start++;
-
-            if ((drawable->GetDrawableFlags() & drawableFlags_) && (drawable->GetViewMask() & viewMask_))
-            {
-                if (inside || frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
-                    result_.Push(drawable);
-            }
-        }
-    }
-
     /// Occlusion buffer.
     OcclusionBuffer* buffer_;
 };
 
-void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex)
-{
-    auto* view = reinterpret_cast<View*>(item->aux_);
-    auto** start = reinterpret_cast<Drawable**>(item->start_);
-    auto** end = reinterpret_cast<Drawable**>(item->end_);
-    OcclusionBuffer* buffer = view->occlusionBuffer_;
-    const Matrix3x4& viewMatrix = view->cullCamera_->GetView();
-    Vector3 viewZ = Vector3(viewMatrix.m20_, viewMatrix.m21_, viewMatrix.m22_);
-    Vector3 absViewZ = viewZ.Abs();
-    unsigned cameraViewMask = view->cullCamera_->GetViewMask();
-    bool cameraZoneOverride = view->cameraZoneOverride_;
-    PerThreadSceneResult& result = view->sceneResults_[threadIndex];
-
-    while (start != end)
-    {
-        Drawable* drawable = *start++;
-
-        if (!buffer || !drawable->IsOccludee() || buffer->IsVisible(drawable->GetWorldBoundingBox()))
-        {
-            drawable->UpdateBatches(view->frame_);
-            // If draw distance non-zero, update and check it
-            float maxDistance = drawable->GetDrawDistance();
-            if (maxDistance > 0.0f)
-            {
-                if (drawable->GetDistance() > maxDistance)
-                    continue;
-            }
-
-            drawable->MarkInView(view->frame_);
-
-            // For geometries, find zone, clear lights and calculate view space Z range
-            if (drawable->GetDrawableFlags() & DRAWABLE_GEOMETRY)
-            {
-                Zone* drawableZone = drawable->GetZone();
-                if (!cameraZoneOverride &&
-                    (drawable->IsZoneDirty() || !drawableZone || (drawableZone->GetViewMask() & cameraViewMask) == 0))
-                    view->FindZone(drawable);
-
-                const BoundingBox& geomBox = drawable->GetWorldBoundingBox();
-                Vector3 center = geomBox.Center();
-                Vector3 edge = geomBox.Size() * 0.5f;
-
-                // Do not add "infinite" objects like skybox to prevent shadow map focusing behaving erroneously
-                if (edge.LengthSquared() < M_LARGE_VALUE * M_LARGE_VALUE)
-                {
-                    float viewCenterZ = viewZ.DotProduct(center) + viewMatrix.m23_;
-                    float viewEdgeZ = absViewZ.DotProduct(edge);
-                    float minZ = viewCenterZ - viewEdgeZ;
-                    float maxZ = viewCenterZ + viewEdgeZ;
-                    drawable->SetMinMaxZ(viewCenterZ - viewEdgeZ, viewCenterZ + viewEdgeZ);
-                    result.minZ_ = Min(result.minZ_, minZ);
-                    result.maxZ_ = Max(result.maxZ_, maxZ);
-                }
-                else
-                    drawable->SetMinMaxZ(M_LARGE_VALUE, M_LARGE_VALUE);
-
-                result.geometries_.Push(drawable);
-            }
-            else if (drawable->GetDrawableFlags() & DRAWABLE_LIGHT)
-            {
-                auto* light = static_cast<Light*>(drawable);
-                // Skip lights with zero brightness or black color
-                if (!light->GetEffectiveColor().Equals(Color::BLACK))
-                    result.lights_.Push(light);
-            }
-        }
-    }
-}
-
-void ProcessLightWork(const WorkItem* item, unsigned threadIndex)
-{
-    auto* view = reinterpret_cast<View*>(item->aux_);
-    auto* query = reinterpret_cast<LightQueryResult*>(item->start_);
-
-    view->ProcessLight(*query, threadIndex);
-}
-
 void UpdateDrawableGeometriesWork(const WorkItem* item, unsigned threadIndex)
 {
     const FrameInfo& frame = *(reinterpret_cast<FrameInfo*>(item->aux_));
@@ -553,6 +464,10 @@ void View::Update(const FrameInfo& frame)
     if (cullCamera_ && cullCamera_->GetAutoAspectRatio())
         cullCamera_->SetAspectRatioInternal((float)frame_.viewSize_.x_ / (float)frame_.viewSize_.y_);
 
+    // Refresh packed bounds left over from the batch updates of the previous views
+    if (octree_)
+        octree_->ApplyBoundsUpdates();
+
     GetDrawables();
     GetBatches();
     renderer_->StorePreparedView(this, cullCamera_);
@@ -894,30 +809,11 @@ void View::GetDrawables()
             result.maxZ_ = 0.0f;
         }
 
-        int numWorkItems = queue->GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = tempDrawables.Size() / numWorkItems;
-
-        PODVector<Drawable*>::Iterator start = tempDrawables.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
+        Drawable** drawables = tempDrawables.Buffer();
+        queue->ParallelFor(0, tempDrawables.Size(), 0, [this, drawables](unsigned begin, unsigned end, unsigned threadIndex)
         {
-            SharedPtr<WorkItem> item = queue->GetFreeItem();
-            item->priority_ = M_MAX_UNSIGNED;
-            item->workFunction_ = CheckVisibilityWork;
-            item->aux_ = this;
-
-            PODVector<Drawable*>::Iterator end = tempDrawables.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue->AddWorkItem(item);
-
-            start = end;
-        }
-
-        queue->Complete(M_MAX_UNSIGNED);
+            CheckVisibility(drawables + begin, drawables + end, threadIndex);
+        });
     }
 
     // Combine lights, geometries & scene Z range from the threads
@@ -982,22 +878,34 @@ void View::ProcessLights()
     auto* queue = GetSubsystem<WorkQueue>();
     lightQueryResults_.Resize(lights_.Size());
 
+    // Build a task graph where the shadow caster queries of directional light splits start as soon as the light's own
+    // processing is done, and the shadow casters are combined once all splits are done. Lights do not wait for each other
+    WorkTaskGraph graph;
+
     for (unsigned i = 0; i < lightQueryResults_.Size(); ++i)
     {
-        SharedPtr<WorkItem> item = queue->GetFreeItem();
-        item->priority_ = M_MAX_UNSIGNED;
-        item->workFunction_ = ProcessLightWork;
-        item->aux_ = this;
+        LightQueryResult* query = &lightQueryResults_[i];
+        query->light_ = lights_[i];
 
-        LightQueryResult& query = lightQueryResults_[i];
-        query.light_ = lights_[i];
+        unsigned lightTask = graph.AddTask([this, query](unsigned threadIndex) { ProcessLight(*query, threadIndex); });
+        unsigned finalizeTask = graph.AddTask([this, query](unsigned threadIndex) { FinalizeLightQuery(*query); });
+        graph.AddDependency(finalizeTask, lightTask);
 
-        item->start_ = &query;
-        queue->AddWorkItem(item);
+        if (query->light_->GetLightType() == LIGHT_DIRECTIONAL)
+        {
+            for (unsigned j = 0; j < MAX_CASCADE_SPLITS; ++j)
+            {
+                unsigned splitTask = graph.AddContinuation(lightTask, [this, query, j](unsigned threadIndex)
+                {
+                    ProcessDirLightShadowSplit(*query, j, threadIndex);
+                });
+                graph.AddDependency(finalizeTask, splitTask);
+            }
+        }
     }
 
     // Ensure all lights have been processed before proceeding
-    queue->Complete(M_MAX_UNSIGNED);
+    queue->Run(&graph);
 }
 
 void View::GetLightBatches()
@@ -2300,6 +2208,91 @@ void View::DrawOccluders(OcclusionBuffer* buffer, const PODVector<Drawable*>& oc
     buffer->BuildDepthHierarchy();
 }
 
+void View::CheckVisibility(Drawable** start, Drawable** end, unsigned threadIndex)
+{
+    OcclusionBuffer* buffer = occlusionBuffer_;
+    const Matrix3x4& viewMatrix = cullCamera_->GetView();
+    Vector3 viewZ = Vector3(viewMatrix.m20_, viewMatrix.m21_, viewMatrix.m22_);
+    Vector3 absViewZ = viewZ.Abs();
+    unsigned cameraViewMask = cullCamera_->GetViewMask();
+    bool cameraZoneOverride = cameraZoneOverride_;
+    PerThreadSceneResult& result = sceneResults_[threadIndex];
+    BoundingBox occludeeBoxes[OCCLUDEE_BATCH_SIZE];
+    bool visible[OCCLUDEE_BATCH_SIZE];
+
+    while (start != end)
+    {
+        // Test the occludees of the next batch of drawables against the occlusion buffer at once
+        Drawable** batchEnd = start + Min((unsigned)(end - start), OCCLUDEE_BATCH_SIZE);
+        if (buffer)
+        {
+            unsigned numOccludees = 0;
+            for (Drawable** i = start; i != batchEnd; ++i)
+            {
+                if ((*i)->IsOccludee())
+                    occludeeBoxes[numOccludees++] = (*i)->GetWorldBoundingBox();
+            }
+            buffer->IsVisible(occludeeBoxes, numOccludees, visible);
+        }
+
+        unsigned occludeeIndex = 0;
+        while (start != batchEnd)
+        {
+            Drawable* drawable = *start++;
+
+            if (!buffer || !drawable->IsOccludee() || visible[occludeeIndex++])
+            {
+                drawable->UpdateBatches(frame_);
+                // If draw distance non-zero, update and check it
+                float maxDistance = drawable->GetDrawDistance();
+                if (maxDistance > 0.0f)
+                {
+                    if (drawable->GetDistance() > maxDistance)
+                        continue;
+                }
+
+                drawable->MarkInView(frame_);
+
+                // For geometries, find zone, clear lights and calculate view space Z range
+                if (drawable->GetDrawableFlags() & DRAWABLE_GEOMETRY)
+                {
+                    Zone* drawableZone = drawable->GetZone();
+                    if (!cameraZoneOverride &&
+                        (drawable->IsZoneDirty() || !drawableZone || (drawableZone->GetViewMask() & cameraViewMask) == 0))
+                        FindZone(drawable);
+
+                    const BoundingBox& geomBox = drawable->GetWorldBoundingBox();
+                    Vector3 center = geomBox.Center();
+                    Vector3 edge = geomBox.Size() * 0.5f;
+
+                    // Do not add "infinite" objects like skybox to prevent shadow map focusing behaving erroneously
+                    if (edge.LengthSquared() < M_LARGE_VALUE * M_LARGE_VALUE)
+                    {
+                        float viewCenterZ = viewZ.DotProduct(center) + viewMatrix.m23_;
+                        float viewEdgeZ = absViewZ.DotProduct(edge);
+                        float minZ = viewCenterZ - viewEdgeZ;
+                        float maxZ = viewCenterZ + viewEdgeZ;
+                        drawable->SetMinMaxZ(viewCenterZ - viewEdgeZ, viewCenterZ + viewEdgeZ);
+                        result.minZ_ = Min(result.minZ_, minZ);
+                        result.maxZ_ = Max(result.maxZ_, maxZ);
+                    }
+                    else
+                        drawable->SetMinMaxZ(M_LARGE_VALUE, M_LARGE_VALUE);
+
+                    result.geometries_.Push(drawable);
+                }
+                else if (drawable->GetDrawableFlags() & DRAWABLE_LIGHT)
+                {
+                    auto* light = static_cast<Light*>(drawable);
+                    // Skip lights with zero brightness or black color
+                    if (!light->GetEffectiveColor().Equals(Color::BLACK))
+                        result.lights_.Push(light);
+                }
+            }
+        }
+    }
+}
+
 void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
 {
     Light* light = query.light_;
@@ -2368,34 +2361,52 @@ void View::ProcessLight(LightQueryResult& query, unsigned threadIndex)
     // Determine number of shadow cameras and setup their initial positions
     SetupShadowCameras(query);
 
-    // Process each split for shadow casters
-    query.shadowCasters_.Clear();
     for (unsigned i = 0; i < query.numSplits_; ++i)
-    {
-        Camera* shadowCamera = query.shadowCameras_[i];
-        const Frustum& shadowCameraFrustum = shadowCamera->GetFrustum();
-        query.shadowCasterBegin_[i] = query.shadowCasterEnd_[i] = query.shadowCasters_.Size();
+        query.splitShadowCasters_[i].Clear();
+
+    // Directional light splits are processed in separate tasks, as each needs its own octree query
+    if (type == LIGHT_DIRECTIONAL)
+        return;
 
+    // Process each split for shadow casters, reusing the lit geometry query
+    for (unsigned i = 0; i < query.numSplits_; ++i)
+    {
         // For point light check that the face is visible: if not, can skip the split
-        if (type == LIGHT_POINT && frustum.IsInsideFast(BoundingBox(shadowCameraFrustum)) == OUTSIDE)
+        if (type == LIGHT_POINT && frustum.IsInsideFast(BoundingBox(query.shadowCameras_[i]->GetFrustum())) == OUTSIDE)
             continue;
 
-        // For directional light check that the split is inside the visible scene: if not, can skip the split
-        if (type == LIGHT_DIRECTIONAL)
-        {
-            if (minZ_ > query.shadowFarSplits_[i])
-                continue;
-            if (maxZ_ < query.shadowNearSplits_[i])
-                continue;
-
-            // Reuse lit geometry query for all except directional lights
-            ShadowCasterOctreeQuery query(tempDrawables, shadowCameraFrustum, DRAWABLE_GEOMETRY, cullCamera_->GetViewMask());
-            octree_->GetDrawables(query);
-        }
-
         // Check which shadow casters actually contribute to the shadowing
         ProcessShadowCasters(query, tempDrawables, i);
     }
+}
+
+void View::ProcessDirLightShadowSplit(LightQueryResult& query, unsigned splitIndex, unsigned threadIndex)
+{
+    if (splitIndex >= query.numSplits_)
+        return;
+
+    // Check that the split is inside the visible scene: if not, can skip the split
+    if (minZ_ > query.shadowFarSplits_[splitIndex] || maxZ_ < query.shadowNearSplits_[splitIndex])
+        return;
+
+    PODVector<Drawable*>& tempDrawables = tempDrawables_[threadIndex];
+    ShadowCasterOctreeQuery octreeQuery(tempDrawables, query.shadowCameras_[splitIndex]->GetFrustum(), DRAWABLE_GEOMETRY,
+        cullCamera_->GetViewMask());
+    octree_->GetDrawables(octreeQuery);
+
+    // Check which shadow casters actually contribute to the shadowing
+    ProcessShadowCasters(query, tempDrawables, splitIndex);
+}
+
+void View::FinalizeLightQuery(LightQueryResult& query)
+{
+    query.shadowCasters_.Clear();
+    for (unsigned i = 0; i < query.numSplits_; ++i)
+    {
+        query.shadowCasterBegin_[i] = query.shadowCasters_.Size();
+        query.shadowCasters_.Push(query.splitShadowCasters_[i]);
+        query.shadowCasterEnd_[i] = query.shadowCasters_.Size();
+    }
 
     // If no shadow casters, the light can be rendered unshadowed. At this point we have not allocated a shadow map yet, so the
     // only cost has been the shadow camera setup & queries
@@ -2472,11 +2483,9 @@ void View::ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawabl
                 lightProjBox = lightViewBox.Projected(lightProj);
                 query.shadowCasterBox_[splitIndex].Merge(lightProjBox);
             }
-            query.shadowCasters_.Push(drawable);
+            query.splitShadowCasters_[splitIndex].Push(drawable);
         }
     }
-
-    query.shadowCasterEnd_[splitIndex] = query.shadowCasters_.Size();
 }
 
 bool View::IsShadowCasterVisible(Drawable* drawable, BoundingBox lightViewBox, Camera* shadowCamera, const Matrix3x4& lightView,
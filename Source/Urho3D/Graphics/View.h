@@ -49,7 +49,6 @@ class Texture2D;
 class Viewport;
 class Zone;
 struct RenderPathCommand;
-struct WorkItem;
 
 /// Intermediate light processing result.
 struct LightQueryResult
@@ -62,6 +61,8 @@ struct LightQueryResult
     PODVector<Drawable*> shadowCasters_;
     /// Shadow cameras.
     Camera* shadowCameras_[MAX_LIGHT_SPLITS];
+    /// Shadow casters of each split before they are combined.
+    PODVector<Drawable*> splitShadowCasters_[MAX_LIGHT_SPLITS];
     /// Shadow caster start indices.
     unsigned shadowCasterBegin_[MAX_LIGHT_SPLITS];
     /// Shadow caster end indices.
@@ -109,9 +110,6 @@ static const unsigned MAX_VIEWPORT_TEXTURES = 2;
 /// Internal structure for 3D rendering work. Created for each backbuffer and texture viewport, but not for shadow cameras.
 class URHO3D_API View : public Object
 {
-    friend void CheckVisibilityWork(const WorkItem* item, unsigned threadIndex);
-    friend void ProcessLightWork(const WorkItem* item, unsigned threadIndex);
-
     URHO3D_OBJECT(View, Object);
 
 public:
@@ -234,8 +232,14 @@ private:
     void UpdateOccluders(PODVector<Drawable*>& occluders, Camera* camera);
     /// Draw occluders to occlusion buffer.
     void DrawOccluders(OcclusionBuffer* buffer, const PODVector<Drawable*>& occluders);
-    /// Query for lit geometries and shadow casters for a light.
+    /// Check occlusion and draw distance of drawables found by the octree query, and collect geometries and lights.
+    void CheckVisibility(Drawable** start, Drawable** end, unsigned threadIndex);
+    /// Query for lit geometries and set up shadow cameras for a light. Also query shadow casters for point and spot lights.
     void ProcessLight(LightQueryResult& query, unsigned threadIndex);
+    /// Query shadow casters for a directional light split. Called after ProcessLight().
+    void ProcessDirLightShadowSplit(LightQueryResult& query, unsigned splitIndex, unsigned threadIndex);
+    /// Combine the shadow casters of all splits. Called after the shadow casters of all splits have been queried.
+    void FinalizeLightQuery(LightQueryResult& query);
     /// Process shadow casters' visibilities and build their combined view- or projection-space bounding box.
     void ProcessShadowCasters(LightQueryResult& query, const PODVector<Drawable*>& drawables, unsigned splitIndex);
     /// Set up initial shadow camera view(s).
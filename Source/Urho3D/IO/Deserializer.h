@@ -54,6 +54,8 @@ public:
     /// Return whether the end of stream has been reached.
     /// @property
     virtual bool IsEof() const { return position_ >= size_; }
+    /// Return the whole stream contents if they reside contiguously in memory, or null if not. Allows parsing the data in place without copying.
+    virtual const unsigned char* GetMemoryData() const { return nullptr; }
 
     /// Set position relative to current position. Return actual new position.
     unsigned SeekRelative(int delta);
@@ -64,19 +64,26 @@ const char* APK = "/apk/";
 static const unsigned READ_BUFFER_SIZE = 32768;
 #endif
 static const unsigned SKIP_BUFFER_SIZE = 1024;
+/// Largest block size that the 16-bit block headers of the ULZ4 format can describe.
+static const unsigned MAX_COMPRESSED_BLOCK_SIZE = 65535;
 
 File::File(Context* context) :
     Object(context),
     mode_(FILE_READ),
     handle_(nullptr),
+    mappedData_(nullptr),
+    mappedPosition_(0),
 #ifdef __ANDROID__
     assetHandle_(0),
 #endif
     readBufferOffset_(0),
     readBufferSize_(0),
+    blockSize_(0),
+    currentBlock_(M_MAX_UNSIGNED),
     offset_(0),
     checksum_(0),
     compressed_(false),
+    useDictionary_(false),
     readSyncNeeded_(false),
     writeSyncNeeded_(false)
 {
@@ -86,14 +93,19 @@ File::File(Context* context, const String& fileName, FileMode mode) :
     Object(context),
     mode_(FILE_READ),
     handle_(nullptr),
+    mappedData_(nullptr),
+    mappedPosition_(0),
 #ifdef __ANDROID__
     assetHandle_(0),
 #endif
     readBufferOffset_(0),
     readBufferSize_(0),
+    blockSize_(0),
+    currentBlock_(M_MAX_UNSIGNED),
     offset_(0),
     checksum_(0),
     compressed_(false),
+    useDictionary_(false),
     readSyncNeeded_(false),
     writeSyncNeeded_(false)
 {
@@ -104,14 +116,19 @@ File::File(Context* context, PackageFile* package, const String& fileName) :
     Object(context),
     mode_(FILE_READ),
     handle_(nullptr),
+    mappedData_(nullptr),
+    mappedPosition_(0),
 #ifdef __ANDROID__
     assetHandle_(0),
 #endif
     readBufferOffset_(0),
     readBufferSize_(0),
+    blockSize_(0),
+    currentBlock_(M_MAX_UNSIGNED),
     offset_(0),
     checksum_(0),
     compressed_(false),
+    useDictionary_(false),
     readSyncNeeded_(false),
     writeSyncNeeded_(false)
 {
@@ -137,21 +154,53 @@ bool File::Open(PackageFile* package, const String& fileName)
     if (!entry)
         return false;
 
-    bool success = OpenInternal(package->GetName(), FILE_READ, true);
-    if (!success)
+    // Read directly from the mapping if available
+    if (package->IsMemoryMapped())
     {
-        URHO3D_LOGERROR("Could not open package file " + fileName);
-        return false;
+        Close();
+
+        auto* fileSystem = GetSubsystem<FileSystem>();
+        if (fileSystem && !fileSystem->CheckAccess(GetPath(package->GetName())))
+        {
+            URHO3D_LOGERRORF("Access denied to %s", package->GetName().CString());
+            return false;
+        }
+
+        mappedData_ = package->GetMappedData();
+        mode_ = FILE_READ;
+        position_ = 0;
+        readSyncNeeded_ = false;
+        writeSyncNeeded_ = false;
+    }
+    else
+    {
+        bool success = OpenInternal(package->GetName(), FILE_READ, true);
+        if (!success)
+        {
+            URHO3D_LOGERROR("Could not open package file " + fileName);
+            return false;
+        }
     }
 
+    package_ = package;
     name_ = fileName;
     offset_ = entry->offset_;
     checksum_ = entry->checksum_;
     size_ = entry->size_;
     compressed_ = package->IsCompressed();
+    blockSize_ = package->GetBlockSize();
+    useDictionary_ = entry->useDictionary_;
 
     // Seek to beginning of package entry's file data
     SeekInternal(offset_);
+
+    if (blockSize_ && !ReadBlockIndex())
+    {
+        URHO3D_LOGERROR("Invalid block index in package file " + fileName);
+        Close();
+        return false;
+    }
+
     return true;
 }
 
@@ -209,6 +258,32 @@ unsigned File::Read(void* dest, unsigned size)
     }
 #endif
 
+    if (blockSize_)
+    {
+        unsigned sizeLeft = size;
+        auto* destPtr = (unsigned char*)dest;
+
+        while (sizeLeft)
+        {
+            // Blocks are decompressed independently, so any position can be read without decompressing the preceding data
+            unsigned block = position_ / blockSize_;
+            if (block != currentBlock_ && !ReadBlock(block))
+            {
+                URHO3D_LOGERROR("Error while decompressing file " + GetName());
+                return size - sizeLeft;
+            }
+
+            unsigned blockOffset = position_ - block * blockSize_;
+            unsigned copySize = Min(readBufferSize_ - blockOffset, sizeLeft);
+            memcpy(destPtr, readBuffer_.Get() + blockOffset, copySize);
+            destPtr += copySize;
+            sizeLeft -= copySize;
+            position_ += copySize;
+        }
+
+        return size;
+    }
+
     if (compressed_)
     {
         unsigned sizeLeft = size;
@@ -219,21 +294,43 @@ unsigned File::Read(void* dest, unsigned size)
             if (!readBuffer_ || readBufferOffset_ >= readBufferSize_)
             {
                 unsigned char blockHeaderBytes[4];
-                ReadInternal(blockHeaderBytes, sizeof blockHeaderBytes);
+                if (!ReadInternal(blockHeaderBytes, sizeof blockHeaderBytes))
+                {
+                    URHO3D_LOGERROR("Error while decompressing file " + GetName());
+                    return size - sizeLeft;
+                }
 
                 MemoryBuffer blockHeader(&blockHeaderBytes[0], sizeof blockHeaderBytes);
                 unsigned unpackedSize = blockHeader.ReadUShort();
                 unsigned packedSize = blockHeader.ReadUShort();
 
+                // Size the buffers for the largest block the header can describe, so that corrupt sizes cannot overflow them
                 if (!readBuffer_)
                 {
-                    readBuffer_ = new unsigned char[unpackedSize];
-                    inputBuffer_ = new unsigned char[LZ4_compressBound(unpackedSize)];
+                    readBuffer_ = new unsigned char[MAX_COMPRESSED_BLOCK_SIZE];
+                    if (!mappedData_)
+                        inputBuffer_ = new unsigned char[MAX_COMPRESSED_BLOCK_SIZE];
                 }
 
-                /// \todo Handle errors
-                ReadInternal(inputBuffer_.Get(), packedSize);
-                LZ4_decompress_fast((const char*)inputBuffer_.Get(), (char*)readBuffer_.Get(), unpackedSize);
+                if (mappedData_)
+                {
+                    // Decompress straight from the mapping, without reading past it on truncated or corrupt data
+                    if (mappedPosition_ + packedSize > package_->GetTotalSize() ||
+                        LZ4_decompress_safe((const char*)mappedData_ + mappedPosition_, (char*)readBuffer_.Get(), packedSize,
+                            unpackedSize) != (int)unpackedSize)
+                    {
+                        URHO3D_LOGERROR("Error while decompressing file " + GetName());
+                        return size - sizeLeft;
+                    }
+                    mappedPosition_ += packedSize;
+                }
+                else if (!ReadInternal(inputBuffer_.Get(), packedSize) ||
+                    LZ4_decompress_safe((const char*)inputBuffer_.Get(), (char*)readBuffer_.Get(), packedSize, unpackedSize) !=
+                        (int)unpackedSize)
+                {
+                    URHO3D_LOGERROR("Error while decompressing file " + GetName());
+                    return size - sizeLeft;
+                }
 
                 readBufferSize_ = unpackedSize;
                 readBufferOffset_ = 0;
@@ -282,6 +379,13 @@ unsigned File::Seek(unsigned position)
     if (mode_ == FILE_READ && position > size_)
         position = size_;
 
+    // With a block index the containing block is located on the next read
+    if (blockSize_)
+    {
+        position_ = position;
+        return position_;
+    }
+
     if (compressed_)
     {
         // Start over from the beginning
@@ -352,6 +456,11 @@ unsigned File::Write(const void* data, unsigned size)
     return size;
 }
 
+const unsigned char* File::GetMemoryData() const
+{
+    return mappedData_ && !compressed_ ? mappedData_ + offset_ : nullptr;
+}
+
 unsigned File::GetChecksum()
 {
     if (offset_ || checksum_)
@@ -394,6 +503,22 @@ void File::Close()
     readBuffer_.Reset();
     inputBuffer_.Reset();
 
+    package_.Reset();
+    blockOffsets_.Clear();
+    blockSize_ = 0;
+    currentBlock_ = M_MAX_UNSIGNED;
+    readBufferSize_ = 0;
+
+    if (mappedData_)
+    {
+        mappedData_ = nullptr;
+        mappedPosition_ = 0;
+        position_ = 0;
+        size_ = 0;
+        offset_ = 0;
+        checksum_ = 0;
+    }
+
     if (handle_)
     {
         fclose((FILE*)handle_);
@@ -414,9 +539,9 @@ void File::Flush()
 bool File::IsOpen() const
 {
 #ifdef __ANDROID__
-    return handle_ != 0 || assetHandle_ != 0;
+    return handle_ != 0 || assetHandle_ != 0 || mappedData_ != 0;
 #else
-    return handle_ != nullptr;
+    return handle_ != nullptr || mappedData_ != nullptr;
 #endif
 }
 
@@ -520,6 +645,15 @@ bool File::OpenInternal(const String& fileName, FileMode mode, bool fromPackage)
 
 bool File::ReadInternal(void* dest, unsigned size)
 {
+    if (mappedData_)
+    {
+        if (mappedPosition_ + size > package_->GetTotalSize())
+            return false;
+        memcpy(dest, mappedData_ + mappedPosition_, size);
+        mappedPosition_ += size;
+        return true;
+    }
+
 #ifdef __ANDROID__
     if (assetHandle_)
     {
@@ -530,8 +664,75 @@ bool File::ReadInternal(void* dest, unsigned size)
         return fread(dest, size, 1, (FILE*)handle_) == 1;
 }
 
+bool File::ReadBlockIndex()
+{
+    // The index stores the packed size of each block, followed by the block data
+    unsigned numBlocks = (size_ + blockSize_ - 1) / blockSize_;
+    auto maxPackedSize = (unsigned)LZ4_compressBound(blockSize_);
+    blockOffsets_.Resize(numBlocks + 1);
+    blockOffsets_[0] = offset_ + numBlocks * sizeof(unsigned);
+    for (unsigned i = 0; i < numBlocks; ++i)
+    {
+        unsigned packedSize;
+        if (!ReadInternal(&packedSize, sizeof packedSize) || packedSize > maxPackedSize)
+            return false;
+        blockOffsets_[i + 1] = blockOffsets_[i] + packedSize;
+    }
+
+    currentBlock_ = M_MAX_UNSIGNED;
+    return blockOffsets_.Back() <= package_->GetTotalSize();
+}
+
+bool File::ReadBlock(unsigned index)
+{
+    unsigned packedSize = blockOffsets_[index + 1] - blockOffsets_[index];
+    unsigned unpackedSize = Min(blockSize_, size_ - index * blockSize_);
+
+    if (!readBuffer_)
+        readBuffer_ = new unsigned char[blockSize_];
+    currentBlock_ = M_MAX_UNSIGNED;
+    readBufferSize_ = 0;
+
+    const unsigned char* src;
+    if (mappedData_)
+        src = mappedData_ + blockOffsets_[index];
+    else
+    {
+        if (!inputBuffer_)
+            inputBuffer_ = new unsigned char[LZ4_compressBound(blockSize_)];
+        SeekInternal(blockOffsets_[index]);
+        if (!ReadInternal(inputBuffer_.Get(), packedSize))
+            return false;
+        src = inputBuffer_.Get();
+    }
+
+    // Blocks that did not shrink in compression are stored as is
+    if (packedSize == unpackedSize)
+        memcpy(readBuffer_.Get(), src, unpackedSize);
+    else
+    {
+        const PODVector<unsigned char>& dictionary = package_->GetDictionary();
+        int decompressedSize = useDictionary_ && dictionary.Size() ?
+            LZ4_decompress_safe_usingDict((const char*)src, (char*)readBuffer_.Get(), packedSize, unpackedSize,
+                (const char*)&dictionary[0], dictionary.Size()) :
+            LZ4_decompress_safe((const char*)src, (char*)readBuffer_.Get(), packedSize, unpackedSize);
+        if (decompressedSize != (int)unpackedSize)
+            return false;
+    }
+
+    currentBlock_ = index;
+    readBufferSize_ = unpackedSize;
+    return true;
+}
+
 void File::SeekInternal(unsigned newPosition)
 {
+    if (mappedData_)
+    {
+        mappedPosition_ = newPosition;
+        return;
+    }
+
 #ifdef __ANDROID__
     if (assetHandle_)
     {
@@ -82,6 +82,8 @@ public:
 
     /// Return a checksum of the file contents using the SDBM hash algorithm.
     unsigned GetChecksum() override;
+    /// Return the file contents for parsing without copying if opened from an uncompressed memory-mapped package file, or null otherwise.
+    const unsigned char* GetMemoryData() const override;
 
     /// Open a filesystem file. Return true if successful.
     bool Open(const String& fileName, FileMode mode = FILE_READ);
@@ -107,6 +109,9 @@ public:
     /// @property
     bool IsPackaged() const { return offset_ != 0; }
 
+    /// Return whether the file is read from a memory-mapped package file.
+    bool IsMemoryMapped() const { return mappedData_ != nullptr; }
+
 private:
     /// Open file internally using either C standard IO functions or SDL RWops for Android asset files. Return true if successful.
     bool OpenInternal(const String& fileName, FileMode mode, bool fromPackage = false);
@@ -114,11 +119,21 @@ private:
     bool ReadInternal(void* dest, unsigned size);
     /// Seek in file internally using either C standard IO functions or SDL RWops for Android asset files.
     void SeekInternal(unsigned newPosition);
+    /// Read the block index of a block-indexed compressed package file entry. Return true if successful.
+    bool ReadBlockIndex();
+    /// Decompress a block of a block-indexed compressed package file entry into the read buffer. Return true if successful.
+    bool ReadBlock(unsigned index);
 
     /// Open mode.
     FileMode mode_;
     /// File handle.
     void* handle_;
+    /// Package file the file was opened from, held to keep its mapping and dictionary alive.
+    SharedPtr<PackageFile> package_;
+    /// Memory-mapped package file data.
+    const unsigned char* mappedData_;
+    /// Read position within the memory-mapped package file.
+    unsigned mappedPosition_;
 #ifdef __ANDROID__
     /// SDL RWops context for Android asset loading.
     SDL_RWops* assetHandle_;
@@ -131,12 +146,20 @@ private:
     unsigned readBufferOffset_;
     /// Bytes in the current read buffer.
     unsigned readBufferSize_;
+    /// Package file offsets of the compressed blocks, followed by the end offset.
+    PODVector<unsigned> blockOffsets_;
+    /// Uncompressed block size of a block-indexed compressed file, 0 if not block-indexed.
+    unsigned blockSize_;
+    /// Index of the block in the read buffer.
+    unsigned currentBlock_;
     /// Start position within a package file, 0 for regular files.
     unsigned offset_;
     /// Content checksum.
     unsigned checksum_;
     /// Compression flag.
     bool compressed_;
+    /// Shared dictionary compression flag.
+    bool useDictionary_;
     /// Synchronization needed before read -flag.
     bool readSyncNeeded_;
     /// Synchronization needed before write -flag.
@@ -32,6 +32,7 @@
 #include "../IO/IOEvents.h"
 #include "../IO/Log.h"
 
+#include <atomic>
 #include <cstdio>
 
 #ifdef __ANDROID__
@@ -56,11 +57,165 @@ const char* logLevelPrefixes[] =
     nullptr
 };
 
+/// Number of message slots in the asynchronous queue. Must be a power of two.
+static const unsigned ASYNC_QUEUE_SIZE = 4096;
+/// Interval for flushing the log file in asynchronous mode.
+static const unsigned ASYNC_FLUSH_INTERVAL_MSEC = 250;
+/// Writer thread sleep time when the asynchronous queue is empty.
+static const unsigned ASYNC_IDLE_SLEEP_MSEC = 2;
+
 static Log* logInstance = nullptr;
 static bool threadErrorDisplayed = false;
+static std::atomic<ThreadID> asyncWriterThreadID{};
+
+/// Message slot in the asynchronous log queue.
+struct AsyncLogSlot
+{
+    /// Sequence number, tells whether the slot is free or holds a message.
+    std::atomic<unsigned> sequence_;
+    /// Message text.
+    String message_;
+    /// Formatted message text. Empty if sent from another thread, in which case it is formatted by the writer thread.
+    String formattedMessage_;
+    /// Message level.
+    int level_;
+    /// Error flag for raw messages.
+    bool error_;
+    /// Sent from the main thread flag. The log event has then already been sent.
+    bool mainThread_;
+    /// Time the message was logged as seconds since 1.1.1970.
+    unsigned time_;
+};
+
+/// Bounded lock-free message queue with multiple producers and a single consumer.
+class AsyncLogQueue
+{
+public:
+    /// Construct.
+    AsyncLogQueue() :
+        slots_(new AsyncLogSlot[ASYNC_QUEUE_SIZE]),
+        enqueuePos_(0),
+        dequeuePos_(0),
+        numDropped_(0)
+    {
+        for (unsigned i = 0; i < ASYNC_QUEUE_SIZE; ++i)
+            slots_[i].sequence_.store(i, std::memory_order_relaxed);
+    }
+
+    /// Push a message. Return false if the queue is full. Can be called from any thread.
+    bool Push(const String& message, const String& formattedMessage, int level, bool error, bool mainThread, unsigned time)
+    {
+        unsigned pos = enqueuePos_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            AsyncLogSlot& slot = slots_[pos & (ASYNC_QUEUE_SIZE - 1)];
+            auto diff = (int)(slot.sequence_.load(std::memory_order_acquire) - pos);
+            if (diff == 0)
+            {
+                // Slot is free: try to claim it
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.message_ = message;
+                    slot.formattedMessage_ = formattedMessage;
+                    slot.level_ = level;
+                    slot.error_ = error;
+                    slot.mainThread_ = mainThread;
+                    slot.time_ = time;
+                    slot.sequence_.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    /// Pop a message into the destination slot, swapping the string buffers so that the queue keeps its allocated memory. Return false if the queue is empty. Must be called from one thread at a time.
+    bool Pop(AsyncLogSlot& dest)
+    {
+        AsyncLogSlot& slot = slots_[dequeuePos_ & (ASYNC_QUEUE_SIZE - 1)];
+        if ((int)(slot.sequence_.load(std::memory_order_acquire) - (dequeuePos_ + 1)) < 0)
+            return false;
+
+        dest.message_.Swap(slot.message_);
+        dest.formattedMessage_.Swap(slot.formattedMessage_);
+        dest.level_ = slot.level_;
+        dest.error_ = slot.error_;
+        dest.mainThread_ = slot.mainThread_;
+        dest.time_ = slot.time_;
+        slot.sequence_.store(dequeuePos_ + ASYNC_QUEUE_SIZE, std::memory_order_release);
+        ++dequeuePos_;
+        return true;
+    }
+
+    /// Message slots.
+    SharedArrayPtr<AsyncLogSlot> slots_;
+    /// Next position to push to.
+    std::atomic<unsigned> enqueuePos_;
+    /// Next position to pop from.
+    unsigned dequeuePos_;
+    /// Number of messages dropped because the queue was full.
+    std::atomic<unsigned> numDropped_;
+};
+
+/// Background thread writing the asynchronous log messages.
+class AsyncLogWriter : public Thread
+{
+public:
+    /// Construct.
+    explicit AsyncLogWriter(Log* log) :
+        log_(log)
+    {
+    }
+
+    /// Process messages until stopped, then write the remaining ones.
+    void ThreadFunction() override
+    {
+        asyncWriterThreadID = Thread::GetCurrentThreadID();
+
+        while (shouldRun_)
+        {
+            if (!log_->WriteQueuedMessages())
+                Time::Sleep(ASYNC_IDLE_SLEEP_MSEC);
+        }
+
+        log_->WriteQueuedMessages();
+    }
+
+private:
+    /// Log subsystem.
+    Log* log_;
+};
+
+static String FormatTimeStamp(unsigned timeSinceEpoch)
+{
+    auto sysTime = (time_t)timeSinceEpoch;
+#ifdef _WIN32
+    // The Windows C runtime uses a per-thread buffer
+    const char* dateTime = ctime(&sysTime);
+#else
+    char dateTime[32];
+    ctime_r(&sysTime, dateTime);
+#endif
+    return String(dateTime).Replaced("\n", "");
+}
+
+static String FormatLogMessage(int level, const String& message, bool timeStamp, unsigned time)
+{
+    String formattedMessage = logLevelPrefixes[level];
+    formattedMessage += ": " + message;
+
+    if (timeStamp)
+        formattedMessage = "[" + FormatTimeStamp(time) + "] " + formattedMessage;
+
+    return formattedMessage;
+}
 
 Log::Log(Context* context) :
     Object(context),
+    numReportedDropped_(0),
 #ifdef _DEBUG
     level_(LOG_DEBUG),
 #else
@@ -68,7 +223,9 @@ Log::Log(Context* context) :
 #endif
     timeStamp_(true),
     inWrite_(false),
-    quiet_(false)
+    quiet_(false),
+    async_(false),
+    needFlush_(false)
 {
     logInstance = this;
 
@@ -77,6 +234,7 @@ Log::Log(Context* context) :
 
 Log::~Log()
 {
+    SetAsync(false);
     logInstance = nullptr;
 }
 
@@ -85,28 +243,39 @@ void Log::Open(const String& fileName)
 #if !defined(__ANDROID__) && !defined(IOS) && !defined(TVOS)
     if (fileName.Empty())
         return;
-    if (logFile_ && logFile_->IsOpen())
+
+    bool opened;
     {
-        if (logFile_->GetName() == fileName)
-            return;
-        else
-            Close();
+        // The writer thread may be accessing the log file in asynchronous mode. Do not log while holding the mutex, as
+        // an error could wait for the writer thread to make space in the queue
+        MutexLock lock(logMutex_);
+
+        if (logFile_ && logFile_->IsOpen())
+        {
+            if (logFile_->GetName() == fileName)
+                return;
+
+            logFile_->Close();
+        }
+
+        logFile_ = new File(context_);
+        opened = logFile_->Open(fileName, FILE_WRITE);
+        if (!opened)
+            logFile_.Reset();
     }
 
-    logFile_ = new File(context_);
-    if (logFile_->Open(fileName, FILE_WRITE))
+    if (opened)
         Write(LOG_INFO, "Opened log file " + fileName);
     else
-    {
-        logFile_.Reset();
         Write(LOG_ERROR, "Failed to create log file " + fileName);
-    }
 #endif
 }
 
 void Log::Close()
 {
 #if !defined(__ANDROID__) && !defined(IOS) && !defined(TVOS)
+    MutexLock lock(logMutex_);
+
     if (logFile_ && logFile_->IsOpen())
     {
         logFile_->Close();
@@ -136,6 +305,46 @@ void Log::SetQuiet(bool quiet)
     quiet_ = quiet;
 }
 
+void Log::SetAsync(bool enable)
+{
+    if (enable == async_)
+        return;
+
+    if (enable)
+    {
+        if (!asyncQueue_)
+            asyncQueue_ = new AsyncLogQueue();
+        asyncWriter_ = new AsyncLogWriter(this);
+        if (!asyncWriter_->Run())
+        {
+            asyncWriter_.Reset();
+            URHO3D_LOGERROR("Failed to start asynchronous log writer thread");
+            return;
+        }
+
+        flushTimer_.Reset();
+        async_ = true;
+    }
+    else
+    {
+        // Stop queuing new messages first. The writer thread writes the remaining messages before exiting
+        async_ = false;
+        asyncWriter_->Stop();
+        asyncWriter_.Reset();
+
+        MutexLock lock(logMutex_);
+        WriteQueuedMessages();
+        if (logFile_)
+            logFile_->Flush();
+        needFlush_ = false;
+    }
+}
+
+unsigned Log::GetNumDroppedMessages() const
+{
+    return asyncQueue_ ? asyncQueue_->numDropped_.load(std::memory_order_relaxed) : 0;
+}
+
 void Log::WriteFormat(int level, const char* format, ...)
 {
     if (!logInstance || logInstance->level_ > level)
@@ -169,56 +378,47 @@ void Log::Write(int level, const String& message)
     {
         if (logInstance)
         {
-            MutexLock lock(logInstance->logMutex_);
-            logInstance->threadMessages_.Push(StoredLogMessage(message, level, false));
+            if (logInstance->async_)
+            {
+                // In asynchronous mode the message is formatted and written in the writer thread, which then stores it
+                // for sending the log event in the main thread
+                if (logInstance->level_ <= level)
+                    logInstance->QueueMessage(message, String::EMPTY, level, false, false, Time::GetTimeSinceEpoch());
+            }
+            else
+            {
+                StoredLogMessage stored(message, level, false, false, Time::GetTimeSinceEpoch());
+                MutexLock lock(logInstance->logMutex_);
+                logInstance->threadMessages_.Push(stored);
+            }
         }
 
         return;
     }
 
+    if (logInstance)
+        logInstance->WriteMessage(level, message, Time::GetTimeSinceEpoch());
+}
+
+void Log::WriteMessage(int level, const String& message, unsigned time)
+{
     // Do not log if message level excluded or if currently sending a log event
-    if (!logInstance || logInstance->level_ > level || logInstance->inWrite_)
+    if (level_ > level || inWrite_)
         return;
 
-    String formattedMessage = logLevelPrefixes[level];
-    formattedMessage += ": " + message;
-    logInstance->lastMessage_ = message;
-
-    if (logInstance->timeStamp_)
-        formattedMessage = "[" + Time::GetTimeStamp() + "] " + formattedMessage;
+    String formattedMessage = FormatLogMessage(level, message, timeStamp_, time);
+    lastMessage_ = message;
 
-#if defined(__ANDROID__)
-    int androidLevel = ANDROID_LOG_VERBOSE + level;
-    __android_log_print(androidLevel, "Urho3D", "%s", message.CString());
-#elif defined(IOS) || defined(TVOS)
-    SDL_IOS_LogMessage(message.CString());
-#else
-    if (logInstance->quiet_)
-    {
-        // If in quiet mode, still print the error message to the standard error stream
-        if (level == LOG_ERROR)
-            PrintUnicodeLine(formattedMessage, true);
-    }
+    if (async_)
+        QueueMessage(message, formattedMessage, level, false, true, time);
     else
-        PrintUnicodeLine(formattedMessage, level == LOG_ERROR);
-#endif
-
-    if (logInstance->logFile_)
     {
-        logInstance->logFile_->WriteLine(formattedMessage);
-        logInstance->logFile_->Flush();
+        WriteOutput(level, message, formattedMessage, level == LOG_ERROR);
+        if (logFile_)
+            logFile_->Flush();
     }
 
-    logInstance->inWrite_ = true;
-
-    using namespace LogMessage;
-
-    VariantMap& eventData = logInstance->GetEventDataMap();
-    eventData[P_MESSAGE] = formattedMessage;
-    eventData[P_LEVEL] = level;
-    logInstance->SendEvent(E_LOGMESSAGE, eventData);
-
-    logInstance->inWrite_ = false;
+    SendMessageEvent(formattedMessage, level);
 }
 
 void Log::WriteRaw(const String& message, bool error)
@@ -228,8 +428,13 @@ void Log::WriteRaw(const String& message, bool error)
     {
         if (logInstance)
         {
-            MutexLock lock(logInstance->logMutex_);
-            logInstance->threadMessages_.Push(StoredLogMessage(message, LOG_RAW, error));
+            if (logInstance->async_)
+                logInstance->QueueMessage(message, message, LOG_RAW, error, false, 0);
+            else
+            {
+                MutexLock lock(logInstance->logMutex_);
+                logInstance->threadMessages_.Push(StoredLogMessage(message, LOG_RAW, error));
+            }
         }
 
         return;
@@ -241,43 +446,147 @@ void Log::WriteRaw(const String& message, bool error)
 
     logInstance->lastMessage_ = message;
 
-#if defined(__ANDROID__)
-    if (logInstance->quiet_)
+    if (logInstance->async_)
+        logInstance->QueueMessage(message, message, LOG_RAW, error, true, 0);
+    else
     {
-        if (error)
-            __android_log_print(ANDROID_LOG_ERROR, "Urho3D", "%s", message.CString());
+        logInstance->WriteOutput(LOG_RAW, message, message, error);
+        if (logInstance->logFile_)
+            logInstance->logFile_->Flush();
+    }
+
+    logInstance->SendMessageEvent(message, error ? LOG_ERROR : LOG_INFO);
+}
+
+void Log::QueueMessage(const String& message, const String& formattedMessage, int level, bool error, bool mainThread, unsigned time)
+{
+    if (asyncQueue_->Push(message, formattedMessage, level, error, mainThread, time))
+        return;
+
+    // The queue is full. Errors wait for the writer thread to make space, while other messages are dropped. The writer
+    // thread itself (for example a log file error) can not wait for itself
+    if ((level == LOG_ERROR || (level == LOG_RAW && error)) && Thread::GetCurrentThreadID() != asyncWriterThreadID.load())
+    {
+        while (async_ && !asyncQueue_->Push(message, formattedMessage, level, error, mainThread, time))
+            Time::Sleep(0);
     }
     else
-        __android_log_print(error ? ANDROID_LOG_ERROR : ANDROID_LOG_INFO, "Urho3D", "%s", message.CString());
+        asyncQueue_->numDropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Log::WriteOutput(int level, const String& message, const String& formattedMessage, bool error)
+{
+    if (level == LOG_RAW)
+    {
+#if defined(__ANDROID__)
+        if (quiet_)
+        {
+            if (error)
+                __android_log_print(ANDROID_LOG_ERROR, "Urho3D", "%s", message.CString());
+        }
+        else
+            __android_log_print(error ? ANDROID_LOG_ERROR : ANDROID_LOG_INFO, "Urho3D", "%s", message.CString());
 #elif defined(IOS) || defined(TVOS)
-    SDL_IOS_LogMessage(message.CString());
+        SDL_IOS_LogMessage(message.CString());
 #else
-    if (logInstance->quiet_)
-    {
-        // If in quiet mode, still print the error message to the standard error stream
-        if (error)
-            PrintUnicode(message, true);
+        if (quiet_)
+        {
+            // If in quiet mode, still print the error message to the standard error stream
+            if (error)
+                PrintUnicode(message, true);
+        }
+        else
+            PrintUnicode(message, error);
+#endif
+
+        if (logFile_)
+            logFile_->Write(message.CString(), message.Length());
     }
     else
-        PrintUnicode(message, error);
+    {
+#if defined(__ANDROID__)
+        int androidLevel = ANDROID_LOG_VERBOSE + level;
+        __android_log_print(androidLevel, "Urho3D", "%s", message.CString());
+#elif defined(IOS) || defined(TVOS)
+        SDL_IOS_LogMessage(message.CString());
+#else
+        if (quiet_)
+        {
+            // If in quiet mode, still print the error message to the standard error stream
+            if (error)
+                PrintUnicodeLine(formattedMessage, true);
+        }
+        else
+            PrintUnicodeLine(formattedMessage, error);
 #endif
 
-    if (logInstance->logFile_)
-    {
-        logInstance->logFile_->Write(message.CString(), message.Length());
-        logInstance->logFile_->Flush();
+        if (logFile_)
+            logFile_->WriteLine(formattedMessage);
     }
+}
 
-    logInstance->inWrite_ = true;
+void Log::SendMessageEvent(const String& message, int level)
+{
+    inWrite_ = true;
 
     using namespace LogMessage;
 
-    VariantMap& eventData = logInstance->GetEventDataMap();
+    VariantMap& eventData = GetEventDataMap();
     eventData[P_MESSAGE] = message;
-    eventData[P_LEVEL] = error ? LOG_ERROR : LOG_INFO;
-    logInstance->SendEvent(E_LOGMESSAGE, eventData);
+    eventData[P_LEVEL] = level;
+    SendEvent(E_LOGMESSAGE, eventData);
+
+    inWrite_ = false;
+}
+
+bool Log::WriteQueuedMessages()
+{
+    AsyncLogSlot slot;
+    bool hasMessages = false;
+    bool hasErrors = false;
+
+    // Hold the mutex for the whole batch, as the log file may be reopened and the thread messages are accessed from the
+    // main thread
+    MutexLock lock(logMutex_);
+
+    while (asyncQueue_->Pop(slot))
+    {
+        bool raw = slot.level_ == LOG_RAW;
+        bool error = raw ? slot.error_ : slot.level_ == LOG_ERROR;
+
+        // Messages from other threads are queued unformatted
+        if (!raw && slot.formattedMessage_.Empty())
+            slot.formattedMessage_ = FormatLogMessage(slot.level_, slot.message_, timeStamp_, slot.time_);
+        WriteOutput(slot.level_, slot.message_, slot.formattedMessage_, error);
+
+        // The log events for messages from other threads are sent in the main thread at the end of the frame
+        if (!slot.mainThread_)
+            threadMessages_.Push(StoredLogMessage(slot.message_, slot.level_, slot.error_, true, slot.time_));
+
+        hasMessages = true;
+        hasErrors |= error;
+    }
 
-    logInstance->inWrite_ = false;
+    unsigned numDropped = asyncQueue_->numDropped_.load(std::memory_order_relaxed);
+    if (numDropped != numReportedDropped_)
+    {
+        String message = "Log queue full, dropped " + String(numDropped - numReportedDropped_) + " messages";
+        WriteOutput(LOG_WARNING, message, FormatLogMessage(LOG_WARNING, message, timeStamp_, Time::GetTimeSinceEpoch()), false);
+        numReportedDropped_ = numDropped;
+        hasMessages = true;
+    }
+
+    // Flush the log file immediately after errors, otherwise periodically
+    needFlush_ |= hasMessages;
+    if (needFlush_ && (hasErrors || flushTimer_.GetMSec(false) >= ASYNC_FLUSH_INTERVAL_MSEC))
+    {
+        if (logFile_)
+            logFile_->Flush();
+        flushTimer_.Reset();
+        needFlush_ = false;
+    }
+
+    return hasMessages;
 }
 
 void Log::HandleEndFrame(StringHash eventType, VariantMap& eventData)
@@ -293,19 +602,39 @@ void Log::HandleEndFrame(StringHash eventType, VariantMap& eventData)
         return;
     }
 
-    MutexLock lock(logMutex_);
+    // Take the messages accumulated from other threads (if any), so that the asynchronous writer is not blocked while
+    // the log events are handled
+    List<StoredLogMessage> messages;
+    {
+        MutexLock lock(logMutex_);
 
-    // Process messages accumulated from other threads (if any)
-    while (!threadMessages_.Empty())
+        // Messages may have been queued by other threads just when asynchronous mode was disabled
+        if (asyncQueue_ && !async_)
+            WriteQueuedMessages();
+
+        messages.Swap(threadMessages_);
+    }
+
+    for (List<StoredLogMessage>::ConstIterator i = messages.Begin(); i != messages.End(); ++i)
     {
-        const StoredLogMessage& stored = threadMessages_.Front();
+        const StoredLogMessage& stored = *i;
 
-        if (stored.level_ != LOG_RAW)
-            Write(stored.level_, stored.message_);
+        if (stored.written_)
+        {
+            // Only send the log event for messages already written by the asynchronous writer
+            if (!inWrite_)
+            {
+                lastMessage_ = stored.message_;
+                if (stored.level_ != LOG_RAW)
+                    SendMessageEvent(FormatLogMessage(stored.level_, stored.message_, timeStamp_, stored.time_), stored.level_);
+                else
+                    SendMessageEvent(stored.message_, stored.error_ ? LOG_ERROR : LOG_INFO);
+            }
+        }
+        else if (stored.level_ != LOG_RAW)
+            WriteMessage(stored.level_, stored.message_, stored.time_);
         else
             WriteRaw(stored.message_, stored.error_);
-
-        threadMessages_.PopFront();
     }
 }
 
@@ -23,9 +23,13 @@
 #pragma once
 
 #include "../Container/List.h"
+#include "../Container/Ptr.h"
 #include "../Core/Mutex.h"
 #include "../Core/Object.h"
 #include "../Core/StringUtils.h"
+#include "../Core/Timer.h"
+
+#include <atomic>
 
 namespace Urho3D
 {
@@ -45,6 +49,8 @@ static const int LOG_ERROR = 4;
 /// Disable all log messages.
 static const int LOG_NONE = 5;
 
+class AsyncLogQueue;
+class AsyncLogWriter;
 class File;
 
 /// Stored log message from another thread.
@@ -54,10 +60,12 @@ struct StoredLogMessage
     StoredLogMessage() = default;
 
     /// Construct with parameters.
-    StoredLogMessage(const String& message, int level, bool error) :
+    StoredLogMessage(const String& message, int level, bool error, bool written = false, unsigned time = 0) :
         message_(message),
         level_(level),
-        error_(error)
+        error_(error),
+        written_(written),
+        time_(time)
     {
     }
 
@@ -67,6 +75,10 @@ struct StoredLogMessage
     int level_{};
     /// Error flag for raw messages.
     bool error_{};
+    /// Already written by the asynchronous writer flag. Only the log event remains to be sent.
+    bool written_{};
+    /// Time the message was logged as seconds since 1.1.1970, used for the timestamp.
+    unsigned time_{};
 };
 
 /// Logging subsystem.
@@ -74,6 +86,8 @@ class URHO3D_API Log : public Object
 {
     URHO3D_OBJECT(Log, Object);
 
+    friend class AsyncLogWriter;
+
 public:
     /// Construct.
     explicit Log(Context* context);
@@ -93,6 +107,9 @@ public:
     /// Set quiet mode ie. only print error entries to standard error stream (which is normally redirected to console also). Output to log file is not affected by this mode.
     /// @property
     void SetQuiet(bool quiet);
+    /// Set asynchronous mode, where standard output and log file writes happen in a background thread and the log file is flushed periodically or after errors. Messages that do not fit in the queue are dropped, except for errors, which wait for free space. Log events are still sent in the main thread.
+    /// @property
+    void SetAsync(bool enable);
 
     /// Return logging level.
     /// @property
@@ -110,6 +127,14 @@ public:
     /// @property
     bool IsQuiet() const { return quiet_; }
 
+    /// Return whether asynchronous mode is enabled.
+    /// @property
+    bool IsAsync() const { return async_; }
+
+    /// Return number of messages dropped in asynchronous mode because the queue was full.
+    /// @property
+    unsigned GetNumDroppedMessages() const;
+
     /// Write to the log. If logging level is higher than the level of the message, the message is ignored.
     /// @nobind
     static void Write(int level, const String& message);
@@ -121,6 +146,16 @@ public:
 private:
     /// Handle end of frame. Process the threaded log messages.
     void HandleEndFrame(StringHash eventType, VariantMap& eventData);
+    /// Queue a message for the asynchronous writer. Apply the drop policy if the queue is full.
+    void QueueMessage(const String& message, const String& formattedMessage, int level, bool error, bool mainThread, unsigned time);
+    /// Write a message in the main thread, timestamped with the time it was logged.
+    void WriteMessage(int level, const String& message, unsigned time);
+    /// Write a message to the standard output streams and the log file.
+    void WriteOutput(int level, const String& message, const String& formattedMessage, bool error);
+    /// Send the log message event. Called in the main thread.
+    void SendMessageEvent(const String& message, int level);
+    /// Write the messages waiting in the asynchronous queue. Return true if there were any.
+    bool WriteQueuedMessages();
 
     /// Mutex for threaded operation.
     Mutex logMutex_;
@@ -128,6 +163,14 @@ private:
     List<StoredLogMessage> threadMessages_;
     /// Log file.
     SharedPtr<File> logFile_;
+    /// Message queue for asynchronous mode.
+    UniquePtr<AsyncLogQueue> asyncQueue_;
+    /// Writer thread for asynchronous mode.
+    UniquePtr<AsyncLogWriter> asyncWriter_;
+    /// Log file flush timer for asynchronous mode.
+    Timer flushTimer_;
+    /// Number of dropped messages already reported in the log.
+    unsigned numReportedDropped_;
     /// Last log message.
     String lastMessage_;
     /// Logging level.
@@ -138,6 +181,10 @@ private:
     bool inWrite_;
     /// Quiet mode flag.
     bool quiet_;
+    /// Asynchronous mode flag.
+    std::atomic<bool> async_;
+    /// Unflushed log file writes flag for asynchronous mode.
+    bool needFlush_;
 };
 
 #ifdef URHO3D_LOGGING
@@ -47,6 +47,8 @@ public:
     unsigned Seek(unsigned position) override;
     /// Write bytes to the memory area.
     unsigned Write(const void* data, unsigned size) override;
+    /// Return the memory area for parsing without copying.
+    const unsigned char* GetMemoryData() const override { return buffer_; }
 
     /// Return memory area.
     unsigned char* GetData() { return buffer_; }
@@ -23,17 +23,37 @@
 #include "../Precompiled.h"
 
 #include "../IO/File.h"
+#include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../IO/PackageFile.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 namespace Urho3D
 {
 
+/// Maximum uncompressed block size accepted in block-indexed compressed packages.
+static const unsigned MAX_BLOCK_SIZE = 16 * 1024 * 1024;
+
+static bool IsPackageID(const String& id)
+{
+    // UPAK: uncompressed, ULZ4: LZ4 compressed with per-block headers, UPK2: LZ4 compressed with block index & dictionary
+    return id == "UPAK" || id == "ULZ4" || id == "UPK2";
+}
+
 PackageFile::PackageFile(Context* context) :
     Object(context),
     totalSize_(0),
     totalDataSize_(0),
     checksum_(0),
+    blockSize_(0),
+    mappedData_(nullptr),
     compressed_(false)
 {
 }
@@ -43,15 +63,34 @@ PackageFile::PackageFile(Context* context, const String& fileName, unsigned star
     totalSize_(0),
     totalDataSize_(0),
     checksum_(0),
+    blockSize_(0),
+    mappedData_(nullptr),
     compressed_(false)
 {
     Open(fileName, startOffset);
 }
 
-PackageFile::~PackageFile() = default;
+PackageFile::~PackageFile()
+{
+    if (mappedData_)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(mappedData_);
+#else
+        munmap(mappedData_, totalSize_);
+#endif
+    }
+}
 
 bool PackageFile::Open(const String& fileName, unsigned startOffset)
 {
+    // Files opened from the package may still be reading from the mapping
+    if (mappedData_)
+    {
+        URHO3D_LOGERROR("Can not reopen memory-mapped package file " + fileName_);
+        return false;
+    }
+
     SharedPtr<File> file(new File(context_, fileName));
     if (!file->IsOpen())
         return false;
@@ -59,7 +98,7 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
     // Check ID, then read the directory
     file->Seek(startOffset);
     String id = file->ReadFileID();
-    if (id != "UPAK" && id != "ULZ4")
+    if (!IsPackageID(id))
     {
         // If start offset has not been explicitly specified, also try to read package size from the end of file
         // to know how much we must rewind to find the package start
@@ -76,7 +115,7 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
             }
         }
 
-        if (id != "UPAK" && id != "ULZ4")
+        if (!IsPackageID(id))
         {
             URHO3D_LOGERROR(fileName + " is not a valid package file");
             return false;
@@ -86,11 +125,26 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
     fileName_ = fileName;
     nameHash_ = fileName_;
     totalSize_ = file->GetSize();
-    compressed_ = id == "ULZ4";
+    compressed_ = id != "UPAK";
+    bool blockIndexed = id == "UPK2";
 
     unsigned numFiles = file->ReadUInt();
     checksum_ = file->ReadUInt();
 
+    if (blockIndexed)
+    {
+        blockSize_ = file->ReadUInt();
+        unsigned dictionarySize = file->ReadUInt();
+        if (!blockSize_ || blockSize_ > MAX_BLOCK_SIZE || dictionarySize > totalSize_)
+        {
+            URHO3D_LOGERROR(fileName + " has invalid compression parameters");
+            return false;
+        }
+        dictionary_.Resize(dictionarySize);
+        if (dictionarySize)
+            file->Read(&dictionary_[0], dictionarySize);
+    }
+
     for (unsigned i = 0; i < numFiles; ++i)
     {
         String entryName = file->ReadString();
@@ -98,7 +152,9 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
         newEntry.offset_ = file->ReadUInt() + startOffset;
         totalDataSize_ += (newEntry.size_ = file->ReadUInt());
         newEntry.checksum_ = file->ReadUInt();
-        if (!compressed_ && newEntry.offset_ + newEntry.size_ > totalSize_)
+        if (blockIndexed)
+            newEntry.useDictionary_ = file->ReadBool();
+        if ((!compressed_ && newEntry.offset_ + newEntry.size_ > totalSize_) || (blockIndexed && newEntry.offset_ > totalSize_))
         {
             URHO3D_LOGERROR("File entry " + entryName + " outside package file");
             return false;
@@ -110,6 +166,56 @@ bool PackageFile::Open(const String& fileName, unsigned startOffset)
     return true;
 }
 
+bool PackageFile::MapToMemory()
+{
+    if (mappedData_)
+        return true;
+    if (fileName_.Empty() || !totalSize_)
+    {
+        URHO3D_LOGERROR("Package file not open, can not map to memory");
+        return false;
+    }
+
+#ifdef __ANDROID__
+    // Assets inside the APK can not be mapped, use regular file reads instead
+    if (URHO3D_IS_ASSET(fileName_))
+        return false;
+#endif
+
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileW(GetWideNativePath(fileName_).CString(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle != INVALID_HANDLE_VALUE)
+    {
+        // The view keeps the file mapping and the file open after the handles are closed
+        HANDLE mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle)
+        {
+            mappedData_ = (unsigned char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, totalSize_);
+            CloseHandle(mappingHandle);
+        }
+        CloseHandle(fileHandle);
+    }
+#else
+    int fd = open(GetNativePath(fileName_).CString(), O_RDONLY);
+    if (fd != -1)
+    {
+        void* data = mmap(nullptr, totalSize_, PROT_READ, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED)
+            mappedData_ = (unsigned char*)data;
+        close(fd);
+    }
+#endif
+
+    if (!mappedData_)
+    {
+        URHO3D_LOGERROR("Could not map package file " + fileName_ + " to memory");
+        return false;
+    }
+
+    return true;
+}
+
 bool PackageFile::Exists(const String& fileName) const
 {
     bool found = entries_.Find(fileName) != entries_.End();
@@ -36,6 +36,8 @@ struct PackageEntry
     unsigned size_;
     /// File checksum.
     unsigned checksum_;
+    /// Whether the file's blocks are compressed using the package's shared dictionary.
+    bool useDictionary_;
 };
 
 /// Stores files of a directory tree sequentially for convenient access.
@@ -53,6 +55,8 @@ public:
 
     /// Open the package file. Return true if successful.
     bool Open(const String& fileName, unsigned startOffset = 0);
+    /// Map the whole package file to memory, so that uncompressed entries can be read without file IO and parsed without copying. The mapping is held until the package file is destroyed. Return true if successful.
+    bool MapToMemory();
     /// Check if a file exists within the package file. This will be case-insensitive on Windows and case-sensitive on other platforms.
     bool Exists(const String& fileName) const;
     /// Return the file entry corresponding to the name, or null if not found. This will be case-insensitive on Windows and case-sensitive on other platforms.
@@ -88,9 +92,21 @@ public:
     /// @property
     bool IsCompressed() const { return compressed_; }
 
+    /// Return the uncompressed block size if the files are compressed in fixed size blocks preceded by a block index, or 0 if not.
+    unsigned GetBlockSize() const { return blockSize_; }
+
+    /// Return the shared dictionary used for compressing small files. Empty if not used.
+    const PODVector<unsigned char>& GetDictionary() const { return dictionary_; }
+
     /// Return list of file names in the package.
     const Vector<String> GetEntryNames() const { return entries_.Keys(); }
 
+    /// Return whether the package file is mapped to memory.
+    bool IsMemoryMapped() const { return mappedData_ != nullptr; }
+
+    /// Return the memory-mapped package file data, or null if not mapped.
+    const unsigned char* GetMappedData() const { return mappedData_; }
+
 private:
     /// File entries.
     HashMap<String, PackageEntry> entries_;
@@ -104,6 +120,12 @@ private:
     unsigned totalDataSize_;
     /// Package file checksum.
     unsigned checksum_;
+    /// Uncompressed block size of block-indexed compressed files.
+    unsigned blockSize_;
+    /// Shared compression dictionary.
+    PODVector<unsigned char> dictionary_;
+    /// Memory-mapped package file data.
+    unsigned char* mappedData_;
     /// Compressed flag.
     bool compressed_;
 };
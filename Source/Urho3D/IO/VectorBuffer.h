@@ -46,6 +46,8 @@ public:
     unsigned Seek(unsigned position) override;
     /// Write bytes to the buffer. Return number of bytes actually written.
     unsigned Write(const void* data, unsigned size) override;
+    /// Return the buffer contents for parsing without copying.
+    const unsigned char* GetMemoryData() const override { return GetData(); }
 
     /// Set data from another buffer.
     void SetData(const PODVector<unsigned char>& data);
@@ -316,6 +316,12 @@ inline float Random(float range) { return Rand() * range / 32767.0f; }
 /// Return a random float between min and max, inclusive from both ends.
 inline float Random(float min, float max) { return Rand() * (max - min) / 32767.0f + min; }
 
+/// Return a random float between 0.0 (inclusive) and 1.0 (exclusive) from a caller-owned seed.
+inline float SeededRandom(unsigned& seed) { return Rand(seed) / 32768.0f; }
+
+/// Return a random float between 0.0 and range, inclusive from both ends, from a caller-owned seed.
+inline float SeededRandom(unsigned& seed, float range) { return Rand(seed) * range / 32767.0f; }
+
 /// Return a random integer between 0 and range - 1.
 /// @alias{RandomInt}
 inline int Random(int range) { return (int)(Random() * range); }
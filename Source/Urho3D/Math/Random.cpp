@@ -43,8 +43,13 @@ unsigned GetRandomSeed()
 
 int Rand()
 {
-    randomSeed = randomSeed * 214013 + 2531011;
-    return (randomSeed >> 16u) & 32767u;
+    return Rand(randomSeed);
+}
+
+int Rand(unsigned& seed)
+{
+    seed = seed * 214013 + 2531011;
+    return (seed >> 16u) & 32767u;
 }
 
 float RandStandardNormal()
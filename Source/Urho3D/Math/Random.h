@@ -38,6 +38,8 @@ URHO3D_API unsigned GetRandomSeed();
 /// Return a random number between 0-32767. Should operate similarly to MSVC rand().
 /// @alias{RandomInt}
 URHO3D_API int Rand();
+/// Return a random number between 0-32767 from a caller-owned seed, which is advanced. Safe to call from worker threads as long as the seed is not shared.
+URHO3D_API int Rand(unsigned& seed);
 /// Return a standard normal distributed number.
 URHO3D_API float RandStandardNormal();
 
@@ -59,12 +59,6 @@ extern const char* NAVIGATION_CATEGORY;
 static const int DEFAULT_MAX_OBSTACLES = 1024;
 static const int DEFAULT_MAX_LAYERS = 16;
 
-struct DynamicNavigationMesh::TileCacheData
-{
-    unsigned char* data;
-    int dataSize;
-};
-
 struct TileCompressor : public dtTileCacheCompressor
 {
     int maxCompressedSize(const int bufferSize) override
@@ -334,210 +328,6 @@ bool DynamicNavigationMesh::Allocate(const BoundingBox& boundingBox, unsigned ma
     return true;
 }
 
-bool DynamicNavigationMesh::Build()
-{
-    URHO3D_PROFILE(BuildNavigationMesh);
-    // Release existing navigation data and zero the bounding box
-    ReleaseNavigationMesh();
-
-    if (!node_)
-        return false;
-
-    if (!node_->GetWorldScale().Equals(Vector3::ONE))
-        URHO3D_LOGWARNING("Navigation mesh root node has scaling. Agent parameters may not work as intended");
-
-    Vector<NavigationGeometryInfo> geometryList;
-    CollectGeometries(geometryList);
-
-    if (geometryList.Empty())
-        return true; // Nothing to do
-
-    // Build the combined bounding box
-    for (unsigned i = 0; i < geometryList.Size(); ++i)
-        boundingBox_.Merge(geometryList[i].boundingBox_);
-
-    // Expand bounding box by padding
-    boundingBox_.min_ -= padding_;
-    boundingBox_.max_ += padding_;
-
-    {
-        URHO3D_PROFILE(BuildNavigationMesh);
-
-        // Calculate number of tiles
-        int gridW = 0, gridH = 0;
-        float tileEdgeLength = (float)tileSize_ * cellSize_;
-        rcCalcGridSize(&boundingBox_.min_.x_, &boundingBox_.max_.x_, cellSize_, &gridW, &gridH);
-        numTilesX_ = (gridW + tileSize_ - 1) / tileSize_;
-        numTilesZ_ = (gridH + tileSize_ - 1) / tileSize_;
-
-        // Calculate max. number of tiles and polygons, 22 bits available to identify both tile & polygon within tile
-        unsigned maxTiles = NextPowerOfTwo((unsigned)(numTilesX_ * numTilesZ_)) * maxLayers_;
-        unsigned tileBits = LogBaseTwo(maxTiles);
-        unsigned maxPolys = 1u << (22 - tileBits);
-
-        dtNavMeshParams params;     // NOLINT(hicpp-member-init)
-        rcVcopy(params.orig, &boundingBox_.min_.x_);
-        params.tileWidth = tileEdgeLength;
-        params.tileHeight = tileEdgeLength;
-        params.maxTiles = maxTiles;
-        params.maxPolys = maxPolys;
-
-        navMesh_ = dtAllocNavMesh();
-        if (!navMesh_)
-        {
-            URHO3D_LOGERROR("Could not allocate navigation mesh");
-            return false;
-        }
-
-        if (dtStatusFailed(navMesh_->init(&params)))
-        {
-            URHO3D_LOGERROR("Could not initialize navigation mesh");
-            ReleaseNavigationMesh();
-            return false;
-        }
-
-        dtTileCacheParams tileCacheParams;      // NOLINT(hicpp-member-init)
-        memset(&tileCacheParams, 0, sizeof(tileCacheParams));
-        rcVcopy(tileCacheParams.orig, &boundingBox_.min_.x_);
-        tileCacheParams.ch = cellHeight_;
-        tileCacheParams.cs = cellSize_;
-        tileCacheParams.width = tileSize_;
-        tileCacheParams.height = tileSize_;
-        tileCacheParams.maxSimplificationError = edgeMaxError_;
-        tileCacheParams.maxTiles = numTilesX_ * numTilesZ_ * maxLayers_;
-        tileCacheParams.maxObstacles = maxObstacles_;
-        // Settings from NavigationMesh
-        tileCacheParams.walkableClimb = agentMaxClimb_;
-        tileCacheParams.walkableHeight = agentHeight_;
-        tileCacheParams.walkableRadius = agentRadius_;
-
-        tileCache_ = dtAllocTileCache();
-        if (!tileCache_)
-        {
-            URHO3D_LOGERROR("Could not allocate tile cache");
-            ReleaseNavigationMesh();
-            return false;
-        }
-
-        if (dtStatusFailed(tileCache_->init(&tileCacheParams, allocator_.Get(), compressor_.Get(), meshProcessor_.Get())))
-        {
-            URHO3D_LOGERROR("Could not initialize tile cache");
-            ReleaseNavigationMesh();
-            return false;
-        }
-
-        // Build each tile
-        unsigned numTiles = 0;
-
-        for (int z = 0; z < numTilesZ_; ++z)
-        {
-            for (int x = 0; x < numTilesX_; ++x)
-            {
-                TileCacheData tiles[TILECACHE_MAXLAYERS];
-                int layerCt = BuildTile(geometryList, x, z, tiles);
-                for (int i = 0; i < layerCt; ++i)
-                {
-                    dtCompressedTileRef tileRef;
-                    int status = tileCache_->addTile(tiles[i].data, tiles[i].dataSize, DT_COMPRESSEDTILE_FREE_DATA, &tileRef);
-                    if (dtStatusFailed((dtStatus)status))
-                    {
-                        dtFree(tiles[i].data);
-                        tiles[i].data = nullptr;
-                    }
-                }
-                tileCache_->buildNavMeshTilesAt(x, z, navMesh_);
-                ++numTiles;
-            }
-        }
-
-        // For a full build it's necessary to update the nav mesh
-        // not doing so will cause dependent components to crash, like CrowdManager
-        tileCache_->update(0, navMesh_);
-
-        URHO3D_LOGDEBUG("Built navigation mesh with " + String(numTiles) + " tiles");
-
-        // Send a notification event to concerned parties that we've been fully rebuilt
-        {
-            using namespace NavigationMeshRebuilt;
-            VariantMap& buildEventParams = GetContext()->GetEventDataMap();
-            buildEventParams[P_NODE] = node_;
-            buildEventParams[P_MESH] = this;
-            SendEvent(E_NAVIGATION_MESH_REBUILT, buildEventParams);
-        }
-
-        // Scan for obstacles to insert into us
-        PODVector<Node*> obstacles;
-        GetScene()->GetChildrenWithComponent<Obstacle>(obstacles, true);
-        for (unsigned i = 0; i < obstacles.Size(); ++i)
-        {
-            auto* obs = obstacles[i]->GetComponent<Obstacle>();
-            if (obs && obs->IsEnabledEffective())
-                AddObstacle(obs);
-        }
-
-        return true;
-    }
-}
-
-bool DynamicNavigationMesh::Build(const BoundingBox& boundingBox)
-{
-    URHO3D_PROFILE(BuildPartialNavigationMesh);
-
-    if (!node_)
-        return false;
-
-    if (!navMesh_)
-    {
-        URHO3D_LOGERROR("Navigation mesh must first be built fully before it can be partially rebuilt");
-        return false;
-    }
-
-    if (!node_->GetWorldScale().Equals(Vector3::ONE))
-        URHO3D_LOGWARNING("Navigation mesh root node has scaling. Agent parameters may not work as intended");
-
-    BoundingBox localSpaceBox = boundingBox.Transformed(node_->GetWorldTransform().Inverse());
-
-    float tileEdgeLength = (float)tileSize_ * cellSize_;
-
-    Vector<NavigationGeometryInfo> geometryList;
-    CollectGeometries(geometryList);
-
-    int sx = Clamp((int)((localSpaceBox.min_.x_ - boundingBox_.min_.x_) / tileEdgeLength), 0, numTilesX_ - 1);
-    int sz = Clamp((int)((localSpaceBox.min_.z_ - boundingBox_.min_.z_) / tileEdgeLength), 0, numTilesZ_ - 1);
-    int ex = Clamp((int)((localSpaceBox.max_.x_ - boundingBox_.min_.x_) / tileEdgeLength), 0, numTilesX_ - 1);
-    int ez = Clamp((int)((localSpaceBox.max_.z_ - boundingBox_.min_.z_) / tileEdgeLength), 0, numTilesZ_ - 1);
-
-    unsigned numTiles = BuildTiles(geometryList, IntVector2(sx, sz), IntVector2(ex, ez));
-
-    URHO3D_LOGDEBUG("Rebuilt " + String(numTiles) + " tiles of the navigation mesh");
-    return true;
-}
-
-bool DynamicNavigationMesh::Build(const IntVector2& from, const IntVector2& to)
-{
-    URHO3D_PROFILE(BuildPartialNavigationMesh);
-
-    if (!node_)
-        return false;
-
-    if (!navMesh_)
-    {
-        URHO3D_LOGERROR("Navigation mesh must first be built fully before it can be partially rebuilt");
-        return false;
-    }
-
-    if (!node_->GetWorldScale().Equals(Vector3::ONE))
-        URHO3D_LOGWARNING("Navigation mesh root node has scaling. Agent parameters may not work as intended");
-
-    Vector<NavigationGeometryInfo> geometryList;
-    CollectGeometries(geometryList);
-
-    unsigned numTiles = BuildTiles(geometryList, from, to);
-
-    URHO3D_LOGDEBUG("Rebuilt " + String(numTiles) + " tiles of the navigation mesh");
-    return true;
-}
-
 PODVector<unsigned char> DynamicNavigationMesh::GetTileData(const IntVector2& tile) const
 {
     VectorBuffer ret;
@@ -817,13 +607,97 @@ bool DynamicNavigationMesh::ReadTiles(Deserializer& source, bool silent)
     return true;
 }
 
-int DynamicNavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z, TileCacheData* tiles)
+bool DynamicNavigationMesh::InitializeBuild()
+{
+    // Calculate max. number of tiles and polygons, 22 bits available to identify both tile & polygon within tile
+    unsigned maxTiles = NextPowerOfTwo((unsigned)(numTilesX_ * numTilesZ_)) * maxLayers_;
+    unsigned tileBits = LogBaseTwo(maxTiles);
+    unsigned maxPolys = 1u << (22 - tileBits);
+    float tileEdgeLength = (float)tileSize_ * cellSize_;
+
+    dtNavMeshParams params;     // NOLINT(hicpp-member-init)
+    rcVcopy(params.orig, &boundingBox_.min_.x_);
+    params.tileWidth = tileEdgeLength;
+    params.tileHeight = tileEdgeLength;
+    params.maxTiles = maxTiles;
+    params.maxPolys = maxPolys;
+
+    navMesh_ = dtAllocNavMesh();
+    if (!navMesh_)
+    {
+        URHO3D_LOGERROR("Could not allocate navigation mesh");
+        return false;
+    }
+
+    if (dtStatusFailed(navMesh_->init(&params)))
+    {
+        URHO3D_LOGERROR("Could not initialize navigation mesh");
+        ReleaseNavigationMesh();
+        return false;
+    }
+
+    dtTileCacheParams tileCacheParams;      // NOLINT(hicpp-member-init)
+    memset(&tileCacheParams, 0, sizeof(tileCacheParams));
+    rcVcopy(tileCacheParams.orig, &boundingBox_.min_.x_);
+    tileCacheParams.ch = cellHeight_;
+    tileCacheParams.cs = cellSize_;
+    tileCacheParams.width = tileSize_;
+    tileCacheParams.height = tileSize_;
+    tileCacheParams.maxSimplificationError = edgeMaxError_;
+    tileCacheParams.maxTiles = numTilesX_ * numTilesZ_ * maxLayers_;
+    tileCacheParams.maxObstacles = maxObstacles_;
+    // Settings from NavigationMesh
+    tileCacheParams.walkableClimb = agentMaxClimb_;
+    tileCacheParams.walkableHeight = agentHeight_;
+    tileCacheParams.walkableRadius = agentRadius_;
+
+    tileCache_ = dtAllocTileCache();
+    if (!tileCache_)
+    {
+        URHO3D_LOGERROR("Could not allocate tile cache");
+        ReleaseNavigationMesh();
+        return false;
+    }
+
+    if (dtStatusFailed(tileCache_->init(&tileCacheParams, allocator_.Get(), compressor_.Get(), meshProcessor_.Get())))
+    {
+        URHO3D_LOGERROR("Could not initialize tile cache");
+        ReleaseNavigationMesh();
+        return false;
+    }
+
+    return true;
+}
+
+void DynamicNavigationMesh::FinishBuild(unsigned numTiles)
+{
+    // For a full build it's necessary to update the nav mesh
+    // not doing so will cause dependent components to crash, like CrowdManager
+    tileCache_->update(0, navMesh_);
+
+    NavigationMesh::FinishBuild(numTiles);
+
+    // Scan for obstacles to insert into us. The rebuilt event handlers may have removed the component from the scene
+    Scene* scene = GetScene();
+    if (!scene)
+        return;
+    PODVector<Node*> obstacles;
+    scene->GetChildrenWithComponent<Obstacle>(obstacles, true);
+    for (unsigned i = 0; i < obstacles.Size(); ++i)
+    {
+        auto* obs = obstacles[i]->GetComponent<Obstacle>();
+        if (obs && obs->IsEnabledEffective())
+            AddObstacle(obs);
+    }
+}
+
+bool DynamicNavigationMesh::BuildTileData(NavTileBuildTask& task, const NavSharedGeometry& geometry) const
 {
     URHO3D_PROFILE(BuildNavigationMeshTile);
 
-    tileCache_->removeTile(navMesh_->getTileRefAt(x, z, 0), nullptr, nullptr);
+    task.success_ = false;
 
-    const BoundingBox tileBoundingBox = GetTileBoundingBox(IntVector2(x, z));
+    const BoundingBox tileBoundingBox = GetTileBoundingBox(task.tile_);
 
     DynamicNavBuildData build(allocator_.Get());
 
@@ -855,23 +729,26 @@ int DynamicNavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryLis
     cfg.bmax[2] += cfg.borderSize * cfg.cs;
 
     BoundingBox expandedBox(*reinterpret_cast<Vector3*>(cfg.bmin), *reinterpret_cast<Vector3*>(cfg.bmax));
-    GetTileGeometry(&build, geometryList, expandedBox);
+    geometry.GetTileGeometry(&build, expandedBox);
 
     if (build.vertices_.Empty() || build.indices_.Empty())
-        return 0; // Nothing to do
+    {
+        task.success_ = true;
+        return true; // Nothing to do
+    }
 
     build.heightField_ = rcAllocHeightfield();
     if (!build.heightField_)
     {
         URHO3D_LOGERROR("Could not allocate heightfield");
-        return 0;
+        return false;
     }
 
     if (!rcCreateHeightfield(build.ctx_, *build.heightField_, cfg.width, cfg.height, cfg.bmin, cfg.bmax, cfg.cs,
         cfg.ch))
     {
         URHO3D_LOGERROR("Could not create heightfield");
-        return 0;
+        return false;
     }
 
     unsigned numTriangles = build.indices_.Size() / 3;
@@ -891,18 +768,18 @@ int DynamicNavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryLis
     if (!build.compactHeightField_)
     {
         URHO3D_LOGERROR("Could not allocate create compact heightfield");
-        return 0;
+        return false;
     }
     if (!rcBuildCompactHeightfield(build.ctx_, cfg.walkableHeight, cfg.walkableClimb, *build.heightField_,
         *build.compactHeightField_))
     {
         URHO3D_LOGERROR("Could not build compact heightfield");
-        return 0;
+        return false;
     }
     if (!rcErodeWalkableArea(build.ctx_, cfg.walkableRadius, *build.compactHeightField_))
     {
         URHO3D_LOGERROR("Could not erode compact heightfield");
-        return 0;
+        return false;
     }
 
     // area volumes
@@ -915,13 +792,13 @@ int DynamicNavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryLis
         if (!rcBuildDistanceField(build.ctx_, *build.compactHeightField_))
         {
             URHO3D_LOGERROR("Could not build distance field");
-            return 0;
+            return false;
         }
         if (!rcBuildRegions(build.ctx_, *build.compactHeightField_, cfg.borderSize, cfg.minRegionArea,
             cfg.mergeRegionArea))
         {
             URHO3D_LOGERROR("Could not build regions");
-            return 0;
+            return false;
         }
     }
     else
@@ -929,7 +806,7 @@ int DynamicNavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryLis
         if (!rcBuildRegionsMonotone(build.ctx_, *build.compactHeightField_, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea))
         {
             URHO3D_LOGERROR("Could not build monotone regions");
-            return 0;
+            return false;
         }
     }
 
@@ -937,24 +814,23 @@ int DynamicNavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryLis
     if (!build.heightFieldLayers_)
     {
         URHO3D_LOGERROR("Could not allocate height field layer set");
-        return 0;
+        return false;
     }
 
     if (!rcBuildHeightfieldLayers(build.ctx_, *build.compactHeightField_, cfg.borderSize, cfg.walkableHeight,
         *build.heightFieldLayers_))
     {
         URHO3D_LOGERROR("Could not build height field layers");
-        return 0;
+        return false;
     }
 
-    int retCt = 0;
     for (int i = 0; i < build.heightFieldLayers_->nlayers; ++i)
     {
         dtTileCacheLayerHeader header;      // NOLINT(hicpp-member-init)
         header.magic = DT_TILECACHE_MAGIC;
         header.version = DT_TILECACHE_VERSION;
-        header.tx = x;
-        header.ty = z;
+        header.tx = task.tile_.x_;
+        header.ty = task.tile_.y_;
         header.tlayer = i;
 
         rcHeightfieldLayer* layer = &build.heightFieldLayers_->layers[i];
@@ -971,19 +847,61 @@ int DynamicNavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryLis
         header.hmin = (unsigned short)layer->hmin;
         header.hmax = (unsigned short)layer->hmax;
 
+        NavTileData tileData;
         if (dtStatusFailed(
             dtBuildTileCacheLayer(compressor_.Get()/*compressor*/, &header, layer->heights, layer->areas/*areas*/, layer->cons,
-                &(tiles[retCt].data), &tiles[retCt].dataSize)))
+                &tileData.data_, &tileData.dataSize_)))
         {
             URHO3D_LOGERROR("Failed to build tile cache layers");
-            return 0;
+            task.FreeData();
+            return false;
         }
         else
-            ++retCt;
+            task.data_.Push(tileData);
+    }
+
+    task.success_ = true;
+    return true;
+}
+
+
+bool DynamicNavigationMesh::AddTileData(NavTileBuildTask& task)
+{
+    const int x = task.tile_.x_;
+    const int z = task.tile_.y_;
+
+    dtCompressedTileRef existing[TILECACHE_MAXLAYERS];
+    const int existingCt = tileCache_->getTilesAt(x, z, existing, maxLayers_);
+    for (int i = 0; i < existingCt; ++i)
+    {
+        unsigned char* data = nullptr;
+        if (!dtStatusFailed(tileCache_->removeTile(existing[i], &data, nullptr)) && data != nullptr)
+            dtFree(data);
+    }
+
+    if (!task.success_)
+    {
+        task.FreeData();
+        return false;
     }
 
+    for (unsigned i = 0; i < task.data_.Size(); ++i)
+    {
+        dtCompressedTileRef tileRef;
+        int status = tileCache_->addTile(task.data_[i].data_, task.data_[i].dataSize_, DT_COMPRESSEDTILE_FREE_DATA, &tileRef);
+        if (dtStatusFailed((dtStatus)status))
+            dtFree(task.data_[i].data_);
+    }
+    bool hasLayers = !task.data_.Empty();
+    task.data_.Clear();
+
+    tileCache_->buildNavMeshTilesAt(x, z, navMesh_);
+
     // Send a notification of the rebuild of this tile to anyone interested
+    if (hasLayers)
     {
+        const BoundingBox tileBoundingBox = GetTileBoundingBox(task.tile_);
+
         using namespace NavigationAreaRebuilt;
         VariantMap& eventData = GetContext()->GetEventDataMap();
         eventData[P_NODE] = GetNode();
@@ -993,47 +911,7 @@ int DynamicNavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryLis
         SendEvent(E_NAVIGATION_AREA_REBUILT, eventData);
     }
 
-    return retCt;
-}
-
-unsigned DynamicNavigationMesh::BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to)
-{
-    unsigned numTiles = 0;
-
-    for (int z = from.y_; z <= to.y_; ++z)
-    {
-        for (int x = from.x_; x <= to.x_; ++x)
-        {
-            dtCompressedTileRef existing[TILECACHE_MAXLAYERS];
-            const int existingCt = tileCache_->getTilesAt(x, z, existing, maxLayers_);
-            for (int i = 0; i < existingCt; ++i)
-            {
-                unsigned char* data = nullptr;
-                if (!dtStatusFailed(tileCache_->removeTile(existing[i], &data, nullptr)) && data != nullptr)
-                    dtFree(data);
-            }
-
-            TileCacheData tiles[TILECACHE_MAXLAYERS];
-            int layerCt = BuildTile(geometryList, x, z, tiles);
-            for (int i = 0; i < layerCt; ++i)
-            {
-                dtCompressedTileRef tileRef;
-                int status = tileCache_->addTile(tiles[i].data, tiles[i].dataSize, DT_COMPRESSEDTILE_FREE_DATA, &tileRef);
-                if (dtStatusFailed((dtStatus)status))
-                {
-                    dtFree(tiles[i].data);
-                    tiles[i].data = nullptr;
-                }
-                else
-                {
-                    tileCache_->buildNavMeshTile(tileRef, navMesh_);
-                    ++numTiles;
-                }
-            }
-        }
-    }
-
-    return numTiles;
+    return true;
 }
 
 PODVector<OffMeshConnection*> DynamicNavigationMesh::CollectOffMeshConnections(const BoundingBox& bounds)
@@ -1068,6 +946,8 @@ void DynamicNavigationMesh::ReleaseTileCache()
 
 void DynamicNavigationMesh::OnSceneSet(Scene* scene)
 {
+    NavigationMesh::OnSceneSet(scene);
+
     // Subscribe to the scene subsystem update, which will trigger the tile cache to update the nav mesh
     if (scene)
         SubscribeToEvent(scene, E_SCENESUBSYSTEMUPDATE, URHO3D_HANDLER(DynamicNavigationMesh, HandleSceneSubsystemUpdate));
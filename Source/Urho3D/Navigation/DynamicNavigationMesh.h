@@ -56,12 +56,6 @@ public:
 
     /// Allocate the navigation mesh without building any tiles. Bounding box is not padded. Return true if successful.
     bool Allocate(const BoundingBox& boundingBox, unsigned maxTiles) override;
-    /// Build/rebuild the entire navigation mesh.
-    bool Build() override;
-    /// Build/rebuild a portion of the navigation mesh.
-    bool Build(const BoundingBox& boundingBox) override;
-    /// Rebuild part of the navigation mesh in the rectangular area. Return true if successful.
-    bool Build(const IntVector2& from, const IntVector2& to) override;
     /// Return tile data.
     PODVector<unsigned char> GetTileData(const IntVector2& tile) const override;
     /// Return whether the Obstacle is touching the given tile.
@@ -105,8 +99,6 @@ public:
     bool GetDrawObstacles() const { return drawObstacles_; }
 
 protected:
-    struct TileCacheData;
-
     /// Subscribe to events when assigned to a scene.
     void OnSceneSet(Scene* scene) override;
     /// Trigger the tile cache to make updates to the nav mesh if necessary.
@@ -119,10 +111,14 @@ protected:
     /// Used by Obstacle class to remove itself from the tile cache, if 'silent' an event will not be raised.
     void RemoveObstacle(Obstacle*, bool silent = false);
 
-    /// Build one tile of the navigation mesh. Return true if successful.
-    int BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z, TileCacheData* tiles);
-    /// Build tiles in the rectangular area. Return number of built tiles.
-    unsigned BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to);
+    /// Allocate the navigation mesh and the tile cache for a full build. Return true if successful.
+    bool InitializeBuild() override;
+    /// Finish a full build, update the navigation mesh from the tile cache and insert the obstacles.
+    void FinishBuild(unsigned numTiles) override;
+    /// Run the Recast build of the tile cache layers of one tile. Called from worker threads. Return true if successful.
+    bool BuildTileData(NavTileBuildTask& task, const NavSharedGeometry& geometry) const override;
+    /// Add the built layers of a tile to the tile cache, replacing the previous ones. Return true if successful.
+    bool AddTileData(NavTileBuildTask& task) override;
     /// Off-mesh connections to be rebuilt in the mesh processor.
     PODVector<OffMeshConnection*> CollectOffMeshConnections(const BoundingBox& bounds);
     /// Release the navigation mesh, query, and tile cache.
@@ -24,6 +24,7 @@
 
 #include "../Navigation/NavBuildData.h"
 
+#include <Detour/DetourAlloc.h>
 #include <DetourTileCache/DetourTileCacheBuilder.h>
 #include <Recast/Recast.h>
 
@@ -47,6 +48,43 @@ NavBuildData::~NavBuildData()
     compactHeightField_ = nullptr;
 }
 
+void NavSharedGeometry::GetTileGeometry(NavBuildData* build, const BoundingBox& box) const
+{
+    for (unsigned i = 0; i < ranges_.Size(); ++i)
+    {
+        const NavGeometryRange& range = ranges_[i];
+        if (box.IsInsideFast(range.boundingBox_) == OUTSIDE)
+            continue;
+
+        unsigned destVertexStart = build->vertices_.Size();
+        for (unsigned j = range.vertexStart_; j < range.vertexStart_ + range.vertexCount_; ++j)
+            build->vertices_.Push(data_.vertices_[j]);
+        // Remap the indices to the tile's own vertex array
+        for (unsigned j = range.indexStart_; j < range.indexStart_ + range.indexCount_; ++j)
+            build->indices_.Push(data_.indices_[j] - range.vertexStart_ + destVertexStart);
+
+        for (unsigned j = range.offMeshStart_; j < range.offMeshStart_ + range.offMeshCount_; ++j)
+        {
+            build->offMeshVertices_.Push(data_.offMeshVertices_[j * 2]);
+            build->offMeshVertices_.Push(data_.offMeshVertices_[j * 2 + 1]);
+            build->offMeshRadii_.Push(data_.offMeshRadii_[j]);
+            build->offMeshFlags_.Push(data_.offMeshFlags_[j]);
+            build->offMeshAreas_.Push(data_.offMeshAreas_[j]);
+            build->offMeshDir_.Push(data_.offMeshDir_[j]);
+        }
+
+        for (unsigned j = range.navAreaStart_; j < range.navAreaStart_ + range.navAreaCount_; ++j)
+            build->navAreas_.Push(data_.navAreas_[j]);
+    }
+}
+
+void NavTileBuildTask::FreeData()
+{
+    for (unsigned i = 0; i < data_.Size(); ++i)
+        dtFree(data_[i].data_);
+    data_.Clear();
+}
+
 SimpleNavBuildData::SimpleNavBuildData() :
     NavBuildData(),
     contourSet_(nullptr),
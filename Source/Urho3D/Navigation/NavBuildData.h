@@ -24,6 +24,7 @@
 
 #include "../Container/Vector.h"
 #include "../Math/BoundingBox.h"
+#include "../Math/Vector2.h"
 #include "../Math/Vector3.h"
 
 class rcContext;
@@ -99,6 +100,64 @@ struct SimpleNavBuildData : public NavBuildData
     rcPolyMeshDetail* polyMeshDetail_;
 };
 
+/// Range of the geometry extracted from one navigation geometry component.
+struct URHO3D_API NavGeometryRange
+{
+    /// Bounding box relative to the navigation mesh root node.
+    BoundingBox boundingBox_;
+    /// First vertex.
+    unsigned vertexStart_;
+    /// Vertex count.
+    unsigned vertexCount_;
+    /// First index.
+    unsigned indexStart_;
+    /// Index count.
+    unsigned indexCount_;
+    /// First offmesh connection.
+    unsigned offMeshStart_;
+    /// Offmesh connection count.
+    unsigned offMeshCount_;
+    /// First navigation area.
+    unsigned navAreaStart_;
+    /// Navigation area count.
+    unsigned navAreaCount_;
+};
+
+/// Navigation geometry extracted once on the main thread and shared read-only by the tile builds.
+struct URHO3D_API NavSharedGeometry
+{
+    /// Copy the geometry intersecting a bounding box to the build data of a tile.
+    void GetTileGeometry(NavBuildData* build, const BoundingBox& box) const;
+
+    /// Extracted geometry of all components. Indices refer to the whole vertex array.
+    NavBuildData data_;
+    /// Ranges of the extracted geometry per component.
+    PODVector<NavGeometryRange> ranges_;
+};
+
+/// Built data of one navigation mesh tile or tile cache layer, allocated with dtAlloc.
+struct URHO3D_API NavTileData
+{
+    /// Data pointer.
+    unsigned char* data_;
+    /// Data size in bytes.
+    int dataSize_;
+};
+
+/// Build task of one navigation mesh tile. The Recast build runs in a worker thread and the result is added to the navigation mesh in the main thread.
+struct URHO3D_API NavTileBuildTask
+{
+    /// Free built data that was not added to the navigation mesh.
+    void FreeData();
+
+    /// Tile index.
+    IntVector2 tile_;
+    /// Built tile data. Empty if the tile had no geometry.
+    PODVector<NavTileData> data_;
+    /// Whether the build succeeded.
+    bool success_;
+};
+
 /// @nobind
 struct DynamicNavBuildData : public NavBuildData
 {
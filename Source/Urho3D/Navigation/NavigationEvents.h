@@ -43,6 +43,25 @@ URHO3D_EVENT(E_NAVIGATION_AREA_REBUILT, NavigationAreaRebuilt)
     URHO3D_PARAM(P_BOUNDSMAX, BoundsMax); // Vector3
 }
 
+/// Asynchronous navigation mesh build has added a tile.
+URHO3D_EVENT(E_NAVIGATION_BUILD_PROGRESS, NavigationBuildProgress)
+{
+    URHO3D_PARAM(P_NODE, Node); // Node pointer
+    URHO3D_PARAM(P_MESH, Mesh); // NavigationMesh pointer
+    URHO3D_PARAM(P_TILE, Tile); // IntVector2
+    URHO3D_PARAM(P_NUMCOMPLETED, NumCompleted); // unsigned
+    URHO3D_PARAM(P_NUMTILES, NumTiles); // unsigned
+}
+
+/// Queued path query has completed without a callback.
+URHO3D_EVENT(E_NAVIGATION_PATH_QUERY_COMPLETED, NavigationPathQueryCompleted)
+{
+    URHO3D_PARAM(P_NODE, Node); // Node pointer
+    URHO3D_PARAM(P_MESH, Mesh); // NavigationMesh pointer
+    URHO3D_PARAM(P_ID, ID); // unsigned
+    URHO3D_PARAM(P_PATH, Path); // VariantVector of world-space Vector3 path points, empty if no path was found
+}
+
 /// Mesh tile is added to navigation mesh.
 URHO3D_EVENT(E_NAVIGATION_TILE_ADDED, NavigationTileAdded)
 {
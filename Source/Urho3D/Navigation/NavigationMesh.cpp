@@ -23,7 +23,11 @@
 #include "../Precompiled.h"
 
 #include "../Core/Context.h"
+#include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
+#include "../Core/Timer.h"
+#include "../Core/Variant.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Drawable.h"
 #include "../Graphics/Geometry.h"
@@ -46,6 +50,7 @@
 #include "../Physics/CollisionShape.h"
 #endif
 #include "../Scene/Scene.h"
+#include "../Scene/SceneEvents.h"
 
 #include <cfloat>
 #include <Detour/DetourNavMesh.h>
@@ -82,6 +87,9 @@ static const float DEFAULT_DETAIL_SAMPLE_DISTANCE = 6.0f;
 static const float DEFAULT_DETAIL_SAMPLE_MAX_ERROR = 1.0f;
 
 static const int MAX_POLYS = 2048;
+static const unsigned DEFAULT_PATH_QUERY_ITERATIONS = 4096;
+static const unsigned DEFAULT_MAX_ACTIVE_PATH_QUERIES = 16;
+static const unsigned PATH_QUERY_GRAIN_SIZE = 4;
 
 
 /// Temporary data for finding a path.
@@ -97,12 +105,154 @@ struct FindPathData
     unsigned char pathFlags_[MAX_POLYS]{};
 };
 
+/// Queued path query.
+struct NavPathRequest
+{
+    /// Query ID.
+    unsigned id_;
+    /// World-space start point.
+    Vector3 start_;
+    /// World-space end point.
+    Vector3 end_;
+    /// How far off the navigation mesh the points can be.
+    Vector3 extents_;
+    /// Query filter, or null to use the default filter.
+    const dtQueryFilter* filter_;
+    /// Result callback.
+    NavigationPathCallback callback_;
+};
+
+/// Query objects for one thread or one queued path query in progress.
+struct NavPathQuerySlot
+{
+    /// Detour navigation mesh query. Holds the sliced path search state.
+    dtNavMeshQuery* query_{};
+    /// Temporary data for finding a path.
+    FindPathData* data_{};
+    /// Queued path query being processed.
+    NavPathRequest request_;
+    /// Local-space start point.
+    Vector3 localStart_;
+    /// Local-space end point.
+    Vector3 localEnd_;
+    /// End polygon.
+    dtPolyRef endRef_{};
+    /// Search iterations spent during the last update.
+    unsigned iterations_{};
+    /// Whether a queued path query is assigned.
+    bool active_{};
+    /// Whether the sliced path search has been initialized.
+    bool started_{};
+    /// Whether the path search has finished.
+    bool done_{};
+    /// Found path.
+    PODVector<NavigationPathPoint> path_;
+};
+
+/// Batched and queued path queries of a navigation mesh.
+struct NavPathQueryService
+{
+    /// Destruct. Free the query objects.
+    ~NavPathQueryService()
+    {
+        ReleaseQueries();
+        for (unsigned i = 0; i < threadSlots_.Size(); ++i)
+            delete threadSlots_[i].data_;
+        for (unsigned i = 0; i < slots_.Size(); ++i)
+            delete slots_[i].data_;
+    }
+
+    /// Free the Detour query objects, which refer to the navigation mesh.
+    void ReleaseQueries()
+    {
+        for (unsigned i = 0; i < threadSlots_.Size(); ++i)
+        {
+            dtFreeNavMeshQuery(threadSlots_[i].query_);
+            threadSlots_[i].query_ = nullptr;
+        }
+        for (unsigned i = 0; i < slots_.Size(); ++i)
+        {
+            dtFreeNavMeshQuery(slots_[i].query_);
+            slots_[i].query_ = nullptr;
+        }
+    }
+
+    /// Query objects per thread for batched queries.
+    Vector<NavPathQuerySlot> threadSlots_;
+    /// Query objects for queued queries in progress.
+    Vector<NavPathQuerySlot> slots_;
+    /// Queued queries waiting for a free slot.
+    List<NavPathRequest> pending_;
+    /// Next query ID.
+    unsigned nextID_{1};
+    /// Statistics of the last frame.
+    NavigationPathQueryStats stats_;
+};
+
+static bool InitializeQuerySlot(NavPathQuerySlot& slot, const dtNavMesh* navMesh)
+{
+    if (!slot.data_)
+        slot.data_ = new FindPathData();
+    if (slot.query_)
+        return true;
+
+    slot.query_ = dtAllocNavMeshQuery();
+    if (!slot.query_)
+    {
+        URHO3D_LOGERROR("Could not create navigation mesh query");
+        return false;
+    }
+
+    if (dtStatusFailed(slot.query_->init(navMesh, MAX_POLYS)))
+    {
+        URHO3D_LOGERROR("Could not init navigation mesh query");
+        dtFreeNavMeshQuery(slot.query_);
+        slot.query_ = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+/// State of an asynchronous navigation mesh build.
+struct NavAsyncBuild
+{
+    /// Destruct. Free the data of tiles that were not added.
+    ~NavAsyncBuild()
+    {
+        for (unsigned i = 0; i < tasks_.Size(); ++i)
+            tasks_[i].FreeData();
+    }
+
+    /// Geometry shared by the tile builds.
+    NavSharedGeometry geometry_;
+    /// Tile build tasks.
+    Vector<NavTileBuildTask> tasks_;
+    /// Work items of the tile builds, reset once signaled as the work queue then reuses them.
+    Vector<SharedPtr<WorkItem> > workItems_;
+    /// Number of tiles completed so far.
+    unsigned numCompleted_{};
+    /// Number of tiles built successfully so far.
+    unsigned numBuilt_{};
+
+    /// Work function for building one tile.
+    static void BuildTileWork(const WorkItem* item, unsigned /*threadIndex*/)
+    {
+        auto* mesh = reinterpret_cast<const NavigationMesh*>(item->aux_);
+        auto* build = reinterpret_cast<const NavAsyncBuild*>(item->end_);
+        auto* task = reinterpret_cast<NavTileBuildTask*>(item->start_);
+        mesh->BuildTileData(*task, build->geometry_);
+    }
+};
+
+
 NavigationMesh::NavigationMesh(Context* context) :
     Component(context),
     navMesh_(nullptr),
     navMeshQuery_(nullptr),
     queryFilter_(new dtQueryFilter()),
     pathData_(new FindPathData()),
+    pathQueries_(new NavPathQueryService()),
     tileSize_(DEFAULT_TILE_SIZE),
     cellSize_(DEFAULT_CELL_SIZE),
     cellHeight_(DEFAULT_CELL_HEIGHT),
@@ -117,6 +267,8 @@ NavigationMesh::NavigationMesh(Context* context) :
     detailSampleDistance_(DEFAULT_DETAIL_SAMPLE_DISTANCE),
     detailSampleMaxError_(DEFAULT_DETAIL_SAMPLE_MAX_ERROR),
     padding_(Vector3::ONE),
+    pathQueryIterations_(DEFAULT_PATH_QUERY_ITERATIONS),
+    maxActivePathQueries_(DEFAULT_MAX_ACTIVE_PATH_QUERIES),
     numTilesX_(0),
     numTilesZ_(0),
     partitionType_(NAVMESH_PARTITION_WATERSHED),
@@ -385,81 +537,100 @@ bool NavigationMesh::Build()
 {
     URHO3D_PROFILE(BuildNavigationMesh);
 
-    // Release existing navigation data and zero the bounding box
-    ReleaseNavigationMesh();
+    Vector<NavigationGeometryInfo> geometryList;
+    if (!PrepareBuild(geometryList))
+        return false;
 
-    if (!node_)
+    if (geometryList.Empty())
+        return true; // Nothing to do
+
+    if (!InitializeBuild())
         return false;
 
-    if (!node_->GetWorldScale().Equals(Vector3::ONE))
-        URHO3D_LOGWARNING("Navigation mesh root node has scaling. Agent parameters may not work as intended");
+    // Build each tile
+    unsigned numTiles = BuildTiles(geometryList, IntVector2::ZERO, GetNumTiles() - IntVector2::ONE);
+    FinishBuild(numTiles);
+    return true;
+}
+
+bool NavigationMesh::BuildAsync()
+{
+    URHO3D_PROFILE(BuildNavigationMeshAsync);
 
     Vector<NavigationGeometryInfo> geometryList;
-    CollectGeometries(geometryList);
+    if (!PrepareBuild(geometryList))
+        return false;
 
     if (geometryList.Empty())
         return true; // Nothing to do
 
-    // Build the combined bounding box
-    for (unsigned i = 0; i < geometryList.Size(); ++i)
-        boundingBox_.Merge(geometryList[i].boundingBox_);
+    if (!InitializeBuild())
+        return false;
 
-    // Expand bounding box by padding
-    boundingBox_.min_ -= padding_;
-    boundingBox_.max_ += padding_;
+    asyncBuild_ = new NavAsyncBuild();
+    ExtractGeometries(asyncBuild_->geometry_, geometryList, boundingBox_);
 
+    asyncBuild_->tasks_.Resize((unsigned)(numTilesX_ * numTilesZ_));
+    for (int z = 0; z < numTilesZ_; ++z)
     {
-        URHO3D_PROFILE(BuildNavigationMesh);
+        for (int x = 0; x < numTilesX_; ++x)
+        {
+            NavTileBuildTask& task = asyncBuild_->tasks_[z * numTilesX_ + x];
+            task.tile_ = IntVector2(x, z);
+            task.success_ = false;
+        }
+    }
 
-        // Calculate number of tiles
-        int gridW = 0, gridH = 0;
-        float tileEdgeLength = (float)tileSize_ * cellSize_;
-        rcCalcGridSize(&boundingBox_.min_.x_, &boundingBox_.max_.x_, cellSize_, &gridW, &gridH);
-        numTilesX_ = (gridW + tileSize_ - 1) / tileSize_;
-        numTilesZ_ = (gridH + tileSize_ - 1) / tileSize_;
+    // Queue the tiles with the lowest priority so that they do not hold up the frame's own work. Completed tiles
+    // are signaled at the start of the next frame
+    auto* queue = GetSubsystem<WorkQueue>();
+    SubscribeToEvent(queue, E_WORKITEMCOMPLETED, URHO3D_HANDLER(NavigationMesh, HandleWorkItemCompleted));
+    for (unsigned i = 0; i < asyncBuild_->tasks_.Size(); ++i)
+    {
+        SharedPtr<WorkItem> item = queue->GetFreeItem();
+        item->priority_ = 0;
+        item->workFunction_ = NavAsyncBuild::BuildTileWork;
+        item->aux_ = this;
+        item->start_ = &asyncBuild_->tasks_[i];
+        item->end_ = asyncBuild_.Get();
+        item->sendEvent_ = true;
+        asyncBuild_->workItems_.Push(item);
+        queue->AddWorkItem(item);
+    }
 
-        // Calculate max. number of tiles and polygons, 22 bits available to identify both tile & polygon within tile
-        unsigned maxTiles = NextPowerOfTwo((unsigned)(numTilesX_ * numTilesZ_));
-        unsigned tileBits = LogBaseTwo(maxTiles);
-        unsigned maxPolys = 1u << (22 - tileBits);
+    return true;
+}
 
-        dtNavMeshParams params;     // NOLINT(hicpp-member-init)
-        rcVcopy(params.orig, &boundingBox_.min_.x_);
-        params.tileWidth = tileEdgeLength;
-        params.tileHeight = tileEdgeLength;
-        params.maxTiles = maxTiles;
-        params.maxPolys = maxPolys;
+void NavigationMesh::CancelBuild()
+{
+    if (!asyncBuild_)
+        return;
 
-        navMesh_ = dtAllocNavMesh();
-        if (!navMesh_)
-        {
-            URHO3D_LOGERROR("Could not allocate navigation mesh");
-            return false;
-        }
+    UnsubscribeFromEvent(E_WORKITEMCOMPLETED);
 
-        if (dtStatusFailed(navMesh_->init(&params)))
+    // Tiles which are already being built refer to the shared geometry, so wait for them to finish
+    auto* queue = GetSubsystem<WorkQueue>();
+    for (unsigned i = 0; i < asyncBuild_->workItems_.Size(); ++i)
+    {
+        WorkItem* item = asyncBuild_->workItems_[i];
+        if (item && !queue->RemoveWorkItem(asyncBuild_->workItems_[i]))
         {
-            URHO3D_LOGERROR("Could not initialize navigation mesh");
-            ReleaseNavigationMesh();
-            return false;
+            while (!item->completed_)
+                Time::Sleep(0);
+            // Do not signal the stale item to a possible next build
+            item->sendEvent_ = false;
         }
+    }
 
-        // Build each tile
-        unsigned numTiles = BuildTiles(geometryList, IntVector2::ZERO, GetNumTiles() - IntVector2::ONE);
-
-        URHO3D_LOGDEBUG("Built navigation mesh with " + String(numTiles) + " tiles");
+    asyncBuild_.Reset();
+}
 
-        // Send a notification event to concerned parties that we've been fully rebuilt
-        {
-            using namespace NavigationMeshRebuilt;
-            VariantMap& buildEventParams = GetContext()->GetEventDataMap();
-            buildEventParams[P_NODE] = node_;
-            buildEventParams[P_MESH] = this;
-            SendEvent(E_NAVIGATION_MESH_REBUILT, buildEventParams);
-        }
+float NavigationMesh::GetBuildProgress() const
+{
+    if (!asyncBuild_ || asyncBuild_->tasks_.Empty())
+        return 1.0f;
 
-        return true;
-    }
+    return (float)asyncBuild_->numCompleted_ / (float)asyncBuild_->tasks_.Size();
 }
 
 bool NavigationMesh::Build(const BoundingBox& boundingBox)
@@ -670,71 +841,114 @@ void NavigationMesh::FindPath(PODVector<NavigationPathPoint>& dest, const Vector
     if (!InitializeQuery())
         return;
 
-    // Navigation data is in local space. Transform path points from world to local
-    const Matrix3x4& transform = node_->GetWorldTransform();
-    Matrix3x4 inverse = transform.Inverse();
+    FindPath(dest, navMeshQuery_, pathData_.Get(), start, end, extents, filter);
+    AssignPathAreas(dest);
+}
 
-    Vector3 localStart = inverse * start;
-    Vector3 localEnd = inverse * end;
+void NavigationMesh::FindPaths(Vector<NavigationPathQuery>& queries)
+{
+    URHO3D_PROFILE(FindPaths);
 
-    const dtQueryFilter* queryFilter = filter ? filter : queryFilter_.Get();
-    dtPolyRef startRef;
-    dtPolyRef endRef;
-    navMeshQuery_->findNearestPoly(&localStart.x_, &extents.x_, queryFilter, &startRef, nullptr);
-    navMeshQuery_->findNearestPoly(&localEnd.x_, &extents.x_, queryFilter, &endRef, nullptr);
+    for (unsigned i = 0; i < queries.Size(); ++i)
+        queries[i].path_.Clear();
 
-    if (!startRef || !endRef)
+    if (queries.Empty() || !InitializeQuery())
         return;
 
-    int numPolys = 0;
-    int numPathPoints = 0;
-
-    navMeshQuery_->findPath(startRef, endRef, &localStart.x_, &localEnd.x_, queryFilter, pathData_->polys_, &numPolys,
-        MAX_POLYS);
-    if (!numPolys)
-        return;
+    auto* queue = GetSubsystem<WorkQueue>();
+    Vector<NavPathQuerySlot>& slots = pathQueries_->threadSlots_;
+    if (slots.Size() < queue->GetNumThreads() + 1)
+        slots.Resize(queue->GetNumThreads() + 1);
+    for (unsigned i = 0; i < slots.Size(); ++i)
+    {
+        if (!InitializeQuerySlot(slots[i], navMesh_))
+            return;
+    }
 
-    Vector3 actualLocalEnd = localEnd;
+    // Make sure the world transform is up to date before the worker threads read it
+    node_->GetWorldTransform();
 
-    // If full path was not found, clamp end point to the end polygon
-    if (pathData_->polys_[numPolys - 1] != endRef)
-        navMeshQuery_->closestPointOnPoly(pathData_->polys_[numPolys - 1], &localEnd.x_, &actualLocalEnd.x_, nullptr);
+    queue->ParallelFor(0, queries.Size(), PATH_QUERY_GRAIN_SIZE, [this, &queries, &slots](unsigned begin, unsigned end, unsigned threadIndex)
+    {
+        NavPathQuerySlot& slot = slots[threadIndex];
+        for (unsigned i = begin; i < end; ++i)
+        {
+            NavigationPathQuery& query = queries[i];
+            FindPath(query.path_, slot.query_, slot.data_, query.start_, query.end_, query.extents_, query.filter_);
+        }
+    });
 
-    navMeshQuery_->findStraightPath(&localStart.x_, &actualLocalEnd.x_, pathData_->polys_, numPolys,
-        &pathData_->pathPoints_[0].x_, pathData_->pathFlags_, pathData_->pathPolys_, &numPathPoints, MAX_POLYS);
+    for (unsigned i = 0; i < queries.Size(); ++i)
+        AssignPathAreas(queries[i].path_);
+}
 
-    // Transform path result back to world space
-    for (int i = 0; i < numPathPoints; ++i)
+unsigned NavigationMesh::QueuePathQuery(const Vector3& start, const Vector3& end, const Vector3& extents,
+    const NavigationPathCallback& callback, const dtQueryFilter* filter)
+{
+    Scene* scene = GetScene();
+    if (!scene)
     {
-        NavigationPathPoint pt;
-        pt.position_ = transform * pathData_->pathPoints_[i];
-        pt.flag_ = (NavigationPathPointFlag)pathData_->pathFlags_[i];
+        URHO3D_LOGERROR("Navigation mesh must be in a scene to queue path queries");
+        return 0;
+    }
 
-        // Walk through all NavAreas and find nearest
-        unsigned nearestNavAreaID = 0;       // 0 is the default nav area ID
-        float nearestDistance = M_LARGE_VALUE;
-        for (unsigned j = 0; j < areas_.Size(); j++)
+    NavPathQueryService& service = *pathQueries_;
+
+    NavPathRequest request;
+    request.id_ = service.nextID_++;
+    if (!service.nextID_)
+        service.nextID_ = 1;
+    request.start_ = start;
+    request.end_ = end;
+    request.extents_ = extents;
+    request.filter_ = filter;
+    request.callback_ = callback;
+    service.pending_.Push(request);
+
+    SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(NavigationMesh, HandlePathQueryUpdate));
+    return request.id_;
+}
+
+bool NavigationMesh::CancelPathQuery(unsigned id)
+{
+    NavPathQueryService& service = *pathQueries_;
+
+    for (List<NavPathRequest>::Iterator i = service.pending_.Begin(); i != service.pending_.End(); ++i)
+    {
+        if (i->id_ == id)
         {
-            NavArea* area = areas_[j].Get();
-            if (area && area->IsEnabledEffective())
-            {
-                BoundingBox bb = area->GetWorldBoundingBox();
-                if (bb.IsInside(pt.position_) == INSIDE)
-                {
-                    Vector3 areaWorldCenter = area->GetNode()->GetWorldPosition();
-                    float distance = (areaWorldCenter - pt.position_).LengthSquared();
-                    if (distance < nearestDistance)
-                    {
-                        nearestDistance = distance;
-                        nearestNavAreaID = area->GetAreaID();
-                    }
-                }
-            }
+            service.pending_.Erase(i);
+            return true;
         }
-        pt.areaID_ = (unsigned char)nearestNavAreaID;
+    }
 
-        dest.Push(pt);
+    for (unsigned i = 0; i < service.slots_.Size(); ++i)
+    {
+        NavPathQuerySlot& slot = service.slots_[i];
+        if (slot.active_ && slot.request_.id_ == id)
+        {
+            slot.active_ = false;
+            slot.request_.callback_ = nullptr;
+            return true;
+        }
     }
+
+    return false;
+}
+
+void NavigationMesh::SetPathQueryIterations(unsigned iterations)
+{
+    pathQueryIterations_ = Max(iterations, 1U);
+}
+
+void NavigationMesh::SetMaxActivePathQueries(unsigned num)
+{
+    maxActivePathQueries_ = Max(num, 1U);
+}
+
+const NavigationPathQueryStats& NavigationMesh::GetPathQueryStats() const
+{
+    return pathQueries_->stats_;
 }
 
 Vector3 NavigationMesh::GetRandomPoint(const dtQueryFilter* filter, dtPolyRef* randomRef)
@@ -1089,108 +1303,141 @@ void NavigationMesh::GetTileGeometry(NavBuildData* build, Vector<NavigationGeome
     for (unsigned i = 0; i < geometryList.Size(); ++i)
     {
         if (box.IsInsideFast(geometryList[i].boundingBox_) != OUTSIDE)
-        {
-            const Matrix3x4& transform = geometryList[i].transform_;
+            AddGeometry(build, geometryList[i], inverse);
+    }
+}
 
-            if (geometryList[i].component_->GetType() == OffMeshConnection::GetTypeStatic())
-            {
-                auto* connection = static_cast<OffMeshConnection*>(geometryList[i].component_);
-                Vector3 start = inverse * connection->GetNode()->GetWorldPosition();
-                Vector3 end = inverse * connection->GetEndPoint()->GetWorldPosition();
-
-                build->offMeshVertices_.Push(start);
-                build->offMeshVertices_.Push(end);
-                build->offMeshRadii_.Push(connection->GetRadius());
-                build->offMeshFlags_.Push((unsigned short)connection->GetMask());
-                build->offMeshAreas_.Push((unsigned char)connection->GetAreaID());
-                build->offMeshDir_.Push((unsigned char)(connection->IsBidirectional() ? DT_OFFMESH_CON_BIDIR : 0));
-                continue;
-            }
-            else if (geometryList[i].component_->GetType() == NavArea::GetTypeStatic())
-            {
-                auto* area = static_cast<NavArea*>(geometryList[i].component_);
-                NavAreaStub stub;
-                stub.areaID_ = (unsigned char)area->GetAreaID();
-                stub.bounds_ = area->GetWorldBoundingBox();
-                build->navAreas_.Push(stub);
-                continue;
-            }
+void NavigationMesh::ExtractGeometries(NavSharedGeometry& dest, const Vector<NavigationGeometryInfo>& geometryList,
+    const BoundingBox& box)
+{
+    URHO3D_PROFILE(ExtractNavigationGeometry);
 
-#ifdef URHO3D_PHYSICS
-            auto* shape = dynamic_cast<CollisionShape*>(geometryList[i].component_);
-            if (shape)
-            {
-                switch (shape->GetShapeType())
-                {
-                case SHAPE_TRIANGLEMESH:
-                    {
-                        Model* model = shape->GetModel();
-                        if (!model)
-                            continue;
+    Matrix3x4 inverse = node_->GetWorldTransform().Inverse();
+    NavBuildData& data = dest.data_;
 
-                        unsigned lodLevel = shape->GetLodLevel();
-                        for (unsigned j = 0; j < model->GetNumGeometries(); ++j)
-                            AddTriMeshGeometry(build, model->GetGeometry(j, lodLevel), transform);
-                    }
-                    break;
+    for (unsigned i = 0; i < geometryList.Size(); ++i)
+    {
+        if (box.IsInsideFast(geometryList[i].boundingBox_) == OUTSIDE)
+            continue;
 
-                case SHAPE_CONVEXHULL:
-                    {
-                        auto* data = static_cast<ConvexData*>(shape->GetGeometryData());
-                        if (!data)
-                            continue;
+        NavGeometryRange range;
+        range.boundingBox_ = geometryList[i].boundingBox_;
+        range.vertexStart_ = data.vertices_.Size();
+        range.indexStart_ = data.indices_.Size();
+        range.offMeshStart_ = data.offMeshRadii_.Size();
+        range.navAreaStart_ = data.navAreas_.Size();
 
-                        unsigned numVertices = data->vertexCount_;
-                        unsigned numIndices = data->indexCount_;
-                        unsigned destVertexStart = build->vertices_.Size();
+        AddGeometry(&data, geometryList[i], inverse);
 
-                        for (unsigned j = 0; j < numVertices; ++j)
-                            build->vertices_.Push(transform * data->vertexData_[j]);
+        range.vertexCount_ = data.vertices_.Size() - range.vertexStart_;
+        range.indexCount_ = data.indices_.Size() - range.indexStart_;
+        range.offMeshCount_ = data.offMeshRadii_.Size() - range.offMeshStart_;
+        range.navAreaCount_ = data.navAreas_.Size() - range.navAreaStart_;
+        dest.ranges_.Push(range);
+    }
+}
 
-                        for (unsigned j = 0; j < numIndices; ++j)
-                            build->indices_.Push(data->indexData_[j] + destVertexStart);
-                    }
-                    break;
+void NavigationMesh::AddGeometry(NavBuildData* build, const NavigationGeometryInfo& info, const Matrix3x4& inverse)
+{
+    const Matrix3x4& transform = info.transform_;
 
-                case SHAPE_BOX:
-                    {
-                        unsigned destVertexStart = build->vertices_.Size();
-
-                        build->vertices_.Push(transform * Vector3(-0.5f, 0.5f, -0.5f));
-                        build->vertices_.Push(transform * Vector3(0.5f, 0.5f, -0.5f));
-                        build->vertices_.Push(transform * Vector3(0.5f, -0.5f, -0.5f));
-                        build->vertices_.Push(transform * Vector3(-0.5f, -0.5f, -0.5f));
-                        build->vertices_.Push(transform * Vector3(-0.5f, 0.5f, 0.5f));
-                        build->vertices_.Push(transform * Vector3(0.5f, 0.5f, 0.5f));
-                        build->vertices_.Push(transform * Vector3(0.5f, -0.5f, 0.5f));
-                        build->vertices_.Push(transform * Vector3(-0.5f, -0.5f, 0.5f));
-
-                        const unsigned indices[] = {
-                            0, 1, 2, 0, 2, 3, 1, 5, 6, 1, 6, 2, 4, 5, 1, 4, 1, 0, 5, 4, 7, 5, 7, 6,
-                            4, 0, 3, 4, 3, 7, 1, 0, 4, 1, 4, 5
-                        };
-
-                        for (unsigned index : indices)
-                            build->indices_.Push(index + destVertexStart);
-                    }
-                    break;
+    if (info.component_->GetType() == OffMeshConnection::GetTypeStatic())
+    {
+        auto* connection = static_cast<OffMeshConnection*>(info.component_);
+        Vector3 start = inverse * connection->GetNode()->GetWorldPosition();
+        Vector3 end = inverse * connection->GetEndPoint()->GetWorldPosition();
+
+        build->offMeshVertices_.Push(start);
+        build->offMeshVertices_.Push(end);
+        build->offMeshRadii_.Push(connection->GetRadius());
+        build->offMeshFlags_.Push((unsigned short)connection->GetMask());
+        build->offMeshAreas_.Push((unsigned char)connection->GetAreaID());
+        build->offMeshDir_.Push((unsigned char)(connection->IsBidirectional() ? DT_OFFMESH_CON_BIDIR : 0));
+        return;
+    }
+    else if (info.component_->GetType() == NavArea::GetTypeStatic())
+    {
+        auto* area = static_cast<NavArea*>(info.component_);
+        NavAreaStub stub;
+        stub.areaID_ = (unsigned char)area->GetAreaID();
+        stub.bounds_ = area->GetWorldBoundingBox();
+        build->navAreas_.Push(stub);
+        return;
+    }
 
-                default:
-                    break;
-                }
+#ifdef URHO3D_PHYSICS
+    auto* shape = dynamic_cast<CollisionShape*>(info.component_);
+    if (shape)
+    {
+        switch (shape->GetShapeType())
+        {
+        case SHAPE_TRIANGLEMESH:
+            {
+                Model* model = shape->GetModel();
+                if (!model)
+                    return;
 
-                continue;
+                unsigned lodLevel = shape->GetLodLevel();
+                for (unsigned j = 0; j < model->GetNumGeometries(); ++j)
+                    AddTriMeshGeometry(build, model->GetGeometry(j, lodLevel), transform);
             }
-#endif
-            auto* drawable = dynamic_cast<Drawable*>(geometryList[i].component_);
-            if (drawable)
+            break;
+
+        case SHAPE_CONVEXHULL:
             {
-                const Vector<SourceBatch>& batches = drawable->GetBatches();
+                auto* data = static_cast<ConvexData*>(shape->GetGeometryData());
+                if (!data)
+                    return;
+
+                unsigned numVertices = data->vertexCount_;
+                unsigned numIndices = data->indexCount_;
+                unsigned destVertexStart = build->vertices_.Size();
 
-                for (unsigned j = 0; j < batches.Size(); ++j)
-                    AddTriMeshGeometry(build, drawable->GetLodGeometry(j, geometryList[i].lodLevel_), transform);
+                for (unsigned j = 0; j < numVertices; ++j)
+                    build->vertices_.Push(transform * data->vertexData_[j]);
+
+                for (unsigned j = 0; j < numIndices; ++j)
+                    build->indices_.Push(data->indexData_[j] + destVertexStart);
             }
+            break;
+
+        case SHAPE_BOX:
+            {
+                unsigned destVertexStart = build->vertices_.Size();
+
+                build->vertices_.Push(transform * Vector3(-0.5f, 0.5f, -0.5f));
+                build->vertices_.Push(transform * Vector3(0.5f, 0.5f, -0.5f));
+                build->vertices_.Push(transform * Vector3(0.5f, -0.5f, -0.5f));
+                build->vertices_.Push(transform * Vector3(-0.5f, -0.5f, -0.5f));
+                build->vertices_.Push(transform * Vector3(-0.5f, 0.5f, 0.5f));
+                build->vertices_.Push(transform * Vector3(0.5f, 0.5f, 0.5f));
+                build->vertices_.Push(transform * Vector3(0.5f, -0.5f, 0.5f));
+                build->vertices_.Push(transform * Vector3(-0.5f, -0.5f, 0.5f));
+
+                const unsigned indices[] = {
+                    0, 1, 2, 0, 2, 3, 1, 5, 6, 1, 6, 2, 4, 5, 1, 4, 1, 0, 5, 4, 7, 5, 7, 6,
+                    4, 0, 3, 4, 3, 7, 1, 0, 4, 1, 4, 5
+                };
+
+                for (unsigned index : indices)
+                    build->indices_.Push(index + destVertexStart);
+            }
+            break;
+
+        default:
+            break;
         }
+
+        return;
+    }
+#endif
+    auto* drawable = dynamic_cast<Drawable*>(info.component_);
+    if (drawable)
+    {
+        const Vector<SourceBatch>& batches = drawable->GetBatches();
+
+        for (unsigned j = 0; j < batches.Size(); ++j)
+            AddTriMeshGeometry(build, drawable->GetLodGeometry(j, info.lodLevel_), transform);
     }
 }
 
@@ -1299,14 +1546,13 @@ bool NavigationMesh::ReadTile(Deserializer& source, bool silent)
     return true;
 }
 
-bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z)
+bool NavigationMesh::BuildTileData(NavTileBuildTask& task, const NavSharedGeometry& geometry) const
 {
     URHO3D_PROFILE(BuildNavigationMeshTile);
 
-    // Remove previous tile (if any)
-    navMesh_->removeTile(navMesh_->getTileRefAt(x, z, 0), nullptr, nullptr);
+    task.success_ = false;
 
-    const BoundingBox tileBoundingBox = GetTileBoundingBox(IntVector2(x, z));
+    const BoundingBox tileBoundingBox = GetTileBoundingBox(task.tile_);
 
     SimpleNavBuildData build;
 
@@ -1338,10 +1584,13 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
     cfg.bmax[2] += cfg.borderSize * cfg.cs;
 
     BoundingBox expandedBox(*reinterpret_cast<Vector3*>(cfg.bmin), *reinterpret_cast<Vector3*>(cfg.bmax));
-    GetTileGeometry(&build, geometryList, expandedBox);
+    geometry.GetTileGeometry(&build, expandedBox);
 
     if (build.vertices_.Empty() || build.indices_.Empty())
+    {
+        task.success_ = true;
         return true; // Nothing to do
+    }
 
     build.heightField_ = rcAllocHeightfield();
     if (!build.heightField_)
@@ -1482,8 +1731,8 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
     params.walkableHeight = agentHeight_;
     params.walkableRadius = agentRadius_;
     params.walkableClimb = agentMaxClimb_;
-    params.tileX = x;
-    params.tileY = z;
+    params.tileX = task.tile_.x_;
+    params.tileY = task.tile_.y_;
     rcVcopy(params.bmin, build.polyMesh_->bmin);
     rcVcopy(params.bmax, build.polyMesh_->bmax);
     params.cs = cfg.cs;
@@ -1507,15 +1756,41 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
         return false;
     }
 
-    if (dtStatusFailed(navMesh_->addTile(navData, navDataSize, DT_TILE_FREE_DATA, 0, nullptr)))
+    NavTileData tileData;
+    tileData.data_ = navData;
+    tileData.dataSize_ = navDataSize;
+    task.data_.Push(tileData);
+    task.success_ = true;
+    return true;
+}
+
+
+bool NavigationMesh::AddTileData(NavTileBuildTask& task)
+{
+    // Remove previous tile (if any)
+    navMesh_->removeTile(navMesh_->getTileRefAt(task.tile_.x_, task.tile_.y_, 0), nullptr, nullptr);
+
+    if (!task.success_)
+    {
+        task.FreeData();
+        return false;
+    }
+    if (task.data_.Empty())
+        return true;
+
+    NavTileData tileData = task.data_[0];
+    task.data_.Clear();
+    if (dtStatusFailed(navMesh_->addTile(tileData.data_, tileData.dataSize_, DT_TILE_FREE_DATA, 0, nullptr)))
     {
         URHO3D_LOGERROR("Failed to add navigation mesh tile");
-        dtFree(navData);
+        dtFree(tileData.data_);
         return false;
     }
 
     // Send a notification of the rebuild of this tile to anyone interested
     {
+        const BoundingBox tileBoundingBox = GetTileBoundingBox(task.tile_);
+
         using namespace NavigationAreaRebuilt;
         VariantMap& eventData = GetContext()->GetEventDataMap();
         eventData[P_NODE] = GetNode();
@@ -1529,19 +1804,120 @@ bool NavigationMesh::BuildTile(Vector<NavigationGeometryInfo>& geometryList, int
 
 unsigned NavigationMesh::BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to)
 {
-    unsigned numTiles = 0;
+    if (to.x_ < from.x_ || to.y_ < from.y_)
+        return 0;
+
+    // Extract the geometry once, including the border that the tiles are padded with
+    BoundingBox box(GetTileBoundingBox(from).min_, GetTileBoundingBox(to).max_);
+    Vector3 border(agentRadius_ + 4.0f * cellSize_, 0.0f, agentRadius_ + 4.0f * cellSize_);
+    box.min_ -= border;
+    box.max_ += border;
+
+    NavSharedGeometry geometry;
+    ExtractGeometries(geometry, geometryList, box);
+
+    int numTilesX = to.x_ - from.x_ + 1;
+    Vector<NavTileBuildTask> tasks((unsigned)(numTilesX * (to.y_ - from.y_ + 1)));
+    for (unsigned i = 0; i < tasks.Size(); ++i)
+        tasks[i].tile_ = IntVector2(from.x_ + (int)i % numTilesX, from.y_ + (int)i / numTilesX);
 
-    for (int z = from.y_; z <= to.y_; ++z)
     {
-        for (int x = from.x_; x <= to.x_; ++x)
+        URHO3D_PROFILE(BuildNavigationMeshTiles);
+
+        GetSubsystem<WorkQueue>()->ParallelFor(0, tasks.Size(), 1, [this, &tasks, &geometry](unsigned begin, unsigned end, unsigned /*threadIndex*/)
         {
-            if (BuildTile(geometryList, x, z))
-                ++numTiles;
-        }
+            for (unsigned i = begin; i < end; ++i)
+                BuildTileData(tasks[i], geometry);
+        });
+    }
+
+    unsigned numTiles = 0;
+    for (unsigned i = 0; i < tasks.Size(); ++i)
+    {
+        if (AddTileData(tasks[i]))
+            ++numTiles;
     }
+
     return numTiles;
 }
 
+bool NavigationMesh::PrepareBuild(Vector<NavigationGeometryInfo>& geometryList)
+{
+    // Release existing navigation data and zero the bounding box
+    ReleaseNavigationMesh();
+
+    if (!node_)
+        return false;
+
+    if (!node_->GetWorldScale().Equals(Vector3::ONE))
+        URHO3D_LOGWARNING("Navigation mesh root node has scaling. Agent parameters may not work as intended");
+
+    CollectGeometries(geometryList);
+
+    if (geometryList.Empty())
+        return true;
+
+    // Build the combined bounding box
+    for (unsigned i = 0; i < geometryList.Size(); ++i)
+        boundingBox_.Merge(geometryList[i].boundingBox_);
+
+    // Expand bounding box by padding
+    boundingBox_.min_ -= padding_;
+    boundingBox_.max_ += padding_;
+
+    // Calculate number of tiles
+    int gridW = 0, gridH = 0;
+    rcCalcGridSize(&boundingBox_.min_.x_, &boundingBox_.max_.x_, cellSize_, &gridW, &gridH);
+    numTilesX_ = (gridW + tileSize_ - 1) / tileSize_;
+    numTilesZ_ = (gridH + tileSize_ - 1) / tileSize_;
+
+    return true;
+}
+
+bool NavigationMesh::InitializeBuild()
+{
+    // Calculate max. number of tiles and polygons, 22 bits available to identify both tile & polygon within tile
+    unsigned maxTiles = NextPowerOfTwo((unsigned)(numTilesX_ * numTilesZ_));
+    unsigned tileBits = LogBaseTwo(maxTiles);
+    unsigned maxPolys = 1u << (22 - tileBits);
+    float tileEdgeLength = (float)tileSize_ * cellSize_;
+
+    dtNavMeshParams params;     // NOLINT(hicpp-member-init)
+    rcVcopy(params.orig, &boundingBox_.min_.x_);
+    params.tileWidth = tileEdgeLength;
+    params.tileHeight = tileEdgeLength;
+    params.maxTiles = maxTiles;
+    params.maxPolys = maxPolys;
+
+    navMesh_ = dtAllocNavMesh();
+    if (!navMesh_)
+    {
+        URHO3D_LOGERROR("Could not allocate navigation mesh");
+        return false;
+    }
+
+    if (dtStatusFailed(navMesh_->init(&params)))
+    {
+        URHO3D_LOGERROR("Could not initialize navigation mesh");
+        ReleaseNavigationMesh();
+        return false;
+    }
+
+    return true;
+}
+
+void NavigationMesh::FinishBuild(unsigned numTiles)
+{
+    URHO3D_LOGDEBUG("Built navigation mesh with " + String(numTiles) + " tiles");
+
+    // Send a notification event to concerned parties that we've been fully rebuilt
+    using namespace NavigationMeshRebuilt;
+    VariantMap& buildEventParams = GetContext()->GetEventDataMap();
+    buildEventParams[P_NODE] = node_;
+    buildEventParams[P_MESH] = this;
+    SendEvent(E_NAVIGATION_MESH_REBUILT, buildEventParams);
+}
+
 bool NavigationMesh::InitializeQuery()
 {
     if (!navMesh_ || !node_)
@@ -1568,6 +1944,9 @@ bool NavigationMesh::InitializeQuery()
 
 void NavigationMesh::ReleaseNavigationMesh()
 {
+    CancelBuild();
+    ReleasePathQueries();
+
     dtFreeNavMesh(navMesh_);
     navMesh_ = nullptr;
 
@@ -1579,6 +1958,336 @@ void NavigationMesh::ReleaseNavigationMesh()
     boundingBox_.Clear();
 }
 
+void NavigationMesh::OnNodeSet(Node* node)
+{
+    // The tile builds read the node's geometry, and the path queries use its transform
+    if (!node)
+    {
+        CancelBuild();
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+        ReleasePathQueries();
+    }
+}
+
+void NavigationMesh::OnSceneSet(Scene* scene)
+{
+    // Keep the queued path queries waiting until back in a scene
+    if (scene)
+    {
+        if (!pathQueries_->pending_.Empty())
+            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(NavigationMesh, HandlePathQueryUpdate));
+    }
+    else
+    {
+        CancelBuild();
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+        ReleasePathQueries();
+    }
+}
+
+void NavigationMesh::HandleWorkItemCompleted(StringHash eventType, VariantMap& eventData)
+{
+    using namespace WorkItemCompleted;
+
+    auto* item = static_cast<WorkItem*>(eventData[P_ITEM].GetPtr());
+    if (!asyncBuild_ || item->aux_ != this || item->end_ != asyncBuild_.Get())
+        return;
+
+    NavTileBuildTask& task = *reinterpret_cast<NavTileBuildTask*>(item->start_);
+    asyncBuild_->workItems_[(unsigned)(&task - &asyncBuild_->tasks_[0])].Reset();
+    if (AddTileData(task))
+        ++asyncBuild_->numBuilt_;
+    ++asyncBuild_->numCompleted_;
+
+    {
+        using namespace NavigationBuildProgress;
+        VariantMap& progressEventData = GetContext()->GetEventDataMap();
+        progressEventData[P_NODE] = node_;
+        progressEventData[P_MESH] = this;
+        progressEventData[P_TILE] = task.tile_;
+        progressEventData[P_NUMCOMPLETED] = asyncBuild_->numCompleted_;
+        progressEventData[P_NUMTILES] = asyncBuild_->tasks_.Size();
+        SendEvent(E_NAVIGATION_BUILD_PROGRESS, progressEventData);
+    }
+
+    // The build may have been cancelled or restarted in response to the progress event
+    if (!asyncBuild_ || item->end_ != asyncBuild_.Get() || asyncBuild_->numCompleted_ < asyncBuild_->tasks_.Size())
+        return;
+
+    unsigned numTiles = asyncBuild_->numBuilt_;
+    UnsubscribeFromEvent(E_WORKITEMCOMPLETED);
+    asyncBuild_.Reset();
+    FinishBuild(numTiles);
+}
+
+void NavigationMesh::HandlePathQueryUpdate(StringHash eventType, VariantMap& eventData)
+{
+    // The queries are in the node's local space
+    if (!node_)
+        return;
+
+    URHO3D_PROFILE(UpdatePathQueries);
+
+    HiresTimer timer;
+    NavPathQueryService& service = *pathQueries_;
+    Vector<NavPathQuerySlot>& slots = service.slots_;
+    NavigationPathQueryStats& stats = service.stats_;
+    stats = NavigationPathQueryStats();
+
+    // Start pending queries in the free slots. If the navigation mesh is not built, keep them waiting
+    if (InitializeQuery())
+    {
+        if (slots.Size() < maxActivePathQueries_)
+            slots.Resize(maxActivePathQueries_);
+        for (unsigned i = 0; i < maxActivePathQueries_ && !service.pending_.Empty(); ++i)
+        {
+            NavPathQuerySlot& slot = slots[i];
+            if (slot.active_)
+                continue;
+            if (!InitializeQuerySlot(slot, navMesh_))
+                break;
+
+            slot.request_ = service.pending_.Front();
+            service.pending_.PopFront();
+            slot.active_ = true;
+            slot.started_ = false;
+            slot.done_ = false;
+        }
+    }
+
+    unsigned numActive = 0;
+    for (unsigned i = 0; i < slots.Size(); ++i)
+    {
+        if (slots[i].active_)
+            ++numActive;
+    }
+
+    stats.numPending_ = service.pending_.Size();
+    if (!numActive)
+    {
+        if (service.pending_.Empty())
+            UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+        stats.time_ = timer.GetUSec(false);
+        return;
+    }
+
+    // Split the iteration budget evenly between the queries in progress
+    unsigned maxIterations = Max(pathQueryIterations_ / numActive, 1U);
+
+    // Make sure the world transform is up to date before the worker threads read it
+    node_->GetWorldTransform();
+
+    GetSubsystem<WorkQueue>()->ParallelFor(0, slots.Size(), 1, [this, &slots, maxIterations](unsigned begin, unsigned end, unsigned /*threadIndex*/)
+    {
+        for (unsigned i = begin; i < end; ++i)
+        {
+            if (slots[i].active_)
+                UpdatePathQuery(slots[i], maxIterations);
+        }
+    });
+
+    // Collect the completed queries before delivering them, as the callbacks may queue or cancel queries
+    Vector<NavPathRequest> completedRequests;
+    Vector<PODVector<NavigationPathPoint> > completedPaths;
+    for (unsigned i = 0; i < slots.Size(); ++i)
+    {
+        NavPathQuerySlot& slot = slots[i];
+        if (!slot.active_)
+            continue;
+
+        stats.numIterations_ += slot.iterations_;
+        if (slot.done_)
+        {
+            completedRequests.Push(slot.request_);
+            completedPaths.Push(PODVector<NavigationPathPoint>());
+            completedPaths.Back().Swap(slot.path_);
+            slot.request_.callback_ = nullptr;
+            slot.active_ = false;
+        }
+        else
+            ++stats.numActive_;
+    }
+
+    stats.numCompleted_ = completedRequests.Size();
+    stats.time_ = timer.GetUSec(false);
+
+    WeakPtr<NavigationMesh> self(this);
+    for (unsigned i = 0; i < completedRequests.Size(); ++i)
+    {
+        const NavPathRequest& request = completedRequests[i];
+        PODVector<NavigationPathPoint>& path = completedPaths[i];
+        AssignPathAreas(path);
+
+        if (request.callback_)
+            request.callback_(request.id_, path);
+        else
+        {
+            VariantVector points(path.Size());
+            for (unsigned j = 0; j < path.Size(); ++j)
+                points[j] = path[j].position_;
+
+            using namespace NavigationPathQueryCompleted;
+            VariantMap& completedEventData = GetContext()->GetEventDataMap();
+            completedEventData[P_NODE] = node_;
+            completedEventData[P_MESH] = this;
+            completedEventData[P_ID] = request.id_;
+            completedEventData[P_PATH] = points;
+            SendEvent(E_NAVIGATION_PATH_QUERY_COMPLETED, completedEventData);
+        }
+
+        // The navigation mesh may have been destroyed in response
+        if (self.Expired())
+            return;
+    }
+}
+
+void NavigationMesh::FindPath(PODVector<NavigationPathPoint>& dest, dtNavMeshQuery* query, FindPathData* data,
+    const Vector3& start, const Vector3& end, const Vector3& extents, const dtQueryFilter* filter) const
+{
+    dest.Clear();
+
+    // Navigation data is in local space. Transform path points from world to local
+    Matrix3x4 inverse = node_->GetWorldTransform().Inverse();
+
+    Vector3 localStart = inverse * start;
+    Vector3 localEnd = inverse * end;
+
+    const dtQueryFilter* queryFilter = filter ? filter : queryFilter_.Get();
+    dtPolyRef startRef;
+    dtPolyRef endRef;
+    query->findNearestPoly(&localStart.x_, &extents.x_, queryFilter, &startRef, nullptr);
+    query->findNearestPoly(&localEnd.x_, &extents.x_, queryFilter, &endRef, nullptr);
+
+    if (!startRef || !endRef)
+        return;
+
+    int numPolys = 0;
+
+    query->findPath(startRef, endRef, &localStart.x_, &localEnd.x_, queryFilter, data->polys_, &numPolys, MAX_POLYS);
+    if (!numPolys)
+        return;
+
+    GetStraightPath(dest, query, data, localStart, localEnd, endRef, numPolys);
+}
+
+void NavigationMesh::GetStraightPath(PODVector<NavigationPathPoint>& dest, dtNavMeshQuery* query, FindPathData* data,
+    const Vector3& localStart, const Vector3& localEnd, dtPolyRef endRef, int numPolys) const
+{
+    int numPathPoints = 0;
+    Vector3 actualLocalEnd = localEnd;
+
+    // If full path was not found, clamp end point to the end polygon
+    if (data->polys_[numPolys - 1] != endRef)
+        query->closestPointOnPoly(data->polys_[numPolys - 1], &localEnd.x_, &actualLocalEnd.x_, nullptr);
+
+    query->findStraightPath(&localStart.x_, &actualLocalEnd.x_, data->polys_, numPolys, &data->pathPoints_[0].x_,
+        data->pathFlags_, data->pathPolys_, &numPathPoints, MAX_POLYS);
+
+    // Transform path result back to world space
+    const Matrix3x4& transform = node_->GetWorldTransform();
+    dest.Resize((unsigned)numPathPoints);
+    for (int i = 0; i < numPathPoints; ++i)
+    {
+        NavigationPathPoint& pt = dest[i];
+        pt.position_ = transform * data->pathPoints_[i];
+        pt.flag_ = (NavigationPathPointFlag)data->pathFlags_[i];
+        pt.areaID_ = 0;
+    }
+}
+
+void NavigationMesh::UpdatePathQuery(NavPathQuerySlot& slot, unsigned maxIterations) const
+{
+    slot.iterations_ = 0;
+
+    if (!slot.started_)
+    {
+        slot.started_ = true;
+        slot.path_.Clear();
+
+        Matrix3x4 inverse = node_->GetWorldTransform().Inverse();
+        slot.localStart_ = inverse * slot.request_.start_;
+        slot.localEnd_ = inverse * slot.request_.end_;
+
+        const dtQueryFilter* queryFilter = slot.request_.filter_ ? slot.request_.filter_ : queryFilter_.Get();
+        const Vector3& extents = slot.request_.extents_;
+        dtPolyRef startRef;
+        slot.query_->findNearestPoly(&slot.localStart_.x_, &extents.x_, queryFilter, &startRef, nullptr);
+        slot.query_->findNearestPoly(&slot.localEnd_.x_, &extents.x_, queryFilter, &slot.endRef_, nullptr);
+
+        if (!startRef || !slot.endRef_ || dtStatusFailed(slot.query_->initSlicedFindPath(startRef, slot.endRef_,
+            &slot.localStart_.x_, &slot.localEnd_.x_, queryFilter)))
+        {
+            slot.done_ = true;
+            return;
+        }
+    }
+
+    int doneIterations = 0;
+    dtStatus status = slot.query_->updateSlicedFindPath((int)maxIterations, &doneIterations);
+    slot.iterations_ = (unsigned)doneIterations;
+    if (dtStatusInProgress(status))
+        return;
+
+    slot.done_ = true;
+    if (dtStatusFailed(status))
+        return;
+
+    int numPolys = 0;
+    slot.query_->finalizeSlicedFindPath(slot.data_->polys_, &numPolys, MAX_POLYS);
+    if (numPolys)
+        GetStraightPath(slot.path_, slot.query_, slot.data_, slot.localStart_, slot.localEnd_, slot.endRef_, numPolys);
+}
+
+void NavigationMesh::AssignPathAreas(PODVector<NavigationPathPoint>& path) const
+{
+    for (unsigned i = 0; i < path.Size(); ++i)
+    {
+        NavigationPathPoint& pt = path[i];
+
+        // Walk through all NavAreas and find nearest
+        unsigned nearestNavAreaID = 0;       // 0 is the default nav area ID
+        float nearestDistance = M_LARGE_VALUE;
+        for (unsigned j = 0; j < areas_.Size(); j++)
+        {
+            NavArea* area = areas_[j].Get();
+            if (area && area->IsEnabledEffective())
+            {
+                BoundingBox bb = area->GetWorldBoundingBox();
+                if (bb.IsInside(pt.position_) == INSIDE)
+                {
+                    Vector3 areaWorldCenter = area->GetNode()->GetWorldPosition();
+                    float distance = (areaWorldCenter - pt.position_).LengthSquared();
+                    if (distance < nearestDistance)
+                    {
+                        nearestDistance = distance;
+                        nearestNavAreaID = area->GetAreaID();
+                    }
+                }
+            }
+        }
+        pt.areaID_ = (unsigned char)nearestNavAreaID;
+    }
+}
+
+void NavigationMesh::ReleasePathQueries()
+{
+    NavPathQueryService& service = *pathQueries_;
+
+    // Restart the queued queries in progress once there is a navigation mesh again
+    for (unsigned i = service.slots_.Size() - 1; i < service.slots_.Size(); --i)
+    {
+        NavPathQuerySlot& slot = service.slots_[i];
+        if (slot.active_)
+        {
+            service.pending_.Insert(service.pending_.Begin(), slot.request_);
+            slot.request_.callback_ = nullptr;
+            slot.active_ = false;
+        }
+    }
+
+    service.ReleaseQueries();
+}
+
 void NavigationMesh::SetPartitionType(NavmeshPartitionType partitionType)
 {
     partitionType_ = partitionType;
@@ -53,7 +53,12 @@ class Geometry;
 class NavArea;
 
 struct FindPathData;
+struct NavAsyncBuild;
+struct NavPathQueryService;
+struct NavPathQuerySlot;
 struct NavBuildData;
+struct NavSharedGeometry;
+struct NavTileBuildTask;
 
 /// Description of a navigation mesh geometry component, with transform and bounds information.
 struct NavigationGeometryInfo
@@ -88,12 +93,46 @@ struct URHO3D_API NavigationPathPoint
     unsigned char areaID_;
 };
 
+/// Callback of a queued path query. Called on the main thread with the query ID and the found path, which is empty if no path was found.
+using NavigationPathCallback = std::function<void(unsigned, const PODVector<NavigationPathPoint>&)>;
+
+/// Path query of a batch.
+struct URHO3D_API NavigationPathQuery
+{
+    /// World-space start point.
+    Vector3 start_;
+    /// World-space end point.
+    Vector3 end_;
+    /// How far off the navigation mesh the points can be.
+    Vector3 extents_{Vector3::ONE};
+    /// Query filter, or null to use the default filter.
+    const dtQueryFilter* filter_{};
+    /// Found path. Empty if no path was found.
+    PODVector<NavigationPathPoint> path_;
+};
+
+/// Statistics of the queued path queries during the last frame.
+struct URHO3D_API NavigationPathQueryStats
+{
+    /// Number of queries waiting for a free query slot.
+    unsigned numPending_{};
+    /// Number of queries in progress.
+    unsigned numActive_{};
+    /// Number of queries completed.
+    unsigned numCompleted_{};
+    /// Number of path search iterations spent.
+    unsigned numIterations_{};
+    /// Time spent in microseconds.
+    long long time_{};
+};
+
 /// Navigation mesh component. Collects the navigation geometry from child nodes with the Navigable component and responds to path queries.
 class URHO3D_API NavigationMesh : public Component
 {
     URHO3D_OBJECT(NavigationMesh, Component);
 
     friend class CrowdManager;
+    friend struct NavAsyncBuild;
 
 public:
     /// Construct.
@@ -158,6 +197,10 @@ public:
     virtual bool Build(const BoundingBox& boundingBox);
     /// Rebuild part of the navigation mesh in the rectangular area. Return true if successful.
     virtual bool Build(const IntVector2& from, const IntVector2& to);
+    /// Start rebuilding the navigation mesh in the worker threads. Built tiles are added on the main thread at the start of the following frames, each sending E_NAVIGATION_BUILD_PROGRESS, and E_NAVIGATION_MESH_REBUILT is sent once all tiles are done. The build parameters must not be changed until then. Return true if the build was started.
+    bool BuildAsync();
+    /// Cancel an asynchronous build in progress. Tiles already added remain in the navigation mesh.
+    void CancelBuild();
     /// Return tile data.
     virtual PODVector<unsigned char> GetTileData(const IntVector2& tile) const;
     /// Add tile to navigation mesh.
@@ -199,6 +242,19 @@ public:
     Vector3 Raycast
         (const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE, const dtQueryFilter* filter = nullptr,
             Vector3* hitNormal = nullptr);
+    /// Find paths for a batch of queries in parallel in the worker threads. Return once all paths have been found.
+    void FindPaths(Vector<NavigationPathQuery>& queries);
+    /// Queue a path query which is resolved over the following frames within the per-frame iteration budget. The result is delivered to the callback, or if none given, with the E_NAVIGATION_PATH_QUERY_COMPLETED event. A custom filter must stay valid until then. Return the query ID, or 0 on error.
+    unsigned QueuePathQuery(const Vector3& start, const Vector3& end, const Vector3& extents = Vector3::ONE,
+        const NavigationPathCallback& callback = NavigationPathCallback(), const dtQueryFilter* filter = nullptr);
+    /// Cancel a queued path query. Return true if it had not completed yet.
+    bool CancelPathQuery(unsigned id);
+    /// Set the total number of path search iterations per frame for the queued path queries.
+    /// @property
+    void SetPathQueryIterations(unsigned iterations);
+    /// Set the maximum number of queued path queries in progress at once.
+    /// @property
+    void SetMaxActivePathQueries(unsigned num);
     /// Add debug geometry to the debug renderer.
     void DrawDebugGeometry(bool depthTest);
 
@@ -267,10 +323,29 @@ public:
     /// Get the current cost of an area.
     float GetAreaCost(unsigned areaID) const;
 
+    /// Return the total number of path search iterations per frame for the queued path queries.
+    /// @property
+    unsigned GetPathQueryIterations() const { return pathQueryIterations_; }
+
+    /// Return the maximum number of queued path queries in progress at once.
+    /// @property
+    unsigned GetMaxActivePathQueries() const { return maxActivePathQueries_; }
+
+    /// Return statistics of the queued path queries during the last frame.
+    const NavigationPathQueryStats& GetPathQueryStats() const;
+
     /// Return whether has been initialized with valid navigation data.
     /// @property
     bool IsInitialized() const { return navMesh_ != nullptr; }
 
+    /// Return whether an asynchronous build is in progress.
+    /// @property
+    bool IsBuilding() const { return asyncBuild_.NotNull(); }
+
+    /// Return progress of the asynchronous build in progress from 0 to 1, or 1 if not building.
+    /// @property
+    float GetBuildProgress() const;
+
     /// Return local space bounding box of the navigation mesh.
     /// @property
     const BoundingBox& GetBoundingBox() const { return boundingBox_; }
@@ -317,18 +392,50 @@ private:
     void WriteTile(Serializer& dest, int x, int z) const;
     /// Read tile data to the navigation mesh.
     bool ReadTile(Deserializer& source, bool silent);
+    /// Add geometry of one component to the geometry data.
+    void AddGeometry(NavBuildData* build, const NavigationGeometryInfo& info, const Matrix3x4& inverse);
+    /// Handle completion of an asynchronous tile build.
+    void HandleWorkItemCompleted(StringHash eventType, VariantMap& eventData);
+    /// Handle scene post-update to advance the queued path queries.
+    void HandlePathQueryUpdate(StringHash eventType, VariantMap& eventData);
+    /// Find a path using the given query objects without assigning the area IDs. Can be called from worker threads.
+    void FindPath(PODVector<NavigationPathPoint>& dest, dtNavMeshQuery* query, FindPathData* data, const Vector3& start,
+        const Vector3& end, const Vector3& extents, const dtQueryFilter* filter) const;
+    /// Convert a polygon path to a straight world space path without assigning the area IDs. Can be called from worker threads.
+    void GetStraightPath(PODVector<NavigationPathPoint>& dest, dtNavMeshQuery* query, FindPathData* data,
+        const Vector3& localStart, const Vector3& localEnd, dtPolyRef endRef, int numPolys) const;
+    /// Advance a queued path query by at most the given number of search iterations. Called from worker threads.
+    void UpdatePathQuery(NavPathQuerySlot& slot, unsigned maxIterations) const;
+    /// Assign navigation area IDs to path points.
+    void AssignPathAreas(PODVector<NavigationPathPoint>& path) const;
+    /// Release the query objects of the queued path queries and restart the queries in progress.
+    void ReleasePathQueries();
 
 protected:
+    /// Handle node being assigned.
+    void OnNodeSet(Node* node) override;
+    /// Handle scene being assigned.
+    void OnSceneSet(Scene* scene) override;
     /// Collect geometry from under Navigable components.
     void CollectGeometries(Vector<NavigationGeometryInfo>& geometryList);
     /// Visit nodes and collect navigable geometry.
     void CollectGeometries(Vector<NavigationGeometryInfo>& geometryList, Node* node, HashSet<Node*>& processedNodes, bool recursive);
     /// Get geometry data within a bounding box.
     void GetTileGeometry(NavBuildData* build, Vector<NavigationGeometryInfo>& geometryList, BoundingBox& box);
+    /// Extract the geometry intersecting a bounding box once for sharing between the tile builds.
+    void ExtractGeometries(NavSharedGeometry& dest, const Vector<NavigationGeometryInfo>& geometryList, const BoundingBox& box);
     /// Add a triangle mesh to the geometry data.
     void AddTriMeshGeometry(NavBuildData* build, Geometry* geometry, const Matrix3x4& transform);
-    /// Build one tile of the navigation mesh. Return true if successful.
-    virtual bool BuildTile(Vector<NavigationGeometryInfo>& geometryList, int x, int z);
+    /// Release the navigation mesh, collect the geometry and calculate the bounding box and number of tiles for a full build. Return false if no scene node.
+    bool PrepareBuild(Vector<NavigationGeometryInfo>& geometryList);
+    /// Allocate the navigation mesh for a full build. Return true if successful.
+    virtual bool InitializeBuild();
+    /// Finish a full build and send the rebuilt notification.
+    virtual void FinishBuild(unsigned numTiles);
+    /// Run the Recast build of one tile. Called from worker threads, so must only read the build parameters and the shared geometry. Return true if successful.
+    virtual bool BuildTileData(NavTileBuildTask& task, const NavSharedGeometry& geometry) const;
+    /// Add a built tile to the navigation mesh, replacing the previous one. Takes ownership of the built data. Return true if successful.
+    virtual bool AddTileData(NavTileBuildTask& task);
     /// Build tiles in the rectangular area. Return number of built tiles.
     unsigned BuildTiles(Vector<NavigationGeometryInfo>& geometryList, const IntVector2& from, const IntVector2& to);
     /// Ensure that the navigation mesh query is initialized. Return true if successful.
@@ -346,6 +453,10 @@ protected:
     UniquePtr<dtQueryFilter> queryFilter_;
     /// Temporary data for finding a path.
     UniquePtr<FindPathData> pathData_;
+    /// Asynchronous build in progress.
+    UniquePtr<NavAsyncBuild> asyncBuild_;
+    /// Batched and queued path queries.
+    UniquePtr<NavPathQueryService> pathQueries_;
     /// Tile size.
     int tileSize_;
     /// Cell size.
@@ -374,6 +485,10 @@ protected:
     float detailSampleMaxError_;
     /// Bounding box padding.
     Vector3 padding_;
+    /// Path search iterations per frame for the queued path queries.
+    unsigned pathQueryIterations_;
+    /// Maximum number of queued path queries in progress at once.
+    unsigned maxActivePathQueries_;
     /// Number of tiles in X direction.
     int numTilesX_;
     /// Number of tiles in Z direction.
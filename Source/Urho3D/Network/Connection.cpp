@@ -29,6 +29,7 @@
 #include "../IO/MemoryBuffer.h"
 #include "../IO/PackageFile.h"
 #include "../Network/Connection.h"
+#include "../Network/InterestManager.h"
 #include "../Network/Network.h"
 #include "../Network/NetworkEvents.h"
 #include "../Network/NetworkPriority.h"
@@ -71,12 +72,15 @@ PackageUpload::PackageUpload() :
 Connection::Connection(Context* context, bool isClient, const SLNet::AddressOrGUID& address, SLNet::RakPeerInterface* peer) :
     Object(context),
     timeStamp_(0),
+    numNodesConsidered_(0),
+    numNodesSent_(0),
     peer_(peer),
     sendMode_(OPSM_NONE),
     isClient_(isClient),
     connectPending_(false),
     sceneLoaded_(false),
     logStatistics_(false),
+    interestActive_(false),
     address_(nullptr),
     packedMessageLimit_(1024)
 {
@@ -183,9 +187,13 @@ void Connection::SetScene(Scene* newScene)
         scene_->CleanupConnection(this);
     }
 
+    relevantNodes_.Clear();
+    interestActive_ = false;
+
     scene_ = newScene;
     sceneLoaded_ = false;
     UnsubscribeFromEvent(E_ASYNCLOADFINISHED);
+    UnsubscribeFromEvent(E_NODEADDED);
 
     if (!scene_)
         return;
@@ -208,6 +216,10 @@ void Connection::SetScene(Scene* newScene)
             msg_.WriteUInt(package->GetChecksum());
         }
         SendMessage(MSG_LOADSCENE, true, true, msg_);
+
+        // With interest management, a node moved under a relevant top-level node has to be checked in full, as the
+        // client may never have received it
+        SubscribeToEvent(scene_, E_NODEADDED, URHO3D_HANDLER(Connection, HandleNodeAdded));
     }
     else
     {
@@ -256,6 +268,31 @@ void Connection::Disconnect(int waitMSec)
     peer_->CloseConnection(*address_, true);
 }
 
+void Connection::PrepareServerUpdate()
+{
+    if (!scene_ || !sceneLoaded_)
+        return;
+
+    numNodesConsidered_ = 0;
+    numNodesSent_ = 0;
+
+    // If the scene uses spatial interest management, update the relevant top-level nodes first
+    auto* interest = scene_->GetComponent<InterestManager>();
+    if (interest && interest->IsEnabledEffective())
+        UpdateRelevantNodes(interest);
+    else if (interestActive_)
+        ResetRelevantNodes();
+
+    // World transforms are updated lazily, so make sure the ones read for distance-based priority are current
+    // before the update is possibly sent from a worker thread
+    for (HashSet<unsigned>::ConstIterator i = sceneState_.dirtyNodes_.Begin(); i != sceneState_.dirtyNodes_.End(); ++i)
+    {
+        Node* node = scene_->GetNode(*i);
+        if (node)
+            node->GetWorldPosition();
+    }
+}
+
 void Connection::SendServerUpdate()
 {
     if (!scene_ || !sceneLoaded_)
@@ -1196,12 +1233,26 @@ void Connection::HandleAsyncLoadFinished(StringHash eventType, VariantMap& event
     SendMessage(MSG_SCENELOADED, true, true, msg_);
 }
 
+void Connection::HandleNodeAdded(StringHash eventType, VariantMap& eventData)
+{
+    using namespace NodeAdded;
+
+    if (!interestActive_)
+        return;
+
+    auto* node = static_cast<Node*>(eventData[P_NODE].GetPtr());
+    if (node && IsRelevant(node))
+        MarkHierarchyDirty(node);
+}
+
 void Connection::ProcessNode(unsigned nodeID)
 {
     // Check that we have not already processed this due to dependency recursion
     if (!nodesToProcess_.Erase(nodeID))
         return;
 
+    ++numNodesConsidered_;
+
     // Find replication state for the node
     HashMap<unsigned, NodeReplicationState>::Iterator i = sceneState_.nodeStates_.Find(nodeID);
     if (i != sceneState_.nodeStates_.End())
@@ -1217,7 +1268,18 @@ void Connection::ProcessNode(unsigned nodeID)
             // would be enough. However, this may be better due to the client not possibly having updated parenting
             // information at the time of receiving this message
             SendMessage(MSG_REMOVENODE, true, true, msg_);
-            sceneState_.nodeStates_.Erase(nodeID);
+            {
+                // Erasing the state releases weak references to the node and its components, which other connections
+                // may be referencing in worker threads
+                MutexLock lock(scene_->GetReplicationMutex());
+                sceneState_.nodeStates_.Erase(nodeID);
+            }
+            ++numNodesSent_;
+        }
+        else if (interestActive_ && !IsRelevant(node))
+        {
+            // The node has been moved under a top-level node the client is not interested in
+            RemoveHierarchy(node);
         }
         else
             ProcessExistingNode(node, i->second_);
@@ -1226,11 +1288,12 @@ void Connection::ProcessNode(unsigned nodeID)
     {
         // Replication state not found: this is a new node
         Node* node = scene_->GetNode(nodeID);
-        if (node)
+        if (node && (!interestActive_ || IsRelevant(node)))
             ProcessNewNode(node);
         else
         {
-            // Did not find the new node (may have been created, then removed immediately): erase from dirty set.
+            // Did not find the new node (may have been created, then removed immediately), or the client is not
+            // interested in it: erase from dirty set. It is marked dirty again once it becomes relevant
             sceneState_.dirtyNodes_.Erase(nodeID);
         }
     }
@@ -1253,8 +1316,13 @@ void Connection::ProcessNewNode(Node* node)
     NodeReplicationState& nodeState = sceneState_.nodeStates_[node->GetID()];
     nodeState.connection_ = this;
     nodeState.sceneState_ = &sceneState_;
-    nodeState.node_ = node;
-    node->AddReplicationState(&nodeState);
+    {
+        // Other connections may be referencing the same node in worker threads. The weak reference count of the node
+        // is also shared, so assign the weak pointer under the lock too
+        MutexLock lock(scene_->GetReplicationMutex());
+        nodeState.node_ = node;
+        node->AddReplicationState(&nodeState);
+    }
 
     // Write node's attributes
     node->WriteInitialDeltaUpdate(msg_, timeStamp_);
@@ -1281,8 +1349,11 @@ void Connection::ProcessNewNode(Node* node)
         ComponentReplicationState& componentState = nodeState.componentStates_[component->GetID()];
         componentState.connection_ = this;
         componentState.nodeState_ = &nodeState;
-        componentState.component_ = component;
-        component->AddReplicationState(&componentState);
+        {
+            MutexLock lock(scene_->GetReplicationMutex());
+            componentState.component_ = component;
+            component->AddReplicationState(&componentState);
+        }
 
         msg_.WriteStringHash(component->GetType());
         msg_.WriteNetID(component->GetID());
@@ -1290,6 +1361,7 @@ void Connection::ProcessNewNode(Node* node)
     }
 
     SendMessage(MSG_CREATENODE, true, true, msg_);
+    ++numNodesSent_;
 
     nodeState.markedDirty_ = false;
     sceneState_.dirtyNodes_.Erase(node->GetID());
@@ -1316,6 +1388,8 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
             return;
     }
 
+    bool sent = false;
+
     // Check if attributes have changed
     if (nodeState.dirtyAttributes_.Count() || nodeState.dirtyVars_.Size())
     {
@@ -1340,6 +1414,7 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
             node->WriteLatestDataUpdate(msg_, timeStamp_);
 
             SendMessage(MSG_NODELATESTDATA, true, false, msg_, node->GetID());
+            sent = true;
         }
 
         // Send deltaupdate if remaining dirty bits, or vars have changed
@@ -1370,6 +1445,7 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
             }
 
             SendMessage(MSG_NODEDELTAUPDATE, true, true, msg_);
+            sent = true;
 
             nodeState.dirtyAttributes_.ClearAll();
             nodeState.dirtyVars_.Clear();
@@ -1390,6 +1466,8 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
             msg_.WriteNetID(current->first_);
 
             SendMessage(MSG_REMOVECOMPONENT, true, true, msg_);
+            sent = true;
+            MutexLock lock(scene_->GetReplicationMutex());
             nodeState.componentStates_.Erase(current);
         }
         else
@@ -1418,6 +1496,7 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                     component->WriteLatestDataUpdate(msg_, timeStamp_);
 
                     SendMessage(MSG_COMPONENTLATESTDATA, true, false, msg_, component->GetID());
+                    sent = true;
                 }
 
                 // Send deltaupdate if remaining dirty bits
@@ -1428,6 +1507,7 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                     component->WriteDeltaUpdate(msg_, componentState.dirtyAttributes_, timeStamp_);
 
                     SendMessage(MSG_COMPONENTDELTAUPDATE, true, true, msg_);
+                    sent = true;
 
                     componentState.dirtyAttributes_.ClearAll();
                 }
@@ -1453,8 +1533,11 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                 ComponentReplicationState& componentState = nodeState.componentStates_[component->GetID()];
                 componentState.connection_ = this;
                 componentState.nodeState_ = &nodeState;
-                componentState.component_ = component;
-                component->AddReplicationState(&componentState);
+                {
+                    MutexLock lock(scene_->GetReplicationMutex());
+                    componentState.component_ = component;
+                    component->AddReplicationState(&componentState);
+                }
 
                 msg_.Clear();
                 msg_.WriteNetID(node->GetID());
@@ -1463,14 +1546,143 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                 component->WriteInitialDeltaUpdate(msg_, timeStamp_);
 
                 SendMessage(MSG_CREATECOMPONENT, true, true, msg_);
+                sent = true;
             }
         }
     }
 
+    if (sent)
+        ++numNodesSent_;
+
     nodeState.markedDirty_ = false;
     sceneState_.dirtyNodes_.Erase(node->GetID());
 }
 
+void Connection::UpdateRelevantNodes(InterestManager* interest)
+{
+    URHO3D_PROFILE(UpdateRelevantNodes);
+
+    float radius = interest->GetInterestRadius();
+    float keepRadius = radius * (1.0f + interest->GetHysteresis());
+    interest->GetNodes(interestNodes_, position_, keepRadius, this);
+
+    // Nodes not yet relevant must be within the interest radius, while already relevant nodes are kept until they pass
+    // the hysteresis radius. Nodes owned by this connection are always relevant
+    newRelevantNodes_.Clear();
+    for (PODVector<Node*>::ConstIterator i = interestNodes_.Begin(); i != interestNodes_.End(); ++i)
+    {
+        Node* node = *i;
+        unsigned nodeID = node->GetID();
+        if (newRelevantNodes_.Contains(nodeID))
+            continue;
+
+        bool wasRelevant = interestActive_ && relevantNodes_.Contains(nodeID);
+        float maxDistance = wasRelevant ? keepRadius : radius;
+        if (node->GetOwner() == this || (node->GetWorldPosition() - position_).LengthSquared() <= maxDistance * maxDistance)
+        {
+            newRelevantNodes_.Insert(nodeID);
+            // Nodes entering the interest area have not been kept up to date, so they need to be checked in full
+            if (!wasRelevant)
+                MarkHierarchyDirty(node);
+        }
+    }
+
+    // Remove the nodes that left the interest area from the client. Removed nodes are instead handled by the normal
+    // replication path, and nodes that were parented elsewhere when they are next processed
+    if (interestActive_)
+    {
+        for (HashSet<unsigned>::ConstIterator i = relevantNodes_.Begin(); i != relevantNodes_.End(); ++i)
+        {
+            if (newRelevantNodes_.Contains(*i))
+                continue;
+            Node* node = scene_->GetNode(*i);
+            if (node && node->GetParent() == scene_)
+                RemoveHierarchy(node);
+        }
+    }
+    else
+    {
+        // Interest management was just activated: the client may have received the whole scene before
+        const Vector<SharedPtr<Node> >& children = scene_->GetChildren();
+        for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+        {
+            Node* node = *i;
+            if (node->IsReplicated() && !newRelevantNodes_.Contains(node->GetID()))
+                RemoveHierarchy(node);
+        }
+    }
+
+    relevantNodes_.Swap(newRelevantNodes_);
+    interestActive_ = true;
+}
+
+void Connection::ResetRelevantNodes()
+{
+    relevantNodes_.Clear();
+    interestActive_ = false;
+
+    // Nodes outside the interest area were not kept up to date, so check the whole scene
+    MarkHierarchyDirty(scene_);
+}
+
+bool Connection::IsRelevant(Node* node) const
+{
+    // Find the top-level node, which is a direct child of the scene
+    Node* parent = node->GetParent();
+    while (parent && parent != scene_)
+    {
+        node = parent;
+        parent = node->GetParent();
+    }
+
+    return node == scene_ || relevantNodes_.Contains(node->GetID());
+}
+
+void Connection::MarkHierarchyDirty(Node* node)
+{
+    if (node->IsReplicated())
+        sceneState_.dirtyNodes_.Insert(node->GetID());
+
+    const Vector<SharedPtr<Node> >& children = node->GetChildren();
+    for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+        MarkHierarchyDirty(*i);
+}
+
+void Connection::RemoveHierarchy(Node* node)
+{
+    unsigned nodeID = node->GetID();
+    HashMap<unsigned, NodeReplicationState>::Iterator i = sceneState_.nodeStates_.Find(nodeID);
+    if (i != sceneState_.nodeStates_.End())
+    {
+        msg_.Clear();
+        msg_.WriteNetID(nodeID);
+        SendMessage(MSG_REMOVENODE, true, true, msg_);
+        ++numNodesSent_;
+
+        // Detach the replication states so that changes to the node and its components are no longer tracked, then
+        // erase them, which releases the weak references to the node and its components
+        NodeReplicationState& nodeState = i->second_;
+        MutexLock lock(scene_->GetReplicationMutex());
+        if (NetworkState* networkState = node->GetNetworkState())
+            networkState->replicationStates_.Remove(&nodeState);
+        for (HashMap<unsigned, ComponentReplicationState>::Iterator j = nodeState.componentStates_.Begin();
+             j != nodeState.componentStates_.End(); ++j)
+        {
+            Component* component = j->second_.component_;
+            NetworkState* networkState = component ? component->GetNetworkState() : nullptr;
+            if (networkState)
+                networkState->replicationStates_.Remove(&j->second_);
+        }
+        sceneState_.nodeStates_.Erase(i);
+    }
+
+    sceneState_.dirtyNodes_.Erase(nodeID);
+
+    const Vector<SharedPtr<Node> >& children = node->GetChildren();
+    for (Vector<SharedPtr<Node> >::ConstIterator j = children.Begin(); j != children.End(); ++j)
+        RemoveHierarchy(*j);
+}
+
 bool Connection::RequestNeededPackages(unsigned numPackages, MemoryBuffer& msg)
 {
     auto* cache = GetSubsystem<ResourceCache>();
@@ -45,6 +45,7 @@ namespace Urho3D
 {
 
 class File;
+class InterestManager;
 class MemoryBuffer;
 class Node;
 class Scene;
@@ -155,7 +156,9 @@ public:
     void SetLogStatistics(bool enable);
     /// Disconnect. If wait time is non-zero, will block while waiting for disconnect to finish.
     void Disconnect(int waitMSec = 0);
-    /// Send scene update messages. Called by Network.
+    /// Prepare for sending scene update messages by updating interest management. Called by Network in the main thread.
+    void PrepareServerUpdate();
+    /// Send scene update messages. Called by Network after PrepareServerUpdate(), possibly in a worker thread.
     void SendServerUpdate();
     /// Send latest controls from the client. Called by Network.
     void SendClientUpdate();
@@ -250,6 +253,18 @@ public:
     /// @property
     int GetPacketsOutPerSec() const;
 
+    /// Return number of nodes considered during the last server update.
+    /// @property
+    unsigned GetNumNodesConsidered() const { return numNodesConsidered_; }
+
+    /// Return number of nodes that had data sent during the last server update.
+    /// @property
+    unsigned GetNumNodesSent() const { return numNodesSent_; }
+
+    /// Return number of top-level nodes relevant to the client when the scene has an InterestManager.
+    /// @property
+    unsigned GetNumRelevantNodes() const { return relevantNodes_.Size(); }
+
     /// Return an address:port string.
     String ToString() const;
     /// Return number of package downloads remaining.
@@ -279,6 +294,8 @@ public:
 private:
     /// Handle scene loaded event.
     void HandleAsyncLoadFinished(StringHash eventType, VariantMap& eventData);
+    /// Handle a node being added or reparented in the scene. Marks the hierarchy dirty if it now belongs to a relevant top-level node.
+    void HandleNodeAdded(StringHash eventType, VariantMap& eventData);
     /// Process a LoadScene message from the server. Called by Network.
     void ProcessLoadScene(int msgID, MemoryBuffer& msg);
     /// Process a SceneChecksumError message from the server. Called by Network.
@@ -301,6 +318,16 @@ private:
     void ProcessNewNode(Node* node);
     /// Process a node that the client has already received.
     void ProcessExistingNode(Node* node, NodeReplicationState& nodeState);
+    /// Update the relevant top-level nodes from the scene's interest manager. Nodes entering the interest area are marked dirty and nodes leaving it are removed from the client.
+    void UpdateRelevantNodes(InterestManager* interest);
+    /// Stop interest management and mark all replicated nodes dirty so that the client receives the whole scene.
+    void ResetRelevantNodes();
+    /// Return whether a node belongs to a relevant top-level node.
+    bool IsRelevant(Node* node) const;
+    /// Mark a node and its replicated children dirty.
+    void MarkHierarchyDirty(Node* node);
+    /// Remove a node and its replicated children from the client, and forget their replication states.
+    void RemoveHierarchy(Node* node);
     /// Process a SyncPackagesInfo message from server.
     void ProcessPackageInfo(int msgID, MemoryBuffer& msg);
     /// Process unknown message. All unknown messages are forwarded as an events
@@ -332,6 +359,16 @@ private:
     HashMap<unsigned, PODVector<unsigned char> > componentLatestData_;
     /// Node ID's to process during a replication update.
     HashSet<unsigned> nodesToProcess_;
+    /// Top-level node ID's relevant to the client when interest management is active.
+    HashSet<unsigned> relevantNodes_;
+    /// Relevant top-level node ID's being collected during an update.
+    HashSet<unsigned> newRelevantNodes_;
+    /// Interest management query result.
+    PODVector<Node*> interestNodes_;
+    /// Number of nodes considered during the last server update.
+    unsigned numNodesConsidered_;
+    /// Number of nodes that had data sent during the last server update.
+    unsigned numNodesSent_;
     /// Reusable message buffer.
     VectorBuffer msg_;
     /// Queued remote events.
@@ -356,6 +393,8 @@ private:
     bool sceneLoaded_;
     /// Show statistics flag.
     bool logStatistics_;
+    /// Interest management active flag.
+    bool interestActive_;
     /// Address of this connection.
     SLNet::AddressOrGUID* address_;
     /// Raknet peer object.
@@ -0,0 +1,186 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "../Precompiled.h"
+
+#include "../Core/Context.h"
+#include "../Core/Profiler.h"
+#include "../Network/InterestManager.h"
+#include "../Scene/Node.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+extern const char* NETWORK_CATEGORY;
+
+static const float DEFAULT_CELL_SIZE = 50.0f;
+static const float DEFAULT_INTEREST_RADIUS = 100.0f;
+static const float DEFAULT_HYSTERESIS = 0.1f;
+static const float MIN_CELL_SIZE = 0.001f;
+/// Grid coordinates are packed as three 21-bit fields into the cell key.
+static const int CELL_COORD_BITS = 21;
+static const int CELL_COORD_OFFSET = 1 << (CELL_COORD_BITS - 1);
+static const int CELL_COORD_MAX = (1 << CELL_COORD_BITS) - 1;
+
+static int GetCellCoord(float value, float cellSize)
+{
+    return Clamp(FloorToInt(value / cellSize) + CELL_COORD_OFFSET, 0, CELL_COORD_MAX);
+}
+
+static unsigned long long MakeCellKey(int x, int y, int z)
+{
+    return ((unsigned long long)x << (CELL_COORD_BITS * 2)) | ((unsigned long long)y << CELL_COORD_BITS) | (unsigned long long)z;
+}
+
+InterestManager::InterestManager(Context* context) :
+    Component(context),
+    cellSize_(DEFAULT_CELL_SIZE),
+    interestRadius_(DEFAULT_INTEREST_RADIUS),
+    hysteresis_(DEFAULT_HYSTERESIS),
+    numNodes_(0)
+{
+}
+
+InterestManager::~InterestManager() = default;
+
+void InterestManager::RegisterObject(Context* context)
+{
+    context->RegisterFactory<InterestManager>(NETWORK_CATEGORY);
+
+    URHO3D_ACCESSOR_ATTRIBUTE("Is Enabled", IsEnabled, SetEnabled, bool, true, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Cell Size", GetCellSize, SetCellSize, float, DEFAULT_CELL_SIZE, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Interest Radius", GetInterestRadius, SetInterestRadius, float, DEFAULT_INTEREST_RADIUS, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Hysteresis", GetHysteresis, SetHysteresis, float, DEFAULT_HYSTERESIS, AM_DEFAULT);
+}
+
+void InterestManager::SetCellSize(float size)
+{
+    cellSize_ = Max(size, MIN_CELL_SIZE);
+    MarkNetworkUpdate();
+}
+
+void InterestManager::SetInterestRadius(float radius)
+{
+    interestRadius_ = Max(radius, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void InterestManager::SetHysteresis(float hysteresis)
+{
+    hysteresis_ = Max(hysteresis, 0.0f);
+    MarkNetworkUpdate();
+}
+
+void InterestManager::Update()
+{
+    URHO3D_PROFILE(UpdateInterestGrid);
+
+    // Reuse the cell vectors from the previous update, then remove the cells that were left empty
+    for (HashMap<unsigned long long, PODVector<Node*> >::Iterator i = cells_.Begin(); i != cells_.End(); ++i)
+        i->second_.Clear();
+    ownedNodes_.Clear();
+    numNodes_ = 0;
+
+    if (node_)
+    {
+        const Vector<SharedPtr<Node> >& children = node_->GetChildren();
+        for (Vector<SharedPtr<Node> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+        {
+            Node* child = *i;
+            if (!child->IsReplicated())
+                continue;
+
+            cells_[GetCellKey(child->GetWorldPosition())].Push(child);
+            if (child->GetOwner())
+                ownedNodes_.Push(child);
+            ++numNodes_;
+        }
+    }
+
+    for (HashMap<unsigned long long, PODVector<Node*> >::Iterator i = cells_.Begin(); i != cells_.End();)
+    {
+        if (i->second_.Empty())
+            i = cells_.Erase(i);
+        else
+            ++i;
+    }
+}
+
+void InterestManager::GetNodes(PODVector<Node*>& dest, const Vector3& position, float radius, Connection* owner) const
+{
+    dest.Clear();
+
+    int minX = GetCellCoord(position.x_ - radius, cellSize_);
+    int minY = GetCellCoord(position.y_ - radius, cellSize_);
+    int minZ = GetCellCoord(position.z_ - radius, cellSize_);
+    int maxX = GetCellCoord(position.x_ + radius, cellSize_);
+    int maxY = GetCellCoord(position.y_ + radius, cellSize_);
+    int maxZ = GetCellCoord(position.z_ + radius, cellSize_);
+
+    unsigned long long numQueryCells = (unsigned long long)(maxX - minX + 1) * (maxY - minY + 1) * (maxZ - minZ + 1);
+    if (numQueryCells <= cells_.Size())
+    {
+        for (int x = minX; x <= maxX; ++x)
+        {
+            for (int y = minY; y <= maxY; ++y)
+            {
+                for (int z = minZ; z <= maxZ; ++z)
+                {
+                    HashMap<unsigned long long, PODVector<Node*> >::ConstIterator i = cells_.Find(MakeCellKey(x, y, z));
+                    if (i != cells_.End())
+                        dest.Push(i->second_);
+                }
+            }
+        }
+    }
+    else
+    {
+        // The query box spans more cells than are occupied: iterate the occupied cells instead
+        for (HashMap<unsigned long long, PODVector<Node*> >::ConstIterator i = cells_.Begin(); i != cells_.End(); ++i)
+        {
+            int x = (int)(i->first_ >> (CELL_COORD_BITS * 2));
+            int y = (int)(i->first_ >> CELL_COORD_BITS) & CELL_COORD_MAX;
+            int z = (int)i->first_ & CELL_COORD_MAX;
+            if (x >= minX && x <= maxX && y >= minY && y <= maxY && z >= minZ && z <= maxZ)
+                dest.Push(i->second_);
+        }
+    }
+
+    if (owner)
+    {
+        for (PODVector<Node*>::ConstIterator i = ownedNodes_.Begin(); i != ownedNodes_.End(); ++i)
+        {
+            if ((*i)->GetOwner() == owner)
+                dest.Push(*i);
+        }
+    }
+}
+
+unsigned long long InterestManager::GetCellKey(const Vector3& position) const
+{
+    return MakeCellKey(GetCellCoord(position.x_, cellSize_), GetCellCoord(position.y_, cellSize_),
+        GetCellCoord(position.z_, cellSize_));
+}
+
+}
@@ -0,0 +1,99 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "../Container/HashMap.h"
+#include "../Scene/Component.h"
+
+namespace Urho3D
+{
+
+class Connection;
+
+/// %Network spatial interest management component. When placed in the scene root, each client connection only receives the top-level nodes (and their children) near its observer position.
+class URHO3D_API InterestManager : public Component
+{
+    URHO3D_OBJECT(InterestManager, Component);
+
+public:
+    /// Construct.
+    explicit InterestManager(Context* context);
+    /// Destruct.
+    ~InterestManager() override;
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Set grid cell size. Default 50.
+    /// @property
+    void SetCellSize(float size);
+    /// Set interest radius around the observer position. Default 100.
+    /// @property
+    void SetInterestRadius(float radius);
+    /// Set hysteresis as a fraction of the interest radius; nodes already relevant are kept until they are this much further away. Default 0.1.
+    /// @property
+    void SetHysteresis(float hysteresis);
+
+    /// Return grid cell size.
+    /// @property
+    float GetCellSize() const { return cellSize_; }
+
+    /// Return interest radius.
+    /// @property
+    float GetInterestRadius() const { return interestRadius_; }
+
+    /// Return hysteresis.
+    /// @property
+    float GetHysteresis() const { return hysteresis_; }
+
+    /// Return number of occupied grid cells.
+    /// @property
+    unsigned GetNumCells() const { return cells_.Size(); }
+
+    /// Return number of nodes in the grid.
+    /// @property
+    unsigned GetNumNodes() const { return numNodes_; }
+
+    /// Rebuild the grid from the scene's top-level replicated nodes. Called by Network once per update before sending the server updates.
+    void Update();
+    /// Return top-level nodes within radius of a position, plus the top-level nodes owned by the connection. May also return nodes slightly outside the radius; the caller is expected to do the exact distance check. Called by Connection.
+    void GetNodes(PODVector<Node*>& dest, const Vector3& position, float radius, Connection* owner) const;
+
+private:
+    /// Return grid cell key for a world position.
+    unsigned long long GetCellKey(const Vector3& position) const;
+
+    /// Nodes by grid cell.
+    HashMap<unsigned long long, PODVector<Node*> > cells_;
+    /// Owned top-level nodes.
+    PODVector<Node*> ownedNodes_;
+    /// Grid cell size.
+    float cellSize_;
+    /// Interest radius.
+    float interestRadius_;
+    /// Hysteresis fraction.
+    float hysteresis_;
+    /// Number of nodes in the grid.
+    unsigned numNodes_;
+};
+
+}
@@ -25,6 +25,7 @@
 #include "../Core/Context.h"
 #include "../Core/CoreEvents.h"
 #include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
 #include "../Engine/EngineEvents.h"
 #include "../IO/FileSystem.h"
 #include "../Input/InputEvents.h"
@@ -32,6 +33,7 @@
 #include "../IO/Log.h"
 #include "../IO/MemoryBuffer.h"
 #include "../Network/HttpRequest.h"
+#include "../Network/InterestManager.h"
 #include "../Network/Network.h"
 #include "../Network/NetworkEvents.h"
 #include "../Network/NetworkPriority.h"
@@ -201,6 +203,7 @@ Network::Network(Context* context) :
     updateInterval_(1.0f / (float)DEFAULT_UPDATE_FPS),
     updateAcc_(0.0f),
     isServer_(false),
+    threadedUpdate_(true),
     scene_(nullptr),
     natPunchServerAddress_(nullptr),
     remoteGUID_(nullptr)
@@ -940,20 +943,59 @@ void Network::PostUpdate(float timeStep)
                 }
 
                 for (HashSet<Scene*>::ConstIterator i = networkScenes_.Begin(); i != networkScenes_.End(); ++i)
-                    (*i)->PrepareNetworkUpdate();
+                {
+                    Scene* scene = *i;
+                    scene->PrepareNetworkUpdate();
+
+                    // Rebuild the interest grid once here, so that each connection only needs to query it
+                    auto* interest = scene->GetComponent<InterestManager>();
+                    if (interest && interest->IsEnabledEffective())
+                        interest->Update();
+                }
             }
 
             {
                 URHO3D_PROFILE(SendServerUpdate);
 
-                // Then send server updates for each client connection
+                // Interest management and world transform updates touch state shared by all connections, so prepare
+                // the client connections in the main thread first
+                updateConnections_.Clear();
                 for (HashMap<SLNet::AddressOrGUID, SharedPtr<Connection> >::Iterator i = clientConnections_.Begin();
                      i != clientConnections_.End(); ++i)
                 {
-                    i->second_->SendServerUpdate();
-                    i->second_->SendRemoteEvents();
-                    i->second_->SendPackages();
-                    i->second_->SendAllBuffers();
+                    i->second_->PrepareServerUpdate();
+                    updateConnections_.Push(i->second_);
+                }
+
+                // Then write the server updates for each client connection. Each connection writes only to its own
+                // replication state and message buffers, so this can be done in worker threads
+                auto* queue = GetSubsystem<WorkQueue>();
+                if (threadedUpdate_ && queue && queue->GetNumThreads() && updateConnections_.Size() > 1)
+                {
+                    Connection** connections = &updateConnections_[0];
+                    queue->ParallelFor(0, updateConnections_.Size(), 1, [connections](unsigned begin, unsigned end, unsigned threadIndex)
+                    {
+                        for (unsigned i = begin; i < end; ++i)
+                        {
+                            connections[i]->SendServerUpdate();
+                            connections[i]->SendRemoteEvents();
+                        }
+                    });
+                }
+                else
+                {
+                    for (PODVector<Connection*>::ConstIterator i = updateConnections_.Begin(); i != updateConnections_.End(); ++i)
+                    {
+                        (*i)->SendServerUpdate();
+                        (*i)->SendRemoteEvents();
+                    }
+                }
+
+                // Package uploads read from files, so send them and flush the buffers in the main thread
+                for (PODVector<Connection*>::ConstIterator i = updateConnections_.Begin(); i != updateConnections_.End(); ++i)
+                {
+                    (*i)->SendPackages();
+                    (*i)->SendAllBuffers();
                 }
             }
         }
@@ -1035,6 +1077,7 @@ void Network::ConfigureNetworkSimulator()
 void RegisterNetworkLibrary(Context* context)
 {
     NetworkPriority::RegisterObject(context);
+    InterestManager::RegisterObject(context);
 }
 
 }
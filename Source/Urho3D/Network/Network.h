@@ -88,6 +88,9 @@ public:
     /// Set network update FPS.
     /// @property
     void SetUpdateFps(int fps);
+    /// Set whether to write the server updates of client connections in worker threads. Default true.
+    /// @property
+    void SetThreadedUpdate(bool enable) { threadedUpdate_ = enable; }
     /// Set simulated latency in milliseconds. This adds a fixed delay before sending each packet.
     /// @property
     void SetSimulatedLatency(int ms);
@@ -113,6 +116,10 @@ public:
     /// @property
     int GetUpdateFps() const { return updateFps_; }
 
+    /// Return whether server updates are written in worker threads.
+    /// @property
+    bool GetThreadedUpdate() const { return threadedUpdate_; }
+
     /// Return simulated latency in milliseconds.
     /// @property
     int GetSimulatedLatency() const { return simulatedLatency_; }
@@ -172,6 +179,8 @@ private:
     HashSet<StringHash> blacklistedRemoteEvents_;
     /// Networked scenes.
     HashSet<Scene*> networkScenes_;
+    /// Client connections to send server updates to.
+    PODVector<Connection*> updateConnections_;
     /// Update FPS.
     int updateFps_;
     /// Simulated latency (send delay) in milliseconds.
@@ -186,6 +195,8 @@ private:
     String packageCacheDir_;
     /// Whether we started as server or not.
     bool isServer_;
+    /// Threaded server update flag.
+    bool threadedUpdate_;
     /// Server/Client password used for connecting.
     String password_;
     /// Scene which will be used for NAT punchtrough connections.
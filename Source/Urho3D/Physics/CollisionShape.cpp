@@ -32,6 +32,8 @@
 #include "../Graphics/Model.h"
 #include "../Graphics/Terrain.h"
 #include "../Graphics/VertexBuffer.h"
+#include "../IO/File.h"
+#include "../IO/FileSystem.h"
 #include "../IO/Log.h"
 #include "../Physics/CollisionShape.h"
 #include "../Physics/PhysicsUtils.h"
@@ -49,6 +51,7 @@
 #include <Bullet/BulletCollision/CollisionShapes/btConvexHullShape.h>
 #include <Bullet/BulletCollision/CollisionShapes/btCylinderShape.h>
 #include <Bullet/BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
+#include <Bullet/BulletCollision/CollisionShapes/btOptimizedBvh.h>
 #include <Bullet/BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.h>
 #include <Bullet/BulletCollision/CollisionShapes/btSphereShape.h>
 #include <Bullet/BulletCollision/CollisionShapes/btTriangleIndexVertexArray.h>
@@ -62,6 +65,10 @@ namespace Urho3D
 
 static const float DEFAULT_COLLISION_MARGIN = 0.04f;
 static const unsigned QUANTIZE_MAX_TRIANGLES = 1000000;
+static const unsigned COOKED_GEOMETRY_VERSION = 1;
+// Cooked BVH data is raw Bullet structures, so it is only valid for the same pointer and scalar size
+static const unsigned COOKED_GEOMETRY_PLATFORM = (unsigned)(sizeof(void*) << 8u | sizeof(btScalar));
+static const unsigned BVH_ALIGNMENT = 16;
 
 static const btVector3 WHITE(1.0f, 1.0f, 1.0f);
 static const btVector3 GREEN(0.0f, 1.0f, 0.0f);
@@ -196,13 +203,193 @@ private:
     Vector<SharedArrayPtr<unsigned char> > dataArrays_;
 };
 
+bool HasDynamicBuffers(Model* model, unsigned lodLevel);
+
+static unsigned HashBytes(unsigned hash, const void* data, unsigned size)
+{
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (unsigned i = 0; i < size; ++i)
+        hash = SDBMHash(hash, bytes[i]);
+    return hash;
+}
+
+static unsigned HashMeshInterface(const btStridingMeshInterface& meshInterface)
+{
+    unsigned hash = 0;
+    int numSubParts = meshInterface.getNumSubParts();
+
+    for (int i = 0; i < numSubParts; ++i)
+    {
+        const unsigned char* vertexBase;
+        const unsigned char* indexBase;
+        int numVertices, vertexStride, indexStride, numFaces;
+        PHY_ScalarType vertexType, indexType;
+
+        meshInterface.getLockedReadOnlyVertexIndexBase(&vertexBase, numVertices, vertexType, vertexStride, &indexBase,
+            indexStride, numFaces, indexType, i);
+        hash = HashBytes(hash, &numFaces, sizeof numFaces);
+
+        // Hash the positions of each triangle, which covers both the vertex and the index data
+        for (int j = 0; j < numFaces; ++j)
+        {
+            const unsigned char* face = indexBase + j * indexStride;
+            for (unsigned k = 0; k < 3; ++k)
+            {
+                unsigned index = indexType == PHY_SHORT ? reinterpret_cast<const unsigned short*>(face)[k] :
+                    reinterpret_cast<const unsigned*>(face)[k];
+                hash = HashBytes(hash, vertexBase + index * vertexStride, 3 * sizeof(float));
+            }
+        }
+
+        meshInterface.unLockReadOnlyVertexBase(i);
+    }
+
+    return hash;
+}
+
+static void WriteCookedHeader(Serializer& dest, ShapeType shapeType)
+{
+    dest.WriteFileID("UCOL");
+    dest.WriteUInt(COOKED_GEOMETRY_VERSION);
+    dest.WriteUInt(COOKED_GEOMETRY_PLATFORM);
+    dest.WriteUInt(shapeType);
+}
+
+static bool ReadCookedHeader(Deserializer& source, ShapeType shapeType)
+{
+    return source.ReadFileID() == "UCOL" && source.ReadUInt() == COOKED_GEOMETRY_VERSION &&
+        source.ReadUInt() == COOKED_GEOMETRY_PLATFORM && source.ReadUInt() == (unsigned)shapeType;
+}
+
+template <class T> static void BuildTriangleMeshShape(T& data)
+{
+    data.shape_ = new btBvhTriangleMeshShape(data.meshInterface_.Get(), data.meshInterface_->useQuantize_, true);
+
+    data.infoMap_ = new btTriangleInfoMap();
+    btGenerateInternalEdgeInfo(data.shape_.Get(), data.infoMap_.Get());
+}
+
+template <class T> static bool LoadCookedTriangleMesh(T& data, Deserializer& source)
+{
+    if (!ReadCookedHeader(source, SHAPE_TRIANGLEMESH) || source.ReadUInt() != HashMeshInterface(*data.meshInterface_) ||
+        source.ReadBool() != data.meshInterface_->useQuantize_)
+        return false;
+
+    unsigned bvhSize = source.ReadUInt();
+    if (!bvhSize || bvhSize > source.GetSize() - source.GetPosition())
+        return false;
+
+    // The BVH is deserialized in place, so it needs 16-byte aligned storage that outlives the shape
+    SharedArrayPtr<unsigned char> bvhData(new unsigned char[bvhSize + BVH_ALIGNMENT]);
+    void* alignedData = reinterpret_cast<void*>(((size_t)bvhData.Get() + BVH_ALIGNMENT - 1) & ~(size_t)(BVH_ALIGNMENT - 1));
+    if (source.Read(alignedData, bvhSize) != bvhSize)
+        return false;
+    btOptimizedBvh* bvh = btOptimizedBvh::deSerializeInPlace(alignedData, bvhSize, false);
+    if (!bvh)
+        return false;
+
+    unsigned numInfos = source.ReadUInt();
+    if (numInfos > (source.GetSize() - source.GetPosition()) / (2 * sizeof(int) + 3 * sizeof(float)))
+        return false;
+
+    UniquePtr<btTriangleInfoMap> infoMap(new btTriangleInfoMap());
+    for (unsigned i = 0; i < numInfos; ++i)
+    {
+        int key = source.ReadInt();
+        btTriangleInfo info;
+        info.m_flags = source.ReadInt();
+        info.m_edgeV0V1Angle = source.ReadFloat();
+        info.m_edgeV1V2Angle = source.ReadFloat();
+        info.m_edgeV2V0Angle = source.ReadFloat();
+        infoMap->insert(btHashInt(key), info);
+    }
+
+    data.cookedBvhData_ = bvhData;
+    data.shape_ = new btBvhTriangleMeshShape(data.meshInterface_.Get(), data.meshInterface_->useQuantize_, false);
+    data.shape_->setOptimizedBvh(bvh);
+    data.infoMap_ = std::move(infoMap);
+    data.shape_->setTriangleInfoMap(data.infoMap_.Get());
+    return true;
+}
+
+template <class T> static bool SaveCookedTriangleMesh(const T& data, Serializer& dest)
+{
+    btOptimizedBvh* bvh = data.shape_ ? data.shape_->getOptimizedBvh() : nullptr;
+    if (!bvh || !data.infoMap_)
+        return false;
+
+    unsigned bvhSize = bvh->calculateSerializeBufferSize();
+    SharedArrayPtr<unsigned char> bvhData(new unsigned char[bvhSize + BVH_ALIGNMENT]);
+    void* alignedData = reinterpret_cast<void*>(((size_t)bvhData.Get() + BVH_ALIGNMENT - 1) & ~(size_t)(BVH_ALIGNMENT - 1));
+    if (!bvh->serializeInPlace(alignedData, bvhSize, false))
+        return false;
+
+    WriteCookedHeader(dest, SHAPE_TRIANGLEMESH);
+    dest.WriteUInt(HashMeshInterface(*data.meshInterface_));
+    dest.WriteBool(data.meshInterface_->useQuantize_);
+    dest.WriteUInt(bvhSize);
+    dest.Write(alignedData, bvhSize);
+
+    const btTriangleInfoMap& infoMap = *data.infoMap_;
+    dest.WriteUInt((unsigned)infoMap.size());
+    for (int i = 0; i < infoMap.size(); ++i)
+    {
+        const btTriangleInfo* info = infoMap.getAtIndex(i);
+        dest.WriteInt(infoMap.getKeyAtIndex(i).getUid1());
+        dest.WriteInt(info->m_flags);
+        dest.WriteFloat(info->m_edgeV0V1Angle);
+        dest.WriteFloat(info->m_edgeV1V2Angle);
+        dest.WriteFloat(info->m_edgeV2V0Angle);
+    }
+
+    return true;
+}
+
+/// Load cooked collision geometry of a model from the resource cache. Return false if missing or stale.
+template <class T> static bool LoadCookedGeometry(T& data, Model* model, ShapeType shapeType, unsigned lodLevel)
+{
+    auto* cache = model->GetSubsystem<ResourceCache>();
+    if (!cache || model->GetName().Empty())
+        return false;
+
+    String name = GetCookedGeometryName(model->GetName(), shapeType, lodLevel);
+    if (!cache->Exists(name))
+        return false;
+
+    SharedPtr<File> file = cache->GetFile(name, false);
+    if (file && data.LoadCooked(*file))
+        return true;
+
+    URHO3D_LOGDEBUG("Cooked collision geometry " + name + " is stale, cooking at runtime");
+    return false;
+}
+
+/// Save collision geometry cooked at runtime next to the model file, if enabled in the physics world config.
+template <class T> static void SaveCookedGeometry(const T& data, Model* model, ShapeType shapeType, unsigned lodLevel)
+{
+    auto* cache = model->GetSubsystem<ResourceCache>();
+    if (!PhysicsWorld::config.saveCookedGeometry_ || !cache || model->GetName().Empty() || HasDynamicBuffers(model, lodLevel))
+        return;
+
+    // Models loaded from packages have no file to save next to
+    String modelFileName = cache->GetResourceFileName(model->GetName());
+    if (modelFileName.Empty())
+        return;
+
+    String fileName = GetCookedGeometryName(modelFileName, shapeType, lodLevel);
+    File file(model->GetContext(), fileName, FILE_WRITE);
+    if (!file.IsOpen() || !data.SaveCooked(file))
+        URHO3D_LOGWARNING("Failed to save cooked collision geometry " + fileName);
+}
+
 MaterialTriangleMeshData::MaterialTriangleMeshData(Model* model, unsigned lodLevel)
 {
 	meshInterface_ = new MaterialTriangleMeshInterface(model, lodLevel);
-	shape_ = new btBvhTriangleMeshShape(meshInterface_.Get(), meshInterface_->useQuantize_, true);
-
-	infoMap_ = new btTriangleInfoMap();
-	btGenerateInternalEdgeInfo(shape_.Get(), infoMap_.Get());
+	if (!LoadCookedGeometry(*this, model, SHAPE_TRIANGLEMESH, lodLevel))
+	{
+		BuildTriangleMeshShape(*this);
+		SaveCookedGeometry(*this, model, SHAPE_TRIANGLEMESH, lodLevel);
+	}
 }
 
 MaterialTriangleMeshData::MaterialTriangleMeshData(CustomGeometry* custom)
@@ -218,13 +405,24 @@ MaterialTriangleMeshData::~MaterialTriangleMeshData()
 {
 }
 
+bool MaterialTriangleMeshData::LoadCooked(Deserializer& source)
+{
+	return LoadCookedTriangleMesh(*this, source);
+}
+
+bool MaterialTriangleMeshData::SaveCooked(Serializer& dest) const
+{
+	return SaveCookedTriangleMesh(*this, dest);
+}
+
 TriangleMeshData::TriangleMeshData(Model* model, unsigned lodLevel)
 {
     meshInterface_ = new TriangleMeshInterface(model, lodLevel);
-    shape_ = new btBvhTriangleMeshShape(meshInterface_.Get(), meshInterface_->useQuantize_, true);
-
-    infoMap_ = new btTriangleInfoMap();
-    btGenerateInternalEdgeInfo(shape_.Get(), infoMap_.Get());
+    if (!LoadCookedGeometry(*this, model, SHAPE_TRIANGLEMESH, lodLevel))
+    {
+        BuildTriangleMeshShape(*this);
+        SaveCookedGeometry(*this, model, SHAPE_TRIANGLEMESH, lodLevel);
+    }
 }
 
 TriangleMeshData::TriangleMeshData(CustomGeometry* custom)
@@ -236,6 +434,16 @@ TriangleMeshData::TriangleMeshData(CustomGeometry* custom)
     btGenerateInternalEdgeInfo(shape_.Get(), infoMap_.Get());
 }
 
+bool TriangleMeshData::LoadCooked(Deserializer& source)
+{
+    return LoadCookedTriangleMesh(*this, source);
+}
+
+bool TriangleMeshData::SaveCooked(Serializer& dest) const
+{
+    return SaveCookedTriangleMesh(*this, dest);
+}
+
 GImpactMeshData::GImpactMeshData(Model* model, unsigned lodLevel)
 {
     meshInterface_ = new TriangleMeshInterface(model, lodLevel);
@@ -284,7 +492,12 @@ ConvexData::ConvexData(Model* model, unsigned lodLevel)
         }
     }
 
-    BuildHull(vertices);
+    sourceHash_ = vertices.Size() ? HashBytes(vertices.Size(), vertices.Buffer(), vertices.Size() * sizeof(Vector3)) : 0;
+    if (!LoadCookedGeometry(*this, model, SHAPE_CONVEXHULL, lodLevel))
+    {
+        BuildHull(vertices);
+        SaveCookedGeometry(*this, model, SHAPE_CONVEXHULL, lodLevel);
+    }
 }
 
 ConvexData::ConvexData(CustomGeometry* custom)
@@ -336,6 +549,42 @@ void ConvexData::BuildHull(const PODVector<Vector3>& vertices)
     }
 }
 
+bool ConvexData::LoadCooked(Deserializer& source)
+{
+    if (!ReadCookedHeader(source, SHAPE_CONVEXHULL) || source.ReadUInt() != sourceHash_)
+        return false;
+
+    unsigned vertexCount = source.ReadUInt();
+    if (vertexCount > (source.GetSize() - source.GetPosition()) / sizeof(Vector3))
+        return false;
+    SharedArrayPtr<Vector3> vertexData(new Vector3[vertexCount]);
+    if (source.Read(vertexData.Get(), vertexCount * sizeof(Vector3)) != vertexCount * sizeof(Vector3))
+        return false;
+
+    unsigned indexCount = source.ReadUInt();
+    if (indexCount > (source.GetSize() - source.GetPosition()) / sizeof(unsigned))
+        return false;
+    SharedArrayPtr<unsigned> indexData(new unsigned[indexCount]);
+    if (source.Read(indexData.Get(), indexCount * sizeof(unsigned)) != indexCount * sizeof(unsigned))
+        return false;
+
+    vertexData_ = vertexData;
+    vertexCount_ = vertexCount;
+    indexData_ = indexData;
+    indexCount_ = indexCount;
+    return true;
+}
+
+bool ConvexData::SaveCooked(Serializer& dest) const
+{
+    WriteCookedHeader(dest, SHAPE_CONVEXHULL);
+    dest.WriteUInt(sourceHash_);
+    dest.WriteUInt(vertexCount_);
+    dest.Write(vertexData_.Get(), vertexCount_ * sizeof(Vector3));
+    dest.WriteUInt(indexCount_);
+    return dest.Write(indexData_.Get(), indexCount_ * sizeof(unsigned)) == indexCount_ * sizeof(unsigned);
+}
+
 HeightfieldData::HeightfieldData(Terrain* terrain, unsigned lodLevel) :
     heightData_(terrain->GetHeightData()),
     spacing_(terrain->GetSpacing()),
@@ -477,6 +726,31 @@ btCollisionShape* CreateCollisionGeometryDataShape(ShapeType shapeType, Collisio
     }
 }
 
+String GetCookedGeometryName(const String& modelName, ShapeType shapeType, unsigned lodLevel)
+{
+    return ReplaceExtension(modelName, "") + "_" + typeNames[shapeType] + "_LOD" + String(lodLevel) + ".col";
+}
+
+bool CookCollisionGeometry(Serializer& dest, ShapeType shapeType, Model* model, unsigned lodLevel)
+{
+    if (shapeType != SHAPE_TRIANGLEMESH && shapeType != SHAPE_CONVEXHULL)
+    {
+        URHO3D_LOGERROR("Only triangle mesh and convex hull collision geometry can be cooked");
+        return false;
+    }
+    if (!model)
+    {
+        URHO3D_LOGERROR("Null model for cooking collision geometry");
+        return false;
+    }
+
+    SharedPtr<CollisionGeometryData> geometry(CreateCollisionGeometryData(shapeType, model, lodLevel));
+    if (shapeType == SHAPE_TRIANGLEMESH)
+        return static_cast<MaterialTriangleMeshData*>(geometry.Get())->SaveCooked(dest);
+    else
+        return static_cast<ConvexData*>(geometry.Get())->SaveCooked(dest);
+}
+
 CollisionShape::CollisionShape(Context* context) :
     Component(context),
     shapeType_(SHAPE_BOX),
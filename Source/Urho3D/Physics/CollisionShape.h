@@ -43,10 +43,12 @@ namespace Urho3D
 {
 
 class CustomGeometry;
+class Deserializer;
 class Geometry;
 class Model;
 class PhysicsWorld;
 class RigidBody;
+class Serializer;
 class Terrain;
 class TriangleMeshInterface;
 
@@ -85,8 +87,15 @@ struct MaterialTriangleMeshData : public CollisionGeometryData
 	/// Destruct. Free geometry data.
 	~MaterialTriangleMeshData();
 
+	/// Load the BVH and internal edge info from cooked data. Return true if successful and the data matches the mesh.
+	bool LoadCooked(Deserializer& source);
+	/// Save the BVH and internal edge info as cooked data. Return true if successful.
+	bool SaveCooked(Serializer& dest) const;
+
 	/// Bullet triangle mesh interface.
 	UniquePtr<MaterialTriangleMeshInterface> meshInterface_;
+	/// Cooked BVH data, which the BVH is deserialized into. Null if the BVH was built at runtime.
+	SharedArrayPtr<unsigned char> cookedBvhData_;
 	/// Bullet triangle mesh collision shape.
 	UniquePtr<btBvhTriangleMeshShape> shape_;
 	/// Bullet triangle info map.
@@ -101,8 +110,15 @@ struct TriangleMeshData : public CollisionGeometryData
     /// Construct from a custom geometry.
     explicit TriangleMeshData(CustomGeometry* custom);
 
+    /// Load the BVH and internal edge info from cooked data. Return true if successful and the data matches the mesh.
+    bool LoadCooked(Deserializer& source);
+    /// Save the BVH and internal edge info as cooked data. Return true if successful.
+    bool SaveCooked(Serializer& dest) const;
+
     /// Bullet triangle mesh interface.
     UniquePtr<TriangleMeshInterface> meshInterface_;
+    /// Cooked BVH data, which the BVH is deserialized into. Null if the BVH was built at runtime.
+    SharedArrayPtr<unsigned char> cookedBvhData_;
     /// Bullet triangle mesh collision shape.
     UniquePtr<btBvhTriangleMeshShape> shape_;
     /// Bullet triangle info map.
@@ -131,7 +147,13 @@ struct ConvexData : public CollisionGeometryData
 
     /// Build the convex hull from vertices.
     void BuildHull(const PODVector<Vector3>& vertices);
+    /// Load the hull from cooked data. Return true if successful and the data matches the source vertices.
+    bool LoadCooked(Deserializer& source);
+    /// Save the hull as cooked data. Return true if successful.
+    bool SaveCooked(Serializer& dest) const;
 
+    /// Hash of the source vertices the hull was built from.
+    unsigned sourceHash_{};
     /// Vertex data.
     SharedArrayPtr<Vector3> vertexData_;
     /// Number of vertices.
@@ -160,6 +182,11 @@ struct HeightfieldData : public CollisionGeometryData
     float maxHeight_;
 };
 
+/// Return the resource name of the cooked collision geometry of a model. Triangle mesh and convex hull shapes can be cooked.
+URHO3D_API String GetCookedGeometryName(const String& modelName, ShapeType shapeType, unsigned lodLevel);
+/// Cook the collision geometry of a model and write it in the cooked geometry format, for example when importing assets offline. Return true if successful.
+URHO3D_API bool CookCollisionGeometry(Serializer& dest, ShapeType shapeType, Model* model, unsigned lodLevel);
+
 /// Physics collision shape component.
 class URHO3D_API CollisionShape : public Component
 {
@@ -25,6 +25,8 @@
 #include "../Core/Context.h"
 #include "../Core/Mutex.h"
 #include "../Core/Profiler.h"
+#include "../Core/Thread.h"
+#include "../Core/WorkQueue.h"
 #include "../Graphics/DebugRenderer.h"
 #include "../Graphics/Model.h"
 #include "../IO/Log.h"
@@ -41,6 +43,7 @@
 #include "../Scene/SceneEvents.h"
 
 #include <Bullet/BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <Bullet/BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
 #include <Bullet/BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h>
 #include <Bullet/BulletCollision/CollisionDispatch/btInternalEdgeUtility.h>
 #include <Bullet/BulletCollision/CollisionShapes/btBoxShape.h>
@@ -48,6 +51,7 @@
 #include <Bullet/BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h>
 #include <Bullet/BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h>
 #include <Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+#include <Bullet/BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
 #include <Bullet/BulletSoftBody/btSoftBodyRigidBodyCollisionConfiguration.h>
 
 #include <Bullet/BulletDynamics/Dynamics/btRigidBody.h>
@@ -64,6 +68,7 @@ extern const char* SUBSYSTEM_CATEGORY;
 
 static const int MAX_SOLVER_ITERATIONS = 256;
 static const Vector3 DEFAULT_GRAVITY = Vector3(0.0f, -9.81f, 0.0f);
+static const unsigned QUERY_BATCH_GRAIN_SIZE = 64;
 
 PhysicsWorldConfig PhysicsWorld::config;
 
@@ -101,6 +106,161 @@ static bool CustomMaterialCombinerCallback(btManifoldPoint& cp, const btCollisio
     return true;
 }
 
+#ifdef URHO3D_THREADING
+/// Bullet task scheduler that runs the parallel loops of the multithreaded world on the work queue.
+class WorkQueueTaskScheduler : public btITaskScheduler
+{
+public:
+    /// Construct.
+    WorkQueueTaskScheduler() :
+        btITaskScheduler("WorkQueue")
+    {
+    }
+
+    /// Set the work queue to use.
+    void SetWorkQueue(WorkQueue* workQueue) { workQueue_ = workQueue; }
+
+    /// Return maximum number of threads.
+    int getMaxNumThreads() const override { return BT_MAX_THREAD_COUNT; }
+    /// Return number of threads. Bullet sizes per-thread data with this and indexes it with btGetCurrentThreadIndex(), which counts every thread that has called into Bullet, so report the maximum.
+    int getNumThreads() const override { return BT_MAX_THREAD_COUNT; }
+    /// Set number of threads. Ignored, the work queue threads are used.
+    void setNumThreads(int numThreads) override { }
+
+    /// Execute a parallel loop.
+    void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) override
+    {
+        if (!CanRunParallel(iBegin, iEnd, grainSize))
+        {
+            body.forLoop(iBegin, iEnd);
+            return;
+        }
+
+        workQueue_->ParallelFor((unsigned)iBegin, (unsigned)iEnd, (unsigned)grainSize, [&body](unsigned begin, unsigned end, unsigned)
+        {
+            body.forLoop((int)begin, (int)end);
+        });
+    }
+
+    /// Execute a parallel loop and return the sum of its results.
+    btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) override
+    {
+        if (!CanRunParallel(iBegin, iEnd, grainSize))
+            return body.sumLoop(iBegin, iEnd);
+
+        // Accumulate per thread, then combine
+        PODVector<btScalar> sums(workQueue_->GetNumThreads() + 1);
+        for (unsigned i = 0; i < sums.Size(); ++i)
+            sums[i] = 0;
+        workQueue_->ParallelFor((unsigned)iBegin, (unsigned)iEnd, (unsigned)grainSize, [&body, &sums](unsigned begin, unsigned end,
+            unsigned threadIndex)
+        {
+            sums[threadIndex] += body.sumLoop((int)begin, (int)end);
+        });
+
+        btScalar sum = 0;
+        for (unsigned i = 0; i < sums.Size(); ++i)
+            sum += sums[i];
+        return sum;
+    }
+
+private:
+    /// Return whether a loop should be split to the work queue threads.
+    bool CanRunParallel(int iBegin, int iEnd, int grainSize) const
+    {
+        // Work queue parallel loops can only be started from the main thread. Loops nested inside worker tasks run inline
+        return workQueue_ && workQueue_->GetNumThreads() && grainSize > 0 && iEnd - iBegin > grainSize && Thread::IsMainThread();
+    }
+
+    /// Work queue.
+    WeakPtr<WorkQueue> workQueue_;
+};
+
+/// Make the work queue task scheduler current. Bullet requires this to happen on the main thread before any multithreaded world objects are created. Return true if successful.
+static bool SetWorkQueueTaskScheduler(WorkQueue* workQueue)
+{
+    static WorkQueueTaskScheduler scheduler;
+
+    scheduler.SetWorkQueue(workQueue);
+    if (btGetTaskScheduler() != &scheduler)
+        btSetTaskScheduler(&scheduler);
+
+    // Bullet ignores the scheduler if the calling thread is not its main thread
+    return btGetTaskScheduler() == &scheduler;
+}
+#endif
+
+/// Return whether collisions between two bodies should be reported, according to their collision event modes.
+static bool IsCollisionReported(RigidBody* bodyA, RigidBody* bodyB)
+{
+    // Skip collision event signaling if both objects are static, or if collision event mode does not match
+    if (bodyA->GetMass() == 0.0f && bodyB->GetMass() == 0.0f)
+        return false;
+    if (bodyA->GetCollisionEventMode() == COLLISION_NEVER || bodyB->GetCollisionEventMode() == COLLISION_NEVER)
+        return false;
+    if (bodyA->GetCollisionEventMode() == COLLISION_ACTIVE && bodyB->GetCollisionEventMode() == COLLISION_ACTIVE &&
+        !bodyA->IsActive() && !bodyB->IsActive())
+        return false;
+    return true;
+}
+
+/// Return whether an event sent by the object would be received by anyone.
+static bool HasEventReceivers(Context* context, Object* sender, StringHash eventType)
+{
+    return context->GetEventReceivers(sender, eventType) || context->GetEventReceivers(eventType);
+}
+
+/// Serialize the contact points of a body pair for the collision events, with normals pointing towards body A, or towards body B if flipped.
+static void WriteContacts(VectorBuffer& dest, const ManifoldPair& manifolds, bool flip)
+{
+    dest.Clear();
+
+    // "Pointers not flipped"-manifold, send unmodified normals
+    btPersistentManifold* contactManifold = manifolds.manifold_;
+    if (contactManifold)
+    {
+        for (int j = 0; j < contactManifold->getNumContacts(); ++j)
+        {
+            btManifoldPoint& point = contactManifold->getContactPoint(j);
+            dest.WriteVector3(ToVector3(point.m_positionWorldOnB));
+            dest.WriteVector3(flip ? -ToVector3(point.m_normalWorldOnB) : ToVector3(point.m_normalWorldOnB));
+            dest.WriteFloat(point.m_distance1);
+            dest.WriteFloat(point.m_appliedImpulse);
+        }
+    }
+    // "Pointers flipped"-manifold, flip normals also
+    contactManifold = manifolds.flippedManifold_;
+    if (contactManifold)
+    {
+        for (int j = 0; j < contactManifold->getNumContacts(); ++j)
+        {
+            btManifoldPoint& point = contactManifold->getContactPoint(j);
+            dest.WriteVector3(ToVector3(point.m_positionWorldOnB));
+            dest.WriteVector3(flip ? ToVector3(point.m_normalWorldOnB) : -ToVector3(point.m_normalWorldOnB));
+            dest.WriteFloat(point.m_distance1);
+            dest.WriteFloat(point.m_appliedImpulse);
+        }
+    }
+}
+
+/// Append the contact points of a manifold to the contact stream.
+static void AddContactPoints(PODVector<PhysicsContactPoint>& dest, btPersistentManifold* contactManifold, bool flip)
+{
+    if (!contactManifold)
+        return;
+
+    for (int j = 0; j < contactManifold->getNumContacts(); ++j)
+    {
+        btManifoldPoint& point = contactManifold->getContactPoint(j);
+        PhysicsContactPoint contactPoint;
+        contactPoint.position_ = ToVector3(point.m_positionWorldOnB);
+        contactPoint.normal_ = flip ? -ToVector3(point.m_normalWorldOnB) : ToVector3(point.m_normalWorldOnB);
+        contactPoint.distance_ = point.m_distance1;
+        contactPoint.impulse_ = point.m_appliedImpulse;
+        dest.Push(contactPoint);
+    }
+}
+
 void RemoveCachedGeometryImpl(CollisionGeometryDataCache& cache, Model* model)
 {
     for (auto i = cache.Begin(); i != cache.End();)
@@ -183,15 +343,7 @@ PhysicsWorld::~PhysicsWorld()
             (*i)->ReleaseBody();
     }
 
-    world_.Reset();
-    solver_.Reset();
-    broadphase_.Reset();
-    collisionDispatcher_.Reset();
-
-    // Delete configuration only if it was the default created by PhysicsWorld
-    if (!PhysicsWorld::config.collisionConfig_)
-        delete collisionConfiguration_;
-    collisionConfiguration_ = nullptr;
+    DestroyDynamicWorld();
 }
 
 void PhysicsWorld::RegisterObject(Context* context)
@@ -207,6 +359,7 @@ void PhysicsWorld::RegisterObject(Context* context)
     URHO3D_ATTRIBUTE("Internal Edge Utility", bool, internalEdge_, true, AM_DEFAULT);
     URHO3D_ACCESSOR_ATTRIBUTE("Split Impulse", GetSplitImpulse, SetSplitImpulse, bool, false, AM_DEFAULT);
     URHO3D_ATTRIBUTE("SoftBody World", bool, useSoftBodyWorld_, false, AM_DEFAULT);
+    URHO3D_ACCESSOR_ATTRIBUTE("Multi-Threaded", GetMultiThreaded, SetMultiThreaded, bool, false, AM_DEFAULT);
 }
 
 void PhysicsWorld::OnSetAttribute(const AttributeInfo& attr, const Variant& src)
@@ -221,14 +374,26 @@ void PhysicsWorld::OnSetAttribute(const AttributeInfo& attr, const Variant& src)
 
 void PhysicsWorld::CreateDynaymicWorld()
 {
-    // Delete configuration only if it was the default created by PhysicsWorld
-    if (collisionConfiguration_)
-        delete collisionConfiguration_;
-    collisionConfiguration_ = 0;
+#ifdef URHO3D_THREADING
+    // Bullet numbers the threads in the order they first call into it and treats number 0 as the main thread. Claim it
+    // before a worker thread, for example running a batched query, does
+    btGetCurrentThreadIndex();
+#endif
+
+    // Keep the settings of a previous world, if any
+    btVector3 gravity = ToBtVector3(DEFAULT_GRAVITY);
+    btContactSolverInfo solverInfo;
+    solverInfo.m_splitImpulse = false; // Disable by default for performance
+    if (world_)
+    {
+        gravity = world_->getGravity();
+        solverInfo = world_->getSolverInfo();
+    }
+
+    DestroyDynamicWorld();
 
     // create common classes
     broadphase_ = new btDbvtBroadphase();
-    solver_ = new btSequentialImpulseConstraintSolver();
 
     if (!useSoftBodyWorld_)
     {
@@ -237,19 +402,44 @@ void PhysicsWorld::CreateDynaymicWorld()
         else
             collisionConfiguration_ = new btDefaultCollisionConfiguration();
 
-        collisionDispatcher_ = new btCollisionDispatcher(collisionConfiguration_);
-        world_ = new btDiscreteDynamicsWorld(collisionDispatcher_.Get(), broadphase_.Get(), solver_.Get(), collisionConfiguration_);
+#ifdef URHO3D_THREADING
+        auto* workQueue = GetSubsystem<WorkQueue>();
+        bool schedulerSet = multiThreaded_ && SetWorkQueueTaskScheduler(workQueue);
+        if (multiThreaded_ && !schedulerSet)
+            URHO3D_LOGERROR("Could not set the physics task scheduler, using a single-threaded physics world");
+
+        if (schedulerSet)
+        {
+            // One solver per thread for solving separate islands in parallel
+            auto* solverPool = new btConstraintSolverPoolMt(workQueue ? workQueue->GetNumThreads() + 1 : 1);
+            solver_ = solverPool;
+            collisionDispatcher_ = new btCollisionDispatcherMt(collisionConfiguration_);
+            world_ = new btDiscreteDynamicsWorldMt(collisionDispatcher_.Get(), broadphase_.Get(), solverPool, nullptr,
+                collisionConfiguration_);
+            multiThreadedWorld_ = true;
+        }
+        else
+#endif
+        {
+            solver_ = new btSequentialImpulseConstraintSolver();
+            collisionDispatcher_ = new btCollisionDispatcher(collisionConfiguration_);
+            world_ = new btDiscreteDynamicsWorld(collisionDispatcher_.Get(), broadphase_.Get(), solver_.Get(), collisionConfiguration_);
+        }
     }
     else
     {
+        if (multiThreaded_)
+            URHO3D_LOGWARNING("Multithreaded physics world is not supported with the soft body world");
+
+        solver_ = new btSequentialImpulseConstraintSolver();
         collisionConfiguration_ = new btSoftBodyRigidBodyCollisionConfiguration();
         collisionDispatcher_ = new btCollisionDispatcher(collisionConfiguration_);
         world_ = new btSoftRigidDynamicsWorld(collisionDispatcher_.Get(), broadphase_.Get(), solver_.Get(), collisionConfiguration_);
     }
 
-    world_->setGravity(ToBtVector3(DEFAULT_GRAVITY));
+    world_->setGravity(gravity);
     world_->getDispatchInfo().m_useContinuous = true;
-    world_->getSolverInfo().m_splitImpulse = false; // Disable by default for performance
+    world_->getSolverInfo() = solverInfo;
     world_->setDebugDrawer(this);
     world_->setInternalTickCallback(InternalPreTickCallback, static_cast<void*>(this), true);
     world_->setInternalTickCallback(InternalTickCallback, static_cast<void*>(this), false);
@@ -271,6 +461,22 @@ void PhysicsWorld::CreateDynaymicWorld()
     getDefaultColors().m_activeObject = btVector3(0.0f, 0.0f, 0.0f);
     getDefaultColors().m_deactivatedObject = btVector3(0.0f, 0.0f, 1.0f);
 }
+
+void PhysicsWorld::DestroyDynamicWorld()
+{
+    world_.Reset();
+    solver_.Reset();
+    broadphase_.Reset();
+    collisionDispatcher_.Reset();
+    softBodyWorldInfo_ = nullptr;
+    multiThreadedWorld_ = false;
+
+    // Delete configuration only if it was created by PhysicsWorld
+    if (collisionConfiguration_ != PhysicsWorld::config.collisionConfig_)
+        delete collisionConfiguration_;
+    collisionConfiguration_ = nullptr;
+}
+
 bool PhysicsWorld::isVisible(const btVector3& aabbMin, const btVector3& aabbMax)
 {
     if (debugRenderer_)
@@ -329,6 +535,12 @@ void PhysicsWorld::Update(float timeStep)
     delayedWorldTransforms_.Clear();
     simulating_ = true;
 
+#ifdef URHO3D_THREADING
+    // Another context or scene may have switched the task scheduler to its own work queue
+    if (multiThreadedWorld_)
+        SetWorkQueueTaskScheduler(GetSubsystem<WorkQueue>());
+#endif
+
     if (interpolation_)
         world_->stepSimulation(timeStep, maxSubSteps, internalTimeStep);
     else
@@ -371,6 +583,11 @@ void PhysicsWorld::Update(float timeStep)
 
 void PhysicsWorld::UpdateCollisions()
 {
+#ifdef URHO3D_THREADING
+    if (multiThreadedWorld_)
+        SetWorkQueueTaskScheduler(GetSubsystem<WorkQueue>());
+#endif
+
     world_->performDiscreteCollisionDetection();
 }
 
@@ -433,6 +650,36 @@ void PhysicsWorld::SetMaxNetworkAngularVelocity(float velocity)
     MarkNetworkUpdate();
 }
 
+void PhysicsWorld::SetContactStreamEnabled(bool enable)
+{
+    contactStreamEnabled_ = enable;
+    if (!enable)
+    {
+        contactStream_.Clear();
+        contactStreamPoints_.Clear();
+        contactStreamBodies_.Clear();
+        contactStreamLinks_.Clear();
+    }
+}
+
+void PhysicsWorld::SetMultiThreaded(bool enable)
+{
+    if (enable == multiThreaded_)
+        return;
+
+    // The Bullet objects of bodies and constraints refer to the world they were added to, so it can only be recreated while empty
+    if (!rigidBodies_.Empty() || !constraints_.Empty() || !softBodies_.Empty())
+    {
+        URHO3D_LOGERROR("Can not change physics world threading mode while it contains bodies or constraints");
+        return;
+    }
+
+    multiThreaded_ = enable;
+    CreateDynaymicWorld();
+
+    MarkNetworkUpdate();
+}
+
 void PhysicsWorld::Raycast(PODVector<PhysicsRaycastResult>& result, const Ray& ray, float maxDistance, unsigned collisionMask)
 {
     URHO3D_PROFILE(PhysicsRaycast);
@@ -461,19 +708,44 @@ void PhysicsWorld::Raycast(PODVector<PhysicsRaycastResult>& result, const Ray& r
     Sort(result.Begin(), result.End(), CompareRaycastResults);
 }
 
-void PhysicsWorld::RaycastSingle(PhysicsRaycastResult& result, const Ray& ray, float maxDistance, unsigned collisionMask)
+/// Closest hit convex sweep callback which ignores one collision object.
+struct ExcludeObjectConvexResultCallback : public btCollisionWorld::ClosestConvexResultCallback
 {
-    URHO3D_PROFILE(PhysicsRaycastSingle);
+    /// Construct.
+    ExcludeObjectConvexResultCallback(const btVector3& from, const btVector3& to, const btCollisionObject* exclude) :
+        btCollisionWorld::ClosestConvexResultCallback(from, to),
+        exclude_(exclude)
+    {
+    }
 
-    if (maxDistance >= M_INFINITY)
-        URHO3D_LOGWARNING("Infinite maxDistance in physics raycast is not supported");
+    /// Return whether to test against the proxy.
+    bool needsCollision(btBroadphaseProxy* proxy0) const override
+    {
+        return proxy0->m_clientObject != exclude_ && btCollisionWorld::ClosestConvexResultCallback::needsCollision(proxy0);
+    }
+
+    /// Collision object to ignore.
+    const btCollisionObject* exclude_;
+};
 
+static void SetNoHit(PhysicsRaycastResult& result)
+{
+    result.position_ = Vector3::ZERO;
+    result.normal_ = Vector3::ZERO;
+    result.distance_ = M_INFINITY;
+    result.hitFraction_ = 0.0f;
+    result.body_ = nullptr;
+}
+
+static void RaycastSingleQuery(const btCollisionWorld* world, PhysicsRaycastResult& result, const Ray& ray, float maxDistance,
+    unsigned collisionMask)
+{
     btCollisionWorld::ClosestRayResultCallback
         rayCallback(ToBtVector3(ray.origin_), ToBtVector3(ray.origin_ + maxDistance * ray.direction_));
     rayCallback.m_collisionFilterGroup = (short)0xffff;
     rayCallback.m_collisionFilterMask = (short)collisionMask;
 
-    world_->rayTest(rayCallback.m_rayFromWorld, rayCallback.m_rayToWorld, rayCallback);
+    world->rayTest(rayCallback.m_rayFromWorld, rayCallback.m_rayToWorld, rayCallback);
 
     if (rayCallback.hasHit())
     {
@@ -484,13 +756,86 @@ void PhysicsWorld::RaycastSingle(PhysicsRaycastResult& result, const Ray& ray, f
         result.body_ = static_cast<RigidBody*>(rayCallback.m_collisionObject->getUserPointer());
     }
     else
+        SetNoHit(result);
+}
+
+static void ConvexCastQuery(const btCollisionWorld* world, PhysicsRaycastResult& result, const btConvexShape* shape,
+    const Vector3& startPos, const Quaternion& startRot, const Vector3& endPos, const Quaternion& endRot, unsigned collisionMask,
+    const btCollisionObject* exclude = nullptr)
+{
+    ExcludeObjectConvexResultCallback convexCallback(ToBtVector3(startPos), ToBtVector3(endPos), exclude);
+    convexCallback.m_collisionFilterGroup = (short)0xffff;
+    convexCallback.m_collisionFilterMask = (short)collisionMask;
+
+    world->convexSweepTest(shape, btTransform(ToBtQuaternion(startRot), convexCallback.m_convexFromWorld),
+        btTransform(ToBtQuaternion(endRot), convexCallback.m_convexToWorld), convexCallback);
+
+    if (convexCallback.hasHit())
     {
-        result.position_ = Vector3::ZERO;
-        result.normal_ = Vector3::ZERO;
-        result.distance_ = M_INFINITY;
-        result.hitFraction_ = 0.0f;
-        result.body_ = nullptr;
+        result.body_ = static_cast<RigidBody*>(convexCallback.m_hitCollisionObject->getUserPointer());
+        result.position_ = ToVector3(convexCallback.m_hitPointWorld);
+        result.normal_ = ToVector3(convexCallback.m_hitNormalWorld);
+        result.distance_ = convexCallback.m_closestHitFraction * (endPos - startPos).Length();
+        result.hitFraction_ = convexCallback.m_closestHitFraction;
+    }
+    else
+        SetNoHit(result);
+}
+
+/// Execute a batch of scene queries in the worker threads and the main thread. Bullet world queries are read-only, but broadphase ray tests are only thread-safe in a BT_THREADSAFE build, which URHO3D_THREADING enables.
+template <class T> static void RunQueryBatch(WorkQueue* queue, unsigned numQueries, const T& query)
+{
+#ifdef URHO3D_THREADING
+    if (queue && queue->GetNumThreads() && numQueries > QUERY_BATCH_GRAIN_SIZE && Thread::IsMainThread())
+    {
+        queue->ParallelFor(0, numQueries, QUERY_BATCH_GRAIN_SIZE, [&query](unsigned begin, unsigned end, unsigned)
+        {
+            for (unsigned i = begin; i < end; ++i)
+                query(i);
+        });
+        return;
     }
+#endif
+
+    for (unsigned i = 0; i < numQueries; ++i)
+        query(i);
+}
+
+static void WarnInfiniteDistance(const PODVector<PhysicsRaycastQuery>& queries, const char* queryName)
+{
+    for (unsigned i = 0; i < queries.Size(); ++i)
+    {
+        if (queries[i].maxDistance_ >= M_INFINITY)
+        {
+            URHO3D_LOGWARNING("Infinite maxDistance in physics " + String(queryName) + " is not supported");
+            return;
+        }
+    }
+}
+
+void PhysicsWorld::RaycastSingle(PhysicsRaycastResult& result, const Ray& ray, float maxDistance, unsigned collisionMask)
+{
+    URHO3D_PROFILE(PhysicsRaycastSingle);
+
+    if (maxDistance >= M_INFINITY)
+        URHO3D_LOGWARNING("Infinite maxDistance in physics raycast is not supported");
+
+    RaycastSingleQuery(world_.Get(), result, ray, maxDistance, collisionMask);
+}
+
+void PhysicsWorld::RaycastSingleBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<PhysicsRaycastQuery>& queries)
+{
+    URHO3D_PROFILE(PhysicsRaycastSingleBatch);
+
+    WarnInfiniteDistance(queries, "raycast");
+    results.Resize(queries.Size());
+
+    const btCollisionWorld* world = world_.Get();
+    RunQueryBatch(GetSubsystem<WorkQueue>(), queries.Size(), [world, &results, &queries](unsigned i)
+    {
+        const PhysicsRaycastQuery& query = queries[i];
+        RaycastSingleQuery(world, results[i], query.ray_, query.maxDistance_, query.collisionMask_);
+    });
 }
 
 struct VertexAccessor
@@ -730,32 +1075,25 @@ void PhysicsWorld::SphereCast(PhysicsRaycastResult& result, const Ray& ray, floa
         URHO3D_LOGWARNING("Infinite maxDistance in physics sphere cast is not supported");
 
     btSphereShape shape(radius);
-    Vector3 endPos = ray.origin_ + maxDistance * ray.direction_;
+    ConvexCastQuery(world_.Get(), result, &shape, ray.origin_, Quaternion::IDENTITY, ray.origin_ + maxDistance * ray.direction_,
+        Quaternion::IDENTITY, collisionMask);
+}
 
-    btCollisionWorld::ClosestConvexResultCallback
-        convexCallback(ToBtVector3(ray.origin_), ToBtVector3(endPos));
-    convexCallback.m_collisionFilterGroup = (short)0xffff;
-    convexCallback.m_collisionFilterMask = (short)collisionMask;
+void PhysicsWorld::SphereCastBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<PhysicsRaycastQuery>& queries)
+{
+    URHO3D_PROFILE(PhysicsSphereCastBatch);
 
-    world_->convexSweepTest(&shape, btTransform(btQuaternion::getIdentity(), convexCallback.m_convexFromWorld),
-        btTransform(btQuaternion::getIdentity(), convexCallback.m_convexToWorld), convexCallback);
+    WarnInfiniteDistance(queries, "sphere cast");
+    results.Resize(queries.Size());
 
-    if (convexCallback.hasHit())
-    {
-        result.body_ = static_cast<RigidBody*>(convexCallback.m_hitCollisionObject->getUserPointer());
-        result.position_ = ToVector3(convexCallback.m_hitPointWorld);
-        result.normal_ = ToVector3(convexCallback.m_hitNormalWorld);
-        result.distance_ = convexCallback.m_closestHitFraction * (endPos - ray.origin_).Length();
-        result.hitFraction_ = convexCallback.m_closestHitFraction;
-    }
-    else
+    const btCollisionWorld* world = world_.Get();
+    RunQueryBatch(GetSubsystem<WorkQueue>(), queries.Size(), [world, &results, &queries](unsigned i)
     {
-        result.body_ = nullptr;
-        result.position_ = Vector3::ZERO;
-        result.normal_ = Vector3::ZERO;
-        result.distance_ = M_INFINITY;
-        result.hitFraction_ = 0.0f;
-    }
+        const PhysicsRaycastQuery& query = queries[i];
+        btSphereShape shape(query.radius_);
+        ConvexCastQuery(world, results[i], &shape, query.ray_.origin_, Quaternion::IDENTITY,
+            query.ray_.origin_ + query.maxDistance_ * query.ray_.direction_, Quaternion::IDENTITY, query.collisionMask_);
+    });
 }
 
 void PhysicsWorld::ConvexCast(PhysicsRaycastResult& result, CollisionShape* shape, const Vector3& startPos,
@@ -826,30 +1164,71 @@ void PhysicsWorld::ConvexCast(PhysicsRaycastResult& result, btCollisionShape* sh
 
     URHO3D_PROFILE(PhysicsConvexCast);
 
-    btCollisionWorld::ClosestConvexResultCallback convexCallback(ToBtVector3(startPos), ToBtVector3(endPos));
-    convexCallback.m_collisionFilterGroup = (short)0xffff;
-    convexCallback.m_collisionFilterMask = (short)collisionMask;
+    ConvexCastQuery(world_.Get(), result, static_cast<btConvexShape*>(shape), startPos, startRot, endPos, endRot, collisionMask);
+}
 
-    world_->convexSweepTest(static_cast<btConvexShape*>(shape), btTransform(ToBtQuaternion(startRot),
-            convexCallback.m_convexFromWorld), btTransform(ToBtQuaternion(endRot), convexCallback.m_convexToWorld),
-        convexCallback);
+void PhysicsWorld::ConvexCastBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<PhysicsConvexCastQuery>& queries)
+{
+    URHO3D_PROFILE(PhysicsConvexCastBatch);
 
-    if (convexCallback.hasHit())
+    results.Resize(queries.Size());
+
+    /// Convex cast prepared on the main thread.
+    struct PreparedConvexCast
     {
-        result.body_ = static_cast<RigidBody*>(convexCallback.m_hitCollisionObject->getUserPointer());
-        result.position_ = ToVector3(convexCallback.m_hitPointWorld);
-        result.normal_ = ToVector3(convexCallback.m_hitNormalWorld);
-        result.distance_ = convexCallback.m_closestHitFraction * (endPos - startPos).Length();
-        result.hitFraction_ = convexCallback.m_closestHitFraction;
-    }
-    else
+        /// Bullet shape, or null if the query is invalid.
+        const btConvexShape* shape_;
+        /// Rigid body of the shape, which is not returned as a hit.
+        const btCollisionObject* exclude_;
+        /// Effective start position.
+        Vector3 startPos_;
+        /// Effective start rotation.
+        Quaternion startRot_;
+        /// Effective end position.
+        Vector3 endPos_;
+        /// Effective end rotation.
+        Quaternion endRot_;
+    };
+
+    // Take the shape offsets into account here, as reading the scene nodes is not thread-safe. Instead of changing the collision
+    // group of the shape's own body like ConvexCast() does, each sweep ignores its own body in the result callback
+    PODVector<PreparedConvexCast> prepared(queries.Size());
+    for (unsigned i = 0; i < queries.Size(); ++i)
     {
-        result.body_ = nullptr;
-        result.position_ = Vector3::ZERO;
-        result.normal_ = Vector3::ZERO;
-        result.distance_ = M_INFINITY;
-        result.hitFraction_ = 0.0f;
+        const PhysicsConvexCastQuery& query = queries[i];
+        PreparedConvexCast& dest = prepared[i];
+        btCollisionShape* shape = query.shape_ ? query.shape_->GetCollisionShape() : nullptr;
+        if (!shape || !shape->isConvex())
+        {
+            URHO3D_LOGERROR("Null or non-convex collision shape for convex cast");
+            dest.shape_ = nullptr;
+            continue;
+        }
+
+        auto* bodyComp = query.shape_->GetComponent<RigidBody>();
+        Node* shapeNode = query.shape_->GetNode();
+        Matrix3x4 startTransform(query.startPos_, query.startRot_, shapeNode ? shapeNode->GetWorldScale() : Vector3::ONE);
+        Matrix3x4 endTransform(query.endPos_, query.endRot_, shapeNode ? shapeNode->GetWorldScale() : Vector3::ONE);
+        dest.shape_ = static_cast<btConvexShape*>(shape);
+        dest.exclude_ = bodyComp ? bodyComp->GetBody() : nullptr;
+        dest.startPos_ = startTransform * query.shape_->GetPosition();
+        dest.endPos_ = endTransform * query.shape_->GetPosition();
+        dest.startRot_ = query.startRot_ * query.shape_->GetRotation();
+        dest.endRot_ = query.endRot_ * query.shape_->GetRotation();
     }
+
+    const btCollisionWorld* world = world_.Get();
+    RunQueryBatch(GetSubsystem<WorkQueue>(), queries.Size(), [world, &results, &queries, &prepared](unsigned i)
+    {
+        const PreparedConvexCast& cast = prepared[i];
+        if (cast.shape_)
+        {
+            ConvexCastQuery(world, results[i], cast.shape_, cast.startPos_, cast.startRot_, cast.endPos_, cast.endRot_,
+                queries[i].collisionMask_, cast.exclude_);
+        }
+        else
+            SetNoHit(results[i]);
+    });
 }
 
 void PhysicsWorld::RemoveCachedGeometry(Model* model)
@@ -925,8 +1304,12 @@ void PhysicsWorld::GetCollidingBodies(PODVector<RigidBody*>& result, const Rigid
 
     result.Clear();
 
-    for (HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, ManifoldPair>::Iterator i = currentCollisions_.Begin();
-         i != currentCollisions_.End(); ++i)
+    // The pairs of the last step are swapped to the previous collisions only after all collision events have been sent
+    HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, ManifoldPair>& collisions =
+        sendingCollisionEvents_ ? currentCollisions_ : previousCollisions_;
+
+    for (HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, ManifoldPair>::Iterator i = collisions.Begin();
+         i != collisions.End(); ++i)
     {
         if (i->first_.first_ == body)
         {
@@ -941,6 +1324,21 @@ void PhysicsWorld::GetCollidingBodies(PODVector<RigidBody*>& result, const Rigid
     }
 }
 
+void PhysicsWorld::GetBodyContacts(PODVector<const PhysicsContact*>& result, const RigidBody* body) const
+{
+    result.Clear();
+
+    if (!body)
+        return;
+
+    HashMap<RigidBody*, unsigned>::ConstIterator i = contactStreamBodies_.Find(const_cast<RigidBody*>(body));
+    if (i == contactStreamBodies_.End())
+        return;
+
+    for (unsigned link = i->second_; link != M_MAX_UNSIGNED; link = contactStreamLinks_[link])
+        result.Push(&contactStream_[link / 2]);
+}
+
 Vector3 PhysicsWorld::GetGravity() const
 {
     return ToVector3(world_->getGravity());
@@ -966,6 +1364,20 @@ void PhysicsWorld::RemoveRigidBody(RigidBody* body)
     rigidBodies_.Remove(body);
     // Remove possible dangling pointer from the delayedWorldTransforms structure
     delayedWorldTransforms_.Erase(body);
+    // Likewise from the contact stream
+    HashMap<RigidBody*, unsigned>::Iterator i = contactStreamBodies_.Find(body);
+    if (i != contactStreamBodies_.End())
+    {
+        for (unsigned link = i->second_; link != M_MAX_UNSIGNED; link = contactStreamLinks_[link])
+        {
+            PhysicsContact& contact = contactStream_[link / 2];
+            if (link & 1u)
+                contact.bodyB_ = nullptr;
+            else
+                contact.bodyA_ = nullptr;
+        }
+        contactStreamBodies_.Erase(i);
+    }
 }
 
 void PhysicsWorld::AddSoftBody(SoftBody* body)
@@ -1092,55 +1504,59 @@ void PhysicsWorld::SendCollisionEvents()
     currentCollisions_.Clear();
     physicsCollisionData_.Clear();
     nodeCollisionData_.Clear();
+    contactStream_.Clear();
+    contactStreamPoints_.Clear();
+    contactStreamBodies_.Clear();
+    contactStreamLinks_.Clear();
 
     int numManifolds = collisionDispatcher_->getNumManifolds();
 
-    if (numManifolds)
+    for (int i = 0; i < numManifolds; ++i)
     {
-        physicsCollisionData_[PhysicsCollision::P_WORLD] = this;
-
-        for (int i = 0; i < numManifolds; ++i)
+        btPersistentManifold* contactManifold = collisionDispatcher_->getManifoldByIndexInternal(i);
+        // First check that there are actual contacts, as the manifold exists also when objects are close but not touching
+        if (!contactManifold->getNumContacts())
+            continue;
+
+        const btCollisionObject* objectA = contactManifold->getBody0();
+        const btCollisionObject* objectB = contactManifold->getBody1();
+
+        auto* bodyA = static_cast<RigidBody*>(objectA->getUserPointer());
+        auto* bodyB = static_cast<RigidBody*>(objectB->getUserPointer());
+        // If it's not a rigidbody, maybe a ghost object
+        if (!bodyA || !bodyB)
+            continue;
+
+        if (!IsCollisionReported(bodyA, bodyB))
+            continue;
+
+        WeakPtr<RigidBody> bodyWeakA(bodyA);
+        WeakPtr<RigidBody> bodyWeakB(bodyB);
+
+        // First only store the collision pair as weak pointers and the manifold pointer, so user code can safely destroy
+        // objects during collision event handling
+        Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> > bodyPair;
+        if (bodyA < bodyB)
         {
-            btPersistentManifold* contactManifold = collisionDispatcher_->getManifoldByIndexInternal(i);
-            // First check that there are actual contacts, as the manifold exists also when objects are close but not touching
-            if (!contactManifold->getNumContacts())
-                continue;
+            bodyPair = MakePair(bodyWeakA, bodyWeakB);
+            currentCollisions_[bodyPair].manifold_ = contactManifold;
+        }
+        else
+        {
+            bodyPair = MakePair(bodyWeakB, bodyWeakA);
+            currentCollisions_[bodyPair].flippedManifold_ = contactManifold;
+        }
+    }
 
-            const btCollisionObject* objectA = contactManifold->getBody0();
-            const btCollisionObject* objectB = contactManifold->getBody1();
+    // Fill the contact stream before any event handler has a chance to remove bodies and destroy their manifolds
+    if (contactStreamEnabled_)
+        UpdateContactStream();
 
-            auto* bodyA = static_cast<RigidBody*>(objectA->getUserPointer());
-            auto* bodyB = static_cast<RigidBody*>(objectB->getUserPointer());
-            // If it's not a rigidbody, maybe a ghost object
-            if (!bodyA || !bodyB)
-                continue;
-
-            // Skip collision event signaling if both objects are static, or if collision event mode does not match
-            if (bodyA->GetMass() == 0.0f && bodyB->GetMass() == 0.0f)
-                continue;
-            if (bodyA->GetCollisionEventMode() == COLLISION_NEVER || bodyB->GetCollisionEventMode() == COLLISION_NEVER)
-                continue;
-            if (bodyA->GetCollisionEventMode() == COLLISION_ACTIVE && bodyB->GetCollisionEventMode() == COLLISION_ACTIVE &&
-                !bodyA->IsActive() && !bodyB->IsActive())
-                continue;
+    sendingCollisionEvents_ = true;
 
-            WeakPtr<RigidBody> bodyWeakA(bodyA);
-            WeakPtr<RigidBody> bodyWeakB(bodyB);
-
-            // First only store the collision pair as weak pointers and the manifold pointer, so user code can safely destroy
-            // objects during collision event handling
-            Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> > bodyPair;
-            if (bodyA < bodyB)
-            {
-                bodyPair = MakePair(bodyWeakA, bodyWeakB);
-                currentCollisions_[bodyPair].manifold_ = contactManifold;
-            }
-            else
-            {
-                bodyPair = MakePair(bodyWeakB, bodyWeakA);
-                currentCollisions_[bodyPair].flippedManifold_ = contactManifold;
-            }
-        }
+    if (!currentCollisions_.Empty())
+    {
+        physicsCollisionData_[PhysicsCollision::P_WORLD] = this;
 
         for (HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, ManifoldPair>::Iterator i = currentCollisions_.Begin();
              i != currentCollisions_.End(); ++i)
@@ -1157,115 +1573,85 @@ void PhysicsWorld::SendCollisionEvents()
 
             bool trigger = bodyA->IsTrigger() || bodyB->IsTrigger();
             bool newCollision = !previousCollisions_.Contains(i->first_);
+            // Contact data is serialized only for the events that have receivers, and reused while the perspective stays the same
+            bool contactsWritten = false;
 
-            physicsCollisionData_[PhysicsCollision::P_NODEA] = nodeA;
-            physicsCollisionData_[PhysicsCollision::P_NODEB] = nodeB;
-            physicsCollisionData_[PhysicsCollision::P_BODYA] = bodyA;
-            physicsCollisionData_[PhysicsCollision::P_BODYB] = bodyB;
-            physicsCollisionData_[PhysicsCollision::P_TRIGGER] = trigger;
-
-            contacts_.Clear();
-
-            // "Pointers not flipped"-manifold, send unmodified normals
-            btPersistentManifold* contactManifold = i->second_.manifold_;
-            if (contactManifold)
+            if ((newCollision && HasEventReceivers(context_, this, E_PHYSICSCOLLISIONSTART)) ||
+                HasEventReceivers(context_, this, E_PHYSICSCOLLISION))
             {
-                for (int j = 0; j < contactManifold->getNumContacts(); ++j)
+                physicsCollisionData_[PhysicsCollision::P_NODEA] = nodeA;
+                physicsCollisionData_[PhysicsCollision::P_NODEB] = nodeB;
+                physicsCollisionData_[PhysicsCollision::P_BODYA] = bodyA;
+                physicsCollisionData_[PhysicsCollision::P_BODYB] = bodyB;
+                physicsCollisionData_[PhysicsCollision::P_TRIGGER] = trigger;
+
+                WriteContacts(contacts_, i->second_, false);
+                contactsWritten = true;
+                physicsCollisionData_[PhysicsCollision::P_CONTACTS] = contacts_.GetBuffer();
+
+                // Send separate collision start event if collision is new
+                if (newCollision)
                 {
-                    btManifoldPoint& point = contactManifold->getContactPoint(j);
-                    contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                    contacts_.WriteVector3(ToVector3(point.m_normalWorldOnB));
-                    contacts_.WriteFloat(point.m_distance1);
-                    contacts_.WriteFloat(point.m_appliedImpulse);
+                    SendEvent(E_PHYSICSCOLLISIONSTART, physicsCollisionData_);
+                    // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
+                    if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+                        continue;
                 }
+
+                // Then send the ongoing collision event
+                SendEvent(E_PHYSICSCOLLISION, physicsCollisionData_);
+                if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+                    continue;
             }
-            // "Pointers flipped"-manifold, flip normals also
-            contactManifold = i->second_.flippedManifold_;
-            if (contactManifold)
+
+            if ((newCollision && HasEventReceivers(context_, nodeA, E_NODECOLLISIONSTART)) ||
+                HasEventReceivers(context_, nodeA, E_NODECOLLISION))
             {
-                for (int j = 0; j < contactManifold->getNumContacts(); ++j)
+                if (!contactsWritten)
                 {
-                    btManifoldPoint& point = contactManifold->getContactPoint(j);
-                    contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                    contacts_.WriteVector3(-ToVector3(point.m_normalWorldOnB));
-                    contacts_.WriteFloat(point.m_distance1);
-                    contacts_.WriteFloat(point.m_appliedImpulse);
+                    WriteContacts(contacts_, i->second_, false);
+                    contactsWritten = true;
                 }
-            }
 
-            physicsCollisionData_[PhysicsCollision::P_CONTACTS] = contacts_.GetBuffer();
+                nodeCollisionData_[NodeCollision::P_BODY] = bodyA;
+                nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeB;
+                nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyB;
+                nodeCollisionData_[NodeCollision::P_TRIGGER] = trigger;
+                nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
 
-            // Send separate collision start event if collision is new
-            if (newCollision)
-            {
-                SendEvent(E_PHYSICSCOLLISIONSTART, physicsCollisionData_);
-                // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
+                if (newCollision)
+                {
+                    nodeA->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
+                    if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+                        continue;
+                }
+
+                nodeA->SendEvent(E_NODECOLLISION, nodeCollisionData_);
                 if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
                     continue;
             }
 
-            // Then send the ongoing collision event
-            SendEvent(E_PHYSICSCOLLISION, physicsCollisionData_);
-            if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
-                continue;
-
-            nodeCollisionData_[NodeCollision::P_BODY] = bodyA;
-            nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeB;
-            nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyB;
-            nodeCollisionData_[NodeCollision::P_TRIGGER] = trigger;
-            nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
-
-            if (newCollision)
+            if ((newCollision && HasEventReceivers(context_, nodeB, E_NODECOLLISIONSTART)) ||
+                HasEventReceivers(context_, nodeB, E_NODECOLLISION))
             {
-                nodeA->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
-                if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
-                    continue;
-            }
+                // Flip perspective to body B
+                WriteContacts(contacts_, i->second_, true);
 
-            nodeA->SendEvent(E_NODECOLLISION, nodeCollisionData_);
-            if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
-                continue;
+                nodeCollisionData_[NodeCollision::P_BODY] = bodyB;
+                nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeA;
+                nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyA;
+                nodeCollisionData_[NodeCollision::P_TRIGGER] = trigger;
+                nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
 
-            // Flip perspective to body B
-            contacts_.Clear();
-            contactManifold = i->second_.manifold_;
-            if (contactManifold)
-            {
-                for (int j = 0; j < contactManifold->getNumContacts(); ++j)
-                {
-                    btManifoldPoint& point = contactManifold->getContactPoint(j);
-                    contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                    contacts_.WriteVector3(-ToVector3(point.m_normalWorldOnB));
-                    contacts_.WriteFloat(point.m_distance1);
-                    contacts_.WriteFloat(point.m_appliedImpulse);
-                }
-            }
-            contactManifold = i->second_.flippedManifold_;
-            if (contactManifold)
-            {
-                for (int j = 0; j < contactManifold->getNumContacts(); ++j)
+                if (newCollision)
                 {
-                    btManifoldPoint& point = contactManifold->getContactPoint(j);
-                    contacts_.WriteVector3(ToVector3(point.m_positionWorldOnB));
-                    contacts_.WriteVector3(ToVector3(point.m_normalWorldOnB));
-                    contacts_.WriteFloat(point.m_distance1);
-                    contacts_.WriteFloat(point.m_appliedImpulse);
+                    nodeB->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
+                    if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+                        continue;
                 }
-            }
 
-            nodeCollisionData_[NodeCollision::P_BODY] = bodyB;
-            nodeCollisionData_[NodeCollision::P_OTHERNODE] = nodeA;
-            nodeCollisionData_[NodeCollision::P_OTHERBODY] = bodyA;
-            nodeCollisionData_[NodeCollision::P_CONTACTS] = contacts_.GetBuffer();
-
-            if (newCollision)
-            {
-                nodeB->SendEvent(E_NODECOLLISIONSTART, nodeCollisionData_);
-                if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
-                    continue;
+                nodeB->SendEvent(E_NODECOLLISION, nodeCollisionData_);
             }
-
-            nodeB->SendEvent(E_NODECOLLISION, nodeCollisionData_);
         }
     }
 
@@ -1285,13 +1671,7 @@ void PhysicsWorld::SendCollisionEvents()
 
                 bool trigger = bodyA->IsTrigger() || bodyB->IsTrigger();
 
-                // Skip collision event signaling if both objects are static, or if collision event mode does not match
-                if (bodyA->GetMass() == 0.0f && bodyB->GetMass() == 0.0f)
-                    continue;
-                if (bodyA->GetCollisionEventMode() == COLLISION_NEVER || bodyB->GetCollisionEventMode() == COLLISION_NEVER)
-                    continue;
-                if (bodyA->GetCollisionEventMode() == COLLISION_ACTIVE && bodyB->GetCollisionEventMode() == COLLISION_ACTIVE &&
-                    !bodyA->IsActive() && !bodyB->IsActive())
+                if (!IsCollisionReported(bodyA, bodyB))
                     continue;
 
                 Node* nodeA = bodyA->GetNode();
@@ -1299,36 +1679,115 @@ void PhysicsWorld::SendCollisionEvents()
                 WeakPtr<Node> nodeWeakA(nodeA);
                 WeakPtr<Node> nodeWeakB(nodeB);
 
-                physicsCollisionData_[PhysicsCollisionEnd::P_BODYA] = bodyA;
-                physicsCollisionData_[PhysicsCollisionEnd::P_BODYB] = bodyB;
-                physicsCollisionData_[PhysicsCollisionEnd::P_NODEA] = nodeA;
-                physicsCollisionData_[PhysicsCollisionEnd::P_NODEB] = nodeB;
-                physicsCollisionData_[PhysicsCollisionEnd::P_TRIGGER] = trigger;
-
-                SendEvent(E_PHYSICSCOLLISIONEND, physicsCollisionData_);
-                // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
-                if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
-                    continue;
-
-                nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyA;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeB;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyB;
-                nodeCollisionData_[NodeCollisionEnd::P_TRIGGER] = trigger;
+                // As with the other collision events, the event data is filled only for the events that have receivers
+                if (HasEventReceivers(context_, this, E_PHYSICSCOLLISIONEND))
+                {
+                    physicsCollisionData_[PhysicsCollisionEnd::P_BODYA] = bodyA;
+                    physicsCollisionData_[PhysicsCollisionEnd::P_BODYB] = bodyB;
+                    physicsCollisionData_[PhysicsCollisionEnd::P_NODEA] = nodeA;
+                    physicsCollisionData_[PhysicsCollisionEnd::P_NODEB] = nodeB;
+                    physicsCollisionData_[PhysicsCollisionEnd::P_TRIGGER] = trigger;
+
+                    SendEvent(E_PHYSICSCOLLISIONEND, physicsCollisionData_);
+                    // Skip rest of processing if either of the nodes or bodies is removed as a response to the event
+                    if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+                        continue;
+                }
 
-                nodeA->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
-                if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
-                    continue;
+                if (HasEventReceivers(context_, nodeA, E_NODECOLLISIONEND))
+                {
+                    nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyA;
+                    nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeB;
+                    nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyB;
+                    nodeCollisionData_[NodeCollisionEnd::P_TRIGGER] = trigger;
+
+                    nodeA->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
+                    if (!nodeWeakA || !nodeWeakB || !i->first_.first_ || !i->first_.second_)
+                        continue;
+                }
 
-                nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyB;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeA;
-                nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyA;
+                if (HasEventReceivers(context_, nodeB, E_NODECOLLISIONEND))
+                {
+                    nodeCollisionData_[NodeCollisionEnd::P_BODY] = bodyB;
+                    nodeCollisionData_[NodeCollisionEnd::P_OTHERNODE] = nodeA;
+                    nodeCollisionData_[NodeCollisionEnd::P_OTHERBODY] = bodyA;
+                    nodeCollisionData_[NodeCollisionEnd::P_TRIGGER] = trigger;
 
-                nodeB->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
+                    nodeB->SendEvent(E_NODECOLLISIONEND, nodeCollisionData_);
+                }
             }
         }
     }
 
-    previousCollisions_ = currentCollisions_;
+    sendingCollisionEvents_ = false;
+
+    // Swap instead of copying, the old pairs are cleared on the next step
+    previousCollisions_.Swap(currentCollisions_);
+}
+
+void PhysicsWorld::UpdateContactStream()
+{
+    URHO3D_PROFILE(UpdateContactStream);
+
+    for (HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, ManifoldPair>::ConstIterator i = currentCollisions_.Begin();
+         i != currentCollisions_.End(); ++i)
+    {
+        RigidBody* bodyA = i->first_.first_;
+        RigidBody* bodyB = i->first_.second_;
+        if (!bodyA || !bodyB)
+            continue;
+
+        PhysicsContact contact;
+        contact.bodyA_ = bodyA;
+        contact.bodyB_ = bodyB;
+        contact.state_ = previousCollisions_.Contains(i->first_) ? CONTACT_STAY : CONTACT_BEGIN;
+        contact.trigger_ = bodyA->IsTrigger() || bodyB->IsTrigger();
+        contact.firstPoint_ = contactStreamPoints_.Size();
+
+        // Normals of the flipped manifold are negated to keep them pointing towards body A
+        AddContactPoints(contactStreamPoints_, i->second_.manifold_, false);
+        AddContactPoints(contactStreamPoints_, i->second_.flippedManifold_, true);
+
+        contact.numPoints_ = contactStreamPoints_.Size() - contact.firstPoint_;
+        contactStream_.Push(contact);
+    }
+
+    for (HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, ManifoldPair>::ConstIterator i = previousCollisions_.Begin();
+         i != previousCollisions_.End(); ++i)
+    {
+        RigidBody* bodyA = i->first_.first_;
+        RigidBody* bodyB = i->first_.second_;
+        if (!bodyA || !bodyB || currentCollisions_.Contains(i->first_) || !IsCollisionReported(bodyA, bodyB))
+            continue;
+
+        PhysicsContact contact;
+        contact.bodyA_ = bodyA;
+        contact.bodyB_ = bodyB;
+        contact.state_ = CONTACT_END;
+        contact.trigger_ = bodyA->IsTrigger() || bodyB->IsTrigger();
+        contact.firstPoint_ = contactStreamPoints_.Size();
+        contact.numPoints_ = 0;
+        contactStream_.Push(contact);
+    }
+
+    // Index the records by body. Link them backwards, so that the records of each body are listed in the stream order
+    contactStreamLinks_.Resize(contactStream_.Size() * 2);
+    for (unsigned i = contactStreamLinks_.Size() - 1; i < contactStreamLinks_.Size(); --i)
+    {
+        const PhysicsContact& contact = contactStream_[i / 2];
+        RigidBody* body = (i & 1u) ? contact.bodyB_ : contact.bodyA_;
+        HashMap<RigidBody*, unsigned>::Iterator j = contactStreamBodies_.Find(body);
+        if (j != contactStreamBodies_.End())
+        {
+            contactStreamLinks_[i] = j->second_;
+            j->second_ = i;
+        }
+        else
+        {
+            contactStreamLinks_[i] = M_MAX_UNSIGNED;
+            contactStreamBodies_[body] = i;
+        }
+    }
 }
 
 void RegisterPhysicsLibrary(Context* context)
@@ -25,6 +25,8 @@
 #include "../Container/HashSet.h"
 #include "../IO/VectorBuffer.h"
 #include "../Math/BoundingBox.h"
+#include "../Math/Quaternion.h"
+#include "../Math/Ray.h"
 #include "../Math/Sphere.h"
 #include "../Math/Vector3.h"
 #include "../Scene/Component.h"
@@ -87,6 +89,36 @@ struct URHO3D_API PhysicsRaycastResult
     IntVector3 vc_{};
 };
 
+/// Ray or swept sphere query of a batch.
+struct URHO3D_API PhysicsRaycastQuery
+{
+    /// World-space ray.
+    Ray ray_;
+    /// Maximum distance along the ray.
+    float maxDistance_{};
+    /// Sphere radius of a swept sphere query. Not used by raycasts.
+    float radius_{};
+    /// Collision mask.
+    unsigned collisionMask_{M_MAX_UNSIGNED};
+};
+
+/// Swept convex shape query of a batch.
+struct URHO3D_API PhysicsConvexCastQuery
+{
+    /// Convex collision shape to sweep. The rigid body it is attached to is not returned as a hit.
+    CollisionShape* shape_{};
+    /// World-space start position.
+    Vector3 startPos_;
+    /// World-space start rotation.
+    Quaternion startRot_;
+    /// World-space end position.
+    Vector3 endPos_;
+    /// World-space end rotation.
+    Quaternion endRot_;
+    /// Collision mask.
+    unsigned collisionMask_{M_MAX_UNSIGNED};
+};
+
 /// Delayed world transform assignment for parented rigidbodies.
 struct DelayedWorldTransform
 {
@@ -116,16 +148,57 @@ struct ManifoldPair
     btPersistentManifold* flippedManifold_;
 };
 
+/// Body pair state in the physics contact stream.
+enum PhysicsContactState
+{
+    CONTACT_BEGIN = 0,
+    CONTACT_STAY,
+    CONTACT_END
+};
+
+/// Contact point in the physics contact stream.
+struct PhysicsContactPoint
+{
+    /// Worldspace position.
+    Vector3 position_;
+    /// Worldspace normal, pointing from body B towards body A.
+    Vector3 normal_;
+    /// Distance, negative when penetrating.
+    float distance_;
+    /// Impulse applied by the constraint solver.
+    float impulse_;
+};
+
+/// Body pair record in the physics contact stream.
+struct PhysicsContact
+{
+    /// First rigid body. Null if the body has been removed after the step.
+    RigidBody* bodyA_;
+    /// Second rigid body. Null if the body has been removed after the step.
+    RigidBody* bodyB_;
+    /// Contact state.
+    PhysicsContactState state_;
+    /// Trigger flag, either body is a trigger.
+    bool trigger_;
+    /// Index of the first contact point.
+    unsigned firstPoint_;
+    /// Number of contact points. Zero for ended contacts.
+    unsigned numPoints_;
+};
+
 /// Custom overrides of physics internals. To use overrides, must be set before the physics component is created.
 struct PhysicsWorldConfig
 {
     PhysicsWorldConfig() :
-        collisionConfig_(nullptr)
+        collisionConfig_(nullptr),
+        saveCookedGeometry_(false)
     {
     }
 
     /// Override for the collision configuration (default btDefaultCollisionConfiguration).
     btCollisionConfiguration* collisionConfig_;
+    /// Save triangle mesh and convex hull geometry cooked at runtime next to the model file, so that later loads can skip cooking. Default false.
+    bool saveCookedGeometry_;
 };
 
 static const int DEFAULT_FPS = 60;
@@ -203,6 +276,12 @@ public:
     void SetSplitImpulse(bool enable);
     /// Set maximum angular velocity for network replication.
     void SetMaxNetworkAngularVelocity(float velocity);
+    /// Set whether to fill the contact stream on each simulation step. It can be read in the physics post-step event instead of handling the collision events per body pair. Disabled by default.
+    /// @property
+    void SetContactStreamEnabled(bool enable);
+    /// Set whether to use the multithreaded Bullet world, which runs collision detection, constraint solving and integration on the work queue threads. Can only be changed while the world has no bodies or constraints. Not supported with the soft body world. Disabled by default.
+    /// @property
+    void SetMultiThreaded(bool enable);
     /// Perform a physics world raycast and return all hits.
     void Raycast
         (PODVector<PhysicsRaycastResult>& result, const Ray& ray, float maxDistance, unsigned collisionMask = M_MAX_UNSIGNED);
@@ -214,6 +293,12 @@ public:
     /// Perform a physics world swept sphere test and return the closest hit.
     void SphereCast
         (PhysicsRaycastResult& result, const Ray& ray, float radius, float maxDistance, unsigned collisionMask = M_MAX_UNSIGNED);
+    /// Perform a batch of raycasts in parallel in the worker threads and return the closest hit of each query at the same index. Return once all queries are done. The world must not be modified meanwhile, so call from the main thread outside the simulation step.
+    void RaycastSingleBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<PhysicsRaycastQuery>& queries);
+    /// Perform a batch of swept sphere tests in parallel in the worker threads and return the closest hit of each query at the same index. Return once all queries are done.
+    void SphereCastBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<PhysicsRaycastQuery>& queries);
+    /// Perform a batch of swept convex tests in parallel in the worker threads and return the first hit of each query at the same index. Return once all queries are done.
+    void ConvexCastBatch(PODVector<PhysicsRaycastResult>& results, const PODVector<PhysicsConvexCastQuery>& queries);
     /// Perform a physics world swept convex test using a user-supplied collision shape and return the first hit.
     void ConvexCast(PhysicsRaycastResult& result, CollisionShape* shape, const Vector3& startPos, const Quaternion& startRot,
         const Vector3& endPos, const Quaternion& endRot, unsigned collisionMask = M_MAX_UNSIGNED);
@@ -230,6 +315,8 @@ public:
     void GetRigidBodies(PODVector<RigidBody*>& result, const RigidBody* body);
     /// Return rigid bodies that have been in collision with the specified body on the last simulation step. Only returns collisions that were sent as events (depends on collision event mode) and excludes e.g. static-static collisions.
     void GetCollidingBodies(PODVector<RigidBody*>& result, const RigidBody* body);
+    /// Return the contact stream records of the last simulation step that involve the specified body.
+    void GetBodyContacts(PODVector<const PhysicsContact*>& result, const RigidBody* body) const;
 
     /// Return gravity.
     /// @property
@@ -266,6 +353,20 @@ public:
     /// Return maximum angular velocity for network replication.
     float GetMaxNetworkAngularVelocity() const { return maxNetworkAngularVelocity_; }
 
+    /// Return whether the contact stream is enabled.
+    /// @property
+    bool IsContactStreamEnabled() const { return contactStreamEnabled_; }
+
+    /// Return contact stream records of the last simulation step. Filtered by the collision event mode of the bodies like the collision events.
+    const PODVector<PhysicsContact>& GetContacts() const { return contactStream_; }
+
+    /// Return contact stream points of the last simulation step, referred to by the contact records.
+    const PODVector<PhysicsContactPoint>& GetContactPoints() const { return contactStreamPoints_; }
+
+    /// Return whether the multithreaded Bullet world is requested.
+    /// @property
+    bool GetMultiThreaded() const { return multiThreaded_; }
+
     /// Add a rigid body to keep track of. Called by RigidBody.
     void AddRigidBody(RigidBody* body);
     /// Remove a rigid body. Called by RigidBody.
@@ -326,6 +427,8 @@ public:
 
 protected:
     void CreateDynaymicWorld();
+    /// Destroy the Bullet world and its helper objects.
+    void DestroyDynamicWorld();
     /// Handle scene being assigned.
     void OnSceneSet(Scene* scene) override;
 
@@ -338,6 +441,8 @@ private:
     void PostStep(float timeStep);
     /// Send accumulated collision events.
     void SendCollisionEvents();
+    /// Fill the contact stream from the collision pairs of the current step.
+    void UpdateContactStream();
 
     /// Bullet collision configuration.
     btCollisionConfiguration* collisionConfiguration_{};
@@ -357,10 +462,18 @@ private:
     PODVector<CollisionShape*> collisionShapes_;
     /// Constraints in the world.
     PODVector<Constraint*> constraints_;
-    /// Collision pairs on this frame.
+    /// Collision pairs being processed on this step.
     HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, ManifoldPair> currentCollisions_;
-    /// Collision pairs on the previous frame. Used to check if a collision is "new." Manifolds are not guaranteed to exist anymore.
+    /// Collision pairs of the last finished step, swapped from the current pairs. Used to check if a collision is "new." Manifolds are not guaranteed to exist anymore.
     HashMap<Pair<WeakPtr<RigidBody>, WeakPtr<RigidBody> >, ManifoldPair> previousCollisions_;
+    /// Contact stream records.
+    PODVector<PhysicsContact> contactStream_;
+    /// Contact stream points.
+    PODVector<PhysicsContactPoint> contactStreamPoints_;
+    /// First contact stream link of each body.
+    HashMap<RigidBody*, unsigned> contactStreamBodies_;
+    /// Contact stream links to the next link of the same body, two per record for body A and body B.
+    PODVector<unsigned> contactStreamLinks_;
     /// Delayed (parented) world transform assignments.
     HashMap<RigidBody*, DelayedWorldTransform> delayedWorldTransforms_;
     /// Cache for trimesh geometry data by model and LOD level.
@@ -393,6 +506,14 @@ private:
     bool applyingTransforms_{};
     /// Simulating flag.
     bool simulating_{};
+    /// Sending collision events flag.
+    bool sendingCollisionEvents_{};
+    /// Contact stream enabled flag.
+    bool contactStreamEnabled_{};
+    /// Multithreaded world requested flag.
+    bool multiThreaded_{};
+    /// Multithreaded world in use flag.
+    bool multiThreadedWorld_{};
     /// Debug draw depth test mode.
     bool debugDepthTest_{};
     /// Debug renderer.
@@ -26,106 +26,196 @@
 
 #include "../Core/Context.h"
 #include "../Core/Profiler.h"
+#include "../Core/Thread.h"
+#include "../Core/Timer.h"
 #include "../IO/Log.h"
 #include "../Resource/BackgroundLoader.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/ResourceEvents.h"
 
+#include <algorithm>
+
 #include "../DebugNew.h"
 
 namespace Urho3D
 {
 
+/// Background loader thread.
+class BackgroundLoadThread : public Thread, public RefCounted
+{
+public:
+    /// Construct.
+    explicit BackgroundLoadThread(BackgroundLoader* owner) :
+        owner_(owner)
+    {
+    }
+
+    /// Process resources until stopped.
+    void ThreadFunction() override
+    {
+        owner_->ProcessItems(this);
+    }
+
+    /// Request the thread to stop and wake it up. Called with the loader mutex held.
+    void RequestStop()
+    {
+        shouldRun_ = false;
+        wakeCondition_.Set();
+    }
+
+    /// Wake up the thread to check the load queue.
+    void Wake() { wakeCondition_.Set(); }
+
+    /// Wait until woken up.
+    void WaitForWake() { wakeCondition_.Wait(); }
+
+    /// Return whether the thread should keep running.
+    bool ShouldRun() const { return shouldRun_; }
+
+private:
+    /// Background loader.
+    BackgroundLoader* owner_;
+    /// Condition for waking up the thread when resources are queued or the thread should stop.
+    Condition wakeCondition_;
+};
+
+/// Return whether a queue entry should be loaded after another entry.
+static bool CompareQueueEntries(const BackgroundLoadQueueEntry& lhs, const BackgroundLoadQueueEntry& rhs)
+{
+    if (lhs.priority_ != rhs.priority_)
+        return lhs.priority_ < rhs.priority_;
+    else
+        return lhs.order_ > rhs.order_;
+}
+
 BackgroundLoader::BackgroundLoader(ResourceCache* owner) :
-    owner_(owner)
+    owner_(owner),
+    numThreads_(1),
+    nextOrder_(0)
 {
 }
 
 BackgroundLoader::~BackgroundLoader()
 {
+    StopThreads(0);
+
     MutexLock lock(backgroundLoadMutex_);
 
     backgroundLoadQueue_.Clear();
+    loadQueue_.Clear();
 }
 
-void BackgroundLoader::ThreadFunction()
+void BackgroundLoader::ProcessItems(BackgroundLoadThread* thread)
 {
-    while (shouldRun_)
+    for (;;)
     {
         backgroundLoadMutex_.Acquire();
-
-        // Search for a queued resource that has not been loaded yet
-        HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Begin();
-        while (i != backgroundLoadQueue_.End())
+        if (!thread->ShouldRun())
         {
-            if (i->second_.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
-                break;
-            else
-                ++i;
+            backgroundLoadMutex_.Release();
+            break;
         }
 
-        if (i == backgroundLoadQueue_.End())
+        BackgroundLoadItem* item = TakeNextItem();
+        if (!item)
         {
-            // No resources to load found
+            // A wake up that happens after releasing the mutex is not lost, so the queue is checked again
             backgroundLoadMutex_.Release();
-            Time::Sleep(5);
+            thread->WaitForWake();
+            continue;
         }
-        else
-        {
-            BackgroundLoadItem& item = i->second_;
-            Resource* resource = item.resource_;
-            // We can be sure that the item is not removed from the queue as long as it is in the
-            // "queued" or "loading" state
-            backgroundLoadMutex_.Release();
 
-            bool success = false;
-            SharedPtr<File> file = owner_->GetFile(resource->GetName(), item.sendEventOnFailure_);
-            if (file)
-            {
-                resource->SetAsyncLoadState(ASYNC_LOADING);
-                success = resource->BeginLoad(*file);
-            }
+        // We can be sure that the item is not removed from the queue as long as it is in the "loading" state
+        Resource* resource = item->resource_;
+        resource->SetAsyncLoadState(ASYNC_LOADING);
+        backgroundLoadMutex_.Release();
 
-            // Process dependencies now
-            // Need to lock the queue again when manipulating other entries
-            Pair<StringHash, StringHash> key = MakePair(resource->GetType(), resource->GetNameHash());
-            backgroundLoadMutex_.Acquire();
-            if (item.dependents_.Size())
-            {
-                for (HashSet<Pair<StringHash, StringHash> >::Iterator i = item.dependents_.Begin();
-                     i != item.dependents_.End(); ++i)
-                {
-                    HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator j = backgroundLoadQueue_.Find(*i);
-                    if (j != backgroundLoadQueue_.End())
-                        j->second_.dependencies_.Erase(key);
-                }
+        bool success = false;
+        SharedPtr<File> file = owner_->GetFile(resource->GetName(), item->sendEventOnFailure_);
+        if (file)
+            success = resource->BeginLoad(*file);
 
-                item.dependents_.Clear();
+        // Process dependencies now
+        // Need to lock the queue again when manipulating other entries
+        Pair<StringHash, StringHash> key = MakePair(resource->GetType(), resource->GetNameHash());
+        backgroundLoadMutex_.Acquire();
+        if (item->dependents_.Size())
+        {
+            for (HashSet<Pair<StringHash, StringHash> >::Iterator i = item->dependents_.Begin(); i != item->dependents_.End(); ++i)
+            {
+                HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator j = backgroundLoadQueue_.Find(*i);
+                if (j != backgroundLoadQueue_.End())
+                    j->second_.dependencies_.Erase(key);
             }
 
-            resource->SetAsyncLoadState(success ? ASYNC_SUCCESS : ASYNC_FAIL);
-            backgroundLoadMutex_.Release();
+            item->dependents_.Clear();
         }
+
+        resource->SetAsyncLoadState(success ? ASYNC_SUCCESS : ASYNC_FAIL);
+        backgroundLoadMutex_.Release();
+
+        loadedCondition_.Set();
     }
 }
 
-bool BackgroundLoader::QueueResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller)
+bool BackgroundLoader::QueueResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller, int priority)
 {
     StringHash nameHash(name);
     Pair<StringHash, StringHash> key = MakePair(type, nameHash);
+    bool knownType = true;
+    bool callerFound = true;
+    bool threadsStarted = true;
 
-    MutexLock lock(backgroundLoadMutex_);
+    // Note: logging and sending events is done without holding the mutex, as event handlers may request more resources
+    {
+        MutexLock lock(backgroundLoadMutex_);
 
-    // Check if already exists in the queue
-    if (backgroundLoadQueue_.Find(key) != backgroundLoadQueue_.End())
-        return false;
+        // Check if already exists in the queue. If so, only raise the priority
+        if (backgroundLoadQueue_.Find(key) != backgroundLoadQueue_.End())
+        {
+            RaisePriority(key, priority);
+            return false;
+        }
 
-    BackgroundLoadItem& item = backgroundLoadQueue_[key];
-    item.sendEventOnFailure_ = sendEventOnFailure;
+        // Make sure the pointer is non-null and is a Resource subclass
+        SharedPtr<Resource> resource = DynamicCast<Resource>(owner_->GetContext()->CreateObject(type));
+        if (!resource)
+            knownType = false;
+        else
+        {
+            BackgroundLoadItem& item = backgroundLoadQueue_[key];
+            item.resource_ = resource;
+            item.priority_ = priority;
+            item.sendEventOnFailure_ = sendEventOnFailure;
+            item.resource_->SetName(name);
+            item.resource_->SetAsyncLoadState(ASYNC_QUEUED);
+
+            // If this is a resource calling for the background load of more resources, mark the dependency as necessary.
+            // The dependency can not be finished before the caller, so load it with at least the caller's priority
+            if (caller)
+            {
+                Pair<StringHash, StringHash> callerKey = MakePair(caller->GetType(), caller->GetNameHash());
+                HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator j = backgroundLoadQueue_.Find(callerKey);
+                if (j != backgroundLoadQueue_.End())
+                {
+                    BackgroundLoadItem& callerItem = j->second_;
+                    item.dependents_.Insert(callerKey);
+                    item.priority_ = Max(item.priority_, callerItem.priority_);
+                    callerItem.dependencies_.Insert(key);
+                }
+                else
+                    callerFound = false;
+            }
+
+            PushQueueEntry(key, item.priority_);
+
+            // Start the background loader threads now
+            if (threads_.Empty())
+                threadsStarted = StartThreads();
+        }
+    }
 
-    // Make sure the pointer is non-null and is a Resource subclass
-    item.resource_ = DynamicCast<Resource>(owner_->GetContext()->CreateObject(type));
-    if (!item.resource_)
+    if (!knownType)
     {
         URHO3D_LOGERROR("Could not load unknown resource type " + String(type));
 
@@ -138,35 +228,46 @@ bool BackgroundLoader::QueueResource(StringHash type, const String& name, bool s
             owner_->SendEvent(E_UNKNOWNRESOURCETYPE, eventData);
         }
 
-        backgroundLoadQueue_.Erase(key);
         return false;
     }
 
     URHO3D_LOGDEBUG("Background loading resource " + name);
 
-    item.resource_->SetName(name);
-    item.resource_->SetAsyncLoadState(ASYNC_QUEUED);
+    if (!callerFound)
+        URHO3D_LOGWARNING("Resource " + caller->GetName() +
+                   " requested for a background loaded resource but was not in the background load queue");
+    if (!threadsStarted)
+        URHO3D_LOGERROR("Failed to start background loader thread");
+
+    return true;
+}
+
+bool BackgroundLoader::CancelResource(StringHash type, StringHash nameHash)
+{
+    String name;
 
-    // If this is a resource calling for the background load of more resources, mark the dependency as necessary
-    if (caller)
     {
-        Pair<StringHash, StringHash> callerKey = MakePair(caller->GetType(), caller->GetNameHash());
-        HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator j = backgroundLoadQueue_.Find(callerKey);
-        if (j != backgroundLoadQueue_.End())
+        MutexLock lock(backgroundLoadMutex_);
+
+        Pair<StringHash, StringHash> key = MakePair(type, nameHash);
+        HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Find(key);
+        if (i == backgroundLoadQueue_.End() || i->second_.resource_->GetAsyncLoadState() != ASYNC_QUEUED)
+            return false;
+
+        // Dependents no longer wait for the resource. They have to load it themselves when finishing
+        for (HashSet<Pair<StringHash, StringHash> >::Iterator j = i->second_.dependents_.Begin(); j != i->second_.dependents_.End(); ++j)
         {
-            BackgroundLoadItem& callerItem = j->second_;
-            item.dependents_.Insert(callerKey);
-            callerItem.dependencies_.Insert(key);
+            HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator k = backgroundLoadQueue_.Find(*j);
+            if (k != backgroundLoadQueue_.End())
+                k->second_.dependencies_.Erase(key);
         }
-        else
-            URHO3D_LOGWARNING("Resource " + caller->GetName() +
-                       " requested for a background loaded resource but was not in the background load queue");
-    }
 
-    // Start the background loader thread now
-    if (!IsStarted())
-        Run();
+        // The priority queue entries of the resource are skipped when taken
+        name = i->second_.resource_->GetName();
+        backgroundLoadQueue_.Erase(i);
+    }
 
+    URHO3D_LOGDEBUG("Cancelled background loading of resource " + name);
     return true;
 }
 
@@ -177,77 +278,110 @@ void BackgroundLoader::WaitForResource(StringHash type, StringHash nameHash)
     // Check if the resource in question is being background loaded
     Pair<StringHash, StringHash> key = MakePair(type, nameHash);
     HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Find(key);
-    if (i != backgroundLoadQueue_.End())
+    if (i == backgroundLoadQueue_.End())
     {
         backgroundLoadMutex_.Release();
+        return;
+    }
 
-        {
-            Resource* resource = i->second_.resource_;
-            HiresTimer waitTimer;
-            bool didWait = false;
+    BackgroundLoadItem& item = i->second_;
+    Resource* resource = item.resource_;
+    AsyncLoadState state = resource->GetAsyncLoadState();
 
-            for (;;)
-            {
-                unsigned numDeps = i->second_.dependencies_.Size();
-                AsyncLoadState state = resource->GetAsyncLoadState();
-                if (numDeps > 0 || state == ASYNC_QUEUED || state == ASYNC_LOADING)
-                {
-                    didWait = true;
-                    Time::Sleep(1);
-                }
-                else
-                    break;
-            }
+    if (item.dependencies_.Size() || state == ASYNC_QUEUED || state == ASYNC_LOADING)
+    {
+        // The resource is needed now, so load it and its dependencies before anything else
+        RaisePriority(key, M_MAX_INT);
 
-            if (didWait)
-                URHO3D_LOGDEBUG("Waited " + String(waitTimer.GetUSec(false) / 1000) + " ms for background loaded resource " +
-                         resource->GetName());
-        }
+        HiresTimer waitTimer;
+        for (;;)
+        {
+            state = resource->GetAsyncLoadState();
+            if (item.dependencies_.Empty() && state != ASYNC_QUEUED && state != ASYNC_LOADING)
+                break;
 
-        // This may take a long time and may potentially wait on other resources, so it is important we do not hold the mutex during this
-        FinishBackgroundLoading(i->second_);
+            // Only the main thread waits, and a resource finished after releasing the mutex still sets the condition
+            backgroundLoadMutex_.Release();
+            loadedCondition_.Wait();
+            backgroundLoadMutex_.Acquire();
+        }
 
-        backgroundLoadMutex_.Acquire();
-        backgroundLoadQueue_.Erase(i);
         backgroundLoadMutex_.Release();
+        URHO3D_LOGDEBUG("Waited " + String(waitTimer.GetUSec(false) / 1000) + " ms for background loaded resource " +
+                 resource->GetName());
     }
     else
         backgroundLoadMutex_.Release();
+
+    // This may take a long time and may potentially wait on other resources, so it is important we do not hold the mutex during this
+    FinishBackgroundLoading(item);
+
+    MutexLock lock(backgroundLoadMutex_);
+    backgroundLoadQueue_.Erase(i);
 }
 
 void BackgroundLoader::FinishResources(int maxMs)
 {
-    if (IsStarted())
+    backgroundLoadMutex_.Acquire();
+
+    if (threads_.Empty())
     {
-        HiresTimer timer;
+        backgroundLoadMutex_.Release();
+        return;
+    }
 
-        backgroundLoadMutex_.Acquire();
+    HiresTimer timer;
 
-        for (HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Begin();
-             i != backgroundLoadQueue_.End();)
+    for (HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Begin();
+         i != backgroundLoadQueue_.End();)
+    {
+        Resource* resource = i->second_.resource_;
+        unsigned numDeps = i->second_.dependencies_.Size();
+        AsyncLoadState state = resource->GetAsyncLoadState();
+        if (numDeps > 0 || state == ASYNC_QUEUED || state == ASYNC_LOADING)
+            ++i;
+        else
         {
-            Resource* resource = i->second_.resource_;
-            unsigned numDeps = i->second_.dependencies_.Size();
-            AsyncLoadState state = resource->GetAsyncLoadState();
-            if (numDeps > 0 || state == ASYNC_QUEUED || state == ASYNC_LOADING)
-                ++i;
-            else
-            {
-                // Finishing a resource may need it to wait for other resources to load, in which case we can not
-                // hold on to the mutex
-                backgroundLoadMutex_.Release();
-                FinishBackgroundLoading(i->second_);
-                backgroundLoadMutex_.Acquire();
-                i = backgroundLoadQueue_.Erase(i);
-            }
-
-            // Break when the time limit passed so that we keep sufficient FPS
-            if (timer.GetUSec(false) >= maxMs * 1000LL)
-                break;
+            // Finishing a resource may need it to wait for other resources to load, in which case we can not
+            // hold on to the mutex
+            backgroundLoadMutex_.Release();
+            FinishBackgroundLoading(i->second_);
+            backgroundLoadMutex_.Acquire();
+            i = backgroundLoadQueue_.Erase(i);
         }
 
-        backgroundLoadMutex_.Release();
+        // Break when the time limit passed so that we keep sufficient FPS
+        if (timer.GetUSec(false) >= maxMs * 1000LL)
+            break;
     }
+
+    backgroundLoadMutex_.Release();
+}
+
+void BackgroundLoader::SetNumThreads(unsigned num)
+{
+    num = Max(num, 1U);
+    bool threadsStarted = true;
+    bool stopNeeded = true;
+
+    {
+        MutexLock lock(backgroundLoadMutex_);
+
+        numThreads_ = num;
+        // If threads have not been started yet, they will be on the first background load request
+        if (threads_.Empty())
+            return;
+        if (threads_.Size() < numThreads_)
+        {
+            threadsStarted = StartThreads();
+            stopNeeded = false;
+        }
+    }
+
+    if (stopNeeded)
+        StopThreads(num);
+    if (!threadsStarted)
+        URHO3D_LOGERROR("Failed to start background loader thread");
 }
 
 unsigned BackgroundLoader::GetNumQueuedResources() const
@@ -256,6 +390,92 @@ unsigned BackgroundLoader::GetNumQueuedResources() const
     return backgroundLoadQueue_.Size();
 }
 
+BackgroundLoadItem* BackgroundLoader::TakeNextItem()
+{
+    while (!loadQueue_.Empty())
+    {
+        std::pop_heap(loadQueue_.Begin().ptr_, loadQueue_.End().ptr_, CompareQueueEntries);
+        BackgroundLoadQueueEntry entry = loadQueue_.Back();
+        loadQueue_.Pop();
+
+        // Skip entries of cancelled resources and entries superseded by a priority raise
+        HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Find(entry.key_);
+        if (i != backgroundLoadQueue_.End() && i->second_.priority_ == entry.priority_ &&
+            i->second_.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
+            return &i->second_;
+    }
+
+    return nullptr;
+}
+
+void BackgroundLoader::PushQueueEntry(const Pair<StringHash, StringHash>& key, int priority)
+{
+    BackgroundLoadQueueEntry entry;
+    entry.key_ = key;
+    entry.priority_ = priority;
+    entry.order_ = nextOrder_++;
+    loadQueue_.Push(entry);
+    std::push_heap(loadQueue_.Begin().ptr_, loadQueue_.End().ptr_, CompareQueueEntries);
+
+    WakeThreads();
+}
+
+void BackgroundLoader::WakeThreads()
+{
+    // Threads that find the queue already empty go back to waiting
+    for (unsigned i = 0; i < threads_.Size(); ++i)
+        threads_[i]->Wake();
+}
+
+void BackgroundLoader::RaisePriority(const Pair<StringHash, StringHash>& key, int priority)
+{
+    HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem>::Iterator i = backgroundLoadQueue_.Find(key);
+    if (i == backgroundLoadQueue_.End() || i->second_.priority_ >= priority)
+        return;
+
+    BackgroundLoadItem& item = i->second_;
+    item.priority_ = priority;
+    if (item.resource_->GetAsyncLoadState() == ASYNC_QUEUED)
+        PushQueueEntry(key, priority);
+
+    // The resource can not be finished before its dependencies, so raise them too
+    for (HashSet<Pair<StringHash, StringHash> >::Iterator j = item.dependencies_.Begin(); j != item.dependencies_.End(); ++j)
+        RaisePriority(*j, priority);
+}
+
+bool BackgroundLoader::StartThreads()
+{
+    while (threads_.Size() < numThreads_)
+    {
+        SharedPtr<BackgroundLoadThread> thread(new BackgroundLoadThread(this));
+        if (!thread->Run())
+            return false;
+        threads_.Push(thread);
+    }
+
+    return true;
+}
+
+void BackgroundLoader::StopThreads(unsigned keep)
+{
+    Vector<SharedPtr<BackgroundLoadThread> > stopThreads;
+
+    {
+        MutexLock lock(backgroundLoadMutex_);
+
+        while (threads_.Size() > keep)
+        {
+            threads_.Back()->RequestStop();
+            stopThreads.Push(threads_.Back());
+            threads_.Pop();
+        }
+    }
+
+    // Wait for the threads to finish their current resource without holding the mutex
+    for (unsigned i = 0; i < stopThreads.Size(); ++i)
+        stopThreads[i]->Stop();
+}
+
 void BackgroundLoader::FinishBackgroundLoading(BackgroundLoadItem& item)
 {
     Resource* resource = item.resource_;
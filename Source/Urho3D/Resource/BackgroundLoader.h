@@ -24,15 +24,16 @@
 
 #include "../Container/HashMap.h"
 #include "../Container/HashSet.h"
-#include "../Core/Mutex.h"
 #include "../Container/Ptr.h"
 #include "../Container/RefCounted.h"
-#include "../Core/Thread.h"
+#include "../Core/Condition.h"
+#include "../Core/Mutex.h"
 #include "../Math/StringHash.h"
 
 namespace Urho3D
 {
 
+class BackgroundLoadThread;
 class Resource;
 class ResourceCache;
 
@@ -45,35 +46,67 @@ struct BackgroundLoadItem
     HashSet<Pair<StringHash, StringHash> > dependencies_;
     /// Resources that depend on this resource's loading.
     HashSet<Pair<StringHash, StringHash> > dependents_;
+    /// Load priority. Higher priority resources are loaded first. Raised to the priority of the dependents.
+    int priority_;
     /// Whether to send failure event.
     bool sendEventOnFailure_;
 };
 
+/// Priority queue entry of a resource waiting to be loaded. When the priority of a resource is raised, a new entry is added and the old one is skipped.
+struct BackgroundLoadQueueEntry
+{
+    /// Resource type and name hash.
+    Pair<StringHash, StringHash> key_;
+    /// Load priority at the time of queuing.
+    int priority_;
+    /// Queuing order, to load resources of the same priority first in first out.
+    unsigned order_;
+};
+
 /// Background loader of resources. Owned by the ResourceCache.
 /// @nobind
-class BackgroundLoader : public RefCounted, public Thread
+class BackgroundLoader : public RefCounted
 {
+    friend class BackgroundLoadThread;
+
 public:
     /// Construct.
     explicit BackgroundLoader(ResourceCache* owner);
 
-    /// Destruct. Forcibly clear the load queue.
+    /// Destruct. Stop the loader threads and forcibly clear the load queue.
     ~BackgroundLoader() override;
 
-    /// Resource background loading loop.
-    void ThreadFunction() override;
-
-    /// Queue loading of a resource. The name must be sanitated to ensure consistent format. Return true if queued (not a duplicate and resource was a known type).
-    bool QueueResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller);
+    /// Queue loading of a resource. The name must be sanitated to ensure consistent format. Return true if queued (not a duplicate and resource was a known type). If already queued, raise the priority if higher.
+    bool QueueResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller, int priority);
+    /// Cancel loading of a resource that has not started loading yet. Return true if cancelled.
+    bool CancelResource(StringHash type, StringHash nameHash);
     /// Wait and finish possible loading of a resource when being requested from the cache.
     void WaitForResource(StringHash type, StringHash nameHash);
     /// Process resources that are ready to finish.
     void FinishResources(int maxMs);
+    /// Set number of loader threads. Minimum 1.
+    void SetNumThreads(unsigned num);
 
     /// Return amount of resources in the load queue.
     unsigned GetNumQueuedResources() const;
+    /// Return number of loader threads.
+    unsigned GetNumThreads() const { return numThreads_; }
 
 private:
+    /// Resource background loading loop of a loader thread.
+    void ProcessItems(BackgroundLoadThread* thread);
+    /// Remove and return the highest priority resource waiting to be loaded, or null if none. Called with the mutex held.
+    BackgroundLoadItem* TakeNextItem();
+    /// Wake up the loader threads to check the load queue. Called with the mutex held.
+    void WakeThreads();
+    /// Add a priority queue entry for a resource. Called with the mutex held.
+    void PushQueueEntry(const Pair<StringHash, StringHash>& key, int priority);
+    /// Raise the priority of a queued resource and the resources it depends on. Called with the mutex held.
+    void RaisePriority(const Pair<StringHash, StringHash>& key, int priority);
+    /// Start loader threads up to the configured amount. Return false if failed to start a thread. Called with the mutex held.
+    bool StartThreads();
+    /// Stop loader threads exceeding the specified amount.
+    void StopThreads(unsigned keep);
     /// Finish one background loaded resource.
     void FinishBackgroundLoading(BackgroundLoadItem& item);
 
@@ -81,8 +114,18 @@ private:
     ResourceCache* owner_;
     /// Mutex for thread-safe access to the background load queue.
     mutable Mutex backgroundLoadMutex_;
+    /// Condition for waking up the main thread when a loader thread has finished loading a resource.
+    Condition loadedCondition_;
     /// Resources that are queued for background loading.
     HashMap<Pair<StringHash, StringHash>, BackgroundLoadItem> backgroundLoadQueue_;
+    /// Resources waiting to be loaded as a binary heap ordered by priority.
+    PODVector<BackgroundLoadQueueEntry> loadQueue_;
+    /// Loader threads.
+    Vector<SharedPtr<BackgroundLoadThread> > threads_;
+    /// Number of loader threads to use.
+    unsigned numThreads_;
+    /// Queuing order counter.
+    unsigned nextOrder_;
 };
 
 }
@@ -2340,6 +2340,14 @@ unsigned char* Image::GetImageData(Deserializer& source, int& width, int& height
 {
     unsigned dataSize = source.GetSize();
 
+    // Decode in place if the whole stream already resides in memory, and consume it as a read would
+    const unsigned char* memoryData = !source.GetPosition() ? source.GetMemoryData() : nullptr;
+    if (memoryData)
+    {
+        source.Seek(dataSize);
+        return stbi_load_from_memory(memoryData, dataSize, &width, &height, (int*)&components, 0);
+    }
+
     SharedArrayPtr<unsigned char> buffer(new unsigned char[dataSize]);
     source.Read(buffer.Get(), dataSize);
     return stbi_load_from_memory(buffer.Get(), dataSize, &width, &height, (int*)&components, 0);
@@ -120,13 +120,21 @@ bool JSONFile::BeginLoad(Deserializer& source)
         return false;
     }
 
-    SharedArrayPtr<char> buffer(new char[dataSize + 1]);
-    if (source.Read(buffer.Get(), dataSize) != dataSize)
-        return false;
-    buffer[dataSize] = '\0';
+    // Parse in place if the whole stream already resides in memory, and consume it as a read would
+    auto* data = !source.GetPosition() ? (const char*)source.GetMemoryData() : nullptr;
+    SharedArrayPtr<char> buffer;
+    if (data)
+        source.Seek(dataSize);
+    else
+    {
+        buffer = new char[dataSize];
+        if (source.Read(buffer.Get(), dataSize) != dataSize)
+            return false;
+        data = buffer.Get();
+    }
 
     rapidjson::Document document;
-    if (document.Parse<kParseCommentsFlag | kParseTrailingCommasFlag>(buffer).HasParseError())
+    if (document.Parse<kParseCommentsFlag | kParseTrailingCommasFlag>(data, dataSize).HasParseError())
     {
         URHO3D_LOGERROR("Could not parse JSON data from " + source.GetName());
         return false;
@@ -72,6 +72,7 @@ ResourceCache::ResourceCache(Context* context) :
     autoReloadResources_(false),
     returnFailedResources_(false),
     searchPackagesFirst_(true),
+    memoryMapPackages_(false),
     isRouting_(false),
     finishBackgroundResourcesMs_(5)
 {
@@ -144,6 +145,10 @@ bool ResourceCache::AddPackageFile(PackageFile* package, unsigned priority)
         return false;
     }
 
+    // Mapping failure is not fatal, as the files can still be read through file IO
+    if (memoryMapPackages_)
+        package->MapToMemory();
+
     if (priority < packages_.Size())
         packages_.Insert(priority, SharedPtr<PackageFile>(package));
     else
@@ -635,7 +640,7 @@ Resource* ResourceCache::GetResource(StringHash type, const String& name, bool s
     return resource;
 }
 
-bool ResourceCache::BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller)
+bool ResourceCache::BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure, Resource* caller, int priority)
 {
 #ifdef URHO3D_THREADING
     // If empty name, fail immediately
@@ -648,13 +653,29 @@ bool ResourceCache::BackgroundLoadResource(StringHash type, const String& name,
     if (FindResource(type, nameHash) != noResource)
         return false;
 
-    return backgroundLoader_->QueueResource(type, sanitatedName, sendEventOnFailure, caller);
+    return backgroundLoader_->QueueResource(type, sanitatedName, sendEventOnFailure, caller, priority);
 #else
     // When threading not supported, fall back to synchronous loading
     return GetResource(type, name, sendEventOnFailure);
 #endif
 }
 
+bool ResourceCache::CancelBackgroundLoadResource(StringHash type, const String& name)
+{
+#ifdef URHO3D_THREADING
+    return backgroundLoader_->CancelResource(type, StringHash(SanitateResourceName(name)));
+#else
+    return false;
+#endif
+}
+
+void ResourceCache::SetNumBackgroundLoadThreads(unsigned num)
+{
+#ifdef URHO3D_THREADING
+    backgroundLoader_->SetNumThreads(num);
+#endif
+}
+
 SharedPtr<Resource> ResourceCache::GetTempResource(StringHash type, const String& name, bool sendEventOnFailure)
 {
     String sanitatedName = SanitateResourceName(name);
@@ -708,6 +729,15 @@ SharedPtr<Resource> ResourceCache::GetTempResource(StringHash type, const String
     return resource;
 }
 
+unsigned ResourceCache::GetNumBackgroundLoadThreads() const
+{
+#ifdef URHO3D_THREADING
+    return backgroundLoader_->GetNumThreads();
+#else
+    return 0;
+#endif
+}
+
 unsigned ResourceCache::GetNumBackgroundLoadResources() const
 {
 #ifdef URHO3D_THREADING
@@ -132,10 +132,14 @@ public:
     /// Define whether when getting resources should check package files or directories first. True for packages, false for directories.
     /// @property
     void SetSearchPackagesFirst(bool value) { searchPackagesFirst_ = value; }
+    /// Define whether package files should be mapped to memory when added. Uncompressed resources are then read without file IO and parsed in place where possible. Default false.
+    void SetMemoryMapPackages(bool enable) { memoryMapPackages_ = enable; }
 
     /// Set how many milliseconds maximum per frame to spend on finishing background loaded resources.
     /// @property
     void SetFinishBackgroundResourcesMs(int ms) { finishBackgroundResourcesMs_ = Max(ms, 1); }
+    /// Set number of threads used for background loading resources. Default 1. With more than one thread, the BeginLoad() of any queued resources may run concurrently, regardless of their type, so increase only when all background loaded resource types are safe to load in parallel.
+    void SetNumBackgroundLoadThreads(unsigned num);
 
     /// Add a resource router object. By default there is none, so the routing process is skipped.
     void AddResourceRouter(ResourceRouter* router, bool addAsFirst = false);
@@ -148,8 +152,10 @@ public:
     Resource* GetResource(StringHash type, const String& name, bool sendEventOnFailure = true);
     /// Load a resource without storing it in the resource cache. Return null if not found or if fails. Can be called from outside the main thread if the resource itself is safe to load completely (it does not possess for example GPU data).
     SharedPtr<Resource> GetTempResource(StringHash type, const String& name, bool sendEventOnFailure = true);
-    /// Background load a resource. An event will be sent when complete. Return true if successfully stored to the load queue, false if eg. already exists. Can be called from outside the main thread.
-    bool BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr);
+    /// Background load a resource. An event will be sent when complete. Return true if successfully stored to the load queue, false if eg. already exists. Resources with higher priority are loaded first; requesting an already queued resource with a higher priority raises its priority. Can be called from outside the main thread.
+    bool BackgroundLoadResource(StringHash type, const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr, int priority = 0);
+    /// Cancel a background load request that has not started loading yet. Return true if cancelled. Can be called only from the main thread.
+    bool CancelBackgroundLoadResource(StringHash type, const String& name);
     /// Return number of pending background-loaded resources.
     /// @property
     unsigned GetNumBackgroundLoadResources() const;
@@ -178,7 +184,9 @@ public:
     /// Template version of releasing a resource by name.
     template <class T> void ReleaseResource(const String& name, bool force = false);
     /// Template version of queueing a resource background load.
-    template <class T> bool BackgroundLoadResource(const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr);
+    template <class T> bool BackgroundLoadResource(const String& name, bool sendEventOnFailure = true, Resource* caller = nullptr, int priority = 0);
+    /// Template version of cancelling a resource background load.
+    template <class T> bool CancelBackgroundLoadResource(const String& name);
     /// Template version of returning loaded resources of a specific type.
     template <class T> void GetResources(PODVector<T*>& result) const;
     /// Return whether a file exists in the resource directories or package files. Does not check manually added in-memory resources.
@@ -207,9 +215,14 @@ public:
     /// @property
     bool GetSearchPackagesFirst() const { return searchPackagesFirst_; }
 
+    /// Return whether package files are mapped to memory when added.
+    bool GetMemoryMapPackages() const { return memoryMapPackages_; }
+
     /// Return how many milliseconds maximum to spend on finishing background loaded resources.
     /// @property
     int GetFinishBackgroundResourcesMs() const { return finishBackgroundResourcesMs_; }
+    /// Return number of threads used for background loading resources.
+    unsigned GetNumBackgroundLoadThreads() const;
 
     /// Return a resource router by index.
     ResourceRouter* GetResourceRouter(unsigned index) const;
@@ -266,6 +279,8 @@ private:
     bool returnFailedResources_;
     /// Search priority flag.
     bool searchPackagesFirst_;
+    /// Memory-map package files flag.
+    bool memoryMapPackages_;
     /// Resource routing flag to prevent endless recursion.
     mutable bool isRouting_;
     /// How many milliseconds maximum per frame to spend on finishing background loaded resources.
@@ -296,10 +311,16 @@ template <class T> SharedPtr<T> ResourceCache::GetTempResource(const String& nam
     return StaticCast<T>(GetTempResource(type, name, sendEventOnFailure));
 }
 
-template <class T> bool ResourceCache::BackgroundLoadResource(const String& name, bool sendEventOnFailure, Resource* caller)
+template <class T> bool ResourceCache::BackgroundLoadResource(const String& name, bool sendEventOnFailure, Resource* caller, int priority)
+{
+    StringHash type = T::GetTypeStatic();
+    return BackgroundLoadResource(type, name, sendEventOnFailure, caller, priority);
+}
+
+template <class T> bool ResourceCache::CancelBackgroundLoadResource(const String& name)
 {
     StringHash type = T::GetTypeStatic();
-    return BackgroundLoadResource(type, name, sendEventOnFailure, caller);
+    return CancelBackgroundLoadResource(type, name);
 }
 
 template <class T> void ResourceCache::GetResources(PODVector<T*>& result) const
@@ -23,12 +23,9 @@
 #include "../Precompiled.h"
 
 #include "../IO/Log.h"
-#if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
-#include "../Physics/PhysicsEvents.h"
-#endif
 #include "../Scene/LogicComponent.h"
+#include "../Scene/LogicUpdateRegistry.h"
 #include "../Scene/Scene.h"
-#include "../Scene/SceneEvents.h"
 
 namespace Urho3D
 {
@@ -37,11 +34,15 @@ LogicComponent::LogicComponent(Context* context) :
     Component(context),
     updateEventMask_(USE_UPDATE | USE_POSTUPDATE | USE_FIXEDUPDATE | USE_FIXEDPOSTUPDATE),
     currentEventMask_(0),
-    delayedStartCalled_(false)
+    delayedStartCalled_(false),
+    parallelUpdate_(false)
 {
 }
 
-LogicComponent::~LogicComponent() = default;
+LogicComponent::~LogicComponent()
+{
+    RemoveEventSubscription();
+}
 
 void LogicComponent::OnSetEnabled()
 {
@@ -73,6 +74,17 @@ void LogicComponent::SetUpdateEventMask(UpdateEventFlags mask)
     }
 }
 
+void LogicComponent::SetParallelUpdate(bool enable)
+{
+    if (enable != parallelUpdate_)
+    {
+        // The registry groups components by the flag, so re-add with the new value
+        RemoveEventSubscription();
+        parallelUpdate_ = enable;
+        UpdateEventSubscription();
+    }
+}
+
 void LogicComponent::OnNodeSet(Node* node)
 {
     if (node)
@@ -92,15 +104,7 @@ void LogicComponent::OnSceneSet(Scene* scene)
     if (scene)
         UpdateEventSubscription();
     else
-    {
-        UnsubscribeFromEvent(E_SCENEUPDATE);
-        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
-#if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
-        UnsubscribeFromEvent(E_PHYSICSPRESTEP);
-        UnsubscribeFromEvent(E_PHYSICSPOSTSTEP);
-#endif
-        currentEventMask_ = USE_NO_EVENT;
-    }
+        RemoveEventSubscription();
 }
 
 void LogicComponent::UpdateEventSubscription()
@@ -109,119 +113,50 @@ void LogicComponent::UpdateEventSubscription()
     if (!scene)
         return;
 
-    bool enabled = IsEnabledEffective();
-
-    bool needUpdate = enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_);
-    if (needUpdate && !(currentEventMask_ & USE_UPDATE))
-    {
-        SubscribeToEvent(scene, E_SCENEUPDATE, URHO3D_HANDLER(LogicComponent, HandleSceneUpdate));
-        currentEventMask_ |= USE_UPDATE;
-    }
-    else if (!needUpdate && (currentEventMask_ & USE_UPDATE))
+    LogicUpdateRegistry* registry = scene->GetLogicUpdateRegistry();
+    if (registry != updateRegistry_)
     {
-        UnsubscribeFromEvent(scene, E_SCENEUPDATE);
-        currentEventMask_ &= ~USE_UPDATE;
+        RemoveEventSubscription();
+        updateRegistry_ = registry;
     }
 
-    bool needPostUpdate = enabled && (updateEventMask_ & USE_POSTUPDATE);
-    if (needPostUpdate && !(currentEventMask_ & USE_POSTUPDATE))
-    {
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(LogicComponent, HandleScenePostUpdate));
-        currentEventMask_ |= USE_POSTUPDATE;
-    }
-    else if (!needPostUpdate && (currentEventMask_ & USE_POSTUPDATE))
-    {
-        UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
-        currentEventMask_ &= ~USE_POSTUPDATE;
-    }
+    bool enabled = IsEnabledEffective();
+    UpdateEventFlags neededMask = USE_NO_EVENT;
 
-#if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
-    Component* world = GetFixedUpdateSource();
-    if (!world)
-        return;
+    if (enabled && ((updateEventMask_ & USE_UPDATE) || !delayedStartCalled_))
+        neededMask |= USE_UPDATE;
+    if (enabled && (updateEventMask_ & USE_POSTUPDATE))
+        neededMask |= USE_POSTUPDATE;
 
-    bool needFixedUpdate = enabled && (updateEventMask_ & USE_FIXEDUPDATE);
-    if (needFixedUpdate && !(currentEventMask_ & USE_FIXEDUPDATE))
-    {
-        SubscribeToEvent(world, E_PHYSICSPRESTEP, URHO3D_HANDLER(LogicComponent, HandlePhysicsPreStep));
-        currentEventMask_ |= USE_FIXEDUPDATE;
-    }
-    else if (!needFixedUpdate && (currentEventMask_ & USE_FIXEDUPDATE))
-    {
-        UnsubscribeFromEvent(world, E_PHYSICSPRESTEP);
-        currentEventMask_ &= ~USE_FIXEDUPDATE;
-    }
-
-    bool needFixedPostUpdate = enabled && (updateEventMask_ & USE_FIXEDPOSTUPDATE);
-    if (needFixedPostUpdate && !(currentEventMask_ & USE_FIXEDPOSTUPDATE))
-    {
-        SubscribeToEvent(world, E_PHYSICSPOSTSTEP, URHO3D_HANDLER(LogicComponent, HandlePhysicsPostStep));
-        currentEventMask_ |= USE_FIXEDPOSTUPDATE;
-    }
-    else if (!needFixedPostUpdate && (currentEventMask_ & USE_FIXEDPOSTUPDATE))
-    {
-        UnsubscribeFromEvent(world, E_PHYSICSPOSTSTEP);
-        currentEventMask_ &= ~USE_FIXEDPOSTUPDATE;
-    }
+    Component* world = nullptr;
+#if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
+    world = GetFixedUpdateSource();
 #endif
-}
-
-void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
-{
-    using namespace SceneUpdate;
-
-    // Execute user-defined delayed start function before first update
-    if (!delayedStartCalled_)
+    if (world)
     {
-        DelayedStart();
-        delayedStartCalled_ = true;
-
-        // If did not need actual update events, unsubscribe now
-        if (!(updateEventMask_ & USE_UPDATE))
-        {
-            UnsubscribeFromEvent(GetScene(), E_SCENEUPDATE);
-            currentEventMask_ &= ~USE_UPDATE;
-            return;
-        }
+        if (enabled && (updateEventMask_ & USE_FIXEDUPDATE))
+            neededMask |= USE_FIXEDUPDATE;
+        if (enabled && (updateEventMask_ & USE_FIXEDPOSTUPDATE))
+            neededMask |= USE_FIXEDPOSTUPDATE;
     }
-
-    // Then execute user-defined update function
-    Update(eventData[P_TIMESTEP].GetFloat());
-}
-
-void LogicComponent::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
-{
-    using namespace ScenePostUpdate;
-
-    // Execute user-defined post-update function
-    PostUpdate(eventData[P_TIMESTEP].GetFloat());
-}
-
-#if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
-
-void LogicComponent::HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData)
-{
-    using namespace PhysicsPreStep;
-
-    // Execute user-defined delayed start function before first fixed update if not called yet
-    if (!delayedStartCalled_)
+    else
     {
-        DelayedStart();
-        delayedStartCalled_ = true;
+        // Without a physics world, leave the fixed update events as they are
+        neededMask |= currentEventMask_ & (USE_FIXEDUPDATE | USE_FIXEDPOSTUPDATE);
     }
 
-    // Execute user-defined fixed update function
-    FixedUpdate(eventData[P_TIMESTEP].GetFloat());
+    registry->RemoveComponent(this, currentEventMask_ & ~neededMask);
+    registry->AddComponent(this, neededMask & ~currentEventMask_, world);
+    currentEventMask_ = neededMask;
 }
 
-void LogicComponent::HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData)
+void LogicComponent::RemoveEventSubscription()
 {
-    using namespace PhysicsPostStep;
+    if (updateRegistry_)
+        updateRegistry_->RemoveComponent(this, currentEventMask_);
 
-    // Execute user-defined fixed post-update function
-    FixedPostUpdate(eventData[P_TIMESTEP].GetFloat());
+    updateRegistry_.Reset();
+    currentEventMask_ = USE_NO_EVENT;
 }
 
-#endif
-
 }
@@ -30,6 +30,8 @@
 namespace Urho3D
 {
 
+class LogicUpdateRegistry;
+
 enum UpdateEvent : unsigned
 {
     /// Bitmask for not using any events.
@@ -50,6 +52,8 @@ class URHO3D_API LogicComponent : public Component
 {
     URHO3D_OBJECT(LogicComponent, Component);
 
+    friend class LogicUpdateRegistry;
+
     /// Construct.
     explicit LogicComponent(Context* context);
     /// Destruct.
@@ -82,6 +86,12 @@ class URHO3D_API LogicComponent : public Component
     /// Return what update events are subscribed to.
     UpdateEventFlags GetUpdateEventMask() const { return updateEventMask_; }
 
+    /// Set whether the update functions are thread-safe, so that components of the same type can be updated in parallel in the worker threads. Update functions may then not create or remove logic components or send events. Delayed start is still called in the main thread. Should be called eg. in the subclass constructor.
+    void SetParallelUpdate(bool enable);
+
+    /// Return whether the update functions may be called in parallel in the worker threads.
+    bool GetParallelUpdate() const { return parallelUpdate_; }
+
     /// Return whether the DelayedStart() function has been called.
     bool IsDelayedStartCalled() const { return delayedStartCalled_; }
 
@@ -92,24 +102,21 @@ protected:
     void OnSceneSet(Scene* scene) override;
 
 private:
-    /// Subscribe/unsubscribe to update events based on current enabled state and update event mask.
+    /// Add to/remove from the scene's update registry based on current enabled state and update event mask.
     void UpdateEventSubscription();
-    /// Handle scene update event.
-    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
-    /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
-#if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
-    /// Handle physics pre-step event.
-    void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
-    /// Handle physics post-step event.
-    void HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData);
-#endif
+    /// Remove from the update registry.
+    void RemoveEventSubscription();
+
+    /// Update registry the component is currently added to.
+    WeakPtr<LogicUpdateRegistry> updateRegistry_;
     /// Requested event subscription mask.
     UpdateEventFlags updateEventMask_;
     /// Current event subscription mask.
     UpdateEventFlags currentEventMask_;
     /// Flag for delayed start.
     bool delayedStartCalled_;
+    /// Parallel update flag.
+    bool parallelUpdate_;
 };
 
 }
@@ -0,0 +1,324 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "../Precompiled.h"
+
+#include "../Core/Profiler.h"
+#include "../Core/WorkQueue.h"
+#if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
+#include "../Physics/PhysicsEvents.h"
+#endif
+#include "../Scene/LogicUpdateRegistry.h"
+#include "../Scene/Scene.h"
+
+#include "../DebugNew.h"
+
+namespace Urho3D
+{
+
+/// Logic update phases.
+enum LogicUpdatePhase
+{
+    PHASE_UPDATE = 0,
+    PHASE_POSTUPDATE,
+    PHASE_FIXEDUPDATE,
+    PHASE_FIXEDPOSTUPDATE
+};
+
+/// Update event of each phase.
+static const UpdateEvent PHASE_EVENTS[] =
+{
+    USE_UPDATE,
+    USE_POSTUPDATE,
+    USE_FIXEDUPDATE,
+    USE_FIXEDPOSTUPDATE
+};
+
+/// Number of components per parallel update work chunk.
+static const unsigned PARALLEL_UPDATE_GRAIN_SIZE = 64;
+
+/// Call the update function of a phase.
+static inline void CallUpdate(unsigned phase, LogicComponent* component, float timeStep)
+{
+    switch (phase)
+    {
+    case PHASE_UPDATE:
+        component->Update(timeStep);
+        break;
+
+    case PHASE_POSTUPDATE:
+        component->PostUpdate(timeStep);
+        break;
+
+    case PHASE_FIXEDUPDATE:
+        component->FixedUpdate(timeStep);
+        break;
+
+    default:
+        component->FixedPostUpdate(timeStep);
+        break;
+    }
+}
+
+LogicUpdateRegistry::LogicUpdateRegistry(Scene* scene) :
+    Object(scene->GetContext()),
+    scene_(scene),
+    inUpdate_(0),
+    dirty_(false)
+{
+}
+
+LogicUpdateRegistry::~LogicUpdateRegistry() = default;
+
+void LogicUpdateRegistry::AddComponent(LogicComponent* component, UpdateEventFlags events, Component* fixedUpdateSource)
+{
+    if (!component)
+        return;
+
+    for (unsigned i = 0; i < NUM_LOGIC_UPDATE_PHASES; ++i)
+    {
+        if (events & PHASE_EVENTS[i])
+            GetGroup(i, component, true)->components_.Push(component);
+    }
+
+#if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
+    if ((events & (USE_FIXEDUPDATE | USE_FIXEDPOSTUPDATE)) && fixedUpdateSource && fixedUpdateSource != fixedUpdateSource_)
+    {
+        if (fixedUpdateSource_)
+        {
+            UnsubscribeFromEvent(fixedUpdateSource_, E_PHYSICSPRESTEP);
+            UnsubscribeFromEvent(fixedUpdateSource_, E_PHYSICSPOSTSTEP);
+        }
+
+        fixedUpdateSource_ = fixedUpdateSource;
+        SubscribeToEvent(fixedUpdateSource, E_PHYSICSPRESTEP, URHO3D_HANDLER(LogicUpdateRegistry, HandlePhysicsPreStep));
+        SubscribeToEvent(fixedUpdateSource, E_PHYSICSPOSTSTEP, URHO3D_HANDLER(LogicUpdateRegistry, HandlePhysicsPostStep));
+    }
+#endif
+}
+
+void LogicUpdateRegistry::RemoveComponent(LogicComponent* component, UpdateEventFlags events)
+{
+    for (unsigned i = 0; i < NUM_LOGIC_UPDATE_PHASES; ++i)
+    {
+        if (!(events & PHASE_EVENTS[i]))
+            continue;
+
+        UpdateGroup* group = GetGroup(i, component, false);
+        if (!group)
+            continue;
+
+        if (inUpdate_ > 0)
+        {
+            PODVector<LogicComponent*>::Iterator j = group->components_.Find(component);
+            if (j != group->components_.End())
+            {
+                (*j) = nullptr;
+                dirty_ = true;
+            }
+        }
+        else
+            group->components_.Remove(component);
+    }
+}
+
+void LogicUpdateRegistry::Update(float timeStep)
+{
+    URHO3D_PROFILE(UpdateLogicComponents);
+
+    RunPhase(PHASE_UPDATE, timeStep);
+}
+
+void LogicUpdateRegistry::PostUpdate(float timeStep)
+{
+    URHO3D_PROFILE(PostUpdateLogicComponents);
+
+    RunPhase(PHASE_POSTUPDATE, timeStep);
+}
+
+unsigned LogicUpdateRegistry::GetNumComponents(UpdateEvent event) const
+{
+    unsigned ret = 0;
+
+    for (unsigned i = 0; i < NUM_LOGIC_UPDATE_PHASES; ++i)
+    {
+        if (PHASE_EVENTS[i] != event)
+            continue;
+
+        for (Vector<UpdateGroup>::ConstIterator j = groups_[i].Begin(); j != groups_[i].End(); ++j)
+        {
+            for (PODVector<LogicComponent*>::ConstIterator k = j->components_.Begin(); k != j->components_.End(); ++k)
+            {
+                if (*k)
+                    ++ret;
+            }
+        }
+    }
+
+    return ret;
+}
+
+LogicUpdateRegistry::UpdateGroup* LogicUpdateRegistry::GetGroup(unsigned phase, LogicComponent* component, bool create)
+{
+    StringHash type = component->GetType();
+    bool parallel = component->GetParallelUpdate();
+    Vector<UpdateGroup>& groups = groups_[phase];
+
+    // The number of distinct logic component types is small, so a linear search is sufficient
+    for (Vector<UpdateGroup>::Iterator i = groups.Begin(); i != groups.End(); ++i)
+    {
+        if (i->type_ == type && i->parallel_ == parallel)
+            return &(*i);
+    }
+
+    if (!create)
+        return nullptr;
+
+    groups.Resize(groups.Size() + 1);
+    UpdateGroup& group = groups.Back();
+    group.type_ = type;
+    group.parallel_ = parallel;
+    return &group;
+}
+
+void LogicUpdateRegistry::RunPhase(unsigned phase, float timeStep)
+{
+    auto* queue = GetSubsystem<WorkQueue>();
+
+    ++inUpdate_;
+
+    // Groups or components may be added during update, so do not hold references to them across update function calls.
+    // Components added during update are updated on the next frame
+    const unsigned numGroups = groups_[phase].Size();
+    for (unsigned i = 0; i < numGroups; ++i)
+    {
+        if (groups_[phase][i].parallel_ && queue && queue->GetNumThreads())
+        {
+            RunPhaseParallel(phase, i, timeStep);
+            continue;
+        }
+
+        const unsigned numComponents = groups_[phase][i].components_.Size();
+        for (unsigned j = 0; j < numComponents; ++j)
+        {
+            LogicComponent* component = groups_[phase][i].components_[j];
+            // Holes may exist if components removed during update
+            if (!component || !CheckDelayedStart(phase, component))
+                continue;
+
+            CallUpdate(phase, component, timeStep);
+        }
+    }
+
+    if (--inUpdate_ == 0 && dirty_)
+        Cleanup();
+}
+
+void LogicUpdateRegistry::RunPhaseParallel(unsigned phase, unsigned groupIndex, float timeStep)
+{
+    // Delayed start is not required to be thread-safe, so call it first in the main thread
+    const unsigned numComponents = groups_[phase][groupIndex].components_.Size();
+    for (unsigned i = 0; i < numComponents; ++i)
+    {
+        LogicComponent* component = groups_[phase][groupIndex].components_[i];
+        if (component)
+            CheckDelayedStart(phase, component);
+    }
+
+    // Parallel update functions must not add or remove components, so the array stays valid until done
+    PODVector<LogicComponent*>& components = groups_[phase][groupIndex].components_;
+
+    scene_->BeginThreadedUpdate();
+    GetSubsystem<WorkQueue>()->ParallelFor(0, components.Size(), PARALLEL_UPDATE_GRAIN_SIZE,
+        [&](unsigned begin, unsigned end, unsigned threadIndex)
+        {
+            for (unsigned i = begin; i < end; ++i)
+            {
+                LogicComponent* component = components[i];
+                if (component)
+                    CallUpdate(phase, component, timeStep);
+            }
+        });
+    scene_->EndThreadedUpdate();
+}
+
+bool LogicUpdateRegistry::CheckDelayedStart(unsigned phase, LogicComponent* component)
+{
+    // Execute user-defined delayed start function before the first update or fixed update
+    if (component->delayedStartCalled_ || (phase != PHASE_UPDATE && phase != PHASE_FIXEDUPDATE))
+        return true;
+
+    component->DelayedStart();
+    component->delayedStartCalled_ = true;
+
+    // If did not need actual update events, stop updating now
+    if (phase == PHASE_UPDATE && !(component->updateEventMask_ & USE_UPDATE))
+    {
+        RemoveComponent(component, USE_UPDATE);
+        component->currentEventMask_ &= ~USE_UPDATE;
+        return false;
+    }
+
+    return true;
+}
+
+void LogicUpdateRegistry::Cleanup()
+{
+    for (unsigned i = 0; i < NUM_LOGIC_UPDATE_PHASES; ++i)
+    {
+        for (Vector<UpdateGroup>::Iterator j = groups_[i].Begin(); j != groups_[i].End(); ++j)
+        {
+            // Compact while keeping the update order
+            PODVector<LogicComponent*>& components = j->components_;
+            unsigned numValid = 0;
+            for (unsigned k = 0; k < components.Size(); ++k)
+            {
+                if (components[k])
+                    components[numValid++] = components[k];
+            }
+            components.Resize(numValid);
+        }
+    }
+
+    dirty_ = false;
+}
+
+#if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
+
+void LogicUpdateRegistry::HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData)
+{
+    using namespace PhysicsPreStep;
+
+    RunPhase(PHASE_FIXEDUPDATE, eventData[P_TIMESTEP].GetFloat());
+}
+
+void LogicUpdateRegistry::HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData)
+{
+    using namespace PhysicsPostStep;
+
+    RunPhase(PHASE_FIXEDPOSTUPDATE, eventData[P_TIMESTEP].GetFloat());
+}
+
+#endif
+
+}
@@ -0,0 +1,100 @@
+//
+// Copyright (c) 2008-2020 the Urho3D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "../Scene/LogicComponent.h"
+
+namespace Urho3D
+{
+
+class Scene;
+
+/// Number of logic update phases, one for each UpdateEvent bit.
+static const unsigned NUM_LOGIC_UPDATE_PHASES = 4;
+
+/// %Scene-level registry that calls the update functions of logic components directly instead of through events. Components are grouped by type into contiguous arrays.
+class URHO3D_API LogicUpdateRegistry : public Object
+{
+    URHO3D_OBJECT(LogicUpdateRegistry, Object);
+
+public:
+    /// Construct.
+    explicit LogicUpdateRegistry(Scene* scene);
+    /// Destruct.
+    ~LogicUpdateRegistry() override;
+
+    /// Add a component to the update lists of the given events. The fixed update events are received from the fixed update source (physics world). Same component must not be double-added!
+    void AddComponent(LogicComponent* component, UpdateEventFlags events, Component* fixedUpdateSource);
+    /// Remove a component from the update lists of the given events. Leaves holes during update, which requires later cleanup.
+    void RemoveComponent(LogicComponent* component, UpdateEventFlags events);
+    /// Run the variable timestep update of the components. Called by Scene.
+    void Update(float timeStep);
+    /// Run the variable timestep post-update of the components. Called by Scene.
+    void PostUpdate(float timeStep);
+
+    /// Return number of components using an update event.
+    unsigned GetNumComponents(UpdateEvent event) const;
+
+private:
+    /// Components of one type using one update event.
+    struct UpdateGroup
+    {
+        /// Component type.
+        StringHash type_;
+        /// Parallel update flag of the components.
+        bool parallel_;
+        /// Components. May contain holes during update.
+        PODVector<LogicComponent*> components_;
+    };
+
+    /// Return group for a component in an update phase, optionally creating it. Return null if not found.
+    UpdateGroup* GetGroup(unsigned phase, LogicComponent* component, bool create);
+    /// Run an update phase.
+    void RunPhase(unsigned phase, float timeStep);
+    /// Run an update phase for a group in the worker threads.
+    void RunPhaseParallel(unsigned phase, unsigned groupIndex, float timeStep);
+    /// Call delayed start if necessary. Return false if the component no longer needs the update phase.
+    bool CheckDelayedStart(unsigned phase, LogicComponent* component);
+    /// Remove holes left by components removed during update.
+    void Cleanup();
+#if defined(URHO3D_PHYSICS) || defined(URHO3D_URHO2D)
+    /// Handle physics pre-step event.
+    void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
+    /// Handle physics post-step event.
+    void HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData);
+#endif
+
+    /// Owner scene.
+    Scene* scene_;
+    /// Fixed update source that the physics step events are received from.
+    WeakPtr<Component> fixedUpdateSource_;
+    /// Component groups per update phase.
+    Vector<UpdateGroup> groups_[NUM_LOGIC_UPDATE_PHASES];
+    /// Update recursion counter.
+    unsigned inUpdate_;
+    /// Cleanup required flag.
+    bool dirty_;
+};
+
+}
@@ -34,6 +34,7 @@
 #include "../Resource/XMLFile.h"
 #include "../Resource/JSONFile.h"
 #include "../Scene/Component.h"
+#include "../Scene/LogicUpdateRegistry.h"
 #include "../Scene/ObjectAnimation.h"
 #include "../Scene/ReplicationState.h"
 #include "../Scene/Scene.h"
@@ -780,6 +781,8 @@ void Scene::Update(float timeStep)
 
     // Update variable timestep logic
     SendEvent(E_SCENEUPDATE, eventData);
+    if (logicUpdateRegistry_)
+        logicUpdateRegistry_->Update(timeStep);
 
     // Update scene attribute animation.
     SendEvent(E_ATTRIBUTEANIMATIONUPDATE, eventData);
@@ -803,6 +806,8 @@ void Scene::Update(float timeStep)
 
     // Post-update variable timestep logic
     SendEvent(E_SCENEPOSTUPDATE, eventData);
+    if (logicUpdateRegistry_)
+        logicUpdateRegistry_->PostUpdate(timeStep);
 
     // Note: using a float for elapsed time accumulation is inherently inaccurate. The purpose of this value is
     // primarily to update material animation effects, as it is available to shaders. It can be reset by calling
@@ -834,6 +839,13 @@ void Scene::EndThreadedUpdate()
     }
 }
 
+LogicUpdateRegistry* Scene::GetLogicUpdateRegistry()
+{
+    if (!logicUpdateRegistry_)
+        logicUpdateRegistry_ = new LogicUpdateRegistry(this);
+    return logicUpdateRegistry_;
+}
+
 void Scene::DelayedMarkedDirty(Component* component)
 {
     MutexLock lock(sceneMutex_);
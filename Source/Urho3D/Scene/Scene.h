@@ -35,6 +35,7 @@ namespace Urho3D
 {
 
 class File;
+class LogicUpdateRegistry;
 class PackageFile;
 
 static const unsigned FIRST_REPLICATED_ID = 0x1;
@@ -245,6 +246,10 @@ public:
 
     /// Return threaded update flag.
     bool IsThreadedUpdate() const { return threadedUpdate_; }
+    /// Return the logic component update registry. Created on first use.
+    LogicUpdateRegistry* GetLogicUpdateRegistry();
+    /// Return mutex for adding and removing network replication states, and the weak references they hold, while server updates are being sent from worker threads.
+    Mutex& GetReplicationMutex() { return replicationMutex_; }
 
     /// Get free node ID, either non-local or local.
     unsigned GetFreeNodeID(CreateMode mode);
@@ -330,6 +335,10 @@ private:
     PODVector<Component*> delayedDirtyComponents_;
     /// Mutex for the delayed dirty notification queue.
     Mutex sceneMutex_;
+    /// Mutex for network replication state changes during threaded server updates.
+    Mutex replicationMutex_;
+    /// Logic component update registry.
+    SharedPtr<LogicUpdateRegistry> logicUpdateRegistry_;
     /// Preallocated event data map for smoothing update events.
     VariantMap smoothingData_;
     /// Next free non-local node ID.
@@ -46,6 +46,8 @@ public:
     void ApplyAttributes() override;
     /// Return UI rendering batches.
     void GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor) override;
+    /// Return whether the batches can be retained. False, as the selected item is rendered from the popup.
+    bool CanRetainBatches() const override { return false; }
     /// React to the popup being shown.
     void OnShowPopup() override;
     /// React to the popup being hidden.
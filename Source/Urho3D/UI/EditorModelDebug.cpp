@@ -18,6 +18,8 @@
 #include "../Resource/ResourceCache.h"
 #include "../Resource/ResourceEvents.h"
 
+#include <cstdio>
+
 namespace Urho3D
 {
 
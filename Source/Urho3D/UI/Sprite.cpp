@@ -141,6 +141,8 @@ void Sprite::SetPosition(const Vector2& position)
         // Copy to the integer position
         position_ = IntVector2((int)position.x_, (int)position.y_);
         MarkDirty();
+        if (parent_)
+            parent_->MarkHitTestDirty();
     }
 }
 
@@ -155,6 +157,7 @@ void Sprite::SetHotSpot(const IntVector2& hotSpot)
     {
         hotSpot_ = hotSpot;
         MarkDirty();
+        MarkHitTestDirty();
     }
 }
 
@@ -169,6 +172,7 @@ void Sprite::SetScale(const Vector2& scale)
     {
         scale_ = scale;
         MarkDirty();
+        MarkHitTestDirty();
     }
 }
 
@@ -188,6 +192,7 @@ void Sprite::SetRotation(float angle)
     {
         rotation_ = angle;
         MarkDirty();
+        MarkHitTestDirty();
     }
 }
 
@@ -196,12 +201,16 @@ void Sprite::SetTexture(Texture* texture)
     texture_ = texture;
     if (imageRect_ == IntRect::ZERO)
         SetFullImageRect();
+    MarkBatchesDirty();
 }
 
 void Sprite::SetImageRect(const IntRect& rect)
 {
     if (rect != IntRect::ZERO)
+    {
         imageRect_ = rect;
+        MarkBatchesDirty();
+    }
 }
 
 void Sprite::SetFullImageRect()
@@ -213,6 +222,7 @@ void Sprite::SetFullImageRect()
 void Sprite::SetBlendMode(BlendMode mode)
 {
     blendMode_ = mode;
+    MarkBatchesDirty();
 }
 
 const Matrix3x4& Sprite::GetTransform() const
@@ -117,6 +117,12 @@ void Text::ApplyAttributes()
     UpdateText();
 }
 
+bool Text::CanRetainBatches() const
+{
+    // Mutable glyphs may be evicted from the font texture by other text, so they must be reacquired every frame
+    return !charLocationsDirty_ && fontFace_ && font_ && font_->GetFace(fontSize_) == fontFace_ && !fontFace_->HasMutableGlyphs();
+}
+
 void Text::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor)
 {
     FontFace* face = font_ ? font_->GetFace(fontSize_) : nullptr;
@@ -314,6 +320,7 @@ void Text::SetTextAlignment(HorizontalAlignment align)
     {
         textAlignment_ = align;
         charLocationsDirty_ = true;
+        MarkBatchesDirty();
     }
 }
 
@@ -373,42 +380,50 @@ void Text::SetSelection(unsigned start, unsigned length)
     selectionStart_ = start;
     selectionLength_ = length;
     ValidateSelection();
+    MarkBatchesDirty();
 }
 
 void Text::ClearSelection()
 {
     selectionStart_ = 0;
     selectionLength_ = 0;
+    MarkBatchesDirty();
 }
 
 void Text::SetTextEffect(TextEffect textEffect)
 {
     textEffect_ = textEffect;
+    MarkBatchesDirty();
 }
 
 void Text::SetEffectShadowOffset(const IntVector2& offset)
 {
     shadowOffset_ = offset;
+    MarkBatchesDirty();
 }
 
 void Text::SetEffectStrokeThickness(int thickness)
 {
     strokeThickness_ = Abs(thickness);
+    MarkBatchesDirty();
 }
 
 void Text::SetEffectRoundStroke(bool roundStroke)
 {
     roundStroke_ = roundStroke;
+    MarkBatchesDirty();
 }
 
 void Text::SetEffectColor(const Color& effectColor)
 {
     effectColor_ = effectColor;
+    MarkBatchesDirty();
 }
 
 void Text::SetEffectDepthBias(float bias)
 {
     effectDepthBias_ = bias;
+    MarkBatchesDirty();
 }
 
 float Text::GetRowWidth(unsigned index) const
@@ -486,6 +501,7 @@ bool Text::FilterImplicitAttributes(XMLElement& dest) const
 
 void Text::UpdateText(bool onResize)
 {
+    MarkBatchesDirty();
     rowWidths_.Clear();
     printText_.Clear();
 
@@ -91,6 +91,8 @@ public:
     void ApplyAttributes() override;
     /// Return UI rendering batches.
     void GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, const IntRect& currentScissor) override;
+    /// Return whether the batches can be retained.
+    bool CanRetainBatches() const override;
     /// React to resize.
     void OnResize(const IntVector2& newSize, const IntVector2& delta) override;
     /// React to indent change.
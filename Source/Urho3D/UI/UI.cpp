@@ -86,6 +86,8 @@ const float DEFAULT_DRAGBEGIN_INTERVAL = 0.5f;
 const float DEFAULT_TOOLTIP_DELAY = 0.5f;
 const int DEFAULT_DRAGBEGIN_DISTANCE = 5;
 const int DEFAULT_FONT_TEXTURE_MAX_SIZE = 2048;
+/// How many merged batches back a retained batch may be moved to join a batch with the same state.
+const unsigned MAX_BATCH_MERGE_DISTANCE = 32;
 
 const char* UI_CATEGORY = "UI";
 
@@ -122,6 +124,14 @@ UI::UI(Context* context) :
     fontOversampling_(2),
     uiRendered_(false),
     nonModalBatchSize_(0),
+    nonModalRetainedBatchSize_(0),
+    batchRangeID_(0),
+    frameBatchRangeID_(0),
+    numElementsRebuilt_(0),
+    numBatchesRebuilt_(0),
+    retainBatches_(true),
+    retainedBatchesChanged_(false),
+    vertexDataDirty_(true),
     dragElementsCount_(0),
     dragConfirmedCount_(0),
     uiScale_(1.0f),
@@ -209,6 +219,7 @@ void UI::SetFocusElement(UIElement* element, bool byKey)
     {
         UIElement* oldFocusElement = focusElement_;
         focusElement_.Reset();
+        oldFocusElement->MarkBatchesDirty();
 
         VariantMap& focusEventData = GetEventDataMap();
         focusEventData[Defocused::P_ELEMENT] = oldFocusElement;
@@ -219,6 +230,7 @@ void UI::SetFocusElement(UIElement* element, bool byKey)
     if (element && element->GetFocusMode() >= FM_FOCUSABLE)
     {
         focusElement_ = element;
+        element->MarkBatchesDirty();
 
         VariantMap& focusEventData = GetEventDataMap();
         focusEventData[Focused::P_ELEMENT] = element;
@@ -421,29 +433,37 @@ void UI::RenderUpdate()
 
     // If the OS cursor is visible, do not render the UI's own cursor
     bool osCursorVisible = GetSubsystem<Input>()->IsMouseVisible();
+    bool drawCursor = cursor_ && cursor_->IsVisible() && !osCursorVisible;
 
-    // Get rendering batches from the non-modal UI elements
-    batches_.Clear();
-    vertexData_.Clear();
-    const IntVector2& rootSize = rootElement_->GetSize();
-    const IntVector2& rootPos = rootElement_->GetPosition();
-    // Note: the scissors operate on unscaled coordinates. Scissor scaling is only performed during render
-    IntRect currentScissor = IntRect(rootPos.x_, rootPos.y_, rootPos.x_ + rootSize.x_, rootPos.y_ + rootSize.y_);
-    if (rootElement_->IsVisible())
-        GetBatches(batches_, vertexData_, rootElement_, currentScissor);
+    if (retainBatches_)
+        UpdateRetainedBatches(drawCursor);
+    else
+    {
+        // Get rendering batches from the non-modal UI elements
+        batches_.Clear();
+        vertexData_.Clear();
+        const IntVector2& rootSize = rootElement_->GetSize();
+        const IntVector2& rootPos = rootElement_->GetPosition();
+        // Note: the scissors operate on unscaled coordinates. Scissor scaling is only performed during render
+        IntRect currentScissor = IntRect(rootPos.x_, rootPos.y_, rootPos.x_ + rootSize.x_, rootPos.y_ + rootSize.y_);
+        if (rootElement_->IsVisible())
+            GetBatches(batches_, vertexData_, rootElement_, currentScissor);
 
-    // Save the batch size of the non-modal batches for later use
-    nonModalBatchSize_ = batches_.Size();
+        // Save the batch size of the non-modal batches for later use
+        nonModalBatchSize_ = batches_.Size();
 
-    // Get rendering batches from the modal UI elements
-    GetBatches(batches_, vertexData_, rootModalElement_, currentScissor);
+        // Get rendering batches from the modal UI elements
+        GetBatches(batches_, vertexData_, rootModalElement_, currentScissor);
 
-    // Get batches from the cursor (and its possible children) last to draw it on top of everything
-    if (cursor_ && cursor_->IsVisible() && !osCursorVisible)
-    {
-        currentScissor = IntRect(0, 0, rootSize.x_, rootSize.y_);
-        cursor_->GetBatches(batches_, vertexData_, currentScissor);
-        GetBatches(batches_, vertexData_, cursor_, currentScissor);
+        // Get batches from the cursor (and its possible children) last to draw it on top of everything
+        if (drawCursor)
+        {
+            currentScissor = IntRect(0, 0, rootSize.x_, rootSize.y_);
+            cursor_->GetBatches(batches_, vertexData_, currentScissor);
+            GetBatches(batches_, vertexData_, cursor_, currentScissor);
+        }
+
+        vertexDataDirty_ = true;
     }
 
     // Get batches for UI elements rendered into textures. Each element rendered into texture is treated as root element.
@@ -495,7 +515,12 @@ void UI::Render(bool renderUICommand)
     // Perform the default backbuffer render only if not rendered yet, or additional renders through RenderUI command
     if (renderUICommand || !uiRendered_)
     {
-        SetVertexData(vertexBuffer_, vertexData_);
+        // The retained batches may not have changed since the last upload
+        if (vertexDataDirty_ || vertexBuffer_->IsDataLost())
+        {
+            SetVertexData(vertexBuffer_, vertexData_);
+            vertexDataDirty_ = false;
+        }
         SetVertexData(debugVertexBuffer_, debugVertexData_);
 
         if (!renderUICommand)
@@ -766,6 +791,18 @@ void UI::SetCustomSize(int width, int height)
     ResizeRootElement();
 }
 
+void UI::SetRetainBatches(bool enable)
+{
+    if (enable == retainBatches_)
+        return;
+
+    retainBatches_ = enable;
+    // Regenerate all batches when retaining is enabled again, as the element hierarchy may have changed meanwhile
+    frameBatchRangeID_ = 0;
+    numElementsRebuilt_ = 0;
+    numBatchesRebuilt_ = 0;
+}
+
 IntVector2 UI::GetCursorPosition() const
 {
     if (cursor_)
@@ -1219,6 +1256,314 @@ void UI::GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, U
     }
 }
 
+void UI::UpdateRetainedBatches(bool drawCursor)
+{
+    // Keep the previous frame's batches for copying the batches of unchanged elements
+    retainedBatches_.Swap(prevRetainedBatches_);
+    retainedVertexData_.Swap(prevRetainedVertexData_);
+    retainedBatches_.Clear();
+    retainedVertexData_.Clear();
+    retainedBatchesChanged_ = false;
+    numElementsRebuilt_ = 0;
+    numBatchesRebuilt_ = 0;
+
+    // The top-level elements are stored relative to the start of the retained batches
+    unsigned prevID = frameBatchRangeID_;
+    frameBatchRangeID_ = NextBatchRangeID();
+
+    const IntVector2& rootSize = rootElement_->GetSize();
+    const IntVector2& rootPos = rootElement_->GetPosition();
+    // Note: the scissors operate on unscaled coordinates. Scissor scaling is only performed during render
+    IntRect currentScissor = IntRect(rootPos.x_, rootPos.y_, rootPos.x_ + rootSize.x_, rootPos.y_ + rootSize.y_);
+    if (rootElement_->IsVisible())
+        GetRetainedBatches(rootElement_, currentScissor, 0, prevID, 0, frameBatchRangeID_);
+    else
+        ClearBatchesDirty(rootElement_);
+
+    unsigned nonModalBatchSize = retainedBatches_.Size();
+    GetRetainedBatches(rootModalElement_, currentScissor, 0, prevID, 0, frameBatchRangeID_);
+
+    if (drawCursor)
+    {
+        currentScissor = IntRect(0, 0, rootSize.x_, rootSize.y_);
+        GetRetainedElementBatches(cursor_, currentScissor, 0, prevID, 0, frameBatchRangeID_);
+        GetRetainedBatches(cursor_, currentScissor, 0, prevID, 0, frameBatchRangeID_);
+    }
+
+    // If every element copied its batches to the same position as on the previous frame, the merged batches are still valid
+    if (!retainedBatchesChanged_ && retainedBatches_.Size() == prevRetainedBatches_.Size() &&
+        nonModalBatchSize == nonModalRetainedBatchSize_)
+        return;
+
+    URHO3D_PROFILE(MergeUIBatches);
+
+    nonModalRetainedBatchSize_ = nonModalBatchSize;
+    batches_.Clear();
+    vertexData_.Clear();
+    vertexData_.Reserve(retainedVertexData_.Size());
+    mergedBatches_.Clear();
+    mergeLinks_.Resize(retainedBatches_.Size());
+
+    // The modal batches are merged separately, as the debug draw is rendered in between
+    MergeBatches(0, nonModalBatchSize);
+    nonModalBatchSize_ = batches_.Size();
+    MergeBatches(nonModalBatchSize, retainedBatches_.Size());
+    vertexDataDirty_ = true;
+}
+
+bool UI::GetRetainedBatches(UIElement* element, IntRect currentScissor, unsigned prevBase, unsigned prevID, unsigned base,
+    unsigned id)
+{
+    UIBatchRange& range = element->childBatchRange_;
+    bool prevValid = prevID && range.parentID_ == prevID;
+
+    // If nothing has changed in the child hierarchy, copy all of its batches from the previous frame
+    if (prevValid && !element->childBatchesDirty_ && range.scissor_ == currentScissor)
+    {
+        CopyRetainedBatches(range, prevBase, base, id);
+        return true;
+    }
+
+    // The children's ranges are relative to this range, and are valid only as long as its generation ID is unchanged
+    unsigned childPrevBase = prevBase + range.start_;
+    unsigned childPrevID = prevValid ? range.id_ : 0;
+    unsigned childBase = retainedBatches_.Size();
+    unsigned childID = NextBatchRangeID();
+
+    element->childBatchesDirty_ = false;
+    range.id_ = childID;
+    range.parentID_ = id;
+    range.scissor_ = currentScissor;
+    range.start_ = childBase - base;
+    range.end_ = range.start_;
+
+    // Set clipping scissor for child elements. No need to draw if zero size
+    element->AdjustScissor(currentScissor);
+    if (currentScissor.left_ == currentScissor.right_ || currentScissor.top_ == currentScissor.bottom_)
+    {
+        ClearBatchesDirty(element);
+        return true;
+    }
+
+    element->SortChildren();
+    const Vector<SharedPtr<UIElement> >& children = element->GetChildren();
+    bool retain = true;
+
+    // Same traversal as in GetBatches()
+    Vector<SharedPtr<UIElement> >::ConstIterator i = children.Begin();
+    if (element->GetTraversalMode() == TM_BREADTH_FIRST)
+    {
+        Vector<SharedPtr<UIElement> >::ConstIterator j = i;
+        while (i != children.End())
+        {
+            int currentPriority = (*i)->GetPriority();
+            while (j != children.End() && (*j)->GetPriority() == currentPriority)
+            {
+                if ((*j)->IsWithinScissor(currentScissor) && (*j) != cursor_)
+                    retain &= GetRetainedElementBatches(*j, currentScissor, childPrevBase, childPrevID, childBase, childID);
+                ++j;
+            }
+            while (i != j)
+            {
+                if ((*i) != cursor_)
+                {
+                    if ((*i)->IsVisible())
+                        retain &= GetRetainedBatches(*i, currentScissor, childPrevBase, childPrevID, childBase, childID);
+                    else
+                        ClearBatchesDirty(*i);
+                }
+                ++i;
+            }
+        }
+    }
+    else
+    {
+        while (i != children.End())
+        {
+            if ((*i) != cursor_)
+            {
+                if ((*i)->IsWithinScissor(currentScissor))
+                    retain &= GetRetainedElementBatches(*i, currentScissor, childPrevBase, childPrevID, childBase, childID);
+                if ((*i)->IsVisible())
+                    retain &= GetRetainedBatches(*i, currentScissor, childPrevBase, childPrevID, childBase, childID);
+                else
+                    ClearBatchesDirty(*i);
+            }
+            ++i;
+        }
+    }
+
+    range.end_ = retainedBatches_.Size() - base;
+    // If a child can not retain its batches, this hierarchy has to be traversed again on the next frame
+    if (!retain)
+        element->childBatchesDirty_ = true;
+    return retain;
+}
+
+bool UI::GetRetainedElementBatches(UIElement* element, const IntRect& currentScissor, unsigned prevBase, unsigned prevID,
+    unsigned base, unsigned id)
+{
+    UIBatchRange& range = element->batchRange_;
+
+    if (prevID && range.parentID_ == prevID && !element->batchesDirty_ && range.scissor_ == currentScissor &&
+        element->hovering_ == element->batchHovering_ && element->CanRetainBatches())
+    {
+        CopyRetainedBatches(range, prevBase, base, id);
+        // Reset hovering for next frame, as GetBatches() would
+        element->hovering_ = false;
+        return true;
+    }
+
+    element->batchesDirty_ = false;
+    element->batchHovering_ = element->hovering_;
+    range.parentID_ = id;
+    range.scissor_ = currentScissor;
+
+    unsigned start = retainedBatches_.Size();
+    unsigned vertexStart = retainedVertexData_.Size();
+    element->GetBatches(retainedBatches_, retainedVertexData_, currentScissor);
+
+    // If the first batch was merged into the previous element's last batch, split it again to keep the element ranges separate
+    if (start && retainedBatches_[start - 1].vertexEnd_ > vertexStart)
+    {
+        UIBatch batch = retainedBatches_[start - 1];
+        retainedBatches_[start - 1].vertexEnd_ = vertexStart;
+        batch.element_ = element;
+        batch.vertexStart_ = vertexStart;
+        retainedBatches_.Insert(start, batch);
+    }
+
+    range.start_ = start - base;
+    range.end_ = retainedBatches_.Size() - base;
+    ++numElementsRebuilt_;
+    numBatchesRebuilt_ += retainedBatches_.Size() - start;
+    retainedBatchesChanged_ = true;
+
+    return element->CanRetainBatches();
+}
+
+void UI::CopyRetainedBatches(UIBatchRange& range, unsigned prevBase, unsigned base, unsigned id)
+{
+    unsigned srcStart = prevBase + range.start_;
+    unsigned srcEnd = prevBase + range.end_;
+    unsigned start = retainedBatches_.Size();
+    assert(srcEnd <= prevRetainedBatches_.Size());
+
+    if (srcStart != start)
+        retainedBatchesChanged_ = true;
+
+    if (srcEnd > srcStart)
+    {
+        unsigned srcVertexStart = prevRetainedBatches_[srcStart].vertexStart_;
+        unsigned srcVertexEnd = prevRetainedBatches_[srcEnd - 1].vertexEnd_;
+        unsigned vertexStart = retainedVertexData_.Size();
+        retainedVertexData_.Resize(vertexStart + srcVertexEnd - srcVertexStart);
+        if (srcVertexEnd > srcVertexStart)
+            memcpy(&retainedVertexData_[vertexStart], &prevRetainedVertexData_[srcVertexStart], (srcVertexEnd - srcVertexStart) * sizeof(float));
+
+        retainedBatches_.Resize(start + srcEnd - srcStart);
+        for (unsigned i = srcStart; i < srcEnd; ++i)
+        {
+            UIBatch& batch = retainedBatches_[start + i - srcStart];
+            batch = prevRetainedBatches_[i];
+            batch.vertexData_ = &retainedVertexData_;
+            batch.vertexStart_ = batch.vertexStart_ - srcVertexStart + vertexStart;
+            batch.vertexEnd_ = batch.vertexEnd_ - srcVertexStart + vertexStart;
+        }
+    }
+
+    range.parentID_ = id;
+    range.start_ = start - base;
+    range.end_ = retainedBatches_.Size() - base;
+}
+
+void UI::ClearBatchesDirty(UIElement* element)
+{
+    element->childBatchesDirty_ = false;
+
+    const Vector<SharedPtr<UIElement> >& children = element->GetChildren();
+    for (Vector<SharedPtr<UIElement> >::ConstIterator i = children.Begin(); i != children.End(); ++i)
+    {
+        if ((*i)->childBatchesDirty_ && (*i) != cursor_)
+            ClearBatchesDirty(*i);
+    }
+}
+
+void UI::MergeBatches(unsigned start, unsigned end)
+{
+    unsigned firstMerged = mergedBatches_.Size();
+
+    for (unsigned i = start; i < end; ++i)
+    {
+        const UIBatch& batch = retainedBatches_[i];
+        mergeLinks_[i] = M_MAX_UNSIGNED;
+        if (batch.vertexEnd_ == batch.vertexStart_)
+            continue;
+
+        Rect bounds;
+        for (unsigned j = batch.vertexStart_; j < batch.vertexEnd_; j += UI_VERTEX_SIZE)
+            bounds.Merge(Vector2(retainedVertexData_[j], retainedVertexData_[j + 1]));
+
+        // Search back for a merged batch with the same state. A batch can not be moved behind a batch it overlaps
+        unsigned target = M_MAX_UNSIGNED;
+        unsigned searchEnd = Max(firstMerged, mergedBatches_.Size() - Min(mergedBatches_.Size(), MAX_BATCH_MERGE_DISTANCE));
+        for (unsigned j = mergedBatches_.Size(); j > searchEnd; --j)
+        {
+            const MergedBatch& merged = mergedBatches_[j - 1];
+            if (retainedBatches_[merged.first_].HasSameState(batch))
+            {
+                target = j - 1;
+                break;
+            }
+            if (bounds.min_.x_ < merged.bounds_.max_.x_ && bounds.max_.x_ > merged.bounds_.min_.x_ &&
+                bounds.min_.y_ < merged.bounds_.max_.y_ && bounds.max_.y_ > merged.bounds_.min_.y_)
+                break;
+        }
+
+        if (target != M_MAX_UNSIGNED)
+        {
+            MergedBatch& merged = mergedBatches_[target];
+            mergeLinks_[merged.last_] = i;
+            merged.last_ = i;
+            merged.bounds_.Merge(bounds);
+        }
+        else
+        {
+            MergedBatch merged;
+            merged.first_ = i;
+            merged.last_ = i;
+            merged.bounds_ = bounds;
+            mergedBatches_.Push(merged);
+        }
+    }
+
+    for (unsigned i = firstMerged; i < mergedBatches_.Size(); ++i)
+    {
+        UIBatch batch = retainedBatches_[mergedBatches_[i].first_];
+        batch.vertexData_ = &vertexData_;
+        batch.vertexStart_ = vertexData_.Size();
+
+        for (unsigned j = mergedBatches_[i].first_; j != M_MAX_UNSIGNED; j = mergeLinks_[j])
+        {
+            const UIBatch& src = retainedBatches_[j];
+            unsigned dest = vertexData_.Size();
+            vertexData_.Resize(dest + src.vertexEnd_ - src.vertexStart_);
+            memcpy(&vertexData_[dest], &retainedVertexData_[src.vertexStart_], (src.vertexEnd_ - src.vertexStart_) * sizeof(float));
+        }
+
+        batch.vertexEnd_ = vertexData_.Size();
+        batches_.Push(batch);
+    }
+}
+
+unsigned UI::NextBatchRangeID()
+{
+    // Zero means a range that has never been generated
+    if (!++batchRangeID_)
+        ++batchRangeID_;
+    return batchRangeID_;
+}
+
 void UI::GetElementAt(UIElement*& result, UIElement* current, const IntVector2& position, bool enabledOnly)
 {
     if (!current)
@@ -1226,6 +1571,32 @@ void UI::GetElementAt(UIElement*& result, UIElement* current, const IntVector2&
 
     current->SortChildren();
     const Vector<SharedPtr<UIElement> >& children = current->GetChildren();
+
+    // With many children, test only the children in the hit test grid cell at the position
+    const PODVector<unsigned>* hitTestChildren = current->GetHitTestChildren(position);
+    if (hitTestChildren)
+    {
+        for (PODVector<unsigned>::ConstIterator i = hitTestChildren->Begin(); i != hitTestChildren->End(); ++i)
+        {
+            UIElement* element = children[*i];
+            if (element == cursor_.Get() || !element->IsVisible())
+                continue;
+
+            // Store the current result, then recurse into its children. Because children are sorted from lowest to
+            // highest priority and the grid cell lists them in child order, the topmost match should remain
+            if (element->IsInside(position, true))
+            {
+                if (element->IsEnabled() || !enabledOnly)
+                    result = element;
+                if (element->GetNumChildren())
+                    GetElementAt(result, element, position, enabledOnly);
+            }
+            else if (element->GetNumChildren() && element->IsInsideCombined(position, true))
+                GetElementAt(result, element, position, enabledOnly);
+        }
+        return;
+    }
+
     LayoutMode parentLayoutMode = current->GetLayoutMode();
 
     for (unsigned i = 0; i < children.Size(); ++i)
@@ -148,6 +148,9 @@ public:
     void SetCustomSize(const IntVector2& size);
     /// Set custom size of the root element.
     void SetCustomSize(int width, int height);
+    /// Set whether to retain rendering batches between frames and regenerate only the elements that have changed. Default true.
+    /// @property
+    void SetRetainBatches(bool enable);
 
     /// Return root UI element.
     /// @property
@@ -264,6 +267,18 @@ public:
     /// @property
     const IntVector2& GetCustomSize() const { return customSize_; }
 
+    /// Return whether rendering batches are retained between frames.
+    /// @property
+    bool GetRetainBatches() const { return retainBatches_; }
+
+    /// Return number of elements whose batches were regenerated during the last render update.
+    /// @property
+    unsigned GetNumElementsRebuilt() const { return numElementsRebuilt_; }
+
+    /// Return number of batches regenerated during the last render update.
+    /// @property
+    unsigned GetNumBatchesRebuilt() const { return numBatchesRebuilt_; }
+
     /// Set texture to which element will be rendered.
     void SetElementRenderTexture(UIElement* element, Texture2D* texture);
 
@@ -306,6 +321,17 @@ private:
         SharedPtr<VertexBuffer> debugVertexBuffer_;
     };
 
+    /// Retained batches merged for rendering.
+    struct MergedBatch
+    {
+        /// First retained batch index.
+        unsigned first_;
+        /// Last retained batch index.
+        unsigned last_;
+        /// Screen bounds of the merged vertices.
+        Rect bounds_;
+    };
+
     /// Initialize when screen mode initially set.
     void Initialize();
     /// Update UI element logic recursively.
@@ -316,6 +342,20 @@ private:
     void Render(VertexBuffer* buffer, const PODVector<UIBatch>& batches, unsigned batchStart, unsigned batchEnd);
     /// Generate batches from an UI element recursively. Skip the cursor element.
     void GetBatches(PODVector<UIBatch>& batches, PODVector<float>& vertexData, UIElement* element, IntRect currentScissor);
+    /// Update the retained batches of the main UI hierarchy and merge them into the rendering batches if they changed.
+    void UpdateRetainedBatches(bool drawCursor);
+    /// Generate or copy the retained batches of an UI element's children recursively. Skip the cursor element. Return true if the batches can be reused on the next frame.
+    bool GetRetainedBatches(UIElement* element, IntRect currentScissor, unsigned prevBase, unsigned prevID, unsigned base, unsigned id);
+    /// Generate or copy the retained batches of an UI element itself. Return true if the batches can be reused on the next frame.
+    bool GetRetainedElementBatches(UIElement* element, const IntRect& currentScissor, unsigned prevBase, unsigned prevID, unsigned base, unsigned id);
+    /// Copy a batch range from the previous frame's retained batches.
+    void CopyRetainedBatches(UIBatchRange& range, unsigned prevBase, unsigned base, unsigned id);
+    /// Clear the child batches dirty flag of an element and its children that were skipped during batch generation.
+    void ClearBatchesDirty(UIElement* element);
+    /// Merge a range of retained batches with the same state into the rendering batches. Batches are reordered only past batches they do not overlap.
+    void MergeBatches(unsigned start, unsigned end);
+    /// Return a new nonzero batch range generation ID.
+    unsigned NextBatchRangeID();
     /// Return UI element at global screen coordinates. Return position converted to element's screen coordinates.
     UIElement* GetElementAt(const IntVector2& position, bool enabledOnly, IntVector2* elementScreenPosition);
     /// Return UI element at screen position recursively.
@@ -454,6 +494,34 @@ private:
     bool uiRendered_;
     /// Non-modal batch size (used internally for rendering).
     unsigned nonModalBatchSize_;
+    /// Retained batches of the current frame, in element order.
+    PODVector<UIBatch> retainedBatches_;
+    /// Retained vertex data of the current frame.
+    PODVector<float> retainedVertexData_;
+    /// Retained batches of the previous frame.
+    PODVector<UIBatch> prevRetainedBatches_;
+    /// Retained vertex data of the previous frame.
+    PODVector<float> prevRetainedVertexData_;
+    /// Merged batches (used internally for batch merging).
+    PODVector<MergedBatch> mergedBatches_;
+    /// Next retained batch index in the same merged batch (used internally for batch merging).
+    PODVector<unsigned> mergeLinks_;
+    /// Non-modal retained batch size.
+    unsigned nonModalRetainedBatchSize_;
+    /// Last batch range generation ID.
+    unsigned batchRangeID_;
+    /// Batch range generation ID of the top-level elements for the current frame.
+    unsigned frameBatchRangeID_;
+    /// Number of elements whose batches were regenerated during the last render update.
+    unsigned numElementsRebuilt_;
+    /// Number of batches regenerated during the last render update.
+    unsigned numBatchesRebuilt_;
+    /// Retain batches between frames flag.
+    bool retainBatches_;
+    /// Retained batches changed during the render update flag.
+    bool retainedBatchesChanged_;
+    /// Vertex data needs to be uploaded flag.
+    bool vertexDataDirty_;
     /// Timer used to trigger double click.
     Timer clickTimer_;
     /// UI element last clicked for tracking double clicks.
@@ -415,6 +415,14 @@ bool UIBatch::Merge(const UIBatch& batch)
     return true;
 }
 
+bool UIBatch::HasSameState(const UIBatch& batch) const
+{
+    return batch.blendMode_ == blendMode_ &&
+        batch.scissor_ == scissor_ &&
+        batch.texture_ == texture_ &&
+        batch.customMaterial_ == customMaterial_;
+}
+
 unsigned UIBatch::GetInterpolatedColor(float x, float y)
 {
     const IntVector2& size = element_->GetSize();
@@ -67,6 +67,8 @@ public:
         const Color& colB, const Color& colC, const Color& colD);
     /// Merge with another batch.
     bool Merge(const UIBatch& batch);
+    /// Return whether has the same render state as another batch, so that their vertices can be drawn in one call.
+    bool HasSameState(const UIBatch& batch) const;
     /// Return an interpolated color for the UI element.
     unsigned GetInterpolatedColor(float x, float y);
 
@@ -100,4 +102,19 @@ public:
     static Vector3 posAdjust;
 };
 
+/// Range of retained %UI batches generated for an element. Stored relative to the parent element's child batch range, so that it stays valid when the parent's batches are copied as a whole.
+struct URHO3D_API UIBatchRange
+{
+    /// Generation ID of a child batch range. Changes whenever the child batches are regenerated.
+    unsigned id_{};
+    /// Generation ID of the parent's child batch range this range is relative to. 0 if never generated.
+    unsigned parentID_{};
+    /// Scissor rectangle the batches were generated with.
+    IntRect scissor_;
+    /// Start index relative to the parent's child batch range.
+    unsigned start_{};
+    /// End index relative to the parent's child batch range.
+    unsigned end_{};
+};
+
 }
@@ -90,6 +90,24 @@ static bool CompareUIElements(const UIElement* lhs, const UIElement* rhs)
     return lhs->GetPriority() < rhs->GetPriority();
 }
 
+/// Minimum number of children for using a hit test grid.
+static const unsigned MIN_HIT_GRID_CHILDREN = 16;
+/// Maximum number of hit test grid cells per axis.
+static const int MAX_HIT_GRID_CELLS = 1024;
+
+/// Grid of child element indices by their combined rects. Stored relative to the element's screen position, so that it stays valid when the element or its ancestors move.
+struct UIHitGrid
+{
+    /// Grid bounds.
+    IntRect bounds_;
+    /// Cell size.
+    IntVector2 cellSize_;
+    /// Number of cells.
+    IntVector2 numCells_;
+    /// Child indices by cell, in child order.
+    Vector<PODVector<unsigned> > cells_;
+};
+
 XPathQuery UIElement::styleXPathQuery_("/elements/element[@type=$typeName]", "typeName:String");
 
 UIElement::UIElement(Context* context) :
@@ -529,6 +547,8 @@ void UIElement::SetPosition(const IntVector2& position)
         position_ = position;
         OnPositionSet(position);
         MarkDirty();
+        if (parent_)
+            parent_->MarkHitTestDirty();
 
         using namespace Positioned;
 
@@ -558,6 +578,7 @@ void UIElement::SetSize(const IntVector2& size)
     if (validatedSize != size_)
     {
         size_ = validatedSize;
+        MarkHitTestDirty();
 
         if (resizeNestingLevel_ == 1)
         {
@@ -703,6 +724,8 @@ void UIElement::SetHorizontalAlignment(HorizontalAlignment align)
         if (enableAnchor_)
             UpdateAnchoring();
         MarkDirty();
+        if (parent_)
+            parent_->MarkHitTestDirty();
     }
 }
 
@@ -736,6 +759,8 @@ void UIElement::SetVerticalAlignment(VerticalAlignment align)
         if (enableAnchor_)
             UpdateAnchoring();
         MarkDirty();
+        if (parent_)
+            parent_->MarkHitTestDirty();
     }
 }
 
@@ -803,6 +828,8 @@ void UIElement::SetPivot(const Vector2& pivot)
         pivotSet_ = true;
         pivot_ = pivot;
         MarkDirty();
+        if (parent_)
+            parent_->MarkHitTestDirty();
     }
 }
 
@@ -817,6 +844,7 @@ void UIElement::SetClipBorder(const IntRect& rect)
     clipBorder_.top_ = Max(rect.top_, 0);
     clipBorder_.right_ = Max(rect.right_, 0);
     clipBorder_.bottom_ = Max(rect.bottom_, 0);
+    MarkBatchesDirty();
 }
 
 void UIElement::SetColor(const Color& color)
@@ -825,6 +853,7 @@ void UIElement::SetColor(const Color& color)
         cornerColor = color;
     colorGradient_ = false;
     derivedColorDirty_ = true;
+    MarkBatchesDirty();
 }
 
 void UIElement::SetColor(Corner corner, const Color& color)
@@ -832,6 +861,7 @@ void UIElement::SetColor(Corner corner, const Color& color)
     colors_[corner] = color;
     colorGradient_ = false;
     derivedColorDirty_ = true;
+    MarkBatchesDirty();
 
     for (unsigned i = 0; i < MAX_UIELEMENT_CORNERS; ++i)
     {
@@ -847,7 +877,10 @@ void UIElement::SetPriority(int priority)
 
     priority_ = priority;
     if (parent_)
+    {
         parent_->sortOrderDirty_ = true;
+        parent_->MarkBatchesDirty();
+    }
 }
 
 void UIElement::SetOpacity(float opacity)
@@ -869,6 +902,8 @@ void UIElement::SetBringToBack(bool enable)
 void UIElement::SetClipChildren(bool enable)
 {
     clipChildren_ = enable;
+    MarkBatchesDirty();
+    MarkHitTestDirty();
 }
 
 void UIElement::SetSortChildren(bool enable)
@@ -877,21 +912,29 @@ void UIElement::SetSortChildren(bool enable)
         sortOrderDirty_ = true;
 
     sortChildren_ = enable;
+    MarkBatchesDirty();
 }
 
 void UIElement::SetUseDerivedOpacity(bool enable)
 {
     useDerivedOpacity_ = enable;
+    MarkDirty();
 }
 
 void UIElement::SetEnabled(bool enable)
 {
+    if (enable != enabled_)
+        MarkBatchesDirty();
+
     enabled_ = enable;
     enabledPrev_ = enable;
 }
 
 void UIElement::SetDeepEnabled(bool enable)
 {
+    if (enable != enabled_)
+        MarkBatchesDirty();
+
     enabled_ = enable;
 
     for (Vector<SharedPtr<UIElement> >::ConstIterator i = children_.Begin(); i != children_.End(); ++i)
@@ -900,6 +943,9 @@ void UIElement::SetDeepEnabled(bool enable)
 
 void UIElement::ResetDeepEnabled()
 {
+    if (enabledPrev_ != enabled_)
+        MarkBatchesDirty();
+
     enabled_ = enabledPrev_;
 
     for (Vector<SharedPtr<UIElement> >::ConstIterator i = children_.Begin(); i != children_.End(); ++i)
@@ -908,6 +954,9 @@ void UIElement::ResetDeepEnabled()
 
 void UIElement::SetEnabledRecursive(bool enable)
 {
+    if (enable != enabled_)
+        MarkBatchesDirty();
+
     enabled_ = enable;
     enabledPrev_ = enable;
 
@@ -951,6 +1000,9 @@ void UIElement::SetFocus(bool enable)
 
 void UIElement::SetSelected(bool enable)
 {
+    if (enable != selected_)
+        MarkBatchesDirty();
+
     selected_ = enable;
 }
 
@@ -964,6 +1016,7 @@ void UIElement::SetVisible(bool enable)
     if (enable != visible_)
     {
         visible_ = enable;
+        MarkBatchesDirty();
 
         // Parent's layout may change as a result of visibility change
         if (parent_)
@@ -1077,6 +1130,7 @@ void UIElement::SetLayoutFlexScale(const Vector2& scale)
 void UIElement::SetIndent(int indent)
 {
     indent_ = indent;
+    MarkBatchesDirty();
     if (parent_)
         parent_->UpdateLayout();
     UpdateLayout();
@@ -1086,6 +1140,7 @@ void UIElement::SetIndent(int indent)
 void UIElement::SetIndentSpacing(int indentSpacing)
 {
     indentSpacing_ = Max(indentSpacing, 0);
+    MarkBatchesDirty();
     if (parent_)
         parent_->UpdateLayout();
     UpdateLayout();
@@ -1317,6 +1372,7 @@ void UIElement::InsertChild(unsigned index, UIElement* element)
 
     element->parent_ = this;
     element->MarkDirty();
+    MarkHitTestDirty();
 
     // Apply style now if child element (and its children) has it defined
     ApplyStyleRecursive(element);
@@ -1362,6 +1418,8 @@ void UIElement::RemoveChild(UIElement* element, unsigned index)
 
             element->Detach();
             children_.Erase(i);
+            MarkBatchesDirty();
+            MarkHitTestDirty();
             UpdateLayout();
             return;
         }
@@ -1389,6 +1447,8 @@ void UIElement::RemoveChildAtIndex(unsigned index)
 
     children_[index]->Detach();
     children_.Erase(index);
+    MarkBatchesDirty();
+    MarkHitTestDirty();
     UpdateLayout();
 }
 
@@ -1415,6 +1475,8 @@ void UIElement::RemoveAllChildren()
         (*i++)->Detach();
     }
     children_.Clear();
+    MarkBatchesDirty();
+    MarkHitTestDirty();
     UpdateLayout();
 }
 
@@ -1449,6 +1511,7 @@ void UIElement::SetInternal(bool enable)
 void UIElement::SetTraversalMode(TraversalMode traversalMode)
 {
     traversalMode_ = traversalMode;
+    MarkBatchesDirty();
 }
 
 void UIElement::SetElementEventSender(bool flag)
@@ -1763,26 +1826,36 @@ bool UIElement::IsInsideCombined(IntVector2 position, bool isScreen)
 IntRect UIElement::GetCombinedScreenRect()
 {
     IntVector2 screenPosition(GetScreenPosition());
-    IntRect combined(screenPosition.x_, screenPosition.y_, screenPosition.x_ + size_.x_, screenPosition.y_ + size_.y_);
 
-    if (!clipChildren_)
+    // The combined rect is cached relative to the screen position, so that it stays valid when the ancestors move
+    if (combinedRectDirty_)
     {
-        for (Vector<SharedPtr<UIElement> >::Iterator i = children_.Begin(); i != children_.End(); ++i)
+        IntRect combined(screenPosition.x_, screenPosition.y_, screenPosition.x_ + size_.x_, screenPosition.y_ + size_.y_);
+
+        if (!clipChildren_)
         {
-            IntRect childCombined((*i)->GetCombinedScreenRect());
-
-            if (childCombined.left_ < combined.left_)
-                combined.left_ = childCombined.left_;
-            if (childCombined.right_ > combined.right_)
-                combined.right_ = childCombined.right_;
-            if (childCombined.top_ < combined.top_)
-                combined.top_ = childCombined.top_;
-            if (childCombined.bottom_ > combined.bottom_)
-                combined.bottom_ = childCombined.bottom_;
+            for (Vector<SharedPtr<UIElement> >::Iterator i = children_.Begin(); i != children_.End(); ++i)
+            {
+                IntRect childCombined((*i)->GetCombinedScreenRect());
+
+                if (childCombined.left_ < combined.left_)
+                    combined.left_ = childCombined.left_;
+                if (childCombined.right_ > combined.right_)
+                    combined.right_ = childCombined.right_;
+                if (childCombined.top_ < combined.top_)
+                    combined.top_ = childCombined.top_;
+                if (childCombined.bottom_ > combined.bottom_)
+                    combined.bottom_ = childCombined.bottom_;
+            }
         }
+
+        combinedRect_ = IntRect(combined.left_ - screenPosition.x_, combined.top_ - screenPosition.y_,
+            combined.right_ - screenPosition.x_, combined.bottom_ - screenPosition.y_);
+        combinedRectDirty_ = false;
     }
 
-    return combined;
+    return IntRect(combinedRect_.left_ + screenPosition.x_, combinedRect_.top_ + screenPosition.y_,
+        combinedRect_.right_ + screenPosition.x_, combinedRect_.bottom_ + screenPosition.y_);
 }
 
 void UIElement::SortChildren()
@@ -1792,7 +1865,11 @@ void UIElement::SortChildren()
         // Only sort when there is no layout
         /// \todo Order is not stable when children have same priorities
         if (layoutMode_ == LM_FREE)
+        {
             Sort(children_.Begin(), children_.End(), CompareUIElements);
+            // The hit test grid refers to the children by index
+            hitGridDirty_ = true;
+        }
         sortOrderDirty_ = false;
     }
 }
@@ -1804,6 +1881,7 @@ void UIElement::SetChildOffset(const IntVector2& offset)
         childOffset_ = offset;
         for (Vector<SharedPtr<UIElement> >::ConstIterator i = children_.Begin(); i != children_.End(); ++i)
             (*i)->MarkDirty();
+        MarkHitTestDirty();
     }
 }
 
@@ -1812,6 +1890,16 @@ void UIElement::SetHovering(bool enable)
     hovering_ = enable;
 }
 
+void UIElement::MarkBatchesDirty()
+{
+    batchesDirty_ = true;
+    childBatchesDirty_ = true;
+
+    // Ancestors can not reuse their child batches either. Stop at an ancestor already marked, as its ancestors are then marked too
+    for (UIElement* parent = parent_; parent && !parent->childBatchesDirty_; parent = parent->parent_)
+        parent->childBatchesDirty_ = true;
+}
+
 void UIElement::AdjustScissor(IntRect& currentScissor)
 {
     if (clipChildren_)
@@ -1937,11 +2025,23 @@ void UIElement::MarkDirty()
     positionDirty_ = true;
     opacityDirty_ = true;
     derivedColorDirty_ = true;
+    MarkBatchesDirty();
 
     for (Vector<SharedPtr<UIElement> >::ConstIterator i = children_.Begin(); i != children_.End(); ++i)
         (*i)->MarkDirty();
 }
 
+void UIElement::MarkHitTestDirty()
+{
+    // The combined rects and grids of the ancestors include this element. Stop at an ancestor already marked, as its
+    // ancestors are then marked too
+    for (UIElement* element = this; element && !(element->combinedRectDirty_ && element->hitGridDirty_); element = element->parent_)
+    {
+        element->combinedRectDirty_ = true;
+        element->hitGridDirty_ = true;
+    }
+}
+
 bool UIElement::RemoveChildXML(XMLElement& parent, const String& name) const
 {
     static XPathQuery matchXPathQuery("./attribute[@name=$attributeName]", "attributeName:String");
@@ -2063,6 +2163,102 @@ void UIElement::GetChildrenRecursive(PODVector<UIElement*>& dest) const
     }
 }
 
+const PODVector<unsigned>* UIElement::GetHitTestChildren(const IntVector2& position)
+{
+    static const PODVector<unsigned> noChildren;
+
+    if (children_.Size() < MIN_HIT_GRID_CHILDREN)
+    {
+        hitGrid_.Reset();
+        return nullptr;
+    }
+
+    if (hitGridDirty_ || !hitGrid_)
+        UpdateHitGrid();
+
+    const UIHitGrid& grid = *hitGrid_;
+    const IntVector2& screenPosition = GetScreenPosition();
+    int x = position.x_ - screenPosition.x_ - grid.bounds_.left_;
+    int y = position.y_ - screenPosition.y_ - grid.bounds_.top_;
+    if (x < 0 || y < 0 || x >= grid.bounds_.Width() || y >= grid.bounds_.Height())
+        return &noChildren;
+
+    return &grid.cells_[(y / grid.cellSize_.y_) * grid.numCells_.x_ + x / grid.cellSize_.x_];
+}
+
+void UIElement::UpdateHitGrid()
+{
+    if (!hitGrid_)
+        hitGrid_ = new UIHitGrid();
+
+    UIHitGrid& grid = *hitGrid_;
+    IntVector2 screenPosition(GetScreenPosition());
+    PODVector<IntRect> rects(children_.Size());
+    IntRect bounds(M_MAX_INT, M_MAX_INT, M_MIN_INT, M_MIN_INT);
+
+    for (unsigned i = 0; i < children_.Size(); ++i)
+    {
+        UIElement* child = children_[i];
+        IntRect rect = child->GetCombinedScreenRect();
+
+        // Include the child's own corners transformed to screen, as for example a rotated Sprite may extend outside its combined rect
+        const IntVector2& size = child->GetSize();
+        IntVector2 corners[] = {IntVector2::ZERO, IntVector2(size.x_, 0), IntVector2(0, size.y_), size};
+        for (const IntVector2& corner : corners)
+        {
+            IntVector2 screenCorner = child->ElementToScreen(corner);
+            rect.left_ = Min(rect.left_, screenCorner.x_);
+            rect.top_ = Min(rect.top_, screenCorner.y_);
+            rect.right_ = Max(rect.right_, screenCorner.x_ + 1);
+            rect.bottom_ = Max(rect.bottom_, screenCorner.y_ + 1);
+        }
+
+        rect.left_ -= screenPosition.x_;
+        rect.top_ -= screenPosition.y_;
+        rect.right_ -= screenPosition.x_;
+        rect.bottom_ -= screenPosition.y_;
+        rects[i] = rect;
+
+        bounds.left_ = Min(bounds.left_, rect.left_);
+        bounds.top_ = Min(bounds.top_, rect.top_);
+        bounds.right_ = Max(bounds.right_, rect.right_);
+        bounds.bottom_ = Max(bounds.bottom_, rect.bottom_);
+    }
+
+    // Aim for about two children per cell, with square-ish cells
+    int width = Max(bounds.Width(), 1);
+    int height = Max(bounds.Height(), 1);
+    int targetCells = Max((int)children_.Size() / 2, 1);
+    int cellsX = Clamp(RoundToInt(sqrtf(targetCells * (float)width / (float)height)), 1, MAX_HIT_GRID_CELLS);
+    int cellsY = Clamp((targetCells + cellsX - 1) / cellsX, 1, MAX_HIT_GRID_CELLS);
+
+    grid.bounds_ = IntRect(bounds.left_, bounds.top_, bounds.left_ + width, bounds.top_ + height);
+    grid.cellSize_ = IntVector2((width + cellsX - 1) / cellsX, (height + cellsY - 1) / cellsY);
+    grid.numCells_ = IntVector2(cellsX, cellsY);
+    grid.cells_.Resize((unsigned)(cellsX * cellsY));
+    for (unsigned i = 0; i < grid.cells_.Size(); ++i)
+        grid.cells_[i].Clear();
+
+    for (unsigned i = 0; i < rects.Size(); ++i)
+    {
+        const IntRect& rect = rects[i];
+        if (rect.right_ <= rect.left_ || rect.bottom_ <= rect.top_)
+            continue;
+
+        int x1 = (rect.left_ - grid.bounds_.left_) / grid.cellSize_.x_;
+        int y1 = (rect.top_ - grid.bounds_.top_) / grid.cellSize_.y_;
+        int x2 = Min((rect.right_ - 1 - grid.bounds_.left_) / grid.cellSize_.x_, cellsX - 1);
+        int y2 = Min((rect.bottom_ - 1 - grid.bounds_.top_) / grid.cellSize_.y_, cellsY - 1);
+        for (int y = y1; y <= y2; ++y)
+        {
+            for (int x = x1; x <= x2; ++x)
+                grid.cells_[y * cellsX + x].Push(i);
+        }
+    }
+
+    hitGridDirty_ = false;
+}
+
 void UIElement::ApplyStyleRecursive(UIElement* element)
 {
     // If child element style file changes as result of being (re)parented and it has a defined style, apply it now
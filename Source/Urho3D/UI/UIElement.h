@@ -117,12 +117,15 @@ URHO3D_FLAGSET(DragAndDropMode, DragAndDropModeFlags);
 class Cursor;
 class ResourceCache;
 class Texture2D;
+struct UIHitGrid;
 
 /// Base class for %UI elements.
 class URHO3D_API UIElement : public Animatable
 {
     URHO3D_OBJECT(UIElement, Animatable);
 
+    friend class UI;
+
 public:
     /// Construct.
     explicit UIElement(Context* context);
@@ -208,6 +211,8 @@ public:
 
     /// Return whether the element could handle wheel input.
     virtual bool IsWheelHandler() const { return false; }
+    /// Return whether the UI may reuse the element's batches from the previous frame until MarkBatchesDirty() is called. Elements whose rendering changes without their state changing should return false.
+    virtual bool CanRetainBatches() const { return true; }
 
     /// Load from an XML file. Return true if successful.
     bool LoadXML(Deserializer& source);
@@ -739,6 +744,10 @@ public:
     void SetChildOffset(const IntVector2& offset);
     /// Set hovering state.
     void SetHovering(bool enable);
+    /// Mark the element's UI rendering batches for regeneration. Call when state that affects GetBatches() changes.
+    void MarkBatchesDirty();
+    /// Mark the combined rect and child hit test grid of the element and its ancestors as needing an update. Call when the element's size or the arrangement of its children changes.
+    void MarkHitTestDirty();
     /// Adjust scissor for rendering.
     void AdjustScissor(IntRect& currentScissor);
     /// Get UI rendering batches with a specified offset. Also recurse to child elements.
@@ -860,6 +869,10 @@ protected:
 private:
     /// Return child elements recursively.
     void GetChildrenRecursive(PODVector<UIElement*>& dest) const;
+    /// Return indices of the children whose combined rect may contain a screen position, in child order. Return null if the element has too few children for a hit test grid, in which case all children must be tested. Used internally by UI.
+    const PODVector<unsigned>* GetHitTestChildren(const IntVector2& position);
+    /// Rebuild the child hit test grid.
+    void UpdateHitGrid();
     /// Return child elements with a specific tag recursively.
     void GetChildrenWithTagRecursive(PODVector<UIElement*>& dest, const String& tag) const;
     /// Recursively apply style to a child element hierarchy when adding to an element.
@@ -929,6 +942,24 @@ private:
     static XPathQuery styleXPathQuery_;
     /// Tag list.
     StringVector tags_;
+    /// Retained batches of the element itself. Used internally by UI.
+    UIBatchRange batchRange_;
+    /// Retained batches of the child elements. Used internally by UI.
+    UIBatchRange childBatchRange_;
+    /// Own batches need to be regenerated flag.
+    bool batchesDirty_{true};
+    /// Child element batches need to be regenerated flag.
+    bool childBatchesDirty_{true};
+    /// Hovering flag the retained batches were generated with.
+    bool batchHovering_{};
+    /// Child hit test grid. Only allocated for elements with many children.
+    UniquePtr<UIHitGrid> hitGrid_;
+    /// Combined rect of the element and its children, relative to the screen position.
+    IntRect combinedRect_;
+    /// Combined rect needs update flag.
+    bool combinedRectDirty_{true};
+    /// Child hit test grid needs update flag.
+    bool hitGridDirty_{true};
 };
 
 template <class T> T* UIElement::CreateChild(const String& name, unsigned index)
@@ -287,6 +287,7 @@ void Window::SetModal(bool modal)
     if (ui->SetModalElement(this, modal))
     {
         modal_ = modal;
+        MarkBatchesDirty();
 
         using namespace ModalChanged;
 
@@ -300,16 +301,19 @@ void Window::SetModal(bool modal)
 void Window::SetModalShadeColor(const Color& color)
 {
     modalShadeColor_ = color;
+    MarkBatchesDirty();
 }
 
 void Window::SetModalFrameColor(const Color& color)
 {
     modalFrameColor_ = color;
+    MarkBatchesDirty();
 }
 
 void Window::SetModalFrameSize(const IntVector2& size)
 {
     modalFrameSize_ = size;
+    MarkBatchesDirty();
 }
 
 void Window::SetModalAutoDismiss(bool enable)
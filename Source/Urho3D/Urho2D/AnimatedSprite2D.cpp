@@ -304,6 +304,7 @@ void AnimatedSprite2D::UpdateSpineAnimation(float timeStep)
 
     sourceBatchesDirty_ = true;
     worldBoundingBoxDirty_ = true;
+    UpdateOctantBounds();
 }
 
 // This enum used to be defined in spine/RegionAttachment.h but it got moved inside RegionAttachment.c so it's no longer accessible.
@@ -416,6 +417,7 @@ void AnimatedSprite2D::UpdateSpriterAnimation(float timeStep)
     spriterInstance_->Update(timeStep * speed_);
     sourceBatchesDirty_ = true;
     worldBoundingBoxDirty_ = true;
+    UpdateOctantBounds();
 }
 
 void AnimatedSprite2D::UpdateSourceBatchesSpriter()
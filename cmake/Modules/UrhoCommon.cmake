@@ -481,6 +481,11 @@ foreach (OPT
         add_definitions (-D${OPT})
     endif ()
 endforeach ()
+# Thread-safe Bullet build is needed by the multithreaded physics world, which schedules its tasks on the Urho3D work queue
+# It changes the Bullet headers, so define it also for the Urho3D library and the applications using it
+if (URHO3D_PHYSICS AND URHO3D_THREADING)
+    add_definitions (-DBT_THREADSAFE=1)
+endif ()
 
 # TODO: The logic below is earmarked to be moved into SDL's CMakeLists.txt when refactoring the library dependency handling, until then ensure the DirectX package is not being searched again in external projects such as when building LuaJIT library
 if (WIN32 AND NOT CMAKE_PROJECT_NAME MATCHES ^Urho3D-ExternalProject-)